@@ -155,6 +155,9 @@
 #define FICA_IMG_CUR_K41Z_APP_ADDR     0x00800000 // just defaulting to this, not used at the moment
 #define FICA_IMG_DEFAULT_APP_ADDR      0x00F00000
 
+// Application Data Sectors, between the image slots above and FICA_IMG_DEFAULT_APP_ADDR
+#define FICA_AIR_BASELINE_ADDR         0x00900000 // CCS811 baseline log, one sector
+
 // Image Size
 #define FICA_IMG_SIZE_ZERO   0 // default
 
@@ -11128,6 +11128,7 @@ void SHELL_BleEventNotify(void *param)
         case 0x4493:
             shell_write("\r\nGATTServerAttributeWrittenIndication");
             BleApp_DemoRpkWriteCallback(&container->Data.GATTServerAttributeWrittenIndication);
+            MEM_BufferFree(container->Data.GATTServerAttributeWrittenIndication.AttributeWrittenEvent.Value);
             break;
 
         case 0x4494:
@@ -50,6 +50,9 @@
 #include "rpk_led.h"
 #ifndef BOOTLOADER
 #include "GUI.h"
+#include "rgb_led.h"
+#include "fsl_edma.h"
+#include "fsl_dmamux.h"
 #endif
 
 /* lptmr variables */
@@ -321,6 +324,128 @@ void Rgb_Led_Set_Colors(uint8_t R, uint8_t G, uint8_t B){
 	FTM_SetSoftwareTrigger(BOARD_INITPINS_RGB_R_PERIPHERAL, true);	// RGB LEDs on the same FTM = FTM3 (channel 2, 4, 5)
 }
 
+#ifndef BOOTLOADER
+/* RGB LED waveform player: PIT channel 3 paces DMA channel 3 (periodic trigger of DMAMUX channel 3), which
+ * copies one frame to C2V..C5V of FTM3 and links to DMA channel 4. The latter requests the PWM synchronization,
+ * the new duty cycles are loaded at the end of the PWM period. DMA channels 0 to 2 are used by the SPI2 driver,
+ * PIT channels 0 to 2 by the timers manager. */
+#define RGB_LED_DMA_CHANNEL				3U
+#define RGB_LED_SYNC_DMA_CHANNEL		4U
+#define RGB_LED_PIT_CHANNEL				RGB_LED_DMA_CHANNEL	/* periodic trigger of the same DMAMUX channel */
+
+#if (BOARD_INITPINS_RGB_G_CHANNEL != 2) || (BOARD_INITPINS_RGB_R_CHANNEL != 4) || (BOARD_INITPINS_RGB_B_CHANNEL != 5)
+#error "The RGB LED waveform player expects the R/G/B LEDs on FTM3 channels 4/2/5"
+#endif
+
+static uint16_t rgb_led_dma_table[RGB_LED_MAX_FRAMES][4];	/* C2V (G), C3V (unused), C4V (R), C5V (B) */
+static uint32_t rgb_led_sync_value;
+
+/* Duty cycle to compare value, as FTM_UpdatePwmDutycycle() */
+static uint16_t Rgb_Led_Duty_To_CnV(uint32_t mod, uint16_t duty){
+	return (duty >= RGB_LED_DUTY_MAX) ? mod + 1 : (mod * duty) / RGB_LED_DUTY_MAX;
+}
+
+/* Store a frame of the RGB LED waveform, see set_waveform_frame in rgb_led.h */
+void Rgb_Led_Set_Waveform_Frame(uint16_t index, const rgb_led_frame_t *frame){
+	FTM_Type *ftm = BOARD_INITPINS_RGB_R_PERIPHERAL;
+	uint32_t mod = ftm->MOD;
+
+	if (index >= RGB_LED_MAX_FRAMES)
+		return;
+
+	rgb_led_dma_table[index][0] = Rgb_Led_Duty_To_CnV(mod, frame->g);
+	rgb_led_dma_table[index][1] = ftm->CONTROLS[3].CnV;
+	rgb_led_dma_table[index][2] = Rgb_Led_Duty_To_CnV(mod, frame->r);
+	rgb_led_dma_table[index][3] = Rgb_Led_Duty_To_CnV(mod, frame->b);
+}
+
+/* Play the RGB LED waveform, see start_waveform in rgb_led.h */
+void Rgb_Led_Start_Waveform(uint16_t count, uint16_t frameMs, bool loop){
+	FTM_Type *ftm = BOARD_INITPINS_RGB_R_PERIPHERAL;
+	edma_config_t edmaConfig;
+	edma_transfer_config_t transfer;
+	edma_minor_offset_config_t minorOffset;
+
+	if (count > RGB_LED_MAX_FRAMES)
+		count = RGB_LED_MAX_FRAMES;
+
+	Rgb_Led_Stop_Waveform();
+
+	/* Load the compare values at the end of the period rather than resetting the counter, which the display
+	   EXTCOMIN signal on the same FTM would see */
+	ftm->SYNCONF &= ~FTM_SYNCONF_SWRSTCNT_MASK;
+	ftm->SYNC |= FTM_SYNC_CNTMAX_MASK;
+	rgb_led_sync_value = ftm->SYNC | FTM_SYNC_SWSYNC_MASK;
+
+	/* An error on a channel must not halt the SPI2 channels */
+	EDMA_GetDefaultConfig(&edmaConfig);
+	edmaConfig.enableHaltOnError = false;
+	EDMA_Init(DMA0, &edmaConfig);
+	DMAMUX_Init(DMAMUX0);
+
+	/* Frame copy: 4 x 16 bits per trigger, the destination goes back to C2V after each frame */
+	EDMA_ResetChannel(DMA0, RGB_LED_DMA_CHANNEL);
+	transfer.srcAddr = (uint32_t)rgb_led_dma_table;
+	transfer.destAddr = (uint32_t)&ftm->CONTROLS[2].CnV;
+	transfer.srcTransferSize = kEDMA_TransferSize2Bytes;
+	transfer.destTransferSize = kEDMA_TransferSize2Bytes;
+	transfer.srcOffset = sizeof(uint16_t);
+	transfer.destOffset = sizeof(ftm->CONTROLS[0]);
+	transfer.minorLoopBytes = sizeof(rgb_led_dma_table[0]);
+	transfer.majorLoopCounts = count;
+	EDMA_SetTransferConfig(DMA0, RGB_LED_DMA_CHANNEL, &transfer, NULL);
+	minorOffset.enableSrcMinorOffset = false;
+	minorOffset.enableDestMinorOffset = true;
+	minorOffset.minorOffset = (uint32_t)(-(int32_t)(4 * sizeof(ftm->CONTROLS[0])));
+	EDMA_SetMinorOffsetConfig(DMA0, RGB_LED_DMA_CHANNEL, &minorOffset);
+	EDMA_SetChannelLink(DMA0, RGB_LED_DMA_CHANNEL, kEDMA_MinorLink, RGB_LED_SYNC_DMA_CHANNEL);
+	DMA0->TCD[RGB_LED_DMA_CHANNEL].SLAST = -(int32_t)(count * sizeof(rgb_led_dma_table[0]));
+	DMA0->TCD[RGB_LED_DMA_CHANNEL].DLAST_SGA = minorOffset.minorOffset;
+	if (loop)
+		DMA0->TCD[RGB_LED_DMA_CHANNEL].CSR &= ~DMA_CSR_DREQ_MASK;	/* restart from the first frame */
+	else
+		DMA0->TCD[RGB_LED_DMA_CHANNEL].CSR |= DMA_CSR_DREQ_MASK;	/* stop on the last frame */
+
+	/* PWM synchronization request, started by the frame copy */
+	EDMA_ResetChannel(DMA0, RGB_LED_SYNC_DMA_CHANNEL);
+	transfer.srcAddr = (uint32_t)&rgb_led_sync_value;
+	transfer.destAddr = (uint32_t)&ftm->SYNC;
+	transfer.srcTransferSize = kEDMA_TransferSize4Bytes;
+	transfer.destTransferSize = kEDMA_TransferSize4Bytes;
+	transfer.srcOffset = 0;
+	transfer.destOffset = 0;
+	transfer.minorLoopBytes = sizeof(uint32_t);
+	transfer.majorLoopCounts = 1;
+	EDMA_SetTransferConfig(DMA0, RGB_LED_SYNC_DMA_CHANNEL, &transfer, NULL);
+	DMA0->TCD[RGB_LED_SYNC_DMA_CHANNEL].CSR &= ~DMA_CSR_DREQ_MASK;
+
+	/* Frame clock */
+	CLOCK_EnableClock(kCLOCK_Pit);
+	PIT->MCR &= ~PIT_MCR_MDIS_MASK;
+	PIT->CHANNEL[RGB_LED_PIT_CHANNEL].LDVAL = (CLOCK_GetBusClkFreq() / 1000U) * frameMs - 1U;
+
+	DMAMUX_SetSource(DMAMUX0, RGB_LED_DMA_CHANNEL, (uint8_t)kDmaRequestMux0AlwaysOn60);
+	DMAMUX_EnablePeriodTrigger(DMAMUX0, RGB_LED_DMA_CHANNEL);
+	DMAMUX_EnableChannel(DMAMUX0, RGB_LED_DMA_CHANNEL);
+	EDMA_EnableChannelRequest(DMA0, RGB_LED_DMA_CHANNEL);
+	PIT->CHANNEL[RGB_LED_PIT_CHANNEL].TCTRL = PIT_TCTRL_TEN_MASK;
+}
+
+/* Stop the RGB LED waveform, the LEDs keep the current duty cycles */
+void Rgb_Led_Stop_Waveform(void){
+	if (DMAMUX0->CHCFG[RGB_LED_DMA_CHANNEL] & DMAMUX_CHCFG_ENBL_MASK){
+		PIT->CHANNEL[RGB_LED_PIT_CHANNEL].TCTRL = 0;
+		EDMA_DisableChannelRequest(DMA0, RGB_LED_DMA_CHANNEL);
+		DMAMUX_DisableChannel(DMAMUX0, RGB_LED_DMA_CHANNEL);
+		/* Let a frame copy in progress complete */
+		while (DMA0->TCD[RGB_LED_DMA_CHANNEL].CSR & DMA_CSR_ACTIVE_MASK){
+		}
+		while (DMA0->TCD[RGB_LED_SYNC_DMA_CHANNEL].CSR & DMA_CSR_ACTIVE_MASK){
+		}
+	}
+}
+#endif
+
 #ifndef BOOTLOADER
 /* Connect the backlight */
 void Backlight_Connect(void){
@@ -177,6 +177,10 @@ void Rgb_Led_Connect(void);
 void Rgb_Led_Disconnect(void);
 void Rgb_Led_Set_Colors(uint8_t R, uint8_t G, uint8_t B);
 #ifndef BOOTLOADER
+struct _rgb_led_frame_t;
+void Rgb_Led_Set_Waveform_Frame(uint16_t index, const struct _rgb_led_frame_t *frame);
+void Rgb_Led_Start_Waveform(uint16_t count, uint16_t frameMs, bool loop);
+void Rgb_Led_Stop_Waveform(void);
 void Backlight_Connect(void);
 void Backlight_Disconnect(void);
 void Backlight_Set_Level(uint8_t level);
@@ -54,11 +54,18 @@ static uint32_t s_gui_memory[(GUI_NUMBYTES + 3) / 4]; /* needs to be word aligne
 #define GUI_MEMORY_ADDR ((uint32_t)s_gui_memory)
 #endif
 
+#if defined(RAPID_IOT) && defined(FSL_RTOS_FREE_RTOS)
+/* emWin time comes from the RTOS tick, LPTMR0 belongs to the tickless idle mode (tickless_idle.c) */
+#define EMWIN_RTOS_TIME 1
+#include "fsl_os_abstraction.h"
+#else
+#define EMWIN_RTOS_TIME 0
 #define LPTMR_HANDLER LPTMR0_IRQHandler
 #define LPTMR_SOURCE_CLOCK CLOCK_GetFreq(kCLOCK_LpoClk)
 /* Define LPTMR microseconds counts value */
 #define LPTMR_USEC_COUNT 10000U
 volatile uint32_t lptmrCounterMs = 0U;
+#endif
 
 /*******************************************************************************
  * Implementation of PortAPI for emWin LCD driver
@@ -206,6 +213,7 @@ int BOARD_Touch_Poll(void)
 }
 #endif
 
+#if !EMWIN_RTOS_TIME
 /*******************************************************************************
  * Implementation of LPTMR handler
  ******************************************************************************/
@@ -223,6 +231,7 @@ void LPTMR_HANDLER(void)
     __DSB();
     __ISB();
 }
+#endif
 
 /*******************************************************************************
  * Application implemented functions required by emWin library
@@ -278,6 +287,7 @@ void GUI_X_Config(void)
 
 void GUI_X_Init(void)
 {
+#if !EMWIN_RTOS_TIME
     lptmr_config_t lptmrConfig;
 
     /* Configure LPTMR */
@@ -309,6 +319,7 @@ void GUI_X_Init(void)
 
     /* Start counting */
     LPTMR_StartTimer(LPTMR0);
+#endif
 }
 
 /* Dummy RTOS stub required by emWin */
@@ -338,7 +349,11 @@ void GUI_X_ExecIdle(void)
 
 GUI_TIMER_TIME GUI_X_GetTime(void)
 {
+#if EMWIN_RTOS_TIME
+    return OSA_TimeGetMsec();
+#else
 	return lptmrCounterMs;
+#endif
 }
 
 void GUI_X_Delay(int Period)
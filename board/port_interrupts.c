@@ -44,12 +44,29 @@
 #if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
 /* UI Management */
 #include "ui_manager.h"
+/* Sensor data ready events */
+#include "sensor_events.h"
 #endif
 
 #include "pin_mux.h"
 #include "pin_mux_rpk.h"
 #include "spi_bus_share.h"
 
+#if defined(__GNUC__)
+#define __WEAK_FUNC __attribute__((weak))
+#elif defined(__ICCARM__)
+#define __WEAK_FUNC __weak
+#elif defined( __CC_ARM )
+#define __WEAK_FUNC __weak
+#endif
+
+/*!
+ * @brief Default NTAG field detect handler, replaced by the NTAG I2C driver when it is linked
+ */
+__WEAK_FUNC void BOARD_NTAG_FD_IRQ_HANDLER(void)
+{
+}
+
 /*!
  * @brief PORTA_IRQHandler IRQ handler for all PORT A interrupts, place necessary callbacks where needed
  *        User switch SW1       (hw label: USER_SW1)
@@ -83,13 +100,15 @@ void PORTA_IRQHandler(void)
 
     if (pin_nb & (1 << BOARD_INITPINS_AIR_INTN_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+        SensorEvents_SetEvent(kSensorEvAirQuality);
+#endif
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_AIR_INTN_GPIO, 1U << BOARD_INITPINS_AIR_INTN_GPIO_PIN);
     }
 
     if (pin_nb & (1 << BOARD_INITPINS_NTAG_FD_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+        BOARD_NTAG_FD_IRQ_HANDLER();
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_NTAG_FD_GPIO, 1U << BOARD_INITPINS_NTAG_FD_GPIO_PIN);
     }
 
@@ -144,25 +163,41 @@ void PORTB_IRQHandler(void)
 void PORTC_IRQHandler(void)
 {
     uint32_t pin_nb;
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+    uint32_t sensorEvents = 0U;
+#endif
     pin_nb = PORT_GetPinsInterruptFlags(PORTC);
 
     if (pin_nb & (1 << BOARD_INITPINS_AMB_INT_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+        sensorEvents |= kSensorEvAmbLight;
+#endif
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_AMB_INT_GPIO, 1U << BOARD_INITPINS_AMB_INT_GPIO_PIN);
     }
 
     if (pin_nb & (1 << BOARD_INITPINS_ACCEL_INT1_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+        sensorEvents |= kSensorEvAccel;
+#endif
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_ACCEL_INT1_GPIO, 1U << BOARD_INITPINS_ACCEL_INT1_GPIO_PIN);
     }
 
     if (pin_nb & (1 << BOARD_INITPINS_GYRO_INT2_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+        sensorEvents |= kSensorEvGyro;
+#endif
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_GYRO_INT2_GPIO, 1U << BOARD_INITPINS_GYRO_INT2_GPIO_PIN);
     }
+
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+    if (0 != sensorEvents)
+    {
+        SensorEvents_SetEvent(sensorEvents);
+    }
+#endif
 }
 
 /*!
@@ -178,6 +213,9 @@ void PORTC_IRQHandler(void)
 void PORTD_IRQHandler(void)
 {
     uint32_t pin_nb;
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+    uint32_t sensorEvents = 0U;
+#endif
     pin_nb = PORT_GetPinsInterruptFlags(PORTD);
 
     if (pin_nb & (1 << BOARD_INITPINS_RTC_INT_GPIO_PIN))
@@ -188,27 +226,42 @@ void PORTD_IRQHandler(void)
 
     if (pin_nb & (1 << BOARD_INITPINS_GYRO_INT1_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+        sensorEvents |= kSensorEvGyro;
+#endif
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_GYRO_INT1_GPIO, 1U << BOARD_INITPINS_GYRO_INT1_GPIO_PIN);
     }
 
     if (pin_nb & (1 << BOARD_INITPINS_PRESSURE_INT2_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+        sensorEvents |= kSensorEvPressure;
+#endif
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_PRESSURE_INT2_GPIO, 1U << BOARD_INITPINS_PRESSURE_INT2_GPIO_PIN);
     }
 
     if (pin_nb & (1 << BOARD_INITPINS_PRESSURE_INT1_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+        sensorEvents |= kSensorEvPressure;
+#endif
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_PRESSURE_INT1_GPIO, 1U << BOARD_INITPINS_PRESSURE_INT1_GPIO_PIN);
     }
 
     if (pin_nb & (1 << BOARD_INITPINS_ACCEL_INT2_GPIO_PIN))
     {
-        /* TODO: Trigger event */
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+        sensorEvents |= kSensorEvAccel;
+#endif
         GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_ACCEL_INT2_GPIO, 1U << BOARD_INITPINS_ACCEL_INT2_GPIO_PIN);
     }
+
+#if !defined(BOOTLOADER) && defined(FSL_RTOS_FREE_RTOS)
+    if (0 != sensorEvents)
+    {
+        SensorEvents_SetEvent(sensorEvents);
+    }
+#endif
 }
 
 /*!
@@ -402,7 +455,7 @@ void PORT_IRQ_EnablePortEIrq(void)
     PORT_SetPinInterruptConfig(BOARD_INITPINS_USER_SW2_PORT, BOARD_INITPINS_USER_SW2_GPIO_PIN, kPORT_InterruptFallingEdge);
     PORT_SetPinInterruptConfig(BOARD_INITPINS_USER_SW3_PORT, BOARD_INITPINS_USER_SW3_GPIO_PIN, kPORT_InterruptFallingEdge);
     PORT_SetPinInterruptConfig(BOARD_INITPINS_USER_SW4_PORT, BOARD_INITPINS_USER_SW4_GPIO_PIN, kPORT_InterruptFallingEdge);
-    PORT_SetPinInterruptConfig(BOARD_INITPINS_KW41_UART_RTS_PORT, BOARD_INITPINS_KW41_UART_RTS_PIN, kPORT_InterruptRisingEdge);
+    PORT_SetPinInterruptConfig(BOARD_INITPINS_KW41_UART_RTS_PORT, BOARD_INITPINS_KW41_UART_RTS_PIN, kPORT_InterruptEitherEdge);
 
 
     /* Enable interrupts on this port */
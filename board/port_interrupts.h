@@ -232,6 +232,15 @@ void PORT_IRQ_UiEnableIrq(void);
  */
 void PORT_IRQ_UiDisableIrq(void);
 
+/*!
+ * @brief NTAG field detect (hw label: NTAG_FD) handler, called from PORTA_IRQHandler.
+ *        The NTAG I2C driver provides it to wake the task waiting on the FD pin.
+ *
+ * @return None
+ *
+ */
+void BOARD_NTAG_FD_IRQ_HANDLER(void);
+
 /*! @}*/
 
 #if defined(__cplusplus)
@@ -82,6 +82,11 @@ uint8_t Init_rpk_rgb_led(void)
 	RPKRGBLED_fct.connect_hw = Rgb_Led_Connect;
 	RPKRGBLED_fct.disconnect_hw = Rgb_Led_Disconnect;
 	RPKRGBLED_fct.set_rgb_colors = Rgb_Led_Set_Colors;
+#ifndef BOOTLOADER
+	RPKRGBLED_fct.set_waveform_frame = Rgb_Led_Set_Waveform_Frame;
+	RPKRGBLED_fct.start_waveform = Rgb_Led_Start_Waveform;
+	RPKRGBLED_fct.stop_waveform = Rgb_Led_Stop_Waveform;
+#endif
 
     RGB_Led_Init_Driver(&RPKRGBLED_fct);
 
@@ -43,6 +43,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
+#include "timers.h"
 #endif
 #include "spi_bus_share.h"
 #if defined(CPU_MK64FN1M0VMD12)
@@ -58,10 +59,30 @@
 //! @addtogroup spi_bus_share
 //! @{
 
+// The K64F tasks are arbitrated between themselves, the KW41Z keeps the RTS/CTS handshake
+#if defined(FSL_RTOS_FREE_RTOS) && defined(CPU_MK64FN1M0VMD12) && !defined(BOOTLOADER)
+#define SPI_BUS_SHARE_ARBITER 1
+#else
+#define SPI_BUS_SHARE_ARBITER 0
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // Prototypes
 ////////////////////////////////////////////////////////////////////////////////
 
+static void SpiBusConnect(void);
+static void SpiBusDisconnect(void);
+
+#if SPI_BUS_SHARE_ARBITER
+static bool SpiBusArbiterActive(void);
+static status_t SpiBusAcquire(spi_bus_client_t client, uint8_t priority, uint32_t deadlineMs, bool transaction);
+static void SpiBusRelease(void);
+static void SpiBusHandshake(void);
+static void SpiBusGrantNext(void);
+static void SpiBusReleaseIdle(void);
+static void SpiBusHoldTimerCallback(TimerHandle_t timer);
+static void SpiBusReleaseIdlePended(void *pParam, uint32_t param);
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // Variables
@@ -77,6 +98,36 @@ volatile static int icount = 0;
 volatile static int IRQCount = 0;
 volatile static int IRQCountSave = 0;
 
+#if SPI_BUS_SHARE_ARBITER
+//! @brief Task queued for the bus
+typedef struct _spi_bus_waiter
+{
+	SemaphoreHandle_t sem;		// given when the grant is handed over
+	TaskHandle_t task;			// NULL when the slot is free
+	TickType_t requested;
+	TickType_t deadline;
+	uint32_t sequence;
+	uint8_t priority;
+	uint8_t client;
+	bool hasDeadline;
+	bool granted;
+} spi_bus_waiter_t;
+
+static spi_bus_waiter_t mSpiBusWaiters[SPI_BUS_SHARE_MAX_WAITERS];
+static SemaphoreHandle_t mSpiBusSlotsSem;		// counts the free waiter slots
+static SemaphoreHandle_t mSpiBusHandoffSem;		// given by the RTS IRQ when the KW41Z drops RTS
+static TimerHandle_t mSpiBusHoldTimer;
+static volatile TaskHandle_t mSpiBusOwner;		// task holding the grant, NULL when idle
+static volatile bool mSpiBusKw41Pending;		// the KW41Z asked for the bus while it was held
+static volatile bool mSpiBusHandoffWait;
+static bool mSpiBusTransaction;					// the grant comes from SPI_Bus_Share_Acquire
+static bool mSpiBusArbiterReady = false;
+static uint8_t mSpiBusOwnerClient;				// client of the current grant, or of the last one when idle
+static uint32_t mSpiBusSequence;
+static TickType_t mSpiBusGrantTick;
+static spi_bus_stats_t mSpiBusStats[kSpiBusClientCount];
+#endif
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Code
@@ -85,9 +136,33 @@ volatile static int IRQCountSave = 0;
 //! @brief Initialize SPI Bus so it can be used
 status_t SPI_Bus_Share_Init(void)
 {
+#if SPI_BUS_SHARE_ARBITER
+	uint32_t i;
+#endif
+
 	if (!bSPIBusgInitialized)
 	{
 		SPI_Bus_Share_Release_Access();
+
+#if SPI_BUS_SHARE_ARBITER
+		mSpiBusSlotsSem = xSemaphoreCreateCounting(SPI_BUS_SHARE_MAX_WAITERS, SPI_BUS_SHARE_MAX_WAITERS);
+		mSpiBusHandoffSem = xSemaphoreCreateBinary();
+		mSpiBusHoldTimer = xTimerCreate("SpiBusHold", pdMS_TO_TICKS(SPI_BUS_SHARE_HOLD_MS), pdFALSE, NULL, SpiBusHoldTimerCallback);
+		mSpiBusArbiterReady = (NULL != mSpiBusSlotsSem) && (NULL != mSpiBusHandoffSem) && (NULL != mSpiBusHoldTimer);
+
+		for (i = 0; mSpiBusArbiterReady && (i < SPI_BUS_SHARE_MAX_WAITERS); i++)
+		{
+			mSpiBusWaiters[i].sem = xSemaphoreCreateBinary();
+			mSpiBusArbiterReady = (NULL != mSpiBusWaiters[i].sem);
+		}
+
+		// Without the arbiter objects every access takes the direct path
+		if (!mSpiBusArbiterReady)
+		{
+			bSPIBusgInitialized = true;
+			return(SPI_BUS_SHARE_ERROR);
+		}
+#endif
 		bSPIBusgInitialized = true;
 	}
 	return(SPI_BUS_SHARE_NO_ERROR);
@@ -97,15 +172,45 @@ status_t SPI_Bus_Share_Init(void)
 #if defined(CPU_MK64FN1M0VMD12)
 void BOARD_K41Z_RTS_IRQ_HANDLER(uint32_t pin_nb)
 {
+#if SPI_BUS_SHARE_ARBITER
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+#endif
 	IRQCount+=1;
 
 	if(!bSPIBusgInitialized)
 		return;
 
-	if(!mSPIBusLocked && !mSPIBusRequest)
-		   GPIO_WritePinOutput(BOARD_INITPINS_KW41_UART_CTS_GPIO, BOARD_INITPINS_KW41_UART_CTS_PIN, 1);
+	// The pin interrupts on both edges: RTS high is a KW41Z request, RTS low a release
+	if(GPIO_ReadPinInput(BOARD_INITPINS_KW41_UART_RTS_GPIO, BOARD_INITPINS_KW41_UART_RTS_PIN)!=0)
+	{
+		if(!mSPIBusLocked && !mSPIBusRequest)
+		{
+			GPIO_WritePinOutput(BOARD_INITPINS_KW41_UART_CTS_GPIO, BOARD_INITPINS_KW41_UART_CTS_PIN, 1);
+		}
+#if SPI_BUS_SHARE_ARBITER
+		else if(mSpiBusArbiterReady && mSPIBusLocked)
+		{
+			// Ends the current batch, or the hold window right away when nobody uses the bus
+			mSpiBusKw41Pending = true;
+			if(NULL == mSpiBusOwner)
+			{
+				(void)xTimerPendFunctionCallFromISR(SpiBusReleaseIdlePended, NULL, 0, &higherPriorityTaskWoken);
+			}
+		}
+#endif
+	}
+#if SPI_BUS_SHARE_ARBITER
+	else if(mSpiBusHandoffWait)
+	{
+		(void)xSemaphoreGiveFromISR(mSpiBusHandoffSem, &higherPriorityTaskWoken);
+	}
+#endif
 
 	GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_KW41_UART_RTS_GPIO, 1U << BOARD_INITPINS_KW41_UART_RTS_PIN);
+
+#if SPI_BUS_SHARE_ARBITER
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+#endif
 }
 #endif
 
@@ -120,6 +225,11 @@ status_t SPI_Bus_Share_DeInit(void)
 
 status_t SPI_Bus_Share_Get_Access(void)
 {
+#if SPI_BUS_SHARE_ARBITER
+	if(SpiBusArbiterActive())
+		return(SpiBusAcquire(kSpiBusClientOther, SPI_BUS_SHARE_PRIO_OTHER, SPI_BUS_SHARE_NO_DEADLINE, false));
+#endif
+
 	if(mSPIBusLocked)
 		return(SPI_BUS_SHARE_NO_ERROR);
 
@@ -127,31 +237,27 @@ status_t SPI_Bus_Share_Get_Access(void)
 	if (!bSPIBusgInitialized)
 		SPI_Bus_Share_Init();
 
-	SPI_Bus_Share_Wait_For_Access();
-	OS_App_WaitUsec(20);
-	BOARD_ConfigurePins_RPK_SPI_Bus();
-	OS_App_WaitUsec(20);
-	icount+=1;
+	SpiBusConnect();
 	return(SPI_BUS_SHARE_NO_ERROR);
 }
 
 
 status_t SPI_Bus_Share_Release_Access(void)
 {
-	if(!mSPIBusLocked)
+#if SPI_BUS_SHARE_ARBITER
+	if(SpiBusArbiterActive())
+	{
+		// Only the task holding the grant ends it, and not inside a transaction
+		if((xTaskGetCurrentTaskHandle() == mSpiBusOwner) && !mSpiBusTransaction)
+			SpiBusRelease();
 		return(SPI_BUS_SHARE_NO_ERROR);
-
-	OS_App_WaitUsec(20);
-	BOARD_UnConfigurePins_RPK_SPI_Bus();
-	OS_App_WaitUsec(20);
-	icount+=1;
-
-#if defined(RAPID_IOT) && defined(CPU_MKW41Z512VHT4)
-	// Release SPI access to K64F by setting RTS pin low
-    GPIO_WritePinOutput(BOARD_INITPINS_K64F_UART_RTS_PC5_GPIO, BOARD_INITPINS_K64F_UART_RTS_PC5_GPIO_PIN, 0);
+	}
 #endif
 
-	mSPIBusLocked = false;
+	if(!mSPIBusLocked)
+		return(SPI_BUS_SHARE_NO_ERROR);
+
+	SpiBusDisconnect();
 	return(SPI_BUS_SHARE_NO_ERROR);
 }
 
@@ -196,6 +302,14 @@ status_t SPI_Bus_Share_Wait_For_Access(void)
 	}
 
 #elif defined(RAPID_IOT) && defined(CPU_MK64FN1M0VMD12)
+#if SPI_BUS_SHARE_ARBITER
+	if(SpiBusArbiterActive())
+	{
+		SpiBusHandshake();
+		mSPIBusRequest = false;
+		return(SPI_BUS_SHARE_NO_ERROR);
+	}
+#endif
 	if(GPIO_ReadPinInput(BOARD_INITPINS_KW41_RST_GPIO, BOARD_INITPINS_KW41_RST_GPIO_PIN)!=0)
 	{
 		while(1)
@@ -238,6 +352,365 @@ status_t SPI_Bus_Share_Wait_For_Access(void)
 }
 
 
+status_t SPI_Bus_Share_Acquire(spi_bus_client_t client, uint8_t priority, uint32_t deadlineMs)
+{
+	if(client >= kSpiBusClientKw41)
+		return(SPI_BUS_SHARE_ERROR);
+
+#if SPI_BUS_SHARE_ARBITER
+	if(SpiBusArbiterActive())
+		return(SpiBusAcquire(client, priority, deadlineMs, true));
+#endif
+	return(SPI_Bus_Share_Get_Access());
+}
+
+
+status_t SPI_Bus_Share_Release(void)
+{
+#if SPI_BUS_SHARE_ARBITER
+	if(SpiBusArbiterActive())
+	{
+		if(xTaskGetCurrentTaskHandle() == mSpiBusOwner)
+			SpiBusRelease();
+		return(SPI_BUS_SHARE_NO_ERROR);
+	}
+#endif
+	return(SPI_Bus_Share_Release_Access());
+}
+
+
+status_t SPI_Bus_Share_GetStats(spi_bus_client_t client, spi_bus_stats_t *pStats)
+{
+	if((client >= kSpiBusClientCount) || (NULL == pStats))
+		return(SPI_BUS_SHARE_ERROR);
+
+#if SPI_BUS_SHARE_ARBITER
+	taskENTER_CRITICAL();
+	*pStats = mSpiBusStats[client];
+	taskEXIT_CRITICAL();
+#else
+	memset(pStats, 0, sizeof(*pStats));
+#endif
+	return(SPI_BUS_SHARE_NO_ERROR);
+}
+
+
+void SPI_Bus_Share_ResetStats(void)
+{
+#if SPI_BUS_SHARE_ARBITER
+	taskENTER_CRITICAL();
+	memset(mSpiBusStats, 0, sizeof(mSpiBusStats));
+	taskEXIT_CRITICAL();
+#endif
+}
+
+
+//! @brief Handshake with the KW41Z, then mux the SPI pins to this processor
+static void SpiBusConnect(void)
+{
+	SPI_Bus_Share_Wait_For_Access();
+	OS_App_WaitUsec(20);
+	BOARD_ConfigurePins_RPK_SPI_Bus();
+	OS_App_WaitUsec(20);
+	icount+=1;
+}
+
+
+//! @brief Release the SPI pins and the handshake
+static void SpiBusDisconnect(void)
+{
+	OS_App_WaitUsec(20);
+	BOARD_UnConfigurePins_RPK_SPI_Bus();
+	OS_App_WaitUsec(20);
+	icount+=1;
+
+#if defined(RAPID_IOT) && defined(CPU_MKW41Z512VHT4)
+	// Release SPI access to K64F by setting RTS pin low
+    GPIO_WritePinOutput(BOARD_INITPINS_K64F_UART_RTS_PC5_GPIO, BOARD_INITPINS_K64F_UART_RTS_PC5_GPIO_PIN, 0);
+#endif
+
+#if SPI_BUS_SHARE_ARBITER
+	taskENTER_CRITICAL();
+	mSPIBusLocked = false;
+
+	// Grant a KW41Z request that arrived while the bus was held, instead of waiting for its retry
+	if(mSpiBusKw41Pending)
+	{
+		mSpiBusKw41Pending = false;
+		if(GPIO_ReadPinInput(BOARD_INITPINS_KW41_UART_RTS_GPIO, BOARD_INITPINS_KW41_UART_RTS_PIN)!=0)
+			GPIO_WritePinOutput(BOARD_INITPINS_KW41_UART_CTS_GPIO, BOARD_INITPINS_KW41_UART_CTS_PIN, 1);
+	}
+	taskEXIT_CRITICAL();
+#else
+	mSPIBusLocked = false;
+#endif
+}
+
+
+#if SPI_BUS_SHARE_ARBITER
+//! @brief The arbiter runs in task context once the scheduler has started
+static bool SpiBusArbiterActive(void)
+{
+	return(mSpiBusArbiterReady &&
+	       (0U == __get_IPSR()) &&
+	       (taskSCHEDULER_RUNNING == xTaskGetSchedulerState()));
+}
+
+
+//! @brief Queues the calling task for the bus and blocks until it is granted
+static status_t SpiBusAcquire(spi_bus_client_t client, uint8_t priority, uint32_t deadlineMs, bool transaction)
+{
+	TaskHandle_t self;
+	TickType_t requested;
+	spi_bus_waiter_t *pWaiter = NULL;
+	spi_bus_stats_t *pStats;
+	uint32_t waitMs;
+	uint32_t i;
+	bool late = false;
+
+	self = xTaskGetCurrentTaskHandle();
+	if(self == mSpiBusOwner)
+	{
+		// A grant from SPI_Bus_Share_Get_Access becomes a transaction
+		if(transaction && !mSpiBusTransaction)
+		{
+			mSpiBusTransaction = true;
+			mSpiBusOwnerClient = (uint8_t)client;
+		}
+		return(SPI_BUS_SHARE_NO_ERROR);
+	}
+
+	requested = xTaskGetTickCount();
+	(void)xSemaphoreTake(mSpiBusSlotsSem, portMAX_DELAY);
+
+	taskENTER_CRITICAL();
+	for(i = 0; i < SPI_BUS_SHARE_MAX_WAITERS; i++)
+	{
+		if((NULL != mSpiBusWaiters[i].task) && !mSpiBusWaiters[i].granted)
+			break;
+	}
+
+	if((NULL == mSpiBusOwner) && (SPI_BUS_SHARE_MAX_WAITERS == i))
+	{
+		// Idle bus and empty queue: granted right away
+		mSpiBusOwner = self;
+	}
+	else
+	{
+		for(i = 0; NULL != mSpiBusWaiters[i].task; i++)
+		{
+		}
+		pWaiter = &mSpiBusWaiters[i];
+		pWaiter->task = self;
+		pWaiter->requested = requested;
+		pWaiter->deadline = requested + pdMS_TO_TICKS(deadlineMs);
+		pWaiter->hasDeadline = (SPI_BUS_SHARE_NO_DEADLINE != deadlineMs);
+		pWaiter->sequence = mSpiBusSequence++;
+		pWaiter->priority = priority;
+		pWaiter->client = (uint8_t)client;
+		pWaiter->granted = false;
+	}
+	taskEXIT_CRITICAL();
+
+	if(NULL != pWaiter)
+	{
+		// The releasing task sets the owner before giving pWaiter->sem
+		(void)xSemaphoreTake(pWaiter->sem, portMAX_DELAY);
+
+		taskENTER_CRITICAL();
+		pWaiter->task = NULL;
+		taskEXIT_CRITICAL();
+	}
+	(void)xSemaphoreGive(mSpiBusSlotsSem);
+
+	mSpiBusTransaction = transaction;
+	mSpiBusOwnerClient = (uint8_t)client;
+	mSpiBusGrantTick = xTaskGetTickCount();
+	waitMs = (mSpiBusGrantTick - requested) * portTICK_PERIOD_MS;
+	if(SPI_BUS_SHARE_NO_DEADLINE != deadlineMs)
+		late = (waitMs > deadlineMs);
+
+	pStats = &mSpiBusStats[client];
+	pStats->grants++;
+	pStats->waitTotalMs += waitMs;
+	if(waitMs > pStats->waitMaxMs)
+		pStats->waitMaxMs = waitMs;
+	if(late)
+		pStats->deadlineMisses++;
+
+	// The pins stay muxed between consecutive grants unless the KW41Z asked for the bus
+	if(mSPIBusLocked)
+		pStats->batched++;
+	else
+		SpiBusConnect();
+
+	return(SPI_BUS_SHARE_NO_ERROR);
+}
+
+
+//! @brief Ends the grant of the calling task
+static void SpiBusRelease(void)
+{
+	bool kw41Pending;
+
+	mSpiBusStats[mSpiBusOwnerClient].busyTotalMs += (xTaskGetTickCount() - mSpiBusGrantTick) * portTICK_PERIOD_MS;
+	mSpiBusTransaction = false;
+
+	taskENTER_CRITICAL();
+	kw41Pending = mSpiBusKw41Pending;
+	taskEXIT_CRITICAL();
+
+	// A KW41Z request ends the batch here, between two transactions
+	if(kw41Pending && mSPIBusLocked)
+		SpiBusDisconnect();
+
+	SpiBusGrantNext();
+}
+
+
+//! @brief Same handshake as the polling version, but sleeps while the KW41Z holds the bus
+static void SpiBusHandshake(void)
+{
+	spi_bus_stats_t *pStats = &mSpiBusStats[kSpiBusClientKw41];
+	TickType_t start;
+	uint32_t waitMs;
+
+	if(GPIO_ReadPinInput(BOARD_INITPINS_KW41_RST_GPIO, BOARD_INITPINS_KW41_RST_GPIO_PIN)==0)
+	{
+		mSPIBusLocked = true;
+		return;
+	}
+
+	while(1)
+	{
+		mSPIBusRequest = true;
+		IRQCountSave = IRQCount;
+		if(GPIO_ReadPinInput(BOARD_INITPINS_KW41_UART_RTS_GPIO, BOARD_INITPINS_KW41_UART_RTS_PIN)==0)
+		{
+			GPIO_WritePinOutput(BOARD_INITPINS_KW41_UART_CTS_GPIO, BOARD_INITPINS_KW41_UART_CTS_PIN, 0);
+			if(IRQCountSave == IRQCount)
+				break;
+		}
+		else
+		{
+			start = xTaskGetTickCount();
+			(void)xSemaphoreTake(mSpiBusHandoffSem, 0);
+			mSpiBusHandoffWait = true;
+			GPIO_WritePinOutput(BOARD_INITPINS_KW41_UART_CTS_GPIO, BOARD_INITPINS_KW41_UART_CTS_PIN, 1);
+			while(GPIO_ReadPinInput(BOARD_INITPINS_KW41_UART_RTS_GPIO, BOARD_INITPINS_KW41_UART_RTS_PIN)!=0)
+			{
+				(void)xSemaphoreTake(mSpiBusHandoffSem, pdMS_TO_TICKS(SPI_BUS_SHARE_HANDOFF_POLL_MS));
+			}
+			mSpiBusHandoffWait = false;
+			GPIO_WritePinOutput(BOARD_INITPINS_KW41_UART_CTS_GPIO, BOARD_INITPINS_KW41_UART_CTS_PIN, 0);
+
+			waitMs = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+			pStats->grants++;
+			pStats->waitTotalMs += waitMs;
+			if(waitMs > pStats->waitMaxMs)
+				pStats->waitMaxMs = waitMs;
+
+			// Check again, the KW41Z may have requested the bus right after dropping RTS
+			if(GPIO_ReadPinInput(BOARD_INITPINS_KW41_UART_RTS_GPIO, BOARD_INITPINS_KW41_UART_RTS_PIN)==0)
+				break;
+		}
+	}
+	mSPIBusLocked = true;
+}
+
+
+//! @brief Hands the grant to the best waiter, or keeps the pins for the hold time.
+//!        Waiters are served overdue first, then by priority, then by earliest deadline,
+//!        then the client of the grant just ended, then in request order.
+static void SpiBusGrantNext(void)
+{
+	spi_bus_waiter_t *pNext = NULL;
+	spi_bus_waiter_t *pWaiter;
+	TickType_t now;
+	bool late;
+	bool nextLate = false;
+	uint32_t i;
+
+	taskENTER_CRITICAL();
+	now = xTaskGetTickCount();
+	for(i = 0; i < SPI_BUS_SHARE_MAX_WAITERS; i++)
+	{
+		pWaiter = &mSpiBusWaiters[i];
+		if((NULL == pWaiter->task) || pWaiter->granted)
+			continue;
+
+		late = pWaiter->hasDeadline && ((int32_t)(now - pWaiter->deadline) >= 0);
+
+		if((NULL == pNext) ||
+		   (late != nextLate ? late :
+		    (pWaiter->priority != pNext->priority) ? (pWaiter->priority > pNext->priority) :
+		    (pWaiter->hasDeadline != pNext->hasDeadline) ? pWaiter->hasDeadline :
+		    (pWaiter->hasDeadline && (pWaiter->deadline != pNext->deadline)) ? ((int32_t)(pWaiter->deadline - pNext->deadline) < 0) :
+		    ((pWaiter->client == mSpiBusOwnerClient) != (pNext->client == mSpiBusOwnerClient)) ? (pWaiter->client == mSpiBusOwnerClient) :
+		    ((int32_t)(pWaiter->sequence - pNext->sequence) < 0)))
+		{
+			pNext = pWaiter;
+			nextLate = late;
+		}
+	}
+
+	if(NULL != pNext)
+	{
+		pNext->granted = true;
+		mSpiBusOwner = pNext->task;
+		(void)xSemaphoreGive(pNext->sem);
+	}
+	else
+	{
+		mSpiBusOwner = NULL;
+	}
+	taskEXIT_CRITICAL();
+
+	if((NULL == pNext) && mSPIBusLocked)
+		(void)xTimerReset(mSpiBusHoldTimer, 0);
+}
+
+
+//! @brief Ends the hold window: releases the pins if no task took the bus meanwhile
+static void SpiBusReleaseIdle(void)
+{
+	bool idle;
+
+	taskENTER_CRITICAL();
+	idle = (NULL == mSpiBusOwner) && mSPIBusLocked;
+	if(idle)
+	{
+		// Owned by the timer task while the pins are released
+		mSpiBusOwner = xTaskGetCurrentTaskHandle();
+	}
+	taskEXIT_CRITICAL();
+
+	if(idle)
+	{
+		SpiBusDisconnect();
+
+		// Tasks queued while the pins were released get the bus now
+		SpiBusGrantNext();
+	}
+}
+
+
+static void SpiBusHoldTimerCallback(TimerHandle_t timer)
+{
+	(void)timer;
+	SpiBusReleaseIdle();
+}
+
+
+static void SpiBusReleaseIdlePended(void *pParam, uint32_t param)
+{
+	(void)pParam;
+	(void)param;
+	SpiBusReleaseIdle();
+}
+#endif
+
+
 //! @}
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -41,6 +41,54 @@
 #define SPI_BUS_SHARE_NO_ERROR 0
 #define SPI_BUS_SHARE_ERROR 1
 
+//! @brief Maximum number of tasks queued for the bus at the same time
+#ifndef SPI_BUS_SHARE_MAX_WAITERS
+#define SPI_BUS_SHARE_MAX_WAITERS 8
+#endif
+
+//! @brief Time the pins stay muxed after the last release, so that back-to-back
+//!        transactions skip the KW41Z handshake and the re-mux
+#ifndef SPI_BUS_SHARE_HOLD_MS
+#define SPI_BUS_SHARE_HOLD_MS 5
+#endif
+
+//! @brief Period at which a task waiting for the KW41Z re-reads RTS, in case an edge is missed
+#ifndef SPI_BUS_SHARE_HANDOFF_POLL_MS
+#define SPI_BUS_SHARE_HANDOFF_POLL_MS 10
+#endif
+
+//! @brief Default priorities of the local clients, higher is served first
+#define SPI_BUS_SHARE_PRIO_DISPLAY 3
+#define SPI_BUS_SHARE_PRIO_STORAGE 2
+#define SPI_BUS_SHARE_PRIO_UPDATE  1
+#define SPI_BUS_SHARE_PRIO_OTHER   1
+
+//! @brief Deadline value for transactions that have none
+#define SPI_BUS_SHARE_NO_DEADLINE 0
+
+//! @brief Clients of the shared SPI bus, used for arbitration and statistics
+typedef enum _spi_bus_client
+{
+	kSpiBusClientDisplay = 0,	//!< Images read from the SPI flash for the display
+	kSpiBusClientStorage,		//!< Sensor history and application records
+	kSpiBusClientUpdate,		//!< Image programming and firmware update
+	kSpiBusClientOther,			//!< Callers of SPI_Bus_Share_Get_Access
+	kSpiBusClientKw41,			//!< The KW41Z, statistics only
+	kSpiBusClientCount
+} spi_bus_client_t;
+
+//! @brief Per client bus statistics. For kSpiBusClientKw41, grants counts the handoffs to
+//!        the KW41Z and the wait fields the time local clients spent waiting for it.
+typedef struct _spi_bus_stats
+{
+	uint32_t grants;			//!< Transactions granted
+	uint32_t batched;			//!< Grants served without a new handshake and pin re-mux
+	uint32_t deadlineMisses;	//!< Grants given after the requested deadline
+	uint32_t waitTotalMs;		//!< Sum of the waits from request to grant
+	uint32_t waitMaxMs;			//!< Longest wait from request to grant
+	uint32_t busyTotalMs;		//!< Sum of the times from grant to release
+} spi_bus_stats_t;
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Prototypes
@@ -56,6 +104,29 @@ status_t SPI_Bus_Share_DeInit(void);
 status_t SPI_Bus_Share_Get_Access(void);
 status_t SPI_Bus_Share_Release_Access(void);
 status_t SPI_Bus_Share_Wait_For_Access(void);
+
+//! @brief Queues a transaction on the bus and blocks until it is granted.
+//!
+//! Waiting transactions are served overdue first, then by priority, then by earliest
+//! deadline. The transaction lasts until SPI_Bus_Share_Release: the SPI_Bus_Share_Get_Access
+//! and SPI_Bus_Share_Release_Access calls made meanwhile by the same task, e.g. by the SPI
+//! flash helpers after every access, keep the grant. Before the scheduler runs this falls
+//! back to SPI_Bus_Share_Get_Access.
+//!
+//! @param client      Client the transaction is accounted to
+//! @param priority    Priority, see the SPI_BUS_SHARE_PRIO_ defaults
+//! @param deadlineMs  Time in ms within which the grant is wanted, or SPI_BUS_SHARE_NO_DEADLINE
+status_t SPI_Bus_Share_Acquire(spi_bus_client_t client, uint8_t priority, uint32_t deadlineMs);
+
+//! @brief Ends the transaction started by SPI_Bus_Share_Acquire
+status_t SPI_Bus_Share_Release(void);
+
+//! @brief Copies the statistics of one client
+status_t SPI_Bus_Share_GetStats(spi_bus_client_t client, spi_bus_stats_t *pStats);
+
+//! @brief Clears the statistics of all clients
+void SPI_Bus_Share_ResetStats(void);
+
 void BOARD_K41Z_RTS_IRQ_HANDLER(uint32_t pin_nb);
 
 #if defined(__cplusplus)
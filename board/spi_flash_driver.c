@@ -32,6 +32,7 @@
 #include "board.h"
 #ifdef FULL_SFLASH_DEBUG
 #include "fsl_debug_console.h"
+#include "DeferredLog.h"
 #endif
 #include "fsl_dspi.h"
 #include "spi_flash_driver.h"
@@ -139,7 +140,7 @@ status_t SPI_Flash_Rw(uint8_t *cmd, uint32_t cmd_len, uint8_t *data_out, uint8_t
         if (DSPI_MasterTransferBlocking(RPK_DSPI_MASTER_BASE, &masterXfer))
         {
 #ifdef FULL_SFLASH_DEBUG
-            PRINTF("\r\nSF:xfer failed\r\n");
+            DLOG_PRINTF("\r\nSF:xfer failed\r\n");
 #endif
         }
     }
@@ -239,7 +240,7 @@ status_t SPI_Flash_Generic_Write(uint8_t *cmd, uint32_t cmd_len, uint8_t *data_o
     if (SPI_Flash_Enable_Write(1))
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: enabling write failed\n");
+        DLOG_PRINTF("\r\nSF: enabling write failed\n");
 #endif
        	return(SPI_FLASH_ERROR);
     }
@@ -247,7 +248,7 @@ status_t SPI_Flash_Generic_Write(uint8_t *cmd, uint32_t cmd_len, uint8_t *data_o
     if (SPI_Flash_Rw(cmd, cmd_len, data_out, data_in, data_len))
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: write failed\n");
+        DLOG_PRINTF("\r\nSF: write failed\n");
 #endif
        	return(SPI_FLASH_ERROR);
     }
@@ -255,7 +256,7 @@ status_t SPI_Flash_Generic_Write(uint8_t *cmd, uint32_t cmd_len, uint8_t *data_o
     if (SPI_Flash_Chk_Status(SPI_FLASH_TIMEOUT, CMD_READ_STATUS, STATUS_BUSY))
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: check status failed\n");
+        DLOG_PRINTF("\r\nSF: check status failed\n");
 #endif
        	return(SPI_FLASH_ERROR);
     }
@@ -300,13 +301,13 @@ status_t SPI_Flash_Write(uint32_t offset, uint32_t len, void *buf)
     if (ret)
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: program failed!\r\n");
+        DLOG_PRINTF("\r\nSF: program failed!\r\n");
 #endif
     }
     else
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: program success!\r\n");
+        DLOG_PRINTF("\r\nSF: program success!\r\n");
 #endif
     }
     return ret;
@@ -336,7 +337,7 @@ status_t SPI_Flash_Erase_Block(uint32_t offset, uint32_t blkSize)
     if (offset % blkSize)
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: Erase offset or length is not multiple of erase size\n");
+        DLOG_PRINTF("\r\nSF: Erase offset or length is not multiple of erase size\n");
 #endif
         return SPI_FLASH_ERROR;
     }
@@ -371,7 +372,7 @@ status_t SPI_Flash_Write_Status(uint8_t sts_reg)
     if (ret != 0)
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: enabling write failed\n");
+        DLOG_PRINTF("\r\nSF: enabling write failed\n");
 #endif
        	return(SPI_FLASH_ERROR);
     }
@@ -381,7 +382,7 @@ status_t SPI_Flash_Write_Status(uint8_t sts_reg)
     if (ret != 0)
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: fail to write status register\n");
+        DLOG_PRINTF("\r\nSF: fail to write status register\n");
 #endif
        	return(SPI_FLASH_ERROR);
     }
@@ -390,7 +391,7 @@ status_t SPI_Flash_Write_Status(uint8_t sts_reg)
     if (ret != 0)
     {
 #ifdef FULL_SFLASH_DEBUG
-        PRINTF("\r\nSF: write status register timed out\n");
+        DLOG_PRINTF("\r\nSF: write status register timed out\n");
 #endif
        	return(SPI_FLASH_ERROR);
     }
@@ -0,0 +1,460 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file spi_bus_share_test.c
+ * Host test for the SPI bus arbiter of the K64F. The module source is built in with FreeRTOS
+ * replaced by a small scheduler: every simulated task is a thread, and a single baton lets one of
+ * them run at a time, so a task blocked on its waiter semaphore stays blocked until the releasing
+ * task gives it. Tasks queue behind a holder with different clients, priorities and deadlines, and
+ * the order in which they are granted the bus is checked against the arbitration rules, including
+ * the preference for the client of the grant that just ended. The statistics, the hold timer and a
+ * KW41Z request ending a batch are checked as well.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FSL_RTOS_FREE_RTOS
+#define CPU_MK64FN1M0VMD12
+#define RAPID_IOT
+
+/* The stub first, the source would find the real board.h next to it */
+#include "stub/board.h"
+#include "../spi_bus_share.c"
+
+/*****************************************************************************
+ * Simulated RTOS
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+#define TEST_MAX_GRANTS     (16)
+
+#define TEST_TASK(n, c, p, d, h)    { .name = (n), .client = (c), .priority = (p), .deadlineMs = (d), .holdTicks = (h) }
+
+struct TestSemaphore
+{
+    uint32_t count;
+    uint32_t max;
+};
+
+struct TestTimer
+{
+    TimerCallbackFunction_t callback;
+    bool running;
+};
+
+struct TestTask
+{
+    const char *name;
+    spi_bus_client_t client;
+    uint8_t priority;
+    uint32_t deadlineMs;
+    TickType_t holdTicks;
+    pthread_t thread;
+    struct TestSemaphore *pBlockedOn;
+    bool holding;
+};
+
+GPIO_Type gGpioB;
+GPIO_Type gGpioE;
+volatile uint8_t lptmrFlag;
+
+static pthread_mutex_t sLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sSwitched = PTHREAD_COND_INITIALIZER;
+static struct TestTask sTimerTask = { .name = "timer" };    /* the main thread, also runs the timer callbacks */
+static struct TestTask *sRunning = &sTimerTask;
+static struct TestSemaphore sSemaphores[SPI_BUS_SHARE_MAX_WAITERS + 2];
+static uint32_t sSemaphoreCount;
+static struct TestTimer sHoldTimer;
+static TickType_t sTicks;
+static int32_t sCriticalDepth;
+static struct TestTask *sGrants[TEST_MAX_GRANTS];
+static uint32_t sGrantCount;
+
+/* Hands the baton to another task and waits until it comes back, the lock is held */
+static void Switch(struct TestTask *pTo)
+{
+    struct TestTask *pSelf = sRunning;
+
+    sRunning = pTo;
+    pthread_cond_broadcast(&sSwitched);
+    while (sRunning != pSelf)
+    {
+        pthread_cond_wait(&sSwitched, &sLock);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return sTicks;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return sRunning;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+    return taskSCHEDULER_RUNNING;
+}
+
+void vTaskEnterCritical(void)
+{
+    sCriticalDepth++;
+}
+
+void vTaskExitCritical(void)
+{
+    CHECK(sCriticalDepth > 0);
+    sCriticalDepth--;
+}
+
+uint32_t __get_IPSR(void)
+{
+    return 0;
+}
+
+static SemaphoreHandle_t CreateSemaphore(uint32_t max, uint32_t count)
+{
+    struct TestSemaphore *pSem;
+
+    CHECK(sSemaphoreCount < sizeof(sSemaphores) / sizeof(sSemaphores[0]));
+    pSem = &sSemaphores[sSemaphoreCount++];
+    pSem->max = max;
+    pSem->count = count;
+    return pSem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount)
+{
+    return CreateSemaphore(maxCount, initialCount);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return CreateSemaphore(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait)
+{
+    CHECK(0 == sCriticalDepth);
+    if ((0 == sem->count) && (0 == ticksToWait))
+    {
+        return pdFALSE;
+    }
+    /* Nothing gives a semaphore the main thread waits for */
+    CHECK((sem->count > 0) || (sRunning != &sTimerTask));
+    while (0 == sem->count)
+    {
+        sRunning->pBlockedOn = sem;
+        Switch(&sTimerTask);
+    }
+    sRunning->pBlockedOn = NULL;
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count >= sem->max)
+    {
+        return pdFALSE;
+    }
+    sem->count++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *pHigherPriorityTaskWoken)
+{
+    *pHigherPriorityTaskWoken = pdTRUE;
+    return xSemaphoreGive(sem);
+}
+
+TimerHandle_t xTimerCreate(const char *pName, TickType_t period, UBaseType_t autoReload, void *pTimerId,
+                           TimerCallbackFunction_t callback)
+{
+    (void)pName;
+    (void)period;
+    (void)autoReload;
+    (void)pTimerId;
+    sHoldTimer.callback = callback;
+    return &sHoldTimer;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticksToWait)
+{
+    (void)ticksToWait;
+    timer->running = true;
+    return pdTRUE;
+}
+
+BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t function, void *pParam, uint32_t param,
+                                         BaseType_t *pHigherPriorityTaskWoken)
+{
+    (void)pHigherPriorityTaskWoken;
+    function(pParam, param);
+    return pdTRUE;
+}
+
+void OS_App_WaitUsec(uint32_t usec)
+{
+    (void)usec;
+}
+
+void OS_App_WaitMsec(uint32_t msec)
+{
+    (void)msec;
+}
+
+void BOARD_ConfigurePins_RPK_SPI_Bus(void)
+{
+}
+
+void BOARD_UnConfigurePins_RPK_SPI_Bus(void)
+{
+}
+
+/*****************************************************************************
+ * Simulated tasks
+ ****************************************************************************/
+
+/* Each task takes the bus once, holds it until the main thread has let its time pass, and releases it */
+static void *TaskMain(void *pParam)
+{
+    struct TestTask *pTask = pParam;
+
+    pthread_mutex_lock(&sLock);
+    while (sRunning != pTask)
+    {
+        pthread_cond_wait(&sSwitched, &sLock);
+    }
+
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_Acquire(pTask->client, pTask->priority, pTask->deadlineMs));
+    CHECK(mSpiBusOwner == pTask);
+    CHECK(sGrantCount < TEST_MAX_GRANTS);
+    sGrants[sGrantCount++] = pTask;
+    pTask->holding = true;
+    Switch(&sTimerTask);
+
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_Release());
+    CHECK(mSpiBusOwner != pTask);
+
+    sRunning = &sTimerTask;
+    pthread_cond_broadcast(&sSwitched);
+    pthread_mutex_unlock(&sLock);
+    return NULL;
+}
+
+/* Runs a new task until it holds the bus or blocks in the queue */
+static void Start(struct TestTask *pTask)
+{
+    CHECK(0 == pthread_create(&pTask->thread, NULL, TaskMain, pTask));
+    Switch(pTask);
+}
+
+/* Runs the tasks until all of them have had the bus and released it */
+static void RunAll(struct TestTask *pTasks, uint32_t count)
+{
+    struct TestTask *pNext;
+    uint32_t i;
+
+    while (1)
+    {
+        pNext = NULL;
+        for (i = 0; (i < count) && (NULL == pNext); i++)
+        {
+            if (pTasks[i].holding || ((NULL != pTasks[i].pBlockedOn) && (pTasks[i].pBlockedOn->count > 0)))
+            {
+                pNext = &pTasks[i];
+            }
+        }
+        if (NULL == pNext)
+        {
+            break;
+        }
+
+        if (pNext->holding)
+        {
+            sTicks += pNext->holdTicks;
+            pNext->holding = false;
+            Switch(pNext);
+            pthread_mutex_unlock(&sLock);
+            CHECK(0 == pthread_join(pNext->thread, NULL));
+            pthread_mutex_lock(&sLock);
+        }
+        else
+        {
+            Switch(pNext);
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        CHECK(NULL == pTasks[i].pBlockedOn);
+    }
+}
+
+static void CheckGrants(const char *const *pExpected, uint32_t count)
+{
+    uint32_t i;
+
+    CHECK(sGrantCount == count);
+    for (i = 0; i < count; i++)
+    {
+        if (0 != strcmp(sGrants[i]->name, pExpected[i]))
+        {
+            printf("FAIL grant %u went to %s, expected %s\n", i, sGrants[i]->name, pExpected[i]);
+            exit(1);
+        }
+    }
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* Overdue waiters first, then priority, then the earlier deadline, then request order */
+static void TestPriorityAndDeadlines(void)
+{
+    struct TestTask tasks[] =
+    {
+        TEST_TASK("holder", kSpiBusClientOther, SPI_BUS_SHARE_PRIO_OTHER, SPI_BUS_SHARE_NO_DEADLINE, 1),
+        TEST_TASK("storage", kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, SPI_BUS_SHARE_NO_DEADLINE, 2),
+        TEST_TASK("display1", kSpiBusClientDisplay, SPI_BUS_SHARE_PRIO_DISPLAY, SPI_BUS_SHARE_NO_DEADLINE, 2),
+        TEST_TASK("update2ms", kSpiBusClientUpdate, SPI_BUS_SHARE_PRIO_UPDATE, 2, 2),
+        TEST_TASK("storage100ms", kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, 100, 2),
+        TEST_TASK("storage50ms", kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, 50, 2),
+        TEST_TASK("display2", kSpiBusClientDisplay, SPI_BUS_SHARE_PRIO_DISPLAY, SPI_BUS_SHARE_NO_DEADLINE, 2),
+        TEST_TASK("update", kSpiBusClientUpdate, SPI_BUS_SHARE_PRIO_UPDATE, SPI_BUS_SHARE_NO_DEADLINE, 2),
+    };
+    /* The 2 ms deadline is not due at the first grant, and is overdue at the second */
+    static const char *const expected[] =
+    {
+        "holder", "display1", "update2ms", "display2", "storage50ms", "storage100ms", "storage", "update"
+    };
+    spi_bus_stats_t stats;
+    uint32_t i;
+
+    SPI_Bus_Share_ResetStats();
+    sGrantCount = 0;
+    sTicks = 10;
+    for (i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++)
+    {
+        Start(&tasks[i]);
+    }
+    CHECK(sGrantCount == 1);
+    RunAll(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    CheckGrants(expected, sizeof(expected) / sizeof(expected[0]));
+
+    /* Granted at 11 and 15 */
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_GetStats(kSpiBusClientDisplay, &stats));
+    CHECK((stats.grants == 2) && (stats.batched == 2) && (stats.deadlineMisses == 0));
+    CHECK((stats.waitTotalMs == 6) && (stats.waitMaxMs == 5) && (stats.busyTotalMs == 4));
+
+    /* Granted at 13 for a 2 ms deadline, and at 23 */
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_GetStats(kSpiBusClientUpdate, &stats));
+    CHECK((stats.grants == 2) && (stats.deadlineMisses == 1) && (stats.waitMaxMs == 13));
+
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_GetStats(kSpiBusClientStorage, &stats));
+    CHECK((stats.grants == 3) && (stats.batched == 3) && (stats.deadlineMisses == 0));
+
+    /* The first grant found the bus idle and made the handshake */
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_GetStats(kSpiBusClientOther, &stats));
+    CHECK((stats.grants == 1) && (stats.batched == 0));
+
+    /* The pins stay muxed for the hold time, then the timer releases them */
+    CHECK((NULL == mSpiBusOwner) && mSPIBusLocked && sHoldTimer.running);
+    sHoldTimer.running = false;
+    sHoldTimer.callback(&sHoldTimer);
+    CHECK((NULL == mSpiBusOwner) && !mSPIBusLocked && !sHoldTimer.running);
+    printf("  priority, deadline and request order: %u grants\n", sGrantCount);
+}
+
+/* Between equal waiters, the client of the grant that just ended goes first. A KW41Z request
+   while the bus is held ends the batch at the next release. */
+static void TestSameClientAndKw41(void)
+{
+    struct TestTask tasks[] =
+    {
+        TEST_TASK("storage-holder", kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_OTHER, SPI_BUS_SHARE_NO_DEADLINE, 1),
+        TEST_TASK("display", kSpiBusClientDisplay, SPI_BUS_SHARE_PRIO_OTHER, SPI_BUS_SHARE_NO_DEADLINE, 1),
+        TEST_TASK("storage1", kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_OTHER, SPI_BUS_SHARE_NO_DEADLINE, 1),
+        TEST_TASK("update", kSpiBusClientUpdate, SPI_BUS_SHARE_PRIO_OTHER, SPI_BUS_SHARE_NO_DEADLINE, 1),
+        TEST_TASK("storage2", kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_OTHER, SPI_BUS_SHARE_NO_DEADLINE, 1),
+        TEST_TASK("update2", kSpiBusClientUpdate, SPI_BUS_SHARE_PRIO_OTHER, SPI_BUS_SHARE_NO_DEADLINE, 1),
+    };
+    static const char *const expected[] =
+    {
+        "storage-holder", "storage1", "storage2", "display", "update", "update2"
+    };
+    spi_bus_stats_t stats;
+    uint32_t i;
+
+    SPI_Bus_Share_ResetStats();
+    sGrantCount = 0;
+    sTicks = 100;
+    for (i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++)
+    {
+        Start(&tasks[i]);
+    }
+
+    /* The KW41Z raises RTS while the holder has the bus */
+    gGpioE.PDIR |= 1U << BOARD_INITPINS_KW41_UART_RTS_PIN;
+    BOARD_K41Z_RTS_IRQ_HANDLER(BOARD_INITPINS_KW41_UART_RTS_PIN);
+    CHECK(mSpiBusKw41Pending);
+    CHECK(0 == (gGpioE.PDOR & (1U << BOARD_INITPINS_KW41_UART_CTS_PIN)));
+
+    RunAll(tasks, sizeof(tasks) / sizeof(tasks[0]));
+    CheckGrants(expected, sizeof(expected) / sizeof(expected[0]));
+
+    /* Granted at the first release, before the next handshake */
+    CHECK(!mSpiBusKw41Pending);
+    CHECK(0 != (gGpioE.PDOR & (1U << BOARD_INITPINS_KW41_UART_CTS_PIN)));
+    gGpioE.PDIR &= ~(1U << BOARD_INITPINS_KW41_UART_RTS_PIN);
+
+    /* The holder and storage1 made a handshake, storage2 was batched */
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_GetStats(kSpiBusClientStorage, &stats));
+    CHECK((stats.grants == 3) && (stats.batched == 1));
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_GetStats(kSpiBusClientUpdate, &stats));
+    CHECK((stats.grants == 2) && (stats.batched == 2));
+
+    sHoldTimer.running = false;
+    sHoldTimer.callback(&sHoldTimer);
+    CHECK((NULL == mSpiBusOwner) && !mSPIBusLocked);
+    printf("  same client first, KW41Z request between two grants: %u grants\n", sGrantCount);
+}
+
+/* Without the scheduler, and for the KW41Z client, the arbiter is not involved */
+static void TestApi(void)
+{
+    spi_bus_stats_t stats;
+
+    CHECK(SPI_BUS_SHARE_ERROR == SPI_Bus_Share_Acquire(kSpiBusClientKw41, 1, SPI_BUS_SHARE_NO_DEADLINE));
+    CHECK(SPI_BUS_SHARE_ERROR == SPI_Bus_Share_GetStats(kSpiBusClientCount, &stats));
+    CHECK(SPI_BUS_SHARE_ERROR == SPI_Bus_Share_GetStats(kSpiBusClientDisplay, NULL));
+    printf("  argument checks\n");
+}
+
+int main(void)
+{
+    pthread_mutex_lock(&sLock);
+
+    CHECK(SPI_BUS_SHARE_NO_ERROR == SPI_Bus_Share_Init());
+    CHECK(mSpiBusArbiterReady && bSPIBusgInitialized);
+
+    TestApi();
+    TestPriorityAndDeadlines();
+    TestSameClientAndKw41();
+
+    pthread_mutex_unlock(&sLock);
+    printf("spi bus share: all tests passed\n");
+    return 0;
+}
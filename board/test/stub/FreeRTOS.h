@@ -0,0 +1,21 @@
+/* Host build stub: the FreeRTOSConfig.h settings of RAPID_IOT */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE                                 ((BaseType_t)0)
+#define pdTRUE                                  ((BaseType_t)1)
+#define portMAX_DELAY                           ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS                      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs)                ((TickType_t)(((TickType_t)(xTimeInMs) * configTICK_RATE_HZ) / (TickType_t)1000))
+#define portYIELD_FROM_ISR(x)                   ((void)(x))
+
+#define configTICK_RATE_HZ                      ((TickType_t)1000)
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
+#endif
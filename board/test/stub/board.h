@@ -0,0 +1,7 @@
+/* Host build stub */
+#ifndef _BOARD_H_
+#define _BOARD_H_
+#include "fsl_common.h"
+
+extern volatile uint8_t lptmrFlag;
+#endif
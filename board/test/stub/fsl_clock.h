@@ -0,0 +1,12 @@
+/* Host build stub: the bus clock of the RUN mode configuration */
+#ifndef _FSL_CLOCK_H_
+#define _FSL_CLOCK_H_
+#include <stdint.h>
+
+typedef enum { kCLOCK_Rtc0, kCLOCK_Pit0 } clock_ip_name_t;
+
+#define PIT_CLOCKS              { kCLOCK_Pit0 }
+
+static inline void CLOCK_EnableClock(clock_ip_name_t name) { (void)name; }
+static inline uint32_t CLOCK_GetBusClkFreq(void) { return 60000000U; }
+#endif
@@ -0,0 +1,69 @@
+/* Host build stub: the registers used by the tickless idle mode and the
+   TimersManager are plain variables defined by the test */
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int32_t status_t;
+
+#define CORE_CLOCK_FREQ                 (120000000U)
+#define FSL_FEATURE_PIT_TIMER_COUNT     (4)
+#define __NVIC_PRIO_BITS                (4)
+
+typedef enum { LPTMR0_IRQn = 58, RTC_IRQn = 46, PIT0_IRQn = 48 } IRQn_Type;
+
+typedef struct { volatile uint32_t CSR, PSR, CMR, CNR; } LPTMR_Type;
+typedef struct { volatile uint32_t TSR, TPR, TAR, TCR, CR, SR, LR, IER; } RTC_Type;
+typedef struct
+{
+    volatile uint32_t MCR;
+    struct { volatile uint32_t LDVAL, CVAL, TCTRL, TFLG; } CHANNEL[4];
+} PIT_Type;
+typedef struct { volatile uint8_t PMPROT, PMCTRL, STOPCTRL, PMSTAT; } SMC_Type;
+typedef struct { volatile uint32_t SCR; } SCB_Type;
+typedef struct { volatile uint8_t C1, C2, C3, C4, C5, C6, S; } MCG_Type;
+
+extern LPTMR_Type gLptmr0;
+extern RTC_Type gRtc;
+extern PIT_Type gPit;
+extern SMC_Type gSmc;
+extern SCB_Type gScb;
+extern MCG_Type gMcg;
+
+#define LPTMR0                  (&gLptmr0)
+#define RTC                     (&gRtc)
+#define PIT_BASE_PTRS           { &gPit }
+#define PIT_IRQS                { PIT0_IRQn }
+#define SMC                     (&gSmc)
+#define SCB                     (&gScb)
+#define MCG                     (&gMcg)
+
+#define RTC_CR_SWR_MASK         (0x1U)
+#define RTC_CR_SUP_MASK         (0x4U)
+#define RTC_CR_UM_MASK          (0x8U)
+#define RTC_CR_OSCE_MASK        (0x100U)
+#define RTC_SR_TIF_MASK         (0x1U)
+#define RTC_SR_TCE_MASK         (0x10U)
+#define RTC_IER_TAIE_MASK       (0x4U)
+#define PIT_MCR_MDIS_MASK       (0x2U)
+#define PIT_TCTRL_TEN_MASK      (0x1U)
+#define PIT_TCTRL_TIE_MASK      (0x2U)
+#define PIT_TCTRL_CHN_MASK      (0x4U)
+#define PIT_TFLG_TIF_MASK       (0x1U)
+#define SMC_PMCTRL_STOPM_MASK   (0x7U)
+#define SMC_PMCTRL_STOPM(x)     ((uint8_t)((x) & SMC_PMCTRL_STOPM_MASK))
+#define SCB_SCR_SLEEPDEEP_Msk   (0x4U)
+#define MCG_S_LOCK0_MASK        (0x40U)
+#define MCG_S_PLLST_MASK        (0x20U)
+
+void __WFI(void);
+uint32_t __get_IPSR(void);
+#define __DSB()
+#define __ISB()
+
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { (void)irq; (void)priority; }
+static inline void NVIC_EnableIRQ(IRQn_Type irq) { (void)irq; }
+static inline void NVIC_ClearPendingIRQ(IRQn_Type irq) { (void)irq; }
+#endif
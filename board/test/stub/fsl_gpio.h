@@ -0,0 +1,30 @@
+/* Host build stub: the GPIO ports are plain variables defined by the test */
+#ifndef _FSL_GPIO_H_
+#define _FSL_GPIO_H_
+#include "fsl_common.h"
+
+typedef struct { volatile uint32_t PDOR, PDIR; } GPIO_Type;
+typedef struct { uint32_t pinDirection; uint8_t outputLogic; } gpio_pin_config_t;
+
+extern GPIO_Type gGpioB;
+extern GPIO_Type gGpioE;
+
+#define GPIOB   (&gGpioB)
+#define GPIOE   (&gGpioE)
+
+static inline uint32_t GPIO_ReadPinInput(GPIO_Type *base, uint32_t pin)
+{
+    return (base->PDIR >> pin) & 1U;
+}
+
+static inline void GPIO_WritePinOutput(GPIO_Type *base, uint32_t pin, uint8_t output)
+{
+    base->PDOR = (base->PDOR & ~(1U << pin)) | ((uint32_t)output << pin);
+}
+
+static inline void GPIO_ClearPinsInterruptFlags(GPIO_Type *base, uint32_t mask)
+{
+    (void)base;
+    (void)mask;
+}
+#endif
@@ -0,0 +1,9 @@
+/* Host build stub */
+#ifndef _FSL_LPTMR_H_
+#define _FSL_LPTMR_H_
+#include "fsl_common.h"
+
+#define kLPTMR_TimerCompareFlag     (0x80U)
+
+void LPTMR_ClearStatusFlags(LPTMR_Type *base, uint32_t mask);
+#endif
@@ -0,0 +1,25 @@
+/* Host build stub: single threaded, interrupt masking only counts its nesting */
+#ifndef _FSL_OS_ABSTRACTION_H_
+#define _FSL_OS_ABSTRACTION_H_
+#include <stdint.h>
+
+typedef void *osaTaskParam_t;
+typedef void *osaTaskId_t;
+typedef void *osaEventId_t;
+typedef uint32_t osaEventFlags_t;
+typedef uint32_t osa_status_t;
+
+#define osaWaitForever_c        ((uint32_t)(-1))
+#define osaEventFlagsAll_c      ((osaEventFlags_t)(0x00FFFFFF))
+#define OSA_TASK_DEFINE(name, priority, instances, stackSz, useFloat)
+#define OSA_TASK(name)          NULL
+
+void OSA_InterruptDisable(void);
+void OSA_InterruptEnable(void);
+void OSA_InstallIntHandler(uint32_t IRQNumber, void (*handler)(void));
+osaEventId_t OSA_EventCreate(uint8_t autoClear);
+osa_status_t OSA_EventSet(osaEventId_t eventId, osaEventFlags_t flagsToSet);
+osa_status_t OSA_EventWait(osaEventId_t eventId, osaEventFlags_t flagsToWait, uint8_t waitAll,
+                           uint32_t millisec, osaEventFlags_t *pSetFlags);
+osaTaskId_t OSA_TaskCreate(void *thread_def, osaTaskParam_t task_param);
+#endif
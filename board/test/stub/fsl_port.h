@@ -0,0 +1,2 @@
+/* Host build stub */
+#include "fsl_common.h"
@@ -0,0 +1,13 @@
+/* Host build stub: the semaphores are provided by the test */
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+#include "FreeRTOS.h"
+
+typedef struct TestSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *pHigherPriorityTaskWoken);
+#endif
@@ -0,0 +1,18 @@
+/* Host build stub: the tick count, critical sections and task handles are provided by the test */
+#ifndef INC_TASK_H
+#define INC_TASK_H
+#include "FreeRTOS.h"
+
+typedef struct TestTask *TaskHandle_t;
+
+#define taskSCHEDULER_RUNNING   ((BaseType_t)2)
+
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t xTaskGetSchedulerState(void);
+void vTaskEnterCritical(void);
+void vTaskExitCritical(void);
+
+#define taskENTER_CRITICAL()    vTaskEnterCritical()
+#define taskEXIT_CRITICAL()     vTaskExitCritical()
+#endif
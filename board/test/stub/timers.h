@@ -0,0 +1,15 @@
+/* Host build stub: the software timers are provided by the test */
+#ifndef TIMERS_H
+#define TIMERS_H
+#include "FreeRTOS.h"
+
+typedef struct TestTimer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+typedef void (*PendedFunction_t)(void *pParam, uint32_t param);
+
+TimerHandle_t xTimerCreate(const char *pName, TickType_t period, UBaseType_t autoReload, void *pTimerId,
+                           TimerCallbackFunction_t callback);
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticksToWait);
+BaseType_t xTimerPendFunctionCallFromISR(PendedFunction_t function, void *pParam, uint32_t param,
+                                         BaseType_t *pHigherPriorityTaskWoken);
+#endif
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file tickless_idle_test.c
+ * Host test for the tickless idle mode and the TimersManager functions it relies on. Both module
+ * sources are built in over a simulated clock: the FTM counter of the TimersManager, the chained
+ * PIT of the timestamp and the RTOS tick advance together, and stop as the hardware does in Normal
+ * Stop. The tests cover TMR_GetFirstExpireTime() with timers of each type, across counter wraps,
+ * TicklessIdleEarliestDeadline() with the deadline callbacks, and whole idle periods in Wait mode
+ * and Normal Stop, after which the timers and TMR_GetTimestamp() must agree with the real time.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TICKLESS_IDLE_DEEP_SLEEP    (1)
+
+/* The stub first, the sources would find the real board.h next to them */
+#include "stub/board.h"
+#include "../tickless_idle.c"
+#include "../../framework/TimersManager/Source/TimersManager.c"
+
+/*****************************************************************************
+ * Simulated hardware
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+/* FTM clock: the 60 MHz bus clock divided by 128 */
+#define TEST_FTM_HZ     (60000000U / 128U)
+
+LPTMR_Type gLptmr0;
+RTC_Type gRtc;
+PIT_Type gPit;
+SMC_Type gSmc;
+SCB_Type gScb;
+MCG_Type gMcg;
+volatile uint8_t lptmrFlag;
+volatile uint8_t lptmr_init_status;
+
+static uint64_t sNowUs;          /* real time */
+static uint64_t sPitUs;          /* time counted by the PIT */
+static uint64_t sFtmFrac;        /* FTM counts times 1000000 not yet counted */
+static uint16_t sFtmCount;
+static bool sFtmRunning;
+static uint16_t sFtmCompare;
+static TickType_t sTicks;
+static int32_t sIrqDepth;
+static uint32_t sWfiCount;
+static uint32_t sSuppressCount;
+static TickType_t sSuppressTicks;
+static bool sSuppressDeep;          /* mode of the last sleep, true for Normal Stop */
+static TickType_t sWakeAfterTicks;  /* earlier wakeup by another interrupt, 0 for none */
+static bool sTmrPending;            /* timer task event set, served when the idle task returns */
+
+static void UpdatePit(void)
+{
+    /* The chained channels count down from all ones */
+    gPit.CHANNEL[1].CVAL = ~(uint32_t)sPitUs;
+    gPit.CHANNEL[2].CVAL = ~(uint32_t)(sPitUs >> 32);
+}
+
+/* Advances the time, in Normal Stop the bus clock and so the FTM and the PIT stop */
+static void Advance(uint32_t us, bool stopMode)
+{
+    sNowUs += us;
+    if (!stopMode)
+    {
+        sPitUs += us;
+        UpdatePit();
+        if (sFtmRunning)
+        {
+            sFtmFrac += (uint64_t)us * TEST_FTM_HZ;
+            sFtmCount += (uint16_t)(sFtmFrac / 1000000U);
+            sFtmFrac %= 1000000U;
+        }
+    }
+}
+
+/* Advances one millisecond, returns true on a compare match of the TimersManager counter */
+static bool Tick(bool stopMode)
+{
+    uint16_t before = sFtmCount;
+    bool running = sFtmRunning && !stopMode;
+
+    Advance(1000U, stopMode);
+    sTicks++;
+    return running && ((uint16_t)(sFtmCompare - before - 1U) < (uint16_t)(sFtmCount - before));
+}
+
+/* Runs for a time with the TimersManager task served on each compare match, as the ISR does */
+static void RunFor(uint32_t ms)
+{
+    if (sTmrPending)
+    {
+        sTmrPending = false;
+        TMR_Task(NULL);
+    }
+    while (ms--)
+    {
+        if (Tick(false))
+        {
+            TMR_Task(NULL);
+        }
+    }
+}
+
+void StackTimer_Init(void (*cb)(void)) { (void)cb; }
+void StackTimer_Enable(void) { sFtmRunning = true; }
+void StackTimer_Disable(void) { sFtmRunning = false; }
+void StackTimer_ClearIntFlag(void) {}
+uint32_t StackTimer_GetInputFrequency(void) { return TEST_FTM_HZ; }
+uint32_t StackTimer_GetCounterValue(void) { return sFtmCount; }
+void StackTimer_SetOffsetTicks(uint32_t offset) { sFtmCompare = (uint16_t)offset; }
+
+void OSA_InterruptDisable(void) { sIrqDepth++; }
+void OSA_InterruptEnable(void) { CHECK(sIrqDepth > 0); sIrqDepth--; }
+void OSA_InstallIntHandler(uint32_t IRQNumber, void (*handler)(void)) { (void)IRQNumber; (void)handler; }
+osaEventId_t OSA_EventCreate(uint8_t autoClear) { (void)autoClear; return (osaEventId_t)&sTmrPending; }
+osa_status_t OSA_EventSet(osaEventId_t e, osaEventFlags_t f) { (void)e; (void)f; sTmrPending = true; return 0; }
+osa_status_t OSA_EventWait(osaEventId_t e, osaEventFlags_t f, uint8_t a, uint32_t t, osaEventFlags_t *p)
+{ (void)e; (void)f; (void)a; (void)t; (void)p; return 0; }
+osaTaskId_t OSA_TaskCreate(void *d, osaTaskParam_t p) { (void)d; (void)p; return (osaTaskId_t)1; }
+const uint8_t gUseRtos_c = 0;
+void panic(panicId_t id, uint32_t location, uint32_t extra1, uint32_t extra2)
+{ (void)id; (void)location; (void)extra1; (void)extra2; CHECK(0); }
+
+TickType_t xTaskGetTickCount(void) { return sTicks; }
+void vTaskEnterCritical(void) { OSA_InterruptDisable(); }
+void vTaskExitCritical(void) { OSA_InterruptEnable(); }
+void LPTMR0_Init(void) { lptmr_init_status = 1U; }
+void vPortLptmrIsr(void) {}
+void LPTMR_ClearStatusFlags(LPTMR_Type *base, uint32_t mask) { (void)base; (void)mask; }
+void __WFI(void) { sWfiCount++; }
+
+/* The FreeRTOS LPTMR port: sleeps for the ticks asked, or until another interrupt. The
+   TimersManager compare match is one of them. */
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+    TickType_t slept = xExpectedIdleTime;
+
+    sSuppressCount++;
+    sSuppressTicks = xExpectedIdleTime;
+    sSuppressDeep = sIsDeepSleep;
+    if ((0U != sWakeAfterTicks) && (sWakeAfterTicks < slept))
+    {
+        slept = sWakeAfterTicks;
+    }
+
+    TicklessIdle_PreSleep(xExpectedIdleTime);
+    CHECK(((gScb.SCR & SCB_SCR_SLEEPDEEP_Msk) != 0U) == sIsDeepSleep);
+    while (slept-- && !sTmrPending)
+    {
+        sTmrPending = Tick(sIsDeepSleep);
+    }
+    TicklessIdle_PostSleep(xExpectedIdleTime);
+    CHECK((gScb.SCR & SCB_SCR_SLEEPDEEP_Msk) == 0U);
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+/* Remaining times are rounded up to whole milliseconds of FTM ticks */
+static bool NearMs(uint32_t ms, uint32_t expected)
+{
+    return (ms + 1U >= expected) && (ms <= expected + 1U);
+}
+
+static uint32_t sFired[gTmrTotalTimers_c];
+static uint64_t sFiredUs[gTmrTotalTimers_c];
+static uint32_t sDeadlineA = UINT32_MAX;
+static uint32_t sDeadlineB = UINT32_MAX;
+
+static void TimerCallback(void *param)
+{
+    sFired[(uintptr_t)param]++;
+    sFiredUs[(uintptr_t)param] = sNowUs;
+}
+
+static uint32_t DeadlineA(void)
+{
+    return sDeadlineA;
+}
+
+static uint32_t DeadlineB(void)
+{
+    return sDeadlineB;
+}
+
+static tmrTimerID_t Start(tmrTimerType_t type, uint32_t ms)
+{
+    tmrTimerID_t id = TMR_AllocateTimer();
+
+    CHECK(id != gTmrInvalidTimerID_c);
+    sFired[id] = 0;
+    CHECK(TMR_StartTimer(id, type, ms, TimerCallback, (void *)(uintptr_t)id) == gTmrSuccess_c);
+    return id;
+}
+
+static void FreeAll(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < gTmrTotalTimers_c; i++)
+    {
+        (void)TMR_FreeTimer((tmrTimerID_t)i);
+    }
+    CHECK(TMR_AreAllTimersOff());
+}
+
+static void TestFirstExpireTime(void)
+{
+    tmrTimerID_t interval;
+    tmrTimerID_t single;
+    tmrTimerID_t lowPower;
+    uint32_t i;
+
+    CHECK(TMR_GetFirstExpireTime(gTmrAllTypes_c) == UINT32_MAX);
+
+    single = Start(gTmrSingleShotTimer_c, 100);
+    interval = Start(gTmrIntervalTimer_c, 30);
+    lowPower = Start(gTmrLowPowerSingleShotMillisTimer_c, 500);
+
+    /* Started timers count once the timer task has taken them */
+    CHECK(TMR_GetFirstExpireTime(gTmrAllTypes_c) == UINT32_MAX);
+    TMR_Task(NULL);
+    CHECK(TMR_GetFirstExpireTime(gTmrAllTypes_c) == 30);
+    CHECK(TMR_GetFirstExpireTime(gTmrSingleShotTimer_c) == 100);
+    CHECK(TMR_GetFirstExpireTime(gTmrLowPowerTimer_c) == 500);
+    CHECK(TMR_GetFirstExpireTime(gTmrSecondTimer_c) == UINT32_MAX);
+
+    /* Between two runs of the timer task the time elapsed since is taken off */
+    Advance(10000U, false);
+    CHECK(NearMs(TMR_GetFirstExpireTime(gTmrAllTypes_c), 20));
+    CHECK(NearMs(TMR_GetFirstExpireTime(gTmrSingleShotTimer_c), 90));
+
+    /* Over 1 s the 16-bit FTM counter wraps 7 times */
+    RunFor(20);
+    for (i = 0; i < 34; i++)
+    {
+        uint32_t elapsed = 30U + 30U * i;
+        uint32_t expected;
+
+        /* The interval timer fires every 30 ms, the single shot ones once */
+        expected = 30U - (elapsed % 30U);
+        if ((elapsed < 100U) && (100U - elapsed < expected))
+        {
+            expected = 100U - elapsed;
+        }
+        if ((elapsed < 500U) && (500U - elapsed < expected))
+        {
+            expected = 500U - elapsed;
+        }
+        CHECK(NearMs(TMR_GetFirstExpireTime(gTmrAllTypes_c), expected));
+        if (elapsed < 500U)
+        {
+            CHECK(NearMs(TMR_GetFirstExpireTime(gTmrLowPowerTimer_c), 500U - elapsed));
+        }
+        else
+        {
+            CHECK(TMR_GetFirstExpireTime(gTmrLowPowerTimer_c) == UINT32_MAX);
+        }
+        RunFor(30);
+    }
+    CHECK(sFired[single] == 1);
+    CHECK(sFired[lowPower] == 1);
+    CHECK((sFired[interval] >= 34) && (sFired[interval] <= 35));
+    CHECK(!TMR_IsTimerActive(single) && !TMR_IsTimerActive(lowPower));
+    CHECK(TMR_GetFirstExpireTime(gTmrSingleShotTimer_c) == UINT32_MAX);
+
+    FreeAll();
+    CHECK(TMR_GetFirstExpireTime(gTmrAllTypes_c) == UINT32_MAX);
+    CHECK(sIrqDepth == 0);
+    printf("  TMR_GetFirstExpireTime: each type, between timer task runs, over 7 counter wraps\n");
+}
+
+static void TestEarliestDeadline(void)
+{
+    CHECK(TicklessIdleEarliestDeadline(1000, UINT32_MAX) == 1000);
+    CHECK(TicklessIdleEarliestDeadline(1000, 40) == 40);
+    CHECK(TicklessIdleEarliestDeadline(5, 40) == 5);
+
+    CHECK(TicklessIdle_RegisterDeadline(DeadlineA) == 0);
+    CHECK(TicklessIdle_RegisterDeadline(DeadlineB) == 0);
+    CHECK(TicklessIdleEarliestDeadline(1000, 40) == 40);
+    sDeadlineA = 25;
+    CHECK(TicklessIdleEarliestDeadline(1000, 40) == 25);
+    sDeadlineB = 12;
+    CHECK(TicklessIdleEarliestDeadline(1000, 40) == 12);
+    CHECK(TicklessIdleEarliestDeadline(3, 40) == 3);
+    sDeadlineB = 0;
+    CHECK(TicklessIdleEarliestDeadline(1000, UINT32_MAX) == 0);
+    sDeadlineA = UINT32_MAX;
+    sDeadlineB = UINT32_MAX;
+    CHECK(TicklessIdleEarliestDeadline(1000, UINT32_MAX) == 1000);
+
+    /* TICKLESS_IDLE_MAX_DEADLINES slots */
+    CHECK(TicklessIdle_RegisterDeadline(DeadlineA) == 0);
+    CHECK(TicklessIdle_RegisterDeadline(DeadlineB) == 0);
+    CHECK(TicklessIdle_RegisterDeadline(DeadlineA) == -1);
+    printf("  TicklessIdleEarliestDeadline: RTOS, TimersManager and callback deadlines\n");
+}
+
+static void TestSleep(void)
+{
+    tmrTimerID_t interval;
+    tmrTimerID_t lowPower;
+    uint64_t timestamp;
+    uint64_t previous;
+    uint64_t startUs;
+    uint64_t dueUs;
+    uint64_t pitUs;
+    uint32_t fired;
+    uint32_t i;
+
+    /* Too short to stop the tick: WFI unless already due */
+    sWfiCount = 0;
+    sSuppressCount = 0;
+    TicklessIdle_Sleep(1);
+    CHECK((sWfiCount == 1) && (sSuppressCount == 0));
+    sDeadlineA = 0;
+    TicklessIdle_Sleep(100);
+    CHECK((sWfiCount == 1) && (sSuppressCount == 0));
+
+    /* A callback deadline shortens the sleep */
+    sDeadlineA = 7;
+    TicklessIdle_Sleep(100);
+    CHECK((sSuppressCount == 1) && (sSuppressTicks == 7) && !sSuppressDeep);
+    sDeadlineA = UINT32_MAX;
+
+    /* The RTOS timeout is capped to what the 16-bit LPTMR counts */
+    TicklessIdle_Sleep(100000);
+    CHECK((sSuppressTicks == TICKLESS_IDLE_MAX_TICKS) && sSuppressDeep);
+
+    /* A running TimersManager timer keeps the MCU in Wait mode, and wakes it up in time */
+    interval = Start(gTmrIntervalTimer_c, 40);
+    TMR_Task(NULL);
+    RunFor(15);
+    TicklessIdle_Sleep(1000);
+    CHECK(NearMs(sSuppressTicks, 25) && !sSuppressDeep);
+    RunFor(1);
+    CHECK(sFired[interval] == 1);
+    CHECK(TMR_GetFirstExpireTime(gTmrAllTypes_c) >= 38);
+    FreeAll();
+
+    /* Only low power timers: Normal Stop, the timers and the timestamp catch up on wakeup */
+    lowPower = Start(gTmrLowPowerIntervalMillisTimer_c, 300);
+    TMR_Task(NULL);
+    startUs = sNowUs;
+    RunFor(5);
+    previous = TMR_GetTimestamp();
+    CHECK(previous == sNowUs);
+    for (i = 0; i < 10; i++)
+    {
+        /* Woken up early by a port interrupt on every other sleep */
+        sWakeAfterTicks = (i & 1U) ? 120U : 0U;
+        dueUs = ((0U != sFired[lowPower]) ? sFiredUs[lowPower] : startUs) + 300000U;
+        pitUs = sPitUs;
+        fired = sFired[lowPower];
+        CHECK(!sTmrPending);
+        TicklessIdle_Sleep(1000);
+        CHECK(NearMs(sSuppressTicks, (uint32_t)((dueUs - previous) / 1000U)));
+        CHECK(sSuppressDeep && (sPitUs == pitUs));
+        CHECK(TMR_GetTimestamp() == sNowUs);
+        RunFor(5);
+        CHECK((sFired[lowPower] == fired) || ((sFired[lowPower] == fired + 1U) && (sFiredUs[lowPower] >= dueUs) &&
+                                                (sFiredUs[lowPower] <= dueUs + 2000U)));
+        timestamp = TMR_GetTimestamp();
+        CHECK((timestamp == sNowUs) && (timestamp > previous));
+        previous = timestamp;
+    }
+    sWakeAfterTicks = 0;
+    CHECK(sFired[lowPower] >= 5);
+    CHECK(sPitUs < sNowUs);
+
+    /* A module holding the bus clock keeps the MCU in Wait mode, where the PIT counts */
+    TicklessIdle_DisallowDeepSleep();
+    previous = sNowUs - sPitUs;
+    TicklessIdle_Sleep(1000);
+    CHECK(!sSuppressDeep && (sNowUs - sPitUs == previous));
+    TicklessIdle_AllowDeepSleep();
+    TicklessIdle_AllowDeepSleep();
+    CHECK(sDeepSleepVotes == 0);
+    FreeAll();
+
+    CHECK(sIrqDepth == 0);
+    printf("  TicklessIdle_Sleep: WFI, Wait mode, Normal Stop with %llu ms of stopped PIT made up\n",
+           (unsigned long long)(sNowUs - sPitUs) / 1000U);
+}
+
+static void TestTimestamp(void)
+{
+    uint64_t before;
+    uint64_t after;
+
+    /* Around the 32-bit boundary of the chained PIT channels */
+    sPitUs = 0xFFFFFF00ULL;
+    sNowUs = sPitUs + mTmrTimestampSleepUs;
+    UpdatePit();
+    before = TMR_GetTimestamp();
+    Advance(0x200U, false);
+    after = TMR_GetTimestamp();
+    CHECK((before == sNowUs - 0x200U) && (after == sNowUs));
+
+    TMR_SyncTimestamp(1234U);
+    CHECK(TMR_GetTimestamp() == after + 1234U);
+    CHECK(sIrqDepth == 0);
+    printf("  TMR_GetTimestamp: PIT carry, sleep time added\n");
+}
+
+int main(void)
+{
+    TMR_Init();
+    TMR_TimeStampInit();
+    UpdatePit();
+
+    TestFirstExpireTime();
+    TestEarliestDeadline();
+    TestSleep();
+    TestTimestamp();
+
+    printf("tickless_idle: all tests passed\n");
+    return 0;
+}
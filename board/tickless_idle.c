@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file tickless_idle.c
+ * This is the source file for the tickless idle mode
+ */
+
+#include "tickless_idle.h"
+#include "board.h"
+#include "fsl_lptmr.h"
+#include "task.h"
+#include "TimersManager.h"
+
+/*****************************************************************************
+ * Variables
+ ****************************************************************************/
+/* The LPTMR counts 1 ms per count, the RTOS tick must be a whole number of them */
+#define TICKLESS_IDLE_LPTMR_HZ      (1000U)
+#define TICKLESS_IDLE_MAX_TICKS     ((0xFFFFUL * configTICK_RATE_HZ) / TICKLESS_IDLE_LPTMR_HZ)
+
+extern volatile uint8_t lptmr_init_status;
+extern void LPTMR0_Init(void);
+extern void vPortLptmrIsr(void);
+extern void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);
+
+static volatile bool sIsSleeping = false;
+static bool sIsDeepSleep = false;
+static volatile uint32_t sDeepSleepVotes;
+static tickless_idle_deadline_t sDeadlines[TICKLESS_IDLE_MAX_DEADLINES];
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+/*!
+ * @brief Computes the earliest wakeup time
+ *
+ * @param[in] rtosMs  Time until the next FreeRTOS timeout
+ * @param[in] tmrMs   Time until the next TimersManager expiry, UINT32_MAX if none
+ *
+ * @return Time in milliseconds until the earliest deadline
+ *
+ */
+static uint32_t TicklessIdleEarliestDeadline(uint32_t rtosMs, uint32_t tmrMs)
+{
+    uint32_t deadline = (tmrMs < rtosMs) ? tmrMs : rtosMs;
+    uint32_t sensorMs;
+    uint32_t i;
+
+    for (i = 0; i < TICKLESS_IDLE_MAX_DEADLINES; i++)
+    {
+        if (NULL != sDeadlines[i])
+        {
+            sensorMs = sDeadlines[i]();
+
+            if (sensorMs < deadline)
+            {
+                deadline = sensorMs;
+            }
+        }
+    }
+
+    return deadline;
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+/* LPTMR hooks of the FreeRTOS LPTMR tickless port (fsl_tickless_lptmr.c) */
+LPTMR_Type *vPortGetLptrmBase(void)
+{
+    /* Shared with App_WaitMsec(), initialized by whichever runs first */
+    if (1U != lptmr_init_status)
+    {
+        LPTMR0_Init();
+    }
+
+    return LPTMR0;
+}
+
+IRQn_Type vPortGetLptmrIrqn(void)
+{
+    return LPTMR0_IRQn;
+}
+
+void LPTMR0_IRQHandler(void)
+{
+    if (sIsSleeping)
+    {
+        vPortLptmrIsr();
+    }
+    else
+    {
+        /* Outside of the idle task the LPTMR only runs for App_WaitMsec() and App_WaitUsec() */
+        LPTMR_ClearStatusFlags(LPTMR0, kLPTMR_TimerCompareFlag);
+        lptmrFlag = 1;
+    }
+
+    __DSB();
+    __ISB();
+}
+
+int32_t TicklessIdle_RegisterDeadline(tickless_idle_deadline_t deadline)
+{
+    uint32_t i;
+
+    for (i = 0; i < TICKLESS_IDLE_MAX_DEADLINES; i++)
+    {
+        if (NULL == sDeadlines[i])
+        {
+            sDeadlines[i] = deadline;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+void TicklessIdle_DisallowDeepSleep(void)
+{
+    taskENTER_CRITICAL();
+    sDeepSleepVotes++;
+    taskEXIT_CRITICAL();
+}
+
+void TicklessIdle_AllowDeepSleep(void)
+{
+    taskENTER_CRITICAL();
+    if (sDeepSleepVotes > 0U)
+    {
+        sDeepSleepVotes--;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void TicklessIdle_Sleep(TickType_t expectedIdleTime)
+{
+    TickType_t tickBefore;
+    uint32_t sleptMs;
+    uint32_t deadlineMs;
+    TickType_t sleepTicks;
+#if TICKLESS_IDLE_DEEP_SLEEP
+    uint16_t tmrUncountedTicks = 0U;
+#endif
+
+    if (expectedIdleTime > TICKLESS_IDLE_MAX_TICKS)
+    {
+        expectedIdleTime = TICKLESS_IDLE_MAX_TICKS;
+    }
+
+    deadlineMs = TicklessIdleEarliestDeadline((expectedIdleTime * 1000U) / configTICK_RATE_HZ,
+                                              TMR_GetFirstExpireTime(gTmrAllTypes_c));
+    sleepTicks = (deadlineMs * configTICK_RATE_HZ) / 1000U;
+
+    if (sleepTicks < configEXPECTED_IDLE_TIME_BEFORE_SLEEP)
+    {
+        /* Too short to stop the tick, wait for the next interrupt unless a timer is already due */
+        if (0U != deadlineMs)
+        {
+            __DSB();
+            __WFI();
+            __ISB();
+        }
+        return;
+    }
+
+#if TICKLESS_IDLE_DEEP_SLEEP
+    /* The TimersManager timers that are not low power ones stop counting in Normal Stop */
+    sIsDeepSleep = (0U == sDeepSleepVotes) && (deadlineMs >= TICKLESS_IDLE_DEEP_SLEEP_MIN_MS) &&
+                   TMR_AreAllTimersOff();
+
+    if (sIsDeepSleep)
+    {
+        tmrUncountedTicks = TMR_NotCountedTicksBeforeSleep();
+    }
+#endif
+
+    tickBefore = xTaskGetTickCount();
+    sIsSleeping = true;
+
+    vPortSuppressTicksAndSleep(sleepTicks);
+
+    sIsSleeping = false;
+    sleptMs = ((xTaskGetTickCount() - tickBefore) * 1000U) / configTICK_RATE_HZ;
+
+#if TICKLESS_IDLE_DEEP_SLEEP
+    if (sIsDeepSleep)
+    {
+        /* The FTM and PIT were stopped, catch up with the time measured by the LPTMR */
+        TMR_SyncLpmTimers((uint32_t)tmrUncountedTicks + (uint32_t)(((uint64_t)sleptMs * TMR_GetTimerFreq()) / 1000U));
+        TMR_SyncTimestamp(sleptMs * 1000U);
+        TMR_MakeTMRThreadReady();
+        sIsDeepSleep = false;
+    }
+#else
+    (void)sleptMs;
+#endif
+}
+
+void TicklessIdle_PreSleep(TickType_t expectedIdleTime)
+{
+    (void)expectedIdleTime;
+
+    if (sIsDeepSleep)
+    {
+        /* Normal Stop on the next WFI */
+        SMC->PMCTRL = (SMC->PMCTRL & ~SMC_PMCTRL_STOPM_MASK) | SMC_PMCTRL_STOPM(0U);
+        (void)SMC->PMCTRL;
+        SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    }
+    else
+    {
+        /* Wait mode on the next WFI */
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    }
+}
+
+void TicklessIdle_PostSleep(TickType_t expectedIdleTime)
+{
+    (void)expectedIdleTime;
+
+    if (sIsDeepSleep)
+    {
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+        /* The PLL was disabled in Normal Stop, wait for it to lock again in PEE mode */
+        if (MCG->S & MCG_S_PLLST_MASK)
+        {
+            while (!(MCG->S & MCG_S_LOCK0_MASK))
+            {
+            }
+        }
+    }
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file tickless_idle.h
+ * This is the header file for the tickless idle mode
+ */
+
+#ifndef _TICKLESS_IDLE_H_
+#define _TICKLESS_IDLE_H_
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+/*!
+ * @addtogroup tickless_idle Tickless Idle
+ *
+ * The tickless_idle module puts the MCU to sleep when the FreeRTOS idle task runs, with the RTOS
+ * tick suppressed.
+ *
+ * The sleep lasts until the earliest of the next FreeRTOS timeout (blocked tasks and software
+ * timers), the next TimersManager expiry and the deadlines reported by the registered callbacks,
+ * or until any interrupt. LPTMR0, clocked by the 1 kHz LPO, is the only time source counting
+ * during sleep. On wakeup the slept time read from it steps the RTOS tick and, after a deep sleep,
+ * the TimersManager timers. emWin takes its time from the RTOS tick, so it no longer needs a
+ * periodic LPTMR interrupt of its own.
+ *
+ * The MCU enters Wait mode, where all clocks keep running. If TICKLESS_IDLE_DEEP_SLEEP is set it
+ * enters Normal Stop instead when the sleep lasts at least TICKLESS_IDLE_DEEP_SLEEP_MIN_MS, no
+ * module disallowed it and no TimersManager timer other than the low power ones is running.
+ * Only the LPTMR and the port interrupts wake the MCU from Normal Stop, so drivers with transfers
+ * in progress over interrupts or DMA must disallow deep sleep until they complete.
+ *
+ * Usage
+ * -------------------------------------------------------------------------------------------------
+ *
+ * Sensor deadline:
+ * @code
+ *
+ *      static uint32_t myDeadline(void)
+ *      {
+ *          // Milliseconds until the sensor needs the CPU, UINT32_MAX if it does not
+ *          return myNextReadMs;
+ *      }
+ *
+ *      TicklessIdle_RegisterDeadline(myDeadline);
+ *
+ * @endcode
+ *
+ * Deep sleep vote:
+ * @code
+ *
+ *      TicklessIdle_DisallowDeepSleep();
+ *      // Transfer that needs the bus clock
+ *      TicklessIdle_AllowDeepSleep();
+ *
+ * @endcode
+ *
+ * @{
+ * @brief Tickless low power idle mode
+ */
+
+#ifndef TICKLESS_IDLE_DEEP_SLEEP
+#define TICKLESS_IDLE_DEEP_SLEEP            (0)       /*!< Allow Normal Stop, Wait mode only if 0 */
+#endif
+
+#ifndef TICKLESS_IDLE_DEEP_SLEEP_MIN_MS
+#define TICKLESS_IDLE_DEEP_SLEEP_MIN_MS     (10U)     /*!< Shortest sleep worth the PLL relock */
+#endif
+
+#ifndef TICKLESS_IDLE_MAX_DEADLINES
+#define TICKLESS_IDLE_MAX_DEADLINES         (4U)      /*!< Number of deadline callbacks */
+#endif
+
+/*!
+ * @brief Deadline callback, returns the time in milliseconds until the module needs the CPU, or
+ *        UINT32_MAX if it has no deadline. Runs in the idle task with the scheduler suspended,
+ *        so it must not block.
+ */
+typedef uint32_t (*tickless_idle_deadline_t)(void);
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Registers a deadline callback
+ *
+ * @param[in] deadline  Callback to add
+ *
+ * @return 0 on success, -1 if all the callback slots are used
+ *
+ */
+int32_t TicklessIdle_RegisterDeadline(tickless_idle_deadline_t deadline);
+
+/*!
+ * @brief Prevents deep sleep until the matching TicklessIdle_AllowDeepSleep() call. Calls nest.
+ *
+ * @return None
+ *
+ */
+void TicklessIdle_DisallowDeepSleep(void);
+
+/*!
+ * @brief Releases one TicklessIdle_DisallowDeepSleep() call
+ *
+ * @return None
+ *
+ */
+void TicklessIdle_AllowDeepSleep(void);
+
+/*!
+ * @brief Sleeps with the RTOS tick suppressed, called by the idle task through
+ *        portSUPPRESS_TICKS_AND_SLEEP()
+ *
+ * @param[in] expectedIdleTime  Ticks until the next FreeRTOS timeout
+ *
+ * @return None
+ *
+ */
+void TicklessIdle_Sleep(TickType_t expectedIdleTime);
+
+/*!
+ * @brief Selects the sleep mode, called through configPRE_SLEEP_PROCESSING()
+ *
+ * @param[in] expectedIdleTime  Ticks the LPTMR is programmed for
+ *
+ * @return None
+ *
+ */
+void TicklessIdle_PreSleep(TickType_t expectedIdleTime);
+
+/*!
+ * @brief Restores the run mode, called through configPOST_SLEEP_PROCESSING()
+ *
+ * @param[in] expectedIdleTime  Ticks the LPTMR was programmed for
+ *
+ * @return None
+ *
+ */
+void TicklessIdle_PostSleep(TickType_t expectedIdleTime);
+
+/*! @}*/
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _TICKLESS_IDLE_H_
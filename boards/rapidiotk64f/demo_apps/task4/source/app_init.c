@@ -62,6 +62,11 @@
 #include "Keyboard.h"
 #include "SerialManager.h"
 #include "Panic.h"
+#include "DeferredLog.h"
+#include "KVStore.h"
+#include "SensorHistory.h"
+#include "air_baseline.h"
+#include "Flash_Adapter.h"
 
 #include "fsl_os_abstraction.h"
 #include "app_init.h"
@@ -292,8 +297,17 @@ osaSemaphoreId_t gOtaSem;
 
 void Init_Display()
 {
+    uint8_t level;
+
     Display_Connect(); /* triggers GUI_Init() */
-    Backlight_SetLevel(BLIGHT_LEVEL_HIGH);
+
+    /* Level last chosen with "set backlight", if any */
+    if ((gKVStoreSuccess_c != KVStore_Get(gAppKVKeyBacklight_c, &level, sizeof(level), NULL)) ||
+        (level > BLIGHT_LEVEL_HIGH))
+    {
+        level = BLIGHT_LEVEL_HIGH;
+    }
+    Backlight_SetLevel((backlight_level_t)level);
 
     GUI_SetBkColor(GUI_BLACK);
     GUI_SetColor(GUI_WHITE);
@@ -368,6 +382,12 @@ void main_task(uint32_t param)
         /* Init  timers module */
         TMR_Init();
         TMR_TimeStampInit();
+        /* Init key-value store, on the flash region reserved by the linker file */
+        if (!KVStore_Init(&gKVStoreInternalFlashStorage))
+        {
+            panic(0,0,0,0);
+        }
+
         /* Init Led module */
         LED_Init();
 
@@ -378,6 +398,8 @@ void main_task(uint32_t param)
         RGB_Led_Set_State(0,3);
 
         SerialManager_Init();
+        /* Init deferred logging, after the serial interfaces it drains to */
+        DLOG_Init();
 
 #ifdef FRDM_K64F_KW41Z
         /* Initialize shell for Thread commands */
@@ -423,6 +445,12 @@ void main_task(uint32_t param)
     PORT_IRQ_EnablePortDIrq();
     PORT_IRQ_EnablePortEIrq();
 
+    /* Read the sensors with data ready interrupts when they signal new data */
+    if (Init_sensor_events())
+    {
+        DLOG_PRINTF("Error while enabling sensor interrupts\r\n");
+    }
+
     BleApp_DemoRpk();
 
     /* Main Application Loop (idle state) */
@@ -434,6 +462,18 @@ void main_task(uint32_t param)
         /* Reset MCU */
         APP_HandleMcuResetOnIdle();
 
+        /* Reclaim key-value store sectors in the background */
+        KVStore_Idle();
+
+        /* Write the completed sensor history blocks to the external flash */
+        SensorHistory_Idle();
+
+        /* Write the air quality baseline checkpoints to the external flash */
+        AirBaseline_Idle();
+
+        /* Run the queued internal flash requests */
+        NV_FlashProcessQueue();
+
         /* For BareMetal break the while(1) after 1 run */
         if (gUseRtos_c == 0)
         {
@@ -43,6 +43,7 @@
  ************************************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 
 /* Framework / Drivers */
 #include "LED.h"
@@ -54,6 +55,13 @@
 #include "MemManager.h"
 #include "board.h"
 #include "sensors.h"
+#include "sensor_conditioning.h"
+#include "air_baseline.h"
+#include "DeferredLog.h"
+#include "fsl_ftoa.h"
+#include "SensorHistory.h"
+#include "flash_ica_driver.h"
+#include "img_program_ext.h"
 
 /* Shell APIs */
 #include "shell_gap.h"
@@ -70,6 +78,7 @@
 #include "GUI.h"
 
 #include "FsciInterface.h"
+#include "att_errors.h"
 /************************************************************************************
 *************************************************************************************
 * Private macros
@@ -82,6 +91,15 @@
 #define gFastConnMinAdvInterval_c    32     /* 20 ms */
 #define gFastConnMaxAdvInterval_c    48     /* 30 ms */
 #define mDemoReportInterval_c        (0.3)  /* RPK demo report interval in seconds */
+
+/* Default reporting settings: deadband (telemetry units), min and max interval (s) */
+#define mReportTemperatureDefault_c  {gReportTemperature_c,  10,  0, 60}  /* 0.1 C */
+#define mReportHumidityDefault_c     {gReportHumidity_c,     50,  0, 60}  /* 0.5 % */
+#define mReportPressureDefault_c     {gReportPressure_c,     1,   0, 60}  /* 1 hPa */
+#define mReportAmbientLightDefault_c {gReportAmbientLight_c, 500, 0, 60}  /* 5 lux */
+#define mAttErrCodeOutOfRange_c      (0xFF) /* Common profile and service error code */
+#define mHistoryFrameInterval_c      20     /* ms between two history download frames */
+#define mHistoryFrameSize_c          20     /* Counter byte and data, fits the default ATT MTU */
 /************************************************************************************
 *************************************************************************************
 * Public type definitions
@@ -97,7 +115,16 @@ static int8_t BleApp_DemoCommand(uint8_t argc, char *argv[]);
 
 static void BleApp_StartRpkDemoSm(void *param);
 static void BleApp_NotifyRpkSm(void *param);
-static void BleApp_Notify(uint16_t hValue, uint8_t *value, uint8_t ValueLenght);
+static bool_t BleApp_Notify(uint16_t hValue, uint8_t *value, uint8_t ValueLenght);
+static void BleApp_CompleteTelemetry(void);
+static void BleApp_NotifyTelemetry(void);
+static void BleApp_RecordHistory(void);
+static void BleApp_HistoryRequest(GATTServerAttributeWrittenIndication_t *pInd);
+static void BleApp_HistoryStream(void *param);
+static bool_t BleApp_ReportDue(uint8_t quantity, int32_t value);
+static void BleApp_ReportSent(uint8_t quantity, int32_t value);
+static int8_t BleApp_ReportCommand(uint8_t argc, char *argv[]);
+static bool_t BleApp_SetReportConfig(const reportConfig_t *pConfig);
 /************************************************************************************
 *************************************************************************************
 * Private memory declarations
@@ -110,6 +137,9 @@ static uint16_t hValueTempMeasurement;
 static uint16_t hValueHumidity;
 static uint16_t hValuePressure;
 static uint16_t hValueAmbientLight;
+static uint16_t hValueTelemetry;
+static uint16_t hValueReportConfig;
+static uint16_t hValueHistory;
 
 static char device_name[DEVICE_PREFIX_LENGTH + 5] = {DEVICE_NAME_PREFIX};
 
@@ -150,7 +180,9 @@ const char mpGattDbHelp[] = "\r\n"
 
 const char mpBleDemoHelp[] = "\r\n"
                              "bledemo rpk\r\n"
-                             "bledemo ota\r\n";
+                             "bledemo ota\r\n"
+                             "bledemo report\r\n"
+                             "bledemo report <temp | humidity | pressure | light> deadband minIntervalS maxIntervalS\r\n";
 
 /* Shell */
 const cmd_tbl_t mGapCmd =
@@ -188,7 +220,7 @@ const cmd_tbl_t mGattDbCmd =
 const cmd_tbl_t mBleDemoCmd =
 {
     .name = "bledemo",
-    .maxargs = 3,
+    .maxargs = 6,
     .repeatable = 1,
     .cmd = BleApp_DemoCommand,
     .usage = (char *)mpBleDemoHelp,
@@ -199,6 +231,31 @@ const cmd_tbl_t mBleDemoCmd =
 static tmrTimerID_t mRpkDemoTimerID = gTmrInvalidTimerID_c;
 static tmrTimerID_t mRpkNotifyTimerID = gTmrInvalidTimerID_c;
 
+/* Readings of the current sweep, sent at its end on the telemetry characteristic */
+static telemetryRecord_t mTelemetryRecord;
+static bool_t mTelemetryReportDue;
+
+/* Deadband reporting: settings and last notified value of each quantity */
+static reportConfig_t maReportConfig[gReportQuantityCount_c] =
+{
+    mReportTemperatureDefault_c,
+    mReportHumidityDefault_c,
+    mReportPressureDefault_c,
+    mReportAmbientLightDefault_c
+};
+static int32_t  maLastReportedValue[gReportQuantityCount_c];
+static uint32_t maLastReportTime[gReportQuantityCount_c];  /* ms */
+static uint8_t  mReportedMask;                             /* Quantities notified since connecting */
+
+/* History download in progress */
+static tmrTimerID_t mHistoryTimerID = gTmrInvalidTimerID_c;
+static uint8_t mHistoryFrameCounter;
+
+static const char * const mapReportQuantityNames[gReportQuantityCount_c] =
+{
+    "temp", "humidity", "pressure", "light"
+};
+
 extern int16_t read_accel_value(bool_t);
 
 /* Authentication Challange Received Flag */
@@ -232,6 +289,9 @@ extern GAPSetDefaultPairingParametersRequest_t gParingParametersRequest;
 /* Weather */
 extern uint8_t uuid_service_weather[];
 extern uint8_t uuid_characteristic_ambientLight[];
+extern uint8_t uuid_characteristic_telemetry[];
+extern uint8_t uuid_characteristic_reportConfig[];
+extern uint8_t uuid_characteristic_history[];
 
 extern gapSmpKeys_t gSmpKeys;
 
@@ -493,17 +553,56 @@ void BleApp_DisplayCode(uint32_t code)
 }
 
 /*
- * This function is not used in this DEMO
+ * Handles writes on the report configuration characteristic
  */
 void BleApp_DemoRpkWriteCallback(void *data)
 {
+    GATTServerAttributeWrittenIndication_t *pInd = data;
+    GATTDBWriteAttributeRequest_t req;
+    reportConfig_t config;
+    uint8_t status = gAttErrCodeNoError_c;
+
     if (data == NULL)
     {
         shell_write("Invalid write callback pointer");
         return;
     }
 
-    return;
+    if (pInd->AttributeWrittenEvent.Handle == hValueHistory)
+    {
+        BleApp_HistoryRequest(pInd);
+        return;
+    }
+
+    /* Only the report configuration and the history are registered for write notifications */
+    if (pInd->AttributeWrittenEvent.Handle != hValueReportConfig)
+    {
+        return;
+    }
+
+    if (pInd->AttributeWrittenEvent.ValueLength != sizeof(reportConfig_t))
+    {
+        status = gAttErrCodeInvalidAttributeValueLength_c;
+    }
+    else
+    {
+        FLib_MemCpy(&config, pInd->AttributeWrittenEvent.Value, sizeof(config));
+
+        if (!BleApp_SetReportConfig(&config))
+        {
+            status = mAttErrCodeOutOfRange_c;
+        }
+        else
+        {
+            /* Store the accepted setting so that it can be read back */
+            req.Handle = hValueReportConfig;
+            req.ValueLength = sizeof(config);
+            req.Value = (uint8_t *)&config;
+            GATTDBWriteAttributeRequest(&req, BLE_FSCI_IF);
+        }
+    }
+
+    ShellGattDb_SendAttributeWrittenStatusRequest(pInd->DeviceId, hValueReportConfig, status);
 }
 
 void BleApp_DemoRpkNotify(void)
@@ -517,6 +616,9 @@ void BleApp_DemoRpkNotify(void)
         mRpkNotifyTimerID = TMR_AllocateTimer();
     }
 
+    /* A new peer gets every quantity on the first sweep */
+    mReportedMask = 0;
+
     TMR_StartSingleShotTimer(mRpkNotifyTimerID, mDemoReportInterval_c, BleApp_NotifyRpkSm, NULL);
 }
 
@@ -544,9 +646,130 @@ static int8_t BleApp_DemoCommand(uint8_t argc, char *argv[])
         BleApp_DemoRpk();
         return CMD_RET_SUCCESS;
     }
+
+    if (!strcmp((char *)argv[1], "report"))
+    {
+        return BleApp_ReportCommand(argc - 2, &argv[2]);
+    }
     return CMD_RET_USAGE;
 }
 
+/*! *********************************************************************************
+* \brief    Prints or changes the reporting settings of one quantity.
+*
+********************************************************************************** */
+static int8_t BleApp_ReportCommand(uint8_t argc, char *argv[])
+{
+    reportConfig_t config;
+    uint8_t i;
+
+    if (argc == 0)
+    {
+        for (i = 0; i < gReportQuantityCount_c; i++)
+        {
+            shell_printf("\r\n%s: deadband %d, min %ds, max %ds", mapReportQuantityNames[i],
+                         maReportConfig[i].deadband, maReportConfig[i].minInterval, maReportConfig[i].maxInterval);
+        }
+        return CMD_RET_SUCCESS;
+    }
+
+    if (argc != 4)
+    {
+        return CMD_RET_USAGE;
+    }
+
+    for (i = 0; i < gReportQuantityCount_c; i++)
+    {
+        if (!strcmp(argv[0], mapReportQuantityNames[i]))
+        {
+            break;
+        }
+    }
+
+    config.quantity = i;
+    config.deadband = (uint16_t)atoi(argv[1]);
+    config.minInterval = (uint16_t)atoi(argv[2]);
+    config.maxInterval = (uint16_t)atoi(argv[3]);
+
+    if (!BleApp_SetReportConfig(&config))
+    {
+        return CMD_RET_USAGE;
+    }
+
+    return CMD_RET_SUCCESS;
+}
+
+/*! *********************************************************************************
+* \brief    Validates and applies the reporting settings of one quantity.
+*
+* \return   FALSE if the quantity is unknown or the intervals are inconsistent.
+*
+********************************************************************************** */
+static bool_t BleApp_SetReportConfig(const reportConfig_t *pConfig)
+{
+    if ((pConfig->quantity >= gReportQuantityCount_c) ||
+        (pConfig->maxInterval && (pConfig->maxInterval < pConfig->minInterval)))
+    {
+        return FALSE;
+    }
+
+    maReportConfig[pConfig->quantity] = *pConfig;
+    return TRUE;
+}
+
+/*! *********************************************************************************
+* \brief    Decides whether a reading must be notified. Nothing is due while no
+*           peer is connected.
+*
+* \param[in] quantity  RpkReportQuantity_t
+* \param[in] value     reading, in the units of the telemetry record
+*
+********************************************************************************** */
+static bool_t BleApp_ReportDue(uint8_t quantity, int32_t value)
+{
+    reportConfig_t *pConfig = &maReportConfig[quantity];
+    uint32_t now = (uint32_t)(TMR_GetTimestamp() / 1000);
+    uint32_t elapsed = now - maLastReportTime[quantity];
+    int32_t delta = value - maLastReportedValue[quantity];
+    bool_t due;
+
+    if (gRpkDemoState != gDemoConnectionEstablish_c)
+    {
+        due = FALSE;
+    }
+    else if (!(mReportedMask & (1 << quantity)))
+    {
+        due = TRUE;
+    }
+    else if (elapsed < (uint32_t)pConfig->minInterval * 1000)
+    {
+        due = FALSE;
+    }
+    else
+    {
+        due = ((uint32_t)((delta < 0) ? -delta : delta) >= pConfig->deadband) ||
+              (pConfig->maxInterval && (elapsed >= (uint32_t)pConfig->maxInterval * 1000));
+    }
+
+    return due;
+}
+
+/*! *********************************************************************************
+* \brief    Records a notified reading as the reference of its quantity's
+*           deadband, and marks the telemetry record of the sweep as due.
+*
+* \param[in] quantity  RpkReportQuantity_t
+* \param[in] value     reading, in the units of the telemetry record
+*
+********************************************************************************** */
+static void BleApp_ReportSent(uint8_t quantity, int32_t value)
+{
+    maLastReportedValue[quantity] = value;
+    maLastReportTime[quantity] = (uint32_t)(TMR_GetTimestamp() / 1000);
+    mReportedMask |= (1 << quantity);
+    mTelemetryReportDue = TRUE;
+}
+
 /*! *********************************************************************************
 * \brief    Convert data from sensors to an acceptable format for mobile app.
 *
@@ -569,7 +792,8 @@ static void BleDecodeValue(uint8_t* buffer, uint8_t buffer_len)
 
 static void BleApp_NotifyRpkSm(void *param)
 {
-    if (ota_demo || (gRpkDemoState != gDemoConnectionEstablish_c))
+    /* Sampling goes on between connections so that the history has no gaps */
+    if (ota_demo || (gRpkDemoState < gDemoSetAdvParam_c) || (gRpkDemoState == gDemoError_c))
         return;
 
     uint8_t TemperatureValue[5]   = {0x00};
@@ -594,20 +818,33 @@ static void BleApp_NotifyRpkSm(void *param)
 
         		float raw_temp;
         		char buff[25] = {0};
+        		char value[FTOA_MAX_STR_LEN];
         		FLib_MemCpy(&raw_temp, &TemperatureValue[1], TempSize);
-        		sprintf(buff,"Temp : %.2f C  ", raw_temp);
+        		(void)SensorConditioning_ProcessSample(kConditioningTemperature, raw_temp, &raw_temp);
+        		FLib_MemCpy(&TemperatureValue[1], &raw_temp, TempSize);
+        		Ftoa_FormatFloat(value, raw_temp, 2);
+        		sprintf(buff,"Temp : %s C  ", value);
         		GUI_DispStringAt(buff, 20,48);
 
-        		/* Expected 5 bytes: (flag | data0 | data1| data2 | number of decimals);
-				 * Ex: 0|1234|-2 => Celsius | 12,34 | 2 decimals */
-        		BleDecodeValue(TemperatureValue + 1, TempSizeBle - 1);
-        		/* Set 2 decimals */
-        		TemperatureValue[4] = 0xFE;
-
-                BleApp_Notify(hValueTempMeasurement, TemperatureValue, TempSizeBle);
+        		mTelemetryRecord.temperature = (int16_t)lroundf(raw_temp * 100);
+        		mTelemetryRecord.flags |= gTelemetryTemperatureValid_c;
+
+        		if (BleApp_ReportDue(gReportTemperature_c, mTelemetryRecord.temperature))
+        		{
+        			/* Expected 5 bytes: (flag | data0 | data1| data2 | number of decimals);
+        			 * Ex: 0|1234|-2 => Celsius | 12,34 | 2 decimals */
+        			BleDecodeValue(TemperatureValue + 1, TempSizeBle - 1);
+        			/* Set 2 decimals */
+        			TemperatureValue[4] = 0xFE;
+
+        			if (BleApp_Notify(hValueTempMeasurement, TemperatureValue, TempSizeBle))
+        			{
+        				BleApp_ReportSent(gReportTemperature_c, mTelemetryRecord.temperature);
+        			}
+        		}
             }
             else
-                shell_write("\r\n-->  Notify Event: Can not read Temperature value. ");
+                DLOG_PRINTF("\r\n-->  Notify Event: Can not read Temperature value. ");
 
             gRpkNotifyState = gNotifyHumidity_c;
             break;
@@ -617,17 +854,30 @@ static void BleApp_NotifyRpkSm(void *param)
             {
         		float raw_hum;
         		char buff[25] = {0};
+        		char value[FTOA_MAX_STR_LEN];
         		FLib_MemCpy(&raw_hum, &HumidityValue[0], HumiditySize);
-        		sprintf(buff,"Humidity : %.2f %%  ", raw_hum);
+        		(void)SensorConditioning_ProcessSample(kConditioningHumidity, raw_hum, &raw_hum);
+        		FLib_MemCpy(&HumidityValue[0], &raw_hum, HumiditySize);
+        		Ftoa_FormatFloat(value, raw_hum, 2);
+        		sprintf(buff,"Humidity : %s %%  ", value);
         		GUI_DispStringAt(buff, 20,78);
 
-        		/* Expected 2 bytes: (data0 | data1);
-				 * Ex: 1234 => 12,34% */
-        		BleDecodeValue(HumidityValue, HumiditySizeBle);
-                BleApp_Notify(hValueHumidity, HumidityValue, HumiditySizeBle);
+        		mTelemetryRecord.humidity = (uint16_t)lroundf(raw_hum * 100);
+        		mTelemetryRecord.flags |= gTelemetryHumidityValid_c;
+
+        		if (BleApp_ReportDue(gReportHumidity_c, mTelemetryRecord.humidity))
+        		{
+        			/* Expected 2 bytes: (data0 | data1);
+        			 * Ex: 1234 => 12,34% */
+        			BleDecodeValue(HumidityValue, HumiditySizeBle);
+        			if (BleApp_Notify(hValueHumidity, HumidityValue, HumiditySizeBle))
+        			{
+        				BleApp_ReportSent(gReportHumidity_c, mTelemetryRecord.humidity);
+        			}
+        		}
             }
             else
-                shell_write("\r\n-->  Notify Event: Can not read Humidity value. ");
+                DLOG_PRINTF("\r\n-->  Notify Event: Can not read Humidity value. ");
 
             gRpkNotifyState = gNotifyPressure_c;
             break;
@@ -636,15 +886,29 @@ static void BleApp_NotifyRpkSm(void *param)
 			if (get_pressure(PressureValue, &PressureSize) == 0) {
 
 				uint32_t raw_pressure;
+				float pressure;
 				char buff[30] = {0};
 				FLib_MemCpy(&raw_pressure, &PressureValue[0], PressureSize);
+				pressure = (float)raw_pressure;
+				(void)SensorConditioning_ProcessSample(kConditioningPressure, pressure, &pressure);
+				raw_pressure = (uint32_t)(pressure + 0.5f);
+				FLib_MemCpy(&PressureValue[0], &raw_pressure, PressureSize);
 				sprintf(buff,"Pressure : %d hPa  ", raw_pressure);
 				GUI_DispStringAt(buff, 20, 108);
 
-				BleApp_Notify(hValuePressure, PressureValue, PressureSize);
+				mTelemetryRecord.pressure = (uint16_t)raw_pressure;
+				mTelemetryRecord.flags |= gTelemetryPressureValid_c;
+
+				if (BleApp_ReportDue(gReportPressure_c, mTelemetryRecord.pressure))
+				{
+					if (BleApp_Notify(hValuePressure, PressureValue, PressureSize))
+					{
+						BleApp_ReportSent(gReportPressure_c, mTelemetryRecord.pressure);
+					}
+				}
 			}
 			else {
-				shell_write("\r\n-->  Notify Event: Can not read Pressure value. ");
+				DLOG_PRINTF("\r\n-->  Notify Event: Can not read Pressure value. ");
 			}
 			gRpkNotifyState = gNotifyAmbientLight_c;
 			break;
@@ -654,14 +918,38 @@ static void BleApp_NotifyRpkSm(void *param)
 
 				float raw_light;
 				char buff[25] = {0};
+				char value[FTOA_MAX_STR_LEN];
 				FLib_MemCpy(&raw_light, &AmbientLightValue[0], AmbientLightSize);
-				sprintf(buff,"Light : %.2f lux  ", raw_light);
+				(void)SensorConditioning_ProcessSample(kConditioningAmbientLight, raw_light, &raw_light);
+				FLib_MemCpy(&AmbientLightValue[0], &raw_light, AmbientLightSize);
+				Ftoa_FormatFloat(value, raw_light, 2);
+				sprintf(buff,"Light : %s lux  ", value);
 				GUI_DispStringAt(buff, 20, 138);
 
-				BleApp_Notify(hValueAmbientLight, AmbientLightValue, AmbientLightSize);
+				mTelemetryRecord.ambientLight = (uint32_t)lroundf(raw_light * 100);
+				mTelemetryRecord.flags |= gTelemetryAmbientLightValid_c;
+
+				if (BleApp_ReportDue(gReportAmbientLight_c, (int32_t)mTelemetryRecord.ambientLight))
+				{
+					if (BleApp_Notify(hValueAmbientLight, AmbientLightValue, AmbientLightSize))
+					{
+						BleApp_ReportSent(gReportAmbientLight_c, (int32_t)mTelemetryRecord.ambientLight);
+					}
+				}
 			}
 			else
-				shell_write("\r\n-->  Notify Event: Can not read Ambient Light value. ");
+				DLOG_PRINTF("\r\n-->  Notify Event: Can not read Ambient Light value. ");
+
+			/* End of the sweep: record it, then send it if any quantity was reported */
+			BleApp_CompleteTelemetry();
+			BleApp_RecordHistory();
+			AirBaseline_Checkpoint(mTelemetryRecord.timestamp);
+
+			if (mTelemetryReportDue)
+			{
+				BleApp_NotifyTelemetry();
+			}
+			mTelemetryRecord.flags = 0;
 
 			gRpkNotifyState = gNotifyTemperature_c;
 			break;
@@ -676,11 +964,11 @@ static void BleApp_NotifyRpkSm(void *param)
    TMR_StartSingleShotTimer(mRpkNotifyTimerID, mDemoReportInterval_c * 1000, BleApp_NotifyRpkSm, NULL);
 }
 
-static void BleApp_Notify(uint16_t hValue, uint8_t *value, uint8_t ValueLenght)
+static bool_t BleApp_Notify(uint16_t hValue, uint8_t *value, uint8_t ValueLenght)
 {
     if (gRpkDemoState != gDemoConnectionEstablish_c)
     {
-        return;
+        return FALSE;
     }
     GATTDBWriteAttributeRequest_t req;
 
@@ -689,7 +977,7 @@ static void BleApp_Notify(uint16_t hValue, uint8_t *value, uint8_t ValueLenght)
     if (!argv)
     {
         shell_write("\r\n-->  Notify Event: Insufficient memory. ");
-        return;
+        return FALSE;
     }
 
     argv[0] = MEM_BufferAlloc(3);
@@ -697,7 +985,8 @@ static void BleApp_Notify(uint16_t hValue, uint8_t *value, uint8_t ValueLenght)
     if (!argv[0])
     {
         shell_write("\r\n-->  Notify Event: Insufficient memory. ");
-        return;
+        MEM_BufferFree(argv);
+        return FALSE;
     }
 
     req.Handle = hValue;
@@ -711,6 +1000,148 @@ static void BleApp_Notify(uint16_t hValue, uint8_t *value, uint8_t ValueLenght)
 
     MEM_BufferFree(argv[0]);
     MEM_BufferFree(argv);
+
+    return TRUE;
+}
+
+/*! *********************************************************************************
+* \brief    Completes the record of the current sweep with the slow changing values
+*           (CO2, battery).
+*
+********************************************************************************** */
+static void BleApp_CompleteTelemetry(void)
+{
+    uint16_t co2;
+    uint8_t co2Size = sizeof(co2);
+    uint8_t batteryLevel;
+    uint8_t chargingState;
+
+    if (get_air_quality((uint8_t *)&co2, &co2Size) == 0)
+    {
+        mTelemetryRecord.co2 = co2;
+        mTelemetryRecord.flags |= gTelemetryCo2Valid_c;
+    }
+
+    if (BatterySensor_GetState(&batteryLevel, &chargingState) == battery_status_success)
+    {
+        mTelemetryRecord.battery = batteryLevel;
+        mTelemetryRecord.flags |= gTelemetryBatteryValid_c;
+
+        if (chargingState)
+        {
+            mTelemetryRecord.flags |= gTelemetryCharging_c;
+        }
+    }
+
+    mTelemetryRecord.version = gTelemetryRecordVersion_c;
+    mTelemetryRecord.timestamp = (uint32_t)(TMR_GetTimestamp() / 1000);
+}
+
+/*! *********************************************************************************
+* \brief    Notifies the record of the current sweep in a single write on the
+*           telemetry characteristic.
+*
+********************************************************************************** */
+static void BleApp_NotifyTelemetry(void)
+{
+    if (BleApp_Notify(hValueTelemetry, (uint8_t *)&mTelemetryRecord, sizeof(mTelemetryRecord)))
+    {
+        mTelemetryRecord.sequence++;
+    }
+    mTelemetryReportDue = FALSE;
+}
+
+/*! *********************************************************************************
+* \brief    Stores the record of the current sweep in the sample history. The
+*           quantities are in telemetry flag order and units.
+*
+********************************************************************************** */
+static void BleApp_RecordHistory(void)
+{
+    int32_t values[gHistoryQuantities_c];
+
+    values[0] = mTelemetryRecord.temperature;
+    values[1] = mTelemetryRecord.humidity;
+    values[2] = mTelemetryRecord.pressure;
+    values[3] = (int32_t)mTelemetryRecord.ambientLight;
+    values[4] = mTelemetryRecord.co2;
+    values[5] = mTelemetryRecord.battery;
+
+    SensorHistory_AddSample(mTelemetryRecord.timestamp,
+                            mTelemetryRecord.flags & ((1 << gHistoryQuantities_c) - 1), values);
+}
+
+/*! *********************************************************************************
+* \brief    Starts the history download requested by a write on the history
+*           characteristic.
+*
+********************************************************************************** */
+static void BleApp_HistoryRequest(GATTServerAttributeWrittenIndication_t *pInd)
+{
+    historyRequest_t request;
+    uint8_t status = gAttErrCodeNoError_c;
+
+    if (pInd->AttributeWrittenEvent.ValueLength != sizeof(historyRequest_t))
+    {
+        status = gAttErrCodeInvalidAttributeValueLength_c;
+    }
+    else
+    {
+        FLib_MemCpy(&request, pInd->AttributeWrittenEvent.Value, sizeof(request));
+
+        /* The samples are stamped with the time since boot: the client's clock
+         * gives the UNIX time of the boot */
+        if (request.now)
+        {
+            SensorHistory_SetEpoch(request.now - (uint32_t)(TMR_GetTimestamp() / 1000000));
+        }
+
+        if (!SensorHistory_StartDownload(request.level, request.fromTime))
+        {
+            status = mAttErrCodeOutOfRange_c;
+        }
+    }
+
+    ShellGattDb_SendAttributeWrittenStatusRequest(pInd->DeviceId, hValueHistory, status);
+
+    if (status == gAttErrCodeNoError_c)
+    {
+        if (mHistoryTimerID == gTmrInvalidTimerID_c)
+        {
+            mHistoryTimerID = TMR_AllocateTimer();
+        }
+
+        mHistoryFrameCounter = 0;
+        TMR_StartSingleShotTimer(mHistoryTimerID, mHistoryFrameInterval_c, BleApp_HistoryStream, NULL);
+    }
+}
+
+/*! *********************************************************************************
+* \brief    Notifies the next frame of the history download. The frames are paced
+*           by a timer so that the sensor sweep and the other notifications
+*           keep going during long downloads.
+*
+********************************************************************************** */
+static void BleApp_HistoryStream(void *param)
+{
+    uint8_t frame[mHistoryFrameSize_c];
+    uint16_t len;
+
+    /* The download is abandoned with the connection */
+    if (gRpkDemoState != gDemoConnectionEstablish_c)
+    {
+        return;
+    }
+
+    frame[0] = mHistoryFrameCounter++;
+    len = SensorHistory_ReadDownload(&frame[1], sizeof(frame) - 1);
+
+    BleApp_Notify(hValueHistory, frame, (uint8_t)(len + 1));
+
+    if (len)
+    {
+        TMR_StartSingleShotTimer(mHistoryTimerID, mHistoryFrameInterval_c, BleApp_HistoryStream, NULL);
+    }
 }
 
 static void BleApp_StartRpkDemoSm(void *param)
@@ -723,6 +1154,19 @@ static void BleApp_StartRpkDemoSm(void *param)
             ShellGattDb_AddServiceGatt();
             ShellGattDb_AddServiceWeather();
 
+            /* Keep the sample history in the external flash, or in RAM if it is not usable */
+            if (img_program_ext_init() == IMG_EXT_NO_ERROR)
+            {
+                if (!SensorHistory_Init(&gHistorySpiFlashStorage))
+                {
+                    (void)SensorHistory_Init(&gHistoryRamStorage);
+                }
+            }
+            else
+            {
+                (void)SensorHistory_Init(&gHistoryRamStorage);
+            }
+
             gRpkDemoState = gDemoSetAdvData_c;
             break;
         }
@@ -897,7 +1341,7 @@ static void BleApp_StartRpkDemoSm(void *param)
 				gLatestHandle = INVALID_HANDLE;
 				GATTDBFindCharValueHandleInServiceRequest(&req, BLE_FSCI_IF);
 
-				gRpkDemoState = gDemoWriteTempAttribute_c;
+				gRpkDemoState = gDemoFindTelemetryHandle_c;
 			}
 			else
 			{
@@ -908,6 +1352,87 @@ static void BleApp_StartRpkDemoSm(void *param)
 			break;
 		}
 
+        case gDemoFindTelemetryHandle_c:
+		{
+			if (gLatestHandle != INVALID_HANDLE)
+			{
+				GATTDBFindCharValueHandleInServiceRequest_t req;
+
+				// save previous handle requested
+				hValueAmbientLight = gLatestHandle;
+
+				req.ServiceHandle = hServiceWeather;
+				req.UuidType = Uuid128Bits;
+				memcpy(req.Uuid.Uuid128Bits, uuid_characteristic_telemetry, 16);
+
+				gLatestHandle = INVALID_HANDLE;
+				GATTDBFindCharValueHandleInServiceRequest(&req, BLE_FSCI_IF);
+
+				gRpkDemoState = gDemoFindReportConfigHandle_c;
+			}
+			else
+			{
+				shell_write("\r\n-->  GATT DB: Could not find characteristic handle for Ambient Light.");
+				gRpkDemoState = gDemoError_c;
+			}
+
+			break;
+		}
+
+        case gDemoFindReportConfigHandle_c:
+		{
+			if (gLatestHandle != INVALID_HANDLE)
+			{
+				GATTDBFindCharValueHandleInServiceRequest_t req;
+
+				// save previous handle requested
+				hValueTelemetry = gLatestHandle;
+
+				req.ServiceHandle = hServiceWeather;
+				req.UuidType = Uuid128Bits;
+				memcpy(req.Uuid.Uuid128Bits, uuid_characteristic_reportConfig, 16);
+
+				gLatestHandle = INVALID_HANDLE;
+				GATTDBFindCharValueHandleInServiceRequest(&req, BLE_FSCI_IF);
+
+				gRpkDemoState = gDemoFindHistoryHandle_c;
+			}
+			else
+			{
+				shell_write("\r\n-->  GATT DB: Could not find characteristic handle for Telemetry.");
+				gRpkDemoState = gDemoError_c;
+			}
+
+			break;
+		}
+
+        case gDemoFindHistoryHandle_c:
+		{
+			if (gLatestHandle != INVALID_HANDLE)
+			{
+				GATTDBFindCharValueHandleInServiceRequest_t req;
+
+				// save previous handle requested
+				hValueReportConfig = gLatestHandle;
+
+				req.ServiceHandle = hServiceWeather;
+				req.UuidType = Uuid128Bits;
+				memcpy(req.Uuid.Uuid128Bits, uuid_characteristic_history, 16);
+
+				gLatestHandle = INVALID_HANDLE;
+				GATTDBFindCharValueHandleInServiceRequest(&req, BLE_FSCI_IF);
+
+				gRpkDemoState = gDemoWriteTempAttribute_c;
+			}
+			else
+			{
+				shell_write("\r\n-->  GATT DB: Could not find characteristic handle for Report Configuration.");
+				gRpkDemoState = gDemoError_c;
+			}
+
+			break;
+		}
+
 
         case gDemoWriteTempAttribute_c:
         {
@@ -915,9 +1440,16 @@ static void BleApp_StartRpkDemoSm(void *param)
             {
                 GATTDBWriteAttributeRequest_t req;
                 uint8_t value[5] = {0x00, 0x41, 0xd0, 0x00, 0x00};
+                uint16_t writeHandles[2];
 
                 // save previous handle requested
-                hValueAmbientLight = gLatestHandle;
+                hValueHistory = gLatestHandle;
+
+                // Writes to the report configuration and history are handled by BleApp_DemoRpkWriteCallback.
+                // The FSCI serializer copies HandleCount bytes of the handle array.
+                writeHandles[0] = hValueReportConfig;
+                writeHandles[1] = hValueHistory;
+                ShellGattDb_RegisterForWriteNotifications(sizeof(writeHandles), (uint8_t *)writeHandles);
 
                 req.Handle = hValueTempMeasurement;
                 req.ValueLength = 5;
@@ -928,7 +1460,7 @@ static void BleApp_StartRpkDemoSm(void *param)
             }
             else
             {
-                shell_write("\r\n-->  GATT DB: Could not find characteristic handle for Ambient Light.");
+                shell_write("\r\n-->  GATT DB: Could not find characteristic handle for History.");
                 gRpkDemoState = gDemoError_c;
             }
 
@@ -1013,6 +1545,9 @@ static void BleApp_StartRpkDemoSm(void *param)
             shell_write("\r\n-->  Waiting connection from a smartphone..");
             gRpkDemoState = gDemoWaitingConnection_c;
 
+            /* Start sampling, the sweep also feeds the history while advertising */
+            BleApp_DemoRpkNotify();
+
 //#define gPasskeyValue_c                999999
 #ifdef gPasskeyValue_c
             GAPSetLocalPasskeyRequest_t req_pass = {gPasskeyValue_c};
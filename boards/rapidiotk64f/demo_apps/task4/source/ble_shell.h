@@ -73,6 +73,9 @@ enum RpkDemoState_t
     gDemoFindPressureHandle_c,
     gDemoFindAirQualityHandle_c,
     gDemoFindAmbientLightHandle_c,
+    gDemoFindTelemetryHandle_c,
+    gDemoFindReportConfigHandle_c,
+    gDemoFindHistoryHandle_c,
     gDemoWriteTempAttribute_c,
     gDemoWriteHumidityParam_c,
     gDemoWritePressureParam_c,
@@ -118,6 +121,68 @@ enum RpkNotifyState_t
 	gNotifyAmbientLight_c
 };
 
+/*! Layout version, first byte of every telemetry record */
+#define gTelemetryRecordVersion_c       1
+
+/*! telemetryRecord_t flags: which fields hold a reading from this sweep */
+#define gTelemetryTemperatureValid_c    (1 << 0)
+#define gTelemetryHumidityValid_c       (1 << 1)
+#define gTelemetryPressureValid_c       (1 << 2)
+#define gTelemetryAmbientLightValid_c   (1 << 3)
+#define gTelemetryCo2Valid_c            (1 << 4)
+#define gTelemetryBatteryValid_c        (1 << 5)
+#define gTelemetryCharging_c            (1 << 7)
+
+/*! Aggregated weather record, notified once per sweep on the telemetry
+ *  characteristic. Little endian, 20 bytes: fits a notification at the
+ *  default ATT MTU, so it never depends on the MTU exchange. */
+typedef PACKED_STRUCT telemetryRecord_tag
+{
+    uint8_t  version;           /* gTelemetryRecordVersion_c */
+    uint8_t  flags;             /* gTelemetryXxxValid_c, gTelemetryCharging_c */
+    uint8_t  sequence;          /* Incremented for every record */
+    uint32_t timestamp;         /* ms since boot */
+    int16_t  temperature;       /* 0.01 C */
+    uint16_t humidity;          /* 0.01 % */
+    uint16_t pressure;          /* hPa */
+    uint32_t ambientLight;      /* 0.01 lux */
+    uint16_t co2;               /* ppm */
+    uint8_t  battery;           /* % */
+} telemetryRecord_t;
+
+/*! Quantities with their own reporting settings */
+enum RpkReportQuantity_t
+{
+    gReportTemperature_c,
+    gReportHumidity_c,
+    gReportPressure_c,
+    gReportAmbientLight_c,
+    gReportQuantityCount_c
+};
+
+/*! Reporting settings of one quantity, also the value written on the report
+ *  configuration characteristic (one quantity per write). A reading is
+ *  notified when it moves by at least deadband from the last notified value,
+ *  or when maxInterval expires, but never sooner than minInterval. */
+typedef PACKED_STRUCT reportConfig_tag
+{
+    uint8_t  quantity;          /* RpkReportQuantity_t */
+    uint16_t deadband;          /* Units of the telemetryRecord_t field, 0 reports every reading */
+    uint16_t minInterval;       /* s */
+    uint16_t maxInterval;       /* s, heartbeat, 0 disables it */
+} reportConfig_t;
+
+/*! Value written on the history characteristic to start a download. The data
+ *  is then notified on the same characteristic in frames of one counter byte
+ *  followed by up to 19 bytes of the SensorHistory download stream; a frame
+ *  with only the counter ends it. */
+typedef PACKED_STRUCT historyRequest_tag
+{
+    uint8_t  level;             /* historyLevel_t */
+    uint32_t fromTime;          /* s, UNIX time, 0 downloads everything */
+    uint32_t now;               /* s, UNIX time of the client, timestamps the history; 0 if unknown */
+} historyRequest_t;
+
 /************************************************************************************
 *************************************************************************************
 * Public prototypes
@@ -118,6 +118,9 @@ static uint8_t mGattDbDynamic_TermpratureMeasurementInitValue[]               =
 static uint8_t mGattDbDynamic_HumidityInitValue[]                             = {0x00, 0x00};
 static uint8_t mGattDbDynamic_PressureInitValue[]                             = {0x00, 0x00, 0x00, 0x00};
 static uint8_t mGattDbDynamic_AmbientLightInitValue[]                         = {0x00, 0x00, 0x00, 0x00};
+static uint8_t mGattDbDynamic_TelemetryInitValue[sizeof(telemetryRecord_t)]   = {gTelemetryRecordVersion_c};
+static uint8_t mGattDbDynamic_ReportConfigInitValue[sizeof(reportConfig_t)]  = {0x00};
+static uint8_t mGattDbDynamic_HistoryInitValue[20]                            = {0x00};
 static uint8_t mGattDbDynamic_MacAddressPublicInitValue[]                         = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
 /************************************************************************************
@@ -128,6 +131,9 @@ static uint8_t mGattDbDynamic_MacAddressPublicInitValue[]
 /*! Weather Service UUID */
 const uint8_t uuid_service_weather[16]             = {0x88,0xc8,0x65,0xaa,0xcb,0x6c,0x11,0xe7,0xab,0xc4,0xce,0xc2,0x70,0xb6,0xb5,0x0a};
 const uint8_t uuid_characteristic_ambientLight[16] = {0x88,0xc8,0x65,0xaa,0xcb,0x6c,0x11,0xe7,0xab,0xc4,0xce,0xc2,0x72,0xb6,0xb5,0x0a};
+const uint8_t uuid_characteristic_telemetry[16]    = {0x88,0xc8,0x65,0xaa,0xcb,0x6c,0x11,0xe7,0xab,0xc4,0xce,0xc2,0x74,0xb6,0xb5,0x0a};
+const uint8_t uuid_characteristic_reportConfig[16] = {0x88,0xc8,0x65,0xaa,0xcb,0x6c,0x11,0xe7,0xab,0xc4,0xce,0xc2,0x75,0xb6,0xb5,0x0a};
+const uint8_t uuid_characteristic_history[16]      = {0x88,0xc8,0x65,0xaa,0xcb,0x6c,0x11,0xe7,0xab,0xc4,0xce,0xc2,0x76,0xb6,0xb5,0x0a};
 const uint8_t uuid_characteristic_macAddressPublic[16] = {0xb7,0x1c,0xec,0x12,0xf7,0x88,0x49,0x0e,0xa9,0xac,0x2e,0x61,0x26,0xb8,0x1b,0x0e};
 
 extern char gDeviceName[];
@@ -255,6 +261,39 @@ void ShellGattDb_AddServiceWeather(void)
 	);
 	GATTDBDynamicAddCccdRequest(BLE_FSCI_IF);
 
+	// Aggregated telemetry characteristic (telemetryRecord_t)
+	ShellGattDb_AddCharDeclValue128(
+			(uint8_t *)uuid_characteristic_telemetry,
+		   gNotify_c | gRead_c,
+		   sizeof(mGattDbDynamic_TelemetryInitValue),
+		   mGattDbDynamic_TelemetryInitValue,
+		   GATTDBDynamicAddCharacteristicDeclarationAndValueRequest_ValueAccessPermissions_gPermissionFlagReadable_c,
+		   FALSE
+	);
+	GATTDBDynamicAddCccdRequest(BLE_FSCI_IF);
+
+	// Report (deadband) configuration characteristic (reportConfig_t)
+	ShellGattDb_AddCharDeclValue128(
+			(uint8_t *)uuid_characteristic_reportConfig,
+		   gWrite_c | gRead_c,
+		   sizeof(mGattDbDynamic_ReportConfigInitValue),
+		   mGattDbDynamic_ReportConfigInitValue,
+		   GATTDBDynamicAddCharacteristicDeclarationAndValueRequest_ValueAccessPermissions_gPermissionFlagWritable_c |
+		   GATTDBDynamicAddCharacteristicDeclarationAndValueRequest_ValueAccessPermissions_gPermissionFlagReadable_c,
+		   FALSE
+	);
+
+	// Sample history download characteristic (historyRequest_t written, frames notified)
+	ShellGattDb_AddCharDeclValue128(
+			(uint8_t *)uuid_characteristic_history,
+		   gWrite_c | gNotify_c,
+		   sizeof(mGattDbDynamic_HistoryInitValue),
+		   mGattDbDynamic_HistoryInitValue,
+		   GATTDBDynamicAddCharacteristicDeclarationAndValueRequest_ValueAccessPermissions_gPermissionFlagWritable_c,
+		   TRUE
+	);
+	GATTDBDynamicAddCccdRequest(BLE_FSCI_IF);
+
 	extern uint8_t macAddressPublic[6];
 
 	// @MAC ADRESS characteristic
@@ -302,6 +341,21 @@ int8_t ShellGattDb_Write(uint8_t argc, char *argv[])
     return CMD_RET_SUCCESS;
 }
 
+void ShellGattDb_RegisterForWriteNotifications(uint8_t count, uint8_t* handles)
+{
+    GATTServerRegisterHandlesForWriteNotificationsRequest_t req;
+
+    if (count == 0)
+    {
+        shell_printf("Write register notify: No handlers!");
+        return;
+    }
+    req.HandleCount = count;
+    req.AttributeHandles = handles;
+
+    GATTServerRegisterHandlesForWriteNotificationsRequest(&req, BLE_FSCI_IF);
+}
+
 void ShellGattDb_SendAttributeWrittenStatusRequest(uint8_t DeviceId, uint16_t AttributeHandle, uint8_t Status)
 {
     GATTServerSendAttributeWrittenStatusRequest_t req;
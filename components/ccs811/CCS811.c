@@ -247,6 +247,26 @@ CCS811_status CCS811_readAlgorithmResults(void)
     return CCS811_SUCCESS;
 }
 
+CCS811_status CCS811_readAlgorithmResultBlock(CCS811_result_t* result)
+{
+    if (!initHwDone) return CCS811_NOINIT_ERROR;
+    assert(result != NULL);
+
+    uint8_t data[8];
+    if (CCS811_multiReadRegister(CCS811_ALG_RESULT_DATA, data, 8)!=0) return CCS811_I2C_ERROR;
+
+    /* data ordered: co2MSB, co2LSB, tvocMSB, tvocLSB, status, error id, raw data MSB, raw data LSB */
+    CO2 = ((uint16_t)data[0] << 8) | data[1];
+    tVOC = ((uint16_t)data[2] << 8) | data[3];
+
+    result->eCO2 = CO2;
+    result->TVOC = tVOC;
+    result->status = data[4];
+    result->errorId = data[5];
+    result->rawData = ((uint16_t)data[6] << 8) | data[7];
+    return CCS811_SUCCESS;
+}
+
 CCS811_status CCS811_checkForStatusError(uint8_t* StatusError)
 {
     if (!initHwDone) return CCS811_NOINIT_ERROR;
@@ -132,6 +132,16 @@ typedef struct _CCS811_fct_t
     void (*WaitMsec)(uint32_t tms); /*!< Wait function in milliseconds */
 } CCS811_fct_t, *ptCCS811_fct_t;
 
+/*! @brief Content of the ALG_RESULT_DATA register block. */
+typedef struct _CCS811_result_t
+{
+    uint16_t eCO2;      /*!< Equivalent CO2 (ppm) */
+    uint16_t TVOC;      /*!< Total volatile organic compounds (ppb) */
+    uint8_t status;     /*!< STATUS register */
+    uint8_t errorId;    /*!< ERROR_ID register, valid if the ERROR bit of status is set */
+    uint16_t rawData;   /*!< RAW_DATA register (current and ADC reading) */
+} CCS811_result_t;
+
 /*!
  * @brief Initialize CCS811 driver.
  *
@@ -160,6 +170,16 @@ CCS811_status CCS811_Init_Hw(void);
  */
 CCS811_status CCS811_readAlgorithmResults(void);
 
+/*!
+ * @brief Read the whole algorithm result block in one transfer.
+ * @note Reading the block releases the nINT signal in interrupt mode. The TVOC and CO2
+ * values returned by #CCS811_getTVOC and #CCS811_getCO2 are updated too.
+ *
+ * @param  result Pointer to the result block
+ * @return Status value (0 for success)
+ */
+CCS811_status CCS811_readAlgorithmResultBlock(CCS811_result_t* result);
+
 /*!
  * @brief Check if error bit is set.
  *
@@ -99,6 +99,8 @@
 
 #define INT_EN_FIFO_SHIFT   (6)
 #define INT_CFG_FIFO_SHIFT  (6)
+#define INT_EN_DRDY_SHIFT   (7)
+#define INT_CFG_DRDY_SHIFT  (7)
 
 // MASKS
 #define MPL_OS_MASK         (0x7 << MPL_OS_SHIFT)
@@ -515,6 +517,71 @@ mpl_status_t MPL_GetFifoStatus(uint8_t* fifoStatus)
     return MPL_SUCCESS;
 }
 
+mpl_status_t MPL_SetDataReadyInterrupt (pinINT_t pinINT)
+{
+    uint8_t wBuf[2] = {MPL_CTRL_REG4};
+    uint8_t rBuf;
+
+    if (!initHwDone) return MPL_INIT_ERROR;
+
+    // the interrupt control registers can only be modified in stand-by mode
+    if (MPL_GotoStandby()!=MPL_SUCCESS) return MPL_ERROR;
+
+    // read CTRL4 register & set INT_EN_DRDY
+    if (sIoFunc.I2C_Read(MPL3115_I2C_SLAVE_ADDRESS, wBuf, 1, &rBuf, 1)!=MPL_SUCCESS) return MPL_ERROR;
+    wBuf[1] = rBuf | (1 << INT_EN_DRDY_SHIFT);
+
+    if (sIoFunc.I2C_Write(MPL3115_I2C_SLAVE_ADDRESS, wBuf, 2)!=MPL_SUCCESS) return MPL_ERROR;
+
+    // read CTRL5 register & Route interrupt to either INT1 or INT2 pin
+    wBuf[0] = MPL_CTRL_REG5;
+    if (sIoFunc.I2C_Read(MPL3115_I2C_SLAVE_ADDRESS, wBuf, 1, &rBuf, 1)!=MPL_SUCCESS) return MPL_ERROR;
+
+    wBuf[1] = (pinINT == FIFO_INT1) ? rBuf | (1 << INT_CFG_DRDY_SHIFT) : rBuf &~(1 << INT_CFG_DRDY_SHIFT);
+    if (sIoFunc.I2C_Write(MPL3115_I2C_SLAVE_ADDRESS, wBuf, 2)!=MPL_SUCCESS) return MPL_ERROR;
+
+    // goto active state, the auto acquisition restarts
+    if (MPL_SetActive()!=MPL_SUCCESS) return MPL_ERROR;
+
+    return MPL_SUCCESS;
+}
+
+mpl_status_t MPL_ReadReadyData (int32_t* sensorData, bool* dataReady)
+{
+    uint8_t wBuf[1] = {REG_STATUS};
+    uint8_t rBuf[6];
+
+    if (!initHwDone) return MPL_INIT_ERROR;
+    assert((sensorData != NULL) && (dataReady != NULL));
+
+    // STATUS, OUT_P and OUT_T in one burst; reading the outputs releases the data ready interrupt
+    if (sIoFunc.I2C_Read(MPL3115_I2C_SLAVE_ADDRESS, wBuf, 1, rBuf, sizeof(rBuf))!=MPL_SUCCESS) return MPL_ERROR;
+
+    switch ( selectedMode )
+    {
+    // pressure value is a Q18.2 right-aligned number in [Pa]
+    case MPL_MODE_PRESSURE:
+        // altitude value is a Q16.4 right-aligned number in [m]
+    case MPL_MODE_ALTITUDE:     {
+        *dataReady = (0 != (rBuf[0] & (1 << MPL_PDR_SHIFT)));
+        if (*dataReady) *sensorData = (int32_t) ((rBuf[1] << 16) | (rBuf[2] << 8) | rBuf[3]) >> 4;
+        break;
+    }
+
+    // temperature value is a Q8.4 right-aligned number in [C]
+    case MPL_MODE_TEMPERATURE:  {
+        *dataReady = (0 != (rBuf[0] & (1 << MPL_TDR_SHIFT)));
+        if (*dataReady) *sensorData = (int32_t) (((rBuf[4] << 8) | rBuf[5]) >> 4);
+        break;
+    }
+    default:  {
+        *dataReady = false;
+    }
+    }
+
+    return MPL_SUCCESS;
+}
+
 mpl_status_t MPL_ReadRawData (modeMPL_t mode, int32_t* sensorData)
 {
     uint8_t wBuf[2] = {REG_STATUS};
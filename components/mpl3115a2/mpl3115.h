@@ -149,7 +149,7 @@ typedef enum {
     FIFO_STOP_OVERFLOW    /*!< FIFO stops accepting new samples when overflowed */
 } modeFIFO_t;
 
-/*! @brief Pin to route FIFO interrupt */
+/*! @brief Pin to route FIFO or data ready interrupt */
 typedef enum {
     FIFO_INT1    = 1,   /*!< FIFO Interrupt routed to INT1 pin */
     FIFO_INT2    = 0    /*!< FIFO Interrupt routed to INT2 pin */
@@ -354,6 +354,26 @@ mpl_status_t MPL_DisableFifoInterrupt();
  */
 mpl_status_t MPL_GetFifoStatus(uint8_t* fifoStatus);
 
+/*!
+ * @brief Setup the data ready interrupt and route it to pin INT1 or INT2
+ * @note
+ * The interrupt is raised at every auto acquisition step and released when the
+ * output registers are read, see MPL_ReadReadyData().
+ *
+ * @param pinINT Interrupt pin selection (INT1 or INT2)
+ * @return Status value (0 for success)
+ */
+mpl_status_t MPL_SetDataReadyInterrupt (pinINT_t pinINT);
+
+/*!
+ * @brief Read the status and output registers in one transfer, without waiting
+ *
+ * @param  sensorData Pointer to the sensor data of the current mode, written if ready
+ * @param  dataReady  Pointer set to true if new data was available
+ * @return Status value (0 for success)
+ */
+mpl_status_t MPL_ReadReadyData (int32_t* sensorData, bool* dataReady);
+
 /*!
  * @brief Read sensor raw data
  *
@@ -48,77 +48,29 @@ static bool initDriverDone = false;
 static bool initHwDone = false;
 static uint8_t currentBrightness;
 static uint8_t currentColor;
+static bool patternRunning = false;
+static rgb_led_frame_t currentOutput;   /* duty cycles set last, start of the next ramp */
+static rgb_led_frame_t firstFrame;      /* of the waveform being stored */
+static rgb_led_frame_t lastFrame;
 
-/*****************************************************************************
- * Static functions
- ****************************************************************************/
+/* Colour wheel sequence */
+static const uint8_t wheelColors[] =
+{
+    RGB_LED_COLOR_RED, RGB_LED_COLOR_YELLOW, RGB_LED_COLOR_GREEN,
+    RGB_LED_COLOR_CYAN, RGB_LED_COLOR_BLUE, RGB_LED_COLOR_PURPLE
+};
 
 /*****************************************************************************
- * Public functions
+ * Static functions
  ****************************************************************************/
 
-void RGB_Led_Init_Driver(rgbled_fct_t *fct)
+/* PWM values within the range [0-100] of a preselected brightness and color */
+static RgbLedErrorCode_t RGB_Led_Get_Levels(uint8_t brightness, uint8_t color, uint8_t *pwm)
 {
-    assert((fct != NULL) &&
-            (fct->connect_hw != NULL) &&
-            (fct->disconnect_hw != NULL) &&
-            (fct->set_rgb_colors != NULL));
-    fctRgbLed = *fct;
-    initDriverDone = true;
-}
-
-void RGB_Led_Deinit_Driver()
-{
-    if (initHwDone)
-    {
-        /* Deinit HW */
-        fctRgbLed.set_rgb_colors(LED_RGB_BLACK); /* off */
-        fctRgbLed.disconnect_hw();
-    }
-
-    /* Deinit driver */
-    initDriverDone = false;
-    initHwDone = false;
-}
-
-RgbLedErrorCode_t RGB_Led_Init_Hw()
-{
-    if (!initDriverDone) {
-        return kStatus_Fail;
-    }
-    currentBrightness = BRIGHTNESS_DEFAULT;
-    currentColor = COLOR_DEFAULT;
-
-    fctRgbLed.connect_hw();
-    fctRgbLed.set_rgb_colors(LED_RGB_BLACK); /* off */
-
-    initHwDone = true;
-    return kStatus_Success;
-}
-
-RgbLedErrorCode_t RGB_Led_Get_State(rgb_led_brightness_t *brightness, rgb_led_color_t *color)
-{
-    if (!initHwDone) return kStatus_Fail;
-    assert((brightness != NULL) && (color != NULL));
-
-    *brightness = currentBrightness;
-    *color = currentColor;
-
-    return kStatus_Success;
-}
-
-RgbLedErrorCode_t RGB_Led_Set_State(rgb_led_brightness_t brightness, rgb_led_color_t color)
-{
-    /* PWM values within the range [0-100] */
     uint8_t pwmRed = 0;
     uint8_t pwmGreen = 0;
     uint8_t pwmBlue = 0;
 
-    if (!initHwDone)
-    {
-        return kStatus_Fail;
-    }
-
     if (color == RGB_LED_COLOR_RED)
     {
         pwmRed = 100;
@@ -199,9 +151,325 @@ RgbLedErrorCode_t RGB_Led_Set_State(rgb_led_brightness_t brightness, rgb_led_col
         return kStatus_Fail;
     }
 
-    fctRgbLed.set_rgb_colors(pwmRed, pwmGreen, pwmBlue);
+    pwm[0] = pwmRed;
+    pwm[1] = pwmGreen;
+    pwm[2] = pwmBlue;
+    return kStatus_Success;
+}
+
+/* Waveform frame of a preselected brightness and color */
+static RgbLedErrorCode_t RGB_Led_Get_Frame(uint8_t brightness, uint8_t color, rgb_led_frame_t *frame)
+{
+    uint8_t pwm[3];
+
+    if (RGB_Led_Get_Levels(brightness, color, pwm) != kStatus_Success)
+    {
+        return kStatus_Fail;
+    }
+    frame->r = pwm[0] * (RGB_LED_DUTY_MAX / 100);
+    frame->g = pwm[1] * (RGB_LED_DUTY_MAX / 100);
+    frame->b = pwm[2] * (RGB_LED_DUTY_MAX / 100);
+    return kStatus_Success;
+}
+
+/* Perceived brightness of a duty cycle, both in [0-RGB_LED_DUTY_MAX] */
+static uint16_t RGB_Led_Duty_To_Level(uint16_t duty)
+{
+    uint32_t x = (uint32_t)duty * RGB_LED_DUTY_MAX;
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)root;
+}
+
+/* Duty cycle at step/steps of the fade from one perceived brightness to another */
+static uint16_t RGB_Led_Fade(uint16_t from, uint16_t to, uint32_t step, uint32_t steps)
+{
+    int32_t level = from + ((int32_t)to - (int32_t)from) * (int32_t)step / (int32_t)steps;
+
+    return (uint16_t)(((uint32_t)level * (uint32_t)level + RGB_LED_DUTY_MAX / 2) / RGB_LED_DUTY_MAX);
+}
+
+/* Frame at step/steps of the fade between two frames */
+static void RGB_Led_Fade_Frame(const rgb_led_frame_t *from, const rgb_led_frame_t *to, uint32_t step, uint32_t steps,
+                               rgb_led_frame_t *frame)
+{
+    frame->r = RGB_Led_Fade(RGB_Led_Duty_To_Level(from->r), RGB_Led_Duty_To_Level(to->r), step, steps);
+    frame->g = RGB_Led_Fade(RGB_Led_Duty_To_Level(from->g), RGB_Led_Duty_To_Level(to->g), step, steps);
+    frame->b = RGB_Led_Fade(RGB_Led_Duty_To_Level(from->b), RGB_Led_Duty_To_Level(to->b), step, steps);
+}
+
+/* Stores a pattern frame in the waveform table of the hardware */
+static void RGB_Led_Store_Frame(uint16_t index, const rgb_led_frame_t *frame)
+{
+    fctRgbLed.set_waveform_frame(index, frame);
+    if (index == 0)
+    {
+        firstFrame = *frame;
+    }
+    lastFrame = *frame;
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+
+void RGB_Led_Init_Driver(rgbled_fct_t *fct)
+{
+    assert((fct != NULL) &&
+            (fct->connect_hw != NULL) &&
+            (fct->disconnect_hw != NULL) &&
+            (fct->set_rgb_colors != NULL));
+    fctRgbLed = *fct;
+    initDriverDone = true;
+}
+
+void RGB_Led_Deinit_Driver()
+{
+    if (initHwDone)
+    {
+        /* Deinit HW */
+        if (patternRunning)
+        {
+            fctRgbLed.stop_waveform();
+            patternRunning = false;
+        }
+        fctRgbLed.set_rgb_colors(LED_RGB_BLACK); /* off */
+        fctRgbLed.disconnect_hw();
+    }
+
+    /* Deinit driver */
+    initDriverDone = false;
+    initHwDone = false;
+}
+
+RgbLedErrorCode_t RGB_Led_Init_Hw()
+{
+    if (!initDriverDone) {
+        return kStatus_Fail;
+    }
+    currentBrightness = BRIGHTNESS_DEFAULT;
+    currentColor = COLOR_DEFAULT;
+
+    fctRgbLed.connect_hw();
+    fctRgbLed.set_rgb_colors(LED_RGB_BLACK); /* off */
+    currentOutput.r = 0;
+    currentOutput.g = 0;
+    currentOutput.b = 0;
+
+    initHwDone = true;
+    return kStatus_Success;
+}
+
+RgbLedErrorCode_t RGB_Led_Get_State(rgb_led_brightness_t *brightness, rgb_led_color_t *color)
+{
+    if (!initHwDone) return kStatus_Fail;
+    assert((brightness != NULL) && (color != NULL));
+
+    *brightness = currentBrightness;
+    *color = currentColor;
+
+    return kStatus_Success;
+}
+
+RgbLedErrorCode_t RGB_Led_Set_State(rgb_led_brightness_t brightness, rgb_led_color_t color)
+{
+    /* PWM values within the range [0-100] */
+    uint8_t pwm[3];
+
+    if (!initHwDone)
+    {
+        return kStatus_Fail;
+    }
+
+    if (RGB_Led_Get_Levels(brightness, color, pwm) != kStatus_Success)
+    {
+        return kStatus_Fail;
+    }
+
+    if (patternRunning)
+    {
+        fctRgbLed.stop_waveform();
+        patternRunning = false;
+    }
+
+    fctRgbLed.set_rgb_colors(pwm[0], pwm[1], pwm[2]);
+    (void)RGB_Led_Get_Frame(brightness, color, &currentOutput);
     currentBrightness = brightness;
     currentColor = color;
     return kStatus_Success;
 }
 
+uint16_t RGB_Led_Build_Waveform(const rgb_led_pattern_t *pattern, const rgb_led_frame_t *from,
+                                rgb_led_frame_handler_t handler, uint16_t maxFrames, uint16_t *frameMs, bool *loop)
+{
+    rgb_led_frame_t target;
+    rgb_led_frame_t next;
+    rgb_led_frame_t frame;
+    rgb_led_frame_t off = {0, 0, 0};
+    uint32_t durationMs;
+    uint32_t period;
+    uint32_t on;
+    uint32_t count;
+    uint32_t i;
+
+    assert((pattern != NULL) && (from != NULL) && (handler != NULL) && (frameMs != NULL) && (loop != NULL));
+
+    if ((pattern->type != RGB_LED_PATTERN_WHEEL) &&
+        (RGB_Led_Get_Frame(pattern->brightness, pattern->color, &target) != kStatus_Success))
+    {
+        return 0;
+    }
+
+    /* Lengthen the frames of the long patterns so that they fit */
+    durationMs = pattern->periodMs;
+    if (pattern->type == RGB_LED_PATTERN_BLINK)
+    {
+        durationMs *= (pattern->repeat ? pattern->repeat : 1);
+    }
+    else if (pattern->type == RGB_LED_PATTERN_WHEEL)
+    {
+        durationMs *= sizeof(wheelColors);
+    }
+    *frameMs = RGB_LED_FRAME_MS * ((durationMs + (uint32_t)RGB_LED_FRAME_MS * maxFrames - 1) / ((uint32_t)RGB_LED_FRAME_MS * maxFrames));
+    if (*frameMs == 0)
+    {
+        return 0;
+    }
+    period = pattern->periodMs / *frameMs;
+
+    switch (pattern->type)
+    {
+        case RGB_LED_PATTERN_RAMP:
+            count = period ? period : 1;
+            for (i = 1; i < count; i++)
+            {
+                RGB_Led_Fade_Frame(from, &target, i, count, &frame);
+                handler((uint16_t)(i - 1), &frame);
+            }
+            handler((uint16_t)(count - 1), &target);
+            *loop = false;
+            break;
+
+        case RGB_LED_PATTERN_BREATHE:
+            if (period < 2)
+            {
+                return 0;
+            }
+            count = period;
+            for (i = 0; i < count; i++)
+            {
+                /* Up in the first half of the period, down in the second one */
+                uint32_t phase = (2 * i < count) ? 2 * i : 2 * (count - i);
+
+                RGB_Led_Fade_Frame(&off, &target, phase, count, &frame);
+                handler((uint16_t)i, &frame);
+            }
+            *loop = true;
+            break;
+
+        case RGB_LED_PATTERN_BLINK:
+            on = (pattern->onMs + *frameMs / 2) / *frameMs;
+            on = on ? on : 1;
+            if (on >= period)
+            {
+                return 0;
+            }
+            count = period * (pattern->repeat ? pattern->repeat : 1);
+            for (i = 0; i < count; i++)
+            {
+                handler((uint16_t)i, ((i % period) < on) ? &target : &off);
+            }
+            /* Played once when repeated, ending off */
+            *loop = (pattern->repeat == 0);
+            break;
+
+        case RGB_LED_PATTERN_WHEEL:
+            if (period == 0)
+            {
+                return 0;
+            }
+            count = period * sizeof(wheelColors);
+            for (i = 0; i < sizeof(wheelColors); i++)
+            {
+                uint32_t j;
+
+                (void)RGB_Led_Get_Frame(pattern->brightness, wheelColors[i], &target);
+                (void)RGB_Led_Get_Frame(pattern->brightness, wheelColors[(i + 1) % sizeof(wheelColors)], &next);
+                for (j = 0; j < period; j++)
+                {
+                    RGB_Led_Fade_Frame(&target, &next, j, period, &frame);
+                    handler((uint16_t)(i * period + j), &frame);
+                }
+            }
+            *loop = true;
+            break;
+
+        default:
+            return 0;
+    }
+
+    return (uint16_t)count;
+}
+
+RgbLedErrorCode_t RGB_Led_Start_Pattern(const rgb_led_pattern_t *pattern)
+{
+    uint16_t count;
+    uint16_t frameMs;
+    bool loop;
+
+    if (!initHwDone || (fctRgbLed.set_waveform_frame == NULL) || (fctRgbLed.start_waveform == NULL) ||
+        (fctRgbLed.stop_waveform == NULL))
+    {
+        return kStatus_Fail;
+    }
+    assert(pattern != NULL);
+
+    /* The hardware reads the waveform table */
+    if (patternRunning)
+    {
+        fctRgbLed.stop_waveform();
+        patternRunning = false;
+    }
+
+    count = RGB_Led_Build_Waveform(pattern, &currentOutput, RGB_Led_Store_Frame, RGB_LED_MAX_FRAMES, &frameMs, &loop);
+    if (count == 0)
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    fctRgbLed.start_waveform(count, frameMs, loop);
+    patternRunning = true;
+
+    /* Next ramp from the held frame, or from the start of the loop */
+    currentOutput = loop ? firstFrame : lastFrame;
+    currentBrightness = pattern->brightness;
+    currentColor = pattern->color;
+    return kStatus_Success;
+}
+
+RgbLedErrorCode_t RGB_Led_Stop_Pattern(void)
+{
+    if (!initHwDone)
+    {
+        return kStatus_Fail;
+    }
+    return RGB_Led_Set_State(RGB_LED_BRIGHT_OFF, RGB_LED_COLOR_BLACK);
+}
@@ -46,6 +46,10 @@
  * -# If the RGB LED is not needed anymore, de-initialize the driver (#RGB_Led_Deinit_Driver). The RGB LED will
  * be switched off. It allows to eventually release shared resources.
  *
+ * Ramps, breathing, blinking and colour wheels are started with #RGB_Led_Start_Pattern. The driver computes
+ * the duty cycles of the whole pattern once, straight into the waveform table of the hardware
+ * (set_waveform_frame callback), which plays them back without waking up the CPU (start_waveform callback).
+ *
  * Example - Sample application code to set RGB LED without error management
  * -------------------------------------------------------------------------
  * @code
@@ -75,12 +79,43 @@
 
 typedef enum _generic_status RgbLedErrorCode_t;
 
+/*! @brief Duration of a waveform frame, in milliseconds. */
+#ifndef RGB_LED_FRAME_MS
+#define RGB_LED_FRAME_MS    20
+#endif
+
+/*! @brief Number of frames of the waveform table (4 s with RGB_LED_FRAME_MS frames). */
+#ifndef RGB_LED_MAX_FRAMES
+#define RGB_LED_MAX_FRAMES  200
+#endif
+
+/*! @brief Duty cycle resolution of the waveform frames: 0 (off) to RGB_LED_DUTY_MAX (on). */
+#define RGB_LED_DUTY_MAX    1000
+
+/*! @brief Waveform frame, duty cycles of the R/G/B LEDs. */
+typedef struct _rgb_led_frame_t
+{
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+} rgb_led_frame_t;
+
+/*! @brief Receives the waveform frames of a pattern, in order, see #RGB_Led_Build_Waveform. */
+typedef void (*rgb_led_frame_handler_t)(uint16_t index, const rgb_led_frame_t *frame);
+
 /*! @brief Structure of external functions or values. */
 typedef struct _rgbled_fct_t
 {
     void (*connect_hw)(void);    /*!< External function to activate the RGB LED hardware */
     void (*disconnect_hw)(void); /*!< External function to deactivate the RGB LED hardware */
     void (*set_rgb_colors)(uint8_t R, uint8_t G, uint8_t B); /*!< External function to set R/G/B colors */
+    /*! Optional external function to store frame index (below RGB_LED_MAX_FRAMES) of the waveform table, R/G/B
+     *  duty cycles from 0 to RGB_LED_DUTY_MAX. Only called while no waveform is played. */
+    void (*set_waveform_frame)(uint16_t index, const rgb_led_frame_t *frame);
+    /*! Optional external function to play the first count frames of the waveform table, one every frameMs,
+     *  in a loop or once (the last frame is then kept). */
+    void (*start_waveform)(uint16_t count, uint16_t frameMs, bool loop);
+    void (*stop_waveform)(void); /*!< Optional external function to stop the waveform, the outputs keep their level */
 } rgbled_fct_t;
 
 /*! @brief LED Brightness */
@@ -103,6 +138,25 @@ typedef enum {
     RGB_LED_COLOR_BLACK  = 7        /*!< LED Color: Black /OFF */
 } rgb_led_color_t;
 
+/*! @brief LED Pattern */
+typedef enum {
+    RGB_LED_PATTERN_RAMP    = 0,    /*!< Fade from the last steady output to the color in periodMs, then hold it */
+    RGB_LED_PATTERN_BREATHE = 1,    /*!< Fade in and out, once every periodMs */
+    RGB_LED_PATTERN_BLINK   = 2,    /*!< On for onMs, once every periodMs, repeat times (0: forever) */
+    RGB_LED_PATTERN_WHEEL   = 3     /*!< Cross-fade through the colors, periodMs per color (color not used) */
+} rgb_led_pattern_type_t;
+
+/*! @brief LED Pattern description */
+typedef struct _rgb_led_pattern_t
+{
+    rgb_led_pattern_type_t type;
+    uint8_t brightness;     /*!< rgb_led_brightness_t */
+    uint8_t color;          /*!< rgb_led_color_t */
+    uint16_t periodMs;
+    uint16_t onMs;          /*!< Blink only */
+    uint8_t repeat;         /*!< Blink only */
+} rgb_led_pattern_t;
+
 /*****************************************************************************
  * Public functions
  ****************************************************************************/
@@ -144,6 +198,39 @@ RgbLedErrorCode_t RGB_Led_Get_State(uint8_t *brightness, uint8_t *color);
  */
 RgbLedErrorCode_t RGB_Led_Set_State(uint8_t brightness, uint8_t color);
 
+/*!
+ * @brief Start a pattern, replacing the running one.
+ *
+ * @note Needs the set_waveform_frame, start_waveform and stop_waveform callbacks. RGB_Led_Set_State stops the pattern.
+ * @param pattern    Pattern description
+ * @return           Status value (0 for success), kStatus_InvalidArgument if the pattern is not valid
+ */
+RgbLedErrorCode_t RGB_Led_Start_Pattern(const rgb_led_pattern_t *pattern);
+
+/*!
+ * @brief Stop the running pattern and switch the RGB LED off.
+ *
+ * @return           Status value (0 for success)
+ */
+RgbLedErrorCode_t RGB_Led_Stop_Pattern(void);
+
+/*!
+ * @brief Compute the waveform frames of a pattern. Used by #RGB_Led_Start_Pattern, and off-target to check
+ * the generated duty cycles.
+ *
+ * @note The brightness is faded on a perceptual scale, the duty cycle being the square of it.
+ * @note The frames last RGB_LED_FRAME_MS, or a multiple of it for the patterns longer than maxFrames frames.
+ * @param pattern    Pattern description
+ * @param from       Output at the start of a ramp
+ * @param handler    Called with each frame, index 0 first
+ * @param maxFrames  Maximum number of frames
+ * @param frameMs    Set to the duration of a frame
+ * @param loop       Set to true if the frames are to be played in a loop
+ * @return           Number of frames, 0 if the pattern is not valid
+ */
+uint16_t RGB_Led_Build_Waveform(const rgb_led_pattern_t *pattern, const rgb_led_frame_t *from,
+                                rgb_led_frame_handler_t handler, uint16_t maxFrames, uint16_t *frameMs, bool *loop);
+
 /*! @}*/
 
 #endif /* RGB_LED_H_ */
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file rgb_led_test.c
+ * Host test for the RGB LED patterns. The driver source is built in with stubbed board callbacks: the
+ * waveform frames of each pattern are checked, and the pattern player is driven through its callbacks.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../rgb_led.c"
+
+/*****************************************************************************
+ * Stubs
+ ****************************************************************************/
+static rgb_led_frame_t sTable[RGB_LED_MAX_FRAMES];   /* waveform table of the "hardware" */
+static uint32_t sStored;
+static bool sPlaying;
+static uint16_t sCount;
+static uint16_t sFrameMs;
+static bool sLoop;
+static uint8_t sColors[3];
+
+static void Connect(void)
+{
+}
+
+static void Disconnect(void)
+{
+}
+
+static void SetColors(uint8_t r, uint8_t g, uint8_t b)
+{
+    sColors[0] = r;
+    sColors[1] = g;
+    sColors[2] = b;
+}
+
+static void SetWaveformFrame(uint16_t index, const rgb_led_frame_t *frame)
+{
+    /* The table is read by the hardware while playing */
+    if (sPlaying || (index >= RGB_LED_MAX_FRAMES))
+    {
+        printf("FAIL frame %u stored while playing or out of the table\n", index);
+        exit(1);
+    }
+    sTable[index] = *frame;
+    sStored++;
+}
+
+static void StartWaveform(uint16_t count, uint16_t frameMs, bool loop)
+{
+    sPlaying = true;
+    sCount = count;
+    sFrameMs = frameMs;
+    sLoop = loop;
+}
+
+static void StopWaveform(void)
+{
+    sPlaying = false;
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+static rgb_led_frame_t sFrames[RGB_LED_MAX_FRAMES];
+static uint32_t sNext;
+
+/* Collects the frames of RGB_Led_Build_Waveform, which come in order */
+static void Collect(uint16_t index, const rgb_led_frame_t *frame)
+{
+    CHECK(index == sNext);
+    CHECK(index < RGB_LED_MAX_FRAMES);
+    sFrames[index] = *frame;
+    sNext++;
+}
+
+static uint16_t Build(const rgb_led_pattern_t *pattern, const rgb_led_frame_t *from, uint16_t *frameMs, bool *loop)
+{
+    uint16_t count;
+
+    sNext = 0;
+    count = RGB_Led_Build_Waveform(pattern, from, Collect, RGB_LED_MAX_FRAMES, frameMs, loop);
+    CHECK(count == sNext);
+    return count;
+}
+
+static void Init(void)
+{
+    rgbled_fct_t fct;
+
+    memset(&fct, 0, sizeof(fct));
+    fct.connect_hw = Connect;
+    fct.disconnect_hw = Disconnect;
+    fct.set_rgb_colors = SetColors;
+    fct.set_waveform_frame = SetWaveformFrame;
+    fct.start_waveform = StartWaveform;
+    fct.stop_waveform = StopWaveform;
+    RGB_Led_Init_Driver(&fct);
+    CHECK(kStatus_Success == RGB_Led_Init_Hw());
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* A 1 s ramp from off: 50 frames of 20 ms, rising, ending on the color */
+static void TestRamp(void)
+{
+    rgb_led_pattern_t pattern = {RGB_LED_PATTERN_RAMP, RGB_LED_BRIGHT_HIGH, RGB_LED_COLOR_WHITE, 1000, 0, 0};
+    rgb_led_frame_t from = {0, 0, 0};
+    uint16_t frameMs;
+    bool loop;
+    uint16_t count;
+    uint16_t i;
+
+    count = Build(&pattern, &from, &frameMs, &loop);
+    CHECK(50 == count);
+    CHECK(RGB_LED_FRAME_MS == frameMs);
+    CHECK(!loop);
+    for (i = 1; i < count; i++)
+    {
+        CHECK(sFrames[i].r >= sFrames[i - 1].r);
+        CHECK(sFrames[i].g >= sFrames[i - 1].g);
+    }
+    CHECK((400 == sFrames[count - 1].r) && (1000 == sFrames[count - 1].g) && (800 == sFrames[count - 1].b));
+}
+
+/* A 2 s breath: symmetric, off at the start of the loop, peaking half way */
+static void TestBreathe(void)
+{
+    rgb_led_pattern_t pattern = {RGB_LED_PATTERN_BREATHE, RGB_LED_BRIGHT_HIGH, RGB_LED_COLOR_RED, 2000, 0, 0};
+    rgb_led_frame_t from = {0, 0, 0};
+    uint16_t frameMs;
+    bool loop;
+    uint16_t count;
+    uint16_t peak = 0;
+    uint16_t i;
+
+    count = Build(&pattern, &from, &frameMs, &loop);
+    CHECK(100 == count);
+    CHECK(loop);
+    for (i = 0; i < count; i++)
+    {
+        peak = (sFrames[i].r > sFrames[peak].r) ? i : peak;
+    }
+    CHECK(50 == peak);
+    CHECK(0 == sFrames[0].r);
+    for (i = 1; i < count; i++)
+    {
+        CHECK(sFrames[i].r == sFrames[count - i].r);
+    }
+
+    /* Too short to go up and down */
+    pattern.periodMs = RGB_LED_FRAME_MS;
+    CHECK(0 == Build(&pattern, &from, &frameMs, &loop));
+}
+
+/* Blinks: on for onMs every period, ending off when repeated, lengthened frames when long */
+static void TestBlink(void)
+{
+    rgb_led_pattern_t pattern = {RGB_LED_PATTERN_BLINK, RGB_LED_BRIGHT_HIGH, RGB_LED_COLOR_BLUE, 1000, 200, 3};
+    rgb_led_frame_t from = {0, 0, 0};
+    uint16_t frameMs;
+    bool loop;
+    uint16_t count;
+    uint16_t on = 0;
+    uint16_t i;
+
+    count = Build(&pattern, &from, &frameMs, &loop);
+    for (i = 0; i < count; i++)
+    {
+        on += (sFrames[i].b != 0);
+    }
+    CHECK(150 == count);
+    CHECK(30 == on);
+    CHECK(!loop);
+    CHECK(0 == sFrames[count - 1].b);
+
+    pattern.repeat = 10;
+    count = Build(&pattern, &from, &frameMs, &loop);
+    CHECK(count <= RGB_LED_MAX_FRAMES);
+    CHECK(60 == frameMs);
+
+    /* Always on is not a blink */
+    pattern.repeat = 0;
+    pattern.onMs = pattern.periodMs;
+    CHECK(0 == Build(&pattern, &from, &frameMs, &loop));
+}
+
+/* A colour wheel: 500 ms per color, in a loop, without visible steps */
+static void TestWheel(void)
+{
+    rgb_led_pattern_t pattern = {RGB_LED_PATTERN_WHEEL, RGB_LED_BRIGHT_HIGH, 0, 500, 0, 0};
+    rgb_led_frame_t from = {0, 0, 0};
+    uint16_t frameMs;
+    bool loop;
+    uint16_t count;
+    int step = 0;
+    uint16_t i;
+
+    count = Build(&pattern, &from, &frameMs, &loop);
+    CHECK(150 == count);
+    CHECK(loop);
+    for (i = 0; i < count; i++)
+    {
+        const rgb_led_frame_t *a = &sFrames[i];
+        const rgb_led_frame_t *b = &sFrames[(i + 1) % count];
+        int d = abs(b->r - a->r) + abs(b->g - a->g) + abs(b->b - a->b);
+
+        step = (d > step) ? d : step;
+    }
+    printf("wheel: largest step %d/%d\n", step, RGB_LED_DUTY_MAX);
+    CHECK(step < 300);
+}
+
+/* The player stores the frames in the hardware table, once, then starts it */
+static void TestPlayer(void)
+{
+    rgb_led_pattern_t pattern = {RGB_LED_PATTERN_BREATHE, RGB_LED_BRIGHT_HIGH, RGB_LED_COLOR_GREEN, 2000, 0, 0};
+    rgb_led_pattern_t ramp = {RGB_LED_PATTERN_RAMP, RGB_LED_BRIGHT_LOW, RGB_LED_COLOR_RED, 200, 0, 0};
+
+    Init();
+    sStored = 0;
+    CHECK(kStatus_Success == RGB_Led_Start_Pattern(&pattern));
+    CHECK(sPlaying && sLoop && (100 == sCount) && (RGB_LED_FRAME_MS == sFrameMs));
+    CHECK(100 == sStored);
+    CHECK(1000 == sTable[50].g);
+
+    /* Replacing a pattern stops the hardware first; the ramp starts from the loop start, off */
+    sStored = 0;
+    CHECK(kStatus_Success == RGB_Led_Start_Pattern(&ramp));
+    CHECK(sPlaying && !sLoop && (10 == sCount) && (10 == sStored));
+    CHECK(0 == sTable[0].g);
+    CHECK(330 == sTable[9].r);
+
+    /* Invalid patterns leave the LED off */
+    pattern.periodMs = 0;
+    CHECK(kStatus_InvalidArgument == RGB_Led_Start_Pattern(&pattern));
+    CHECK(!sPlaying);
+
+    /* A steady state stops the pattern */
+    CHECK(kStatus_Success == RGB_Led_Start_Pattern(&ramp));
+    CHECK(kStatus_Success == RGB_Led_Set_State(RGB_LED_BRIGHT_HIGH, RGB_LED_COLOR_RED));
+    CHECK(!sPlaying && (100 == sColors[0]));
+    CHECK(kStatus_Success == RGB_Led_Stop_Pattern());
+    CHECK(0 == sColors[0]);
+
+    RGB_Led_Deinit_Driver();
+    CHECK(kStatus_Fail == RGB_Led_Start_Pattern(&ramp));
+}
+
+int main(void)
+{
+    TestRamp();
+    TestBreathe();
+    TestBlink();
+    TestWheel();
+    TestPlayer();
+
+    printf("rgb_led: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,22 @@
+/* Host test stub of the SDK common definitions */
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int32_t status_t;
+
+enum _generic_status
+{
+    kStatus_Success = 0,
+    kStatus_Fail = 1,
+    kStatus_ReadOnly = 2,
+    kStatus_OutOfRange = 3,
+    kStatus_InvalidArgument = 4,
+    kStatus_Timeout = 5,
+    kStatus_NoTransferInProgress = 6,
+};
+
+#endif
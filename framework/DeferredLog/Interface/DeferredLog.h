@@ -0,0 +1,212 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file DeferredLog.h
+* This is the header file for the deferred (binary) logging module.
+* Call sites store a compact record (format string address, timestamp and raw
+* 32 bit arguments) into a lock-free ring buffer. A low priority task formats
+* the records and drains them to the shell UART or, in binary form, to FSCI.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* o Redistributions of source code must retain the above copyright notice, this list
+*   of conditions and the following disclaimer.
+*
+* o Redistributions in binary form must reproduce the above copyright notice, this
+*   list of conditions and the following disclaimer in the documentation and/or
+*   other materials provided with the distribution.
+*
+* o Neither the name of the copyright holder nor the names of its
+*   contributors may be used to endorse or promote products derived from this
+*   software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+* ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _DEFERRED_LOG_H_
+#define _DEFERRED_LOG_H_
+
+/*! *********************************************************************************
+*************************************************************************************
+* Include
+*************************************************************************************
+********************************************************************************** */
+#include "EmbeddedTypes.h"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public macros
+*************************************************************************************
+********************************************************************************** */
+
+/*
+ * \brief   Enables / Disables the deferred logging module
+ * VALID RANGE: TRUE/FALSE
+ */
+#ifndef gDLogEnabled_d
+#define gDLogEnabled_d                  1
+#endif
+
+/*
+ * \brief   Number of records in the ring buffer.
+ * VALID RANGE: power of 2
+ */
+#ifndef gDLogBufferEntries_c
+#define gDLogBufferEntries_c            64
+#endif
+
+/*
+ * \brief   Maximum number of 32 bit arguments stored for one record.
+ * VALID RANGE: 1..4
+ */
+#ifndef gDLogMaxArgs_c
+#define gDLogMaxArgs_c                  4
+#endif
+
+/*
+ * \brief   Selects the output of the drain task.
+ *          0 - records are formatted and written to the shell serial interface
+ *          1 - records are sent unformatted over FSCI (decode them on the host
+ *              with Tools/dlog_decode.py)
+ */
+#ifndef gDLogOutputFsci_d
+#define gDLogOutputFsci_d               0
+#endif
+
+/*
+ * \brief   Prefix every formatted record with its timestamp in milliseconds.
+ * VALID RANGE: TRUE/FALSE
+ */
+#ifndef gDLogPrintTimestamp_d
+#define gDLogPrintTimestamp_d           0
+#endif
+
+/*
+ * \brief   Size of the buffer used by the drain task to format one record.
+ */
+#ifndef gDLogLineSize_c
+#define gDLogLineSize_c                 96
+#endif
+
+/*
+ * \brief   Configures the drain task stack size and priority. The task must run
+ *          at a lower priority than every producer.
+ */
+#ifndef gDLogTaskStackSize_c
+#define gDLogTaskStackSize_c            600
+#endif
+
+#ifndef gDLogTaskPriority_c
+#define gDLogTaskPriority_c             OSA_PRIORITY_IDLE
+#endif
+
+/*
+ * \brief   Maximum time the drain task sleeps before checking the ring again.
+ */
+#ifndef gDLogDrainIntervalMs_c
+#define gDLogDrainIntervalMs_c          100
+#endif
+
+/* FSCI operation code used for binary records (logging operation group) */
+#define gDLogFsciOpCode_c               0x02
+
+/* Counts the arguments following the format string (0..12) */
+#define mDLogNArgs_m(...)               mDLogNArgsSel_m(__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, \
+                                                        4, 3, 2, 1, 0, 0)
+#define mDLogNArgsSel_m(fmt, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, n, ...) n
+
+/* Fails to compile (negative array size) when a record has too many arguments */
+#define mDLogCheckNArgs_m(n)            ((void)sizeof(char[((n) <= gDLogMaxArgs_c) ? 1 : -1]))
+
+#if gDLogEnabled_d
+/*
+ * \brief   Records a log message. The format string must be a literal (or have
+ *          static storage) because only its address is stored. Arguments are
+ *          stored as raw 32 bit words: integers, characters and pointers to
+ *          constant strings are supported, floating point values are not.
+ *          More than gDLogMaxArgs_c arguments is a build error.
+ */
+#define DLOG_PRINTF(...)                (mDLogCheckNArgs_m(mDLogNArgs_m(__VA_ARGS__)), \
+                                         DLOG_Record(mDLogNArgs_m(__VA_ARGS__), __VA_ARGS__))
+#else
+#define DLOG_PRINTF(...)
+#define DLOG_Init()
+#define DLOG_Flush()
+#define DLOG_GetDroppedCount()          0
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public type definitions
+*************************************************************************************
+********************************************************************************** */
+
+/*! Binary record layout as sent over FSCI. Only nArgs arguments are transmitted. */
+typedef PACKED_STRUCT dlogFsciRecord_tag
+{
+    uint32_t formatAddr;                /* Address of the format string in flash */
+    uint32_t timestamp;                 /* Microseconds, from TMR_GetTimestamp() */
+    uint8_t  nArgs;
+    uint32_t args[gDLogMaxArgs_c];
+} dlogFsciRecord_t;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public prototypes
+*************************************************************************************
+********************************************************************************** */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if gDLogEnabled_d
+/*! *********************************************************************************
+* \brief   Creates the drain task. Records may be stored before this is called,
+*          they are output once the task runs.
+*
+********************************************************************************** */
+void DLOG_Init(void);
+
+/*! *********************************************************************************
+* \brief   Stores a record into the ring buffer. Safe to call from tasks and ISRs.
+*          Never blocks: when the ring is full the record is dropped and counted.
+*
+* \param[in] nArgs    number of 32 bit arguments that follow pFormat
+* \param[in] pFormat  printf style format string with static storage
+*
+* \remarks  Use the DLOG_PRINTF() macro instead of calling this directly.
+*
+********************************************************************************** */
+void DLOG_Record(uint8_t nArgs, const char *pFormat, ...);
+
+/*! *********************************************************************************
+* \brief   Synchronously outputs all committed records. Intended for panic and
+*          reset paths, where the drain task will not get to run anymore. It may
+*          preempt the drain task: every record is still output exactly once.
+*
+********************************************************************************** */
+void DLOG_Flush(void);
+
+/*! *********************************************************************************
+* \brief   Returns the number of records lost because the ring buffer was full.
+*
+********************************************************************************** */
+uint32_t DLOG_GetDroppedCount(void);
+#endif /* gDLogEnabled_d */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DEFERRED_LOG_H_ */
@@ -0,0 +1,411 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file DeferredLog.c
+* This is the source file for the deferred (binary) logging module.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* o Redistributions of source code must retain the above copyright notice, this list
+*   of conditions and the following disclaimer.
+*
+* o Redistributions in binary form must reproduce the above copyright notice, this
+*   list of conditions and the following disclaimer in the documentation and/or
+*   other materials provided with the distribution.
+*
+* o Neither the name of the copyright holder nor the names of its
+*   contributors may be used to endorse or promote products derived from this
+*   software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+* ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*! *********************************************************************************
+*************************************************************************************
+* Include
+*************************************************************************************
+********************************************************************************** */
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "EmbeddedTypes.h"
+#include "DeferredLog.h"
+#include "FunctionLib.h"
+#include "TimersManager.h"
+#include "Panic.h"
+#include "fsl_os_abstraction.h"
+#include "fsl_common.h"
+
+#if gDLogOutputFsci_d
+#include "FsciInterface.h"
+#else
+#include "shell.h"
+#endif
+
+#if gDLogEnabled_d
+/*! *********************************************************************************
+*************************************************************************************
+* Private macros
+*************************************************************************************
+********************************************************************************** */
+#if (gDLogBufferEntries_c & (gDLogBufferEntries_c - 1))
+#error "gDLogBufferEntries_c must be a power of 2"
+#endif
+
+#if (gDLogMaxArgs_c > 4)
+#error "The records are formatted with at most 4 arguments"
+#endif
+
+#define mDLogIndexMask_c            (gDLogBufferEntries_c - 1)
+#define mDLogEventNewRecord_c       (1 << 0)
+
+/* Use the exclusive monitor on ARMv7-M. Other cores fall back to masking interrupts. */
+#if defined(__CORTEX_M) && (__CORTEX_M >= 3U)
+#define mDLogUseExclusives_d        1
+#define mDLogBarrier_m()            __DMB()
+#else
+#define mDLogUseExclusives_d        0
+#define mDLogBarrier_m()            __asm volatile ("" ::: "memory")
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private type definitions
+*************************************************************************************
+********************************************************************************** */
+typedef struct dlogRecord_tag
+{
+    const char       *pFormat;
+    uint32_t          timestamp;
+    uint8_t           nArgs;
+    volatile uint8_t  committed;    /* Set by the producer once the record is complete */
+    uint32_t          args[gDLogMaxArgs_c];
+} dlogRecord_t;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private prototypes
+*************************************************************************************
+********************************************************************************** */
+static void DLOG_Task(osaTaskParam_t param);
+static void DLOG_Drain(void);
+static bool_t DLOG_Take(dlogRecord_t *pRecord);
+static void DLOG_Output(const dlogRecord_t *pRecord);
+static bool_t DLOG_Reserve(uint32_t *pIndex);
+static void DLOG_CountDropped(void);
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private memory declarations
+*************************************************************************************
+********************************************************************************** */
+OSA_TASK_DEFINE(DLOG_Task, gDLogTaskPriority_c, 1, gDLogTaskStackSize_c, FALSE);
+
+static dlogRecord_t maDLogRing[gDLogBufferEntries_c];
+
+/* Free running indexes: head is advanced by the producers, tail by DLOG_Take() */
+static volatile uint32_t mDLogHead;
+static volatile uint32_t mDLogTail;
+static volatile uint32_t mDLogDropped;
+static uint32_t mDLogDroppedReported;
+
+static osaEventId_t mDLogEventId = NULL;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public functions
+*************************************************************************************
+********************************************************************************** */
+
+/*! *********************************************************************************
+* \brief   Creates the drain task.
+*
+********************************************************************************** */
+void DLOG_Init(void)
+{
+    if( NULL == mDLogEventId )
+    {
+        mDLogEventId = OSA_EventCreate(TRUE);
+
+        if( NULL == mDLogEventId )
+        {
+            panic(0, (uint32_t)DLOG_Init, 0, 0);
+        }
+        else if( NULL == OSA_TaskCreate(OSA_TASK(DLOG_Task), NULL) )
+        {
+            panic(0, (uint32_t)DLOG_Init, 0, 0);
+        }
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Stores a record into the ring buffer.
+*
+* \param[in] nArgs    number of 32 bit arguments that follow pFormat
+* \param[in] pFormat  printf style format string with static storage
+*
+********************************************************************************** */
+void DLOG_Record(uint8_t nArgs, const char *pFormat, ...)
+{
+    dlogRecord_t *pRecord;
+    uint32_t index;
+    uint8_t i;
+    va_list args;
+
+    if( !DLOG_Reserve(&index) )
+    {
+        DLOG_CountDropped();
+        return;
+    }
+
+    if( nArgs > gDLogMaxArgs_c )
+    {
+        nArgs = gDLogMaxArgs_c;
+    }
+
+    pRecord = &maDLogRing[index & mDLogIndexMask_c];
+    pRecord->pFormat = pFormat;
+    pRecord->timestamp = (uint32_t)TMR_GetTimestamp();
+    pRecord->nArgs = nArgs;
+
+    va_start(args, pFormat);
+    for( i = 0; i < nArgs; i++ )
+    {
+        pRecord->args[i] = va_arg(args, uint32_t);
+    }
+    va_end(args);
+
+    /* The record must be complete before the drain task can see it */
+    mDLogBarrier_m();
+    pRecord->committed = TRUE;
+
+    /* Only the producer that found the ring empty needs to wake the drain task */
+    if( (index == mDLogTail) && (NULL != mDLogEventId) )
+    {
+        (void)OSA_EventSet(mDLogEventId, mDLogEventNewRecord_c);
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Synchronously outputs all committed records.
+*
+********************************************************************************** */
+void DLOG_Flush(void)
+{
+    DLOG_Drain();
+}
+
+/*! *********************************************************************************
+* \brief   Returns the number of records lost because the ring buffer was full.
+*
+********************************************************************************** */
+uint32_t DLOG_GetDroppedCount(void)
+{
+    return mDLogDropped;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private functions
+*************************************************************************************
+********************************************************************************** */
+
+/*! *********************************************************************************
+* \brief   Low priority task which empties the ring buffer. It wakes up when a
+*          record is stored into an empty ring, and periodically to pick up
+*          records whose producer was preempted before committing them.
+*
+********************************************************************************** */
+static void DLOG_Task(osaTaskParam_t param)
+{
+    osaEventFlags_t ev;
+
+    (void)param;
+
+    while(1)
+    {
+        (void)OSA_EventWait(mDLogEventId, osaEventFlagsAll_c, FALSE, gDLogDrainIntervalMs_c, &ev);
+        DLOG_Drain();
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Outputs the committed records in order and releases their slots. Runs
+*          in the drain task and in DLOG_Flush().
+*
+********************************************************************************** */
+static void DLOG_Drain(void)
+{
+    dlogRecord_t record;
+
+    while( DLOG_Take(&record) )
+    {
+        DLOG_Output(&record);
+    }
+
+    OSA_InterruptDisable();
+    record.nArgs = 0;
+
+    if( mDLogDropped != mDLogDroppedReported )
+    {
+        record.pFormat = "\r\n[dlog] %u records dropped\r\n";
+        record.timestamp = (uint32_t)TMR_GetTimestamp();
+        record.nArgs = 1;
+        record.args[0] = mDLogDropped - mDLogDroppedReported;
+        mDLogDroppedReported += record.args[0];
+    }
+    OSA_InterruptEnable();
+
+    if( record.nArgs )
+    {
+        DLOG_Output(&record);
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Copies the oldest committed record and releases its slot. The consumer
+*          index is only moved with the interrupts masked, so that DLOG_Flush()
+*          and the drain task never output the same record twice.
+*
+* \param[out] pRecord  copy of the record
+*
+* \return  FALSE if no committed record is waiting
+*
+********************************************************************************** */
+static bool_t DLOG_Take(dlogRecord_t *pRecord)
+{
+    dlogRecord_t *pSlot;
+    uint32_t tail;
+    bool_t taken = FALSE;
+
+    OSA_InterruptDisable();
+    tail = mDLogTail;
+    pSlot = &maDLogRing[tail & mDLogIndexMask_c];
+
+    /* A reserved record is skipped until the producer has finished writing it */
+    if( (tail != mDLogHead) && pSlot->committed )
+    {
+        FLib_MemCpy(pRecord, pSlot, sizeof(dlogRecord_t));
+        pSlot->committed = FALSE;
+        mDLogBarrier_m();
+        mDLogTail = tail + 1;
+        taken = TRUE;
+    }
+    OSA_InterruptEnable();
+
+    return taken;
+}
+
+/*! *********************************************************************************
+* \brief   Sends one record to the configured output.
+*
+********************************************************************************** */
+static void DLOG_Output(const dlogRecord_t *pRecord)
+{
+#if gDLogOutputFsci_d
+    dlogFsciRecord_t fsciRecord;
+
+    fsciRecord.formatAddr = (uint32_t)pRecord->pFormat;
+    fsciRecord.timestamp = pRecord->timestamp;
+    fsciRecord.nArgs = pRecord->nArgs;
+    FLib_MemCpy(fsciRecord.args, (void *)pRecord->args, pRecord->nArgs * sizeof(uint32_t));
+
+    FSCI_transmitPayload(gFSCI_LoggingOpcodeGroup_c, gDLogFsciOpCode_c, &fsciRecord,
+                         GetRelAddr(dlogFsciRecord_t, args) + pRecord->nArgs * sizeof(uint32_t),
+                         gFsciLoggingInterface_c);
+#else
+    char line[gDLogLineSize_c];
+    uint32_t args[4] = {0};
+    int len = 0;
+    int n;
+
+    FLib_MemCpy(args, (void *)pRecord->args, pRecord->nArgs * sizeof(uint32_t));
+
+#if gDLogPrintTimestamp_d
+    len = snprintf(line, sizeof(line), "[%lu] ", (unsigned long)(pRecord->timestamp / 1000));
+#endif
+    /* Unused argument slots are zero and ignored by the format string */
+    n = snprintf(&line[len], sizeof(line) - len, pRecord->pFormat, args[0], args[1], args[2], args[3]);
+
+    if( n > 0 )
+    {
+        len = MIN(len + n, (int)sizeof(line) - 1);
+    }
+
+    shell_writeN(line, (uint16_t)len);
+#endif
+}
+
+/*! *********************************************************************************
+* \brief   Claims the next free slot of the ring.
+*
+* \param[out] pIndex  free running index of the claimed slot
+*
+* \return  FALSE if the ring is full
+*
+********************************************************************************** */
+static bool_t DLOG_Reserve(uint32_t *pIndex)
+{
+    uint32_t head;
+
+#if mDLogUseExclusives_d
+    do
+    {
+        head = __LDREXW(&mDLogHead);
+
+        if( (head - mDLogTail) >= gDLogBufferEntries_c )
+        {
+            __CLREX();
+            return FALSE;
+        }
+    } while( __STREXW(head + 1, &mDLogHead) );
+#else
+    OSA_InterruptDisable();
+    head = mDLogHead;
+
+    if( (head - mDLogTail) >= gDLogBufferEntries_c )
+    {
+        OSA_InterruptEnable();
+        return FALSE;
+    }
+
+    mDLogHead = head + 1;
+    OSA_InterruptEnable();
+#endif
+
+    *pIndex = head;
+    return TRUE;
+}
+
+/*! *********************************************************************************
+* \brief   Atomically increments the dropped records counter.
+*
+********************************************************************************** */
+static void DLOG_CountDropped(void)
+{
+#if mDLogUseExclusives_d
+    uint32_t count;
+
+    do
+    {
+        count = __LDREXW(&mDLogDropped);
+    } while( __STREXW(count + 1, &mDLogDropped) );
+#else
+    OSA_InterruptDisable();
+    mDLogDropped++;
+    OSA_InterruptEnable();
+#endif
+}
+
+#endif /* gDLogEnabled_d */
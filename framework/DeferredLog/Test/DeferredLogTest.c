@@ -0,0 +1,236 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file DeferredLogTest.c
+* Host test for the deferred logging module. The module source is built in with
+* stubbed OS services: OSA_InterruptDisable() is a mutex shared by all threads,
+* so producers, the drain task and DLOG_Flush() can run concurrently.
+*
+* Build and run with "make" from this directory.
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../Source/DeferredLog.c"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Stubs
+*************************************************************************************
+********************************************************************************** */
+static pthread_mutex_t mIrqLock;
+static pthread_mutex_t mOutLock = PTHREAD_MUTEX_INITIALIZER;
+static char mOut[4 * 1024 * 1024];
+static size_t mOutLen;
+
+void OSA_InterruptDisable(void) { pthread_mutex_lock(&mIrqLock); }
+void OSA_InterruptEnable(void)  { pthread_mutex_unlock(&mIrqLock); }
+osaEventId_t OSA_EventCreate(uint8_t autoClear) { (void)autoClear; return NULL; }
+osa_status_t OSA_EventSet(osaEventId_t e, osaEventFlags_t f) { (void)e; (void)f; return 0; }
+osa_status_t OSA_EventWait(osaEventId_t e, osaEventFlags_t f, uint8_t a, uint32_t t, osaEventFlags_t *p)
+{ (void)e; (void)f; (void)a; (void)t; (void)p; return 0; }
+osaTaskId_t OSA_TaskCreate(void *d, osaTaskParam_t p) { (void)d; (void)p; return NULL; }
+uint64_t TMR_GetTimestamp(void) { return 0; }
+void panic(panicId_t id, uint32_t location, uint32_t extra1, uint32_t extra2)
+{ (void)id; (void)location; (void)extra1; (void)extra2; abort(); }
+void FLib_MemCpy(void *pDst, void *pSrc, uint32_t cBytes) { memcpy(pDst, pSrc, cBytes); }
+
+void shell_writeN(char *pBuff, uint16_t n)
+{
+    pthread_mutex_lock(&mOutLock);
+    if( mOutLen + n < sizeof(mOut) )
+    {
+        memcpy(&mOut[mOutLen], pBuff, n);
+        mOutLen += n;
+        mOut[mOutLen] = '\0';
+    }
+    pthread_mutex_unlock(&mOutLock);
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Tests
+*************************************************************************************
+********************************************************************************** */
+#define CHECK(c)    do { if( !(c) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while(0)
+
+#define mProducers_c        4
+#define mRecordsPerThread_c 20000
+
+static volatile int mProducing;
+static uint8_t mSeen[mProducers_c][mRecordsPerThread_c];
+
+static void ResetOutput(void)
+{
+    mOutLen = 0;
+    mOut[0] = '\0';
+}
+
+static void TestFormatting(void)
+{
+    ResetOutput();
+    DLOG_PRINTF("none\n");
+    DLOG_PRINTF("%u\n", 1U);
+    /* Pointers are 32 bit on the target only: no string argument on the host */
+    DLOG_PRINTF("%u %d\n", 2U, -2);
+    DLOG_PRINTF("%x %u %c\n", 0xABU, 3U, 'c');
+    DLOG_PRINTF("%u %u %u %u\n", 1U, 2U, 3U, 4U);
+    CHECK(0 == strlen(mOut));
+
+    DLOG_Flush();
+    CHECK(0 == strcmp(mOut, "none\n1\n2 -2\nab 3 c\n1 2 3 4\n"));
+    CHECK(mDLogHead == mDLogTail);
+}
+
+static void TestOverflow(void)
+{
+    uint32_t i;
+
+    ResetOutput();
+    for( i = 0; i < gDLogBufferEntries_c + 3; i++ )
+    {
+        DLOG_PRINTF("%u\n", i);
+    }
+    CHECK(3 == DLOG_GetDroppedCount());
+
+    DLOG_Flush();
+    CHECK(NULL != strstr(mOut, "\n63\n\r\n[dlog] 3 records dropped\r\n"));
+    CHECK(NULL == strstr(mOut, "\n64\n"));
+
+    /* The report is only printed once */
+    ResetOutput();
+    DLOG_Flush();
+    CHECK(0 == mOutLen);
+}
+
+static void TestUncommitted(void)
+{
+    uint32_t index;
+
+    ResetOutput();
+    CHECK(DLOG_Reserve(&index));
+    DLOG_PRINTF("after\n");
+
+    /* A reserved record holds back the ones stored after it */
+    DLOG_Flush();
+    CHECK(0 == mOutLen);
+
+    maDLogRing[index & mDLogIndexMask_c].pFormat = "before\n";
+    maDLogRing[index & mDLogIndexMask_c].nArgs = 0;
+    maDLogRing[index & mDLogIndexMask_c].committed = TRUE;
+    DLOG_Flush();
+    CHECK(0 == strcmp(mOut, "before\nafter\n"));
+}
+
+static void *Producer(void *param)
+{
+    uint32_t id = (uint32_t)(uintptr_t)param;
+    uint32_t i;
+
+    for( i = 0; i < mRecordsPerThread_c; i++ )
+    {
+        DLOG_PRINTF("%u %u\n", id, i);
+
+        /* Let the consumers run, otherwise nearly every record is dropped */
+        if( 0 == (i % 16) )
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *DrainTask(void *param)
+{
+    (void)param;
+
+    while( mProducing )
+    {
+        DLOG_Drain();
+    }
+    return NULL;
+}
+
+static void *Flusher(void *param)
+{
+    (void)param;
+
+    while( mProducing )
+    {
+        DLOG_Flush();
+    }
+    return NULL;
+}
+
+/* Flush and the drain task race on the same records: each must be output once */
+static void TestConcurrentFlush(void)
+{
+    pthread_t producers[mProducers_c];
+    pthread_t drain, flusher;
+    uint32_t dropped = DLOG_GetDroppedCount();
+    uint32_t delivered = 0;
+    uint32_t id, seq;
+    char *pLine;
+    uintptr_t i;
+
+    ResetOutput();
+    mProducing = 1;
+    pthread_create(&drain, NULL, DrainTask, NULL);
+    pthread_create(&flusher, NULL, Flusher, NULL);
+    for( i = 0; i < mProducers_c; i++ )
+    {
+        pthread_create(&producers[i], NULL, Producer, (void *)i);
+    }
+
+    for( i = 0; i < mProducers_c; i++ )
+    {
+        pthread_join(producers[i], NULL);
+    }
+    mProducing = 0;
+    pthread_join(drain, NULL);
+    pthread_join(flusher, NULL);
+    DLOG_Flush();
+
+    CHECK(mDLogHead == mDLogTail);
+    dropped = DLOG_GetDroppedCount() - dropped;
+
+    for( pLine = mOut; *pLine; pLine = strchr(pLine, '\n') + 1 )
+    {
+        if( 2 == sscanf(pLine, "%u %u", &id, &seq) )
+        {
+            CHECK((id < mProducers_c) && (seq < mRecordsPerThread_c));
+            CHECK(0 == mSeen[id][seq]);
+            mSeen[id][seq] = 1;
+            delivered++;
+        }
+        if( NULL == strchr(pLine, '\n') )
+        {
+            break;
+        }
+    }
+
+    CHECK(delivered + dropped == mProducers_c * mRecordsPerThread_c);
+    printf("concurrent: %u delivered, %u dropped\n", delivered, dropped);
+}
+
+int main(void)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mIrqLock, &attr);
+
+    TestFormatting();
+    TestOverflow();
+    TestUncommitted();
+    TestConcurrentFlush();
+
+    printf("DeferredLog: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,6 @@
+/* Host build stub */
+#ifndef __TIMERS_MANAGER_H__
+#define __TIMERS_MANAGER_H__
+#include <stdint.h>
+uint64_t TMR_GetTimestamp(void);
+#endif
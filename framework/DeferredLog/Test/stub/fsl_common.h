@@ -0,0 +1,6 @@
+/* Host build stub: the real header selects the Cortex-M intrinsics */
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+#include <stdint.h>
+#include <stddef.h>
+#endif
@@ -0,0 +1,24 @@
+/* Host build stub: interrupt masking is a recursive mutex shared by all threads */
+#ifndef _FSL_OS_ABSTRACTION_H_
+#define _FSL_OS_ABSTRACTION_H_
+#include <stdint.h>
+
+typedef void *osaTaskParam_t;
+typedef void *osaTaskId_t;
+typedef void *osaEventId_t;
+typedef uint32_t osaEventFlags_t;
+typedef uint32_t osa_status_t;
+
+#define osaEventFlagsAll_c      ((osaEventFlags_t)(0x00FFFFFF))
+#define OSA_PRIORITY_IDLE       (6)
+#define OSA_TASK_DEFINE(name, priority, instances, stackSz, useFloat)
+#define OSA_TASK(name)          NULL
+
+void OSA_InterruptDisable(void);
+void OSA_InterruptEnable(void);
+osaEventId_t OSA_EventCreate(uint8_t autoClear);
+osa_status_t OSA_EventSet(osaEventId_t eventId, osaEventFlags_t flagsToSet);
+osa_status_t OSA_EventWait(osaEventId_t eventId, osaEventFlags_t flagsToWait, uint8_t waitAll,
+                           uint32_t millisec, osaEventFlags_t *pSetFlags);
+osaTaskId_t OSA_TaskCreate(void *thread_def, osaTaskParam_t task_param);
+#endif
@@ -0,0 +1,6 @@
+/* Host build stub */
+#ifndef _SHELL_H_
+#define _SHELL_H_
+#include <stdint.h>
+void shell_writeN(char *pBuff, uint16_t n);
+#endif
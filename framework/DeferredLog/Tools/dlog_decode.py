@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+#
+# Copyright 2018 NXP
+# All rights reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Host decoder for the deferred logging module (DeferredLog.c, gDLogOutputFsci_d = 1).
+#
+# The target only sends the flash address of the format string, a timestamp and the
+# raw 32 bit arguments. This tool reads the strings back from the ELF image that was
+# flashed and prints the formatted log.
+#
+# usage: dlog_decode.py <image.axf> <capture.bin> [--len1]
+#   capture.bin  raw bytes captured from the FSCI logging interface
+#   --len1       FSCI length field has 1 byte (gFsciLenHas2Bytes_c = 0)
+
+import re
+import struct
+import sys
+
+FSCI_STX = 0x02
+FSCI_LOGGING_OG = 0xB0
+DLOG_OPCODE = 0x02
+
+SHT_PROGBITS = 1
+SHF_ALLOC = 0x2
+
+
+class ElfImage(object):
+    """Minimal little endian ELF32 reader: maps target addresses to file contents."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1:
+            raise ValueError('%s is not an ELF32 file' % path)
+        (shoff,) = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (name, stype, flags, addr, offset, size) = struct.unpack_from(
+                '<IIIIII', self.data, shoff + i * shentsize)
+            if stype == SHT_PROGBITS and (flags & SHF_ALLOC) and size:
+                self.sections.append((addr, offset, size))
+
+    def string_at(self, addr):
+        for (start, offset, size) in self.sections:
+            if start <= addr < start + size:
+                pos = offset + addr - start
+                end = self.data.index(b'\0', pos)
+                return self.data[pos:end].decode('latin-1')
+        return '<bad string @0x%08X>' % addr
+
+
+SPEC = re.compile(r'%([-+ #0]*)(\d*|\*)(?:\.(\d+))?(hh|h|ll|l|z)?([diouxXcspf%])')
+
+
+def format_record(elf, fmt, args):
+    args = list(args)
+
+    def repl(m):
+        flags, width, prec, _, conv = m.groups()
+        if conv == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        if conv == 's':
+            value = elf.string_at(value)
+        elif conv in 'di':
+            value = struct.unpack('<i', struct.pack('<I', value))[0]
+        elif conv == 'p':
+            return '0x%08X' % value
+        elif conv == 'c':
+            value = chr(value & 0xFF)
+        spec = '%' + flags + width + ('.' + prec if prec else '') + ('d' if conv in 'iu' else conv)
+        return spec % value
+
+    return SPEC.sub(repl, fmt)
+
+
+def fsci_frames(raw, len_size):
+    i = 0
+    while i < len(raw):
+        if raw[i] != FSCI_STX:
+            i += 1
+            continue
+        hdr = 3 + len_size
+        if i + hdr > len(raw):
+            break
+        og, oc = raw[i + 1], raw[i + 2]
+        length = raw[i + 3] if len_size == 1 else struct.unpack_from('<H', raw, i + 3)[0]
+        end = i + hdr + length
+        if end >= len(raw):
+            break
+        checksum = 0
+        for b in raw[i + 1:end]:
+            checksum ^= b
+        if checksum != raw[end]:
+            i += 1
+            continue
+        yield og, oc, raw[i + hdr:end]
+        i = end + 1
+
+
+def main(argv):
+    if len(argv) < 3:
+        sys.stderr.write(__doc__ or 'usage: dlog_decode.py <image.axf> <capture.bin> [--len1]\n')
+        return 1
+    elf = ElfImage(argv[1])
+    with open(argv[2], 'rb') as f:
+        raw = bytearray(f.read())
+    len_size = 1 if '--len1' in argv[3:] else 2
+
+    for og, oc, payload in fsci_frames(raw, len_size):
+        if og != FSCI_LOGGING_OG or oc != DLOG_OPCODE or len(payload) < 9:
+            continue
+        fmt_addr, timestamp, nargs = struct.unpack_from('<IIB', payload, 0)
+        args = struct.unpack_from('<%dI' % nargs, payload, 9)
+        text = format_record(elf, elf.string_at(fmt_addr), args)
+        sys.stdout.write('[%10.3f] %s\n' % (timestamp / 1000000.0, text.strip('\r\n')))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -48,31 +48,55 @@
  * Private macros
  *****************************************************************************
  *****************************************************************************/
-#if (PGM_SIZE_BYTE == 4)
-#define mProgBuffSizeInPgmWrUnits_c  16
-#elif (PGM_SIZE_BYTE == 8)
-#define mProgBuffSizeInPgmWrUnits_c  8
-#else
-#define mProgBuffSizeInPgmWrUnits_c  4
-#endif
-
 /* Generator for CRC calculations. */
 #define POLGEN  0x1021              
+
+/* Flash queue operations */
+#define mFAOpProgram_c          0
+#define mFAOpErase_c            1
+
+/* No program unit is being assembled */
+#define mFANoPhrase_c           0xFFFFFFFFUL
 /*! *********************************************************************************
 *************************************************************************************
 * Private type definitions
 *************************************************************************************
 ********************************************************************************** */
+/*! Program or erase request of the flash queue */
+typedef struct nvFlashOp_tag
+{
+    uint32_t          dest;
+    uint32_t          size;
+    uint8_t*          pData;
+    nvFlashCallback_t pfCallback;
+    void*             pParam;
+    uint8_t           type;
+}nvFlashOp_t;
+
+/*! Completion of a blocking request */
+typedef struct nvFlashSync_tag
+{
+    volatile bool_t   done;
+    uint32_t          status;
+}nvFlashSync_t;
 
 /*! *********************************************************************************
 *************************************************************************************
 * Private prototypes
 *************************************************************************************
 ********************************************************************************** */
-static uint32_t NV_FlashProgramAdaptation(uint32_t dest, uint32_t size, uint8_t* pData);
 static uint8_t  NV_VerifyCrcOverHWParameters(hardwareParameters_t* pHwParams);
 static uint16_t NV_ComputeCrcOverHWParameters(hardwareParameters_t* pHwParams);
 static void NV_Flash_WaitForCSEndAndDisableInterrupts(void);
+static void NV_Flash_WakeWaiters(void);
+static void NV_Flash_WaitForProgress(void);
+static bool_t NV_Flash_Enqueue(nvFlashOp_t* pOp);
+static uint32_t NV_Flash_Submit(nvFlashOp_t* pOp);
+static void NV_Flash_SyncDone(uint32_t status, void* pParam);
+static void NV_Flash_Complete(uint8_t count, uint32_t status);
+static bool_t NV_Flash_RunCommand(uint8_t type, uint32_t dest, uint32_t* pStatus);
+static bool_t NV_Flash_FlushPhrase(void);
+static bool_t NV_Flash_Step(void);
 /*! *********************************************************************************
 *************************************************************************************
 * Public memory declarations
@@ -89,6 +113,18 @@ static osaSemaphoreId_t       mFlashAdapterSemaphoreId;
 #endif
 static volatile uint8_t mFA_CSFlag = 0;
 static volatile uint8_t mFA_SemWaitCount = 0;
+
+/* Flash queue. The requests are run in order by a single owner; the first
+   mFA_QueueDone ones are fully copied to the program unit being assembled,
+   and complete once it is programmed. */
+static nvFlashOp_t      maFA_Queue[gNvFlashQueueSize_c];
+static volatile uint8_t mFA_QueueHead = 0;
+static volatile uint8_t mFA_QueueCount = 0;
+static volatile uint8_t mFA_QueueOwned = 0;
+static uint8_t          mFA_QueueDone = 0;
+static uint32_t         mFA_OpOffset = 0;
+static uint32_t         maFA_Phrase[PGM_SIZE_BYTE / sizeof(uint32_t)];
+static uint32_t         mFA_PhraseAddr = mFANoPhrase_c;
 /*****************************************************************************
  *****************************************************************************
  * Private functions
@@ -141,49 +177,305 @@ static void NV_Flash_WaitForCSEndAndDisableInterrupts(void)
 #endif    
 }
 /*! *********************************************************************************
- * \brief  Write alligned data to FLASH
+ * \brief  Wakes up the tasks blocked in NV_Flash_WaitForProgress()
  *
- * \param[in] dest        The address of the Flash location
- * \param[in] size        The number of bytes to be programed
- * \param[in] pData       Pointer to the data to be programmed to Flash
+ * \param[in] none
+ * \return nothing
  *
- * \return error code
+********************************************************************************** */
+static void NV_Flash_WakeWaiters(void)
+{
+#if (USE_RTOS)
+    while(1)
+    {
+        OSA_InterruptDisable();
+
+        if(mFA_SemWaitCount == 0)
+        {
+            break;
+        }
+        mFA_SemWaitCount--;
+        OSA_InterruptEnable();
+        OSA_SemaphorePost(mFlashAdapterSemaphoreId);
+    }
+    OSA_InterruptEnable();
+#endif
+}
+
+/*! *********************************************************************************
+ * \brief  Blocks until the critical section ends or another task releases the queue.
+ *         Returns at once if neither holds the queue.
+ *
+ * \param[in] none
+ * \return nothing
  *
 ********************************************************************************** */
-static uint32_t NV_FlashProgramAdaptation(uint32_t dest, uint32_t size, uint8_t* pData)
+static void NV_Flash_WaitForProgress(void)
 {
-  uint32_t status = kStatus_FLASH_Success;
-  if( ((uint32_t)pData)%sizeof(uint32_t) == 0)
-  {
-    status = FLASH_Program(&gFlashConfig,dest, (uint32_t*) pData, size);    
+#if (USE_RTOS)
+#if (gNvStorageIncluded_d)
+    /* NvIdle runs on a freeRTOS idle task hook which must never block. Since it
+       has the least priority in the system, it can poll instead */
+    if(OSA_TaskGetId() == (osaTaskId_t)NvGetNvIdleTaskId())
+    {
+        while(mFA_CSFlag || mFA_QueueOwned);
+        return;
+    }
+#endif
+    OSA_InterruptDisable();
+    if(mFA_CSFlag || mFA_QueueOwned)
+    {
+        mFA_SemWaitCount++;
+        OSA_InterruptEnable();
+        OSA_SemaphoreWait(mFlashAdapterSemaphoreId, osaWaitForever_c);
+    }
+    else
+    {
+        OSA_InterruptEnable();
+    }
+#endif
+}
+
+/*! *********************************************************************************
+ * \brief  Adds a request at the end of the flash queue
+ *
+ * \param[in] pOp  request, copied
+ * \return FALSE if the queue is full
+ *
+********************************************************************************** */
+static bool_t NV_Flash_Enqueue(nvFlashOp_t* pOp)
+{
+    bool_t status = FALSE;
+
+    OSA_InterruptDisable();
+    if(mFA_QueueCount < gNvFlashQueueSize_c)
+    {
+        FLib_MemCpy(&maFA_Queue[(mFA_QueueHead + mFA_QueueCount) % gNvFlashQueueSize_c], pOp, sizeof(nvFlashOp_t));
+        mFA_QueueCount++;
+        status = TRUE;
+    }
+    OSA_InterruptEnable();
     return status;
-  }
-  if( (size & (PGM_SIZE_BYTE - 0x01U)) != 0 )
-  {
-    return kStatus_FLASH_AlignmentError;
-  }
-  {
-    uint32_t progBuf[PGM_SIZE_BYTE * mProgBuffSizeInPgmWrUnits_c / 4];
-    uint32_t progSize;
-    while(size)
-    {
-      progSize = PGM_SIZE_BYTE * mProgBuffSizeInPgmWrUnits_c;
-      if(progSize > size)
-      {
-        progSize = size;
-      }
-      FLib_MemCpy (progBuf, pData, progSize);
-      status = FLASH_Program(&gFlashConfig,dest, progBuf, progSize);
-      if(status != kStatus_FLASH_Success)
-      {
-        break;
-      }
-      pData += progSize;
-      size -= progSize;
-      dest += progSize;
-    }  
-  }
-  return status;
+}
+
+/*! *********************************************************************************
+ * \brief  Queues a request and drains the queue until the request is done
+ *
+ * \param[in] pOp  request, its callback is overwritten
+ * \return error code
+ *
+********************************************************************************** */
+static uint32_t NV_Flash_Submit(nvFlashOp_t* pOp)
+{
+    nvFlashSync_t sync;
+
+    sync.done = FALSE;
+    sync.status = kStatus_FLASH_Success;
+    pOp->pfCallback = NV_Flash_SyncDone;
+    pOp->pParam = &sync;
+
+    while(!NV_Flash_Enqueue(pOp))
+    {
+        NV_FlashProcessQueue();
+        NV_Flash_WaitForProgress();
+    }
+
+    while(!sync.done)
+    {
+        NV_FlashProcessQueue();
+        if(!sync.done)
+        {
+            NV_Flash_WaitForProgress();
+        }
+    }
+    return sync.status;
+}
+
+/*! *********************************************************************************
+ * \brief  Completion callback of the blocking requests
+ *
+********************************************************************************** */
+static void NV_Flash_SyncDone(uint32_t status, void* pParam)
+{
+    ((nvFlashSync_t*)pParam)->status = status;
+    ((nvFlashSync_t*)pParam)->done = TRUE;
+}
+
+/*! *********************************************************************************
+ * \brief  Removes requests from the head of the queue and calls their callbacks
+ *
+ * \param[in] count   number of requests
+ * \param[in] status  completion status
+ * \return nothing
+ *
+********************************************************************************** */
+static void NV_Flash_Complete(uint8_t count, uint32_t status)
+{
+    nvFlashOp_t op;
+
+    while(count--)
+    {
+        /* The slot may be reused as soon as it is released */
+        FLib_MemCpy(&op, &maFA_Queue[mFA_QueueHead], sizeof(nvFlashOp_t));
+        OSA_InterruptDisable();
+        mFA_QueueHead = (mFA_QueueHead + 1) % gNvFlashQueueSize_c;
+        mFA_QueueCount--;
+        OSA_InterruptEnable();
+
+        if(op.pfCallback)
+        {
+            op.pfCallback(status, op.pParam);
+        }
+    }
+}
+
+/*! *********************************************************************************
+ * \brief  Runs one flash command: programs maFA_Phrase or erases one sector.
+ *         The interrupts are disabled for this command only.
+ *
+ * \param[in]  type     mFAOpProgram_c or mFAOpErase_c
+ * \param[in]  dest     address of the program unit or of the sector
+ * \param[out] pStatus  error code of the command
+ * \return FALSE if a critical section is on and the command was not run
+ *
+********************************************************************************** */
+static bool_t NV_Flash_RunCommand(uint8_t type, uint32_t dest, uint32_t* pStatus)
+{
+    OSA_InterruptDisable();
+    if(mFA_CSFlag)
+    {
+        OSA_InterruptEnable();
+        return FALSE;
+    }
+#if !gNvDisableIntCmdSeq_c
+    OSA_InterruptEnable();
+#endif
+    if(mFAOpErase_c == type)
+    {
+        *pStatus = FLASH_Erase(&gFlashConfig, dest, P_SECTOR_SIZE, kFLASH_ApiEraseKey);
+    }
+    else
+    {
+        *pStatus = FLASH_Program(&gFlashConfig, dest, (void*)maFA_Phrase, PGM_SIZE_BYTE);
+    }
+#if gNvDisableIntCmdSeq_c
+    OSA_InterruptEnable();
+#endif
+    return TRUE;
+}
+
+/*! *********************************************************************************
+ * \brief  Programs the unit being assembled and completes the requests it ends
+ *
+ * \param[in] none
+ * \return FALSE if a critical section is on
+ *
+********************************************************************************** */
+static bool_t NV_Flash_FlushPhrase(void)
+{
+    uint32_t status;
+    uint8_t  count = mFA_QueueDone;
+
+    if(!NV_Flash_RunCommand(mFAOpProgram_c, mFA_PhraseAddr, &status))
+    {
+        return FALSE;
+    }
+    mFA_PhraseAddr = mFANoPhrase_c;
+
+    if((status != kStatus_FLASH_Success) && mFA_OpOffset)
+    {
+        /* The request being copied fails as well */
+        count++;
+        mFA_OpOffset = 0;
+    }
+    mFA_QueueDone = 0;
+    NV_Flash_Complete(count, status);
+    return TRUE;
+}
+
+/*! *********************************************************************************
+ * \brief  Advances the queue by one flash command, or by the copy of a request
+ *         into the program unit being assembled. Consecutive requests sharing
+ *         a unit are programmed with a single command.
+ *
+ * \param[in] none
+ * \return FALSE if the queue is empty or a critical section is on
+ *
+********************************************************************************** */
+static bool_t NV_Flash_Step(void)
+{
+    nvFlashOp_t* pOp;
+    uint32_t addr;
+    uint32_t phraseAddr;
+    uint32_t size;
+    uint32_t status;
+
+    if(mFA_QueueDone == mFA_QueueCount)
+    {
+        /* End of the batch */
+        return (mFA_PhraseAddr != mFANoPhrase_c) ? NV_Flash_FlushPhrase() : FALSE;
+    }
+
+    pOp = &maFA_Queue[(mFA_QueueHead + mFA_QueueDone) % gNvFlashQueueSize_c];
+    addr = pOp->dest + mFA_OpOffset;
+
+    if(pOp->type == mFAOpErase_c)
+    {
+        if(mFA_PhraseAddr != mFANoPhrase_c)
+        {
+            return NV_Flash_FlushPhrase();
+        }
+        if(!NV_Flash_RunCommand(mFAOpErase_c, addr, &status))
+        {
+            return FALSE;
+        }
+        mFA_OpOffset += P_SECTOR_SIZE;
+
+        if((status != kStatus_FLASH_Success) || (mFA_OpOffset >= pOp->size))
+        {
+            mFA_OpOffset = 0;
+            NV_Flash_Complete(1, status);
+        }
+        return TRUE;
+    }
+
+    phraseAddr = addr & ~(PGM_SIZE_BYTE - 1U);
+
+    if((mFA_PhraseAddr != mFANoPhrase_c) && (mFA_PhraseAddr != phraseAddr))
+    {
+        return NV_Flash_FlushPhrase();
+    }
+
+    size = PGM_SIZE_BYTE - (addr - phraseAddr);
+    if(size > pOp->size - mFA_OpOffset)
+    {
+        size = pOp->size - mFA_OpOffset;
+    }
+
+    if(mFA_PhraseAddr == mFANoPhrase_c)
+    {
+        if(size < PGM_SIZE_BYTE)
+        {
+            /* Keep the flash content around the request */
+            NV_FlashRead(phraseAddr, maFA_Phrase, PGM_SIZE_BYTE);
+        }
+        mFA_PhraseAddr = phraseAddr;
+    }
+
+    FLib_MemCpy((uint8_t*)maFA_Phrase + (addr - phraseAddr), pOp->pData + mFA_OpOffset, size);
+    mFA_OpOffset += size;
+
+    if(mFA_OpOffset == pOp->size)
+    {
+        mFA_OpOffset = 0;
+        mFA_QueueDone++;
+    }
+
+    if(addr + size == phraseAddr + PGM_SIZE_BYTE)
+    {
+        return NV_Flash_FlushPhrase();
+    }
+    return TRUE;
 }
 
 /*! *********************************************************************************
@@ -308,29 +600,21 @@ void
 )
 {
 #if (USE_RTOS)        
+    bool_t csEnd;
+
     OSA_InterruptDisable();
     if(mFA_CSFlag)
     {
         mFA_CSFlag--;
     }
+    csEnd = (mFA_CSFlag == 0);
     OSA_InterruptEnable();
-    while(1)
+
+    /* The tasks blocked on flash requests resume draining the queue */
+    if(csEnd)
     {
-        OSA_InterruptDisable();
-        
-        if(mFA_CSFlag)
-        {
-            break;
-        }
-        if(mFA_SemWaitCount == 0)
-        {
-            break;
-        }
-        mFA_SemWaitCount--;
-        OSA_InterruptEnable();
-        OSA_SemaphorePost(mFlashAdapterSemaphoreId);
+        NV_Flash_WakeWaiters();
     }
-    OSA_InterruptEnable();
 #endif    
 }
 
@@ -356,13 +640,12 @@ uint32_t NV_FlashVerifyErase ( uint32_t start, uint32_t lengthInBytes, flash_mar
   return status;
 }
 /*! *********************************************************************************
- * \brief  Write alligned data to FLASH
+ * \brief  Write alligned data to FLASH. The request goes through the flash queue
+ *         and the interrupts are disabled for one program unit at a time.
  *
- * \param[in] pSSDConfig  Pointer to a flash config structure
  * \param[in] dest        The address of the Flash location
  * \param[in] size        The number of bytes to be programed
  * \param[in] pData       Pointer to the data to be programmed to Flash
- * \param[in] pFlashCommandSequence  Pointer to the Flash RAM function
  *
  * \return error code
  *
@@ -371,25 +654,20 @@ uint32_t NV_FlashProgram (         uint32_t dest,
                                    uint32_t size,
                                    uint8_t* pData)
 {
-    uint32_t status;
-    #if gNvDisableIntCmdSeq_c
-        NV_Flash_WaitForCSEndAndDisableInterrupts();
-    #endif
-    status = NV_FlashProgramAdaptation(dest, size, pData);
-    #if gNvDisableIntCmdSeq_c
-        OSA_InterruptEnable();
-    #endif
-    return status;
+    if( ((dest | size) & (PGM_SIZE_BYTE - 0x01U)) != 0 )
+    {
+        return kStatus_FLASH_AlignmentError;
+    }
+    return NV_FlashProgramUnaligned(dest, size, pData);
 }
 
 /*! *********************************************************************************
- * \brief  Write data to FLASH
- * 
- * \param[in] pSSDConfig  Pointer to a flash config structure  
+ * \brief  Write data to FLASH. The program units partially covered by the data
+ *         keep their other bytes.
+ *
  * \param[in] dest        The address of the Flash location
  * \param[in] size        The number of bytes to be programed
  * \param[in] pData       Pointer to the data to be programmed to Flash
- * \param[in] pFlashCommandSequence  Pointer to the Flash RAM function
  *
  * \return error code
  *
@@ -399,101 +677,143 @@ uint32_t NV_FlashProgramUnaligned(
                                   uint32_t size,
                                   uint8_t* pData)
 {
-    uint8_t  buffer[PGM_SIZE_BYTE];
-    uint16_t bytes = dest & (PGM_SIZE_BYTE-1);
-    uint32_t status;
+    nvFlashOp_t op;
 
-    if( bytes )
+    if( (NULL == pData) || (0 == size) )
     {
-        uint16_t unalignedBytes = PGM_SIZE_BYTE - bytes;
+        return kStatus_FLASH_InvalidArgument;
+    }
 
-        if( unalignedBytes > size )
-        {
-            unalignedBytes = size;
-        }
+    op.type = mFAOpProgram_c;
+    op.dest = dest;
+    op.size = size;
+    op.pData = pData;
+    return NV_Flash_Submit(&op);
+}
 
-        FLib_MemCpy(buffer, (void*)(dest - bytes), PGM_SIZE_BYTE);
-        FLib_MemCpy(&buffer[bytes], pData, unalignedBytes);
-#if gNvDisableIntCmdSeq_c
-        NV_Flash_WaitForCSEndAndDisableInterrupts();
-#endif
-        status = NV_FlashProgramAdaptation(dest - bytes, PGM_SIZE_BYTE, buffer);
-#if gNvDisableIntCmdSeq_c
-        OSA_InterruptEnable();
-#endif
-        if( status != kStatus_FLASH_Success )
-        {
-            return status;
-        }
+/*! *********************************************************************************
+ * \brief  Erase to 0xFF one ore more FLASH sectors. The interrupts are disabled
+ *         for one sector at a time.
+ *
+ * \param[in] dest        The start address of the first sector to be erased
+ * \param[in] size        The amount of flash to be erased (multiple of sector size)
+ *
+ * \return error code
+ *
+********************************************************************************** */
+uint32_t NV_FlashEraseSector(uint32_t dest, uint32_t size)
+{
+    nvFlashOp_t op;
 
-        dest += PGM_SIZE_BYTE - bytes;
-        pData += unalignedBytes;
-        size -= unalignedBytes;
+    if( 0 == size )
+    {
+        return kStatus_FLASH_InvalidArgument;
     }
 
-    bytes = size & ~(PGM_SIZE_BYTE - 1U);
+    op.type = mFAOpErase_c;
+    op.dest = dest;
+    op.size = size;
+    op.pData = NULL;
+    return NV_Flash_Submit(&op);
+}
 
-    if( bytes )
-    {
-#if gNvDisableIntCmdSeq_c
-        NV_Flash_WaitForCSEndAndDisableInterrupts();
-#endif
-        status = NV_FlashProgramAdaptation(dest, bytes, pData);
-#if gNvDisableIntCmdSeq_c
-        OSA_InterruptEnable();
-#endif
-        if( status != kStatus_FLASH_Success )
-        {
-            return status;
-        }
+/*! *********************************************************************************
+ * \brief  Queues a FLASH program request and returns without waiting for it.
+ *         The request is run by the next NV_FlashProcessQueue() call, or by a
+ *         blocking flash call, once no critical section is on.
+ *
+ * \param[in] dest        The address of the Flash location
+ * \param[in] size        The number of bytes to be programed
+ * \param[in] pData       Pointer to the data, must stay valid until the callback
+ * \param[in] pfCallback  Called when the request is done, may be NULL
+ * \param[in] pParam      Parameter of the callback
+ *
+ * \return kStatus_Fail if the queue is full, kStatus_FLASH_Success otherwise
+ *
+********************************************************************************** */
+uint32_t NV_FlashProgramAsync(    uint32_t dest,
+                                  uint32_t size,
+                                  uint8_t* pData,
+                                  nvFlashCallback_t pfCallback,
+                                  void* pParam)
+{
+    nvFlashOp_t op;
 
-        dest  += bytes;
-        pData += bytes;
-        size  -= bytes;
-    }
-    
-    if( size )
+    if( (NULL == pData) || (0 == size) )
     {
-        FLib_MemCpy(buffer, (void*)dest, PGM_SIZE_BYTE);
-        FLib_MemCpy(buffer, pData, size);
-#if gNvDisableIntCmdSeq_c
-        NV_Flash_WaitForCSEndAndDisableInterrupts();
-#endif
-        status = NV_FlashProgramAdaptation(dest, PGM_SIZE_BYTE, buffer);
-#if gNvDisableIntCmdSeq_c
-        OSA_InterruptEnable();
-#endif
-        if( status != kStatus_FLASH_Success )
-        {
-            return status;
-        }
+        return kStatus_FLASH_InvalidArgument;
     }
-    
-    return kStatus_FLASH_Success;
+
+    op.type = mFAOpProgram_c;
+    op.dest = dest;
+    op.size = size;
+    op.pData = pData;
+    op.pfCallback = pfCallback;
+    op.pParam = pParam;
+    return NV_Flash_Enqueue(&op) ? kStatus_FLASH_Success : kStatus_Fail;
 }
 
 /*! *********************************************************************************
- * \brief  Erase to 0xFF one ore more FLASH sectors.
- * 
- * \param[in] pSSDConfig  Pointer to a flash config structure  
+ * \brief  Queues a FLASH sector erase request and returns without waiting for it.
+ *
  * \param[in] dest        The start address of the first sector to be erased
  * \param[in] size        The amount of flash to be erased (multiple of sector size)
- * \param[in] pFlashCommandSequence  Pointer to the Flash RAM function
+ * \param[in] pfCallback  Called when the request is done, may be NULL
+ * \param[in] pParam      Parameter of the callback
  *
- * \return error code
+ * \return kStatus_Fail if the queue is full, kStatus_FLASH_Success otherwise
  *
 ********************************************************************************** */
-uint32_t NV_FlashEraseSector(uint32_t dest, uint32_t size)
+uint32_t NV_FlashEraseSectorAsync(uint32_t dest,
+                                  uint32_t size,
+                                  nvFlashCallback_t pfCallback,
+                                  void* pParam)
 {
-    uint32_t status;
-#if gNvDisableIntCmdSeq_c
-    NV_Flash_WaitForCSEndAndDisableInterrupts();
-#endif
-    status = FLASH_Erase(&gFlashConfig, dest, size, kFLASH_ApiEraseKey);
-#if gNvDisableIntCmdSeq_c
+    nvFlashOp_t op;
+
+    if( 0 == size )
+    {
+        return kStatus_FLASH_InvalidArgument;
+    }
+
+    op.type = mFAOpErase_c;
+    op.dest = dest;
+    op.size = size;
+    op.pData = NULL;
+    op.pfCallback = pfCallback;
+    op.pParam = pParam;
+    return NV_Flash_Enqueue(&op) ? kStatus_FLASH_Success : kStatus_Fail;
+}
+
+/*! *********************************************************************************
+ * \brief  Runs the queued FLASH requests, to be called from task context. Only one
+ *         task drains the queue at a time, the call returns at once if another
+ *         one does. Draining stops while a critical section is on. The request
+ *         callbacks must not call the blocking FLASH functions.
+ *
+ * \param[in] none
+ * \return nothing
+ *
+********************************************************************************** */
+void NV_FlashProcessQueue(void)
+{
+    bool_t owner = FALSE;
+
+    OSA_InterruptDisable();
+    if(!mFA_QueueOwned)
+    {
+        mFA_QueueOwned = TRUE;
+        owner = TRUE;
+    }
     OSA_InterruptEnable();
-#endif
-    return status;
+
+    if(owner)
+    {
+        while(NV_Flash_Step());
+
+        mFA_QueueOwned = FALSE;
+        NV_Flash_WakeWaiters();
+    }
 }
 
 /*! *********************************************************************************
@@ -39,7 +39,17 @@
 *************************************************************************************
 ********************************************************************************** */
 #include "EmbeddedTypes.h"
+#include "fsl_device_registers.h"
+#if (FSL_FEATURE_FLASH_IS_FTFA || FSL_FEATURE_FLASH_IS_FTFE || FSL_FEATURE_FLASH_IS_FTFL)
+/* FTFx controllers (K64 FTFE) are driven by the FTFx flash driver, fsl_flash.c is the FTMRx one */
+#include "fsl_ftfx_flash.h"
+/* fsl_flash.h names used by the adapter and its users */
+#define kStatus_FLASH_AlignmentError    kStatus_FTFx_AlignmentError
+#define kStatus_FLASH_InvalidArgument   kStatus_FTFx_InvalidArgument
+typedef ftfx_margin_value_t flash_margin_value_t;
+#else
 #include "fsl_flash.h"
+#endif
 
 
 /*! *********************************************************************************
@@ -66,6 +76,17 @@
 #define gNvDisableIntCmdSeq_c           (1)
 #endif
 
+/*
+ * Name: gNvFlashQueueSize_c
+ * Description: number of program/erase requests that can wait in the flash
+ *              operation queue. The blocking calls use one entry each while
+ *              they wait; NV_FlashProgramAsync() and NV_FlashEraseSectorAsync()
+ *              fail when the queue is full.
+ */
+#ifndef gNvFlashQueueSize_c
+#define gNvFlashQueueSize_c             (8)
+#endif
+
 /* size of array to copy__Launch_Command function to.*/
 /* It should be at least equal to actual size of __Launch_Command func */
 /* User can change this value based on RAM size availability and actual size of __Launch_Command function */
@@ -116,6 +137,10 @@ typedef PACKED_STRUCT hardwareParameters_tag
     uint16_t hardwareParamsCrc;        /* crc for data between start of reserved area and start of hardwareParamsCrc field (not included). */ 
 }hardwareParameters_t;
 
+/*! Completion of a queued flash request, called from the context that drains the
+ *  queue with the status of the first failed command, or kStatus_FLASH_Success */
+typedef void (*nvFlashCallback_t)(uint32_t status, void *pParam);
+
 /*! *********************************************************************************
 *************************************************************************************
 * Public memory declarations
@@ -143,6 +168,19 @@ uint32_t NV_FlashEraseSector(     uint32_t dest,
                                   uint32_t size);
 uint32_t NV_FlashVerifyErase ( uint32_t start, uint32_t lengthInBytes, flash_margin_value_t margin);
 
+uint32_t NV_FlashProgramAsync(    uint32_t dest,
+                                  uint32_t size,
+                                  uint8_t* pData,
+                                  nvFlashCallback_t pfCallback,
+                                  void* pParam);
+
+uint32_t NV_FlashEraseSectorAsync(uint32_t dest,
+                                  uint32_t size,
+                                  nvFlashCallback_t pfCallback,
+                                  void* pParam);
+
+void NV_FlashProcessQueue(void);
+
 uint32_t NV_ReadHWParameters(hardwareParameters_t *pHwParams);
 
 uint32_t NV_WriteHWParameters(hardwareParameters_t *pHwParams);
@@ -0,0 +1,482 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file FlashTest.c
+* Host test for the internal flash adapter queue. The adapter source is built in
+* over a simulated FTFE: a command programs one phrase or erases one sector, and
+* takes the data sheet maximum time (145 us per phrase, 114 ms per sector). The
+* time advances only in the flash commands, so the longest interrupts-off
+* interval is the worst-case latency an ISR sees during NV writes.
+*
+* Each request size is measured against the time of the whole request, which is
+* what the interrupts were held off for when the adapter disabled them per
+* request. A random mix of blocking, queued and critical-section calls is then
+* checked against a reference model of the flash, with at most one flash command
+* per interrupts-off interval.
+*
+* Build and run with "make" from this directory.
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "../Internal/Flash_Adapter.c"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Simulated FTFE and interrupt mask
+*************************************************************************************
+********************************************************************************** */
+#define CHECK(c)    do { if( !(c) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while(0)
+
+#define mPhraseUs_c     145
+#define mEraseUs_c      114000
+#define mSectors_c      4
+#define mFlashSize_c    (mSectors_c * P_SECTOR_SIZE)
+
+uint32_t FREESCALE_PROD_DATA_BASE_ADDR[P_SECTOR_SIZE / sizeof(uint32_t)];
+
+/* The adapter reads the flash through its 32-bit address */
+static uint8_t *mpFlash;
+static uint32_t mFlashBase;
+
+static uint64_t mNowUs;
+static uint32_t mCommands;
+
+static uint32_t mIntDisableNest;
+static uint64_t mIntOffAt;
+static uint64_t mIntOffMax;
+static uint32_t mCommandsWhileOff;
+
+/* ISR made pending by the mIsrAtCommand-th command, run when the interrupts are enabled again */
+static uint32_t mIsrAtCommand;
+static void (*mpIsr)(void);
+static void (*mpPendingIsr)(void);
+
+static uint32_t mSemCount;
+static uint32_t mSemWaits;
+
+void FLib_MemCpy(void *pDst, void *pSrc, uint32_t cBytes) { memmove(pDst, pSrc, cBytes); }
+void FLib_MemSet(void *pDst, uint8_t value, uint32_t cBytes) { memset(pDst, value, cBytes); }
+bool_t FLib_MemCmp(void *pData1, void *pData2, uint32_t cBytes) { return 0 == memcmp(pData1, pData2, cBytes); }
+void panic(panicId_t id, uint32_t location, uint32_t extra1, uint32_t extra2) { abort(); }
+
+void OSA_InterruptDisable(void)
+{
+    if( 0 == mIntDisableNest++ )
+    {
+        mIntOffAt = mNowUs;
+        mCommandsWhileOff = 0;
+    }
+}
+
+void OSA_InterruptEnable(void)
+{
+    CHECK(mIntDisableNest > 0);
+    if( 0 == --mIntDisableNest )
+    {
+        if( mNowUs - mIntOffAt > mIntOffMax )
+        {
+            mIntOffMax = mNowUs - mIntOffAt;
+        }
+        if( mpPendingIsr )
+        {
+            void (*pIsr)(void) = mpPendingIsr;
+
+            mpPendingIsr = NULL;
+            pIsr();
+        }
+    }
+}
+
+osaTaskId_t OSA_TaskGetId(void) { return NULL; }
+osaSemaphoreId_t OSA_SemaphoreCreate(uint32_t initValue) { mSemCount = initValue; return &mSemCount; }
+
+osaStatus_t OSA_SemaphorePost(osaSemaphoreId_t semId)
+{
+    mSemCount++;
+    return osaStatus_Success;
+}
+
+/* A single task only waits for a critical section: the task holding it ends it meanwhile */
+osaStatus_t OSA_SemaphoreWait(osaSemaphoreId_t semId, uint32_t millisec)
+{
+    CHECK(0 == mIntDisableNest);
+    mSemWaits++;
+    if( 0 == mSemCount )
+    {
+        CHECK(mFA_CSFlag);
+        while( mFA_CSFlag )
+        {
+            NV_Flash_ClearCriticalSection();
+        }
+    }
+    CHECK(mSemCount > 0);
+    mSemCount--;
+    return osaStatus_Success;
+}
+
+static void Command(uint32_t durationUs)
+{
+    /* One command per interrupts-off interval, never during a critical section */
+    CHECK(mIntDisableNest > 0);
+    CHECK(++mCommandsWhileOff == 1);
+    CHECK(0 == mFA_CSFlag);
+    mNowUs += durationUs;
+    if( ++mCommands == mIsrAtCommand )
+    {
+        mpPendingIsr = mpIsr;
+    }
+}
+
+status_t FLASH_Init(flash_config_t *config) { return kStatus_FTFx_Success; }
+
+status_t FLASH_Erase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, uint32_t key)
+{
+    CHECK(kFLASH_ApiEraseKey == key);
+    CHECK(P_SECTOR_SIZE == lengthInBytes);
+    CHECK(start >= mFlashBase && start < mFlashBase + mFlashSize_c && 0 == (start - mFlashBase) % P_SECTOR_SIZE);
+    Command(mEraseUs_c);
+    memset(&mpFlash[start - mFlashBase], 0xFF, P_SECTOR_SIZE);
+    return kStatus_FTFx_Success;
+}
+
+status_t FLASH_Program(flash_config_t *config, uint32_t start, uint8_t *src, uint32_t lengthInBytes)
+{
+    uint8_t *pDst = &mpFlash[start - mFlashBase];
+    uint32_t i;
+
+    CHECK(PGM_SIZE_BYTE == lengthInBytes);
+    CHECK(start >= mFlashBase && start < mFlashBase + mFlashSize_c && 0 == start % PGM_SIZE_BYTE);
+    Command(mPhraseUs_c);
+    for( i = 0; i < lengthInBytes; i++ )
+    {
+        /* Programming only clears bits */
+        CHECK((pDst[i] & src[i]) == src[i]);
+        pDst[i] = src[i];
+    }
+    return kStatus_FTFx_Success;
+}
+
+status_t FLASH_VerifyErase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, ftfx_margin_value_t margin)
+{
+    return kStatus_FTFx_Success;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Helpers
+*************************************************************************************
+********************************************************************************** */
+/* Expected flash content */
+static uint8_t maModel[mFlashSize_c];
+
+static uint32_t mCallbacks;
+static uint32_t mCallbackOrder;
+
+static void Reset(void)
+{
+    memset(mpFlash, 0xFF, mFlashSize_c);
+    memset(maModel, 0xFF, sizeof(maModel));
+    mIntOffMax = 0;
+    mCommands = 0;
+    mIsrAtCommand = 0;
+}
+
+static void ModelProgram(uint32_t offset, uint32_t size, const uint8_t *pData)
+{
+    memcpy(&maModel[offset], pData, size);
+}
+
+static void ModelErase(uint32_t offset, uint32_t size)
+{
+    memset(&maModel[offset], 0xFF, size);
+}
+
+static bool_t ModelErased(uint32_t offset, uint32_t size)
+{
+    while( size-- )
+    {
+        if( 0xFF != maModel[offset++] )
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void Fill(uint8_t *pData, uint32_t size)
+{
+    while( size-- )
+    {
+        *pData++ = (uint8_t)rand();
+    }
+}
+
+static void Callback(uint32_t status, void *pParam)
+{
+    CHECK(kStatus_FLASH_Success == status);
+    /* In queue order */
+    CHECK((uintptr_t)pParam == mCallbackOrder++);
+    mCallbacks++;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Tests
+*************************************************************************************
+********************************************************************************** */
+/* Longest interrupts-off interval of one blocking request, against its duration */
+static void Measure(const char *pName, uint32_t offset, uint32_t size, bool_t erase)
+{
+    static uint8_t data[mFlashSize_c];
+    uint64_t start;
+
+    Reset();
+    start = mNowUs;
+    if( erase )
+    {
+        memset(mpFlash, 0, mFlashSize_c);
+        memset(maModel, 0, sizeof(maModel));
+        CHECK(kStatus_FLASH_Success == NV_FlashEraseSector(mFlashBase + offset, size));
+        ModelErase(offset, size);
+    }
+    else
+    {
+        Fill(data, size);
+        CHECK(kStatus_FLASH_Success == NV_FlashProgramUnaligned(mFlashBase + offset, size, data));
+        ModelProgram(offset, size, data);
+    }
+    CHECK(0 == memcmp(mpFlash, maModel, mFlashSize_c));
+    CHECK(mIntOffMax == (erase ? mEraseUs_c : mPhraseUs_c));
+
+    printf("  %-16s %8u us %8u us %6u\n", pName, (unsigned)(mNowUs - start), (unsigned)mIntOffMax,
+           (unsigned)mCommands);
+}
+
+static void TestLatency(void)
+{
+    printf("request             duration  ints off  commands\n");
+    Measure("program 264 B", 0, 264, FALSE);
+    Measure("program 1 KB", 0, 1024, FALSE);
+    Measure("program 4 KB", 0, 4096, FALSE);
+    Measure("unaligned 90 B", 13, 90, FALSE);
+    Measure("sector erase", P_SECTOR_SIZE, P_SECTOR_SIZE, TRUE);
+    Measure("2 sector erase", 0, 2 * P_SECTOR_SIZE, TRUE);
+}
+
+/* Queued records sharing program units are merged into one command per unit */
+static void TestBatching(void)
+{
+    static uint8_t records[8][12];
+    uint32_t i;
+
+    Reset();
+    mCallbacks = 0;
+    mCallbackOrder = 0;
+    for( i = 0; i < 8; i++ )
+    {
+        Fill(records[i], sizeof(records[i]));
+        CHECK(kStatus_FLASH_Success == NV_FlashProgramAsync(mFlashBase + i * 12, 12, records[i], Callback,
+                                                            (void *)(uintptr_t)i));
+        ModelProgram(i * 12, 12, records[i]);
+    }
+    /* The queue is full */
+    CHECK(kStatus_Fail == NV_FlashProgramAsync(mFlashBase + 96, 12, records[0], NULL, NULL));
+    CHECK(0 == mCommands);
+
+    NV_FlashProcessQueue();
+    CHECK(8 == mCallbacks);
+    CHECK(0 == memcmp(mpFlash, maModel, mFlashSize_c));
+    /* 96 bytes, 12 phrases; 16 commands if each record was programmed on its own */
+    CHECK(12 == mCommands);
+    CHECK(mIntOffMax == mPhraseUs_c);
+}
+
+static void IsrEntersCriticalSection(void)
+{
+    NV_Flash_SetCriticalSection();
+}
+
+/* No flash command while a critical section is on, queued or blocking */
+static void TestCriticalSection(void)
+{
+    static uint8_t data[256];
+    uint32_t waits;
+
+    Reset();
+    mCallbacks = 0;
+    mCallbackOrder = 0;
+    Fill(data, sizeof(data));
+    NV_Flash_SetCriticalSection();
+    CHECK(kStatus_FLASH_Success == NV_FlashProgramAsync(mFlashBase, sizeof(data), data, Callback, (void *)0));
+    ModelProgram(0, sizeof(data), data);
+    NV_FlashProcessQueue();
+    CHECK(0 == mCommands);
+    NV_Flash_ClearCriticalSection();
+    NV_FlashProcessQueue();
+    CHECK(1 == mCallbacks);
+    CHECK(0 == memcmp(mpFlash, maModel, mFlashSize_c));
+
+    /* An ISR enters a critical section during the 5th command: draining stops after it */
+    mpIsr = IsrEntersCriticalSection;
+    mIsrAtCommand = mCommands + 5;
+    CHECK(kStatus_FLASH_Success == NV_FlashProgramAsync(mFlashBase + 1024, sizeof(data), data, Callback, (void *)1));
+    ModelProgram(1024, sizeof(data), data);
+    NV_FlashProcessQueue();
+    CHECK(mFA_CSFlag);
+    CHECK(mIsrAtCommand == mCommands);
+    CHECK(1 == mCallbacks);
+    NV_Flash_ClearCriticalSection();
+    NV_FlashProcessQueue();
+    CHECK(2 == mCallbacks);
+    CHECK(0 == memcmp(mpFlash, maModel, mFlashSize_c));
+
+    /* Same during a blocking call: the caller waits for the end of the critical section */
+    waits = mSemWaits;
+    mIsrAtCommand = mCommands + 3;
+    CHECK(kStatus_FLASH_Success == NV_FlashProgram(mFlashBase + 2048, sizeof(data), data));
+    ModelProgram(2048, sizeof(data), data);
+    CHECK(mSemWaits == waits + 1);
+    CHECK(0 == mFA_CSFlag);
+    CHECK(0 == memcmp(mpFlash, maModel, mFlashSize_c));
+    mpIsr = NULL;
+}
+
+/* Random blocking, queued and critical-section calls against the model */
+static void TestFuzz(uint32_t seed, uint32_t ops)
+{
+    static uint8_t buffers[gNvFlashQueueSize_c + 1][300];
+    uint32_t next = 0;
+    uint32_t sector;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t i;
+
+    srand(seed);
+    Reset();
+    mpIsr = IsrEntersCriticalSection;
+    mCallbacks = 0;
+    mSemWaits = 0;
+    mCallbackOrder = 0;
+    for( i = 0; i < ops; i++ )
+    {
+        uint32_t action = rand() % 100;
+        uint8_t *pData = buffers[next % (gNvFlashQueueSize_c + 1)];
+
+        sector = rand() % mSectors_c;
+        size = 1 + rand() % sizeof(buffers[0]);
+        offset = sector * P_SECTOR_SIZE + rand() % (P_SECTOR_SIZE - size);
+
+        if( action < 5 )
+        {
+            /* Sectors are erased as a whole; the queue must be drained before the
+               model is compared, so both kinds of calls are used */
+            if( rand() & 1 )
+            {
+                CHECK(kStatus_FLASH_Success == NV_FlashEraseSector(mFlashBase + sector * P_SECTOR_SIZE, P_SECTOR_SIZE));
+            }
+            else if( kStatus_FLASH_Success == NV_FlashEraseSectorAsync(mFlashBase + sector * P_SECTOR_SIZE,
+                                                                       P_SECTOR_SIZE, Callback,
+                                                                       (void *)(uintptr_t)next) )
+            {
+                next++;
+            }
+            else
+            {
+                continue;
+            }
+            ModelErase(sector * P_SECTOR_SIZE, P_SECTOR_SIZE);
+            continue;
+        }
+        if( action < 10 )
+        {
+            if( 0 == mFA_CSFlag )
+            {
+                NV_Flash_SetCriticalSection();
+            }
+            else
+            {
+                NV_Flash_ClearCriticalSection();
+            }
+            continue;
+        }
+        if( action < 15 )
+        {
+            /* Critical section entered by an ISR a few commands from now */
+            mIsrAtCommand = mCommands + 1 + rand() % 8;
+            continue;
+        }
+        if( action < 30 )
+        {
+            NV_FlashProcessQueue();
+            continue;
+        }
+
+        /* Programs only over erased bytes */
+        if( !ModelErased(offset, size) )
+        {
+            continue;
+        }
+        Fill(pData, size);
+        if( action < 60 )
+        {
+            CHECK(kStatus_FLASH_Success == NV_FlashProgramUnaligned(mFlashBase + offset, size, pData));
+        }
+        else if( kStatus_FLASH_Success == NV_FlashProgramAsync(mFlashBase + offset, size, pData, Callback,
+                                                               (void *)(uintptr_t)next) )
+        {
+            next++;
+        }
+        else
+        {
+            continue;
+        }
+        ModelProgram(offset, size, pData);
+
+        if( (0 == mFA_CSFlag) && (0 == mFA_QueueCount) )
+        {
+            CHECK(0 == memcmp(mpFlash, maModel, mFlashSize_c));
+        }
+    }
+
+    mpIsr = NULL;
+    mpPendingIsr = NULL;
+    while( mFA_CSFlag )
+    {
+        NV_Flash_ClearCriticalSection();
+    }
+    NV_FlashProcessQueue();
+    CHECK(0 == mFA_QueueCount);
+    CHECK(next == mCallbacks);
+    CHECK(0 == memcmp(mpFlash, maModel, mFlashSize_c));
+    CHECK(mIntOffMax <= mEraseUs_c);
+    printf("  fuzz seed %2u: %6u commands, %4u callbacks, %3u critical section waits\n", (unsigned)seed,
+           (unsigned)mCommands, (unsigned)mCallbacks, (unsigned)mSemWaits);
+}
+
+int main(void)
+{
+    uint32_t seed;
+
+    /* The flash must sit below 4 GB, the adapter takes 32-bit addresses */
+    mpFlash = mmap(NULL, mFlashSize_c, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    CHECK(MAP_FAILED != mpFlash);
+    mFlashBase = (uint32_t)(uintptr_t)mpFlash;
+
+    NV_Init();
+    TestLatency();
+    TestBatching();
+    TestCriticalSection();
+    for( seed = 1; seed <= 20; seed++ )
+    {
+        TestFuzz(seed, 10000);
+    }
+
+    printf("Flash: all tests passed\n");
+    return 0;
+}
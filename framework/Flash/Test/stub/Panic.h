@@ -0,0 +1,8 @@
+/* Host build stub */
+#ifndef __PANIC_H__
+#define __PANIC_H__
+#include <stdint.h>
+typedef uint32_t panicId_t;
+#define ID_PANIC(grp,value) ((panicId_t)(((uint16_t)grp << 16)+((uint16_t)value)))
+void panic(panicId_t id, uint32_t location, uint32_t extra1, uint32_t extra2);
+#endif
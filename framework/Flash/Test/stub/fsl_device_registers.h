@@ -0,0 +1,8 @@
+/* Host build stub: MK64FN1M0VMD12 flash features */
+#ifndef __FSL_DEVICE_REGISTERS_H__
+#define __FSL_DEVICE_REGISTERS_H__
+#define FSL_FEATURE_FLASH_IS_FTFE                       (1)
+#define FSL_FEATURE_FLASH_PFLASH_BLOCK_COUNT            (2)
+#define FSL_FEATURE_FLASH_PFLASH_BLOCK_SECTOR_SIZE      (4096)
+#define FSL_FEATURE_FLASH_PFLASH_BLOCK_WRITE_UNIT_SIZE  (8)
+#endif
@@ -0,0 +1,24 @@
+/* Host build stub: FTFx flash driver API, implemented by FlashTest.c on a
+   simulated flash */
+#ifndef _FSL_FTFX_FLASH_H_
+#define _FSL_FTFX_FLASH_H_
+#include <stdint.h>
+typedef int32_t status_t;
+enum
+{
+    kStatus_Success = 0,
+    kStatus_Fail = 1,
+    kStatus_FTFx_Success = 0,
+    kStatus_FTFx_InvalidArgument = 4,
+    kStatus_FTFx_AlignmentError = 101
+};
+enum { kFTFx_ApiEraseKey = 0x6b66656b };
+#define kStatus_FLASH_Success kStatus_FTFx_Success
+#define kFLASH_ApiEraseKey kFTFx_ApiEraseKey
+typedef enum { kFTFx_MarginValueNormal, kFTFx_MarginValueUser, kFTFx_MarginValueFactory } ftfx_margin_value_t;
+typedef struct { uint32_t PFlashTotalSize; } flash_config_t;
+status_t FLASH_Init(flash_config_t *config);
+status_t FLASH_Erase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, uint32_t key);
+status_t FLASH_Program(flash_config_t *config, uint32_t start, uint8_t *src, uint32_t lengthInBytes);
+status_t FLASH_VerifyErase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, ftfx_margin_value_t margin);
+#endif
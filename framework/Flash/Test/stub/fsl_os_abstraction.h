@@ -0,0 +1,17 @@
+/* Host build stub: the test is single threaded, the interrupt mask and the
+   semaphore are simulated by FlashTest.c */
+#ifndef _FSL_OS_ABSTRACTION_H_
+#define _FSL_OS_ABSTRACTION_H_
+#include <stdint.h>
+#define USE_RTOS            1
+#define osaWaitForever_c    ((uint32_t)(-1))
+typedef void* osaTaskId_t;
+typedef void* osaSemaphoreId_t;
+typedef enum { osaStatus_Success = 0, osaStatus_Error = 1 } osaStatus_t;
+void OSA_InterruptDisable(void);
+void OSA_InterruptEnable(void);
+osaTaskId_t OSA_TaskGetId(void);
+osaSemaphoreId_t OSA_SemaphoreCreate(uint32_t initValue);
+osaStatus_t OSA_SemaphoreWait(osaSemaphoreId_t semId, uint32_t millisec);
+osaStatus_t OSA_SemaphorePost(osaSemaphoreId_t semId);
+#endif
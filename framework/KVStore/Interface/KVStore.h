@@ -0,0 +1,233 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file KVStore.h
+* This is the header file for the key-value store module.
+* Small application records (calibration, counters, configuration) are kept
+* in a log-structured store on a ring of flash sectors. An update appends a
+* new copy of the record, so that no sector is erased per write; the sectors
+* are reclaimed oldest first, which spreads the erases evenly over the ring.
+*
+* Every record carries a CRC. A record cut by a reset is ignored at the next
+* KVStore_Init() and the previous value of its key is kept, so an update is
+* either fully applied or not at all.
+*
+* The flash is reached through a kvStorage_t descriptor only. On target it maps
+* to the Flash_Adapter program and erase functions; the host test in Test/ maps
+* it to a simulated flash that loses power in the middle of a program or erase.
+*
+* The application settings keys are listed in app_config.h.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* o Redistributions of source code must retain the above copyright notice, this list
+*   of conditions and the following disclaimer.
+*
+* o Redistributions in binary form must reproduce the above copyright notice, this
+*   list of conditions and the following disclaimer in the documentation and/or
+*   other materials provided with the distribution.
+*
+* o Neither the name of the copyright holder nor the names of its
+*   contributors may be used to endorse or promote products derived from this
+*   software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+* ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _KV_STORE_H_
+#define _KV_STORE_H_
+
+/*! *********************************************************************************
+*************************************************************************************
+* Include
+*************************************************************************************
+********************************************************************************** */
+#include "EmbeddedTypes.h"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public macros
+*************************************************************************************
+********************************************************************************** */
+
+/*
+ * \brief   Number of keys. Keys are 0..gKVStoreMaxKeys_c-1 and index a RAM
+ *          table holding the location of their newest record.
+ */
+#ifndef gKVStoreMaxKeys_c
+#define gKVStoreMaxKeys_c               32
+#endif
+
+/*
+ * \brief   Largest value stored under a key, in bytes.
+ */
+#ifndef gKVStoreMaxValueSize_c
+#define gKVStoreMaxValueSize_c          256
+#endif
+
+/*
+ * \brief   Largest number of sectors of a storage region. At least 3 are needed:
+ *          the one being appended to, one kept erased for the compaction and
+ *          one holding older records.
+ */
+#ifndef gKVStoreMaxSectors_c
+#define gKVStoreMaxSectors_c            8
+#endif
+
+/*
+ * \brief   KVStore_Idle() compacts the oldest sector while fewer sectors than
+ *          this are erased, so that KVStore_Set() seldom has to.
+ */
+#ifndef gKVStoreIdleFreeSectors_c
+#define gKVStoreIdleFreeSectors_c       2
+#endif
+
+/*
+ * \brief   Enables the storage descriptor for the internal flash, on the
+ *          KV_STORE_BASE_ADDR region reserved by the linker file.
+ */
+#ifndef gKVStoreInternalFlashEnabled_d
+#define gKVStoreInternalFlashEnabled_d  1
+#endif
+
+/* Records and sector headers are written in units of this size */
+#define gKVStoreProgramUnit_c           8
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public type definitions
+*************************************************************************************
+********************************************************************************** */
+
+typedef enum kvStatus_tag
+{
+    gKVStoreSuccess_c,
+    gKVStoreNotFound_c,
+    gKVStoreInvalidParam_c,
+    gKVStoreBufferTooSmall_c,           /* Value longer than the buffer, nothing copied */
+    gKVStoreFull_c,                     /* Live records fill the region */
+    gKVStoreFlashError_c,
+    gKVStoreNotInitialized_c
+} kvStatus_t;
+
+/*! Storage device. All the addresses are absolute. The region must be a whole
+ *  number of sectors. Program calls are aligned to gKVStoreProgramUnit_c and
+ *  never rewrite a unit that was not erased. The functions return FALSE on error. */
+typedef struct kvStorage_tag
+{
+    uint32_t baseAddr;
+    uint32_t size;
+    uint32_t sectorSize;
+    bool_t (*read)(uint32_t addr, uint32_t len, uint8_t *pData);
+    bool_t (*program)(uint32_t addr, uint32_t len, const uint8_t *pData);
+    bool_t (*erase)(uint32_t addr);     /* Erases the sector starting at addr */
+} kvStorage_t;
+
+/*! Flash usage counters since KVStore_Init(), e.g. for the write amplification */
+typedef struct kvStats_tag
+{
+    uint32_t userBytes;                 /* Value bytes passed to KVStore_Set() */
+    uint32_t programmedBytes;           /* Bytes programmed, headers and compaction included */
+    uint32_t erases;
+    uint32_t compactions;               /* Sectors reclaimed */
+    uint32_t liveBytes;                 /* Bytes of the records currently in use */
+} kvStats_t;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public memory declarations
+*************************************************************************************
+********************************************************************************** */
+#if gKVStoreInternalFlashEnabled_d
+extern const kvStorage_t gKVStoreInternalFlashStorage;
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public prototypes
+*************************************************************************************
+********************************************************************************** */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! *********************************************************************************
+* \brief   Selects the storage device and rebuilds the RAM index from the records
+*          found in it. Sectors left half written or half erased by a reset are
+*          erased again.
+*
+* \param[in] pStorage  storage descriptor, must stay valid
+*
+* \return  FALSE if the storage geometry is not supported or cannot be accessed
+*
+********************************************************************************** */
+bool_t KVStore_Init(const kvStorage_t *pStorage);
+
+/*! *********************************************************************************
+* \brief   Stores a value, replacing the previous one of the key. When the region
+*          is full the oldest sector is compacted before returning.
+*
+* \param[in] key    0..gKVStoreMaxKeys_c-1
+* \param[in] pData  value
+* \param[in] len    1..gKVStoreMaxValueSize_c
+*
+* \return  gKVStoreSuccess_c once the record is in flash
+*
+********************************************************************************** */
+kvStatus_t KVStore_Set(uint16_t key, const void *pData, uint16_t len);
+
+/*! *********************************************************************************
+* \brief   Reads the value of a key.
+*
+* \param[in]  key     0..gKVStoreMaxKeys_c-1
+* \param[out] pData   destination
+* \param[in]  maxLen  size of pData
+* \param[out] pLen    length of the value, may be NULL
+*
+* \return  gKVStoreNotFound_c if the key has no value
+*
+********************************************************************************** */
+kvStatus_t KVStore_Get(uint16_t key, void *pData, uint16_t maxLen, uint16_t *pLen);
+
+/*! *********************************************************************************
+* \brief   Removes the value of a key.
+*
+* \param[in] key  0..gKVStoreMaxKeys_c-1
+*
+* \return  gKVStoreSuccess_c, also if the key had no value
+*
+********************************************************************************** */
+kvStatus_t KVStore_Delete(uint16_t key);
+
+/*! *********************************************************************************
+* \brief   Background compaction. Does at most one record copy or one sector erase
+*          per call, to be called from the lowest priority context (the NV idle
+*          task, or the main application loop when the NVM module is not used).
+*
+********************************************************************************** */
+void KVStore_Idle(void);
+
+/*! *********************************************************************************
+* \brief   Reads the flash usage counters.
+*
+* \param[out] pStats  destination
+*
+********************************************************************************** */
+void KVStore_GetStats(kvStats_t *pStats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _KV_STORE_H_ */
@@ -0,0 +1,1099 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file KVStore.c
+* This is the source file for the key-value store module.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* o Redistributions of source code must retain the above copyright notice, this list
+*   of conditions and the following disclaimer.
+*
+* o Redistributions in binary form must reproduce the above copyright notice, this
+*   list of conditions and the following disclaimer in the documentation and/or
+*   other materials provided with the distribution.
+*
+* o Neither the name of the copyright holder nor the names of its
+*   contributors may be used to endorse or promote products derived from this
+*   software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+* ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*! *********************************************************************************
+*************************************************************************************
+* Include
+*************************************************************************************
+********************************************************************************** */
+#include "EmbeddedTypes.h"
+#include "KVStore.h"
+#include "FunctionLib.h"
+#include "fsl_os_abstraction.h"
+#include "Panic.h"
+
+#if gKVStoreInternalFlashEnabled_d
+#include "Flash_Adapter.h"
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private macros
+*************************************************************************************
+********************************************************************************** */
+#if (gKVStoreMaxSectors_c < 3)
+#error "gKVStoreMaxSectors_c must be at least 3"
+#endif
+
+#if (gKVStoreMaxValueSize_c < 1) || (gKVStoreMaxValueSize_c > 0x7FFF)
+#error "gKVStoreMaxValueSize_c must be in the 1..0x7FFF range"
+#endif
+
+/* Sector header check word, "KVS1" */
+#define mKVSectorMagic_c        0x4B565331UL
+
+/* Length flag of the record written by KVStore_Delete() */
+#define mKVTombstone_c          0x8000U
+#define mKVLengthMask_c         0x7FFFU
+
+#define mKVNoRecord_c           0xFFFFFFFFUL
+
+/* Key of the record appended once the live records of a sector are copied, before
+ * it is erased. Its value is the sequence of that sector. */
+#define mKVReclaimKey_c         0xFFFEU
+
+/* Generator for CRC calculations, CRC-32 in reflected form. 16 bits are not enough:
+ * a record torn by a reset passes a CRC-16 about once every 65536 cuts. */
+#define mKVCrcPoly_c            0xEDB88320UL
+
+#define mKVAlign_m(len)         (((uint32_t)(len) + gKVStoreProgramUnit_c - 1) & ~(uint32_t)(gKVStoreProgramUnit_c - 1))
+#define mKVRecordSize_m(len)    (sizeof(kvRecordHeader_t) + mKVAlign_m((len) & mKVLengthMask_c))
+
+/* Every sector keeps room for a reclaim record */
+#define mKVMarkerSize_c         mKVRecordSize_m(sizeof(uint32_t))
+
+#define mKVSectorAddr_m(s)      (mpKVStorage->baseAddr + (s) * mpKVStorage->sectorSize)
+
+#if (USE_RTOS)
+#define mKVLock_m()             (void)OSA_MutexLock(mKVMutexId, osaWaitForever_c)
+#define mKVUnlock_m()           (void)OSA_MutexUnlock(mKVMutexId)
+#else
+#define mKVLock_m()
+#define mKVUnlock_m()
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private type definitions
+*************************************************************************************
+********************************************************************************** */
+
+/*! First program unit of a sector in use. Sectors are used in sequence order,
+ *  the newest one is appended to and the oldest one is reclaimed first. */
+typedef PACKED_STRUCT kvSectorHeader_tag
+{
+    uint32_t sequence;
+    uint32_t check;                     /* sequence ^ mKVSectorMagic_c */
+} kvSectorHeader_t;
+
+/*! Header of a record, followed by the value padded with 0xFF to the program unit */
+typedef PACKED_STRUCT kvRecordHeader_tag
+{
+    uint16_t key;
+    uint16_t length;                    /* Value length, mKVTombstone_c for a delete */
+    uint32_t crc;                       /* Over the fields above and the value */
+} kvRecordHeader_t;
+
+typedef enum kvSectorState_tag
+{
+    mKVSectorFree_c,                    /* Erased */
+    mKVSectorUsed_c,
+    mKVSectorDirty_c                    /* Neither erased nor holding a valid header */
+} kvSectorState_t;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private prototypes
+*************************************************************************************
+********************************************************************************** */
+static uint32_t   KVStore_Crc(uint32_t crc, const uint8_t *pData, uint32_t len);
+static bool_t     KVStore_IsBlank(uint32_t addr, uint32_t len, bool_t *pBlank);
+static bool_t     KVStore_ReadRecord(uint32_t sector, uint32_t offset, kvRecordHeader_t *pHeader, bool_t *pValid);
+static bool_t     KVStore_Load(void);
+static bool_t     KVStore_ScanSector(uint32_t sector, bool_t markers);
+static void       KVStore_IndexUpdate(uint16_t key, uint32_t location, uint16_t length);
+static uint32_t   KVStore_FreeSectors(void);
+static uint32_t   KVStore_OldestSector(void);
+static kvStatus_t KVStore_EraseSector(uint32_t sector);
+static kvStatus_t KVStore_OpenSector(bool_t keepSpare);
+static kvStatus_t KVStore_Append(uint16_t key, const uint8_t *pData, uint16_t length, bool_t keepSpare);
+static kvStatus_t KVStore_CompactStep(bool_t *pDone);
+static kvStatus_t KVStore_Write(uint16_t key, const uint8_t *pData, uint16_t length);
+
+#if gKVStoreInternalFlashEnabled_d
+static bool_t KVStore_FlashRead(uint32_t addr, uint32_t len, uint8_t *pData);
+static bool_t KVStore_FlashProgram(uint32_t addr, uint32_t len, const uint8_t *pData);
+static bool_t KVStore_FlashErase(uint32_t addr);
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private memory declarations
+*************************************************************************************
+********************************************************************************** */
+static const kvStorage_t *mpKVStorage = NULL;
+static uint32_t mKVSectors;
+
+/* Location (region offset) and length of the newest record of every key */
+static uint32_t maKVIndex[gKVStoreMaxKeys_c];
+static uint16_t maKVLength[gKVStoreMaxKeys_c];
+
+static uint8_t  maKVState[gKVStoreMaxSectors_c];
+static uint32_t maKVSequence[gKVStoreMaxSectors_c];
+static uint32_t maKVEnd[gKVStoreMaxSectors_c];      /* Offset after the last valid record */
+static uint32_t maKVLive[gKVStoreMaxSectors_c];     /* Bytes of the records still indexed */
+
+static uint32_t mKVHead;                            /* Sector appended to */
+static uint32_t mKVWriteOffset;                     /* sectorSize once a write was cut */
+static uint32_t mKVNextSequence;
+static uint32_t mKVCompactOffset;                   /* Next record of the oldest sector, 0 if idle */
+static bool_t   mKVCompactMarked;                   /* Reclaim record written, the erase is next */
+
+static kvStats_t mKVStats;
+
+/* Record being written, header first */
+static uint8_t maKVRecord[sizeof(kvRecordHeader_t) + mKVAlign_m(gKVStoreMaxValueSize_c)];
+
+#if (USE_RTOS)
+static osaMutexId_t mKVMutexId;
+#endif
+
+#if gKVStoreInternalFlashEnabled_d
+/* Region reserved below the product data by the linker file */
+extern uint32_t KV_STORE_BASE_ADDR[];
+extern uint32_t KV_STORE_SIZE[];
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public memory declarations
+*************************************************************************************
+********************************************************************************** */
+#if gKVStoreInternalFlashEnabled_d
+const kvStorage_t gKVStoreInternalFlashStorage =
+{
+    (uint32_t)KV_STORE_BASE_ADDR,
+    (uint32_t)KV_STORE_SIZE,
+    FSL_FEATURE_FLASH_PFLASH_BLOCK_SECTOR_SIZE,
+    KVStore_FlashRead,
+    KVStore_FlashProgram,
+    KVStore_FlashErase
+};
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public functions
+*************************************************************************************
+********************************************************************************** */
+
+/*! *********************************************************************************
+* \brief   Selects the storage device and rebuilds the index from its records.
+*
+* \param[in] pStorage  storage descriptor
+*
+* \return  FALSE if the storage geometry is not supported or cannot be accessed
+*
+********************************************************************************** */
+bool_t KVStore_Init(const kvStorage_t *pStorage)
+{
+    bool_t status;
+
+#if (USE_RTOS)
+    if( NULL == mKVMutexId )
+    {
+        mKVMutexId = OSA_MutexCreate();
+
+        if( NULL == mKVMutexId )
+        {
+            panic(0, (uint32_t)KVStore_Init, 0, 0);
+        }
+    }
+#endif
+
+    if( (NULL == pStorage) || (0 == pStorage->sectorSize) || (pStorage->sectorSize % gKVStoreProgramUnit_c) ||
+        (pStorage->size % pStorage->sectorSize) || (pStorage->size < 3 * pStorage->sectorSize) ||
+        (pStorage->size > gKVStoreMaxSectors_c * pStorage->sectorSize) ||
+        (pStorage->sectorSize < sizeof(kvSectorHeader_t) + sizeof(maKVRecord)) )
+    {
+        return FALSE;
+    }
+
+    mKVLock_m();
+
+    mpKVStorage = pStorage;
+    mKVSectors = pStorage->size / pStorage->sectorSize;
+    FLib_MemSet(&mKVStats, 0, sizeof(mKVStats));
+
+    status = KVStore_Load();
+
+    /* Outside of a reclaim a sector is always kept erased. Without one, a reset cut
+     * a reclaim whose copies went to a new sector before its reclaim record: that
+     * sector holds nothing but copies, so it is dropped and the originals are used
+     * again. */
+    if( status && (0 == KVStore_FreeSectors()) )
+    {
+        status = (gKVStoreSuccess_c == KVStore_EraseSector(mKVHead)) ? KVStore_Load() : FALSE;
+    }
+
+    if( !status )
+    {
+        mpKVStorage = NULL;
+    }
+
+    mKVUnlock_m();
+
+    return status;
+}
+
+/*! *********************************************************************************
+* \brief   Stores a value, replacing the previous one of the key.
+*
+* \param[in] key    0..gKVStoreMaxKeys_c-1
+* \param[in] pData  value
+* \param[in] len    1..gKVStoreMaxValueSize_c
+*
+* \return  gKVStoreSuccess_c once the record is in flash
+*
+********************************************************************************** */
+kvStatus_t KVStore_Set(uint16_t key, const void *pData, uint16_t len)
+{
+    kvStatus_t status;
+
+    if( (key >= gKVStoreMaxKeys_c) || (NULL == pData) || (0 == len) || (len > gKVStoreMaxValueSize_c) )
+    {
+        return gKVStoreInvalidParam_c;
+    }
+
+    if( NULL == mpKVStorage )
+    {
+        return gKVStoreNotInitialized_c;
+    }
+
+    mKVLock_m();
+
+    status = KVStore_Write(key, pData, len);
+
+    if( gKVStoreSuccess_c == status )
+    {
+        mKVStats.userBytes += len;
+    }
+
+    mKVUnlock_m();
+
+    return status;
+}
+
+/*! *********************************************************************************
+* \brief   Reads the value of a key.
+*
+* \param[in]  key     0..gKVStoreMaxKeys_c-1
+* \param[out] pData   destination
+* \param[in]  maxLen  size of pData
+* \param[out] pLen    length of the value, may be NULL
+*
+* \return  gKVStoreNotFound_c if the key has no value
+*
+********************************************************************************** */
+kvStatus_t KVStore_Get(uint16_t key, void *pData, uint16_t maxLen, uint16_t *pLen)
+{
+    kvStatus_t status = gKVStoreSuccess_c;
+    uint32_t location;
+    uint16_t length;
+
+    if( (key >= gKVStoreMaxKeys_c) || ((NULL == pData) && maxLen) )
+    {
+        return gKVStoreInvalidParam_c;
+    }
+
+    if( NULL == mpKVStorage )
+    {
+        return gKVStoreNotInitialized_c;
+    }
+
+    mKVLock_m();
+
+    location = maKVIndex[key];
+    length = maKVLength[key];
+
+    if( mKVNoRecord_c == location )
+    {
+        status = gKVStoreNotFound_c;
+        length = 0;
+    }
+    else if( length > maxLen )
+    {
+        status = gKVStoreBufferTooSmall_c;
+    }
+    else if( !mpKVStorage->read(mpKVStorage->baseAddr + location + sizeof(kvRecordHeader_t), length, pData) )
+    {
+        status = gKVStoreFlashError_c;
+    }
+
+    mKVUnlock_m();
+
+    if( NULL != pLen )
+    {
+        *pLen = length;
+    }
+
+    return status;
+}
+
+/*! *********************************************************************************
+* \brief   Removes the value of a key.
+*
+* \param[in] key  0..gKVStoreMaxKeys_c-1
+*
+* \return  gKVStoreSuccess_c, also if the key had no value
+*
+********************************************************************************** */
+kvStatus_t KVStore_Delete(uint16_t key)
+{
+    kvStatus_t status = gKVStoreSuccess_c;
+
+    if( key >= gKVStoreMaxKeys_c )
+    {
+        return gKVStoreInvalidParam_c;
+    }
+
+    if( NULL == mpKVStorage )
+    {
+        return gKVStoreNotInitialized_c;
+    }
+
+    mKVLock_m();
+
+    if( mKVNoRecord_c != maKVIndex[key] )
+    {
+        status = KVStore_Write(key, NULL, mKVTombstone_c);
+    }
+
+    mKVUnlock_m();
+
+    return status;
+}
+
+/*! *********************************************************************************
+* \brief   Background compaction, one record copy or one sector erase per call.
+*          Only sectors holding superseded records are reclaimed here, moving a
+*          sector of live records would only add wear.
+*
+********************************************************************************** */
+void KVStore_Idle(void)
+{
+    uint32_t oldest;
+    bool_t done;
+
+    if( NULL == mpKVStorage )
+    {
+        return;
+    }
+
+#if (USE_RTOS)
+    /* Never wait here, the caller may be the idle task */
+    if( osaStatus_Success != OSA_MutexLock(mKVMutexId, 0) )
+    {
+        return;
+    }
+#endif
+
+    if( 0 == mKVCompactOffset )
+    {
+        oldest = KVStore_OldestSector();
+
+        if( (KVStore_FreeSectors() < gKVStoreIdleFreeSectors_c) && (oldest != mKVHead) &&
+            (maKVLive[oldest] + sizeof(kvSectorHeader_t) < maKVEnd[oldest]) )
+        {
+            (void)KVStore_CompactStep(&done);
+        }
+    }
+    else
+    {
+        (void)KVStore_CompactStep(&done);
+    }
+
+    mKVUnlock_m();
+}
+
+/*! *********************************************************************************
+* \brief   Reads the flash usage counters.
+*
+* \param[out] pStats  destination
+*
+********************************************************************************** */
+void KVStore_GetStats(kvStats_t *pStats)
+{
+    uint32_t i;
+
+    if( NULL == pStats )
+    {
+        return;
+    }
+
+    mKVLock_m();
+
+    *pStats = mKVStats;
+    pStats->liveBytes = 0;
+
+    for( i = 0; (NULL != mpKVStorage) && (i < mKVSectors); i++ )
+    {
+        pStats->liveBytes += maKVLive[i];
+    }
+
+    mKVUnlock_m();
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private functions
+*************************************************************************************
+********************************************************************************** */
+
+/*! *********************************************************************************
+* \brief   CRC-32 update, without the final complement.
+*
+********************************************************************************** */
+static uint32_t KVStore_Crc(uint32_t crc, const uint8_t *pData, uint32_t len)
+{
+    uint8_t bit;
+
+    while( len-- )
+    {
+        crc ^= *pData++;
+
+        for( bit = 8; bit; bit-- )
+        {
+            crc = (crc & 1U) ? ((crc >> 1) ^ mKVCrcPoly_c) : (crc >> 1);
+        }
+    }
+
+    return crc;
+}
+
+/*! *********************************************************************************
+* \brief   Checks that a range of the storage is erased.
+*
+* \return  FALSE on read error
+*
+********************************************************************************** */
+static bool_t KVStore_IsBlank(uint32_t addr, uint32_t len, bool_t *pBlank)
+{
+    uint32_t chunk[8];
+    uint32_t size;
+    uint32_t i;
+
+    *pBlank = TRUE;
+
+    while( len && *pBlank )
+    {
+        size = (len < sizeof(chunk)) ? len : sizeof(chunk);
+
+        if( !mpKVStorage->read(addr, size, (uint8_t *)chunk) )
+        {
+            return FALSE;
+        }
+
+        for( i = 0; i < size; i++ )
+        {
+            if( 0xFF != ((uint8_t *)chunk)[i] )
+            {
+                *pBlank = FALSE;
+                break;
+            }
+        }
+
+        addr += size;
+        len -= size;
+    }
+
+    return TRUE;
+}
+
+/*! *********************************************************************************
+* \brief   Reads a record into maKVRecord and checks it.
+*
+* \param[in]  sector   sector index
+* \param[in]  offset   offset of the record in the sector
+* \param[out] pHeader  record header
+* \param[out] pValid   FALSE for an erased or cut record
+*
+* \return  FALSE on read error
+*
+********************************************************************************** */
+static bool_t KVStore_ReadRecord(uint32_t sector, uint32_t offset, kvRecordHeader_t *pHeader, bool_t *pValid)
+{
+    uint16_t length;
+
+    *pValid = FALSE;
+
+    if( !mpKVStorage->read(mKVSectorAddr_m(sector) + offset, sizeof(kvRecordHeader_t), (uint8_t *)pHeader) )
+    {
+        return FALSE;
+    }
+
+    length = pHeader->length & mKVLengthMask_c;
+
+    if( ((pHeader->key >= gKVStoreMaxKeys_c) && (mKVReclaimKey_c != pHeader->key)) ||
+        ((mKVReclaimKey_c == pHeader->key) && (sizeof(uint32_t) != pHeader->length)) ||
+        (length > gKVStoreMaxValueSize_c) || ((pHeader->length & mKVTombstone_c) && length) ||
+        (offset + mKVRecordSize_m(pHeader->length) > mpKVStorage->sectorSize) )
+    {
+        return TRUE;
+    }
+
+    FLib_MemCpy(maKVRecord, pHeader, sizeof(kvRecordHeader_t));
+
+    if( length &&
+        !mpKVStorage->read(mKVSectorAddr_m(sector) + offset + sizeof(kvRecordHeader_t), length,
+                           &maKVRecord[sizeof(kvRecordHeader_t)]) )
+    {
+        return FALSE;
+    }
+
+    *pValid = (KVStore_Crc(KVStore_Crc(0xFFFFFFFFUL, maKVRecord, sizeof(kvRecordHeader_t) - sizeof(uint32_t)),
+                           &maKVRecord[sizeof(kvRecordHeader_t)], length) == pHeader->crc) ? TRUE : FALSE;
+
+    return TRUE;
+}
+
+/*! *********************************************************************************
+* \brief   Rebuilds the index and the sector states from the storage.
+*
+* \return  FALSE on flash error
+*
+********************************************************************************** */
+static bool_t KVStore_Load(void)
+{
+    kvSectorHeader_t header;
+    uint32_t order[gKVStoreMaxSectors_c];
+    uint32_t used = 0;
+    uint32_t i, j, tmp;
+    bool_t blank;
+    bool_t status = TRUE;
+
+    mKVNextSequence = 1;
+    mKVCompactOffset = 0;
+    mKVCompactMarked = FALSE;
+
+    for( i = 0; i < gKVStoreMaxKeys_c; i++ )
+    {
+        maKVIndex[i] = mKVNoRecord_c;
+        maKVLength[i] = 0;
+    }
+
+    /* Classify the sectors by their header */
+    for( i = 0; (i < mKVSectors) && status; i++ )
+    {
+        maKVSequence[i] = 0;
+        maKVEnd[i] = 0;
+        maKVLive[i] = 0;
+
+        if( !mpKVStorage->read(mKVSectorAddr_m(i), sizeof(header), (uint8_t *)&header) )
+        {
+            status = FALSE;
+        }
+        else if( (header.check == (header.sequence ^ mKVSectorMagic_c)) && (0 != header.sequence) )
+        {
+            maKVState[i] = mKVSectorUsed_c;
+            maKVSequence[i] = header.sequence;
+            order[used++] = i;
+
+            if( header.sequence >= mKVNextSequence )
+            {
+                mKVNextSequence = header.sequence + 1;
+            }
+        }
+        else if( !KVStore_IsBlank(mKVSectorAddr_m(i), mpKVStorage->sectorSize, &blank) )
+        {
+            status = FALSE;
+        }
+        else
+        {
+            /* A header cut while the sector was being opened, or an erase cut by a reset */
+            maKVState[i] = blank ? mKVSectorFree_c : mKVSectorDirty_c;
+        }
+    }
+
+    /* Replay the sectors oldest first, so that the newest record of a key wins */
+    for( i = 1; i < used; i++ )
+    {
+        for( j = i; (j > 0) && (maKVSequence[order[j - 1]] > maKVSequence[order[j]]); j-- )
+        {
+            tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+    }
+
+    /* A sector named by a reclaim record had all its live records copied: whatever
+     * an erase cut by a reset left of it is ignored */
+    for( i = 0; (i < used) && status; i++ )
+    {
+        status = KVStore_ScanSector(order[i], TRUE);
+    }
+
+    for( i = 0, j = used; (i < used) && status; i++ )
+    {
+        if( mKVSectorUsed_c == maKVState[order[i]] )
+        {
+            status = KVStore_ScanSector(order[i], FALSE);
+            j = i;
+        }
+    }
+
+    for( i = 0; (i < mKVSectors) && status; i++ )
+    {
+        if( (mKVSectorDirty_c == maKVState[i]) && (gKVStoreSuccess_c != KVStore_EraseSector(i)) )
+        {
+            status = FALSE;
+        }
+    }
+
+    if( status )
+    {
+        if( j < used )
+        {
+            /* KVStore_ScanSector() left the write offset of the newest sector */
+            mKVHead = order[j];
+        }
+        else
+        {
+            mKVHead = mKVSectors - 1;
+            status = (gKVStoreSuccess_c == KVStore_OpenSector(FALSE)) ? TRUE : FALSE;
+        }
+    }
+
+    return status;
+}
+
+/*! *********************************************************************************
+* \brief   Adds the records of a used sector to the index. The scan stops at the
+*          first erased or invalid record. Unless the rest of the sector is erased,
+*          that record was cut by a reset and the sector takes no more appends.
+*
+* \param[in] sector   sector index
+* \param[in] markers  only look for reclaim records and mark the sectors they name
+*
+* \return  FALSE on read error
+*
+********************************************************************************** */
+static bool_t KVStore_ScanSector(uint32_t sector, bool_t markers)
+{
+    kvRecordHeader_t header;
+    uint32_t offset = sizeof(kvSectorHeader_t);
+    uint32_t sectorSize = mpKVStorage->sectorSize;
+    uint32_t sequence;
+    uint32_t i;
+    bool_t valid = TRUE;
+    bool_t blank = FALSE;
+
+    while( valid && (offset + sizeof(kvRecordHeader_t) <= sectorSize) )
+    {
+        if( !KVStore_ReadRecord(sector, offset, &header, &valid) )
+        {
+            return FALSE;
+        }
+
+        if( !valid )
+        {
+            break;
+        }
+
+        if( mKVReclaimKey_c != header.key )
+        {
+            if( !markers )
+            {
+                KVStore_IndexUpdate(header.key, sector * sectorSize + offset, header.length);
+            }
+        }
+        else if( markers )
+        {
+            FLib_MemCpy(&sequence, &maKVRecord[sizeof(kvRecordHeader_t)], sizeof(sequence));
+
+            for( i = 0; i < mKVSectors; i++ )
+            {
+                if( (mKVSectorUsed_c == maKVState[i]) && (maKVSequence[i] == sequence) )
+                {
+                    maKVState[i] = mKVSectorDirty_c;
+                }
+            }
+        }
+
+        offset += mKVRecordSize_m(header.length);
+    }
+
+    if( markers )
+    {
+        return TRUE;
+    }
+
+    if( !KVStore_IsBlank(mKVSectorAddr_m(sector) + offset, sectorSize - offset, &blank) )
+    {
+        return FALSE;
+    }
+
+    maKVEnd[sector] = offset;
+    mKVWriteOffset = blank ? offset : sectorSize;
+
+    return TRUE;
+}
+
+/*! *********************************************************************************
+* \brief   Points a key to its newest record.
+*
+********************************************************************************** */
+static void KVStore_IndexUpdate(uint16_t key, uint32_t location, uint16_t length)
+{
+    uint32_t sectorSize = mpKVStorage->sectorSize;
+
+    if( mKVNoRecord_c != maKVIndex[key] )
+    {
+        maKVLive[maKVIndex[key] / sectorSize] -= mKVRecordSize_m(maKVLength[key]);
+    }
+
+    if( length & mKVTombstone_c )
+    {
+        /* The delete record itself is never copied: the older records it hides are
+         * in older sectors, which are reclaimed before its own */
+        maKVIndex[key] = mKVNoRecord_c;
+        maKVLength[key] = 0;
+    }
+    else
+    {
+        maKVIndex[key] = location;
+        maKVLength[key] = length;
+        maKVLive[location / sectorSize] += mKVRecordSize_m(length);
+    }
+}
+
+static uint32_t KVStore_FreeSectors(void)
+{
+    uint32_t count = 0;
+    uint32_t i;
+
+    for( i = 0; i < mKVSectors; i++ )
+    {
+        if( mKVSectorFree_c == maKVState[i] )
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static uint32_t KVStore_OldestSector(void)
+{
+    uint32_t oldest = mKVHead;
+    uint32_t i;
+
+    for( i = 0; i < mKVSectors; i++ )
+    {
+        if( (mKVSectorUsed_c == maKVState[i]) && (maKVSequence[i] < maKVSequence[oldest]) )
+        {
+            oldest = i;
+        }
+    }
+
+    return oldest;
+}
+
+static kvStatus_t KVStore_EraseSector(uint32_t sector)
+{
+    maKVState[sector] = mKVSectorDirty_c;
+    maKVSequence[sector] = 0;
+    maKVEnd[sector] = 0;
+    maKVLive[sector] = 0;
+
+    if( !mpKVStorage->erase(mKVSectorAddr_m(sector)) )
+    {
+        return gKVStoreFlashError_c;
+    }
+
+    maKVState[sector] = mKVSectorFree_c;
+    mKVStats.erases++;
+
+    return gKVStoreSuccess_c;
+}
+
+/*! *********************************************************************************
+* \brief   Makes the next erased sector after the current one the append sector.
+*
+* \param[in] keepSpare  fail unless another erased sector is left for the compaction
+*
+********************************************************************************** */
+static kvStatus_t KVStore_OpenSector(bool_t keepSpare)
+{
+    kvSectorHeader_t header;
+    uint32_t sector = mKVHead;
+    uint32_t i;
+
+    if( KVStore_FreeSectors() < (keepSpare ? 2U : 1U) )
+    {
+        return gKVStoreFull_c;
+    }
+
+    /* Round robin over the ring spreads the erases evenly */
+    for( i = 0; i < mKVSectors; i++ )
+    {
+        sector = (sector + 1) % mKVSectors;
+
+        if( mKVSectorFree_c == maKVState[sector] )
+        {
+            break;
+        }
+    }
+
+    header.sequence = mKVNextSequence;
+    header.check = mKVNextSequence ^ mKVSectorMagic_c;
+
+    if( !mpKVStorage->program(mKVSectorAddr_m(sector), sizeof(header), (const uint8_t *)&header) )
+    {
+        maKVState[sector] = mKVSectorDirty_c;
+        return gKVStoreFlashError_c;
+    }
+
+    mKVStats.programmedBytes += sizeof(header);
+    maKVState[sector] = mKVSectorUsed_c;
+    maKVSequence[sector] = mKVNextSequence++;
+    maKVEnd[sector] = sizeof(header);
+    maKVLive[sector] = 0;
+    mKVHead = sector;
+    mKVWriteOffset = sizeof(header);
+
+    return gKVStoreSuccess_c;
+}
+
+/*! *********************************************************************************
+* \brief   Appends a record. The value may already be in place in maKVRecord.
+*
+* \param[in] key        key
+* \param[in] pData      value, NULL for a delete record
+* \param[in] length     value length, with mKVTombstone_c for a delete record
+* \param[in] keepSpare  see KVStore_OpenSector()
+*
+********************************************************************************** */
+static kvStatus_t KVStore_Append(uint16_t key, const uint8_t *pData, uint16_t length, bool_t keepSpare)
+{
+    kvRecordHeader_t *pHeader = (kvRecordHeader_t *)maKVRecord;
+    uint8_t *pValue = &maKVRecord[sizeof(kvRecordHeader_t)];
+    uint16_t valueLength = length & mKVLengthMask_c;
+    uint32_t size = mKVRecordSize_m(length);
+    uint32_t limit = mpKVStorage->sectorSize - ((mKVReclaimKey_c == key) ? 0 : mKVMarkerSize_c);
+    uint32_t location;
+    kvStatus_t status;
+
+    if( mKVWriteOffset + size > limit )
+    {
+        status = KVStore_OpenSector(keepSpare);
+
+        if( gKVStoreSuccess_c != status )
+        {
+            return status;
+        }
+    }
+
+    if( (NULL != pData) && (pData != pValue) )
+    {
+        FLib_MemCpy(pValue, (void *)pData, valueLength);
+    }
+
+    FLib_MemSet(&pValue[valueLength], 0xFF, size - sizeof(kvRecordHeader_t) - valueLength);
+
+    pHeader->key = key;
+    pHeader->length = length;
+    pHeader->crc = KVStore_Crc(KVStore_Crc(0xFFFFFFFFUL, maKVRecord, sizeof(kvRecordHeader_t) - sizeof(uint32_t)),
+                               pValue, valueLength);
+
+    location = mKVHead * mpKVStorage->sectorSize + mKVWriteOffset;
+
+    if( !mpKVStorage->program(mpKVStorage->baseAddr + location, size, maKVRecord) )
+    {
+        /* What reached the flash is unknown, leave the rest of the sector alone */
+        mKVWriteOffset = mpKVStorage->sectorSize;
+        return gKVStoreFlashError_c;
+    }
+
+    mKVStats.programmedBytes += size;
+    mKVWriteOffset += size;
+    maKVEnd[mKVHead] = mKVWriteOffset;
+
+    if( mKVReclaimKey_c != key )
+    {
+        KVStore_IndexUpdate(key, location, length);
+    }
+
+    return gKVStoreSuccess_c;
+}
+
+/*! *********************************************************************************
+* \brief   One step of the reclaim of the oldest sector: copies its next record
+*          still indexed to the append sector, or once all are copied appends the
+*          reclaim record, or erases the sector. A reset during the copies leaves
+*          both copies and the newer one wins at Init; after the reclaim record
+*          the sector is erased at Init.
+*
+* \param[out] pDone  TRUE when the sector was erased
+*
+********************************************************************************** */
+static kvStatus_t KVStore_CompactStep(bool_t *pDone)
+{
+    kvRecordHeader_t header;
+    uint32_t sector = KVStore_OldestSector();
+    uint32_t location;
+    kvStatus_t status = gKVStoreSuccess_c;
+    bool_t valid;
+
+    *pDone = FALSE;
+
+    if( 0 == mKVCompactOffset )
+    {
+        /* All the copies go to one sector: the append sector if they fit in it,
+         * else a new one, which then holds nothing but copies until the end */
+        if( (sector == mKVHead) || (maKVLive[sector] + mKVMarkerSize_c > mpKVStorage->sectorSize - mKVWriteOffset) )
+        {
+            status = KVStore_OpenSector(FALSE);
+
+            if( gKVStoreSuccess_c != status )
+            {
+                return status;
+            }
+        }
+
+        mKVCompactOffset = sizeof(kvSectorHeader_t);
+    }
+
+    if( mKVCompactOffset < maKVEnd[sector] )
+    {
+        if( !KVStore_ReadRecord(sector, mKVCompactOffset, &header, &valid) || !valid )
+        {
+            return gKVStoreFlashError_c;
+        }
+
+        location = sector * mpKVStorage->sectorSize + mKVCompactOffset;
+
+        if( (mKVReclaimKey_c != header.key) && (maKVIndex[header.key] == location) )
+        {
+            status = KVStore_Append(header.key, &maKVRecord[sizeof(kvRecordHeader_t)], header.length, FALSE);
+        }
+
+        if( gKVStoreSuccess_c == status )
+        {
+            mKVCompactOffset += mKVRecordSize_m(header.length);
+        }
+    }
+    else if( !mKVCompactMarked )
+    {
+        status = KVStore_Append(mKVReclaimKey_c, (const uint8_t *)&maKVSequence[sector], sizeof(uint32_t), FALSE);
+        mKVCompactMarked = (gKVStoreSuccess_c == status) ? TRUE : FALSE;
+    }
+    else
+    {
+        status = KVStore_EraseSector(sector);
+
+        if( gKVStoreSuccess_c == status )
+        {
+            mKVCompactOffset = 0;
+            mKVCompactMarked = FALSE;
+            mKVStats.compactions++;
+            *pDone = TRUE;
+        }
+    }
+
+    return status;
+}
+
+/*! *********************************************************************************
+* \brief   Appends a record, reclaiming sectors while the region is full. An
+*          unchanged value is not written again.
+*
+********************************************************************************** */
+static kvStatus_t KVStore_Write(uint16_t key, const uint8_t *pData, uint16_t length)
+{
+    kvStatus_t status;
+    uint32_t reclaimed = 0;
+    bool_t done;
+
+    if( (NULL != pData) && (mKVNoRecord_c != maKVIndex[key]) && (maKVLength[key] == length) &&
+        mpKVStorage->read(mpKVStorage->baseAddr + maKVIndex[key] + sizeof(kvRecordHeader_t), length,
+                          &maKVRecord[sizeof(kvRecordHeader_t)]) &&
+        FLib_MemCmp(&maKVRecord[sizeof(kvRecordHeader_t)], (void *)pData, length) )
+    {
+        return gKVStoreSuccess_c;
+    }
+
+    /* A reclaim started by KVStore_Idle() is finished first, so that its copies
+     * still fit where they were meant to go */
+    status = gKVStoreSuccess_c;
+
+    while( mKVCompactOffset && (gKVStoreSuccess_c == status) )
+    {
+        status = KVStore_CompactStep(&done);
+    }
+
+    if( gKVStoreSuccess_c == status )
+    {
+        status = KVStore_Append(key, pData, length, TRUE);
+    }
+
+    /* Every reclaim frees a sector, after a full turn of the ring the live records fill it */
+    while( (gKVStoreFull_c == status) && (reclaimed < mKVSectors) )
+    {
+        do
+        {
+            status = KVStore_CompactStep(&done);
+        } while( (gKVStoreSuccess_c == status) && !done );
+
+        if( gKVStoreSuccess_c != status )
+        {
+            break;
+        }
+
+        reclaimed++;
+        status = KVStore_Append(key, pData, length, TRUE);
+    }
+
+    return status;
+}
+
+#if gKVStoreInternalFlashEnabled_d
+static bool_t KVStore_FlashRead(uint32_t addr, uint32_t len, uint8_t *pData)
+{
+    NV_FlashRead(addr, pData, len);
+    return TRUE;
+}
+
+static bool_t KVStore_FlashProgram(uint32_t addr, uint32_t len, const uint8_t *pData)
+{
+    NV_Init();
+    return (kStatus_FLASH_Success == NV_FlashProgram(addr, len, (uint8_t *)pData)) ? TRUE : FALSE;
+}
+
+static bool_t KVStore_FlashErase(uint32_t addr)
+{
+    NV_Init();
+    return (kStatus_FLASH_Success == NV_FlashEraseSector(addr, FSL_FEATURE_FLASH_PFLASH_BLOCK_SECTOR_SIZE)) ?
+           TRUE : FALSE;
+}
+#endif
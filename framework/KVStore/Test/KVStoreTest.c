@@ -0,0 +1,379 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file KVStoreTest.c
+* Host test for the key-value store. The module source is built in with a
+* simulated NOR flash (program only clears bits, erase works on whole sectors)
+* which can lose power in the middle of any program or erase: part of the units
+* are then written, one is torn, or part of the sector is left unerased. After
+* every cut the store is initialized again and each key must hold either its
+* previous value or the one being written.
+*
+* Build and run with "make" from this directory.
+*/
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define gKVStoreInternalFlashEnabled_d  0
+#include "../Source/KVStore.c"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Stubs
+*************************************************************************************
+********************************************************************************** */
+void FLib_MemCpy(void *pDst, void *pSrc, uint32_t cBytes) { memmove(pDst, pSrc, cBytes); }
+void FLib_MemSet(void *pDst, uint8_t value, uint32_t cBytes) { memset(pDst, value, cBytes); }
+bool_t FLib_MemCmp(void *pData1, void *pData2, uint32_t cBytes) { return 0 == memcmp(pData1, pData2, cBytes); }
+void panic(panicId_t id, uint32_t location, uint32_t extra1, uint32_t extra2) { abort(); }
+
+#define mMaxFlashSize_c     (gKVStoreMaxSectors_c * 4096)
+
+static uint8_t  maFlash[mMaxFlashSize_c];
+static uint32_t maErases[gKVStoreMaxSectors_c];
+static uint32_t mSectorSize;
+
+/* Power cut: the mCutAt-th flash operation from now is interrupted, -1 for none */
+static int32_t  mCutAt = -1;
+static jmp_buf  mCutJmp;
+
+static bool_t FlashRead(uint32_t addr, uint32_t len, uint8_t *pData)
+{
+    memcpy(pData, &maFlash[addr], len);
+    return TRUE;
+}
+
+static bool_t FlashProgram(uint32_t addr, uint32_t len, const uint8_t *pData)
+{
+    uint32_t units;
+    uint32_t i;
+
+    /* Aligned, and never over a unit that is not erased */
+    if( (addr % gKVStoreProgramUnit_c) || (len % gKVStoreProgramUnit_c) )
+    {
+        abort();
+    }
+    for( i = 0; i < len; i++ )
+    {
+        if( 0xFF != maFlash[addr + i] )
+        {
+            abort();
+        }
+    }
+
+    if( 0 == mCutAt-- )
+    {
+        units = rand() % (len / gKVStoreProgramUnit_c + 1);
+        memcpy(&maFlash[addr], pData, units * gKVStoreProgramUnit_c);
+        for( i = units * gKVStoreProgramUnit_c; (i < len) && (i < (units + 1) * gKVStoreProgramUnit_c); i++ )
+        {
+            maFlash[addr + i] &= (rand() & 1) ? pData[i] : (uint8_t)rand();
+        }
+        longjmp(mCutJmp, 1);
+    }
+
+    memcpy(&maFlash[addr], pData, len);
+    return TRUE;
+}
+
+static bool_t FlashErase(uint32_t addr)
+{
+    uint32_t i;
+
+    if( addr % mSectorSize )
+    {
+        abort();
+    }
+
+    if( 0 == mCutAt-- )
+    {
+        for( i = 0; i < mSectorSize; i++ )
+        {
+            if( rand() & 1 )
+            {
+                maFlash[addr + i] = 0xFF;
+            }
+        }
+        longjmp(mCutJmp, 1);
+    }
+
+    memset(&maFlash[addr], 0xFF, mSectorSize);
+    maErases[addr / mSectorSize]++;
+    return TRUE;
+}
+
+static kvStorage_t mStorage = {0, 0, 0, FlashRead, FlashProgram, FlashErase};
+
+/*! *********************************************************************************
+*************************************************************************************
+* Helpers
+*************************************************************************************
+********************************************************************************** */
+#define CHECK(c)    do { if( !(c) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while(0)
+
+#define mKeys_c     16
+
+/* Expected content of the store */
+static uint8_t  maModel[mKeys_c][gKVStoreMaxValueSize_c];
+static uint16_t maModelLen[mKeys_c];
+
+static void Format(uint32_t sectorSize, uint32_t sectors)
+{
+    mSectorSize = sectorSize;
+    mStorage.size = sectorSize * sectors;
+    mStorage.sectorSize = sectorSize;
+    memset(maFlash, 0xFF, sizeof(maFlash));
+    memset(maErases, 0, sizeof(maErases));
+    memset(maModelLen, 0, sizeof(maModelLen));
+    CHECK(KVStore_Init(&mStorage));
+}
+
+static bool_t Holds(uint16_t key, const uint8_t *pValue, uint16_t len)
+{
+    uint8_t value[gKVStoreMaxValueSize_c];
+    uint16_t got = 0;
+    kvStatus_t status = KVStore_Get(key, value, sizeof(value), &got);
+
+    if( 0 == len )
+    {
+        return gKVStoreNotFound_c == status;
+    }
+    return (gKVStoreSuccess_c == status) && (got == len) && (0 == memcmp(value, pValue, len));
+}
+
+/* Every key holds its model value; the key being written may hold the new one */
+static void Verify(int32_t key, const uint8_t *pValue, uint16_t len)
+{
+    uint16_t k;
+
+    for( k = 0; k < mKeys_c; k++ )
+    {
+        if( Holds(k, maModel[k], maModelLen[k]) )
+        {
+            continue;
+        }
+        CHECK(((int32_t)k == key) && Holds(k, pValue, len));
+        memcpy(maModel[k], pValue, len);
+        maModelLen[k] = len;
+    }
+}
+
+static void RandomValue(uint8_t *pValue, uint16_t len)
+{
+    uint16_t i;
+
+    for( i = 0; i < len; i++ )
+    {
+        pValue[i] = (uint8_t)rand();
+    }
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Tests
+*************************************************************************************
+********************************************************************************** */
+
+/* Set, get and delete, and the argument checks */
+static void TestBasic(void)
+{
+    uint8_t value[gKVStoreMaxValueSize_c + 1] = {0};
+    uint16_t len = 0;
+
+    CHECK(gKVStoreNotInitialized_c == KVStore_Set(0, value, 1));
+
+    /* Unsupported geometries */
+    mStorage.sectorSize = 1020;
+    mStorage.size = 3 * 1020;
+    CHECK(!KVStore_Init(&mStorage));
+    mStorage.sectorSize = 1024;
+    mStorage.size = 2 * 1024;
+    CHECK(!KVStore_Init(&mStorage));
+    mStorage.size = (gKVStoreMaxSectors_c + 1) * 1024;
+    CHECK(!KVStore_Init(&mStorage));
+
+    Format(1024, 4);
+
+    CHECK(gKVStoreInvalidParam_c == KVStore_Set(gKVStoreMaxKeys_c, value, 1));
+    CHECK(gKVStoreInvalidParam_c == KVStore_Set(0, value, 0));
+    CHECK(gKVStoreInvalidParam_c == KVStore_Set(0, value, gKVStoreMaxValueSize_c + 1));
+    CHECK(gKVStoreNotFound_c == KVStore_Get(0, value, sizeof(value), &len));
+
+    CHECK(gKVStoreSuccess_c == KVStore_Set(3, "abc", 3));
+    CHECK(gKVStoreSuccess_c == KVStore_Set(3, "hello", 5));
+    CHECK(gKVStoreBufferTooSmall_c == KVStore_Get(3, value, 4, &len));
+    CHECK(gKVStoreSuccess_c == KVStore_Get(3, value, 5, &len));
+    CHECK((5 == len) && (0 == memcmp(value, "hello", 5)));
+
+    CHECK(gKVStoreSuccess_c == KVStore_Set(gKVStoreMaxKeys_c - 1, value, gKVStoreMaxValueSize_c));
+    CHECK(gKVStoreSuccess_c == KVStore_Delete(3));
+    CHECK(gKVStoreSuccess_c == KVStore_Delete(3));
+    CHECK(gKVStoreNotFound_c == KVStore_Get(3, value, sizeof(value), &len));
+
+    /* The records survive a reset, the deletion too */
+    CHECK(KVStore_Init(&mStorage));
+    CHECK(gKVStoreNotFound_c == KVStore_Get(3, value, sizeof(value), &len));
+    CHECK(gKVStoreSuccess_c == KVStore_Get(gKVStoreMaxKeys_c - 1, value, sizeof(value), &len));
+    CHECK(gKVStoreMaxValueSize_c == len);
+}
+
+/* Live records that do not fit are refused, the stored ones are kept */
+static void TestFull(void)
+{
+    uint8_t value[gKVStoreMaxValueSize_c];
+    uint16_t key;
+    kvStatus_t status = gKVStoreSuccess_c;
+
+    Format(1024, 3);
+    for( key = 0; (key < gKVStoreMaxKeys_c) && (gKVStoreSuccess_c == status); key++ )
+    {
+        RandomValue(value, sizeof(value));
+        status = KVStore_Set(key, value, sizeof(value));
+        if( gKVStoreSuccess_c == status )
+        {
+            memcpy(maModel[key], value, sizeof(value));
+            maModelLen[key] = sizeof(value);
+        }
+    }
+    CHECK(gKVStoreFull_c == status);
+    Verify(-1, NULL, 0);
+
+    /* Freeing a key makes room again */
+    CHECK(gKVStoreSuccess_c == KVStore_Delete(0));
+    maModelLen[0] = 0;
+    CHECK(gKVStoreSuccess_c == KVStore_Set(key - 1, value, sizeof(value)));
+    memcpy(maModel[key - 1], value, sizeof(value));
+    maModelLen[key - 1] = sizeof(value);
+    CHECK(KVStore_Init(&mStorage));
+    Verify(-1, NULL, 0);
+}
+
+/* Updates are spread over the ring, the write amplification stays low */
+static void TestWear(void)
+{
+    uint8_t value[64];
+    kvStats_t stats;
+    uint32_t least = 0xFFFFFFFFU;
+    uint32_t most = 0;
+    uint32_t i;
+    uint16_t key;
+
+    Format(4096, 4);
+    for( i = 0; i < 100000; i++ )
+    {
+        key = rand() % mKeys_c;
+        RandomValue(value, sizeof(value));
+        CHECK(gKVStoreSuccess_c == KVStore_Set(key, value, sizeof(value)));
+        memcpy(maModel[key], value, sizeof(value));
+        maModelLen[key] = sizeof(value);
+        if( 0 == (i % 8) )
+        {
+            KVStore_Idle();
+        }
+    }
+    Verify(-1, NULL, 0);
+
+    KVStore_GetStats(&stats);
+    for( i = 0; i < 4; i++ )
+    {
+        least = (maErases[i] < least) ? maErases[i] : least;
+        most = (maErases[i] > most) ? maErases[i] : most;
+    }
+    printf("wear: %u updates of %u bytes, write amplification %u.%02u, %u..%u erases per sector\n",
+           100000U, (unsigned)sizeof(value), stats.programmedBytes / stats.userBytes,
+           (stats.programmedBytes % stats.userBytes) * 100U / stats.userBytes, least, most);
+    CHECK(stats.programmedBytes < 2 * stats.userBytes);
+    CHECK(most - least <= 1);
+}
+
+/* Random operations with power cuts in the middle of the flash accesses */
+static void TestPowerCut(uint32_t sectorSize, uint32_t sectors, uint16_t maxLen, uint32_t seed)
+{
+    /* Static, they live across the longjmp() of a power cut */
+    static uint8_t value[gKVStoreMaxValueSize_c];
+    static uint16_t len;
+    static int32_t key;
+    static uint32_t cuts;
+    static uint32_t i;
+    static int op;
+    kvStatus_t status;
+
+    srand(seed);
+    Format(sectorSize, sectors);
+    cuts = 0;
+
+    for( i = 0; i < 20000; i++ )
+    {
+        key = rand() % mKeys_c;
+        op = rand() % 100;
+        len = 0;
+        if( op < 80 )
+        {
+            len = 1 + rand() % maxLen;
+            RandomValue(value, len);
+        }
+        mCutAt = (0 == rand() % 4) ? rand() % 4 : -1;
+
+        if( setjmp(mCutJmp) )
+        {
+            cuts++;
+            mCutAt = -1;
+            CHECK(KVStore_Init(&mStorage));
+            Verify((op < 90) ? key : -1, value, len);
+            continue;
+        }
+
+        if( op < 80 )
+        {
+            status = KVStore_Set(key, value, len);
+            CHECK((gKVStoreSuccess_c == status) || (gKVStoreFull_c == status));
+            if( gKVStoreSuccess_c == status )
+            {
+                memcpy(maModel[key], value, len);
+                maModelLen[key] = len;
+            }
+        }
+        else if( op < 90 )
+        {
+            CHECK(gKVStoreSuccess_c == KVStore_Delete(key));
+            maModelLen[key] = 0;
+        }
+        else
+        {
+            KVStore_Idle();
+        }
+        mCutAt = -1;
+
+        if( 0 == (i % 97) )
+        {
+            Verify(-1, NULL, 0);
+        }
+    }
+
+    CHECK(KVStore_Init(&mStorage));
+    Verify(-1, NULL, 0);
+    printf("power cut: %u sectors of %u bytes, %u cuts\n", sectors, sectorSize, cuts);
+}
+
+int main(void)
+{
+    uint32_t seed;
+
+    TestBasic();
+    TestFull();
+    TestWear();
+    TestPowerCut(1024, 4, 48, 1);
+    TestPowerCut(4096, 4, gKVStoreMaxValueSize_c, 2);
+    TestPowerCut(2048, 8, 128, 3);
+    for( seed = 10; seed < 16; seed++ )
+    {
+        TestPowerCut((seed & 1) ? 1024 : 2048, 3 + seed % 5, 96, seed);
+    }
+
+    printf("KVStore: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,5 @@
+/* Host build stub: the test is single threaded, the store takes no mutex */
+#ifndef _FSL_OS_ABSTRACTION_H_
+#define _FSL_OS_ABSTRACTION_H_
+#define USE_RTOS    0
+#endif
@@ -89,7 +89,7 @@ extern __attribute__((weak)) uint32_t MEM_GetTimeStamp(void);
 #endif
 
 /* Allocate a block from the memory pools forever.*/
-#define MEM_BufferAllocForever(numBytes,poolId)   MEM_BufferAllocWithId(numBytes, poolId, (void*)((uint32_t)__get_LR() | 0x80000000 ))
+#define MEM_BufferAllocForever(numBytes,poolId)   MEM_BufferAllocWithId(numBytes, poolId, (void*)((uintptr_t)__get_LR() | 0x80000000 ))
 
 
 /*! *********************************************************************************
@@ -42,6 +42,7 @@
 #include "Panic.h"
 #include "MemManager.h"
 #include "FunctionLib.h"
+#include "DeferredLog.h"
 
 /*! *********************************************************************************
 *************************************************************************************
@@ -365,7 +366,8 @@ void *pCaller
     
     OSA_InterruptEnable();
 
-    shell_write("\r\nOut of memory on K64!!!\r\n");
+    /* Interrupts were just re-enabled: do not format and print from here */
+    DLOG_PRINTF("\r\nOut of memory on K64!!!\r\n");
 
     return NULL;
 }
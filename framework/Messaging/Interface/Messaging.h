@@ -53,6 +53,28 @@
 #define  anchor_t        list_t
 #define  msgQueue_t      list_t
 
+/* Producers allowed on a lock-free message queue */
+typedef enum
+{
+  gMsgQueueSpsc_c = 0,   /* one producer, one consumer: bounded ring of message pointers */
+  gMsgQueueMpsc_c        /* any number of producers, tasks or ISRs, one consumer: unbounded */
+}msgQueueType_t;
+
+/* Lock-free message queue. The fields are private, use the MSG_LfQueue* API.
+ * The MPSC queue links the messages through their MemManager header. Producers
+ * push on the inbox stack with LDREX/STREX, the consumer takes the whole stack
+ * at once and keeps it in FIFO order in the outbox. */
+typedef struct msgLfQueue_tag
+{
+  listElement_t * volatile pInbox;
+  listElement_t           *pOutbox;
+  void                   **ppRing;
+  volatile uint32_t        head;
+  volatile uint32_t        tail;
+  uint32_t                 size;
+  msgQueueType_t           type;
+}msgLfQueue_t;
+
 /************************************************************************************
 *************************************************************************************
 * Public macros
@@ -78,6 +100,12 @@
 #define  MSG_Free(element)          MEM_BufferFree(element)
 #define  MSG_FreeQueue(anchor)      while(MSG_Pending(anchor)) { MSG_Free(MSG_DeQueue(anchor)); }
 
+/* Lock-free counterparts of the queue macros above, see msgLfQueue_t */
+#define MSG_LfQueue(pQueue, element)  MSG_LfQueuePut((pQueue), (element))
+#define MSG_LfDeQueue(pQueue)         MSG_LfQueueGet(pQueue)
+#define MSG_LfPending(pQueue)         MSG_LfQueuePending(pQueue)
+#define MSG_LfFreeQueue(pQueue)       while(MSG_LfPending(pQueue)) { MSG_Free(MSG_LfDeQueue(pQueue)); }
+
 /************************************************************************************
 *************************************************************************************
 * Public prototypes
@@ -92,6 +120,11 @@ void *ListRemoveHeadMsg( listHandle_t list );
 void *ListGetHeadMsg   ( listHandle_t list );
 void *ListGetNextMsg   ( void* pMsg );
 
+void MSG_LfQueueInit( msgLfQueue_t *pQueue, msgQueueType_t type, void **ppRing, uint32_t size );
+listStatus_t MSG_LfQueuePut( msgLfQueue_t *pQueue, void *pMsg );
+void *MSG_LfQueueGet( msgLfQueue_t *pQueue );
+bool_t MSG_LfQueuePending( msgLfQueue_t *pQueue );
+
 /*================================================================================================*/
 
 #endif  /* _MESSAGING_H */
@@ -40,13 +40,30 @@
 #include "EmbeddedTypes.h"
 #include "MemManager.h"
 #include "Messaging.h"
+#include "Panic.h"
 #include "fsl_os_abstraction.h"
+#include "fsl_common.h"
 
 /************************************************************************************
 *************************************************************************************
 * Private macros
 *************************************************************************************
 ************************************************************************************/
+/* Use the exclusive monitor on ARMv7-M. Other cores fall back to masking interrupts. */
+#if defined(__CORTEX_M) && (__CORTEX_M >= 3U)
+#define mMsgUseExclusives_d         1
+#define mMsgBarrier_m()             __DMB()
+#else
+#define mMsgUseExclusives_d         0
+#define mMsgBarrier_m()             __asm volatile ("" ::: "memory")
+#endif
+
+/* Exclusive load and store of a message link. A host build with wider pointers
+ * provides its own. */
+#ifndef mMsgLoadExclusive_m
+#define mMsgLoadExclusive_m(ppLink)         ((listElement_t*)__LDREXW( (volatile uint32_t*)(ppLink) ))
+#define mMsgStoreExclusive_m(ppLink, pElem) __STREXW( (uint32_t)(pElem), (volatile uint32_t*)(ppLink) )
+#endif
 
 /************************************************************************************
 *************************************************************************************
@@ -177,22 +194,10 @@ void *ListRemoveHeadMsg(listHandle_t list)
 ********************************************************************************** */
 void *ListGetHeadMsg( listHandle_t list )
 {
-    listHeader_t *p;
-
-    OSA_InterruptDisable();
-    
-    if( list->head )
-    {
-        p = (listHeader_t*)(list->head) + 1;
-    }
-    else
-    {
-        p = NULL;
-    }
-    
-    OSA_InterruptEnable();
+    /* A single aligned load, no need to mask interrupts */
+    listElement_t *pHead = list->head;
 
-    return p;
+    return pHead ? (listHeader_t*)pHead + 1 : NULL;
 }
 
 /*! *********************************************************************************
@@ -212,24 +217,10 @@ void *ListGetHeadMsg( listHandle_t list )
 ********************************************************************************** */
 void *ListGetNextMsg( void* pMsg )
 {
-    listHeader_t *p;
-
-    OSA_InterruptDisable();
-    
-    p = (listHeader_t*)pMsg - 1;
-
-    if( p->link.next )
-    {
-        p = (listHeader_t*)(p->link.next) + 1;
-    }
-    else
-    {
-        p = NULL;
-    }
+    /* A single aligned load, no need to mask interrupts */
+    listElement_t *pNext = ((listHeader_t*)pMsg - 1)->link.next;
 
-    OSA_InterruptEnable();
-    
-    return p;
+    return pNext ? (listHeader_t*)pNext + 1 : NULL;
 }
 
 /*! *********************************************************************************
@@ -252,3 +243,207 @@ listStatus_t ListRemoveMsg( void* pMsg )
 
     return ListRemoveElement( (listElementHandle_t)p );
 }
+
+/*! *********************************************************************************
+* \brief     Initializes a lock-free message queue.
+*
+* \param[in] pQueue - pointer to the queue
+*            type - gMsgQueueSpsc_c or gMsgQueueMpsc_c
+*            ppRing - storage for size message pointers, SPSC only, NULL for MPSC
+*            size - number of entries of ppRing, a power of 2, SPSC only
+*
+* \return None.
+*
+* \pre
+*
+* \post
+*
+* \remarks An SPSC queue must only be written by one task or ISR and read by one
+*          task or ISR. An MPSC queue may be written from any context.
+*
+********************************************************************************** */
+void MSG_LfQueueInit( msgLfQueue_t *pQueue, msgQueueType_t type, void **ppRing, uint32_t size )
+{
+    if( (gMsgQueueSpsc_c == type) && ((NULL == ppRing) || (0 == size) || (size & (size - 1))) )
+    {
+        panic( 0, (uint32_t)MSG_LfQueueInit, 0, 0 );
+    }
+
+    pQueue->pInbox = NULL;
+    pQueue->pOutbox = NULL;
+    pQueue->ppRing = ppRing;
+    pQueue->head = 0;
+    pQueue->tail = 0;
+    pQueue->size = size;
+    pQueue->type = type;
+}
+
+/*! *********************************************************************************
+* \brief     Adds a message to the tail of a lock-free queue, without masking
+*            interrupts on ARMv7-M.
+*
+* \param[in] pQueue - pointer to the queue
+*            pMsg - data block to add
+*
+* \return gListOk_c, or gListFull_c if the ring of an SPSC queue is full.
+*
+* \pre Buffer must be allocated using MemManager.
+*
+* \post
+*
+* \remarks
+*
+********************************************************************************** */
+listStatus_t MSG_LfQueuePut( msgLfQueue_t *pQueue, void *pMsg )
+{
+    listElement_t *pElem = &((listHeader_t*)pMsg - 1)->link;
+    listElement_t *pTop;
+    uint32_t head;
+
+    if( gMsgQueueSpsc_c == pQueue->type )
+    {
+        head = pQueue->head;
+
+        if( (head - pQueue->tail) >= pQueue->size )
+        {
+            return gListFull_c;
+        }
+
+        pQueue->ppRing[head & (pQueue->size - 1)] = pMsg;
+
+        /* Publish the entry before the index */
+        mMsgBarrier_m();
+        pQueue->head = head + 1;
+
+        return gListOk_c;
+    }
+
+    /* Publish the message contents before the message */
+    mMsgBarrier_m();
+
+#if mMsgUseExclusives_d
+    do
+    {
+        pTop = mMsgLoadExclusive_m( &pQueue->pInbox );
+        pElem->next = pTop;
+    } while( mMsgStoreExclusive_m( &pQueue->pInbox, pElem ) );
+#else
+    OSA_InterruptDisable();
+    pTop = pQueue->pInbox;
+    pElem->next = pTop;
+    pQueue->pInbox = pElem;
+    OSA_InterruptEnable();
+#endif
+
+    return gListOk_c;
+}
+
+/*! *********************************************************************************
+* \brief     Removes the message at the head of a lock-free queue. Must only be
+*            called by the consumer of the queue.
+*
+* \param[in] pQueue - pointer to the queue
+*
+* \return NULL if the queue is empty.
+*         pointer to the data block if removal was successful.
+*
+* \pre
+*
+* \post
+*
+* \remarks
+*
+********************************************************************************** */
+void *MSG_LfQueueGet( msgLfQueue_t *pQueue )
+{
+    listElement_t *pList;
+    listElement_t *pNext;
+    listElement_t *pFifo;
+    uint32_t tail;
+    void *pMsg;
+
+    if( gMsgQueueSpsc_c == pQueue->type )
+    {
+        tail = pQueue->tail;
+
+        if( tail == pQueue->head )
+        {
+            return NULL;
+        }
+
+        mMsgBarrier_m();
+        pMsg = pQueue->ppRing[tail & (pQueue->size - 1)];
+
+        /* Read the entry before giving the slot back to the producer */
+        mMsgBarrier_m();
+        pQueue->tail = tail + 1;
+
+        return pMsg;
+    }
+
+    if( (NULL == pQueue->pOutbox) && (NULL != pQueue->pInbox) )
+    {
+        /* Take all the pushed messages at once, they are in LIFO order */
+#if mMsgUseExclusives_d
+        do
+        {
+            pList = mMsgLoadExclusive_m( &pQueue->pInbox );
+        } while( mMsgStoreExclusive_m( &pQueue->pInbox, NULL ) );
+#else
+        OSA_InterruptDisable();
+        pList = pQueue->pInbox;
+        pQueue->pInbox = NULL;
+        OSA_InterruptEnable();
+#endif
+        mMsgBarrier_m();
+
+        pFifo = NULL;
+
+        while( pList )
+        {
+            pNext = pList->next;
+            pList->next = pFifo;
+            pFifo = pList;
+            pList = pNext;
+        }
+
+        pQueue->pOutbox = pFifo;
+    }
+
+    pList = pQueue->pOutbox;
+
+    if( NULL == pList )
+    {
+        return NULL;
+    }
+
+    pQueue->pOutbox = pList->next;
+    pList->next = NULL;
+
+    return (listHeader_t*)pList + 1;
+}
+
+/*! *********************************************************************************
+* \brief     Checks if a message is pending in a lock-free queue.
+*
+* \param[in] pQueue - pointer to the queue
+*
+* \return TRUE if any pending messages, and FALSE otherwise.
+*
+* \pre
+*
+* \post
+*
+* \remarks Exact when called by the consumer. From other contexts the result
+*          may already be outdated on return.
+*
+********************************************************************************** */
+bool_t MSG_LfQueuePending( msgLfQueue_t *pQueue )
+{
+    if( gMsgQueueSpsc_c == pQueue->type )
+    {
+        return (pQueue->head != pQueue->tail);
+    }
+
+    return (NULL != pQueue->pOutbox) || (NULL != pQueue->pInbox);
+}
@@ -0,0 +1,450 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file MessagingTest.c
+* Host test for the lock-free message queues. The module source is built in
+* as for a Cortex-M4, with LDREX/STREX emulated by compare-and-swap that also
+* fails now and then, as the exclusive monitor does when an interrupt hits.
+* Producer and consumer threads stress both queue types, then the put latency
+* of the MPSC queue is compared with the interrupt masked list under the same
+* load. OSA_InterruptDisable() is a mutex shared by all threads.
+*
+* Build and run with "make" from this directory.
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*! *********************************************************************************
+*************************************************************************************
+* Exclusive monitor
+*************************************************************************************
+********************************************************************************** */
+static __thread void *tExclusiveValue;
+static __thread uint32_t tExclusiveCount;
+static volatile uint32_t mExclusiveFails;
+
+static void *LoadExclusive(void * volatile *ppLink)
+{
+    tExclusiveValue = __atomic_load_n(ppLink, __ATOMIC_ACQUIRE);
+    return tExclusiveValue;
+}
+
+static uint32_t StoreExclusive(void * volatile *ppLink, void *pValue)
+{
+    void *expected = tExclusiveValue;
+
+    /* The monitor is cleared by an exception return every so often */
+    if( (++tExclusiveCount % 13U) == 0U )
+    {
+        __atomic_add_fetch(&mExclusiveFails, 1, __ATOMIC_RELAXED);
+        return 1;
+    }
+
+    return __atomic_compare_exchange_n(ppLink, &expected, pValue, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? 0 : 1;
+}
+
+#define mMsgLoadExclusive_m(ppLink)         ((listElement_t*)LoadExclusive( (void * volatile *)(ppLink) ))
+#define mMsgStoreExclusive_m(ppLink, pElem) StoreExclusive( (void * volatile *)(ppLink), (pElem) )
+
+#include "../Source/Messaging.c"
+#include "../../Lists/GenericList.c"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Stubs
+*************************************************************************************
+********************************************************************************** */
+static pthread_mutex_t mIrqLock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t mPanics;
+
+void OSA_InterruptDisable(void) { pthread_mutex_lock(&mIrqLock); }
+void OSA_InterruptEnable(void)  { pthread_mutex_unlock(&mIrqLock); }
+void panic(panicId_t id, uint32_t location, uint32_t extra1, uint32_t extra2)
+{ (void)id; (void)location; (void)extra1; (void)extra2; mPanics++; }
+
+void *MEM_BufferAlloc(uint32_t numBytes)
+{
+    listHeader_t *pHeader = calloc(1, sizeof(listHeader_t) + numBytes);
+
+    return pHeader ? pHeader + 1 : NULL;
+}
+
+uint8_t MEM_BufferFree(void *buffer)
+{
+    free((listHeader_t*)buffer - 1);
+    return 0;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Tests
+*************************************************************************************
+********************************************************************************** */
+#define CHECK(c)    do { if( !(c) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while(0)
+
+#define mProducers_c        4U
+#define mMsgPerProducer_c   250000U
+#define mRingSize_c         64U
+#define mLatencySamples_c   200000U
+#define mLatencyBuckets_c   16U
+#define mMaxInFlight_c      1024U   /* list_t counts its elements in 16 bits */
+
+typedef struct testMsg_tag
+{
+    uint32_t producer;
+    uint32_t seq;
+}testMsg_t;
+
+typedef struct producer_tag
+{
+    pthread_t   thread;
+    uint32_t    id;
+    uint32_t    count;
+    uint32_t    fullHits;
+    bool_t      lockFree;
+    uint32_t    histogram[mLatencyBuckets_c];
+    uint32_t   *pSamples;
+}producer_t;
+
+static msgLfQueue_t mQueue;
+static void *mRing[mRingSize_c];
+static list_t mList;
+static volatile uint32_t mStart;
+static volatile uint32_t mInFlight;
+
+static testMsg_t *NewMsg(uint32_t producer, uint32_t seq)
+{
+    testMsg_t *pMsg = MSG_AllocType(testMsg_t);
+
+    CHECK(pMsg != NULL);
+    pMsg->producer = producer;
+    pMsg->seq = seq;
+    return pMsg;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+
+/* Single threaded behaviour of both queue types */
+static void TestApi(void)
+{
+    msgLfQueue_t queue;
+    void *ring[4];
+    testMsg_t *pMsg[6];
+    uint32_t i;
+
+    /* The SPSC ring must be a power of 2 */
+    MSG_LfQueueInit(&queue, gMsgQueueSpsc_c, ring, 3);
+    CHECK(mPanics == 1);
+    MSG_LfQueueInit(&queue, gMsgQueueSpsc_c, NULL, 4);
+    CHECK(mPanics == 2);
+    MSG_LfQueueInit(&queue, gMsgQueueMpsc_c, NULL, 0);
+    CHECK(mPanics == 2);
+
+    /* SPSC: bounded, FIFO, across the wrap */
+    MSG_LfQueueInit(&queue, gMsgQueueSpsc_c, ring, 4);
+    CHECK(!MSG_LfPending(&queue));
+    CHECK(MSG_LfDeQueue(&queue) == NULL);
+    for( i = 0; i < 6; i++ )
+    {
+        pMsg[i] = NewMsg(0, i);
+    }
+    for( i = 0; i < 4; i++ )
+    {
+        CHECK(MSG_LfQueue(&queue, pMsg[i]) == gListOk_c);
+    }
+    CHECK(MSG_LfQueue(&queue, pMsg[4]) == gListFull_c);
+    CHECK(MSG_LfDeQueue(&queue) == pMsg[0]);
+    CHECK(MSG_LfQueue(&queue, pMsg[4]) == gListOk_c);
+    CHECK(MSG_LfDeQueue(&queue) == pMsg[1]);
+    CHECK(MSG_LfQueue(&queue, pMsg[5]) == gListOk_c);
+    for( i = 2; i < 6; i++ )
+    {
+        CHECK(MSG_LfPending(&queue));
+        CHECK(MSG_LfDeQueue(&queue) == pMsg[i]);
+    }
+    CHECK(!MSG_LfPending(&queue));
+
+    /* MPSC: unbounded, FIFO while puts and gets interleave */
+    MSG_LfQueueInit(&queue, gMsgQueueMpsc_c, NULL, 0);
+    CHECK(!MSG_LfPending(&queue));
+    CHECK(MSG_LfDeQueue(&queue) == NULL);
+    MSG_LfQueue(&queue, pMsg[0]);
+    MSG_LfQueue(&queue, pMsg[1]);
+    CHECK(MSG_LfPending(&queue));
+    CHECK(MSG_LfDeQueue(&queue) == pMsg[0]);
+    MSG_LfQueue(&queue, pMsg[2]);
+    MSG_LfQueue(&queue, pMsg[3]);
+    CHECK(MSG_LfDeQueue(&queue) == pMsg[1]);
+    CHECK(MSG_LfDeQueue(&queue) == pMsg[2]);
+    MSG_LfQueue(&queue, pMsg[4]);
+    CHECK(MSG_LfDeQueue(&queue) == pMsg[3]);
+    CHECK(MSG_LfDeQueue(&queue) == pMsg[4]);
+    CHECK(!MSG_LfPending(&queue));
+    CHECK(MSG_LfDeQueue(&queue) == NULL);
+
+    /* A message taken off the queue can go on a list again */
+    MSG_LfQueue(&queue, pMsg[5]);
+    CHECK(MSG_LfDeQueue(&queue) == pMsg[5]);
+    CHECK(((listHeader_t*)pMsg[5] - 1)->link.next == NULL);
+    MSG_InitQueue(&mList);
+    CHECK(MSG_Queue(&mList, pMsg[5]) == gListOk_c);
+    CHECK(ListGetHeadMsg(&mList) == pMsg[5]);
+    CHECK(MSG_DeQueue(&mList) == pMsg[5]);
+
+    for( i = 0; i < 6; i++ )
+    {
+        MSG_Free(pMsg[i]);
+    }
+    MSG_LfFreeQueue(&queue);
+    printf("  init checks, SPSC wrap and full, MPSC order across refills\n");
+}
+
+static void *Producer(void *arg)
+{
+    producer_t *pProducer = arg;
+    testMsg_t *pMsg;
+    uint32_t i;
+
+    while( !mStart )
+    {
+        sched_yield();
+    }
+
+    for( i = 0; i < pProducer->count; i++ )
+    {
+        pMsg = NewMsg(pProducer->id, i);
+        while( MSG_LfQueue(&mQueue, pMsg) == gListFull_c )
+        {
+            pProducer->fullHits++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* Receive everything the producers sent, in order per producer */
+static void Consume(uint32_t producers, uint32_t count)
+{
+    uint32_t next[mProducers_c] = {0};
+    uint32_t received = 0;
+    testMsg_t *pMsg;
+
+    while( received < producers * count )
+    {
+        pMsg = MSG_LfDeQueue(&mQueue);
+        if( pMsg == NULL )
+        {
+            sched_yield();
+            continue;
+        }
+        CHECK(pMsg->producer < producers);
+        CHECK(pMsg->seq == next[pMsg->producer]);
+        CHECK(((listHeader_t*)pMsg - 1)->link.next == NULL);
+        next[pMsg->producer]++;
+        received++;
+        MSG_Free(pMsg);
+    }
+    CHECK(!MSG_LfPending(&mQueue));
+    CHECK(MSG_LfDeQueue(&mQueue) == NULL);
+}
+
+static void TestStress(msgQueueType_t type, uint32_t producers)
+{
+    producer_t producer[mProducers_c];
+    uint32_t fullHits = 0;
+    uint32_t i;
+
+    memset(producer, 0, sizeof(producer));
+    mStart = 0;
+    mExclusiveFails = 0;
+    if( type == gMsgQueueSpsc_c )
+    {
+        MSG_LfQueueInit(&mQueue, type, mRing, mRingSize_c);
+    }
+    else
+    {
+        MSG_LfQueueInit(&mQueue, type, NULL, 0);
+    }
+
+    for( i = 0; i < producers; i++ )
+    {
+        producer[i].id = i;
+        producer[i].count = mMsgPerProducer_c * mProducers_c / producers;
+        CHECK(pthread_create(&producer[i].thread, NULL, Producer, &producer[i]) == 0);
+    }
+    mStart = 1;
+    Consume(producers, mMsgPerProducer_c * mProducers_c / producers);
+    for( i = 0; i < producers; i++ )
+    {
+        pthread_join(producer[i].thread, NULL);
+        fullHits += producer[i].fullHits;
+    }
+
+    if( type == gMsgQueueSpsc_c )
+    {
+        printf("  SPSC: 1 producer, %u messages in order, ring full %u times\n",
+               mMsgPerProducer_c * mProducers_c, fullHits);
+    }
+    else
+    {
+        CHECK(mExclusiveFails > 0);
+        printf("  MPSC: %u producers, %u messages, in order per producer, %u exclusive stores retried\n",
+               producers, mMsgPerProducer_c * mProducers_c, mExclusiveFails);
+    }
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Latency
+*************************************************************************************
+********************************************************************************** */
+static void *LatencyProducer(void *arg)
+{
+    producer_t *pProducer = arg;
+    testMsg_t *pMsg;
+    uint64_t t;
+    uint32_t ns;
+    uint32_t bucket;
+    uint32_t i;
+
+    while( !mStart )
+    {
+        sched_yield();
+    }
+
+    for( i = 0; i < pProducer->count; i++ )
+    {
+        while( __atomic_load_n(&mInFlight, __ATOMIC_RELAXED) >= mMaxInFlight_c )
+        {
+            sched_yield();
+        }
+        __atomic_add_fetch(&mInFlight, 1, __ATOMIC_RELAXED);
+
+        pMsg = NewMsg(pProducer->id, i);
+        t = NowNs();
+        if( pProducer->lockFree )
+        {
+            MSG_LfQueue(&mQueue, pMsg);
+        }
+        else
+        {
+            MSG_Queue(&mList, pMsg);
+        }
+        ns = (uint32_t)(NowNs() - t);
+
+        /* log2 buckets from 32 ns up */
+        for( bucket = 0; (bucket < mLatencyBuckets_c - 1U) && (ns >= (64U << bucket)); bucket++ )
+        {
+        }
+        pProducer->histogram[bucket]++;
+        pProducer->pSamples[i] = ns;
+    }
+    return NULL;
+}
+
+static int CompareU32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+static void MeasureLatency(bool_t lockFree)
+{
+    static uint32_t samples[mProducers_c * mLatencySamples_c];
+    producer_t producer[mProducers_c];
+    uint32_t histogram[mLatencyBuckets_c] = {0};
+    const uint32_t total = mProducers_c * mLatencySamples_c;
+    uint32_t received = 0;
+    testMsg_t *pMsg;
+    uint32_t i;
+    uint32_t b;
+
+    memset(producer, 0, sizeof(producer));
+    mStart = 0;
+    mInFlight = 0;
+    MSG_LfQueueInit(&mQueue, gMsgQueueMpsc_c, NULL, 0);
+    MSG_InitQueue(&mList);
+
+    for( i = 0; i < mProducers_c; i++ )
+    {
+        producer[i].id = i;
+        producer[i].count = mLatencySamples_c;
+        producer[i].lockFree = lockFree;
+        producer[i].pSamples = &samples[i * mLatencySamples_c];
+        CHECK(pthread_create(&producer[i].thread, NULL, LatencyProducer, &producer[i]) == 0);
+    }
+    mStart = 1;
+
+    /* The consumer keeps draining while the producers put */
+    while( received < total )
+    {
+        if( lockFree )
+        {
+            pMsg = MSG_LfDeQueue(&mQueue);
+        }
+        else
+        {
+            pMsg = MSG_DeQueue(&mList);
+        }
+        if( pMsg != NULL )
+        {
+            MSG_Free(pMsg);
+            __atomic_sub_fetch(&mInFlight, 1, __ATOMIC_RELAXED);
+            received++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    for( i = 0; i < mProducers_c; i++ )
+    {
+        pthread_join(producer[i].thread, NULL);
+        for( b = 0; b < mLatencyBuckets_c; b++ )
+        {
+            histogram[b] += producer[i].histogram[b];
+        }
+    }
+    qsort(samples, total, sizeof(samples[0]), CompareU32);
+
+    printf("  %s put, %u producers and a consumer draining:\n",
+           lockFree ? "MSG_LfQueue (MPSC)" : "MSG_Queue (masked)", mProducers_c);
+    printf("    p50 %u ns, p99 %u ns, p99.9 %u ns, max %u ns\n", samples[total / 2],
+           samples[(uint64_t)total * 99 / 100], samples[(uint64_t)total * 999 / 1000], samples[total - 1]);
+    for( b = 0; b < mLatencyBuckets_c; b++ )
+    {
+        if( histogram[b] )
+        {
+            printf("    %2s %8u ns %7u %5.1f%%\n", (b == mLatencyBuckets_c - 1U) ? ">=" : " <",
+                   (b == mLatencyBuckets_c - 1U) ? (32U << b) : (64U << b), histogram[b], 100.0 * histogram[b] / total);
+        }
+    }
+}
+
+int main(void)
+{
+    TestApi();
+    TestStress(gMsgQueueSpsc_c, 1);
+    TestStress(gMsgQueueMpsc_c, mProducers_c);
+    MeasureLatency(TRUE);
+    MeasureLatency(FALSE);
+
+    printf("Messaging: all tests passed\n");
+    return 0;
+}
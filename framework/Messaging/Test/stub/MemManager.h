@@ -0,0 +1,16 @@
+/* Host build stub: buffers come from the C heap, behind the same header as a
+   MemManager block */
+#ifndef _MEM_MANAGER_H_
+#define _MEM_MANAGER_H_
+#include "EmbeddedTypes.h"
+#include "GenericList.h"
+
+typedef struct listHeader_tag
+{
+  listElement_t link;
+  struct pools_tag *pParentPool;
+}listHeader_t;
+
+void *MEM_BufferAlloc(uint32_t numBytes);
+uint8_t MEM_BufferFree(void *buffer);
+#endif
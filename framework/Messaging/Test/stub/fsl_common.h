@@ -0,0 +1,10 @@
+/* Host build stub: a Cortex-M4 with the barrier mapped to a full fence. The
+   test provides the exclusive load and store, see MessagingTest.c */
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+#include <stdint.h>
+#include <stddef.h>
+
+#define __CORTEX_M      (4U)
+#define __DMB()         __sync_synchronize()
+#endif
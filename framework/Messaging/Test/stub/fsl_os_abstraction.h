@@ -0,0 +1,6 @@
+/* Host build stub: interrupt masking is a mutex shared by all threads */
+#ifndef _FSL_OS_ABSTRACTION_H_
+#define _FSL_OS_ABSTRACTION_H_
+void OSA_InterruptDisable(void);
+void OSA_InterruptEnable(void);
+#endif
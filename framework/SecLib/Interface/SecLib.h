@@ -0,0 +1,223 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file SecLib.h
+* This is the header file for the security library module.
+* It provides SHA-256, AES-128 and AES-128 CMAC. The hash and the MAC can be
+* fed incrementally, in pieces of any length, so that data received in blocks
+* (e.g. an OTA image) is processed as it arrives, without being kept in RAM.
+*
+* On the parts with an MMCAU the compression function and the block cipher run
+* on the coprocessor (gSecLib_HWSupport_d). The software implementation is used
+* otherwise, and off-target.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* o Redistributions of source code must retain the above copyright notice, this list
+*   of conditions and the following disclaimer.
+*
+* o Redistributions in binary form must reproduce the above copyright notice, this
+*   list of conditions and the following disclaimer in the documentation and/or
+*   other materials provided with the distribution.
+*
+* o Neither the name of the copyright holder nor the names of its
+*   contributors may be used to endorse or promote products derived from this
+*   software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+* ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _SEC_LIB_H_
+#define _SEC_LIB_H_
+
+/*! *********************************************************************************
+*************************************************************************************
+* Include
+*************************************************************************************
+********************************************************************************** */
+#include "EmbeddedTypes.h"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public macros
+*************************************************************************************
+********************************************************************************** */
+
+/*
+ * \brief   Runs SHA-256 and AES on the MMCAU. Needs drivers/fsl_mmcau.c and the
+ *          MMCAU library (cau_api) in the build.
+ */
+#ifndef gSecLib_HWSupport_d
+#define gSecLib_HWSupport_d     0
+#endif
+
+#define SHA256_HASH_SIZE        32      /* bytes */
+#define SHA256_BLOCK_SIZE       64      /* bytes */
+
+#define AES_128_KEY_BYTE_LEN    16
+#define AES_128_BLOCK_SIZE      16      /* bytes */
+#define AES_128_CMAC_SIZE       16      /* bytes */
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public type definitions
+*************************************************************************************
+********************************************************************************** */
+
+/*! SHA-256 context. After SHA256_HashFinish() or SHA256_Hash(), hash holds
+ *  the digest bytes, in order. */
+typedef struct sha256Context_tag
+{
+    uint32_t hash[SHA256_HASH_SIZE / sizeof(uint32_t)];
+    uint32_t buffer[SHA256_BLOCK_SIZE / sizeof(uint32_t)];  /* Partial block */
+    uint32_t totalBytes;
+    uint8_t  bytes;                                         /* Bytes in buffer */
+} sha256Context_t;
+
+/*! AES-128 CMAC context (RFC 4493) */
+typedef struct aesCmacContext_tag
+{
+    uint32_t keySchedule[44];
+    uint8_t  x[AES_128_BLOCK_SIZE];                         /* CBC chaining value */
+    uint8_t  buffer[AES_128_BLOCK_SIZE];                    /* Last block, not encrypted yet */
+    uint8_t  bytes;                                         /* Bytes in buffer */
+} aesCmacContext_t;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public prototypes
+*************************************************************************************
+********************************************************************************** */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! *********************************************************************************
+* \brief   Starts a SHA-256 hash.
+*
+* \param[out] pContext  hash context
+*
+********************************************************************************** */
+void SHA256_Init(sha256Context_t *pContext);
+
+/*! *********************************************************************************
+* \brief   Hashes more data. Whole blocks are hashed at once, the rest is kept in
+*          the context until the next call.
+*
+* \param[in,out] pContext  hash context
+* \param[in]     pData     data, any alignment
+* \param[in]     numBytes  length of the data
+*
+********************************************************************************** */
+void SHA256_HashUpdate(sha256Context_t *pContext, const uint8_t *pData, uint32_t numBytes);
+
+/*! *********************************************************************************
+* \brief   Hashes the last data, pads the message and stores the digest in
+*          pContext->hash.
+*
+* \param[in,out] pContext  hash context
+* \param[in]     pData     last data, may be NULL if numBytes is 0
+* \param[in]     numBytes  length of the data
+*
+********************************************************************************** */
+void SHA256_HashFinish(sha256Context_t *pContext, const uint8_t *pData, uint32_t numBytes);
+
+/*! *********************************************************************************
+* \brief   Hashes a whole message. The digest is stored in pContext->hash.
+*
+* \param[out] pContext  hash context
+* \param[in]  pData     message
+* \param[in]  numBytes  length of the message
+*
+********************************************************************************** */
+void SHA256_Hash(sha256Context_t *pContext, const uint8_t *pData, uint32_t numBytes);
+
+/*! *********************************************************************************
+* \brief   Encrypts one block with AES-128.
+*
+* \param[in]  pInput   16 bytes of plain text
+* \param[in]  pKey     16 bytes key
+* \param[out] pOutput  16 bytes of cipher text, may be pInput
+*
+********************************************************************************** */
+void AES_128_Encrypt(const uint8_t *pInput, const uint8_t *pKey, uint8_t *pOutput);
+
+/*! *********************************************************************************
+* \brief   Starts an AES-128 CMAC.
+*
+* \param[out] pContext  MAC context
+* \param[in]  pKey      16 bytes key
+*
+********************************************************************************** */
+void AES_128_CMAC_Init(aesCmacContext_t *pContext, const uint8_t *pKey);
+
+/*! *********************************************************************************
+* \brief   MACs more data. The last block seen is kept in the context, since the
+*          subkey applied to it is only known at the end of the message.
+*
+* \param[in,out] pContext  MAC context
+* \param[in]     pData     data
+* \param[in]     numBytes  length of the data
+*
+********************************************************************************** */
+void AES_128_CMAC_Update(aesCmacContext_t *pContext, const uint8_t *pData, uint32_t numBytes);
+
+/*! *********************************************************************************
+* \brief   Ends the message and computes the MAC. The key schedule is cleared.
+*
+* \param[in,out] pContext  MAC context
+* \param[out]    pOutput   16 bytes MAC
+*
+********************************************************************************** */
+void AES_128_CMAC_Finish(aesCmacContext_t *pContext, uint8_t *pOutput);
+
+/*! *********************************************************************************
+* \brief   Computes the AES-128 CMAC of a whole message.
+*
+* \param[in]  pInput    message
+* \param[in]  inputLen  length of the message
+* \param[in]  pKey      16 bytes key
+* \param[out] pOutput   16 bytes MAC
+*
+********************************************************************************** */
+void AES_128_CMAC(const uint8_t *pInput, uint32_t inputLen, const uint8_t *pKey, uint8_t *pOutput);
+
+/*! *********************************************************************************
+* \brief   XORs a buffer into another: pDst[i] ^= pSrc[i].
+*
+* \param[in,out] pDst  destination
+* \param[in]     pSrc  source
+* \param[in]     len   number of bytes
+*
+********************************************************************************** */
+void SecLib_XorN(uint8_t *pDst, const uint8_t *pSrc, uint8_t len);
+
+/*! *********************************************************************************
+* \brief   Compares two buffers in a time that does not depend on their content,
+*          for checking a digest or a MAC received from a peer.
+*
+* \param[in] pA   first buffer
+* \param[in] pB   second buffer
+* \param[in] len  number of bytes
+*
+* \return  TRUE if the buffers are equal
+*
+********************************************************************************** */
+bool_t SecLib_VerifyEqual(const uint8_t *pA, const uint8_t *pB, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SEC_LIB_H_ */
@@ -0,0 +1,627 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file SecLib.c
+* This is the source file for the security library module.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* o Redistributions of source code must retain the above copyright notice, this list
+*   of conditions and the following disclaimer.
+*
+* o Redistributions in binary form must reproduce the above copyright notice, this
+*   list of conditions and the following disclaimer in the documentation and/or
+*   other materials provided with the distribution.
+*
+* o Neither the name of the copyright holder nor the names of its
+*   contributors may be used to endorse or promote products derived from this
+*   software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+* ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/*! *********************************************************************************
+*************************************************************************************
+* Include
+*************************************************************************************
+********************************************************************************** */
+#include "EmbeddedTypes.h"
+#include "SecLib.h"
+#include "FunctionLib.h"
+
+#if gSecLib_HWSupport_d
+#include "fsl_mmcau.h"
+#include "fsl_os_abstraction.h"
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private macros
+*************************************************************************************
+********************************************************************************** */
+#define mSha256LengthOffset_c       (SHA256_BLOCK_SIZE - 8)
+#define mAes128Rounds_c             10
+
+#define mRotR32(x, n)               (((x) >> (n)) | ((x) << (32 - (n))))
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private prototypes
+*************************************************************************************
+********************************************************************************** */
+static void SecLib_Sha256InitState(uint32_t *pState);
+static void SecLib_Sha256Blocks(uint32_t *pState, const uint8_t *pData, uint32_t numBlocks);
+static void SecLib_Aes128SetKey(const uint8_t *pKey, uint32_t *pKeySchedule);
+static void SecLib_Aes128Encrypt(const uint8_t *pInput, const uint32_t *pKeySchedule, uint8_t *pOutput);
+static void SecLib_CmacSubkey(uint8_t *pKey);
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private memory declarations
+*************************************************************************************
+********************************************************************************** */
+#if !gSecLib_HWSupport_d
+static const uint32_t mSha256K[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint8_t mAesSBox[256] =
+{
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public functions
+*************************************************************************************
+********************************************************************************** */
+
+/*! *********************************************************************************
+* \brief   Starts a SHA-256 hash.
+*
+* \param[out] pContext  hash context
+*
+********************************************************************************** */
+void SHA256_Init(sha256Context_t *pContext)
+{
+    SecLib_Sha256InitState(pContext->hash);
+    pContext->totalBytes = 0;
+    pContext->bytes = 0;
+}
+
+/*! *********************************************************************************
+* \brief   Hashes more data. Whole blocks are hashed at once, the rest is kept in
+*          the context until the next call.
+*
+* \param[in,out] pContext  hash context
+* \param[in]     pData     data, any alignment
+* \param[in]     numBytes  length of the data
+*
+********************************************************************************** */
+void SHA256_HashUpdate(sha256Context_t *pContext, const uint8_t *pData, uint32_t numBytes)
+{
+    uint8_t *pBuffer = (uint8_t *)pContext->buffer;
+    uint32_t size;
+
+    pContext->totalBytes += numBytes;
+
+    /* Complete the block kept from the previous call */
+    if (pContext->bytes)
+    {
+        size = SHA256_BLOCK_SIZE - pContext->bytes;
+        if (size > numBytes)
+        {
+            size = numBytes;
+        }
+        FLib_MemCpy(&pBuffer[pContext->bytes], (void *)pData, size);
+        pContext->bytes += size;
+        pData += size;
+        numBytes -= size;
+
+        if (pContext->bytes < SHA256_BLOCK_SIZE)
+        {
+            return;
+        }
+        SecLib_Sha256Blocks(pContext->hash, pBuffer, 1);
+        pContext->bytes = 0;
+    }
+
+    /* Whole blocks straight from the caller's data */
+    size = numBytes / SHA256_BLOCK_SIZE;
+    if (size)
+    {
+        SecLib_Sha256Blocks(pContext->hash, pData, size);
+        pData += size * SHA256_BLOCK_SIZE;
+        numBytes -= size * SHA256_BLOCK_SIZE;
+    }
+
+    if (numBytes)
+    {
+        FLib_MemCpy(pBuffer, (void *)pData, numBytes);
+        pContext->bytes = numBytes;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Hashes the last data, pads the message and stores the digest in
+*          pContext->hash.
+*
+* \param[in,out] pContext  hash context
+* \param[in]     pData     last data, may be NULL if numBytes is 0
+* \param[in]     numBytes  length of the data
+*
+********************************************************************************** */
+void SHA256_HashFinish(sha256Context_t *pContext, const uint8_t *pData, uint32_t numBytes)
+{
+    uint8_t *pBuffer = (uint8_t *)pContext->buffer;
+    uint8_t *pHash = (uint8_t *)pContext->hash;
+    uint32_t word;
+    uint32_t i;
+
+    if (numBytes)
+    {
+        SHA256_HashUpdate(pContext, pData, numBytes);
+    }
+
+    pBuffer[pContext->bytes++] = 0x80;
+
+    if (pContext->bytes > mSha256LengthOffset_c)
+    {
+        FLib_MemSet(&pBuffer[pContext->bytes], 0, SHA256_BLOCK_SIZE - pContext->bytes);
+        SecLib_Sha256Blocks(pContext->hash, pBuffer, 1);
+        pContext->bytes = 0;
+    }
+    FLib_MemSet(&pBuffer[pContext->bytes], 0, mSha256LengthOffset_c - pContext->bytes);
+
+    /* Message length in bits, big endian */
+    word = pContext->totalBytes >> 29;
+    pBuffer[56] = (uint8_t)(word >> 24);
+    pBuffer[57] = (uint8_t)(word >> 16);
+    pBuffer[58] = (uint8_t)(word >> 8);
+    pBuffer[59] = (uint8_t)word;
+    word = pContext->totalBytes << 3;
+    pBuffer[60] = (uint8_t)(word >> 24);
+    pBuffer[61] = (uint8_t)(word >> 16);
+    pBuffer[62] = (uint8_t)(word >> 8);
+    pBuffer[63] = (uint8_t)word;
+    SecLib_Sha256Blocks(pContext->hash, pBuffer, 1);
+    pContext->bytes = 0;
+
+    /* The state words are stored as the big endian digest bytes */
+    for (i = 0; i < SHA256_HASH_SIZE / sizeof(uint32_t); i++)
+    {
+        word = pContext->hash[i];
+        pHash[4 * i]     = (uint8_t)(word >> 24);
+        pHash[4 * i + 1] = (uint8_t)(word >> 16);
+        pHash[4 * i + 2] = (uint8_t)(word >> 8);
+        pHash[4 * i + 3] = (uint8_t)word;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Hashes a whole message. The digest is stored in pContext->hash.
+*
+* \param[out] pContext  hash context
+* \param[in]  pData     message
+* \param[in]  numBytes  length of the message
+*
+********************************************************************************** */
+void SHA256_Hash(sha256Context_t *pContext, const uint8_t *pData, uint32_t numBytes)
+{
+    SHA256_Init(pContext);
+    SHA256_HashFinish(pContext, pData, numBytes);
+}
+
+/*! *********************************************************************************
+* \brief   Encrypts one block with AES-128.
+*
+* \param[in]  pInput   16 bytes of plain text
+* \param[in]  pKey     16 bytes key
+* \param[out] pOutput  16 bytes of cipher text, may be pInput
+*
+********************************************************************************** */
+void AES_128_Encrypt(const uint8_t *pInput, const uint8_t *pKey, uint8_t *pOutput)
+{
+    uint32_t keySchedule[44];
+
+    SecLib_Aes128SetKey(pKey, keySchedule);
+    SecLib_Aes128Encrypt(pInput, keySchedule, pOutput);
+    FLib_MemSet(keySchedule, 0, sizeof(keySchedule));
+}
+
+/*! *********************************************************************************
+* \brief   Starts an AES-128 CMAC.
+*
+* \param[out] pContext  MAC context
+* \param[in]  pKey      16 bytes key
+*
+********************************************************************************** */
+void AES_128_CMAC_Init(aesCmacContext_t *pContext, const uint8_t *pKey)
+{
+    SecLib_Aes128SetKey(pKey, pContext->keySchedule);
+    FLib_MemSet(pContext->x, 0, AES_128_BLOCK_SIZE);
+    pContext->bytes = 0;
+}
+
+/*! *********************************************************************************
+* \brief   MACs more data. The last block seen is kept in the context, since the
+*          subkey applied to it is only known at the end of the message.
+*
+* \param[in,out] pContext  MAC context
+* \param[in]     pData     data
+* \param[in]     numBytes  length of the data
+*
+********************************************************************************** */
+void AES_128_CMAC_Update(aesCmacContext_t *pContext, const uint8_t *pData, uint32_t numBytes)
+{
+    uint32_t size;
+
+    while (numBytes)
+    {
+        /* More data follows the kept block, so it is not the last one */
+        if (pContext->bytes == AES_128_BLOCK_SIZE)
+        {
+            SecLib_XorN(pContext->x, pContext->buffer, AES_128_BLOCK_SIZE);
+            SecLib_Aes128Encrypt(pContext->x, pContext->keySchedule, pContext->x);
+            pContext->bytes = 0;
+        }
+
+        size = AES_128_BLOCK_SIZE - pContext->bytes;
+        if (size > numBytes)
+        {
+            size = numBytes;
+        }
+        FLib_MemCpy(&pContext->buffer[pContext->bytes], (void *)pData, size);
+        pContext->bytes += size;
+        pData += size;
+        numBytes -= size;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Ends the message and computes the MAC. The key schedule is cleared.
+*
+* \param[in,out] pContext  MAC context
+* \param[out]    pOutput   16 bytes MAC
+*
+********************************************************************************** */
+void AES_128_CMAC_Finish(aesCmacContext_t *pContext, uint8_t *pOutput)
+{
+    uint8_t subkey[AES_128_BLOCK_SIZE] = {0};
+
+    /* K1 = dbl(E(K, 0)), K2 = dbl(K1) */
+    SecLib_Aes128Encrypt(subkey, pContext->keySchedule, subkey);
+    SecLib_CmacSubkey(subkey);
+
+    if (pContext->bytes < AES_128_BLOCK_SIZE)
+    {
+        /* Incomplete (or empty) last block: pad with 10..0 and use K2 */
+        SecLib_CmacSubkey(subkey);
+        pContext->buffer[pContext->bytes] = 0x80;
+        FLib_MemSet(&pContext->buffer[pContext->bytes + 1], 0, AES_128_BLOCK_SIZE - 1 - pContext->bytes);
+    }
+
+    SecLib_XorN(pContext->buffer, subkey, AES_128_BLOCK_SIZE);
+    SecLib_XorN(pContext->x, pContext->buffer, AES_128_BLOCK_SIZE);
+    SecLib_Aes128Encrypt(pContext->x, pContext->keySchedule, pOutput);
+
+    FLib_MemSet(subkey, 0, sizeof(subkey));
+    FLib_MemSet(pContext, 0, sizeof(aesCmacContext_t));
+}
+
+/*! *********************************************************************************
+* \brief   Computes the AES-128 CMAC of a whole message.
+*
+* \param[in]  pInput    message
+* \param[in]  inputLen  length of the message
+* \param[in]  pKey      16 bytes key
+* \param[out] pOutput   16 bytes MAC
+*
+********************************************************************************** */
+void AES_128_CMAC(const uint8_t *pInput, uint32_t inputLen, const uint8_t *pKey, uint8_t *pOutput)
+{
+    aesCmacContext_t context;
+
+    AES_128_CMAC_Init(&context, pKey);
+    AES_128_CMAC_Update(&context, pInput, inputLen);
+    AES_128_CMAC_Finish(&context, pOutput);
+}
+
+/*! *********************************************************************************
+* \brief   XORs a buffer into another: pDst[i] ^= pSrc[i].
+*
+* \param[in,out] pDst  destination
+* \param[in]     pSrc  source
+* \param[in]     len   number of bytes
+*
+********************************************************************************** */
+void SecLib_XorN(uint8_t *pDst, const uint8_t *pSrc, uint8_t len)
+{
+    while (len--)
+    {
+        *pDst++ ^= *pSrc++;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Compares two buffers in a time that does not depend on their content,
+*          for checking a digest or a MAC received from a peer.
+*
+* \param[in] pA   first buffer
+* \param[in] pB   second buffer
+* \param[in] len  number of bytes
+*
+* \return  TRUE if the buffers are equal
+*
+********************************************************************************** */
+bool_t SecLib_VerifyEqual(const uint8_t *pA, const uint8_t *pB, uint32_t len)
+{
+    volatile uint8_t diff = 0;
+
+    while (len--)
+    {
+        diff |= *pA++ ^ *pB++;
+    }
+
+    return (diff == 0) ? TRUE : FALSE;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private functions
+*************************************************************************************
+********************************************************************************** */
+
+/*! *********************************************************************************
+* \brief   Computes the CMAC subkey following pKey: a left shift by one bit in
+*          GF(2^128), without branching on the secret top bit.
+*
+* \param[in,out] pKey  16 bytes
+*
+********************************************************************************** */
+static void SecLib_CmacSubkey(uint8_t *pKey)
+{
+    uint8_t msb = (uint8_t)(0u - (pKey[0] >> 7));
+    uint32_t i;
+
+    for (i = 0; i < AES_128_BLOCK_SIZE - 1; i++)
+    {
+        pKey[i] = (uint8_t)((pKey[i] << 1) | (pKey[i + 1] >> 7));
+    }
+    pKey[AES_128_BLOCK_SIZE - 1] = (uint8_t)((pKey[AES_128_BLOCK_SIZE - 1] << 1) ^ (msb & 0x87));
+}
+
+#if gSecLib_HWSupport_d
+/*! *********************************************************************************
+* \brief   Loads the SHA-256 initial hash value.
+*
+********************************************************************************** */
+static void SecLib_Sha256InitState(uint32_t *pState)
+{
+    MMCAU_SHA256_InitializeOutput(pState);
+}
+
+/*! *********************************************************************************
+* \brief   Hashes whole blocks on the MMCAU. The coprocessor registers are not
+*          saved on a context switch, so the interrupts are disabled for one
+*          block at a time. One block per call also keeps the driver's copy of
+*          unaligned input correct.
+*
+********************************************************************************** */
+static void SecLib_Sha256Blocks(uint32_t *pState, const uint8_t *pData, uint32_t numBlocks)
+{
+    while (numBlocks--)
+    {
+        OSA_InterruptDisable();
+        MMCAU_SHA256_HashN(pData, 1, pState);
+        OSA_InterruptEnable();
+        pData += SHA256_BLOCK_SIZE;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Expands an AES-128 key in the MMCAU key schedule format.
+*
+********************************************************************************** */
+static void SecLib_Aes128SetKey(const uint8_t *pKey, uint32_t *pKeySchedule)
+{
+    OSA_InterruptDisable();
+    MMCAU_AES_SetKey(pKey, AES_128_KEY_BYTE_LEN, (uint8_t *)pKeySchedule);
+    OSA_InterruptEnable();
+}
+
+/*! *********************************************************************************
+* \brief   Encrypts one block on the MMCAU.
+*
+********************************************************************************** */
+static void SecLib_Aes128Encrypt(const uint8_t *pInput, const uint32_t *pKeySchedule, uint8_t *pOutput)
+{
+    OSA_InterruptDisable();
+    MMCAU_AES_EncryptEcb(pInput, (const uint8_t *)pKeySchedule, mAes128Rounds_c, pOutput);
+    OSA_InterruptEnable();
+}
+
+#else /* gSecLib_HWSupport_d */
+/*! *********************************************************************************
+* \brief   Loads the SHA-256 initial hash value.
+*
+********************************************************************************** */
+static void SecLib_Sha256InitState(uint32_t *pState)
+{
+    pState[0] = 0x6a09e667;
+    pState[1] = 0xbb67ae85;
+    pState[2] = 0x3c6ef372;
+    pState[3] = 0xa54ff53a;
+    pState[4] = 0x510e527f;
+    pState[5] = 0x9b05688c;
+    pState[6] = 0x1f83d9ab;
+    pState[7] = 0x5be0cd19;
+}
+
+/*! *********************************************************************************
+* \brief   SHA-256 compression function, on whole blocks.
+*
+********************************************************************************** */
+static void SecLib_Sha256Blocks(uint32_t *pState, const uint8_t *pData, uint32_t numBlocks)
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h, t1, t2;
+    uint32_t i;
+
+    while (numBlocks--)
+    {
+        for (i = 0; i < 16; i++)
+        {
+            w[i] = ((uint32_t)pData[4 * i] << 24) | ((uint32_t)pData[4 * i + 1] << 16) |
+                   ((uint32_t)pData[4 * i + 2] << 8) | pData[4 * i + 3];
+        }
+        for (i = 16; i < 64; i++)
+        {
+            t1 = mRotR32(w[i - 2], 17) ^ mRotR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            t2 = mRotR32(w[i - 15], 7) ^ mRotR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            w[i] = t1 + w[i - 7] + t2 + w[i - 16];
+        }
+
+        a = pState[0]; b = pState[1]; c = pState[2]; d = pState[3];
+        e = pState[4]; f = pState[5]; g = pState[6]; h = pState[7];
+
+        for (i = 0; i < 64; i++)
+        {
+            t1 = h + (mRotR32(e, 6) ^ mRotR32(e, 11) ^ mRotR32(e, 25)) + ((e & f) ^ (~e & g)) + mSha256K[i] + w[i];
+            t2 = (mRotR32(a, 2) ^ mRotR32(a, 13) ^ mRotR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        pState[0] += a; pState[1] += b; pState[2] += c; pState[3] += d;
+        pState[4] += e; pState[5] += f; pState[6] += g; pState[7] += h;
+        pData += SHA256_BLOCK_SIZE;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Expands an AES-128 key: 11 round keys of 16 bytes.
+*
+********************************************************************************** */
+static void SecLib_Aes128SetKey(const uint8_t *pKey, uint32_t *pKeySchedule)
+{
+    uint8_t *pRk = (uint8_t *)pKeySchedule;
+    uint8_t rcon = 0x01;
+    uint8_t t[4];
+    uint32_t i;
+
+    FLib_MemCpy(pRk, (void *)pKey, AES_128_KEY_BYTE_LEN);
+
+    for (i = AES_128_KEY_BYTE_LEN; i < 44 * sizeof(uint32_t); i += 4)
+    {
+        t[0] = pRk[i - 4]; t[1] = pRk[i - 3]; t[2] = pRk[i - 2]; t[3] = pRk[i - 1];
+
+        if ((i % AES_128_KEY_BYTE_LEN) == 0)
+        {
+            uint8_t tmp = t[0];
+
+            t[0] = mAesSBox[t[1]] ^ rcon;
+            t[1] = mAesSBox[t[2]];
+            t[2] = mAesSBox[t[3]];
+            t[3] = mAesSBox[tmp];
+            rcon = (uint8_t)((rcon << 1) ^ ((rcon >> 7) * 0x1b));
+        }
+
+        pRk[i]     = pRk[i - 16] ^ t[0];
+        pRk[i + 1] = pRk[i - 15] ^ t[1];
+        pRk[i + 2] = pRk[i - 14] ^ t[2];
+        pRk[i + 3] = pRk[i - 13] ^ t[3];
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Encrypts one AES-128 block.
+*
+********************************************************************************** */
+static void SecLib_Aes128Encrypt(const uint8_t *pInput, const uint32_t *pKeySchedule, uint8_t *pOutput)
+{
+    const uint8_t *pRk = (const uint8_t *)pKeySchedule;
+    uint8_t s[AES_128_BLOCK_SIZE];
+    uint8_t t[AES_128_BLOCK_SIZE];
+    uint32_t round;
+    uint32_t i;
+
+    for (i = 0; i < AES_128_BLOCK_SIZE; i++)
+    {
+        s[i] = pInput[i] ^ pRk[i];
+    }
+
+    for (round = 1; round <= mAes128Rounds_c; round++)
+    {
+        pRk += AES_128_BLOCK_SIZE;
+
+        /* SubBytes and ShiftRows: the state is stored column by column */
+        for (i = 0; i < AES_128_BLOCK_SIZE; i++)
+        {
+            t[i] = mAesSBox[s[(i + 4 * (i % 4)) % AES_128_BLOCK_SIZE]];
+        }
+
+        if (round < mAes128Rounds_c)
+        {
+            /* MixColumns */
+            for (i = 0; i < AES_128_BLOCK_SIZE; i += 4)
+            {
+                uint8_t a0 = t[i], a1 = t[i + 1], a2 = t[i + 2], a3 = t[i + 3];
+                uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+
+                s[i]     = a0 ^ all ^ (uint8_t)(((a0 ^ a1) << 1) ^ (((a0 ^ a1) >> 7) * 0x1b));
+                s[i + 1] = a1 ^ all ^ (uint8_t)(((a1 ^ a2) << 1) ^ (((a1 ^ a2) >> 7) * 0x1b));
+                s[i + 2] = a2 ^ all ^ (uint8_t)(((a2 ^ a3) << 1) ^ (((a2 ^ a3) >> 7) * 0x1b));
+                s[i + 3] = a3 ^ all ^ (uint8_t)(((a3 ^ a0) << 1) ^ (((a3 ^ a0) >> 7) * 0x1b));
+            }
+        }
+        else
+        {
+            FLib_MemCpy(s, t, AES_128_BLOCK_SIZE);
+        }
+
+        for (i = 0; i < AES_128_BLOCK_SIZE; i++)
+        {
+            s[i] ^= pRk[i];
+        }
+    }
+
+    FLib_MemCpy(pOutput, s, AES_128_BLOCK_SIZE);
+}
+#endif /* gSecLib_HWSupport_d */
@@ -0,0 +1,458 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file SecLibTest.c
+* Host test for the security library. The module source is built in and checked
+* against the known answers of FIPS 180-2 (SHA-256), SP 800-38A (AES-128) and
+* RFC 4493 (AES-128 CMAC). The incremental interfaces must give the one-shot
+* result whatever the split of the input. The throughput is then measured with
+* the OTA client pattern, 64-byte pieces, next to the CRC the client used before.
+*
+* The Makefile also builds the MMCAU path (gSecLib_HWSupport_d 1) over stubs of
+* the driver calls, which check that the interrupts are masked around each call.
+* Its throughput is the host's reference code, not the coprocessor's.
+*
+* Build and run with "make" from this directory.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../Source/SecLib.c"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Stubs
+*************************************************************************************
+********************************************************************************** */
+void FLib_MemCpy(void *pDst, void *pSrc, uint32_t cBytes) { memmove(pDst, pSrc, cBytes); }
+void FLib_MemSet(void *pDst, uint8_t value, uint32_t cBytes) { memset(pDst, value, cBytes); }
+
+#define CHECK(c)    do { if( !(c) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while(0)
+
+#if gSecLib_HWSupport_d
+/* MMCAU driver calls, run by a textbook SHA-256 and AES-128 with the constants
+   derived at first use. Each call must be made with the interrupts masked, and
+   SHA-256 is fed one block per masked interval. */
+static uint32_t mIntMasked;
+static uint32_t mCauCalls;
+static uint32_t mShaK[64];
+static uint32_t mShaIv[8];
+static uint8_t mSBox[256];
+
+void OSA_InterruptDisable(void) { mIntMasked++; }
+void OSA_InterruptEnable(void)  { CHECK(mIntMasked); mIntMasked--; }
+
+static void CauConstants(void)
+{
+    uint32_t n, p, d;
+    uint8_t a = 1, b = 1, x;
+
+    if( mShaK[0] )
+    {
+        return;
+    }
+
+    /* Fractional parts of the square and cube roots of the first primes */
+    for( n = 0, p = 2; n < 64; p++ )
+    {
+        for( d = 2; (d * d <= p) && (p % d); d++ ) {}
+        if( d * d > p )
+        {
+            if( n < 8 )
+            {
+                mShaIv[n] = (uint32_t)((sqrt(p) - floor(sqrt(p))) * 4294967296.0);
+            }
+            mShaK[n++] = (uint32_t)((cbrt(p) - floor(cbrt(p))) * 4294967296.0);
+        }
+    }
+
+    /* S-box: multiplicative inverse in GF(2^8), then the affine map */
+    do
+    {
+        a = (uint8_t)(a ^ (a << 1) ^ ((a & 0x80) ? 0x1B : 0));
+        b ^= (uint8_t)(b << 1);
+        b ^= (uint8_t)(b << 2);
+        b ^= (uint8_t)(b << 4);
+        b ^= (b & 0x80) ? 0x09 : 0;
+        x = (uint8_t)(b ^ (b << 1) ^ (b >> 7) ^ (b << 2) ^ (b >> 6) ^ (b << 3) ^ (b >> 5) ^ (b << 4) ^ (b >> 4));
+        mSBox[a] = (uint8_t)(x ^ 0x63);
+    } while( a != 1 );
+    mSBox[0] = 0x63;
+}
+
+status_t MMCAU_SHA256_InitializeOutput(uint32_t *sha256State)
+{
+    CauConstants();
+    memcpy(sha256State, mShaIv, sizeof(mShaIv));
+    return kStatus_Success;
+}
+
+status_t MMCAU_SHA256_HashN(const uint8_t *input, uint32_t numBlocks, uint32_t *sha256State)
+{
+    uint32_t w[64], v[8], t1, t2, i;
+
+    CHECK(mIntMasked && (1 == numBlocks));
+    mCauCalls++;
+    for( i = 0; i < 64; i++ )
+    {
+        w[i] = (i < 16) ? ((uint32_t)input[4 * i] << 24) | ((uint32_t)input[4 * i + 1] << 16) |
+                          ((uint32_t)input[4 * i + 2] << 8) | input[4 * i + 3]
+                        : (mRotR32(w[i - 2], 17) ^ mRotR32(w[i - 2], 19) ^ (w[i - 2] >> 10)) + w[i - 7] +
+                          (mRotR32(w[i - 15], 7) ^ mRotR32(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 16];
+    }
+    memcpy(v, sha256State, sizeof(v));
+    for( i = 0; i < 64; i++ )
+    {
+        t1 = v[7] + (mRotR32(v[4], 6) ^ mRotR32(v[4], 11) ^ mRotR32(v[4], 25)) + ((v[4] & v[5]) ^ (~v[4] & v[6])) +
+             mShaK[i] + w[i];
+        t2 = (mRotR32(v[0], 2) ^ mRotR32(v[0], 13) ^ mRotR32(v[0], 22)) + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+        memmove(&v[1], &v[0], 7 * sizeof(uint32_t));
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+    for( i = 0; i < 8; i++ )
+    {
+        sha256State[i] += v[i];
+    }
+    return kStatus_Success;
+}
+
+status_t MMCAU_AES_SetKey(const uint8_t *key, const size_t keySize, uint8_t *keySch)
+{
+    uint8_t rcon = 1;
+    uint32_t i;
+
+    CHECK(mIntMasked && (AES_128_KEY_BYTE_LEN == keySize));
+    mCauCalls++;
+    CauConstants();
+    memcpy(keySch, key, keySize);
+    for( i = 16; i < 176; i += 4 )
+    {
+        uint8_t t[4] = { keySch[i - 4], keySch[i - 3], keySch[i - 2], keySch[i - 1] };
+
+        if( 0 == (i % 16) )
+        {
+            uint8_t t0 = t[0];
+
+            t[0] = (uint8_t)(mSBox[t[1]] ^ rcon);
+            t[1] = mSBox[t[2]];
+            t[2] = mSBox[t[3]];
+            t[3] = mSBox[t0];
+            rcon = (uint8_t)((rcon << 1) ^ ((rcon & 0x80) ? 0x1B : 0));
+        }
+        keySch[i] = keySch[i - 16] ^ t[0];
+        keySch[i + 1] = keySch[i - 15] ^ t[1];
+        keySch[i + 2] = keySch[i - 14] ^ t[2];
+        keySch[i + 3] = keySch[i - 13] ^ t[3];
+    }
+    return kStatus_Success;
+}
+
+status_t MMCAU_AES_EncryptEcb(const uint8_t *in, const uint8_t *keySch, uint32_t aesRounds, uint8_t *out)
+{
+    uint8_t s[16], t[16];
+    uint32_t r, c, i;
+
+    CHECK(mIntMasked && (10 == aesRounds));
+    mCauCalls++;
+    for( i = 0; i < 16; i++ )
+    {
+        s[i] = in[i] ^ keySch[i];
+    }
+    for( r = 1; r <= aesRounds; r++ )
+    {
+        /* SubBytes and ShiftRows: row i % 4 of column i / 4 moves left by the row number */
+        for( i = 0; i < 16; i++ )
+        {
+            t[i] = mSBox[s[(i + 4 * (i % 4)) % 16]];
+        }
+        for( c = 0; c < 4; c++ )
+        {
+            uint8_t *p = &t[4 * c];
+            uint8_t all = p[0] ^ p[1] ^ p[2] ^ p[3];
+            uint8_t first = p[0];
+
+            for( i = 0; (r < aesRounds) && (i < 4); i++ )
+            {
+                uint8_t pair = p[i] ^ ((i < 3) ? p[i + 1] : first);
+
+                p[i] ^= all ^ (uint8_t)((pair << 1) ^ ((pair & 0x80) ? 0x1B : 0));
+            }
+        }
+        for( i = 0; i < 16; i++ )
+        {
+            s[i] = t[i] ^ keySch[16 * r + i];
+        }
+    }
+    memcpy(out, s, sizeof(s));
+    return kStatus_Success;
+}
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Helpers
+*************************************************************************************
+********************************************************************************** */
+#define mBigSize_c  (1000000U)
+
+static uint8_t maBig[mBigSize_c];
+
+/* RFC 4493 key and messages, also the SP 800-38A plaintext */
+static const char mKey[] = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char mMessage[] = "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                               "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+
+static void FromHex(const char *pHex, uint8_t *pOut, uint32_t len)
+{
+    uint32_t i;
+
+    for( i = 0; i < len; i++ )
+    {
+        CHECK(1 == sscanf(&pHex[2 * i], "%2hhx", &pOut[i]));
+    }
+}
+
+static bool_t Equals(const void *pData, const char *pHex, uint32_t len)
+{
+    uint8_t expected[SHA256_HASH_SIZE];
+
+    FromHex(pHex, expected, len);
+    return 0 == memcmp(pData, expected, len);
+}
+
+/* OTA_CrcCompute(): bitwise CRC-16 */
+static uint16_t Crc16(const uint8_t *pData, uint32_t len, uint16_t crc)
+{
+    uint32_t i;
+
+    while( len-- )
+    {
+        crc ^= (uint16_t)(*pData++ << 8);
+        for( i = 0; i < 8; i++ )
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static double Now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Tests
+*************************************************************************************
+********************************************************************************** */
+
+/* FIPS 180-2 examples, and the million 'a' fed in random pieces */
+static void TestSha256(void)
+{
+    static const uint8_t m448[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    sha256Context_t ctx;
+    uint32_t offset;
+    uint32_t len;
+
+    SHA256_Hash(&ctx, (const uint8_t *)"abc", 3);
+    CHECK(Equals(ctx.hash, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", SHA256_HASH_SIZE));
+    SHA256_Hash(&ctx, NULL, 0);
+    CHECK(Equals(ctx.hash, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", SHA256_HASH_SIZE));
+    SHA256_Hash(&ctx, m448, sizeof(m448) - 1);
+    CHECK(Equals(ctx.hash, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", SHA256_HASH_SIZE));
+
+    /* Bytes 0 to 255: four different whole blocks in one call */
+    for( offset = 0; offset < 256; offset++ )
+    {
+        maBig[offset] = (uint8_t)offset;
+    }
+    SHA256_Hash(&ctx, maBig, 256);
+    CHECK(Equals(ctx.hash, "40aff2e9d2d8922e47afd4648e6967497158785fbd1da870e7110266bf944880", SHA256_HASH_SIZE));
+
+    memset(maBig, 'a', sizeof(maBig));
+    SHA256_Init(&ctx);
+    for( offset = 0; offset < sizeof(maBig); offset += len )
+    {
+        len = 1 + rand() % 300;
+        len = (offset + len > sizeof(maBig)) ? (sizeof(maBig) - offset) : len;
+        SHA256_HashUpdate(&ctx, &maBig[offset], len);
+    }
+    SHA256_HashFinish(&ctx, NULL, 0);
+    CHECK(Equals(ctx.hash, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", SHA256_HASH_SIZE));
+}
+
+/* SP 800-38A ECB and RFC 4493 examples */
+static void TestAes(void)
+{
+    uint8_t key[AES_128_KEY_BYTE_LEN];
+    uint8_t message[64];
+    uint8_t out[AES_128_BLOCK_SIZE];
+
+    FromHex(mKey, key, sizeof(key));
+    FromHex(mMessage, message, sizeof(message));
+
+    AES_128_Encrypt(message, key, out);
+    CHECK(Equals(out, "3ad77bb40d7a3660a89ecaf32466ef97", AES_128_BLOCK_SIZE));
+
+    AES_128_CMAC(message, 0, key, out);
+    CHECK(Equals(out, "bb1d6929e95937287fa37d129b756746", AES_128_CMAC_SIZE));
+    AES_128_CMAC(message, 16, key, out);
+    CHECK(Equals(out, "070a16b46b4d4144f79bdd9dd04a287c", AES_128_CMAC_SIZE));
+    AES_128_CMAC(message, 40, key, out);
+    CHECK(Equals(out, "dfa66747de9ae63030ca32611497c827", AES_128_CMAC_SIZE));
+    AES_128_CMAC(message, 64, key, out);
+    CHECK(Equals(out, "51f0bebf7e3b9d92fc49741779363cfe", AES_128_CMAC_SIZE));
+}
+
+/* Every split of the inputs in three pieces gives the one-shot result */
+static void TestSplits(void)
+{
+    uint8_t key[AES_128_KEY_BYTE_LEN];
+    uint8_t message[64];
+    uint8_t reference[SHA256_HASH_SIZE];
+    uint8_t out[AES_128_CMAC_SIZE];
+    aesCmacContext_t cmac;
+    sha256Context_t sha;
+    uint32_t splits = 0;
+    uint32_t len;
+    uint32_t a;
+    uint32_t b;
+
+    FromHex(mKey, key, sizeof(key));
+    FromHex(mMessage, message, sizeof(message));
+
+    for( len = 0; len <= sizeof(message); len++ )
+    {
+        AES_128_CMAC(message, len, key, reference);
+        for( a = 0; a <= len; a++ )
+        {
+            for( b = a; b <= len; b++ )
+            {
+                AES_128_CMAC_Init(&cmac, key);
+                AES_128_CMAC_Update(&cmac, message, a);
+                AES_128_CMAC_Update(&cmac, &message[a], b - a);
+                AES_128_CMAC_Update(&cmac, &message[b], len - b);
+                AES_128_CMAC_Finish(&cmac, out);
+                CHECK(0 == memcmp(out, reference, AES_128_CMAC_SIZE));
+                splits++;
+            }
+        }
+    }
+
+    for( len = 0; len <= 200; len++ )
+    {
+        SHA256_Hash(&sha, maBig, len);
+        memcpy(reference, sha.hash, SHA256_HASH_SIZE);
+        for( a = 0; a <= len; a += 3 )
+        {
+            SHA256_Init(&sha);
+            SHA256_HashUpdate(&sha, maBig, 0);
+            SHA256_HashUpdate(&sha, maBig, a);
+            SHA256_HashFinish(&sha, &maBig[a], len - a);
+            CHECK(0 == memcmp(sha.hash, reference, SHA256_HASH_SIZE));
+            splits++;
+        }
+    }
+    printf("splits: %u incremental results checked\n", splits);
+}
+
+static void TestHelpers(void)
+{
+    uint8_t a[32] = {0};
+    uint8_t b[32] = {0};
+
+    CHECK(SecLib_VerifyEqual(a, b, sizeof(a)));
+    b[31] = 1;
+    CHECK(!SecLib_VerifyEqual(a, b, sizeof(a)));
+    CHECK(SecLib_VerifyEqual(a, b, 31));
+
+    SecLib_XorN(a, b, sizeof(a));
+    CHECK(0 == memcmp(a, b, sizeof(a)));
+}
+
+/* Throughput with the OTA client feeding pattern */
+static void Benchmark(void)
+{
+    const uint32_t reps = 20;
+    uint8_t key[AES_128_KEY_BYTE_LEN] = {0};
+    uint8_t mac[AES_128_CMAC_SIZE];
+    aesCmacContext_t cmac;
+    sha256Context_t sha;
+    volatile uint32_t sink = 0;
+    uint32_t offset;
+    uint32_t r;
+    double t;
+
+    for( offset = 0; offset < sizeof(maBig); offset++ )
+    {
+        maBig[offset] = (uint8_t)rand();
+    }
+    printf("Throughput, 64-byte pieces, %s (gSecLib_HWSupport_d %d):\n",
+           gSecLib_HWSupport_d ? "MMCAU stubs" : "software", gSecLib_HWSupport_d);
+
+    t = Now();
+    for( r = 0; r < reps; r++ )
+    {
+        uint16_t crc = 0;
+
+        for( offset = 0; offset < sizeof(maBig); offset += 64 )
+        {
+            crc = Crc16(&maBig[offset], 64, crc);
+        }
+        sink += crc;
+    }
+    printf("CRC-16 (bitwise)   %7.1f MB/s\n", reps * sizeof(maBig) / (Now() - t) / 1e6);
+
+    t = Now();
+    for( r = 0; r < reps; r++ )
+    {
+        SHA256_Init(&sha);
+        for( offset = 0; offset < sizeof(maBig); offset += 64 )
+        {
+            SHA256_HashUpdate(&sha, &maBig[offset], 64);
+        }
+        SHA256_HashFinish(&sha, NULL, 0);
+        sink += sha.hash[0];
+    }
+    printf("SHA-256            %7.1f MB/s\n", reps * sizeof(maBig) / (Now() - t) / 1e6);
+
+    t = Now();
+    for( r = 0; r < reps; r++ )
+    {
+        AES_128_CMAC_Init(&cmac, key);
+        for( offset = 0; offset < sizeof(maBig); offset += 64 )
+        {
+            AES_128_CMAC_Update(&cmac, &maBig[offset], 64);
+        }
+        AES_128_CMAC_Finish(&cmac, mac);
+        sink += mac[0];
+    }
+    printf("AES-128 CMAC       %7.1f MB/s\n", reps * sizeof(maBig) / (Now() - t) / 1e6);
+    (void)sink;
+}
+
+int main(void)
+{
+    srand(1);
+    TestSha256();
+    TestAes();
+    TestSplits();
+    TestHelpers();
+#if gSecLib_HWSupport_d
+    CHECK(mCauCalls && (0 == mIntMasked));
+#endif
+    Benchmark();
+
+    printf("SecLib: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,15 @@
+/* Host build stub: the MMCAU driver calls used by SecLib, run by a reference
+   implementation in the test */
+#ifndef _FSL_MMCAU_H_
+#define _FSL_MMCAU_H_
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int32_t status_t;
+#define kStatus_Success     0
+
+status_t MMCAU_AES_SetKey(const uint8_t *key, const size_t keySize, uint8_t *keySch);
+status_t MMCAU_AES_EncryptEcb(const uint8_t *in, const uint8_t *keySch, uint32_t aesRounds, uint8_t *out);
+status_t MMCAU_SHA256_InitializeOutput(uint32_t *sha256State);
+status_t MMCAU_SHA256_HashN(const uint8_t *input, uint32_t numBlocks, uint32_t *sha256State);
+#endif
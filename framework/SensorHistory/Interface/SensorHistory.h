@@ -0,0 +1,291 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file SensorHistory.h
+* This is the header file for the sensor history module.
+* Every sample of the sampled quantities is delta encoded into fixed size blocks
+* which are appended to a circular region of a storage device (the external SPI
+* flash, or RAM). The samples are also folded into 1 s, 1 min and 1 h rollups
+* (minimum, maximum and mean) kept in RAM. Both can be streamed back to a host.
+*
+* The module takes no timestamps and makes no storage accesses of its own: the
+* caller passes the sample time and the storage device is described by a set of
+* function pointers, so that the module can be run off-target with a simulated
+* clock and flash.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* o Redistributions of source code must retain the above copyright notice, this list
+*   of conditions and the following disclaimer.
+*
+* o Redistributions in binary form must reproduce the above copyright notice, this
+*   list of conditions and the following disclaimer in the documentation and/or
+*   other materials provided with the distribution.
+*
+* o Neither the name of the copyright holder nor the names of its
+*   contributors may be used to endorse or promote products derived from this
+*   software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+* ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef _SENSOR_HISTORY_H_
+#define _SENSOR_HISTORY_H_
+
+/*! *********************************************************************************
+*************************************************************************************
+* Include
+*************************************************************************************
+********************************************************************************** */
+#include "EmbeddedTypes.h"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public macros
+*************************************************************************************
+********************************************************************************** */
+
+/*
+ * \brief   Number of quantities recorded for every sample. Bit n of a sample
+ *          mask tells whether quantity n is present.
+ * VALID RANGE: 1..8
+ */
+#ifndef gHistoryQuantities_c
+#define gHistoryQuantities_c            6
+#endif
+
+/*
+ * \brief   Size of a block of samples. This is also the unit written to storage,
+ *          so it should be the page size of the flash.
+ */
+#ifndef gHistoryBlockSize_c
+#define gHistoryBlockSize_c             256
+#endif
+
+/*
+ * \brief   Number of completed rollups kept for each resolution.
+ */
+#ifndef gHistorySecondRollups_c
+#define gHistorySecondRollups_c         16
+#endif
+
+#ifndef gHistoryMinuteRollups_c
+#define gHistoryMinuteRollups_c         60
+#endif
+
+#ifndef gHistoryHourRollups_c
+#define gHistoryHourRollups_c           24
+#endif
+
+/*
+ * \brief   Enables the storage descriptor for the external SPI flash. The
+ *          region is the upper half of the FICA_IMG_CUR_K41Z_APP_ADDR slot,
+ *          which a KW41Z image never reaches.
+ */
+#ifndef gHistorySpiFlashEnabled_d
+#define gHistorySpiFlashEnabled_d       1
+#endif
+
+#ifndef gHistorySpiFlashStart_c
+#define gHistorySpiFlashStart_c         0x00880000
+#endif
+
+#ifndef gHistorySpiFlashSize_c
+#define gHistorySpiFlashSize_c          0x00080000
+#endif
+
+/*
+ * \brief   Number of completed blocks waiting in RAM for SensorHistory_Idle()
+ *          to write them to storage. If the idle loop falls this far behind,
+ *          the samples of the next completed block are lost.
+ */
+#ifndef gHistoryPendingBlocks_c
+#define gHistoryPendingBlocks_c         2
+#endif
+
+/*
+ * \brief   Number of blocks of the RAM storage descriptor, used when no
+ *          external flash is available.
+ */
+#ifndef gHistoryRamBlocks_c
+#define gHistoryRamBlocks_c             8
+#endif
+
+/* Block header magic word ("SH") and encoding version */
+#define gHistoryBlockMagic_c            0x5348
+#define gHistoryBlockVersion_c          2
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public type definitions
+*************************************************************************************
+********************************************************************************** */
+
+/*! Resolutions that can be downloaded */
+typedef enum historyLevel_tag
+{
+    gHistoryLevelRaw_c,                 /* Every sample, as stored blocks */
+    gHistoryLevelSecond_c,
+    gHistoryLevelMinute_c,
+    gHistoryLevelHour_c,
+    gHistoryLevelCount_c
+} historyLevel_t;
+
+/*! Storage device. All the addresses are absolute. The region must be a whole
+ *  number of sectors and a sector a whole number of blocks. The functions return
+ *  FALSE on error. */
+typedef struct historyStorage_tag
+{
+    uint32_t baseAddr;
+    uint32_t size;
+    uint32_t sectorSize;
+    bool_t (*read)(uint32_t addr, uint32_t len, uint8_t *pData);
+    bool_t (*program)(uint32_t addr, uint32_t len, const uint8_t *pData);
+    bool_t (*erase)(uint32_t addr);     /* Erases the sector starting at addr */
+} historyStorage_t;
+
+/*! Header of every stored block. The times are ms from the caller's clock, whose
+ *  origin (usually the boot) was at UNIX time epoch. The records that follow are:
+ *    varint    time since the previous record in ms (0 for the first one)
+ *    uint8_t   mask of the quantities present
+ *    zigzag varint per present quantity: difference to the previous value of
+ *    that quantity in the same block (to 0 for its first occurrence)
+ *  so that every block can be decoded on its own. */
+typedef PACKED_STRUCT historyBlockHeader_tag
+{
+    uint16_t magic;                     /* gHistoryBlockMagic_c */
+    uint8_t  version;                   /* gHistoryBlockVersion_c */
+    uint8_t  samples;
+    uint32_t sequence;                  /* Increments with every block written */
+    uint32_t epoch;                     /* s, UNIX time of the clock origin, 0 if unknown */
+    uint32_t firstTime;                 /* ms */
+    uint32_t lastTime;                  /* ms */
+    uint16_t length;                    /* Bytes of records following the header */
+} historyBlockHeader_t;
+
+/*! Statistics of one quantity over a rollup period */
+typedef PACKED_STRUCT historyStats_tag
+{
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+} historyStats_t;
+
+/*! Rollup as streamed: the stats of the quantities present in mask follow
+ *  the header, in quantity order. */
+typedef PACKED_STRUCT historyRollupHeader_tag
+{
+    uint32_t epoch;                     /* s, UNIX time of the clock origin, 0 if unknown */
+    uint32_t startTime;                 /* ms, aligned to the period */
+    uint8_t  level;                     /* historyLevel_t */
+    uint8_t  mask;
+    uint16_t samples;
+} historyRollupHeader_t;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public memory declarations
+*************************************************************************************
+********************************************************************************** */
+#if gHistorySpiFlashEnabled_d
+extern const historyStorage_t gHistorySpiFlashStorage;
+#endif
+extern const historyStorage_t gHistoryRamStorage;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public prototypes
+*************************************************************************************
+********************************************************************************** */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! *********************************************************************************
+* \brief   Selects the storage device and resumes after the newest block found
+*          in it. The rollups start empty.
+*
+* \param[in] pStorage  storage descriptor, must stay valid
+*
+* \return  FALSE if the storage geometry is not supported or cannot be read
+*
+********************************************************************************** */
+bool_t SensorHistory_Init(const historyStorage_t *pStorage);
+
+/*! *********************************************************************************
+* \brief   Records one sample. Samples must be added in time order. A completed
+*          block is only queued: storage is not accessed.
+*
+* \param[in] timestamp  ms, from the caller's clock
+* \param[in] mask       bit n set if pValues[n] is valid
+* \param[in] pValues    gHistoryQuantities_c values
+*
+********************************************************************************** */
+void SensorHistory_AddSample(uint32_t timestamp, uint8_t mask, const int32_t *pValues);
+
+/*! *********************************************************************************
+* \brief   Sets the UNIX time of the origin of the caller's clock, e.g. when a
+*          peer provides the wall clock time. It applies to the block being
+*          filled and to the rollups.
+*
+* \param[in] epoch  s, 0 if unknown
+*
+********************************************************************************** */
+void SensorHistory_SetEpoch(uint32_t epoch);
+
+/*! *********************************************************************************
+* \brief   Writes the completed blocks to storage. Call it from the idle loop of
+*          a task which may block on the storage device.
+*
+********************************************************************************** */
+void SensorHistory_Idle(void);
+
+/*! *********************************************************************************
+* \brief   Writes the block being filled and the completed blocks to storage,
+*          e.g. before a reset. Must not run concurrently with SensorHistory_Idle().
+*
+********************************************************************************** */
+void SensorHistory_Flush(void);
+
+/*! *********************************************************************************
+* \brief   Starts a download, aborting the one in progress.
+*
+* \param[in] level     historyLevel_t
+* \param[in] fromTime  s, UNIX time: older blocks and rollups are skipped. Those of
+*                      an unknown epoch are always sent, 0 sends everything.
+*
+* \return  FALSE if the level is not valid
+*
+********************************************************************************** */
+bool_t SensorHistory_StartDownload(uint8_t level, uint32_t fromTime);
+
+/*! *********************************************************************************
+* \brief   Reads the next bytes of the download. Raw downloads are the stored
+*          blocks (header and records) back to back, oldest first, followed by
+*          the completed blocks not stored yet and the block being filled. Rollup downloads are historyRollupHeader_t
+*          records, oldest first, followed by the period in progress.
+*
+* \param[out] pBuf    destination
+* \param[in]  maxLen  size of pBuf
+*
+* \return  number of bytes copied, 0 when the download is complete
+*
+********************************************************************************** */
+uint16_t SensorHistory_ReadDownload(uint8_t *pBuf, uint16_t maxLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SENSOR_HISTORY_H_ */
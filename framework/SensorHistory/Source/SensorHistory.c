@@ -0,0 +1,938 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file SensorHistory.c
+* This is the source file for the sensor history module.
+*
+* Redistribution and use in source and binary forms, with or without modification,
+* are permitted provided that the following conditions are met:
+*
+* o Redistributions of source code must retain the above copyright notice, this list
+*   of conditions and the following disclaimer.
+*
+* o Redistributions in binary form must reproduce the above copyright notice, this
+*   list of conditions and the following disclaimer in the documentation and/or
+*   other materials provided with the distribution.
+*
+* o Neither the name of the copyright holder nor the names of its
+*   contributors may be used to endorse or promote products derived from this
+*   software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+* ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*! *********************************************************************************
+*************************************************************************************
+* Include
+*************************************************************************************
+********************************************************************************** */
+#include "EmbeddedTypes.h"
+#include "SensorHistory.h"
+#include "FunctionLib.h"
+
+#if gHistorySpiFlashEnabled_d
+#include "spi_flash_driver.h"
+#include "spi_bus_share.h"
+#endif
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private macros
+*************************************************************************************
+********************************************************************************** */
+#if (gHistoryQuantities_c < 1) || (gHistoryQuantities_c > 8)
+#error "gHistoryQuantities_c must be in the 1..8 range"
+#endif
+
+#if (gHistoryPendingBlocks_c < 1)
+#error "gHistoryPendingBlocks_c must be at least 1"
+#endif
+
+/* Worst case record: 5 bytes of time delta, the mask, 5 bytes per quantity */
+#define mHistoryMaxRecordSize_c     (6 + 5 * gHistoryQuantities_c)
+#define mHistoryBlockCapacity_c     (gHistoryBlockSize_c - sizeof(historyBlockHeader_t))
+
+/* Signed difference of two wrapping ms timestamps */
+#define mHistoryTimeDiff_m(a, b)    ((int32_t)((uint32_t)(a) - (uint32_t)(b)))
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private type definitions
+*************************************************************************************
+********************************************************************************** */
+
+/*! Period in progress of one resolution */
+typedef struct historyAccumulator_tag
+{
+    uint32_t startTime;
+    uint16_t samples;
+    uint8_t  mask;
+    int32_t  min[gHistoryQuantities_c];
+    int32_t  max[gHistoryQuantities_c];
+    int64_t  sum[gHistoryQuantities_c];
+    uint16_t count[gHistoryQuantities_c];
+} historyAccumulator_t;
+
+typedef struct historyRollup_tag
+{
+    historyRollupHeader_t header;
+    historyStats_t        stats[gHistoryQuantities_c];
+} historyRollup_t;
+
+typedef struct historyRollupLevel_tag
+{
+    uint32_t              period;       /* ms */
+    historyRollup_t      *pRing;
+    uint8_t               size;
+    uint8_t               head;         /* Next slot to be written */
+    uint8_t               count;
+    historyAccumulator_t  acc;
+} historyRollupLevel_t;
+
+typedef struct historyDownload_tag
+{
+    bool_t   active;
+    uint8_t  level;
+    bool_t   currentSent;               /* Block or period in progress already staged */
+    uint32_t fromEpochTime;             /* s, UNIX time */
+    uint32_t fromTime;                  /* Rollups: ms of the caller's clock */
+    uint32_t position;                  /* Raw: sequence of the next block */
+    uint16_t offset;
+    uint16_t length;
+    uint8_t  buf[gHistoryBlockSize_c];
+} historyDownload_t;
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private prototypes
+*************************************************************************************
+********************************************************************************** */
+static void     SensorHistory_AppendRaw(uint32_t timestamp, uint8_t mask, const int32_t *pValues);
+static uint8_t  SensorHistory_EncodeRecord(uint8_t *pDst, uint32_t delta, uint8_t mask, const int32_t *pValues);
+static void     SensorHistory_StartBlock(uint32_t timestamp);
+static void     SensorHistory_CloseBlock(void);
+static void     SensorHistory_WriteBlock(uint32_t sequence, const uint8_t *pBlock);
+static bool_t   SensorHistory_ReadBlock(uint32_t sequence, uint8_t *pBuf);
+static bool_t   SensorHistory_IsBlockWanted(const historyBlockHeader_t *pHeader);
+static void     SensorHistory_Accumulate(historyRollupLevel_t *pLevel, uint32_t timestamp, uint8_t mask, const int32_t *pValues);
+static uint16_t SensorHistory_SerializeRollup(uint8_t *pDst, uint8_t level, const historyAccumulator_t *pAcc);
+static bool_t   SensorHistory_StageNext(void);
+static bool_t   SensorHistory_StageRaw(void);
+static bool_t   SensorHistory_StageRollup(void);
+
+#if gHistorySpiFlashEnabled_d
+static bool_t SensorHistory_SpiRead(uint32_t addr, uint32_t len, uint8_t *pData);
+static bool_t SensorHistory_SpiProgram(uint32_t addr, uint32_t len, const uint8_t *pData);
+static bool_t SensorHistory_SpiErase(uint32_t addr);
+#endif
+static bool_t SensorHistory_RamRead(uint32_t addr, uint32_t len, uint8_t *pData);
+static bool_t SensorHistory_RamProgram(uint32_t addr, uint32_t len, const uint8_t *pData);
+static bool_t SensorHistory_RamErase(uint32_t addr);
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private memory declarations
+*************************************************************************************
+********************************************************************************** */
+static const historyStorage_t *mpHistoryStorage = NULL;
+static uint32_t mHistoryBlocks;
+static uint32_t mHistoryBlocksPerSector;
+/* The blocks from mHistoryWriteSequence up to the one being filled wait in
+ * maHistoryPending. The indexes are moved by the sampling context and by
+ * SensorHistory_Idle() respectively. */
+static volatile uint32_t mHistoryNextSequence;  /* Sequence of the block being filled */
+static volatile uint32_t mHistoryWriteSequence; /* Oldest block not stored yet */
+static volatile uint32_t mHistoryOldestSequence;/* Oldest block still in storage */
+static volatile uint32_t mHistoryEpoch;
+
+/* Block being filled, header first */
+static uint8_t  maHistoryBlock[gHistoryBlockSize_c];
+static uint8_t  maHistoryPending[gHistoryPendingBlocks_c][gHistoryBlockSize_c];
+static int32_t  maHistoryPrevValue[gHistoryQuantities_c];
+static uint32_t mHistoryPrevTime;
+
+static historyRollup_t maHistorySecondRing[gHistorySecondRollups_c];
+static historyRollup_t maHistoryMinuteRing[gHistoryMinuteRollups_c];
+static historyRollup_t maHistoryHourRing[gHistoryHourRollups_c];
+
+/* Indexed by historyLevel_t - 1 */
+static historyRollupLevel_t maHistoryLevels[gHistoryLevelCount_c - 1] =
+{
+    {1000,    maHistorySecondRing, gHistorySecondRollups_c, 0, 0, {0}},
+    {60000,   maHistoryMinuteRing, gHistoryMinuteRollups_c, 0, 0, {0}},
+    {3600000, maHistoryHourRing,   gHistoryHourRollups_c,   0, 0, {0}}
+};
+
+static historyDownload_t mHistoryDownload;
+
+static uint8_t maHistoryRamStorage[gHistoryRamBlocks_c * gHistoryBlockSize_c];
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public memory declarations
+*************************************************************************************
+********************************************************************************** */
+#if gHistorySpiFlashEnabled_d
+const historyStorage_t gHistorySpiFlashStorage =
+{
+    gHistorySpiFlashStart_c,
+    gHistorySpiFlashSize_c,
+    FLASH_SECTOR_SIZE,
+    SensorHistory_SpiRead,
+    SensorHistory_SpiProgram,
+    SensorHistory_SpiErase
+};
+#endif
+
+const historyStorage_t gHistoryRamStorage =
+{
+    0,
+    sizeof(maHistoryRamStorage),
+    gHistoryBlockSize_c,
+    SensorHistory_RamRead,
+    SensorHistory_RamProgram,
+    SensorHistory_RamErase
+};
+
+/*! *********************************************************************************
+*************************************************************************************
+* Public functions
+*************************************************************************************
+********************************************************************************** */
+
+/*! *********************************************************************************
+* \brief   Selects the storage device and resumes after the newest block found.
+*
+* \param[in] pStorage  storage descriptor
+*
+* \return  FALSE if the storage geometry is not supported or cannot be read
+*
+********************************************************************************** */
+bool_t SensorHistory_Init(const historyStorage_t *pStorage)
+{
+    historyBlockHeader_t header;
+    uint32_t sectors;
+    uint32_t slot;
+    uint32_t i;
+    bool_t found = FALSE;
+    uint32_t newest = 0;
+    uint32_t newestSlot = 0;
+    uint32_t oldest = 0;
+
+    mpHistoryStorage = NULL;
+
+    if( (NULL == pStorage) || (0 == pStorage->sectorSize) ||
+        (pStorage->sectorSize % gHistoryBlockSize_c) || (pStorage->size % pStorage->sectorSize) ||
+        (pStorage->size < 2 * pStorage->sectorSize) )
+    {
+        return FALSE;
+    }
+
+    mHistoryBlocks = pStorage->size / gHistoryBlockSize_c;
+    mHistoryBlocksPerSector = pStorage->sectorSize / gHistoryBlockSize_c;
+    sectors = pStorage->size / pStorage->sectorSize;
+
+    /* Sectors are erased as a whole before their first block is written, so the
+     * first block of every used sector tells the sequence range it holds */
+    for( i = 0; i < sectors; i++ )
+    {
+        slot = i * mHistoryBlocksPerSector;
+
+        if( !pStorage->read(pStorage->baseAddr + slot * gHistoryBlockSize_c, sizeof(header), (uint8_t *)&header) )
+        {
+            return FALSE;
+        }
+
+        if( (header.magic != gHistoryBlockMagic_c) || (header.version != gHistoryBlockVersion_c) ||
+            ((header.sequence % mHistoryBlocks) != slot) )
+        {
+            continue;
+        }
+
+        if( !found || (header.sequence > newest) )
+        {
+            newest = header.sequence;
+            newestSlot = slot;
+        }
+
+        if( !found || (header.sequence < oldest) )
+        {
+            oldest = header.sequence;
+        }
+
+        found = TRUE;
+    }
+
+    if( found )
+    {
+        /* Walk the newest sector up to its last written block */
+        for( i = 1; i < mHistoryBlocksPerSector; i++ )
+        {
+            if( !pStorage->read(pStorage->baseAddr + (newestSlot + i) * gHistoryBlockSize_c,
+                                sizeof(header), (uint8_t *)&header) )
+            {
+                return FALSE;
+            }
+
+            if( (header.magic != gHistoryBlockMagic_c) || (header.sequence != newest + 1) )
+            {
+                break;
+            }
+
+            newest++;
+        }
+
+        mHistoryOldestSequence = oldest;
+        mHistoryNextSequence = newest + 1;
+    }
+    else
+    {
+        mHistoryOldestSequence = 0;
+        mHistoryNextSequence = 0;
+    }
+
+    mHistoryWriteSequence = mHistoryNextSequence;
+
+    for( i = 0; i < (gHistoryLevelCount_c - 1); i++ )
+    {
+        maHistoryLevels[i].head = 0;
+        maHistoryLevels[i].count = 0;
+        maHistoryLevels[i].acc.samples = 0;
+    }
+
+    ((historyBlockHeader_t *)maHistoryBlock)->samples = 0;
+    mHistoryDownload.active = FALSE;
+    mpHistoryStorage = pStorage;
+
+    return TRUE;
+}
+
+/*! *********************************************************************************
+* \brief   Records one sample into the block being filled and the rollups.
+*
+* \param[in] timestamp  ms
+* \param[in] mask       bit n set if pValues[n] is valid
+* \param[in] pValues    gHistoryQuantities_c values
+*
+********************************************************************************** */
+void SensorHistory_AddSample(uint32_t timestamp, uint8_t mask, const int32_t *pValues)
+{
+    uint8_t i;
+
+    if( NULL == mpHistoryStorage )
+    {
+        return;
+    }
+
+    mask &= (uint8_t)((1U << gHistoryQuantities_c) - 1);
+
+    SensorHistory_AppendRaw(timestamp, mask, pValues);
+
+    for( i = 0; i < (gHistoryLevelCount_c - 1); i++ )
+    {
+        SensorHistory_Accumulate(&maHistoryLevels[i], timestamp, mask, pValues);
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Sets the UNIX time of the origin of the caller's clock.
+*
+* \param[in] epoch  s
+*
+********************************************************************************** */
+void SensorHistory_SetEpoch(uint32_t epoch)
+{
+    historyBlockHeader_t *pHeader = (historyBlockHeader_t *)maHistoryBlock;
+
+    mHistoryEpoch = epoch;
+
+    /* The samples already in the block share the clock origin */
+    if( pHeader->samples )
+    {
+        pHeader->epoch = epoch;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Writes the completed blocks to storage, oldest first.
+*
+********************************************************************************** */
+void SensorHistory_Idle(void)
+{
+    uint32_t sequence;
+
+    if( NULL == mpHistoryStorage )
+    {
+        return;
+    }
+
+    while( mHistoryWriteSequence != mHistoryNextSequence )
+    {
+        sequence = mHistoryWriteSequence;
+        SensorHistory_WriteBlock(sequence, maHistoryPending[sequence % gHistoryPendingBlocks_c]);
+
+        /* Releases the pending slot, downloads read the block from storage now */
+        mHistoryWriteSequence = sequence + 1;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Writes the block being filled and the completed blocks to storage.
+*
+********************************************************************************** */
+void SensorHistory_Flush(void)
+{
+    if( NULL == mpHistoryStorage )
+    {
+        return;
+    }
+
+    SensorHistory_Idle();
+
+    if( ((historyBlockHeader_t *)maHistoryBlock)->samples )
+    {
+        SensorHistory_CloseBlock();
+        SensorHistory_Idle();
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Starts a download, aborting the one in progress.
+*
+* \param[in] level     historyLevel_t
+* \param[in] fromTime  s, UNIX time
+*
+* \return  FALSE if the level is not valid
+*
+********************************************************************************** */
+bool_t SensorHistory_StartDownload(uint8_t level, uint32_t fromTime)
+{
+    uint32_t epoch = mHistoryEpoch;
+
+    if( (NULL == mpHistoryStorage) || (level >= gHistoryLevelCount_c) )
+    {
+        return FALSE;
+    }
+
+    mHistoryDownload.level = level;
+    mHistoryDownload.fromEpochTime = fromTime;
+    mHistoryDownload.fromTime = 0;
+
+    /* The rollups are all on the current clock */
+    if( (0 != epoch) && (fromTime > epoch) )
+    {
+        mHistoryDownload.fromTime = (fromTime - epoch) * 1000;
+    }
+
+    mHistoryDownload.position = mHistoryOldestSequence;
+    mHistoryDownload.currentSent = FALSE;
+    mHistoryDownload.offset = 0;
+    mHistoryDownload.length = 0;
+    mHistoryDownload.active = TRUE;
+
+    return TRUE;
+}
+
+/*! *********************************************************************************
+* \brief   Reads the next bytes of the download.
+*
+* \param[out] pBuf    destination
+* \param[in]  maxLen  size of pBuf
+*
+* \return  number of bytes copied, 0 when the download is complete
+*
+********************************************************************************** */
+uint16_t SensorHistory_ReadDownload(uint8_t *pBuf, uint16_t maxLen)
+{
+    uint16_t len = 0;
+    uint16_t chunk;
+
+    while( mHistoryDownload.active && (len < maxLen) )
+    {
+        if( mHistoryDownload.offset == mHistoryDownload.length )
+        {
+            mHistoryDownload.offset = 0;
+            mHistoryDownload.length = 0;
+
+            if( !SensorHistory_StageNext() )
+            {
+                mHistoryDownload.active = FALSE;
+                break;
+            }
+        }
+
+        chunk = MIN(maxLen - len, mHistoryDownload.length - mHistoryDownload.offset);
+        FLib_MemCpy(&pBuf[len], &mHistoryDownload.buf[mHistoryDownload.offset], chunk);
+        mHistoryDownload.offset += chunk;
+        len += chunk;
+    }
+
+    return len;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Private functions
+*************************************************************************************
+********************************************************************************** */
+
+/*! *********************************************************************************
+* \brief   Delta encodes a sample at the end of the block being filled, closing
+*          the block first if the record does not fit anymore.
+*
+********************************************************************************** */
+static void SensorHistory_AppendRaw(uint32_t timestamp, uint8_t mask, const int32_t *pValues)
+{
+    historyBlockHeader_t *pHeader = (historyBlockHeader_t *)maHistoryBlock;
+    uint8_t record[mHistoryMaxRecordSize_c];
+    uint8_t len;
+
+    if( (pHeader->samples != 0) &&
+        ((pHeader->samples == 0xFF) || (mHistoryTimeDiff_m(timestamp, mHistoryPrevTime) < 0)) )
+    {
+        SensorHistory_CloseBlock();
+    }
+
+    if( pHeader->samples == 0 )
+    {
+        SensorHistory_StartBlock(timestamp);
+    }
+
+    len = SensorHistory_EncodeRecord(record, timestamp - mHistoryPrevTime, mask, pValues);
+
+    if( (pHeader->length + len) > mHistoryBlockCapacity_c )
+    {
+        SensorHistory_CloseBlock();
+        SensorHistory_StartBlock(timestamp);
+        len = SensorHistory_EncodeRecord(record, 0, mask, pValues);
+    }
+
+    FLib_MemCpy(&maHistoryBlock[sizeof(historyBlockHeader_t) + pHeader->length], record, len);
+    pHeader->length += len;
+    pHeader->samples++;
+    pHeader->lastTime = timestamp;
+    mHistoryPrevTime = timestamp;
+}
+
+/*! *********************************************************************************
+* \brief   Encodes one record and updates the previous values of the block.
+*
+* \return  record length
+*
+********************************************************************************** */
+static uint8_t SensorHistory_EncodeRecord(uint8_t *pDst, uint32_t delta, uint8_t mask, const int32_t *pValues)
+{
+    uint8_t len = 0;
+    uint8_t i;
+    uint32_t zigzag;
+
+    do
+    {
+        pDst[len++] = (uint8_t)((delta & 0x7F) | ((delta > 0x7F) ? 0x80 : 0));
+        delta >>= 7;
+    } while( delta );
+
+    pDst[len++] = mask;
+
+    for( i = 0; i < gHistoryQuantities_c; i++ )
+    {
+        if( mask & (1U << i) )
+        {
+            int32_t diff = (int32_t)((uint32_t)pValues[i] - (uint32_t)maHistoryPrevValue[i]);
+
+            maHistoryPrevValue[i] = pValues[i];
+            zigzag = ((uint32_t)diff << 1) ^ (uint32_t)(diff >> 31);
+
+            do
+            {
+                pDst[len++] = (uint8_t)((zigzag & 0x7F) | ((zigzag > 0x7F) ? 0x80 : 0));
+                zigzag >>= 7;
+            } while( zigzag );
+        }
+    }
+
+    return len;
+}
+
+/*! *********************************************************************************
+* \brief   Prepares an empty block, its first record is stored at timestamp.
+*
+********************************************************************************** */
+static void SensorHistory_StartBlock(uint32_t timestamp)
+{
+    historyBlockHeader_t *pHeader = (historyBlockHeader_t *)maHistoryBlock;
+
+    pHeader->magic = gHistoryBlockMagic_c;
+    pHeader->version = gHistoryBlockVersion_c;
+    pHeader->samples = 0;
+    pHeader->sequence = mHistoryNextSequence;
+    pHeader->epoch = mHistoryEpoch;
+    pHeader->firstTime = timestamp;
+    pHeader->lastTime = timestamp;
+    pHeader->length = 0;
+
+    FLib_MemSet(maHistoryPrevValue, 0, sizeof(maHistoryPrevValue));
+    mHistoryPrevTime = timestamp;
+}
+
+/*! *********************************************************************************
+* \brief   Queues the block being filled for SensorHistory_Idle(). If all the
+*          pending slots are taken its samples are dropped and its sequence is
+*          reused by the next block.
+*
+********************************************************************************** */
+static void SensorHistory_CloseBlock(void)
+{
+    historyBlockHeader_t *pHeader = (historyBlockHeader_t *)maHistoryBlock;
+    uint32_t sequence = mHistoryNextSequence;
+
+    if( (sequence - mHistoryWriteSequence) < gHistoryPendingBlocks_c )
+    {
+        FLib_MemCpy(maHistoryPending[sequence % gHistoryPendingBlocks_c], maHistoryBlock,
+                    sizeof(historyBlockHeader_t) + pHeader->length);
+        mHistoryNextSequence = sequence + 1;
+    }
+
+    pHeader->samples = 0;
+}
+
+/*! *********************************************************************************
+* \brief   Writes a completed block to its slot. The first block of a sector
+*          erases it, dropping the oldest blocks once the region has wrapped.
+*
+********************************************************************************** */
+static void SensorHistory_WriteBlock(uint32_t sequence, const uint8_t *pBlock)
+{
+    const historyBlockHeader_t *pHeader = (const historyBlockHeader_t *)pBlock;
+    uint32_t addr = mpHistoryStorage->baseAddr + (sequence % mHistoryBlocks) * gHistoryBlockSize_c;
+
+    if( 0 == (sequence % mHistoryBlocksPerSector) )
+    {
+        if( (sequence + mHistoryBlocksPerSector) > (mHistoryOldestSequence + mHistoryBlocks) )
+        {
+            mHistoryOldestSequence = sequence + mHistoryBlocksPerSector - mHistoryBlocks;
+        }
+
+        (void)mpHistoryStorage->erase(addr);
+    }
+
+    /* A failed write leaves a slot that Init and the downloads skip */
+    (void)mpHistoryStorage->program(addr, sizeof(historyBlockHeader_t) + pHeader->length, pBlock);
+}
+
+/*! *********************************************************************************
+* \brief   Reads a stored block and checks that it is the expected one.
+*
+********************************************************************************** */
+static bool_t SensorHistory_ReadBlock(uint32_t sequence, uint8_t *pBuf)
+{
+    historyBlockHeader_t *pHeader = (historyBlockHeader_t *)pBuf;
+    uint32_t addr = mpHistoryStorage->baseAddr + (sequence % mHistoryBlocks) * gHistoryBlockSize_c;
+
+    return mpHistoryStorage->read(addr, gHistoryBlockSize_c, pBuf) &&
+           (pHeader->magic == gHistoryBlockMagic_c) &&
+           (pHeader->sequence == sequence) &&
+           (pHeader->length <= mHistoryBlockCapacity_c);
+}
+
+/*! *********************************************************************************
+* \brief   Tells whether a block ends at or after the start of the download.
+*          Blocks of an unknown epoch are always sent.
+*
+********************************************************************************** */
+static bool_t SensorHistory_IsBlockWanted(const historyBlockHeader_t *pHeader)
+{
+    return (0 == pHeader->epoch) ||
+           ((pHeader->epoch + pHeader->lastTime / 1000) >= mHistoryDownload.fromEpochTime);
+}
+
+/*! *********************************************************************************
+* \brief   Adds a sample to the period in progress of one resolution, closing
+*          the period first if the sample belongs to a later one.
+*
+********************************************************************************** */
+static void SensorHistory_Accumulate(historyRollupLevel_t *pLevel, uint32_t timestamp, uint8_t mask, const int32_t *pValues)
+{
+    historyAccumulator_t *pAcc = &pLevel->acc;
+    uint32_t start = timestamp - (timestamp % pLevel->period);
+    uint8_t i;
+
+    if( pAcc->samples && (pAcc->startTime != start) )
+    {
+        (void)SensorHistory_SerializeRollup((uint8_t *)&pLevel->pRing[pLevel->head],
+                                            (uint8_t)(pLevel - maHistoryLevels) + 1, pAcc);
+
+        pLevel->head = (pLevel->head + 1) % pLevel->size;
+
+        if( pLevel->count < pLevel->size )
+        {
+            pLevel->count++;
+        }
+
+        pAcc->samples = 0;
+    }
+
+    if( 0 == pAcc->samples )
+    {
+        pAcc->startTime = start;
+        pAcc->mask = 0;
+        FLib_MemSet(pAcc->count, 0, sizeof(pAcc->count));
+    }
+
+    for( i = 0; i < gHistoryQuantities_c; i++ )
+    {
+        if( !(mask & (1U << i)) )
+        {
+            continue;
+        }
+
+        if( 0 == pAcc->count[i] )
+        {
+            pAcc->min[i] = pValues[i];
+            pAcc->max[i] = pValues[i];
+            pAcc->sum[i] = 0;
+        }
+        else if( pValues[i] < pAcc->min[i] )
+        {
+            pAcc->min[i] = pValues[i];
+        }
+        else if( pValues[i] > pAcc->max[i] )
+        {
+            pAcc->max[i] = pValues[i];
+        }
+
+        pAcc->sum[i] += pValues[i];
+        pAcc->count[i]++;
+    }
+
+    pAcc->mask |= mask;
+
+    if( pAcc->samples < 0xFFFF )
+    {
+        pAcc->samples++;
+    }
+}
+
+/*! *********************************************************************************
+* \brief   Writes a period as historyRollupHeader_t followed by the statistics of
+*          the quantities present.
+*
+* \return  number of bytes written
+*
+********************************************************************************** */
+static uint16_t SensorHistory_SerializeRollup(uint8_t *pDst, uint8_t level, const historyAccumulator_t *pAcc)
+{
+    historyRollupHeader_t header;
+    historyStats_t stats;
+    uint16_t len = sizeof(header);
+    uint8_t i;
+
+    header.epoch = mHistoryEpoch;
+    header.startTime = pAcc->startTime;
+    header.level = level;
+    header.mask = pAcc->mask;
+    header.samples = pAcc->samples;
+    FLib_MemCpy(pDst, &header, sizeof(header));
+
+    for( i = 0; i < gHistoryQuantities_c; i++ )
+    {
+        if( pAcc->mask & (1U << i) )
+        {
+            stats.min = pAcc->min[i];
+            stats.max = pAcc->max[i];
+            stats.mean = (int32_t)(pAcc->sum[i] / pAcc->count[i]);
+            FLib_MemCpy(&pDst[len], &stats, sizeof(stats));
+            len += sizeof(stats);
+        }
+    }
+
+    return len;
+}
+
+/*! *********************************************************************************
+* \brief   Loads the next block or rollup of the download into its buffer.
+*
+* \return  FALSE when there is nothing left to send
+*
+********************************************************************************** */
+static bool_t SensorHistory_StageNext(void)
+{
+    if( gHistoryLevelRaw_c == mHistoryDownload.level )
+    {
+        return SensorHistory_StageRaw();
+    }
+
+    return SensorHistory_StageRollup();
+}
+
+/*! *********************************************************************************
+* \brief   Stages the next completed block ending at or after the start of the
+*          download, from storage or from the pending slots, then the block
+*          being filled.
+*
+********************************************************************************** */
+static bool_t SensorHistory_StageRaw(void)
+{
+    historyBlockHeader_t *pHeader = (historyBlockHeader_t *)mHistoryDownload.buf;
+    uint32_t sequence;
+    bool_t valid;
+
+    /* Blocks may have been erased since the download started */
+    if( mHistoryDownload.position < mHistoryOldestSequence )
+    {
+        mHistoryDownload.position = mHistoryOldestSequence;
+    }
+
+    while( mHistoryDownload.position < mHistoryNextSequence )
+    {
+        sequence = mHistoryDownload.position++;
+
+        /* A pending slot is only reused once another block is closed, which
+         * happens in this context: it stays valid after being written */
+        if( sequence >= mHistoryWriteSequence )
+        {
+            FLib_MemCpy(mHistoryDownload.buf, maHistoryPending[sequence % gHistoryPendingBlocks_c], gHistoryBlockSize_c);
+            valid = TRUE;
+        }
+        else
+        {
+            valid = SensorHistory_ReadBlock(sequence, mHistoryDownload.buf);
+        }
+
+        if( valid && SensorHistory_IsBlockWanted(pHeader) )
+        {
+            mHistoryDownload.length = sizeof(historyBlockHeader_t) + pHeader->length;
+            return TRUE;
+        }
+    }
+
+    pHeader = (historyBlockHeader_t *)maHistoryBlock;
+
+    if( !mHistoryDownload.currentSent && pHeader->samples && SensorHistory_IsBlockWanted(pHeader) )
+    {
+        mHistoryDownload.currentSent = TRUE;
+        mHistoryDownload.length = sizeof(historyBlockHeader_t) + pHeader->length;
+        FLib_MemCpy(mHistoryDownload.buf, maHistoryBlock, mHistoryDownload.length);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*! *********************************************************************************
+* \brief   Stages the oldest rollup starting at or after fromTime, then the
+*          period in progress. fromTime moves past every staged rollup, so the
+*          ring may keep filling while the download runs.
+*
+********************************************************************************** */
+static bool_t SensorHistory_StageRollup(void)
+{
+    historyRollupLevel_t *pLevel = &maHistoryLevels[mHistoryDownload.level - 1];
+    historyRollup_t *pRollup;
+    uint8_t i;
+    uint8_t q;
+
+    for( i = 0; i < pLevel->count; i++ )
+    {
+        pRollup = &pLevel->pRing[(pLevel->head + pLevel->size - pLevel->count + i) % pLevel->size];
+
+        if( mHistoryTimeDiff_m(pRollup->header.startTime, mHistoryDownload.fromTime) >= 0 )
+        {
+            mHistoryDownload.length = sizeof(historyRollupHeader_t);
+
+            for( q = 0; q < gHistoryQuantities_c; q++ )
+            {
+                if( pRollup->header.mask & (1U << q) )
+                {
+                    mHistoryDownload.length += sizeof(historyStats_t);
+                }
+            }
+
+            FLib_MemCpy(mHistoryDownload.buf, pRollup, mHistoryDownload.length);
+            /* The epoch may have been learnt after the period was closed */
+            ((historyRollupHeader_t *)mHistoryDownload.buf)->epoch = mHistoryEpoch;
+            mHistoryDownload.fromTime = pRollup->header.startTime + pLevel->period;
+            return TRUE;
+        }
+    }
+
+    if( !mHistoryDownload.currentSent && pLevel->acc.samples &&
+        (mHistoryTimeDiff_m(pLevel->acc.startTime, mHistoryDownload.fromTime) >= 0) )
+    {
+        mHistoryDownload.currentSent = TRUE;
+        mHistoryDownload.length = SensorHistory_SerializeRollup(mHistoryDownload.buf,
+                                                                mHistoryDownload.level, &pLevel->acc);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+#if gHistorySpiFlashEnabled_d
+/*! *********************************************************************************
+* \brief   External SPI flash storage. The bus is shared with the KW41Z, so it is
+*          acquired for every access.
+*
+********************************************************************************** */
+static bool_t SensorHistory_SpiRead(uint32_t addr, uint32_t len, uint8_t *pData)
+{
+    status_t status;
+
+    SPI_Bus_Share_Acquire(kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, SPI_BUS_SHARE_NO_DEADLINE);
+    status = SPI_Flash_Read(addr, len, pData);
+    SPI_Bus_Share_Release();
+    return (SPI_FLASH_NO_ERROR == status);
+}
+
+static bool_t SensorHistory_SpiProgram(uint32_t addr, uint32_t len, const uint8_t *pData)
+{
+    status_t status;
+
+    SPI_Bus_Share_Acquire(kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, SPI_BUS_SHARE_NO_DEADLINE);
+    status = SPI_Flash_Write(addr, len, (void *)pData);
+    SPI_Bus_Share_Release();
+    return (SPI_FLASH_NO_ERROR == status);
+}
+
+static bool_t SensorHistory_SpiErase(uint32_t addr)
+{
+    status_t status;
+
+    SPI_Bus_Share_Acquire(kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, SPI_BUS_SHARE_NO_DEADLINE);
+    status = SPI_Flash_Erase_Block(addr, FLASH_SECTOR_SIZE);
+    SPI_Bus_Share_Release();
+    return (SPI_FLASH_NO_ERROR == status);
+}
+#endif /* gHistorySpiFlashEnabled_d */
+
+/*! *********************************************************************************
+* \brief   RAM storage, behaves like a flash whose sectors are one block.
+*
+********************************************************************************** */
+static bool_t SensorHistory_RamRead(uint32_t addr, uint32_t len, uint8_t *pData)
+{
+    FLib_MemCpy(pData, &maHistoryRamStorage[addr], len);
+    return TRUE;
+}
+
+static bool_t SensorHistory_RamProgram(uint32_t addr, uint32_t len, const uint8_t *pData)
+{
+    FLib_MemCpy(&maHistoryRamStorage[addr], (void *)pData, len);
+    return TRUE;
+}
+
+static bool_t SensorHistory_RamErase(uint32_t addr)
+{
+    FLib_MemSet(&maHistoryRamStorage[addr], 0xFF, gHistoryBlockSize_c);
+    return TRUE;
+}
@@ -0,0 +1,396 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file SensorHistoryTest.c
+* Host test for the sensor history module. The module source is built in with a
+* simulated NOR flash (program only clears bits, erase works on whole sectors)
+* which counts the accesses, so the test can check that samples never reach the
+* storage outside of SensorHistory_Idle().
+*
+* Build and run with "make" from this directory.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define gHistorySpiFlashEnabled_d   0
+#include "../Source/SensorHistory.c"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Stubs
+*************************************************************************************
+********************************************************************************** */
+void FLib_MemCpy(void *pDst, void *pSrc, uint32_t cBytes) { memmove(pDst, pSrc, cBytes); }
+void FLib_MemSet(void *pDst, uint8_t value, uint32_t cBytes) { memset(pDst, value, cBytes); }
+
+#define mSectorSize_c       (4 * gHistoryBlockSize_c)
+#define mFlashSize_c        (4 * mSectorSize_c)
+
+static uint8_t  maFlash[mFlashSize_c];
+static uint32_t mPrograms;
+static uint32_t mErases;
+
+static bool_t FlashRead(uint32_t addr, uint32_t len, uint8_t *pData)
+{
+    memcpy(pData, &maFlash[addr], len);
+    return TRUE;
+}
+
+static bool_t FlashProgram(uint32_t addr, uint32_t len, const uint8_t *pData)
+{
+    uint32_t i;
+
+    for( i = 0; i < len; i++ )
+    {
+        maFlash[addr + i] &= pData[i];
+    }
+    mPrograms++;
+    return TRUE;
+}
+
+static bool_t FlashErase(uint32_t addr)
+{
+    memset(&maFlash[addr], 0xFF, mSectorSize_c);
+    mErases++;
+    return TRUE;
+}
+
+static const historyStorage_t mFlashStorage =
+{
+    0, mFlashSize_c, mSectorSize_c, FlashRead, FlashProgram, FlashErase
+};
+
+/*! *********************************************************************************
+*************************************************************************************
+* Helpers
+*************************************************************************************
+********************************************************************************** */
+#define CHECK(c)    do { if( !(c) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while(0)
+
+#define mMaxSamples_c   4096
+
+typedef struct
+{
+    uint32_t epoch;
+    uint32_t time;
+    uint8_t  mask;
+    int32_t  values[gHistoryQuantities_c];
+} sample_t;
+
+static sample_t maDecoded[mMaxSamples_c];
+static uint32_t mDecodedCount;
+static uint8_t  maStream[64 * 1024];
+
+static void MakeSample(uint32_t i, int32_t *pValues)
+{
+    uint8_t q;
+
+    for( q = 0; q < gHistoryQuantities_c; q++ )
+    {
+        pValues[q] = (int32_t)(2000 + q * 100) + (int32_t)((i * 7 + q * 13) % 50) - 25;
+    }
+}
+
+static void AddSamples(uint32_t first, uint32_t count)
+{
+    int32_t values[gHistoryQuantities_c];
+    uint32_t i;
+
+    for( i = first; i < first + count; i++ )
+    {
+        MakeSample(i, values);
+        SensorHistory_AddSample(i * 1000, 0x3F, values);
+    }
+}
+
+static uint32_t Varint(const uint8_t *pData, uint32_t *pPos)
+{
+    uint32_t value = 0;
+    uint32_t shift = 0;
+    uint8_t b;
+
+    do
+    {
+        b = pData[(*pPos)++];
+        value |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while( b & 0x80 );
+
+    return value;
+}
+
+static uint32_t Download(uint8_t level, uint32_t fromTime)
+{
+    uint32_t len = 0;
+    uint16_t n;
+
+    CHECK(SensorHistory_StartDownload(level, fromTime));
+
+    /* Odd frame size, as on the history characteristic */
+    while( 0 != (n = SensorHistory_ReadDownload(&maStream[len], 19)) )
+    {
+        len += n;
+        CHECK(len < sizeof(maStream) - 19);
+    }
+
+    return len;
+}
+
+/* Decodes a raw download, checking the block headers on the way */
+static void DecodeRaw(uint32_t len)
+{
+    historyBlockHeader_t header;
+    int32_t prev[gHistoryQuantities_c];
+    uint32_t pos = 0;
+    uint32_t end;
+    uint32_t time;
+    uint32_t z;
+    uint8_t q;
+    uint8_t n;
+
+    mDecodedCount = 0;
+
+    while( pos < len )
+    {
+        memcpy(&header, &maStream[pos], sizeof(header));
+        CHECK(header.magic == gHistoryBlockMagic_c);
+        CHECK(header.version == gHistoryBlockVersion_c);
+        pos += sizeof(header);
+        end = pos + header.length;
+        time = header.firstTime;
+        memset(prev, 0, sizeof(prev));
+        n = 0;
+
+        while( pos < end )
+        {
+            sample_t *pSample = &maDecoded[mDecodedCount++];
+
+            time += Varint(maStream, &pos);
+            pSample->epoch = header.epoch;
+            pSample->time = time;
+            pSample->mask = maStream[pos++];
+
+            for( q = 0; q < gHistoryQuantities_c; q++ )
+            {
+                if( pSample->mask & (1U << q) )
+                {
+                    z = Varint(maStream, &pos);
+                    prev[q] += (int32_t)((z >> 1) ^ (0U - (z & 1)));
+                    pSample->values[q] = prev[q];
+                }
+            }
+            n++;
+        }
+
+        CHECK(pos == end);
+        CHECK(n == header.samples);
+        CHECK(time == header.lastTime);
+    }
+}
+
+/* Checks that the decoded samples are first, first + 1, ... */
+static void CheckRun(uint32_t from, uint32_t first, uint32_t count)
+{
+    int32_t values[gHistoryQuantities_c];
+    uint32_t i;
+
+    CHECK(from + count <= mDecodedCount);
+
+    for( i = 0; i < count; i++ )
+    {
+        MakeSample(first + i, values);
+        CHECK(maDecoded[from + i].time == (first + i) * 1000);
+        CHECK(0 == memcmp(maDecoded[from + i].values, values, sizeof(values)));
+    }
+}
+
+static void Reset(void)
+{
+    memset(maFlash, 0xFF, sizeof(maFlash));
+    mPrograms = 0;
+    mErases = 0;
+    mHistoryEpoch = 0;
+    CHECK(SensorHistory_Init(&mFlashStorage));
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Tests
+*************************************************************************************
+********************************************************************************** */
+
+/* Completed blocks are only written by SensorHistory_Idle() */
+static void TestDeferredWrites(void)
+{
+    Reset();
+    AddSamples(0, 40);
+    CHECK(mHistoryNextSequence == 1);
+    CHECK(0 == mPrograms);
+    CHECK(0 == mErases);
+
+    /* A download before the idle loop ran still sees every sample */
+    DecodeRaw(Download(gHistoryLevelRaw_c, 0));
+    CHECK(40 == mDecodedCount);
+    CheckRun(0, 0, 40);
+
+    SensorHistory_Idle();
+    CHECK(1 == mPrograms);
+    CHECK(1 == mErases);
+    CHECK(mHistoryWriteSequence == mHistoryNextSequence);
+
+    DecodeRaw(Download(gHistoryLevelRaw_c, 0));
+    CHECK(40 == mDecodedCount);
+    CheckRun(0, 0, 40);
+}
+
+/* A block completed while all the pending slots are taken is dropped */
+static void TestPendingOverflow(void)
+{
+    uint32_t perBlock;
+
+    Reset();
+    AddSamples(0, 1);
+    while( mHistoryNextSequence == 0 )
+    {
+        AddSamples(mHistoryPrevTime / 1000 + 1, 1);
+    }
+    perBlock = mHistoryPrevTime / 1000;
+
+    /* Fill the remaining pending slots, then lose one block */
+    AddSamples(perBlock + 1, perBlock * gHistoryPendingBlocks_c);
+    CHECK(mHistoryNextSequence == gHistoryPendingBlocks_c);
+    CHECK(0 == mPrograms);
+
+    SensorHistory_Flush();
+    CHECK(mPrograms == gHistoryPendingBlocks_c + 1);
+
+    /* The sequence of the dropped block went to the one holding the last sample */
+    DecodeRaw(Download(gHistoryLevelRaw_c, 0));
+    CHECK(mDecodedCount == perBlock * gHistoryPendingBlocks_c + 1);
+    CheckRun(0, 0, perBlock * gHistoryPendingBlocks_c);
+    CheckRun(mDecodedCount - 1, perBlock * (gHistoryPendingBlocks_c + 1), 1);
+}
+
+/* Blocks survive a reset, and the oldest sectors are recycled */
+static void TestResumeAndWrap(void)
+{
+    uint32_t i;
+    uint32_t last = 0;
+
+    Reset();
+
+    for( i = 0; i < 80; i++ )
+    {
+        AddSamples(i * 10, 10);
+        SensorHistory_Idle();
+    }
+    SensorHistory_Flush();
+    CHECK(mHistoryNextSequence > mHistoryBlocks);
+
+    CHECK(SensorHistory_Init(&mFlashStorage));
+    CHECK(mHistoryWriteSequence == mHistoryNextSequence);
+    CHECK(mHistoryNextSequence - mHistoryOldestSequence <= mHistoryBlocks);
+
+    DecodeRaw(Download(gHistoryLevelRaw_c, 0));
+    CHECK(mDecodedCount > 0);
+    last = maDecoded[mDecodedCount - 1].time / 1000;
+    CHECK(799 == last);
+    CheckRun(0, maDecoded[0].time / 1000, mDecodedCount);
+}
+
+/* Blocks carry the UNIX time of the clock origin once it is known */
+static void TestEpoch(void)
+{
+    const uint32_t boot = 1500000000;
+    uint32_t i;
+
+    Reset();
+    AddSamples(0, 30);
+    SensorHistory_Flush();
+
+    /* The block being filled learns the epoch, the stored one stays unknown */
+    AddSamples(30, 5);
+    SensorHistory_SetEpoch(boot);
+    AddSamples(35, 5);
+    SensorHistory_Flush();
+
+    DecodeRaw(Download(gHistoryLevelRaw_c, 0));
+    CHECK(40 == mDecodedCount);
+    for( i = 0; i < mDecodedCount; i++ )
+    {
+        CHECK(maDecoded[i].epoch == ((maDecoded[i].time >= 30000) ? boot : 0));
+    }
+
+    /* Only the blocks of a known epoch are filtered by time */
+    AddSamples(100, 30);
+    SensorHistory_Flush();
+    DecodeRaw(Download(gHistoryLevelRaw_c, boot + 90));
+    CHECK(60 == mDecodedCount);
+    for( i = 0; i < mDecodedCount; i++ )
+    {
+        CHECK((0 == maDecoded[i].epoch) || (maDecoded[i].time >= 90000));
+    }
+    CheckRun(0, 0, 30);
+    CheckRun(30, 100, 30);
+}
+
+/* Second rollups: statistics of every complete second, then the one in progress */
+static void TestRollups(void)
+{
+    historyRollupHeader_t header;
+    historyStats_t stats;
+    int32_t values[gHistoryQuantities_c];
+    uint32_t len;
+    uint32_t pos = 0;
+    uint32_t count = 0;
+
+    Reset();
+    SensorHistory_SetEpoch(1234);
+    values[1] = 0;
+    for( uint32_t i = 0; i < 10; i++ )
+    {
+        values[0] = (int32_t)i;
+        SensorHistory_AddSample(i * 500, 0x01, values);
+    }
+
+    len = Download(gHistoryLevelSecond_c, 0);
+    while( pos < len )
+    {
+        memcpy(&header, &maStream[pos], sizeof(header));
+        memcpy(&stats, &maStream[pos + sizeof(header)], sizeof(stats));
+        pos += sizeof(header) + sizeof(stats);
+
+        CHECK(header.epoch == 1234);
+        CHECK(header.level == gHistoryLevelSecond_c);
+        CHECK(header.mask == 0x01);
+        CHECK(header.startTime == count * 1000);
+        CHECK(header.samples == 2);
+        CHECK(stats.min == (int32_t)(2 * count));
+        CHECK(stats.max == (int32_t)(2 * count + 1));
+        CHECK(stats.mean == (int32_t)(2 * count));
+        count++;
+    }
+    CHECK(pos == len);
+    CHECK(5 == count);
+
+    /* Starting at the UNIX time of the 4th second */
+    len = Download(gHistoryLevelSecond_c, 1234 + 3);
+    memcpy(&header, maStream, sizeof(header));
+    CHECK(header.startTime == 3000);
+    CHECK(len == 2 * (sizeof(header) + sizeof(stats)));
+}
+
+int main(void)
+{
+    TestDeferredWrites();
+    TestPendingOverflow();
+    TestResumeAndWrap();
+    TestEpoch();
+    TestRollups();
+
+    printf("SensorHistory: all tests passed\n");
+    return 0;
+}
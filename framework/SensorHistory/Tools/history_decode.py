@@ -0,0 +1,119 @@
+#!/usr/bin/env python
+#
+# Copyright 2018 NXP
+# All rights reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Host decoder for the sensor history downloads (SensorHistory.c).
+#
+# The frames notified on the history characteristic are one counter byte
+# followed by up to 19 bytes of the download stream. This tool reassembles the
+# stream and prints it as CSV: one line per sample for raw downloads, one line
+# per period (min/max/mean of every quantity) for rollup downloads. The time_ms
+# column is the device clock (time since boot); the utc column is only filled
+# for the blocks and rollups whose epoch is known.
+#
+# usage: history_decode.py <level> <frames.txt>
+#   level       level written in the request: 0 raw, 1 second, 2 minute, 3 hour
+#   frames.txt  one notification value per line, in hex ("0a1b2c..." or "0a-1b-2c...")
+
+import datetime
+import struct
+import sys
+
+QUANTITIES = 6
+BLOCK_MAGIC = 0x5348
+BLOCK_HEADER = struct.Struct('<HBBIIIIH')
+ROLLUP_HEADER = struct.Struct('<IIBBH')
+STATS = struct.Struct('<iii')
+
+
+def read_stream(path):
+    stream = bytearray()
+    expected = 0
+    with open(path) as f:
+        for line in f:
+            digits = ''.join(c for c in line if c in '0123456789abcdefABCDEF')
+            if not digits:
+                continue
+            frame = bytearray.fromhex(digits)
+            if frame[0] != expected:
+                sys.stderr.write('frame %d missing, got %d\n' % (expected, frame[0]))
+            expected = (frame[0] + 1) & 0xFF
+            if len(frame) == 1:
+                break
+            stream += frame[1:]
+    return stream
+
+
+def varint(data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def utc(epoch, time_ms):
+    if not epoch:
+        return ''
+    return datetime.datetime.utcfromtimestamp(epoch + time_ms / 1000.0).isoformat()
+
+
+def decode_blocks(data):
+    pos = 0
+    print('utc,time_ms,' + ','.join('q%d' % q for q in range(QUANTITIES)))
+    while pos + BLOCK_HEADER.size <= len(data):
+        magic, _, samples, sequence, epoch, first, _, length = BLOCK_HEADER.unpack_from(data, pos)
+        if magic != BLOCK_MAGIC:
+            raise ValueError('bad block at offset %d' % pos)
+        pos += BLOCK_HEADER.size
+        end = pos + length
+        prev = [0] * QUANTITIES
+        time = first
+        while pos < end:
+            delta, pos = varint(data, pos)
+            time += delta
+            mask = data[pos]
+            pos += 1
+            row = [''] * QUANTITIES
+            for q in range(QUANTITIES):
+                if mask & (1 << q):
+                    z, pos = varint(data, pos)
+                    prev[q] += (z >> 1) ^ -(z & 1)
+                    row[q] = str(prev[q])
+            print('%s,%d,%s' % (utc(epoch, time), time, ','.join(row)))
+
+
+def decode_rollups(data):
+    pos = 0
+    print('utc,start_ms,level,samples,' + ','.join('q%d_min,q%d_max,q%d_mean' % (q, q, q) for q in range(QUANTITIES)))
+    while pos + ROLLUP_HEADER.size <= len(data):
+        epoch, start, level, mask, samples = ROLLUP_HEADER.unpack_from(data, pos)
+        pos += ROLLUP_HEADER.size
+        row = [''] * (3 * QUANTITIES)
+        for q in range(QUANTITIES):
+            if mask & (1 << q):
+                row[3 * q:3 * q + 3] = [str(v) for v in STATS.unpack_from(data, pos)]
+                pos += STATS.size
+        print('%s,%d,%d,%d,%s' % (utc(epoch, start), start, level, samples, ','.join(row)))
+
+
+def main(argv):
+    if len(argv) < 3:
+        sys.stderr.write('usage: history_decode.py <level> <frames.txt>\n')
+        return 1
+    data = read_stream(argv[2])
+    if int(argv[1]) == 0:
+        decode_blocks(data)
+    else:
+        decode_rollups(data)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -91,7 +91,8 @@ typedef enum
 *************************************************************************************
 ************************************************************************************/
 #if SHELL_ENABLED
-extern cmd_tbl_t *gpCmdTable[];
+extern cmd_tbl_t **gpCmdTable;
+extern uint16_t gShellCmdCount;
 extern void (*pfShellProcessCommand) (char * pCmd, uint16_t length);
 #endif
 
@@ -122,6 +123,7 @@ void shell_putc(char c);
 uint16_t shell_printf(char * format,...);
 #endif
 cmd_tbl_t * shell_find_command( char * cmd );
+cmd_tbl_t ** shell_find_prefix( char * prefix, uint16_t * pCount );
 uint8_t make_argv(char *s, uint8_t argvsz, char * argv[]);
 char * shell_get_opt(uint8_t argc, char * argv[], char *pOption);
 
@@ -143,6 +145,7 @@ char * shell_get_opt(uint8_t argc, char * argv[], char *pOption);
 #define shell_writeBool(boolValue)
 #define shell_putc(c)
 #define shell_find_command(cmd) NULL
+#define shell_find_prefix(prefix,pCount) NULL
 #define make_argv(s,argvsz,argv) 0
 #define shell_get_opt(argc,argv,pOption) NULL
 #if SHELL_USE_PRINTF
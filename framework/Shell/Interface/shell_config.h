@@ -74,7 +74,8 @@
 #define SHELL_MAX_ARGS                (8)
 #endif
 
-/* maximum number of user functions */
+/* number of commands registered before the command table is moved to a
+   larger MemManager buffer */
 #ifndef SHELL_MAX_COMMANDS
 #define SHELL_MAX_COMMANDS            (5)
 #endif
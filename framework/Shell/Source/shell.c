@@ -86,6 +86,8 @@ if( mCmdIdx < mCmdLen )                                 \
 static void shell_main( void *params );
 static int16_t shell_ProcessChr( void );
 static void shell_erase_to_eol( void );
+static uint16_t shell_search_command( char * key, uint16_t len, bool_t upper );
+static bool_t shell_grow_command_table( void );
 
 /************************************************************************************
 *************************************************************************************
@@ -101,7 +103,12 @@ uint8_t  gShellSerMgrIf;
 uint8_t  mInsert = 1;
 uint8_t  mShellMaxCmdLen = 0;
 
-cmd_tbl_t *gpCmdTable[SHELL_MAX_COMMANDS];
+/* Registered commands, sorted by name. The table starts in maShellCmdTable and
+   is moved to a larger MemManager buffer when it is full */
+static cmd_tbl_t *maShellCmdTable[SHELL_MAX_COMMANDS];
+static uint16_t mShellCmdTableSize = SHELL_MAX_COMMANDS;
+cmd_tbl_t **gpCmdTable = maShellCmdTable;
+uint16_t gShellCmdCount = 0;
 
 int8_t (*mpfShellBreak)(uint8_t argc, char * argv[]) = NULL;
 void (*pfShellProcessCommand) (char * pCmd, uint16_t length) = NULL;
@@ -175,7 +182,13 @@ void shell_init(char* prompt)
 
     mCmdLen = 0;
     mCmdIdx = 0;
-    FLib_MemSet(gpCmdTable, 0, sizeof(gpCmdTable));
+    if( gpCmdTable != maShellCmdTable )
+    {
+        MEM_BufferFree(gpCmdTable);
+        gpCmdTable = maShellCmdTable;
+        mShellCmdTableSize = SHELL_MAX_COMMANDS;
+    }
+    gShellCmdCount = 0;
     FLib_MemSet(mCmdBuf, 0, sizeof(mCmdBuf));
 #if SHELL_USE_HELP
     shell_register_function(&CommandFun_Help);
@@ -428,35 +441,36 @@ uint16_t shell_printf(char * format,...)
 *
 * \param[in]  pAddress pointer to the command structure
 *
-* \remarks
+* \remarks  The command table grows past SHELL_MAX_COMMANDS entries as long as
+*           MemManager has a large enough buffer.
 *
 ********************************************************************************** */
 uint8_t shell_register_function(cmd_tbl_t * pAddress)
 {
-    uint16_t i;
+    uint16_t len = strlen(pAddress->name);
+    uint16_t i = shell_search_command(pAddress->name, len + 1, FALSE);
+
     /* check name conflict */
-    for(i = 0; i< SHELL_MAX_COMMANDS; i++)
+    if( (i < gShellCmdCount) && !strcmp(pAddress->name, gpCmdTable[i]->name) )
     {
-        if( gpCmdTable[i] && !strcmp(pAddress->name, gpCmdTable[i]->name) )
-        {
-            return 1;
-        }
+        return 1;
     }
-    /* insert */
-    for (i = 0; i< SHELL_MAX_COMMANDS; i++)
-    {
-        if (gpCmdTable[i] == NULL)
-        {
-            gpCmdTable[i] =  pAddress;
-            // Update max command length
-            i = strlen(pAddress->name);
-            if( i > mShellMaxCmdLen )
-                mShellMaxCmdLen = i;
 
-            return 0;
-        }
+    if( (gShellCmdCount == mShellCmdTableSize) && !shell_grow_command_table() )
+    {
+        return 1;
     }
-    return 1;
+
+    /* insert, keeping the table sorted */
+    FLib_MemInPlaceCpy(&gpCmdTable[i + 1], &gpCmdTable[i], (gShellCmdCount - i) * sizeof(cmd_tbl_t*));
+    gpCmdTable[i] = pAddress;
+    gShellCmdCount++;
+
+    // Update max command length
+    if( len > mShellMaxCmdLen )
+        mShellMaxCmdLen = len;
+
+    return 0;
 }
 
 /*! *********************************************************************************
@@ -486,15 +500,13 @@ void shell_register_function_array(cmd_tbl_t * pAddress, uint8_t num)
 ********************************************************************************** */
 uint8_t shell_unregister_function(char * name)
 {
-    uint16_t i;
+    uint16_t i = shell_search_command(name, strlen(name) + 1, FALSE);
 
-    for( i=0; i<SHELL_MAX_COMMANDS; i++ )
+    if( (i < gShellCmdCount) && !strcmp(name, gpCmdTable[i]->name) )
     {
-        if( gpCmdTable[i] && !strcmp(name, gpCmdTable[i]->name) )
-        {
-            gpCmdTable[i] = NULL;
-            return 0;
-        }
+        gShellCmdCount--;
+        FLib_MemInPlaceCpy(&gpCmdTable[i], &gpCmdTable[i + 1], (gShellCmdCount - i) * sizeof(cmd_tbl_t*));
+        return 0;
     }
 
     return 1;
@@ -560,17 +572,35 @@ cmd_tbl_t * shell_find_command (char * cmd)
         return NULL;
     }
 
-    for( i=0; i < SHELL_MAX_COMMANDS; i++)
+    i = shell_search_command(cmd, strlen(cmd) + 1, FALSE);
+
+    if( (i < gShellCmdCount) && !strcmp((char*)cmd, gpCmdTable[i]->name) )
     {
-        if( (gpCmdTable[i] != NULL) && !strcmp((char*)cmd, gpCmdTable[i]->name) )
-        {
-            return gpCmdTable[i];
-        }
+        return gpCmdTable[i];
     }
 
     return NULL;
 }
 
+/*! *********************************************************************************
+* \brief  This function returns the commands starting with a prefix. They are
+*         adjacent in gpCmdTable, which is sorted by name.
+*
+* \param [in]   prefix     start of the command names, "" for all the commands
+* \param [out]  pCount     number of commands found
+*
+* \return       cmd_tbl_t**     first command found
+*
+********************************************************************************** */
+cmd_tbl_t ** shell_find_prefix (char * prefix, uint16_t * pCount)
+{
+    uint16_t len = strlen(prefix);
+    uint16_t first = shell_search_command(prefix, len, FALSE);
+
+    *pCount = shell_search_command(prefix, len, TRUE) - first;
+    return &gpCmdTable[first];
+}
+
 /*! *********************************************************************************
 * \brief  This function splits a command string into arguments
 *
@@ -619,6 +649,71 @@ uint8_t make_argv(char *s, uint8_t argvsz, char * argv[])
 *************************************************************************************
 ************************************************************************************/
 
+/*! *********************************************************************************
+* \brief  Binary search in gpCmdTable, comparing the first len characters of the
+*         command names with the key.
+*
+* \param [in]   key     searched string
+* \param [in]   len     number of characters compared, strlen(key) + 1 for an
+*                       exact name
+* \param [in]   upper   FALSE to find the first name not below the key, TRUE
+*                       to find the first name above it
+*
+* \return       uint16_t     index in gpCmdTable, gShellCmdCount if none
+*
+********************************************************************************** */
+static uint16_t shell_search_command( char * key, uint16_t len, bool_t upper )
+{
+    uint16_t low = 0;
+    uint16_t high = gShellCmdCount;
+    uint16_t mid;
+    int cmp;
+
+    while( low < high )
+    {
+        mid = (low + high) / 2;
+        cmp = strncmp(gpCmdTable[mid]->name, key, len);
+
+        if( (cmp < 0) || (upper && (cmp == 0)) )
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/*! *********************************************************************************
+* \brief  Moves the command table to a MemManager buffer twice as large
+*
+* \return       bool_t     FALSE if no buffer is available
+*
+********************************************************************************** */
+static bool_t shell_grow_command_table( void )
+{
+    cmd_tbl_t **pTable = MEM_BufferAlloc(2 * mShellCmdTableSize * sizeof(cmd_tbl_t*));
+
+    if( !pTable )
+    {
+        return FALSE;
+    }
+
+    FLib_MemCpy(pTable, gpCmdTable, gShellCmdCount * sizeof(cmd_tbl_t*));
+
+    if( gpCmdTable != maShellCmdTable )
+    {
+        MEM_BufferFree(gpCmdTable);
+    }
+
+    gpCmdTable = pTable;
+    mShellCmdTableSize *= 2;
+    return TRUE;
+}
+
 /*! *********************************************************************************
 * \brief  This function is called every time a character is received.
 *         The main SHELL processing is done from here
@@ -67,7 +67,8 @@
 static int8_t complete_cmdv(uint8_t argc, char * argv[], char last_char, uint8_t maxv, char *cmdv[])
 {
     cmd_tbl_t *cmdtp;
-    uint8_t i;
+    cmd_tbl_t **ppCmd;
+    uint16_t count;
     uint8_t n_found = 0;
 
     cmdv[0] = NULL;
@@ -93,23 +94,17 @@ static int8_t complete_cmdv(uint8_t argc, char * argv[], char last_char, uint8_t
     * Some commands allow length modifiers (like "cp.b");
     * compare command name only until first dot.
     */
-    for(i=0; i<SHELL_MAX_COMMANDS; i++)
+    ppCmd = shell_find_prefix(argc ? argv[0] : "", &count);
+
+    while( count-- )
     {
-        if( gpCmdTable[i] && gpCmdTable[i]->name )
+        /* too many! */
+        if (n_found >= maxv - 2)
         {
-            if( argc && !FLib_MemCmp(argv[0], gpCmdTable[i]->name, strlen(argv[0])) )
-            {
-                continue;
-            }
-
-            /* too many! */
-            if (n_found >= maxv - 2)
-            {
-                cmdv[n_found++] = "...";
-                break;
-            }
-            cmdv[n_found++] = gpCmdTable[i]->name;
+            cmdv[n_found++] = "...";
+            break;
         }
+        cmdv[n_found++] = (*ppCmd++)->name;
     }
     cmdv[n_found] = NULL;
     return n_found;
@@ -145,57 +145,48 @@ static int8_t DoHelp(uint8_t argc, char * argv[])
         
         if( pStr )
         {
-            for( i=0; i<SHELL_MAX_COMMANDS; i++ )
+            for( i=0; i<gShellCmdCount; i++ )
             {
-                if( gpCmdTable[i] )
-                {
-                    uint16_t len = strlen(gpCmdTable[i]->name);
-                    
-                    FLib_MemCpy( pStr, gpCmdTable[i]->name, len );
-                    FLib_MemSet( &pStr[len], ' ', mShellMaxCmdLen - len + 2); 
-                    shell_writeN(pStr, mShellMaxCmdLen + 2);
-                    shell_write(gpCmdTable[i]->usage);
-                    SHELL_NEWLINE();
-                }
+                uint16_t len = strlen(gpCmdTable[i]->name);
+
+                FLib_MemCpy( pStr, gpCmdTable[i]->name, len );
+                FLib_MemSet( &pStr[len], ' ', mShellMaxCmdLen - len + 2);
+                shell_writeN(pStr, mShellMaxCmdLen + 2);
+                shell_write(gpCmdTable[i]->usage);
+                SHELL_NEWLINE();
             }
 
             MEM_BufferFree(pStr);
         }
         else
         {
-            for( i=0; i<SHELL_MAX_COMMANDS; i++ )
+            for( i=0; i<gShellCmdCount; i++ )
             {
-                if( gpCmdTable[i] )
-                {
-                    shell_write(gpCmdTable[i]->name);
-                    shell_writeN(" ", 1);
-                    shell_write(gpCmdTable[i]->usage);
-                    SHELL_NEWLINE();
-                }
+                shell_write(gpCmdTable[i]->name);
+                shell_writeN(" ", 1);
+                shell_write(gpCmdTable[i]->usage);
+                SHELL_NEWLINE();
             }
         }
     }
     else if (argc == 2)
     {
-        for( i=0; i<SHELL_MAX_COMMANDS; i++ )
+        cmd_tbl_t *cmdtp = shell_find_command(argv[1]);
+
+        if( cmdtp )
         {
-            if( gpCmdTable[i] && !strcmp(argv[1], gpCmdTable[i]->name))
+            if (cmdtp->help != NULL)
             {
-                if (gpCmdTable[i]->help != NULL)
-                {
-                    shell_write(gpCmdTable[i]->name);
-                    shell_writeN(" - ", 3);
-                    shell_write(gpCmdTable[i]->help);
-                    SHELL_NEWLINE();
-                    return CMD_RET_SUCCESS;
-                }
-                else
-                {
-                    shell_write ("- No additional help available.\r\n");
-                    return CMD_RET_SUCCESS;
-                }
+                shell_write(cmdtp->name);
+                shell_writeN(" - ", 3);
+                shell_write(cmdtp->help);
+                SHELL_NEWLINE();
             }
-
+            else
+            {
+                shell_write ("- No additional help available.\r\n");
+            }
+            return CMD_RET_SUCCESS;
         }
         shell_write( "- No command available.\r\n" );
     }
@@ -218,21 +209,17 @@ static int8_t DoHelp(uint8_t argc, char * argv[])
 ********************************************************************************** */
 static int8_t DoHelpComplete(uint8_t argc, char * argv[], char last_char, uint8_t maxv, char * cmdv[])
 {
-    uint8_t str_len;
+    cmd_tbl_t **ppCmd;
+    uint16_t count;
     uint8_t found = 0;
-    uint8_t i;
-    str_len = strlen(argv[argc-1]);
 
     switch(argc)
     {
         case 2:
-            for( i=0; i<SHELL_MAX_COMMANDS; i++ )
+            ppCmd = shell_find_prefix(argv[argc-1], &count);
+            while( count-- && (found < maxv - 1) )
             {
-                if(gpCmdTable[i] && !strncmp(argv[argc-1], gpCmdTable[i]->name, str_len))
-                {
-                    cmdv[found] = gpCmdTable[i]->name;
-                    found++;
-                }  
+                cmdv[found++] = (*ppCmd++)->name;
             }
             break;
         default:
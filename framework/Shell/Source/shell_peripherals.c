@@ -40,6 +40,12 @@
 #include "sensors.h"
 #include "app_config.h"
 #include "board.h"
+#include "fsl_ftoa.h"
+#include "KVStore.h"
+#if defined(FSL_RTOS_FREE_RTOS)
+#include "motion_capture.h"
+#include "sensor_fusion.h"
+#endif
 
 #if SHELL_DEBUGGER
 
@@ -58,16 +64,30 @@ const char mpGetSensorHelp[] = "\r\n"
                                "get magnetometer\r\n"
                                "get motiondetect\r\n"
                                "get freefalldetect\r\n"
-                               "get tapcount\r\n";
+                               "get tapcount\r\n"
+#if defined(FSL_RTOS_FREE_RTOS)
+                               "get orientation\r\n"
+#endif
+                               ;
 const char mpSetSensorHelp[] = "\r\n"
                                "set led intensity color \r\n"
+                               "set led ramp/breathe/wheel intensity color periodMs\r\n"
+                               "set led blink intensity color periodMs onMs\r\n"
+                               "set led stop\r\n"
                                "set buzzer 0/1\r\n"
-                               "set backlight level\r\n";
+                               "set backlight level\r\n"
+#if defined(FSL_RTOS_FREE_RTOS)
+                               "set motion rate(100/200/400) watermark(1-31)\r\n"
+                               "set motion 0\r\n"
+                               "set fusion rate\r\n"
+                               "set fusion 0\r\n"
+#endif
+                               ;
 
 const cmd_tbl_t mSetCmd =
 {
     .name = "set",
-    .maxargs = 4,
+    .maxargs = 7,
     .repeatable = 1,
     .cmd = SetSensorData_Command,
     .usage = (char *)mpSetSensorHelp,
@@ -106,6 +126,39 @@ static int8_t SetSensorData_Command(uint8_t argc, char *argv[])
             status = RGB_Led_Set_State(atoi(argv[2]), atoi(argv[3]));
             return (status == 0) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
         }
+        else if ((argc == 3) && !strcmp((char *)argv[2], "stop"))
+        {
+            status = RGB_Led_Stop_Pattern();
+            return (status == 0) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
+        }
+        else if ((argc == 6) || (argc == 7))
+        {
+            /* Played by the hardware, blinking forever */
+            rgb_led_pattern_t pattern = {0};
+
+            if (!strcmp((char *)argv[2], "ramp"))
+                pattern.type = RGB_LED_PATTERN_RAMP;
+            else if (!strcmp((char *)argv[2], "breathe"))
+                pattern.type = RGB_LED_PATTERN_BREATHE;
+            else if (!strcmp((char *)argv[2], "blink"))
+                pattern.type = RGB_LED_PATTERN_BLINK;
+            else if (!strcmp((char *)argv[2], "wheel"))
+                pattern.type = RGB_LED_PATTERN_WHEEL;
+            else
+                return CMD_RET_USAGE;
+
+            if ((argc == 7) != (pattern.type == RGB_LED_PATTERN_BLINK))
+                return CMD_RET_USAGE;
+
+            pattern.brightness = atoi(argv[3]);
+            pattern.color = atoi(argv[4]);
+            pattern.periodMs = atoi(argv[5]);
+            if (argc == 7)
+                pattern.onMs = atoi(argv[6]);
+
+            status = RGB_Led_Start_Pattern(&pattern);
+            return (status == 0) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
+        }
         else
             return CMD_RET_USAGE;
     }
@@ -135,12 +188,57 @@ static int8_t SetSensorData_Command(uint8_t argc, char *argv[])
     {
         if (argc == 3)
         {
-            status = Backlight_SetLevel(atoi(argv[2]));
+            uint8_t level = atoi(argv[2]);
+
+            status = Backlight_SetLevel(level);
+            if (status == 0)
+            {
+                /* Restored by Init_Display() at the next boot */
+                (void)KVStore_Set(gAppKVKeyBacklight_c, &level, sizeof(level));
+            }
+            return (status == 0) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
+        }
+        else
+            return CMD_RET_USAGE;
+    }
+#if defined(FSL_RTOS_FREE_RTOS)
+    else if (!strcmp((char *)argv[1], "motion"))
+    {
+        if ((argc == 3) && (atoi(argv[2]) == 0))
+        {
+            SensorFusion_Stop();
+            status = MotionCapture_Stop();
+            return (status == 0) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
+        }
+        else if (argc == 4)
+        {
+            /* Restart with the new rate and watermark */
+            SensorFusion_Stop();
+            (void)MotionCapture_Stop();
+            status = MotionCapture_Start(atoi(argv[2]), atoi(argv[3]));
+            return (status == 0) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
+        }
+        else
+            return CMD_RET_USAGE;
+    }
+    else if (!strcmp((char *)argv[1], "fusion"))
+    {
+        if (argc == 3)
+        {
+            if (atoi(argv[2]) == 0)
+            {
+                SensorFusion_Stop();
+                return CMD_RET_SUCCESS;
+            }
+
+            /* Fuses the running capture, see "set motion" */
+            status = SensorFusion_Start(atoi(argv[2]), NULL);
             return (status == 0) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
         }
         else
             return CMD_RET_USAGE;
     }
+#endif
     return CMD_RET_USAGE;
 }
 
@@ -160,7 +258,7 @@ static int8_t GetSensorData_Command(uint8_t argc, char *argv[])
 
         if (get_temperature((uint8_t *)&TemperatureValue, &TempSize) == 0)
         {
-            sprintf(buff, "%.2f", TemperatureValue);
+            Ftoa_FormatFloat(buff, TemperatureValue, 2);
             shell_write(buff);
         }
         else
@@ -176,7 +274,7 @@ static int8_t GetSensorData_Command(uint8_t argc, char *argv[])
 
         if (get_humidity((uint8_t *)&HumidityValue, &HumiditySize) == 0)
         {
-            sprintf(buff, "%.2f", HumidityValue);
+            Ftoa_FormatFloat(buff, HumidityValue, 2);
             shell_write(buff);
         }
         else
@@ -224,7 +322,7 @@ static int8_t GetSensorData_Command(uint8_t argc, char *argv[])
 
         if (get_ambient_light((uint8_t *)&AmbientLightValue, &AmbientLightSize) == 0)
         {
-            sprintf(buff, "%.2f", AmbientLightValue);
+            Ftoa_FormatFloat(buff, AmbientLightValue, 2);
             shell_write(buff);
         }
         else
@@ -273,7 +371,12 @@ static int8_t GetSensorData_Command(uint8_t argc, char *argv[])
 
         if (get_acceleration((uint8_t *)AccelerometerValue, &AccelerometerSize) == 0)
         {
-            sprintf(buff, "\"X\":\"%.6f\",\"Y\":\"%.6f\",\"Z\":\"%.6f\"", AccelerometerValue[0], AccelerometerValue[1], AccelerometerValue[2]);
+            char x[FTOA_MAX_STR_LEN], y[FTOA_MAX_STR_LEN], z[FTOA_MAX_STR_LEN];
+
+            Ftoa_FormatFloat(x, AccelerometerValue[0], 6);
+            Ftoa_FormatFloat(y, AccelerometerValue[1], 6);
+            Ftoa_FormatFloat(z, AccelerometerValue[2], 6);
+            sprintf(buff, "\"X\":\"%s\",\"Y\":\"%s\",\"Z\":\"%s\"", x, y, z);
             shell_write(buff);
         }
         else
@@ -289,7 +392,12 @@ static int8_t GetSensorData_Command(uint8_t argc, char *argv[])
 
         if (get_magnetic_field((uint8_t *)MagnetometerValue, &MagnetometerSize) == 0)
         {
-            sprintf(buff, "\"X\":\"%.1f\",\"Y\":\"%.1f\",\"Z\":\"%.1f\"", MagnetometerValue[0], MagnetometerValue[1], MagnetometerValue[2]);
+            char x[FTOA_MAX_STR_LEN], y[FTOA_MAX_STR_LEN], z[FTOA_MAX_STR_LEN];
+
+            Ftoa_FormatFloat(x, MagnetometerValue[0], 1);
+            Ftoa_FormatFloat(y, MagnetometerValue[1], 1);
+            Ftoa_FormatFloat(z, MagnetometerValue[2], 1);
+            sprintf(buff, "\"X\":\"%s\",\"Y\":\"%s\",\"Z\":\"%s\"", x, y, z);
             shell_write(buff);
         }
         else
@@ -386,6 +494,33 @@ static int8_t GetSensorData_Command(uint8_t argc, char *argv[])
             App_WaitMsec(20);
         }
     }
+#if defined(FSL_RTOS_FREE_RTOS)
+    else if (!strcmp((char *)argv[1], "orientation"))
+    {
+        float OrientationValue[5] = {0};
+        uint8_t OrientationSize   = 20;
+
+        if (get_orientation((uint8_t *)OrientationValue, &OrientationSize) == 0)
+        {
+            char w[FTOA_MAX_STR_LEN], x[FTOA_MAX_STR_LEN], y[FTOA_MAX_STR_LEN], z[FTOA_MAX_STR_LEN];
+            char heading[FTOA_MAX_STR_LEN];
+            char orientation[5 * FTOA_MAX_STR_LEN + 40];
+
+            Ftoa_FormatFloat(w, OrientationValue[0], 4);
+            Ftoa_FormatFloat(x, OrientationValue[1], 4);
+            Ftoa_FormatFloat(y, OrientationValue[2], 4);
+            Ftoa_FormatFloat(z, OrientationValue[3], 4);
+            Ftoa_FormatFloat(heading, OrientationValue[4], 2);
+            sprintf(orientation, "\"W\":\"%s\",\"X\":\"%s\",\"Y\":\"%s\",\"Z\":\"%s\",\"Heading\":\"%s\"",
+                    w, x, y, z, heading);
+            shell_write(orientation);
+        }
+        else
+            shell_write("\r\n-->  Notify Event: Can not read Orientation value, start the fusion with \"set fusion\". ");
+
+        return CMD_RET_SUCCESS;
+    }
+#endif
     return CMD_RET_USAGE;
 }
 #endif
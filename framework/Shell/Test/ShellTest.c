@@ -0,0 +1,574 @@
+/*!
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* \file ShellTest.c
+* Host test for the shell command table. The shell and autocomplete sources are
+* built in over a serial stub that feeds typed lines to the receive callback and
+* keeps what the shell writes back. Some 600 commands are registered in random
+* order and the sorted table is checked against a brute-force scan: exact
+* lookups, prefix runs, removal and growth. Typed lines then go through
+* dispatch, usage errors, "help" and TAB completion.
+*
+* The binary searches are counted through strncmp, so the O(log n) bound is
+* checked exactly. Lookup, prefix, dispatch and TAB times are printed for
+* growing tables, next to the linear scan of the former unsorted table.
+*
+* Build and run with "make" from this directory.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Counts the name comparisons of the binary searches in shell.c */
+static uint32_t mNameCompares;
+
+static int CountedStrncmp(const char *s1, const char *s2, size_t n)
+{
+    mNameCompares++;
+    return strncmp(s1, s2, n);
+}
+
+#define strncmp CountedStrncmp
+#include "../Source/shell.c"
+#include "../Source/shell_autocomplete.c"
+#undef strncmp
+
+#include "ModuleInfo.h"
+
+/*! *********************************************************************************
+*************************************************************************************
+* Stubs
+*************************************************************************************
+********************************************************************************** */
+#define CHECK(c)    do { if( !(c) ) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while(0)
+
+#define mOutputSize_c   (65536)
+
+static const char *mpInput;
+static char maOutput[mOutputSize_c + 1];
+static uint32_t mOutputLen;
+static pSerialCallBack_t mpRxCallback;
+static int32_t mBuffersInUse;
+
+/* "version" lists the modules found in the VERSION_TAGS section */
+static char *mpModuleString = "SHELL TEST v1.0";
+static const moduleInfo_t mModuleInfo __attribute__((section("VERSION_TAGS"), used)) = { &mpModuleString, 1, {1, 0, 0}, 1, {0} };
+
+void FLib_MemCpy(void *pDst, void *pSrc, uint32_t cBytes) { memmove(pDst, pSrc, cBytes); }
+void FLib_MemInPlaceCpy(void *pDst, void *pSrc, uint32_t cBytes) { memmove(pDst, pSrc, cBytes); }
+void FLib_MemSet(void *pDst, uint8_t value, uint32_t cBytes) { memset(pDst, value, cBytes); }
+bool_t FLib_MemCmp(void *pData1, void *pData2, uint32_t cBytes) { return 0 == memcmp(pData1, pData2, cBytes); }
+
+void *MEM_BufferAlloc(uint32_t numBytes)
+{
+    void *pBuffer = malloc(numBytes);
+
+    if( pBuffer )
+    {
+        mBuffersInUse++;
+    }
+    return pBuffer;
+}
+
+uint8_t MEM_BufferFree(void *buffer)
+{
+    mBuffersInUse--;
+    free(buffer);
+    return 0;
+}
+
+void SerialManager_Init(void)
+{
+}
+
+serialStatus_t Serial_InitInterface(uint8_t *pInterfaceId, serialInterfaceType_t interfaceType, uint8_t instance)
+{
+    *pInterfaceId = 0;
+    return gSerial_Success_c;
+}
+
+serialStatus_t Serial_SetBaudRate(uint8_t InterfaceId, uint32_t baudRate)
+{
+    return gSerial_Success_c;
+}
+
+serialStatus_t Serial_SetRxCallBack(uint8_t InterfaceId, pSerialCallBack_t cb, void *pRxParam)
+{
+    mpRxCallback = cb;
+    return gSerial_Success_c;
+}
+
+serialStatus_t Serial_Read(uint8_t InterfaceId, uint8_t *pData, uint16_t dataSize, uint16_t *bytesRead)
+{
+    *bytesRead = 0;
+    while( (*bytesRead < dataSize) && mpInput && *mpInput )
+    {
+        pData[(*bytesRead)++] = (uint8_t)*mpInput++;
+    }
+    return gSerial_Success_c;
+}
+
+serialStatus_t Serial_SyncWrite(uint8_t InterfaceId, uint8_t *pBuf, uint16_t bufLen)
+{
+    if( mOutputLen + bufLen <= mOutputSize_c )
+    {
+        memcpy(&maOutput[mOutputLen], pBuf, bufLen);
+        mOutputLen += bufLen;
+        maOutput[mOutputLen] = '\0';
+    }
+    return gSerial_Success_c;
+}
+
+serialStatus_t Serial_PrintDec(uint8_t InterfaceId, uint32_t nr)
+{
+    char str[12];
+
+    return Serial_SyncWrite(InterfaceId, (uint8_t *)str, (uint16_t)sprintf(str, "%u", (unsigned)nr));
+}
+
+serialStatus_t Serial_PrintHex(uint8_t InterfaceId, uint8_t *hex, uint8_t len, uint8_t flags)
+{
+    return gSerial_Success_c;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Commands and helpers
+*************************************************************************************
+********************************************************************************** */
+static const char *maGroups[] = { "ble", "cfg", "coap", "dfu", "disp", "fs", "gpio", "i2c", "ifconfig",
+                                  "kv", "led", "log", "mac", "mem", "motion", "net", "nvm", "ota", "ping",
+                                  "pwr", "rtc", "sens", "spi", "thr", "tmr", "uart", "usb", "wdt" };
+static const char *maVerbs[] = { "cal", "clear", "config", "disable", "dump", "enable", "erase",
+                                 "erase_all", "get", "id", "info", "list", "mode", "rate", "read", "reset",
+                                 "scan", "set", "show", "start", "stats", "stop", "test", "write" };
+
+#define mCmds_c         (NumberOfElements(maGroups) * NumberOfElements(maVerbs))
+#define mMaxArgs_c      (4)
+/* "help", "version" and "history", registered by shell_init() */
+#define mBuiltins_c     (3)
+
+static cmd_tbl_t maCmds[mCmds_c];
+static char maNames[mCmds_c][24];
+static char maHelp[mCmds_c][32];
+/* Registration order, and the table of the former shell: unsorted, scanned with strcmp */
+static cmd_tbl_t *maOrder[mCmds_c];
+static uint32_t mCalls;
+static uint8_t mLastArgc;
+static char mLastCmd[24];
+
+static int8_t DoCmd(uint8_t argc, char *argv[])
+{
+    mCalls++;
+    mLastArgc = argc;
+    strcpy(mLastCmd, argv[0]);
+    return CMD_RET_SUCCESS;
+}
+
+static void MakeCommands(void)
+{
+    uint32_t i, j;
+
+    for( i = 0; i < mCmds_c; i++ )
+    {
+        sprintf(maNames[i], "%s_%s", maGroups[i / NumberOfElements(maVerbs)], maVerbs[i % NumberOfElements(maVerbs)]);
+        sprintf(maHelp[i], "help of %s", maNames[i]);
+        maCmds[i].name = maNames[i];
+        maCmds[i].maxargs = mMaxArgs_c;
+        maCmds[i].cmd = DoCmd;
+        maCmds[i].usage = "test command";
+        maCmds[i].help = maHelp[i];
+        maOrder[i] = &maCmds[i];
+    }
+
+    for( i = mCmds_c - 1; i > 0; i-- )
+    {
+        cmd_tbl_t *pCmd = maOrder[i];
+
+        j = (uint32_t)rand() % (i + 1);
+        maOrder[i] = maOrder[j];
+        maOrder[j] = pCmd;
+    }
+}
+
+/* Shell with the built-in commands and the first count commands of maOrder */
+static void InitShell(uint32_t count)
+{
+    uint32_t i;
+
+    shell_init("$ ");
+    for( i = 0; i < count; i++ )
+    {
+        CHECK(0 == shell_register_function(maOrder[i]));
+    }
+    CHECK(gShellCmdCount == count + mBuiltins_c);
+}
+
+/* Feeds a typed line to the shell, as the serial manager does */
+static void Type(const char *pKeys)
+{
+    mOutputLen = 0;
+    maOutput[0] = '\0';
+    mpInput = pKeys;
+    mpRxCallback(NULL);
+    CHECK('\0' == *mpInput);
+}
+
+static cmd_tbl_t *LinearFind(char *name, uint32_t count)
+{
+    uint32_t i;
+
+    for( i = 0; i < count; i++ )
+    {
+        if( !strcmp(name, maOrder[i]->name) )
+        {
+            return maOrder[i];
+        }
+    }
+    return NULL;
+}
+
+static uint16_t LinearPrefix(char *prefix, uint32_t count)
+{
+    uint32_t i;
+    uint16_t found = 0;
+
+    for( i = 0; i < count; i++ )
+    {
+        if( FLib_MemCmp(prefix, maOrder[i]->name, strlen(prefix)) )
+        {
+            found++;
+        }
+    }
+    return found;
+}
+
+/* Comparisons of one lower bound search in n names */
+static uint32_t SearchSteps(uint32_t n)
+{
+    uint32_t steps = 0;
+
+    while( n )
+    {
+        steps++;
+        n >>= 1;
+    }
+    return steps;
+}
+
+static uint64_t NowNs(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+
+/*! *********************************************************************************
+*************************************************************************************
+* Tests
+*************************************************************************************
+********************************************************************************** */
+
+/* Every prefix of every name gives the same run as a brute-force scan */
+static void CheckTable(void)
+{
+    uint16_t i, j, count;
+    cmd_tbl_t **ppCmd;
+    char prefix[24];
+
+    for( i = 1; i < gShellCmdCount; i++ )
+    {
+        CHECK(strcmp(gpCmdTable[i - 1]->name, gpCmdTable[i]->name) < 0);
+    }
+
+    for( i = 0; i < gShellCmdCount; i++ )
+    {
+        mNameCompares = 0;
+        CHECK(gpCmdTable[i] == shell_find_command(gpCmdTable[i]->name));
+        CHECK(mNameCompares <= SearchSteps(gShellCmdCount));
+
+        for( j = 0; j <= strlen(gpCmdTable[i]->name); j++ )
+        {
+            uint16_t expected = 0;
+            uint16_t k;
+
+            memcpy(prefix, gpCmdTable[i]->name, j);
+            prefix[j] = '\0';
+            for( k = 0; k < gShellCmdCount; k++ )
+            {
+                expected += (0 == strncmp(prefix, gpCmdTable[k]->name, j));
+            }
+
+            mNameCompares = 0;
+            ppCmd = shell_find_prefix(prefix, &count);
+            CHECK(mNameCompares <= 2 * SearchSteps(gShellCmdCount));
+            CHECK(count == expected);
+            while( count-- )
+            {
+                CHECK(0 == strncmp(prefix, (*ppCmd++)->name, j));
+            }
+        }
+    }
+
+    CHECK(NULL == shell_find_command("zzz"));
+    CHECK(NULL == shell_find_command("a"));
+    shell_find_prefix("zzz", &count);
+    CHECK(0 == count);
+    shell_find_prefix("", &count);
+    CHECK(gShellCmdCount == count);
+}
+
+static void TestRegistry(void)
+{
+    uint32_t i;
+    char name[32];
+
+    InitShell(mCmds_c);
+    CHECK(mBuffersInUse == 1);
+    CHECK(mShellCmdTableSize >= gShellCmdCount);
+    CHECK(mShellMaxCmdLen == strlen("ifconfig_erase_all"));
+    CheckTable();
+
+    for( i = 0; i < mCmds_c; i++ )
+    {
+        CHECK(1 == shell_register_function(&maCmds[i]));
+        strcpy(name, maNames[i]);
+        strcat(name, "x");
+        CHECK(NULL == shell_find_command(name));
+        strcpy(name, maNames[i]);
+        name[strlen(name) - 1] = '\0';
+        CHECK(NULL == shell_find_command(name));
+    }
+    CHECK(gShellCmdCount == mCmds_c + mBuiltins_c);
+
+    /* Remove every third command, then put them back */
+    for( i = 0; i < mCmds_c; i += 3 )
+    {
+        CHECK(0 == shell_unregister_function(maNames[i]));
+        CHECK(1 == shell_unregister_function(maNames[i]));
+    }
+    for( i = 0; i < mCmds_c; i++ )
+    {
+        CHECK(shell_find_command(maNames[i]) == ((i % 3) ? &maCmds[i] : NULL));
+    }
+    CheckTable();
+    for( i = 0; i < mCmds_c; i += 3 )
+    {
+        CHECK(0 == shell_register_function(&maCmds[i]));
+    }
+    CHECK(gShellCmdCount == mCmds_c + mBuiltins_c);
+    CheckTable();
+
+    /* shell_init() frees a grown table */
+    shell_init("$ ");
+    CHECK(0 == mBuffersInUse);
+    CHECK(gpCmdTable == maShellCmdTable);
+    CHECK(mBuiltins_c == gShellCmdCount);
+    printf("  %u commands registered in random order, sorted and found, every prefix run checked\n",
+           (unsigned)mCmds_c);
+}
+
+static void TestDispatch(void)
+{
+    InitShell(mCmds_c);
+
+    mCalls = 0;
+    Type("led_set 1 2\r");
+    CHECK(1 == mCalls);
+    CHECK(!strcmp(mLastCmd, "led_set"));
+    CHECK(3 == mLastArgc);
+    CHECK(NULL != strstr(maOutput, "$ "));
+
+    Type("  uart_write   a\r");
+    CHECK(2 == mCalls);
+    CHECK(!strcmp(mLastCmd, "uart_write"));
+    CHECK(2 == mLastArgc);
+
+    Type("led_se\r");
+    CHECK(2 == mCalls);
+    CHECK(NULL != strstr(maOutput, "Unknown command 'led_se'"));
+
+    /* Past maxargs the usage and help are printed instead */
+    Type("wdt_stop 1 2 3 4\r");
+    CHECK(2 == mCalls);
+    CHECK(NULL != strstr(maOutput, "Usage:\r\nwdt_stop - test command"));
+    CHECK(NULL != strstr(maOutput, "wdt_stop help of wdt_stop"));
+
+    Type("help ota_read\r");
+    CHECK(NULL != strstr(maOutput, "ota_read - help of ota_read"));
+    Type("help ota_rea\r");
+    CHECK(NULL != strstr(maOutput, "- No command available."));
+
+    /* "help" lists the commands in order */
+    Type("help\r");
+    CHECK(strstr(maOutput, "ble_cal ") < strstr(maOutput, "ble_clear "));
+    CHECK(strstr(maOutput, "version ") < strstr(maOutput, "wdt_cal "));
+    Type("version\r");
+    CHECK(NULL != strstr(maOutput, "SHELL TEST v1.0"));
+    printf("  dispatch, usage errors, help and version from typed lines\n");
+}
+
+static void TestAutoComplete(void)
+{
+    InitShell(mCmds_c);
+
+    /* One match: completed with a trailing space, then run */
+    mCalls = 0;
+    Type("led_sto\t");
+    CHECK(!strcmp(mCmdBuf, "led_stop "));
+    CHECK(9 == mCmdLen);
+    Type("1\r");
+    CHECK(1 == mCalls);
+    CHECK(!strcmp(mLastCmd, "led_stop"));
+    CHECK(2 == mLastArgc);
+
+    /* A common prefix is completed, with a beep */
+    Type("nvm_er\t");
+    CHECK(!strcmp(mCmdBuf, "nvm_erase"));
+    CHECK(NULL != strstr(maOutput, "ase\a"));
+    Type("\x03");
+
+    /* Several matches are listed, the line is kept */
+    Type("led_s\t");
+    CHECK(!strcmp(mCmdBuf, "led_s"));
+    CHECK(NULL != strstr(maOutput, "  led_scan led_set led_show led_start led_stats led_stop\n\r$ led_s"));
+    Type("\x03");
+
+    /* Past eight matches the list ends with "...", wrapped at 78 columns */
+    Type("ifc\t");
+    CHECK(!strcmp(mCmdBuf, "ifc"));
+    CHECK(NULL != strstr(maOutput, "  ifconfig_cal ifconfig_clear ifconfig_config ifconfig_disable ifconfig_dump\n\r"
+                                   "  ifconfig_enable ifconfig_erase ifconfig_erase_all ...\n\r$ ifc"));
+    Type("\x03");
+
+    Type("xyz\t");
+    CHECK(NULL != strstr(maOutput, "\a"));
+    Type("\x03");
+
+    /* The help arguments complete on the command names */
+    Type("help ota_wr\t");
+    CHECK(!strcmp(mCmdBuf, "help ota_write "));
+    Type("\r");
+    CHECK(NULL != strstr(maOutput, "ota_write - help of ota_write"));
+    printf("  TAB completion: single match, common prefix, match list, help arguments\n");
+}
+
+/* Time per operation against the linear scan of the former table */
+static void Benchmark(void)
+{
+    static const uint32_t sizes[] = { 25, 100, 300, mCmds_c };
+    static char line[mCmds_c][40];
+    static char tab[mCmds_c][24];
+    uint32_t s, i, rep, n, reps;
+    uint16_t count;
+    uint32_t sum;
+    uint64_t t;
+    uint32_t ns[6];
+
+    printf("  commands   lookup   linear   prefix   linear   dispatch   TAB\n");
+    for( s = 0; s < NumberOfElements(sizes); s++ )
+    {
+        n = sizes[s];
+        reps = 200000 / n;
+        InitShell(n);
+        sum = 0;
+
+        t = NowNs();
+        for( rep = 0; rep < reps; rep++ )
+        {
+            for( i = 0; i < n; i++ )
+            {
+                sum += (NULL != shell_find_command(maOrder[i]->name));
+            }
+        }
+        ns[0] = (uint32_t)((NowNs() - t) / (reps * n));
+
+        t = NowNs();
+        for( rep = 0; rep < reps; rep++ )
+        {
+            for( i = 0; i < n; i++ )
+            {
+                sum += (NULL != LinearFind(maOrder[i]->name, n));
+            }
+        }
+        ns[1] = (uint32_t)((NowNs() - t) / (reps * n));
+        CHECK(sum == 2 * reps * n);
+
+        /* The first three letters of each name, as typed before a TAB */
+        for( i = 0; i < n; i++ )
+        {
+            memcpy(tab[i], maOrder[i]->name, 3);
+            tab[i][3] = '\0';
+        }
+
+        sum = 0;
+        t = NowNs();
+        for( rep = 0; rep < reps; rep++ )
+        {
+            for( i = 0; i < n; i++ )
+            {
+                shell_find_prefix(tab[i], &count);
+                sum += count;
+            }
+        }
+        ns[2] = (uint32_t)((NowNs() - t) / (reps * n));
+
+        t = NowNs();
+        for( rep = 0; rep < reps; rep++ )
+        {
+            for( i = 0; i < n; i++ )
+            {
+                sum -= LinearPrefix(tab[i], n);
+            }
+        }
+        ns[3] = (uint32_t)((NowNs() - t) / (reps * n));
+        CHECK(0 == sum);
+
+        /* Whole typed lines, through make_argv, the history and the prompt */
+        for( i = 0; i < n; i++ )
+        {
+            sprintf(line[i], "%s 1 2\r", maOrder[i]->name);
+        }
+        mCalls = 0;
+        t = NowNs();
+        for( i = 0; i < n * 20; i++ )
+        {
+            Type(line[i % n]);
+        }
+        ns[4] = (uint32_t)((NowNs() - t) / (n * 20));
+        CHECK(n * 20 == mCalls);
+
+        for( i = 0; i < n; i++ )
+        {
+            sprintf(tab[i], "%.*s\t\x03", (int)strlen(maOrder[i]->name) - 1, maOrder[i]->name);
+        }
+        t = NowNs();
+        for( i = 0; i < n * 20; i++ )
+        {
+            Type(tab[i % n]);
+        }
+        ns[5] = (uint32_t)((NowNs() - t) / (n * 20));
+
+        printf("  %8u %6u ns %6u ns %6u ns %6u ns %8u ns %5u ns\n", (unsigned)n + mBuiltins_c, (unsigned)ns[0],
+               (unsigned)ns[1], (unsigned)ns[2], (unsigned)ns[3], (unsigned)ns[4], (unsigned)ns[5]);
+    }
+    shell_init("$ ");
+}
+
+int main(void)
+{
+    srand(1);
+    MakeCommands();
+    TestRegistry();
+    TestDispatch();
+    TestAutoComplete();
+    Benchmark();
+    CHECK(0 == mBuffersInUse);
+    printf("Shell: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,9 @@
+/* Host build stub: buffers come from the C heap and are counted, so the test
+   sees the command table buffers freed */
+#ifndef _MEM_MANAGER_H_
+#define _MEM_MANAGER_H_
+#include "EmbeddedTypes.h"
+
+void *MEM_BufferAlloc(uint32_t numBytes);
+uint8_t MEM_BufferFree(void *buffer);
+#endif
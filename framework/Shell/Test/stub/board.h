@@ -0,0 +1,7 @@
+/* Host build stub: the shell console is a UART */
+#ifndef _BOARD_H_
+#define _BOARD_H_
+#define APP_SERIAL_INTERFACE_TYPE       (gSerialMgrUart_c)
+#define APP_SERIAL_INTERFACE_INSTANCE   (0)
+#define APP_SERIAL_INTERFACE_SPEED      (115200)
+#endif
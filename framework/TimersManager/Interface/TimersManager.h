@@ -585,6 +585,16 @@ void TMR_MakeTMRThreadReady
  void   
 );
 
+/*! -------------------------------------------------------------------------
+ * \brief      This function is called by the Low Power module each time the
+ *             MCU wakes up from a mode where the timestamp timer is stopped.
+ * \param[in]  sleepDurationUs - time spent in that mode, in microseconds
+ *---------------------------------------------------------------------------*/
+void TMR_SyncTimestamp
+(
+    uint32_t sleepDurationUs
+);
+
 /*! -------------------------------------------------------------------------
  * \brief     Convert milliseconds to ticks
  * \param[in] milliseconds
@@ -671,10 +681,11 @@ uint64_t TMR_GetTimestamp(void);
 #define TMR_NotCountedTicksBeforeSleep()    0
 #define TMR_SyncLpmTimers(sleepDurationTmrTicks)
 #define TMR_MakeTMRThreadReady()
+#define TMR_SyncTimestamp(sleepDurationUs)
 #define TmrTicksFromMilliseconds(milliseconds)      0
 #define TMR_GetTimerFreq()                          0
 #define TMR_GetRemainingTime(tmrID)                 0
-#define TMR_GetFirstExpireTime                      0xFFFFFFFF
+#define TMR_GetFirstExpireTime(timerType)           0xFFFFFFFF
 #define TMR_AllocateMinuteTimer()     TMR_AllocateTimer()
 #define TMR_AllocateSecondTimer()     TMR_AllocateTimer()
 #define TMR_FreeMinuteTimer(timerID)  TMR_FreeTimer(timerID)
@@ -240,6 +240,11 @@ OSA_TASK_DEFINE( TMR_Task, gTmrTaskPriority_c, 1, gTmrTaskStackSize_c, FALSE );
  */
 static osaEventId_t        mTimerThreadEventId;
 #endif
+
+/*
+ * \brief Time in microseconds spent in low power modes where the timestamp timer is stopped
+ */
+static volatile uint64_t mTmrTimestampSleepUs;
 #endif /*gTMR_Enabled_d*/
 
 
@@ -1193,6 +1198,21 @@ void TMR_MakeTMRThreadReady
 #endif /* #if (gTMR_EnableLowPowerTimers_d) */
 }
 
+/*! -------------------------------------------------------------------------
+ * \brief      This function is called by the Low Power module each time the
+ *             MCU wakes up from a mode where the timestamp timer is stopped.
+ * \param[in]  sleepDurationUs - time spent in that mode, in microseconds
+ *---------------------------------------------------------------------------*/
+void TMR_SyncTimestamp
+(
+    uint32_t sleepDurationUs
+)
+{
+    TmrIntDisableAll();
+    mTmrTimestampSleepUs += sleepDurationUs;
+    TmrIntRestoreAll();
+}
+
 /*! -------------------------------------------------------------------------
  * \brief Get the frequency in Hz of the TMR counter
  *---------------------------------------------------------------------------*/
@@ -1223,7 +1243,14 @@ void TMR_TimeStampInit(void)
 uint64_t TMR_GetTimestamp(void)
 {
 #if gTMR_PIT_Timestamp_Enabled_d
-    return TMR_PITGetTimestamp();
+    uint64_t timestamp;
+
+    /* The 64-bit sleep time takes two loads, and must not change between the PIT read and its own */
+    TmrIntDisableAll();
+    timestamp = TMR_PITGetTimestamp() + mTmrTimestampSleepUs;
+    TmrIntRestoreAll();
+
+    return timestamp;
 #else
     return TMR_RTCGetTimestamp();
 #endif
@@ -37,7 +37,8 @@ ISR_CALLBACK_ENTRY(ISR_GPIO_INT0, 0, 43)
 #if defined(FRDM_K82F)
 ISR_CALLBACK_ENTRY(ISR_INT_PORTC, 0, 10) /* PTC10  */
 #endif
-#if defined(FRDM_K64F)
+/* the Rapid IoT projects also define FRDM_K64F */
+#if defined(FRDM_K64F) && !defined(RAPID_IOT)
 ISR_CALLBACK_ENTRY(ISR_INT_PORTA, 0, 2) /* PTA2  */
 #endif
 #if defined(RAPID_IOT)
@@ -128,4 +128,17 @@ void HAL_ISR_RegisterCallback(ISR_SOURCE_T source, ISR_MODE_T mode, ISR_HANDLER_
  */
 BOOL HAL_ISR_SleepWithTimeout(ISR_SOURCE_T source, uint32_t timeout_ms);
 
+/**
+ * \brief handle an interrupt of the specified source
+ *
+ * This function is called from the port interrupt handler that owns the
+ * pin of the source. It disables the source, calls the registered callback
+ * and wakes the task waiting in HAL_ISR_SleepWithTimeout.
+ *
+ * \param	source 	source that triggered
+ *
+ * \return	       	none
+ */
+void HAL_ISR_Handler(ISR_SOURCE_T source);
+
 #endif /* _HAL_ISR_DRIVER_H_ */
@@ -13,7 +13,6 @@ Include Files
 #include <stdint.h>
 
 #include "TAG_Access.h"
-#include "Test_Functions.h"
 #include "pin_mux.h"
 #include "peripherals.h"
 #include "board.h"
@@ -24,7 +23,6 @@ Include Files
 #include "HAL_ISR_driver.h"
 #include "nfc_device.h"
 #include "ntag_bridge.h"
-#include "jsmn.h"
 //#include "thread_attributes.h"
 
 #include "ndef_message.h"
@@ -33,184 +31,815 @@ Private Macro
 ==================================================================================================*/
 #define NTAG_I2C_BLOCK		(23)
 #define NTAG_I2C_BLOCK_SIZE	0x10
-#define MAX_TOKEN	        (30)
+#define NTAG_USR_MEM_SIZE	(NTAG_I2C_BLOCK * NTAG_I2C_BLOCK_SIZE)
 #define MIN_VAL(a,b)		((a) < (b) ? (a) : (b))
 
+/* TLV and record constants of the NFC Forum Type 2 tag */
+#define TLV_NULL		(0x00)
+#define TLV_NDEF		(0x03)
+#define TLV_TERMINATOR		(0xFE)
+#define TLV_LONG_LENGTH		(0xFF)
+#define TLV_SHORT_MAX		(0xFE)
+#define TLV_LONG_MAX		(0xFFFE)
+#define NDEF_FLAG_MB		(0x80)
+#define NDEF_FLAG_ME		(0x40)
+#define NDEF_FLAG_SR		(0x10)
+#define NDEF_FLAG_IL		(0x08)
+#define NDEF_TNF_MASK		(0x07)
+#define NDEF_TNF_WELL_KNOWN	(0x01)
+#define NDEF_SHORT_MAX		(0xFF)
+#define NDEF_LONG_MAX		(0xFFFF)
+#define NDEF_TEXT_UTF16		(0x80)
+#define NDEF_TEXT_LANG_MASK	(0x3F)
+#define NDEF_TEXT_HEADER_LEN	(7)	/* flags, type and payload lengths, 'T', status, "en" */
+
+/* Known configuration keys, lengths 2, 4 and 9 are distinct modulo 4 */
+#define TAG_KEY_SLOTS		(4)
+#define TAG_KEY_HASH(len)	((len) & (TAG_KEY_SLOTS - 1))
+#define TAG_KEY_MAX_LEN		(9)
+#define TAG_KEYS_ALL		((1U << kTagKeyNone) - 1U)
+#define TAG_VALUE_MAX_LEN	(EUI_SIZE - 1)
+#define TAG_MEMBERS_MAX_LEN	(96)	/* the three members, with values of TAG_VALUE_MAX_LEN characters at most */
+
+/*==================================================================================================
+Private type definitions
+==================================================================================================*/
+typedef enum TAG_KEY_E
+{
+	kTagKeyId = 0,
+	kTagKeyType,
+	kTagKeyActivetag,
+	kTagKeyNone
+}tag_key_e;
+
+/* Lazy reader over the user memory, a block is fetched over I2C when the cursor enters it */
+typedef struct TAG_CURSOR_T
+{
+	uint16_t pos;
+	uint16_t end;
+}tag_cursor_t;
+
+/* Where the configuration sits in the user memory, recorded by the parser so that the setters patch it in place */
+typedef struct TAG_LAYOUT_T
+{
+	bool     complete;			// the NDEF message was walked up to its last record
+	uint8_t  records;			// number of records walked
+	uint16_t lastRecord;			// offset of the header of the last record walked
+	uint16_t tlvLenPos;			// offset of the length of the NDEF TLV
+	uint8_t  tlvLenSize;			// 1, or 2 after the long form marker
+	uint16_t messageEnd;			// offset following the NDEF message
+	uint16_t payloadLenPos;			// offset of the payload length of the Text record
+	uint8_t  payloadLenSize;		// 1 for a short record, 4 otherwise
+	uint16_t objectEnd;			// offset of the closing brace of the JSON object
+	uint8_t  members;			// number of members of the JSON object
+	uint8_t  present;			// bit mask of the known keys in the object, valid value or not
+	uint16_t valuePos[kTagKeyNone];		// offset of the value of each key present, quotes excluded
+	uint16_t valueLen[kTagKeyNone];
+}tag_layout_t;
+
 /*==================================================================================================
 Private global variables declarations
 ==================================================================================================*/
-static uint8_t JString[NTAG_I2C_BLOCK * NFC_I2C_BLOCK_SIZE] = {0};      // buffer to store payload(json string) of NDEF msg
-uint8_t ntagUsrMemBuff[NTAG_I2C_BLOCK][NTAG_I2C_BLOCK_SIZE] = {{0}};    // buffer to store User Memory Blocks of NTAG
-static jsmntok_t	t[MAX_TOKEN];
-//static HAL_I2C_HANDLE_T *i2cHandleMaster;
-static NTAG_HANDLE_T      ntag_handle;
-static uint8_t          payLoadPosInNdef;
+uint8_t ntagUsrMemBuff[NTAG_I2C_BLOCK][NTAG_I2C_BLOCK_SIZE] = {{0}};    // tag user memory, valid up to ntagUsrMemBlocks
+static uint8_t          ntagUsrMemBlocks;	// number of blocks of ntagUsrMemBuff read from or written to the tag
+static NTAG_HANDLE_T    ntag_handle;
+static tag_config_t     tagConfig;
+static tag_layout_t     tagLayout;
+static bool             tagConfigValid;
+static uint8_t          tagConfigBlocks;	// number of blocks the cached configuration was parsed from
+static uint8_t          tagParseBlocks;		// number of blocks read by the parse in progress
+
+static const char *const tagKeyName[kTagKeyNone] = {"id", "type", "activetag"};
+static const uint8_t tagKeySlot[TAG_KEY_SLOTS] = {kTagKeyType, kTagKeyActivetag, kTagKeyId, kTagKeyNone};
 
 /*==================================================================================================
 Private prototypes
 ==================================================================================================*/
-static int jsoneq(const char *json, jsmntok_t *tok, const char *s);
-static int8_t GetParsedData(jsmntok_t t[]);
-static uint8_t GetValueOfKey(char *val, jsmntok_t *t, uint8_t totalKey);
-static void parse_ndef( uint8_t rxBuffer[], uint8_t msgBuffer[], uint16_t *msgBufferSize, uint8_t *payloadStartPos);
-static uint8_t writeNtagUserMemory(uint8_t *JString, uint16_t JStringLen, uint8_t usrMemAddrOffset);
-static ntag_status_e readNtagUserMemory(uint8_t *readMessagebuffer);
-static void WriteBuffer(uint8_t *dstBuff, uint8_t *srcBuff, uint8_t actualSize, uint8_t idleSize);
+static bool TagReadByte(tag_cursor_t *cur, uint8_t *byte);
+static bool TagSkip(tag_cursor_t *cur, uint16_t len);
+static bool TagFindMessage(tag_cursor_t *cur);
+static bool TagNextTextRecord(tag_cursor_t *cur, tag_cursor_t *text);
+static tag_key_e TagLookupKey(const char *key, uint8_t len);
+static bool TagReadString(tag_cursor_t *cur, char *str, uint8_t size, uint8_t *len);
+static bool TagReadScalar(tag_cursor_t *cur, uint8_t first, char *str, uint8_t size, uint8_t *len, uint8_t *next);
+static bool TagSkipValue(tag_cursor_t *cur, uint8_t first, uint8_t *next);
+static bool TagReadNonSpace(tag_cursor_t *cur, uint8_t *byte);
+static bool TagParseJson(tag_cursor_t *cur, tag_config_t *config);
+static uint8_t TagParse(void);
+static uint8_t TagLoadConfig(void);
+static bool TagReadAll(void);
+static uint16_t TagUsedSize(const uint8_t *image);
+static bool TagSplice(uint8_t *image, uint16_t *used, uint16_t pos, uint16_t oldLen, const uint8_t *data, uint16_t len);
+static bool TagAddLength(uint8_t *image, uint16_t pos, uint8_t size, int32_t delta, uint32_t max);
+static void TagValueText(const tag_config_t *config, uint8_t id, char *text);
+static uint8_t TagWriteImage(const uint8_t *image);
+static uint8_t TagStoreConfig(const tag_config_t *config, uint8_t keys);
+static uint8_t TagAppendConfig(const tag_config_t *config);
 
 /*==================================================================================================
 Private functions
 ==================================================================================================*/
-static void WriteBuffer(uint8_t *dstBuff, uint8_t *srcBuff, uint8_t actualSize, uint8_t idleSize)
+static bool TagReadByte(tag_cursor_t *cur, uint8_t *byte)
 {
-	uint8_t i = 0;
+	uint8_t block = cur->pos / NTAG_I2C_BLOCK_SIZE;
 
-	actualSize = MIN_VAL(actualSize, idleSize-1);	// idleSize-1 to put NULL at last byte
+	if (cur->pos >= cur->end)
+	{
+		return FALSE;
+	}
 
-	// Copy data into buffer
-    for (i = 0; i < actualSize; i++)
+	if (block >= ntagUsrMemBlocks)
 	{
-    	dstBuff[i] = srcBuff[i];
+		if (NTAG_OK != NTAG_ReadBlock(ntag_handle, NTAG_MEM_BLOCK_START_USER_MEMORY + block, &ntagUsrMemBuff[block][0], NTAG_I2C_BLOCK_SIZE))
+		{
+			return FALSE;
+		}
+		ntagUsrMemBlocks = block + 1;
+	}
+	if (block >= tagParseBlocks)
+	{
+		tagParseBlocks = block + 1;
 	}
 
-    // zero(NULL) rest of the buffer
-    for (i = actualSize; i < idleSize; i++)
-    {
-    	dstBuff[i] = 0;
-    }
+	*byte = ntagUsrMemBuff[block][cur->pos % NTAG_I2C_BLOCK_SIZE];
+	cur->pos++;
+	return TRUE;
 }
 
-static int jsoneq(const char *json, jsmntok_t *tok, const char *s) 
+static bool TagSkip(tag_cursor_t *cur, uint16_t len)
 {
-	if (tok->type == JSMN_STRING && (int) strlen(s) == tok->end - tok->start &&
-			strncmp(json + tok->start, s, tok->end - tok->start) == 0) 
-        {
-		return 0;
+	if (len > cur->end - cur->pos)
+	{
+		return FALSE;
 	}
-	return -1;
+
+	/* skipped blocks are never read */
+	cur->pos += len;
+	return TRUE;
 }
 
-static int8_t GetParsedData(jsmntok_t t[])
+/* Walks the TLVs up to the NDEF TLV, the cursor is then bounded by the NDEF message */
+static bool TagFindMessage(tag_cursor_t *cur)
 {
-	char msg[100];
-	//Read User space of I2C for data
-	if (NTAG_FAIL == readNtagUserMemory(JString))
+	uint8_t tlv, byte, lenSize;
+	uint16_t tlvLen, lenPos;
+
+	do
 	{
-		return NTAG_FAIL;
+		if (!TagReadByte(cur, &tlv) || TLV_TERMINATOR == tlv)
+		{
+			return FALSE;
+		}
+		if (TLV_NULL == tlv)
+		{
+			continue;
+		}
+		if (!TagReadByte(cur, &byte))
+		{
+			return FALSE;
+		}
+		lenPos = cur->pos - 1;
+		lenSize = 1;
+		tlvLen = byte;
+		if (TLV_LONG_LENGTH == byte)
+		{
+			lenPos = cur->pos;
+			lenSize = 2;
+			if (!TagReadByte(cur, &byte))
+			{
+				return FALSE;
+			}
+			tlvLen = byte << 8;
+			if (!TagReadByte(cur, &byte))
+			{
+				return FALSE;
+			}
+			tlvLen |= byte;
+		}
+		if (TLV_NDEF != tlv && !TagSkip(cur, tlvLen))
+		{
+			return FALSE;
+		}
+	} while (TLV_NDEF != tlv);
+
+	/* a TLV longer than the user memory is truncated */
+	if (tlvLen > cur->end - cur->pos)
+	{
+		return FALSE;
 	}
+	cur->end = cur->pos + tlvLen;
+
+	tagLayout.tlvLenPos = lenPos;
+	tagLayout.tlvLenSize = lenSize;
+	tagLayout.messageEnd = cur->end;
+	tagLayout.complete = (0 == tlvLen);
+	return TRUE;
+}
 
-	//Parse JSON string
-	int r;
-	jsmn_parser p;
+/* Walks the records up to the next UTF-8 Well-Known Text record, text is then bounded by its text */
+static bool TagNextTextRecord(tag_cursor_t *cur, tag_cursor_t *text)
+{
+	uint8_t byte, flags, typeLen, idLen, lenSize, status;
+	uint16_t header, lenPos, payload;
+	uint32_t payloadLen;
 
-	jsmn_init(&p);	//init
-	r = jsmn_parse(&p, (const char *)JString, strlen((const char *)JString), t, MAX_TOKEN);	//parse
-  
-	/* Assume the top-level element is an object */
-	if (r < 1 || t[0].type != JSMN_OBJECT)
+	while (!tagLayout.complete)
 	{
-		sprintf(msg,"Object expected\r\n");
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-		return NTAG_FAIL;
+		header = cur->pos;
+		if (!TagReadByte(cur, &flags) || !TagReadByte(cur, &typeLen))
+		{
+			return FALSE;
+		}
+		lenPos = cur->pos;
+		lenSize = (flags & NDEF_FLAG_SR) ? 1 : 4;
+		payloadLen = 0;
+		for (idLen = lenSize; idLen; idLen--)
+		{
+			if (!TagReadByte(cur, &byte))
+			{
+				return FALSE;
+			}
+			payloadLen = (payloadLen << 8) | byte;
+		}
+		idLen = 0;
+		if ((flags & NDEF_FLAG_IL) && !TagReadByte(cur, &idLen))
+		{
+			return FALSE;
+		}
+
+		byte = 0;
+		if ((NDEF_TNF_WELL_KNOWN == (flags & NDEF_TNF_MASK)) && (1 == typeLen))
+		{
+			if (!TagReadByte(cur, &byte) || !TagSkip(cur, idLen))
+			{
+				return FALSE;
+			}
+		}
+		else if (!TagSkip(cur, typeLen + idLen))
+		{
+			return FALSE;
+		}
+		if (payloadLen > (uint32_t)(cur->end - cur->pos))
+		{
+			return FALSE;
+		}
+
+		tagLayout.lastRecord = header;
+		tagLayout.records++;
+		tagLayout.complete = (0 != (flags & NDEF_FLAG_ME));
+		payload = cur->pos;
+
+		if (('T' == byte) && (0 != payloadLen))
+		{
+			if (!TagReadByte(cur, &status))
+			{
+				return FALSE;
+			}
+			if (!(status & NDEF_TEXT_UTF16) && ((status & NDEF_TEXT_LANG_MASK) < payloadLen))
+			{
+				text->pos = payload + 1 + (status & NDEF_TEXT_LANG_MASK);
+				text->end = payload + payloadLen;
+				tagLayout.payloadLenPos = lenPos;
+				tagLayout.payloadLenSize = lenSize;
+				cur->pos = text->end;
+				return TRUE;
+			}
+			cur->pos = payload;
+		}
+
+		if (!TagSkip(cur, payloadLen))
+		{
+			return FALSE;
+		}
+	}
+
+	return FALSE;
+}
+
+static tag_key_e TagLookupKey(const char *key, uint8_t len)
+{
+	tag_key_e id = (tag_key_e)tagKeySlot[TAG_KEY_HASH(len)];
+
+	if ((kTagKeyNone != id) && (strlen(tagKeyName[id]) == len) && !memcmp(tagKeyName[id], key, len))
+	{
+		return id;
+	}
+
+	return kTagKeyNone;
+}
+
+static bool TagReadNonSpace(tag_cursor_t *cur, uint8_t *byte)
+{
+	do
+	{
+		if (!TagReadByte(cur, byte))
+		{
+			return FALSE;
+		}
+	} while ((' ' == *byte) || ('\t' == *byte) || ('\r' == *byte) || ('\n' == *byte));
+
+	return TRUE;
+}
+
+/* Reads a string after its opening quote, the characters beyond size-1 are dropped */
+static bool TagReadString(tag_cursor_t *cur, char *str, uint8_t size, uint8_t *len)
+{
+	uint8_t byte;
+
+	*len = 0;
+	while (TagReadByte(cur, &byte))
+	{
+		if ('"' == byte)
+		{
+			if (str)
+			{
+				str[MIN_VAL(*len, size - 1)] = '\0';
+			}
+			return TRUE;
+		}
+		if (('\\' == byte) && !TagReadByte(cur, &byte))
+		{
+			break;
+		}
+		if (str && (*len < size - 1))
+		{
+			str[*len] = byte;
+		}
+		if (*len < 0xFF)
+		{
+			(*len)++;
+		}
+	}
+
+	/* unterminated string */
+	return FALSE;
+}
+
+/* Reads a number or literal, next is the first byte after it */
+static bool TagReadScalar(tag_cursor_t *cur, uint8_t first, char *str, uint8_t size, uint8_t *len, uint8_t *next)
+{
+	uint8_t byte = first;
+
+	*len = 0;
+	do
+	{
+		if ((',' == byte) || ('}' == byte) || (']' == byte) || (' ' == byte) || ('\t' == byte) ||
+		    ('\r' == byte) || ('\n' == byte))
+		{
+			if (0 == *len)
+			{
+				return FALSE;
+			}
+			str[*len] = '\0';
+			*next = byte;
+			return TRUE;
+		}
+		if (('{' == byte) || ('[' == byte) || ('"' == byte) || ':' == byte || (*len >= size - 1))
+		{
+			return FALSE;
+		}
+		str[(*len)++] = byte;
+	} while (TagReadByte(cur, &byte));
+
+	return FALSE;
+}
+
+/* Skips a value of an unknown key, nested objects and arrays included */
+static bool TagSkipValue(tag_cursor_t *cur, uint8_t first, uint8_t *next)
+{
+	uint8_t depth = 0;
+	uint8_t byte = first;
+	uint8_t len;
+	char scalar[TAG_VALUE_MAX_LEN + 1];
+
+	if (('{' != byte) && ('[' != byte))
+	{
+		if ('"' == byte)
+		{
+			return TagReadString(cur, NULL, 0, &len) && TagReadNonSpace(cur, next);
+		}
+		return TagReadScalar(cur, byte, scalar, sizeof(scalar), &len, next);
+	}
+
+	do
+	{
+		if (('{' == byte) || ('[' == byte))
+		{
+			depth++;
+		}
+		else if (('}' == byte) || (']' == byte))
+		{
+			depth--;
+		}
+		else if (('"' == byte) && !TagReadString(cur, NULL, 0, &len))
+		{
+			return FALSE;
+		}
+	} while (depth && TagReadByte(cur, &byte));
+
+	return (0 == depth) && TagReadNonSpace(cur, next);
+}
+
+/* Single pass over the JSON object, the values of the known keys are stored in config and located in tagLayout */
+static bool TagParseJson(tag_cursor_t *cur, tag_config_t *config)
+{
+	char key[TAG_KEY_MAX_LEN + 1];
+	char value[TAG_VALUE_MAX_LEN + 1];
+	uint8_t byte, len, keyLen;
+	uint16_t pos;
+	tag_key_e id;
+
+	memset(config, 0, sizeof(*config));
+	tagLayout.members = 0;
+	tagLayout.present = 0;
+
+	if (!TagReadNonSpace(cur, &byte) || ('{' != byte) || !TagReadNonSpace(cur, &byte))
+	{
+		return FALSE;
+	}
+
+	while ('}' != byte)
+	{
+		if (('"' != byte) || !TagReadString(cur, key, sizeof(key), &keyLen) ||
+		    !TagReadNonSpace(cur, &byte) || (':' != byte) || !TagReadNonSpace(cur, &byte))
+		{
+			return FALSE;
+		}
+
+		id = (keyLen <= TAG_KEY_MAX_LEN) ? TagLookupKey(key, keyLen) : kTagKeyNone;
+		tagLayout.members++;
+
+		if (kTagKeyNone == id)
+		{
+			if (!TagSkipValue(cur, byte, &byte))
+			{
+				return FALSE;
+			}
+		}
+		else
+		{
+			if ('"' == byte)
+			{
+				pos = cur->pos;
+				if (!TagReadString(cur, value, sizeof(value), &len))
+				{
+					return FALSE;
+				}
+				tagLayout.valueLen[id] = cur->pos - 1 - pos;
+				if (!TagReadNonSpace(cur, &byte))
+				{
+					return FALSE;
+				}
+			}
+			else
+			{
+				pos = cur->pos - 1;
+				if (!TagReadScalar(cur, byte, value, sizeof(value), &len, &byte))
+				{
+					return FALSE;
+				}
+				tagLayout.valueLen[id] = cur->pos - 1 - pos;
+			}
+			tagLayout.valuePos[id] = pos;
+			tagLayout.present |= (1U << id);
+
+			if (((' ' == byte) || ('\t' == byte) || ('\r' == byte) || ('\n' == byte)) && !TagReadNonSpace(cur, &byte))
+			{
+				return FALSE;
+			}
+
+			if ((kTagKeyId == id) && (len >= TAG_VALUE_MAX_LEN))
+			{
+				memcpy(config->id, value, TAG_VALUE_MAX_LEN);
+				config->id[TAG_VALUE_MAX_LEN] = '\0';
+				config->keys |= (1U << kTagKeyId);
+			}
+			else if ((kTagKeyId != id) && (0 != len))
+			{
+				if (kTagKeyType == id)
+				{
+					config->type = value[0] - '0';
+				}
+				else
+				{
+					config->activetag = value[0] - '0';
+				}
+				config->keys |= (1U << id);
+			}
+		}
+
+		if (',' == byte)
+		{
+			if (!TagReadNonSpace(cur, &byte) || ('}' == byte))
+			{
+				return FALSE;
+			}
+		}
+		else if ('}' != byte)
+		{
+			return FALSE;
+		}
+	}
+
+	tagLayout.objectEnd = cur->pos - 1;
+	return TRUE;
+}
+
+/* Parses the user memory, the blocks not cached yet are fetched over I2C */
+static uint8_t TagParse(void)
+{
+	tag_cursor_t cur = {0, NTAG_USR_MEM_SIZE};
+	tag_cursor_t text;
+
+	memset(&tagLayout, 0, sizeof(tagLayout));
+	tagParseBlocks = 0;
+	tagConfigValid = FALSE;
+
+	if (TagFindMessage(&cur))
+	{
+		/* a Text record that is not a JSON object belongs to someone else */
+		while (TagNextTextRecord(&cur, &text))
+		{
+			if (TagParseJson(&text, &tagConfig))
+			{
+				tagConfigBlocks = tagParseBlocks;
+				tagConfigValid = TRUE;
+				return NTAG_SUCCESS;
+			}
+		}
 	}
 
 #if NTAG_DEBUG
-	shell_printf("Total Key: %d\r\n", r);
-#endif  //NTAG_DEBUG
+	shell_printf("NTAG configuration not found\r\n");
+#endif
+	return NTAG_FAIL;
+}
+
+/* Parses the tag once, later calls only check that the blocks it was parsed from were not written over RF */
+static uint8_t TagLoadConfig(void)
+{
+	uint8_t data[NTAG_I2C_BLOCK_SIZE];
+	uint8_t block;
 
-	return r;	//total key
+	for (block = 0; tagConfigValid && (block < tagConfigBlocks); block++)
+	{
+		if ((NTAG_OK != NTAG_ReadBlock(ntag_handle, NTAG_MEM_BLOCK_START_USER_MEMORY + block, data, NTAG_I2C_BLOCK_SIZE)) ||
+		    memcmp(data, ntagUsrMemBuff[block], NTAG_I2C_BLOCK_SIZE))
+		{
+			tagConfigValid = FALSE;
+		}
+	}
+
+	if (tagConfigValid)
+	{
+		/* the blocks that follow were not checked, they are read again when needed */
+		ntagUsrMemBlocks = tagConfigBlocks;
+		return NTAG_SUCCESS;
+	}
+
+	ntagUsrMemBlocks = 0;
+	return TagParse();
 }
 
-static uint8_t GetValueOfKey(char *val, jsmntok_t *t, uint8_t totalKey)
+/* Completes the cache up to the end of the user memory, before its content is moved */
+static bool TagReadAll(void)
 {
-	/* Loop over all keys of the root object */
-	uint8_t i;
-	for (i = 1; i < totalKey; i++)
+	for (; ntagUsrMemBlocks < NTAG_I2C_BLOCK; ntagUsrMemBlocks++)
 	{
-		if (jsoneq((const char *)JString, &t[i], val) == 0)
+		if (NTAG_OK != NTAG_ReadBlock(ntag_handle, NTAG_MEM_BLOCK_START_USER_MEMORY + ntagUsrMemBlocks,
+		                              &ntagUsrMemBuff[ntagUsrMemBlocks][0], NTAG_I2C_BLOCK_SIZE))
 		{
-			return i;
+			return FALSE;
 		}
 	}
 
-	return NTAG_FAIL;	//if key is not available in data
+	return TRUE;
 }
 
-/* NDEF Parser to parse JSON string*/
-static void parse_ndef( uint8_t rxBuffer[], uint8_t msgBuffer[], uint16_t *msgBufferSize, uint8_t *payloadStartPos)
+/* Offset following the last TLV of image, the NULL TLVs after it are free space */
+static uint16_t TagUsedSize(const uint8_t *image)
 {
-	uint8_t tnfPos;
-	uint8_t recordTypePos;
-	uint8_t textDataStartPos;
-	uint16_t payLoadLenght;
+	uint32_t pos = 0;
+	uint32_t used = 0;
+	uint16_t len;
+	uint8_t tlv;
 
-	if ( 0xFF == rxBuffer[1] )	//TLV length is more than 1 byte
+	while (pos < NTAG_USR_MEM_SIZE)
 	{
-		tnfPos = 4;
-		recordTypePos = 10;
-		payLoadLenght = (rxBuffer[8] * 256) + rxBuffer[9];
-		textDataStartPos = 14;
+		tlv = image[pos++];
+		if (TLV_TERMINATOR == tlv)
+		{
+			return pos;
+		}
+		if (TLV_NULL == tlv)
+		{
+			continue;
+		}
+		if (pos >= NTAG_USR_MEM_SIZE)
+		{
+			return NTAG_USR_MEM_SIZE;
+		}
+		len = image[pos++];
+		if (TLV_LONG_LENGTH == len)
+		{
+			if (pos + 2 > NTAG_USR_MEM_SIZE)
+			{
+				return NTAG_USR_MEM_SIZE;
+			}
+			len = (image[pos] << 8) | image[pos + 1];
+			pos += 2;
+		}
+		pos += len;
+		used = pos;
+	}
+
+	return (used > NTAG_USR_MEM_SIZE) ? NTAG_USR_MEM_SIZE : used;
+}
+
+/* Replaces oldLen bytes at pos by data, the TLVs that follow are moved and used is updated */
+static bool TagSplice(uint8_t *image, uint16_t *used, uint16_t pos, uint16_t oldLen, const uint8_t *data, uint16_t len)
+{
+	if ((pos + oldLen > *used) || (*used - oldLen + len > NTAG_USR_MEM_SIZE))
+	{
+		return FALSE;
+	}
+
+	memmove(&image[pos + len], &image[pos + oldLen], *used - pos - oldLen);
+	if (len < oldLen)
+	{
+		memset(&image[*used - (oldLen - len)], 0, oldLen - len);
+	}
+	memcpy(&image[pos], data, len);
+	*used = *used - oldLen + len;
+
+	return TRUE;
+}
+
+/* Adds delta to the big endian length of size bytes at pos */
+static bool TagAddLength(uint8_t *image, uint16_t pos, uint8_t size, int32_t delta, uint32_t max)
+{
+	int32_t len = 0;
+	uint8_t i;
+
+	for (i = 0; i < size; i++)
+	{
+		len = (len << 8) | image[pos + i];
+	}
+	len += delta;
+	if ((len < 0) || ((uint32_t)len > max))
+	{
+		return FALSE;
+	}
+	for (i = size; i; i--)
+	{
+		image[pos + i - 1] = (uint8_t)len;
+		len >>= 8;
+	}
+
+	return TRUE;
+}
+
+static void TagValueText(const tag_config_t *config, uint8_t id, char *text)
+{
+	if (kTagKeyId == id)
+	{
+		memcpy(text, config->id, TAG_VALUE_MAX_LEN);
+		text[TAG_VALUE_MAX_LEN] = '\0';
 	}
 	else
 	{
-		tnfPos = 2;
-		recordTypePos = 5;
-		payLoadLenght = rxBuffer[4];
-		textDataStartPos = 9;
+		sprintf(text, "%u", (kTagKeyType == id) ? config->type : config->activetag);
 	}
+}
 
-	uint8_t tnf = rxBuffer[tnfPos] & 0x07 ;
+/* Writes the blocks of image that differ from the tag, then parses the result */
+static uint8_t TagWriteImage(const uint8_t *image)
+{
+	uint8_t block;
 
-	if (tnf == 0x01) //well know type
+	for (block = 0; block < NTAG_I2C_BLOCK; block++)
 	{
-		if(rxBuffer[recordTypePos] == 'T') //text Record
+		if (!memcmp(&image[block * NTAG_I2C_BLOCK_SIZE], ntagUsrMemBuff[block], NTAG_I2C_BLOCK_SIZE))
 		{
-			*msgBufferSize = payLoadLenght-3;
-			memcpy(msgBuffer, rxBuffer+textDataStartPos, *msgBufferSize);
-                        *payloadStartPos = textDataStartPos;
+			continue;
 		}
+		if (NTAG_OK != NFC_WriteBlock(ntag_handle, NTAG_MEM_BLOCK_START_USER_MEMORY + block, &image[block * NTAG_I2C_BLOCK_SIZE], NTAG_I2C_BLOCK_SIZE))
+		{
+			InvalidateConfigTag();
+			return NTAG_FAIL;
+		}
+		memcpy(ntagUsrMemBuff[block], &image[block * NTAG_I2C_BLOCK_SIZE], NTAG_I2C_BLOCK_SIZE);
 	}
+
+	return TagParse();
 }
 
-static uint8_t writeNtagUserMemory(uint8_t *JString, uint16_t JStringLen, uint8_t usrMemAddrOffset)
+/* Patches the values of keys in the JSON text of the tag, the other members, records and TLVs are kept */
+static uint8_t TagStoreConfig(const tag_config_t *config, uint8_t keys)
 {
-		char msg[100];
-        if(!JString)
-        {
-            return NTAG_FAIL;
-        }
-  
-	if (NTAG_OK != NFC_WriteBytes(ntag_handle, NFC_MEM_ADDR_START_USER_MEMORY + usrMemAddrOffset, JString, JStringLen))
+	static uint8_t image[NTAG_USR_MEM_SIZE];
+	char values[kTagKeyNone][TAG_VALUE_MAX_LEN + 1];
+	char members[TAG_MEMBERS_MAX_LEN];
+	uint16_t used, membersLen = 0;
+	int32_t delta;
+	uint8_t id, next, mask, count = tagLayout.members;
+
+	if (!TagReadAll())
 	{
-		sprintf(msg,"Failed to write status\r\n");
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
 		return NTAG_FAIL;
 	}
+	memcpy(image, ntagUsrMemBuff, sizeof(image));
+	used = TagUsedSize(image);
+	delta = -(int32_t)used;
 
-	return NTAG_SUCCESS;
+	for (id = 0; id < kTagKeyNone; id++)
+	{
+		TagValueText(config, id, values[id]);
+	}
+
+	/* the keys missing from the object become new members before its closing brace */
+	for (id = 0; id < kTagKeyNone; id++)
+	{
+		if ((keys & (1U << id)) && !(tagLayout.present & (1U << id)))
+		{
+			membersLen += sprintf(&members[membersLen], "%s\"%s\":\"%s\"", count++ ? "," : "", tagKeyName[id], values[id]);
+		}
+	}
+	if (!TagSplice(image, &used, tagLayout.objectEnd, 0, (const uint8_t *)members, membersLen))
+	{
+		return NTAG_FAIL;
+	}
+
+	/* the values present are replaced from the last one, the offsets of the others stay valid */
+	for (mask = keys & tagLayout.present; mask; mask &= ~(1U << next))
+	{
+		next = kTagKeyNone;
+		for (id = 0; id < kTagKeyNone; id++)
+		{
+			if ((mask & (1U << id)) && ((kTagKeyNone == next) || (tagLayout.valuePos[id] > tagLayout.valuePos[next])))
+			{
+				next = id;
+			}
+		}
+		if (!TagSplice(image, &used, tagLayout.valuePos[next], tagLayout.valueLen[next], (const uint8_t *)values[next], strlen(values[next])))
+		{
+			return NTAG_FAIL;
+		}
+	}
+
+	delta += used;
+	if (!TagAddLength(image, tagLayout.tlvLenPos, tagLayout.tlvLenSize, delta, (1 == tagLayout.tlvLenSize) ? TLV_SHORT_MAX : TLV_LONG_MAX) ||
+	    !TagAddLength(image, tagLayout.payloadLenPos, tagLayout.payloadLenSize, delta, (1 == tagLayout.payloadLenSize) ? NDEF_SHORT_MAX : NDEF_LONG_MAX))
+	{
+		return NTAG_FAIL;
+	}
+
+	return TagWriteImage(image);
 }
 
-static ntag_status_e readNtagUserMemory(uint8_t *readMessagebuffer)
+/* Appends a Text record holding config to the NDEF message of a tag that has no configuration */
+static uint8_t TagAppendConfig(const tag_config_t *config)
 {
-	char msg[100];
-    uint16_t NDEFmessagelen=0;
+	static uint8_t image[NTAG_USR_MEM_SIZE];
+	char values[kTagKeyNone][TAG_VALUE_MAX_LEN + 1];
+	uint8_t record[NDEF_TEXT_HEADER_LEN + TAG_MEMBERS_MAX_LEN];
+	uint16_t used, len;
+	uint8_t id;
 
-    /* Read User Memory */
-    uint8_t current_block;
-    for (current_block = 1; current_block <= NTAG_I2C_BLOCK; current_block++)
-    {
-        if (NTAG_OK != NTAG_ReadBlock (ntag_handle, current_block, &ntagUsrMemBuff[(current_block - 1)][0], NTAG_I2C_BLOCK_SIZE))
-        {
-            sprintf(msg,"Failed to read block %u\r\n", current_block);
-    		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-            return NTAG_FAIL;
-        }
-    }
+	if (!tagLayout.complete || !TagReadAll())
+	{
+		return NTAG_FAIL;
+	}
 
-    parse_ndef(&ntagUsrMemBuff[0][0], readMessagebuffer, &NDEFmessagelen, &payLoadPosInNdef);       //Parse NDEF message
-	PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-    sprintf(msg,"payLoadPosInNdef: %d\r\n", payLoadPosInNdef);
+	for (id = 0; id < kTagKeyNone; id++)
+	{
+		TagValueText(config, id, values[id]);
+	}
+	len = sprintf((char *)&record[NDEF_TEXT_HEADER_LEN], "{\"id\":\"%s\",\"type\":\"%s\",\"activetag\":\"%s\"}",
+	              values[kTagKeyId], values[kTagKeyType], values[kTagKeyActivetag]);
+
+	record[0] = (tagLayout.records ? 0 : NDEF_FLAG_MB) | NDEF_FLAG_ME | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN;
+	record[1] = 1;
+	record[2] = len + 3;
+	record[3] = 'T';
+	record[4] = 2;
+	record[5] = 'e';
+	record[6] = 'n';
+	len += NDEF_TEXT_HEADER_LEN;
+
+	memcpy(image, ntagUsrMemBuff, sizeof(image));
+	used = TagUsedSize(image);
+	if (tagLayout.records)
+	{
+		image[tagLayout.lastRecord] &= ~NDEF_FLAG_ME;
+	}
+	if (!TagSplice(image, &used, tagLayout.messageEnd, 0, record, len) ||
+	    !TagAddLength(image, tagLayout.tlvLenPos, tagLayout.tlvLenSize, len, (1 == tagLayout.tlvLenSize) ? TLV_SHORT_MAX : TLV_LONG_MAX))
+	{
+		return NTAG_FAIL;
+	}
 
-    return NTAG_SUCCESS;
+	return TagWriteImage(image);
 }
 
 /*==================================================================================================
@@ -247,194 +876,113 @@ Public functions
 //
 //}
 
-uint8_t  GetIdTag(uint8_t *id)
+uint8_t GetConfigTag(tag_config_t *config)
 {
-	if(!id)
+	if (!config || (NTAG_SUCCESS != TagLoadConfig()))
 	{
-           return NTAG_FAIL;
+		return NTAG_FAIL;
 	}
 
-	uint8_t retKeyPos = 0;
-	uint8_t totalKey = 0;
+	*config = tagConfig;
+	return NTAG_SUCCESS;
+}
 
-	if(!(totalKey = GetParsedData(t)))
-		return NTAG_FAIL;
+void InvalidateConfigTag(void)
+{
+	tagConfigValid = FALSE;
+	ntagUsrMemBlocks = 0;
+}
 
-	if(!(retKeyPos = GetValueOfKey("id", t, totalKey)))
-		return NTAG_FAIL;	//No Key
-        if(t[retKeyPos+1].end - t[retKeyPos+1].start < 16)
-            return NTAG_FAIL;           //No value                      
-        
-        WriteBuffer(id, JString + t[retKeyPos+1].start, t[retKeyPos+1].end - t[retKeyPos+1].start, EUI_SIZE);
+uint8_t GetIdTag(uint8_t *id)
+{
+	if (!id || (NTAG_SUCCESS != TagLoadConfig()) || !(tagConfig.keys & (1U << kTagKeyId)))
+	{
+		return NTAG_FAIL;
+	}
 
+	memcpy(id, tagConfig.id, EUI_SIZE);
 	return NTAG_SUCCESS;
 }
 
 uint8_t GetTypeTag(uint8_t *type)
 {
-	if(!type)
+	if (!type || (NTAG_SUCCESS != TagLoadConfig()) || !(tagConfig.keys & (1U << kTagKeyType)))
 	{
 		return NTAG_FAIL;
 	}
 
-	uint8_t retKeyPos = 0;
-	uint8_t totalKey = 0;
-
-	if(!(totalKey = GetParsedData(t)))
-		return NTAG_FAIL;
-
-	if(!(retKeyPos = GetValueOfKey("type", t, totalKey)))
-		return NTAG_FAIL;	//No Key
-        
-        if(t[retKeyPos+1].end - t[retKeyPos+1].start == 0)
-            return NTAG_FAIL;           //No Value                                 
-        
-	*type =	*(JString + t[retKeyPos+1].start) - 48;
-
+	*type = tagConfig.type;
 	return NTAG_SUCCESS;
 }
 
 uint8_t GetActiveTagValue(uint8_t *activetag)
 {
-	if(!activetag)
+	if (!activetag || (NTAG_SUCCESS != TagLoadConfig()) || !(tagConfig.keys & (1U << kTagKeyActivetag)))
 	{
 		return NTAG_FAIL;
 	}
 
-	uint8_t retKeyPos = 0;
-	uint8_t totalKey = 0;
-
-	if(!(totalKey = GetParsedData(t)))
-		return NTAG_FAIL;
-
-	if(!(retKeyPos = GetValueOfKey("activetag", t, totalKey)))
-		return NTAG_FAIL;	//No Key
-        if(t[retKeyPos+1].end - t[retKeyPos+1].start == 0)
-            return NTAG_FAIL;           //No Value
-        
-	*activetag =	*(JString + t[retKeyPos+1].start) - 48;
-
+	*activetag = tagConfig.activetag;
 	return NTAG_SUCCESS;
 }
 
 uint8_t SetIdTag(char *id)
 {
-	char msg[100];
-        if(!id)
-	{
-        sprintf(msg,"String is empty\n\r");
-        PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-		return NTAG_FAIL;
-	}
-       
-	uint8_t retKeyPos = 0;
-	uint8_t totalKey = 0;
+	tag_config_t config;
 
-	if(!(totalKey = GetParsedData(t)))
-		return NTAG_FAIL;
-               
-	if(!(retKeyPos = GetValueOfKey("id", t, totalKey)))
-		return NTAG_FAIL;	//No Key
-        
-        if(!memcmp((JString + t[retKeyPos+1].start),id, 16))
-          return NTAG_SUCCESS;
-         
-        //Modified new ID(EUI) 
-         memcpy((JString + t[retKeyPos+1].start),id, 16);
-
-        
-        //Write NDEF Header to I2C Tag
-	if(!writeNtagUserMemory(&ntagUsrMemBuff[0][0], payLoadPosInNdef, 0))
+	if (!id || (strlen(id) < TAG_VALUE_MAX_LEN) || (NTAG_SUCCESS != TagLoadConfig()))
 	{
 		return NTAG_FAIL;
 	}
-   
-	//Write modified data to I2C Tag
-	if(!writeNtagUserMemory(JString, strlen((char const *)JString), payLoadPosInNdef))
+
+	if (!memcmp(tagConfig.id, id, TAG_VALUE_MAX_LEN))
 	{
-		return NTAG_FAIL;
+		return NTAG_SUCCESS;
 	}
-	return NTAG_SUCCESS;
+
+	config = tagConfig;
+	memcpy(config.id, id, TAG_VALUE_MAX_LEN);
+	return TagStoreConfig(&config, 1U << kTagKeyId);
 }
 
 uint8_t SetTypeTag(uint8_t *type)
 {
-	if(!type)
-	{
-		return NTAG_FAIL;
-	}
-
-	uint8_t retKeyPos = 0;
-	uint8_t totalKey = 0;
-
-	if(!(totalKey = GetParsedData(t)))
-		return NTAG_FAIL;
-
-	if(!(retKeyPos = GetValueOfKey("type", t, totalKey)))
-		return NTAG_FAIL;	//No Key
+	tag_config_t config;
 
-        // Validate the tag has specified data or not
-        // If it has same data as user want then return as no need a write operation
-        if((JString + t[retKeyPos+1].start)[0] ==  (*type + 48)) {
-            return NTAG_SUCCESS;
-        }
-	(JString + t[retKeyPos+1].start)[0] = *type + 48;
-
-        //Write NDEF Header to I2C Tag
-	if(!writeNtagUserMemory(&ntagUsrMemBuff[0][0], payLoadPosInNdef, 0))
+	if (!type || (*type > 9) || (NTAG_SUCCESS != TagLoadConfig()))
 	{
 		return NTAG_FAIL;
 	}
-        
-	//Write modified data to I2C Tag
-	if(!writeNtagUserMemory(JString, strlen((char const *)JString), payLoadPosInNdef))
+
+	if ((tagConfig.keys & (1U << kTagKeyType)) && (tagConfig.type == *type))
 	{
-		return NTAG_FAIL;
+		return NTAG_SUCCESS;
 	}
 
-	return NTAG_SUCCESS;
+	config = tagConfig;
+	config.type = *type;
+	return TagStoreConfig(&config, 1U << kTagKeyType);
 }
 
 uint8_t SetActivetagTag(uint8_t *activetag)
 {
-	if(!activetag)        
-	{
-		return NTAG_FAIL;
-	}
+	tag_config_t config;
 
-	uint8_t retKeyPos = 0;
-	uint8_t totalKey = 0;
-
-	if(!(totalKey = GetParsedData(t)))
-		return NTAG_FAIL;
-
-	if(!(retKeyPos = GetValueOfKey("activetag", t, totalKey)))
-		return NTAG_FAIL;	//No Key
-
-        // Validate the tag has specified data or not
-        // If it has same data as user want then return as no need a write operation
-        if((JString + t[retKeyPos+1].start)[0] ==  (*activetag + 48)) 
-        {
-            return NTAG_SUCCESS;
-        }
-	(JString + t[retKeyPos+1].start)[0] = *activetag + 48;
-
-        //Write NDEF Header to I2C Tag
-	if(!writeNtagUserMemory(&ntagUsrMemBuff[0][0], payLoadPosInNdef, 0))
+	if (!activetag || (*activetag > 9) || (NTAG_SUCCESS != TagLoadConfig()))
 	{
 		return NTAG_FAIL;
 	}
-        
-	//Write modified data to I2C Tag
-	if(!writeNtagUserMemory(JString, strlen((char const *)JString), payLoadPosInNdef))
+
+	if ((tagConfig.keys & (1U << kTagKeyActivetag)) && (tagConfig.activetag == *activetag))
 	{
-		return NTAG_FAIL;
+		return NTAG_SUCCESS;
 	}
 
-	return NTAG_SUCCESS;
+	config = tagConfig;
+	config.activetag = *activetag;
+	return TagStoreConfig(&config, 1U << kTagKeyActivetag);
 }
 
-
 void factory_reset_Tag()
     {
     uint8_t page = 8;
@@ -456,247 +1004,40 @@ void factory_reset_Tag()
     
     }
 
-uint8_t WriteTag()
-{
-    uint8_t eui[8],state = 0, eui_value[8];
-    char id_string[18]={0};
-    char buf[128] = {0};
-    char msg[128];
-    uint32_t attrLength;
-    uint8_t status,i,j;
-    mfg_t mfg;
-    uint8_t strlength;
-    uint8_t totalKey = 0;
-    uint8_t empty=0;
-    uint8_t retKeyPos = 0;
-    uint8_t JString1[NTAG_I2C_BLOCK * NFC_I2C_BLOCK_SIZE] = {0}; 
-    char data1[] = "{\"id\":\"0000000000000000\",\"type\":\"0\",\"activetag\":\"0\"}" ;
-    uint8_t eui1[18];
-    char str[] = ",\"activetag\":\"1\"";
-    uint8_t len = 0;
- 
-    memset(eui_value,0,sizeof(eui_value));
-  
-//    THR_GetAttr(0,gNwkAttrId_IeeeAddr_c, 0, &(attrLength), eui_value); 	// [VF] To be replaced by other function
-//    NWKU_SwapArrayBytes((uint8_t*)&eui_value, 8);						// [VF] To be replaced by other function
-
-
-    // VF: Temp values only for test
-    attrLength = 8; // [VF] 64 bit eui = 8 bytest ???
-    eui_value[0] = 0x00;
-    eui_value[1] = 0x60;
-    eui_value[2] = 0x37;
-    eui_value[3] = 0x00;
-    eui_value[4] = 0x00;
-    eui_value[5] = 0x0E;
-    eui_value[6] = 0x22;
-    eui_value[7] = 0xC4;
-    
-    for(i = 0,j=0; i < attrLength ; i++,j++) 
-    {
-        sprintf(&id_string[j++],"%02x",eui_value[i]);       
-    }
-    id_string[j] = '\0';        //Contains ID read from Thread Stack
-    
-    sprintf(buf,"{\"id\":\"%s\",\"type\":\"2\",\"activetag\":\"1\"}",id_string); 
-    
-    len = strlen(buf)+3;                //todo check why i need to add 3 bytes.
-    sprintf(msg,"[Generated Tag]: %s, length: %d\n\r",buf,strlen((char *)buf));
-	PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-    
-    totalKey = GetParsedData(t);
-	PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-    sprintf(msg,"[Read Tag]: %s, length: %d\n\r",(char *)(JString),strlen((char*)buf));
-    //Check if no key found then rewrite complete string contained in buf.
-    if(!totalKey) 
-    {
-         empty = 1;
-    }
-    else
-    {
-      char     nfcrx_id[17];
-      uint8_t  type = 0xff;
-      uint8_t  activetag = 0xff;
-      
-      if(NTAG_SUCCESS == GetIdTag((uint8_t *)nfcrx_id))
-      {
-          if(memcmp(nfcrx_id,id_string,16))
-          {
-              SetIdTag(id_string);           //Write Tag with actual value;
-          } 
-      }
-      else
-      {
-          empty = 1;       
-      }
-
-      if(!empty)
-      {
-          if(NTAG_SUCCESS == GetTypeTag(&type))
-          {
-              if(type != 2)
-              {                    
-                  type = 2;
-                  SetTypeTag(&type);          //Write value Tag;
-              }
-          }
-          else
-          {
-            empty = 1;                    //Set the flag to write it from scratch      
-          }
-      }
-      if(!empty)
-      {
-          if(NTAG_SUCCESS == GetActiveTagValue(&activetag))
-          {
-              if(activetag != 1)
-              {                    
-                  activetag = 1;
-                  SetActivetagTag(&activetag);
-              }         
-          }
-          else
-          {
-             
-             //Add this Tag
-             strlength = strlen((char *)JString);
-             strcpy((char *)(JString+(strlength-1)),(const char *)str);
-             strcpy((char *)(JString+(strlen((char *)JString))),(const char *)"}");
-             sprintf(msg,"After Add ActiveTAG Jstring = %s\n",JString);
-             PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-             
-             factory_reset_Tag();
-             
-             char ntagheader[] = {0x03,0x00,0xD1,0x01,
-                                0x00,0x54,0x02,0x65,
-				0x6E};
-
-              strlength = strlen((char *)JString);
-
-              /* Write Zero to the previous data of string */
-              if(!writeNtagUserMemory((uint8_t *)ntagheader, 9, 0)) 
-              {
-                  sprintf(msg,"failed to write header\n\r");
-                  PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-                  return NTAG_FAIL;
-              }
-              if(!writeNtagUserMemory((uint8_t *)JString, strlen((char const *)JString), payLoadPosInNdef)) 
-              {
-                 sprintf(msg,"faild to write on a tag");
-                 PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-                 return NTAG_FAIL;
-              }
-              
-              strlength = strlen((char *)JString);
-	
-              uint8_t end_byte = 0xFE;
-              // Write 0xFE which is indicate last byte of message
-              if(!writeNtagUserMemory(&end_byte, 1 , strlen((char *)JString)+9))
-              {
-                 sprintf(msg,"faild to write on a tag");
-                 PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-                 return NTAG_FAIL;
-              }
-
-              uint8_t length_field = strlength+7;
-              uint8_t payload_length = strlength+3;
-              if(!writeNtagUserMemory(&length_field, 1, 1)) 
-              {
-                 sprintf(msg,"Failed to write length field\n\r");
-                 PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-                 return NTAG_FAIL;
-              }
-              if(!writeNtagUserMemory(&payload_length, 1, 4)) 
-              {
-                 sprintf(msg,"Failed to write payloadpos\n\r");
-                 PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-                 return NTAG_FAIL;
-              }
-
-              if(NTAG_FAIL != (GetParsedData(t))) 
-              {
-                 return NTAG_SUCCESS;
-              }
-              else 
-              {
-                return NTAG_FAIL;
-              }
-          }
-       }
-    }
-    
-    
-    if(empty)
-    {
-      sprintf(msg,"Writing Default Jstring\n\r");
-      PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-      
-      factory_reset_Tag();
-      
-      char ntagheader[] = {0x03,0x00,0xD1,0x01,
-                            0x00,0x54,0x02,0x65,
-                            0x6E};
-      
-      //Write NDEF header to I2C tag
-      if(!writeNtagUserMemory((uint8_t *)ntagheader, 9, 0)) 
-      {
-        sprintf(msg,"failed to write\n\r");
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-        return NTAG_FAIL;
-      }
-      
-      memcpy(JString, buf,strlen((char const *)buf));
-      strlength = strlen((char *)JString);
-      
-      payLoadPosInNdef = (0==payLoadPosInNdef)?9:payLoadPosInNdef;
-      
-      //Write actual data
-      if(!writeNtagUserMemory((uint8_t *)JString, strlength, payLoadPosInNdef)) 
-      {
-        sprintf(msg,"faild to write Default Tag");
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-        return NTAG_FAIL;
-      }
-      
-      // Write 0xFE which is indicate last byte of message
-      uint8_t end_byte = 0xFE;
-      if(!writeNtagUserMemory(&end_byte, 1 , strlength + 9))
-      {
-        sprintf(msg,"faild to write End Byte");
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-        return NTAG_FAIL;
-      }
-      
-      uint8_t length_field = strlength+7;
-      uint8_t payload_length = strlength+3;
-      
-      sprintf(msg,"length_field %d, payload_length:%d\n",length_field,payload_length);
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-      if(!writeNtagUserMemory(&length_field, 1, 1))
-      {
-        sprintf(msg,"Failed to write length field\n\r");
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-        return NTAG_FAIL;
-      }
-      if(!writeNtagUserMemory(&payload_length, 1, 4))
-      {
-        sprintf(msg,"Failed to write payloadpos\n\r");
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-        return NTAG_FAIL;
-      }
-      
-      if(NTAG_FAIL != (GetParsedData(t)))
-      {
-        sprintf(msg,"[Jstring]  :%s  len:%d\n\r",totalKey,(char *)(JString),strlen((char *)JString));
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-        return NTAG_SUCCESS;
-      }
-      else
-      {
-        sprintf(msg,"Failed to Parse NTAG Data After Default write\n\r");
-		PrintUart(TERMINAL_UART, (uint8_t *)msg, strlen(msg));
-        return NTAG_FAIL;
-      }
-    } 
-    return NTAG_SUCCESS;  
+uint8_t WriteTag(uint8_t* MAC_Add)
+{
+	/* [VF] placeholder EUI until the Thread stack provides it */
+	static const uint8_t defaultEui[8] = {0x00, 0x60, 0x37, 0x00, 0x00, 0x0E, 0x22, 0xC4};
+	const uint8_t *eui = MAC_Add ? MAC_Add : defaultEui;
+	tag_config_t config;
+	uint8_t i;
+
+	memset(&config, 0, sizeof(config));
+	for (i = 0; i < 8; i++)
+	{
+		sprintf((char *)&config.id[2 * i], "%02x", eui[i]);
+	}
+	config.type = 2;
+	config.activetag = 1;
+
+	if ((NTAG_SUCCESS != TagLoadConfig()) && !tagLayout.complete)
+	{
+		/* no NDEF message to add the configuration to, restore the default memory layout first */
+		factory_reset_Tag();
+		InvalidateConfigTag();
+		(void)TagLoadConfig();
+	}
+
+	if (!tagConfigValid)
+	{
+		return TagAppendConfig(&config);
+	}
+
+	if ((TAG_KEYS_ALL == tagConfig.keys) && !memcmp(tagConfig.id, config.id, TAG_VALUE_MAX_LEN) &&
+	    (tagConfig.type == config.type) && (tagConfig.activetag == config.activetag))
+	{
+		return NTAG_SUCCESS;
+	}
+
+	return TagStoreConfig(&config, TAG_KEYS_ALL);
 }
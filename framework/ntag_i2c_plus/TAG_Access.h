@@ -63,6 +63,14 @@ typedef struct INSTALL_T
 	uint8_t state;
 }install_t;
 
+typedef struct TAG_CONFIG_T
+{
+	uint8_t id[EUI_SIZE];				// 16 hex digit EUI, null terminated
+	uint8_t type;					// device type
+	uint8_t activetag;				// tag enable
+	uint8_t keys;					// bit mask of the keys found on the tag, 0 id, 1 type, 2 activetag
+}tag_config_t;
+
 
 
 /*==================================================================================================
@@ -132,7 +140,73 @@ uint8_t SetStateTag(uint8_t *state);
 uint8_t SetEuiTag(char *eui);
 
 ///
-///	Write EUI of the device to the NTAG
+///	Get the configuration stored on the tag as JSON in an NDEF Text record.
+///	The tag is parsed once, later calls only re-read the blocks it was parsed from to catch RF writes
+///	\param[out]	config	structure to fill
+///
+///	\return NTAG_SUCCESS/NTAG_FAIL
+///
+uint8_t GetConfigTag(tag_config_t *config);
+
+///
+///	Drop the cached configuration, to be called when the tag was written over I2C by another module
+///
+void InvalidateConfigTag(void);
+
+///
+///	Get the id stored on the tag
+///	\param[out]	id	buffer of EUI_SIZE bytes
+///
+///	\return NTAG_SUCCESS/NTAG_FAIL
+///
+uint8_t GetIdTag(uint8_t *id);
+
+///
+///	Get the device type stored on the tag
+///	\param[out]	type	device type
+///
+///	\return NTAG_SUCCESS/NTAG_FAIL
+///
+uint8_t GetTypeTag(uint8_t *type);
+
+///
+///	Get the activetag value stored on the tag
+///	\param[out]	activetag	tag enable
+///
+///	\return NTAG_SUCCESS/NTAG_FAIL
+///
+uint8_t GetActiveTagValue(uint8_t *activetag);
+
+///
+///	Set the id in place in the JSON text, the other members, records and TLVs are kept.
+///	Only the changed blocks of the tag are written
+///	\param[in]	id	16 hex digit EUI
+///
+///	\return NTAG_SUCCESS/NTAG_FAIL
+///
+uint8_t SetIdTag(char *id);
+
+///
+///	Set the device type in place in the JSON text, the other members, records and TLVs are kept.
+///	Only the changed blocks of the tag are written
+///	\param[in]	type	device type, 0 to 9
+///
+///	\return NTAG_SUCCESS/NTAG_FAIL
+///
+uint8_t SetTypeTag(uint8_t *type);
+
+///
+///	Set the activetag value in place in the JSON text, the other members, records and TLVs are kept.
+///	Only the changed blocks of the tag are written
+///	\param[in]	activetag	tag enable, 0 to 9
+///
+///	\return NTAG_SUCCESS/NTAG_FAIL
+///
+uint8_t SetActivetagTag(uint8_t *activetag);
+
+///
+///	Write EUI of the device to the NTAG, a Text record is appended to the NDEF message if there is no configuration yet
+///	\param[in]	MAC_Add	8 byte EUI-64, NULL for the default one
 ///
 ///	\return NTAG_SUCCESS/NTAG_FAIL
 ///
@@ -97,7 +97,7 @@ BOOL HAL_ISR_SleepWithTimeout(ISR_SOURCE_T source, uint32_t timeout_ms)
         /* start waiting for interrupt */
         enableInterrupt(callback->channel);
 
-        ISR_WAIT_FOR_INTERRUPT();
+        ISR_WAIT_FOR_INTERRUPT_TIMEOUT((size_t)source, until - current);
 
         /* disable interrupt during check */
         disableInterrupt(callback->channel);
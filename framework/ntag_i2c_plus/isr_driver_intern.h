@@ -86,5 +86,6 @@ extern ISR_CALLBACK_T isr_callback_list[];
 void disableInterrupt(uint32_t channel);
 void enableInterrupt(uint32_t channel);
 void setupMode(void *port, uint32_t pin, ISR_MODE_T mode);
+void waitForInterrupt(uint32_t source, uint32_t timeout_ms);
 
 #endif /* _ISR_DRIVER_INTERN_H_ */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2016, NXP Semiconductor
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of NXP Semiconductor nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/***********************************************************************/
+/* INCLUDES                                                            */
+/***********************************************************************/
+#include "fsl_port.h"
+#include "isr_driver_intern.h"
+#if defined(FSL_RTOS_FREE_RTOS)
+#include "fsl_os_abstraction.h"
+#endif
+#if defined(RAPID_IOT)
+#include "port_interrupts.h"
+#endif
+/***********************************************************************/
+/* DEFINES                                                             */
+/***********************************************************************/
+/***********************************************************************/
+/* GLOBAL VARIABLES                                                    */
+/***********************************************************************/
+#if defined(FSL_RTOS_FREE_RTOS)
+/* posted by HAL_ISR_Handler, the waiting task blocks on it */
+static osaSemaphoreId_t isr_semaphore_list[ISR_MAX_CALLBACKS];
+#endif
+
+/***********************************************************************/
+/* LOCAL FUNCTION PROTOTYPES                                           */
+/***********************************************************************/
+static ISR_CALLBACK_T *getCallback(uint32_t channel);
+
+/***********************************************************************/
+/* GLOBAL FUNCTIONS                                                    */
+/***********************************************************************/
+void HAL_ISR_Init(void)
+{
+    size_t i;
+
+    for (i = 0; i < ISR_MAX_CALLBACKS; i++)
+    {
+        PORT_SetPinMux(EXT_INT_FD_PORT, isr_callback_list[i].pin_func, kPORT_MuxAsGpio);
+        PORT_SetPinInterruptConfig(EXT_INT_FD_PORT, isr_callback_list[i].pin_func, kPORT_InterruptOrDMADisabled);
+#if defined(FSL_RTOS_FREE_RTOS)
+        if (NULL == isr_semaphore_list[i])
+            isr_semaphore_list[i] = OSA_SemaphoreCreate(0);
+#endif
+#if !defined(RAPID_IOT)
+        /* on Rapid IoT the port IRQ is shared and owned by port_interrupts.c */
+        NVIC_EnableIRQ(GPIO_PININT_NVIC(isr_callback_list[i].channel));
+#endif
+    }
+}
+
+void HAL_ISR_Handler(ISR_SOURCE_T source)
+{
+    SELECT_CALLBACK((size_t)source);
+
+    /* level modes would retrigger until the NTAG releases the pin */
+    DISABLE_INTERRUPT();
+    CHECK_VALID_AND_CALL_HANDLER();
+    WAKEUP_TASKS();
+
+#if defined(FSL_RTOS_FREE_RTOS)
+    if (NULL != isr_semaphore_list[(size_t)source])
+        (void)OSA_SemaphorePost(isr_semaphore_list[(size_t)source]);
+#endif
+}
+
+#if defined(RAPID_IOT)
+void BOARD_NTAG_FD_IRQ_HANDLER(void)
+{
+    HAL_ISR_Handler(ISR_INT_PORTA);
+}
+#endif
+
+void disableInterrupt(uint32_t channel)
+{
+    ISR_CALLBACK_T *callback = getCallback(channel);
+
+    if (callback)
+        PORT_SetPinInterruptConfig(EXT_INT_FD_PORT, callback->pin_func, kPORT_InterruptOrDMADisabled);
+}
+
+void enableInterrupt(uint32_t channel)
+{
+    ISR_CALLBACK_T *callback = getCallback(channel);
+
+    /* a source that already fired stays disabled until it is waited on again */
+    if (callback && ISR_SEMAPHORE_IS_TAKEN(callback->sema))
+        setupMode(EXT_INT_FD_PORT, callback->pin_func, callback->mode);
+}
+
+void setupMode(void *port, uint32_t pin, ISR_MODE_T mode)
+{
+    port_interrupt_t config;
+
+    switch (mode)
+    {
+        case ISR_EDGE_RISE:
+            config = kPORT_InterruptRisingEdge;
+            break;
+        case ISR_EDGE_FALL:
+            config = kPORT_InterruptFallingEdge;
+            break;
+        case ISR_LEVEL_HI:
+            config = kPORT_InterruptLogicOne;
+            break;
+        case ISR_LEVEL_LO:
+            config = kPORT_InterruptLogicZero;
+            break;
+        default:
+            config = kPORT_InterruptOrDMADisabled;
+            break;
+    }
+
+    PORT_SetPinInterruptConfig((PORT_Type *)port, pin, config);
+}
+
+#if defined(FSL_RTOS_FREE_RTOS)
+void waitForInterrupt(uint32_t source, uint32_t timeout_ms)
+{
+    if (NULL == isr_semaphore_list[source])
+        isr_semaphore_list[source] = OSA_SemaphoreCreate(0);
+
+    /* a stale post only ends this wait early, the caller checks the callback state */
+    (void)OSA_SemaphoreWait(isr_semaphore_list[source], timeout_ms);
+}
+#endif
+
+/***********************************************************************/
+/* LOCAL FUNCTIONS                                                     */
+/***********************************************************************/
+static ISR_CALLBACK_T *getCallback(uint32_t channel)
+{
+    size_t i;
+
+    for (i = 0; i < ISR_MAX_CALLBACKS; i++)
+    {
+        if (isr_callback_list[i].channel == channel)
+            return &isr_callback_list[i];
+    }
+
+    return NULL;
+}
+
+/***********************************************************************/
+/* INTERUPT SERVICE ROUTINES                                           */
+/***********************************************************************/
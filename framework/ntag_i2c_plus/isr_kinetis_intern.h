@@ -49,7 +49,8 @@
 #define EXT_INT_FD_PORT PORTC
 #define EXT_INT_FD_PIN 10U
 #endif /* FRDM_K82F */
-#if defined(FRDM_K64F)
+/* the Rapid IoT projects also define FRDM_K64F */
+#if defined(FRDM_K64F) && !defined(RAPID_IOT)
 #define GPIO_PININT_NVIC(channel) ((IRQn_Type)(PORTA_IRQn + channel))
 #define EXT_INT_FD_GPIO GPIOA
 #define EXT_INT_FD_PORT PORTA
@@ -124,6 +125,13 @@
 
 #define ISR_WAIT_FOR_INTERRUPT() __WFI();
 
+#if defined(FSL_RTOS_FREE_RTOS)
+/* block the calling task until HAL_ISR_Handler runs or the timeout expires */
+#define ISR_WAIT_FOR_INTERRUPT_TIMEOUT(source, timeout_ms) waitForInterrupt(source, timeout_ms);
+#else
+#define ISR_WAIT_FOR_INTERRUPT_TIMEOUT(source, timeout_ms) ISR_WAIT_FOR_INTERRUPT()
+#endif
+
 /***********************************************************************/
 /* TYPES                                                               */
 /***********************************************************************/
@@ -31,6 +31,7 @@
 /***********************************************************************/
 /* INCLUDES                                                            */
 /***********************************************************************/
+#include <string.h>
 #include "HAL_I2C_driver.h"
 #include "HAL_timer_driver.h"
 #include "ntag_bridge.h"
@@ -56,7 +57,6 @@ BOOL NTAG_WaitForEvent(NTAG_HANDLE_T ntag, NTAG_EVENT_T event, uint32_t timeout_
     uint8_t reg = 0;
     uint8_t reg_mask = 0;
     size_t i = 0;
-    uint32_t loop;
 
     switch (event)
     {
@@ -154,10 +154,7 @@ BOOL NTAG_WaitForEvent(NTAG_HANDLE_T ntag, NTAG_EVENT_T event, uint32_t timeout_
         case NTAG_EVENT_NDEF_DATA_READ_POLLED:
             for (/* */; i < timeout_ms && !(reg & reg_mask); i++)
             {
-//                HAL_Timer_delay_ms(1);
-            	for (loop = 0; loop < 1 * 8000U; loop++) {	// [VF] 1ms wait with Clock = 24MHz
-            		__NOP();
-            	}
+                HAL_Timer_delay_ms(1);
                 NTAG_ReadRegister(ntag, NTAG_MEM_OFFSET_NS_REG, &reg);
             }
             return !(reg & reg_mask);
@@ -167,10 +164,7 @@ BOOL NTAG_WaitForEvent(NTAG_HANDLE_T ntag, NTAG_EVENT_T event, uint32_t timeout_
         case NTAG_EVENT_RF_READ_SRAM_POLLED:
             for (/* */; i < timeout_ms && (reg & reg_mask); i++)
             {
-//                HAL_Timer_delay_ms(1);
-				for (loop = 0; loop < 1 * 8000U; loop++) {	// [VF] 1ms wait with Clock = 24MHz
-					__NOP();
-				}
+                HAL_Timer_delay_ms(1);
                 NTAG_ReadRegister(ntag, NTAG_MEM_OFFSET_NS_REG, &reg);
             }
             return (reg & reg_mask);
@@ -182,6 +176,77 @@ BOOL NTAG_WaitForEvent(NTAG_HANDLE_T ntag, NTAG_EVENT_T event, uint32_t timeout_
     return TRUE;
 }
 
+//---------------------------------------------------------------------
+BOOL NTAG_PthruStream(NTAG_HANDLE_T ntag, NTAG_TRANSFER_DIR_T dir, NTAG_PTHRU_CB_T cb, void *arg, uint32_t timeout_ms)
+{
+    /* one buffer is on the I2C bus while the callback works on the other */
+    uint8_t buffer[2][NTAG_MEM_SRAM_SIZE];
+    uint8_t current = 0;
+    uint16_t len = 0;
+    BOOL err;
+
+    if (NULL == cb)
+        return TRUE;
+
+    if (I2C_TO_RF == dir)
+    {
+        /* the first chunk is ready before the reader is signalled */
+        len = cb(buffer[current], NTAG_MEM_SRAM_SIZE, arg);
+        if (0 == len)
+            return FALSE;
+    }
+
+#ifdef HAVE_NTAG_INTERRUPT
+    /* FD goes low on data written by RF or read by RF, high once I2C handled the SRAM */
+    err = NTAG_SetFDOffFunction(ntag, I2C_LAST_DATA_READ_OR_WRITTEN_OR_RF_SWITCHED_OFF_11b) ||
+          NTAG_SetFDOnFunction(ntag, DATA_READY_BY_I2C_OR_DATA_READ_BY_RF_11b);
+#else
+    err = FALSE;
+#endif
+    err = err || NTAG_SetTransferDir(ntag, dir) || NTAG_SetPthruOnOff(ntag, TRUE);
+
+    while (!err)
+    {
+        if (I2C_TO_RF == dir)
+        {
+            /* the last SRAM block written hands the SRAM over to RF */
+            if (len < NTAG_MEM_SRAM_SIZE)
+                memset(&buffer[current][len], 0, NTAG_MEM_SRAM_SIZE - len);
+
+            err = NTAG_WriteBytes(ntag, NTAG_MEM_ADDR_START_SRAM, buffer[current], NTAG_MEM_SRAM_SIZE);
+            if (err)
+                break;
+
+            /* fill the next chunk while the reader fetches this one */
+            current ^= 1;
+            len = cb(buffer[current], NTAG_MEM_SRAM_SIZE, arg);
+
+            err = NTAG_WaitForEvent(ntag, NTAG_PTHRU_EVENT_RF_READ_SRAM, timeout_ms, FALSE);
+            if (0 == len)
+                break;
+        }
+        else
+        {
+            err = NTAG_WaitForEvent(ntag, NTAG_PTHRU_EVENT_RF_WROTE_SRAM, timeout_ms, FALSE);
+            if (err)
+                break;
+
+            /* reading the last SRAM block hands the SRAM back to RF */
+            err = NTAG_ReadBytes(ntag, NTAG_MEM_ADDR_START_SRAM, buffer[current], NTAG_MEM_SRAM_SIZE);
+            if (err)
+                break;
+
+            /* the writer fills the SRAM again while the chunk is consumed */
+            len = cb(buffer[current], NTAG_MEM_SRAM_SIZE, arg);
+            current ^= 1;
+            if (0 == len)
+                break;
+        }
+    }
+
+    return err;
+}
+
 //---------------------------------------------------------------------
 BOOL NTAG_SetI2CRstOnOff(NTAG_HANDLE_T ntag, BOOL on)
 {
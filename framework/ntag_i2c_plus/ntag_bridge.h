@@ -43,6 +43,13 @@
 /***********************************************************************/
 /* DEFINES                                                             */
 /***********************************************************************/
+#ifdef HAVE_NTAG_INTERRUPT
+#define NTAG_PTHRU_EVENT_RF_WROTE_SRAM NTAG_EVENT_RF_WROTE_SRAM_INTERRUPT
+#define NTAG_PTHRU_EVENT_RF_READ_SRAM NTAG_EVENT_RF_READ_SRAM_INTERRUPT
+#else
+#define NTAG_PTHRU_EVENT_RF_WROTE_SRAM NTAG_EVENT_RF_WROTE_SRAM_POLLED
+#define NTAG_PTHRU_EVENT_RF_READ_SRAM NTAG_EVENT_RF_READ_SRAM_POLLED
+#endif
 
 /***********************************************************************/
 /* TYPES                                                               */
@@ -90,6 +97,15 @@ typedef enum
     NTAG_EVENT_RF_READ_SRAM_POLLED
 } NTAG_EVENT_T;
 
+/**
+ * \brief pass-through stream callback
+ *
+ * Called with one SRAM sized chunk. When sending (I2C_TO_RF) it fills chunk and
+ * returns the number of bytes written, when receiving (RF_TO_I2C) it consumes the
+ * len bytes of chunk. Returning 0 ends the stream.
+ */
+typedef uint16_t (*NTAG_PTHRU_CB_T)(uint8_t *chunk, uint16_t len, void *arg);
+
 /***********************************************************************/
 /* GLOBAL VARIABLES                                                    */
 /***********************************************************************/
@@ -119,6 +135,25 @@ typedef enum
  */
 BOOL NTAG_WaitForEvent(NTAG_HANDLE_T ntag, NTAG_EVENT_T event, uint32_t timeout_ms, BOOL set_fd_pin_function);
 
+/**
+ * \brief stream data through the SRAM in pass-through mode
+ *
+ *	Enables the pass-through mode in the selected direction and moves 64 byte
+ *	chunks between the callback and the SRAM until the callback returns 0.
+ *	Two chunk buffers are used, so the callback prepares or consumes one chunk
+ *	while the NFC device transfers the other. With HAVE_NTAG_INTERRUPT the
+ *	handshakes wait on the FD pin, the FD functions are set accordingly.
+ *
+ * \param	ntag      	handle to identify the NTAG device instance
+ * \param	dir       	I2C_TO_RF to send, RF_TO_I2C to receive
+ * \param	cb        	callback producing or consuming the chunks
+ * \param	arg       	argument passed to the callback
+ * \param	timeout_ms	timeout of each SRAM handshake in ms
+ *
+ * \return			TRUE on failure or timeout
+ */
+BOOL NTAG_PthruStream(NTAG_HANDLE_T ntag, NTAG_TRANSFER_DIR_T dir, NTAG_PTHRU_CB_T cb, void *arg, uint32_t timeout_ms);
+
 /**
  * \brief enable/disable the I2C_RST
  *
@@ -34,7 +34,8 @@
 #if defined(FRDM_K82F)
 NTAG_DEVICE_ENTRY(NTAG0, 0x55, ISR_INT_PORTC)
 #endif
-#if defined(FRDM_K64F)
+/* the Rapid IoT projects also define FRDM_K64F */
+#if defined(FRDM_K64F) && !defined(RAPID_IOT)
 NTAG_DEVICE_ENTRY(NTAG0, 0x55, ISR_INT_PORTA)
 #endif
 #if defined(RAPID_IOT)
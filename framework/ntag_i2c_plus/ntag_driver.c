@@ -328,7 +328,6 @@ BOOL NTAG_WriteBlock(NTAG_HANDLE_T ntag, uint8_t block, const uint8_t *bytes, ui
     uint8_t ns_reg = 0;
     uint32_t timeout = NTAG_MAX_WRITE_DELAY_MS / 5 + 1;
     size_t i = 0;
-    uint32_t loop;
 
     ntag->tx_buffer[TX_START] = block;
 
@@ -356,10 +355,7 @@ BOOL NTAG_WriteBlock(NTAG_HANDLE_T ntag, uint8_t block, const uint8_t *bytes, ui
     /* wait for completion */
     do
     {
-//        HAL_Timer_delay_ms(5);
-    	for (loop = 0; loop < 5 * 8000U; loop++) {	// [VF] 5ms wait with Clock = 24MHz
-    		__NOP();
-    	}
+        HAL_Timer_delay_ms(5);
         if (NTAG_ReadRegister(ntag, NTAG_MEM_OFFSET_NS_REG, &ns_reg))
             break;
         timeout--;
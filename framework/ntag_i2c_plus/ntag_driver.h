@@ -105,6 +105,7 @@ typedef enum
 /* GLOBAL FUNCTION PROTOTYPES                                          */
 /***********************************************************************/
 BOOL NTAG_ReadBlock(NTAG_HANDLE_T ntag, uint8_t block, uint8_t *bytes, uint8_t len); // [VF]
+BOOL NTAG_WriteBlock(NTAG_HANDLE_T ntag, uint8_t block, const uint8_t *bytes, uint8_t len); // [VF]
 
 
 /**
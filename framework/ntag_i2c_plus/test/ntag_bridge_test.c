@@ -0,0 +1,371 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file ntag_bridge_test.c
+ * Host test for the NTAG SRAM pass-through stream. The driver and bridge sources are built
+ * in with a simulated NTAG I2C plus (memory blocks, NC/NS session registers, FD pin) and an
+ * RF reader that moves the SRAM content whenever the tag hands the SRAM over to it.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ntag_driver.c"
+#include "../ntag_bridge.c"
+
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+/*****************************************************************************
+ * Simulated tag and reader
+ ****************************************************************************/
+#define SRAM_LAST_BLOCK     (NTAG_MEM_BLOCK_START_SRAM + NTAG_MEM_SRAM_BLOCKS - 1U)
+#define FD_FUNCTIONS_11B    (NTAG_NC_REG_MASK_FD_OFF | NTAG_NC_REG_MASK_FD_ON)
+#define READER_BUFFER_SIZE  (4096U)
+
+static uint8_t sMem[256][NTAG_I2C_BLOCK_SIZE];
+static uint8_t sNc;
+static uint8_t sBlock;
+static uint8_t sRegister;
+static bool sRegisterSelected;
+static bool sRfOwnsSram;
+
+static bool sReaderPresent;
+static uint8_t sReaderIn[READER_BUFFER_SIZE];
+static uint32_t sReaderInLen;
+static uint32_t sReaderInPos;
+static uint8_t sReaderOut[READER_BUFFER_SIZE];
+static uint32_t sReaderOutLen;
+
+static ISR_MODE_T sFdMode;
+static uint32_t sFdWaits;
+static uint32_t sNow;
+
+static bool PthruOn(void)
+{
+    return 0 != (sNc & NTAG_NC_REG_MASK_PTHRU_ON_OFF);
+}
+
+/* The reader handles the SRAM once the tag gave it away, then hands it back to I2C */
+static void ReaderStep(void)
+{
+    uint32_t n;
+
+    if (!sReaderPresent || !sRfOwnsSram)
+    {
+        return;
+    }
+
+    if (sNc & NTAG_NC_REG_MASK_TRANSFER_DIR)
+    {
+        if (sReaderInPos >= sReaderInLen)
+        {
+            return;
+        }
+        n = sReaderInLen - sReaderInPos;
+        n = (n > NTAG_MEM_SRAM_SIZE) ? NTAG_MEM_SRAM_SIZE : n;
+        memset(sMem[NTAG_MEM_BLOCK_START_SRAM], 0, NTAG_MEM_SRAM_SIZE);
+        memcpy(sMem[NTAG_MEM_BLOCK_START_SRAM], &sReaderIn[sReaderInPos], n);
+        sReaderInPos += n;
+    }
+    else
+    {
+        CHECK(sReaderOutLen + NTAG_MEM_SRAM_SIZE <= sizeof(sReaderOut));
+        memcpy(&sReaderOut[sReaderOutLen], sMem[NTAG_MEM_BLOCK_START_SRAM], NTAG_MEM_SRAM_SIZE);
+        sReaderOutLen += NTAG_MEM_SRAM_SIZE;
+    }
+    sRfOwnsSram = false;
+}
+
+/* FD_ON/FD_OFF 11b: the pin is low while the SRAM waits for I2C */
+static bool FdLow(void)
+{
+    return PthruOn() && (FD_FUNCTIONS_11B == (sNc & FD_FUNCTIONS_11B)) && !sRfOwnsSram;
+}
+
+static uint8_t NsRegister(void)
+{
+    uint8_t ns = NTAG_NS_REG_MASK_RF_FIELD_PRESENT;
+
+    ReaderStep();
+    if (PthruOn() && !sRfOwnsSram && (sNc & NTAG_NC_REG_MASK_TRANSFER_DIR))
+    {
+        ns |= NTAG_NS_REG_MASK_SRAM_I2C_READY;
+    }
+    if (PthruOn() && sRfOwnsSram && !(sNc & NTAG_NC_REG_MASK_TRANSFER_DIR))
+    {
+        ns |= NTAG_NS_REG_MASK_SRAM_RF_READY;
+    }
+    return ns;
+}
+
+int16_t TransmitPoll(I2C_Type *instance, uint8_t address, uint8_t *bytes, size_t len)
+{
+    (void)instance;
+    CHECK(0x55 == address);
+
+    sRegisterSelected = false;
+    if ((NTAG_MEM_BLOCK_SESSION_REGS == bytes[0]) && (2U == len))
+    {
+        sRegister = bytes[1];
+        sRegisterSelected = true;
+    }
+    else if ((NTAG_MEM_BLOCK_SESSION_REGS == bytes[0]) && (4U == len))
+    {
+        /* only the NC register is written by the stream */
+        CHECK(NTAG_MEM_OFFSET_NC_REG == bytes[1]);
+        sNc = (sNc & ~bytes[2]) | (bytes[3] & bytes[2]);
+
+        /* switching the pass-through hands the SRAM to the writer: RF when receiving */
+        if (bytes[2] & NTAG_NC_REG_MASK_PTHRU_ON_OFF)
+        {
+            sRfOwnsSram = PthruOn() && (sNc & NTAG_NC_REG_MASK_TRANSFER_DIR);
+        }
+    }
+    else if (1U == len)
+    {
+        sBlock = bytes[0];
+    }
+    else
+    {
+        CHECK(NTAG_I2C_BLOCK_SIZE + 1U == len);
+        memcpy(sMem[bytes[0]], &bytes[1], NTAG_I2C_BLOCK_SIZE);
+
+        /* writing the last SRAM block hands the SRAM over to RF */
+        if ((SRAM_LAST_BLOCK == bytes[0]) && PthruOn() && !(sNc & NTAG_NC_REG_MASK_TRANSFER_DIR))
+        {
+            sRfOwnsSram = true;
+        }
+    }
+    return HAL_I2C_OK;
+}
+
+int16_t ReceivePoll(I2C_Type *instance, uint8_t address, uint8_t *bytes, size_t len)
+{
+    (void)instance;
+    CHECK(0x55 == address);
+
+    if (sRegisterSelected)
+    {
+        CHECK(1U == len);
+        bytes[0] = (NTAG_MEM_OFFSET_NC_REG == sRegister) ? sNc : NsRegister();
+        return HAL_I2C_OK;
+    }
+
+    CHECK(NTAG_I2C_BLOCK_SIZE == len);
+    memcpy(bytes, sMem[sBlock], NTAG_I2C_BLOCK_SIZE);
+
+    /* reading the last SRAM block hands the SRAM back to RF */
+    if ((SRAM_LAST_BLOCK == sBlock) && PthruOn() && (sNc & NTAG_NC_REG_MASK_TRANSFER_DIR))
+    {
+        sRfOwnsSram = true;
+    }
+    return HAL_I2C_OK;
+}
+
+void HAL_ISR_RegisterCallback(ISR_SOURCE_T source, ISR_MODE_T mode, ISR_HANDLER_T handler, ISR_ARGUMENT_T arg)
+{
+    (void)source;
+    (void)handler;
+    (void)arg;
+    sFdMode = mode;
+}
+
+BOOL HAL_ISR_SleepWithTimeout(ISR_SOURCE_T source, uint32_t timeout_ms)
+{
+    (void)source;
+    sFdWaits++;
+
+    ReaderStep();
+    if (FdLow() == (ISR_LEVEL_LO == sFdMode))
+    {
+        return FALSE;
+    }
+    sNow += timeout_ms;
+    return TRUE;
+}
+
+void HAL_Timer_delay_ms(uint32_t ms)
+{
+    sNow += ms;
+}
+
+uint32_t HAL_Timer_getTime_ms(void)
+{
+    return sNow;
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define TIMEOUT_MS  (100U)
+
+typedef struct
+{
+    uint8_t data[READER_BUFFER_SIZE];
+    uint32_t len;
+    uint32_t pos;
+    uint32_t calls;
+    uint32_t overlapped;
+} stream_t;
+
+static NTAG_HANDLE_T sNtag;
+
+/* Fills the next chunk, counting the ones prepared while the reader holds the SRAM */
+static uint16_t Produce(uint8_t *chunk, uint16_t len, void *arg)
+{
+    stream_t *stream = (stream_t *)arg;
+    uint32_t n = stream->len - stream->pos;
+
+    n = (n > len) ? len : n;
+    memcpy(chunk, &stream->data[stream->pos], n);
+    stream->pos += n;
+    stream->calls++;
+    stream->overlapped += sRfOwnsSram ? 1U : 0U;
+    return (uint16_t)n;
+}
+
+/* Collects the chunks until the expected length arrived */
+static uint16_t Consume(uint8_t *chunk, uint16_t len, void *arg)
+{
+    stream_t *stream = (stream_t *)arg;
+
+    CHECK(stream->pos + len <= sizeof(stream->data));
+    memcpy(&stream->data[stream->pos], chunk, len);
+    stream->pos += len;
+    stream->calls++;
+    stream->overlapped += sRfOwnsSram ? 1U : 0U;
+    return (stream->pos < stream->len) ? len : 0U;
+}
+
+static void Reset(void)
+{
+    memset(sMem, 0, sizeof(sMem));
+    sNc = 0;
+    sRfOwnsSram = false;
+    sReaderPresent = true;
+    sReaderInLen = 0;
+    sReaderInPos = 0;
+    sReaderOutLen = 0;
+    sFdWaits = 0;
+    sNow = 0;
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* 1000 bytes to the reader: 16 chunks, each prepared while the previous one is read */
+static void TestSend(void)
+{
+    static stream_t stream;
+    uint32_t i;
+
+    Reset();
+    memset(&stream, 0, sizeof(stream));
+    stream.len = 1000;
+    for (i = 0; i < stream.len; i++)
+    {
+        stream.data[i] = (uint8_t)(i * 7U);
+    }
+
+    CHECK(!NTAG_PthruStream(sNtag, I2C_TO_RF, Produce, &stream, TIMEOUT_MS));
+
+    CHECK(16U * NTAG_MEM_SRAM_SIZE == sReaderOutLen);
+    CHECK(0 == memcmp(sReaderOut, stream.data, stream.len));
+    for (i = stream.len; i < sReaderOutLen; i++)
+    {
+        CHECK(0 == sReaderOut[i]);
+    }
+    CHECK(16U == sFdWaits);
+    CHECK(17U == stream.calls);
+    CHECK(16U == stream.overlapped);
+    CHECK(PthruOn() && !(sNc & NTAG_NC_REG_MASK_TRANSFER_DIR));
+    CHECK(FD_FUNCTIONS_11B == (sNc & FD_FUNCTIONS_11B));
+    CHECK(0U == sNow);
+}
+
+/* 700 bytes from the reader: 11 chunks, the last one padded */
+static void TestReceive(void)
+{
+    static stream_t stream;
+    uint32_t i;
+
+    Reset();
+    memset(&stream, 0, sizeof(stream));
+    stream.len = 700;
+    sReaderInLen = stream.len;
+    for (i = 0; i < sReaderInLen; i++)
+    {
+        sReaderIn[i] = (uint8_t)(i ^ 0x5AU);
+    }
+
+    CHECK(!NTAG_PthruStream(sNtag, RF_TO_I2C, Consume, &stream, TIMEOUT_MS));
+
+    CHECK(11U * NTAG_MEM_SRAM_SIZE == stream.pos);
+    CHECK(0 == memcmp(stream.data, sReaderIn, sReaderInLen));
+    CHECK(11U == sFdWaits);
+    CHECK(11U == stream.calls);
+    CHECK(11U == stream.overlapped);
+    CHECK(sReaderInPos == sReaderInLen);
+    CHECK(PthruOn() && (sNc & NTAG_NC_REG_MASK_TRANSFER_DIR));
+}
+
+/* A reader that never answers ends the stream with an error after one handshake */
+static void TestTimeout(void)
+{
+    static stream_t stream;
+
+    Reset();
+    memset(&stream, 0, sizeof(stream));
+    stream.len = 200;
+    sReaderPresent = false;
+    CHECK(NTAG_PthruStream(sNtag, RF_TO_I2C, Consume, &stream, TIMEOUT_MS));
+    CHECK(1U == sFdWaits);
+    CHECK(0U == stream.calls);
+    CHECK(TIMEOUT_MS == sNow);
+
+    Reset();
+    memset(&stream, 0, sizeof(stream));
+    stream.len = 200;
+    sReaderPresent = false;
+    CHECK(NTAG_PthruStream(sNtag, I2C_TO_RF, Produce, &stream, TIMEOUT_MS));
+    CHECK(1U == sFdWaits);
+    CHECK(0U == sReaderOutLen);
+    CHECK(TIMEOUT_MS == sNow);
+}
+
+/* Nothing to send or no callback: no handshake at all */
+static void TestNothing(void)
+{
+    static stream_t stream;
+
+    Reset();
+    memset(&stream, 0, sizeof(stream));
+    CHECK(!NTAG_PthruStream(sNtag, I2C_TO_RF, Produce, &stream, TIMEOUT_MS));
+    CHECK(1U == stream.calls);
+    CHECK(0U == sFdWaits);
+    CHECK(!PthruOn());
+
+    CHECK(NTAG_PthruStream(sNtag, RF_TO_I2C, NULL, NULL, TIMEOUT_MS));
+    CHECK(0U == sFdWaits);
+}
+
+int main(void)
+{
+    sNtag = NTAG_InitDevice(NTAG0, (I2C_Type *)&sMem);
+    CHECK(NTAG_INVALID_HANDLE != sNtag);
+
+    TestSend();
+    TestReceive();
+    TestTimeout();
+    TestNothing();
+
+    printf("ntag_bridge: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,5 @@
+/* Host test stub, the tag configuration code uses nothing from the board support */
+#ifndef _FSL_GPIO_H_
+#define _FSL_GPIO_H_
+
+#endif
@@ -0,0 +1,11 @@
+/* Host test stub of the I2C driver, only the types used by the NTAG I2C HAL */
+#ifndef _FSL_I2C_H_
+#define _FSL_I2C_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct _I2C_Type I2C_Type;
+typedef int clock_name_t;
+
+#endif
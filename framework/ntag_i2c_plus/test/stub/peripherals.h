@@ -0,0 +1,5 @@
+/* Host test stub, the tag configuration code uses nothing from the board support */
+#ifndef _PERIPHERALS_H_
+#define _PERIPHERALS_H_
+
+#endif
@@ -0,0 +1,5 @@
+/* Host test stub, the tag configuration code uses nothing from the board support */
+#ifndef _PIN_MUX_H_
+#define _PIN_MUX_H_
+
+#endif
@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file tag_access_test.c
+ * Host test for the tag configuration. The module source is built in over a simulated tag
+ * memory which counts the block reads and writes, so the test can check that the setters
+ * patch the JSON text in place and leave the other TLVs and records of the tag untouched.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../TAG_Access.c"
+
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+/*****************************************************************************
+ * Simulated tag
+ ****************************************************************************/
+#define USER_START      (NTAG_MEM_BLOCK_START_USER_MEMORY * NTAG_I2C_BLOCK_SIZE)
+
+static uint8_t sMem[64 * NTAG_I2C_BLOCK_SIZE];
+static uint32_t sReads;
+static uint32_t sWrites;
+static bool sWriteError;
+
+BOOL NTAG_ReadBlock(NTAG_HANDLE_T ntag, uint8_t block, uint8_t *bytes, uint8_t len)
+{
+    (void)ntag;
+    memcpy(bytes, &sMem[block * NTAG_I2C_BLOCK_SIZE], len);
+    sReads++;
+    return FALSE;
+}
+
+BOOL NTAG_WriteBlock(NTAG_HANDLE_T ntag, uint8_t block, const uint8_t *bytes, uint8_t len)
+{
+    (void)ntag;
+    if (sWriteError)
+    {
+        return TRUE;
+    }
+    memcpy(&sMem[block * NTAG_I2C_BLOCK_SIZE], bytes, len);
+    sWrites++;
+    return FALSE;
+}
+
+BOOL NTAG_WriteBytes(NTAG_HANDLE_T ntag, uint16_t address, const uint8_t *bytes, uint16_t len)
+{
+    (void)ntag;
+    memcpy(&sMem[address], bytes, len);
+    return FALSE;
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+static uint8_t *User(void)
+{
+    return &sMem[USER_START];
+}
+
+/* Puts image in the user memory, as written over RF while the cache was dropped */
+static void Load(const uint8_t *image, uint32_t len)
+{
+    memset(sMem, 0, sizeof(sMem));
+    memcpy(User(), image, len);
+    InvalidateConfigTag();
+    sReads = 0;
+    sWrites = 0;
+}
+
+/* Builds a lone Text record holding json, len bytes are cut from both lengths */
+static uint32_t MakeText(uint8_t *image, const char *json, uint8_t cut)
+{
+    uint32_t n = strlen(json);
+    uint32_t p = 0;
+
+    image[p++] = TLV_NDEF;
+    image[p++] = n + NDEF_TEXT_HEADER_LEN - cut;
+    image[p++] = NDEF_FLAG_MB | NDEF_FLAG_ME | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN;
+    image[p++] = 1;
+    image[p++] = n + 3 - cut;
+    image[p++] = 'T';
+    image[p++] = 2;
+    image[p++] = 'e';
+    image[p++] = 'n';
+    memcpy(&image[p], json, n);
+    p += n;
+    image[p++] = TLV_TERMINATOR;
+    return p;
+}
+
+static void LoadText(const char *json)
+{
+    uint8_t image[NTAG_USR_MEM_SIZE];
+
+    Load(image, MakeText(image, json, 0));
+}
+
+/* A lock control TLV, then a URI record and a Text record holding json, then a proprietary TLV */
+static uint32_t MakeMixed(uint8_t *image, const char *json)
+{
+    static const uint8_t lock[] = {0x01, 0x03, 0xA0, 0x10, 0x44, TLV_NULL};
+    static const uint8_t uri[] = {NDEF_FLAG_MB | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN, 1, 5, 'U', 0x01, 'n', 'x', 'p', '/'};
+    static const uint8_t proprietary[] = {0xFD, 0x02, 0x12, 0x34, TLV_TERMINATOR};
+    uint32_t n = strlen(json);
+    uint32_t p = 0;
+
+    memcpy(&image[p], lock, sizeof(lock));
+    p += sizeof(lock);
+    image[p++] = TLV_NDEF;
+    image[p++] = sizeof(uri) + n + NDEF_TEXT_HEADER_LEN;
+    memcpy(&image[p], uri, sizeof(uri));
+    p += sizeof(uri);
+    image[p++] = NDEF_FLAG_ME | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN;
+    image[p++] = 1;
+    image[p++] = n + 3;
+    image[p++] = 'T';
+    image[p++] = 2;
+    image[p++] = 'e';
+    image[p++] = 'n';
+    memcpy(&image[p], json, n);
+    p += n;
+    memcpy(&image[p], proprietary, sizeof(proprietary));
+    return p + sizeof(proprietary);
+}
+
+static bool UserEquals(const uint8_t *image, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = len; i < NTAG_USR_MEM_SIZE; i++)
+    {
+        if (0 != User()[i])
+        {
+            return FALSE;
+        }
+    }
+    return 0 == memcmp(User(), image, len);
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* Well formed configurations, and everything that must not be taken for one */
+static void TestParse(void)
+{
+    static const char *const bad[] = {"", "{", "{\"id\"", "{\"id\":}", "{\"id\":\"abc", "{\"type\":\"2\",}",
+                                      "{\"type\" \"2\"}", "[1]", "{\"type\":\"2\"", "{\"a\":{\"b\":1}"};
+    uint8_t image[NTAG_USR_MEM_SIZE];
+    uint8_t id[EUI_SIZE];
+    tag_config_t config;
+    uint32_t i;
+    uint8_t value;
+
+    LoadText("{\"id\":\"00603700000e22c4\",\"type\":\"2\",\"activetag\":\"1\"}");
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config));
+    CHECK(!strcmp((char *)config.id, "00603700000e22c4"));
+    CHECK((2 == config.type) && (1 == config.activetag) && (TAG_KEYS_ALL == config.keys));
+    CHECK(4 == sReads);
+
+    /* Later calls only check the blocks the configuration was parsed from */
+    sReads = 0;
+    CHECK(NTAG_SUCCESS == GetIdTag(id));
+    CHECK(NTAG_SUCCESS == GetTypeTag(&value) && (2 == value));
+    CHECK(8 == sReads);
+
+    /* Reordered keys, whitespace, an unknown nested value, numbers */
+    LoadText("{ \"x\": {\"a\":[1,{\"b\":\"}\"}]}, \"activetag\" : 1 , \"type\":3,\"id\":\"0011223344556677\" }");
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config));
+    CHECK((3 == config.type) && (1 == config.activetag) && (TAG_KEYS_ALL == config.keys));
+
+    /* A missing key */
+    LoadText("{\"id\":\"0011223344556677\"}");
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config) && ((1U << kTagKeyId) == config.keys));
+    CHECK(NTAG_FAIL == GetTypeTag(&value));
+
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        LoadText(bad[i]);
+        CHECK(NTAG_FAIL == GetConfigTag(&config));
+    }
+
+    /* Lengths cut short of the JSON text */
+    for (i = 1; i < 40; i++)
+    {
+        Load(image, MakeText(image, "{\"id\":\"00603700000e22c4\",\"type\":\"2\",\"activetag\":\"1\"}", i));
+        CHECK(NTAG_FAIL == GetConfigTag(&config));
+    }
+
+    /* A TLV longer than the user memory */
+    {
+        static const uint8_t longTlv[] = {TLV_NDEF, TLV_LONG_LENGTH, 0x01, 0x80, 0xD1};
+
+        Load(longTlv, sizeof(longTlv));
+        CHECK(NTAG_FAIL == GetConfigTag(&config));
+    }
+
+    /* A blank tag */
+    Load(image, 0);
+    CHECK(NTAG_FAIL == GetConfigTag(&config));
+
+    /* UTF-16 text */
+    LoadText("{}");
+    User()[6] = NDEF_TEXT_UTF16 | 2;
+    CHECK(NTAG_FAIL == GetConfigTag(&config));
+
+    /* A payload longer than the TLV */
+    LoadText("{\"type\":\"2\"}");
+    User()[4] = 200;
+    CHECK(NTAG_FAIL == GetConfigTag(&config));
+
+    /* Other TLVs and records around the configuration */
+    Load(image, MakeMixed(image, "{\"type\":\"5\"}"));
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config) && (5 == config.type));
+}
+
+/* A Text record that is not JSON is skipped for the next one */
+static void TestForeignText(void)
+{
+    static const char json[] = "{\"type\":\"7\"}";
+    uint8_t image[NTAG_USR_MEM_SIZE];
+    tag_config_t config;
+    uint32_t n = strlen(json);
+    uint32_t p = 0;
+
+    image[p++] = TLV_NDEF;
+    image[p++] = 2 * NDEF_TEXT_HEADER_LEN + 5 + n;
+    image[p++] = NDEF_FLAG_MB | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN;
+    memcpy(&image[p], "\x01\x08T\x02" "enhello", 11);
+    p += 11;
+    image[p++] = NDEF_FLAG_ME | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN;
+    image[p++] = 1;
+    image[p++] = n + 3;
+    memcpy(&image[p], "T\x02" "en", 4);
+    p += 4;
+    memcpy(&image[p], json, n);
+    p += n;
+    image[p++] = TLV_TERMINATOR;
+
+    Load(image, p);
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config) && (7 == config.type));
+}
+
+/* A same size value is patched in one block, everything else on the tag is kept */
+static void TestSetInPlace(void)
+{
+    static const char json[] = "{\"id\":\"00603700000e22c4\",\"x\":\"keep\",\"type\":\"2\",\"activetag\":\"1\"}";
+    uint8_t image[NTAG_USR_MEM_SIZE];
+    uint8_t *at;
+    uint32_t len;
+    uint8_t value;
+
+    len = MakeMixed(image, json);
+    Load(image, len);
+    CHECK(NTAG_SUCCESS == GetActiveTagValue(&value) && (1 == value));
+
+    value = 0;
+    sWrites = 0;
+    CHECK(NTAG_SUCCESS == SetActivetagTag(&value));
+    CHECK(1 == sWrites);
+    at = (uint8_t *)strstr((char *)image + 20, "\"activetag\":\"1\"") + 13;
+    *at = '0';
+    CHECK(UserEquals(image, len));
+
+    /* Unchanged values write nothing */
+    sWrites = 0;
+    CHECK(NTAG_SUCCESS == SetActivetagTag(&value));
+    CHECK(NTAG_SUCCESS == SetIdTag("00603700000e22c4"));
+    CHECK(0 == sWrites);
+
+    CHECK(NTAG_SUCCESS == SetIdTag("00603700000e22c5"));
+    at = (uint8_t *)strstr((char *)image + 20, "22c4\"");
+    at[3] = '5';
+    CHECK(UserEquals(image, len));
+
+    /* A number stays a number */
+    len = MakeMixed(image, "{\"type\":3}");
+    Load(image, len);
+    value = 4;
+    CHECK(NTAG_SUCCESS == SetTypeTag(&value));
+    *(uint8_t *)strstr((char *)image + 20, "3}") = '4';
+    CHECK(UserEquals(image, len));
+
+    /* A failed write drops the cache */
+    value = 5;
+    sWriteError = TRUE;
+    CHECK(NTAG_FAIL == SetTypeTag(&value));
+    sWriteError = FALSE;
+    CHECK(NTAG_SUCCESS == GetTypeTag(&value) && (4 == value));
+}
+
+/* Values that change size move what follows, the TLV and payload lengths follow */
+static void TestResize(void)
+{
+    uint8_t image[NTAG_USR_MEM_SIZE];
+    uint8_t expected[NTAG_USR_MEM_SIZE];
+    tag_config_t config;
+    uint32_t len;
+    uint8_t value;
+
+    /* An id too short to be taken grows to 16 digits */
+    Load(image, MakeMixed(image, "{\"id\":\"abc\",\"type\":\"2\"}"));
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config) && ((1U << kTagKeyType) == config.keys));
+    CHECK(NTAG_SUCCESS == SetIdTag("0011223344556677"));
+    len = MakeMixed(expected, "{\"id\":\"0011223344556677\",\"type\":\"2\"}");
+    CHECK(UserEquals(expected, len));
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config) && (TAG_KEYS_ALL & ~(1U << kTagKeyActivetag)) == config.keys);
+
+    /* A longer value shrinks, the freed tail is cleared */
+    Load(image, MakeMixed(image, "{\"type\":\"2 old\",\"x\":[1,2]}"));
+    value = 5;
+    CHECK(NTAG_SUCCESS == SetTypeTag(&value));
+    len = MakeMixed(expected, "{\"type\":\"5\",\"x\":[1,2]}");
+    CHECK(UserEquals(expected, len));
+
+    /* Missing keys are added before the closing brace */
+    Load(image, MakeMixed(image, "{}"));
+    CHECK(NTAG_SUCCESS == SetTypeTag(&value));
+    len = MakeMixed(expected, "{\"type\":\"5\"}");
+    CHECK(UserEquals(expected, len));
+    value = 1;
+    CHECK(NTAG_SUCCESS == SetActivetagTag(&value));
+    len = MakeMixed(expected, "{\"type\":\"5\",\"activetag\":\"1\"}");
+    CHECK(UserEquals(expected, len));
+}
+
+/* Values that do not fit leave the tag as it was */
+static void TestNoRoom(void)
+{
+    char json[NTAG_USR_MEM_SIZE];
+    uint8_t image[NTAG_USR_MEM_SIZE];
+    uint32_t len;
+    uint8_t value = 1;
+
+    /* Past the short payload length of the record */
+    memset(json, 'a', sizeof(json));
+    memcpy(json, "{\"x\":\"", 6);
+    strcpy(&json[232], "\",\"type\":\"2\"}");
+    len = MakeText(image, json, 0);
+    Load(image, len);
+    CHECK(NTAG_SUCCESS == GetTypeTag(&value));
+    sWrites = 0;
+    CHECK(NTAG_FAIL == SetActivetagTag(&value));
+    CHECK(0 == sWrites);
+    CHECK(UserEquals(image, len));
+
+    /* Past the end of the user memory */
+    memset(image, 0, sizeof(image));
+    len = MakeText(image, "{\"type\":\"2\"}", 0);
+    memset(&image[len - 1], TLV_NULL, NTAG_USR_MEM_SIZE - len);
+    image[len - 1] = 0xFD;
+    image[len] = NTAG_USR_MEM_SIZE - len - 3;
+    image[NTAG_USR_MEM_SIZE - 1] = TLV_TERMINATOR;
+    Load(image, NTAG_USR_MEM_SIZE);
+    CHECK(NTAG_FAIL == SetActivetagTag(&value));
+    CHECK(0 == sWrites);
+    CHECK(UserEquals(image, NTAG_USR_MEM_SIZE));
+}
+
+/* Writes over RF are seen without InvalidateConfigTag */
+static void TestRfWrite(void)
+{
+    tag_config_t config;
+    uint8_t value;
+    uint8_t *at;
+
+    LoadText("{\"type\":\"2\",\"activetag\":\"1\"}");
+    CHECK(NTAG_SUCCESS == GetActiveTagValue(&value) && (1 == value));
+
+    at = (uint8_t *)strstr((char *)User() + 9, "\"1\"") + 1;
+    *at = '0';
+    CHECK(NTAG_SUCCESS == GetActiveTagValue(&value) && (0 == value));
+
+    /* The reader wiped the configuration */
+    memset(User(), 0, NTAG_USR_MEM_SIZE);
+    CHECK(NTAG_FAIL == GetConfigTag(&config));
+
+    /* Blocks past the configuration are not checked, but never used stale */
+    LoadText("{\"type\":\"2\"}");
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config));
+    User()[NTAG_USR_MEM_SIZE - 1] = 0xAA;
+    value = 3;
+    CHECK(NTAG_SUCCESS == SetTypeTag(&value));
+    CHECK(0xAA == User()[NTAG_USR_MEM_SIZE - 1]);
+}
+
+/* WriteTag adds its record to the factory NDEF message, then patches it */
+static void TestWriteTag(void)
+{
+    static const uint8_t eui[8] = {0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF};
+    uint8_t factory[NTAG_USR_MEM_SIZE];
+    uint8_t *record;
+    tag_config_t config;
+    uint8_t value;
+
+    /* A blank tag gets the factory content first */
+    memset(factory, 0, sizeof(factory));
+    Load(factory, 0);
+    CHECK(NTAG_SUCCESS == WriteTag(NULL));
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config) && (TAG_KEYS_ALL == config.keys));
+    CHECK(!strcmp((char *)config.id, "00603700000e22c4") && (2 == config.type) && (1 == config.activetag));
+
+    /* The smart poster and the application record are kept, the latter is no longer the last */
+    memcpy(factory, &Default_BeginingOfMemory[USER_START], sizeof(Default_BeginingOfMemory) - USER_START);
+    CHECK(0x5F + 59 == User()[1]);
+    CHECK(!memcmp(&User()[2], &factory[2], 58));
+    CHECK((factory[60] & ~NDEF_FLAG_ME) == User()[60]);
+    CHECK(!memcmp(&User()[61], &factory[61], 0x5F - 59));
+    record = &User()[2 + 0x5F];
+    CHECK((NDEF_FLAG_ME | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN) == record[0]);
+    CHECK(!memcmp(&record[3], "T\x02" "en{\"id\":\"00603700000e22c4\",\"type\":\"2\",\"activetag\":\"1\"}", 56));
+    CHECK(TLV_TERMINATOR == record[59]);
+
+    /* Then only the id changes */
+    sWrites = 0;
+    CHECK(NTAG_SUCCESS == WriteTag((uint8_t *)eui));
+    CHECK(1 == sWrites);
+    CHECK(NTAG_SUCCESS == GetConfigTag(&config) && !strcmp((char *)config.id, "0123456789abcdef"));
+    sWrites = 0;
+    CHECK(NTAG_SUCCESS == WriteTag((uint8_t *)eui));
+    CHECK(0 == sWrites);
+
+    /* An existing configuration is completed, its other members are kept */
+    LoadText("{\"x\":\"keep\",\"type\":\"9\"}");
+    CHECK(NTAG_SUCCESS == WriteTag(NULL));
+    CHECK(!strcmp((char *)&User()[9], "{\"x\":\"keep\",\"type\":\"2\",\"id\":\"00603700000e22c4\",\"activetag\":\"1\"}\xFE"));
+    CHECK(NTAG_SUCCESS == GetTypeTag(&value) && (2 == value));
+}
+
+/* Random contents never make the parser or the setters leave the user memory */
+static void TestFuzz(void)
+{
+    uint8_t image[NTAG_USR_MEM_SIZE];
+    tag_config_t config;
+    uint32_t i;
+    uint32_t k;
+    uint32_t n;
+    uint8_t value;
+
+    srand(1);
+    for (i = 0; i < 100000; i++)
+    {
+        n = rand() % NTAG_USR_MEM_SIZE;
+        for (k = 0; k < n; k++)
+        {
+            image[k] = rand();
+        }
+        if ((i & 1) && (n > 7))
+        {
+            image[0] = TLV_NDEF;
+            image[1] = rand() % 80;
+            image[2] = NDEF_FLAG_MB | NDEF_FLAG_ME | NDEF_FLAG_SR | NDEF_TNF_WELL_KNOWN;
+            image[3] = 1;
+            image[5] = 'T';
+            image[6] = 2;
+        }
+        Load(image, n);
+        if (NTAG_SUCCESS == GetConfigTag(&config))
+        {
+            value = rand() % 10;
+            if (NTAG_SUCCESS == SetTypeTag(&value))
+            {
+                InvalidateConfigTag();
+                CHECK(NTAG_SUCCESS == GetTypeTag(&config.type) && (value == config.type));
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    TestParse();
+    TestForeignText();
+    TestSetInPlace();
+    TestResize();
+    TestNoRoom();
+    TestRfWrite();
+    TestWriteTag();
+    TestFuzz();
+
+    printf("tag_access: all tests passed\n");
+    return 0;
+}
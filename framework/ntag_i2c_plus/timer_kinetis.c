@@ -34,14 +34,22 @@
 //#include <board.h>
 #include "HAL_timer_driver.h"
 #include "fsl_smc.h"
+#if defined(FSL_RTOS_FREE_RTOS)
+#include "fsl_os_abstraction.h"
+#endif
 
 /***********************************************************************/
 /* DEFINES                                                             */
 /***********************************************************************/
+/* busy loop iterations per ms, a loop pass takes about 4 core cycles */
+#define TIMER_LOOPS_PER_MS (SystemCoreClock / 4000U)
+
 /***********************************************************************/
 /* GLOBAL VARIABLES                                                    */
 /***********************************************************************/
+#if !defined(FSL_RTOS_FREE_RTOS)
 static volatile uint32_t timer = 0;
+#endif
 
 /***********************************************************************/
 /* LOCAL FUNCTION PROTOTYPES                                           */
@@ -49,6 +57,23 @@ static volatile uint32_t timer = 0;
 /***********************************************************************/
 /* GLOBAL FUNCTIONS                                                    */
 /***********************************************************************/
+#if defined(FSL_RTOS_FREE_RTOS)
+void HAL_Timer_Init()
+{
+    /* the RTOS tick is the time base */
+}
+
+void HAL_Timer_delay_ms(uint32_t ms)
+{
+    /* the calling task sleeps, other tasks run meanwhile */
+    OSA_TimeDelay(ms);
+}
+
+uint32_t HAL_Timer_getTime_ms()
+{
+    return OSA_TimeGetMsec();
+}
+#else
 void HAL_Timer_Init()
 {
     /* produce a timer interrupt every 1ms */
@@ -57,11 +82,15 @@ void HAL_Timer_Init()
 
 void HAL_Timer_delay_ms(uint32_t ms)
 {
-    volatile uint32_t until = timer + ms;
-    while (until > timer)
+    volatile uint32_t loop;
+
+    /* the SysTick handler is not installed, scale a busy loop with the core clock */
+    while (ms--)
     {
-        __WFI();
-        //		Chip_PMU_SleepState(LPC_PMU);
+        for (loop = 0; loop < TIMER_LOOPS_PER_MS; loop++)
+        {
+            __NOP();
+        }
     }
 }
 
@@ -69,6 +98,7 @@ uint32_t HAL_Timer_getTime_ms()
 {
     return timer;
 }
+#endif
 
 /***********************************************************************/
 /* LOCAL FUNCTIONS                                                     */
@@ -83,7 +83,11 @@
  *----------------------------------------------------------*/
 
 #define configUSE_PREEMPTION                    1
+#ifdef RAPID_IOT
+#define configUSE_TICKLESS_IDLE                 1
+#else
 #define configUSE_TICKLESS_IDLE                 0
+#endif
 #define configCPU_CLOCK_HZ                      (SystemCoreClock)
 #ifdef RAPID_IOT
 #define configTICK_RATE_HZ                      ((TickType_t)1000)
@@ -193,4 +197,15 @@ standard names. */
 #define xPortPendSVHandler PendSV_Handler
 #define xPortSysTickHandler SysTick_Handler
 
+#if defined(RAPID_IOT) && (configUSE_TICKLESS_IDLE == 1)
+/* Tickless idle on LPTMR0 (fsl_tickless_lptmr.c), the sleep time and mode are
+selected by board/tickless_idle.c */
+extern void TicklessIdle_Sleep(uint32_t expectedIdleTime);
+extern void TicklessIdle_PreSleep(uint32_t expectedIdleTime);
+extern void TicklessIdle_PostSleep(uint32_t expectedIdleTime);
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime) TicklessIdle_Sleep(xExpectedIdleTime)
+#define configPRE_SLEEP_PROCESSING(xExpectedIdleTime)   TicklessIdle_PreSleep(xExpectedIdleTime)
+#define configPOST_SLEEP_PROCESSING(xExpectedIdleTime)  TicklessIdle_PostSleep(xExpectedIdleTime)
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
@@ -110,6 +110,8 @@ const char* gpHttpConnection = {"Connection:"};
 
 const char* gpHttpConnectionClose ={"close"};
 
+const char* gpHttpConnectionKeepAlive = {"keep-alive"};
+
 const char* gpHttpHost = "Host:";
 
 
@@ -184,7 +186,7 @@ void HTTP_Uint32ToAscii
 )
 {
     uint32_t crtPos = 0U;
-    char tempVal[4];
+    char tempVal[10]; /* Digits of the largest uint32_t */
     uint32_t index = 0;
 
     if(pAsciiValue)
@@ -49,13 +49,30 @@ Include Files
 
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 #include "FunctionLib.h"
 
+#include "TimersManager.h"
+
 /*==================================================================================================
 Private macros
 ==================================================================================================*/
 
+/* Index of HTTP/1.0 in gapHttpVersion */
+#define mHttpVersion10Index_c           1U
+
+/* Longest request header block kept while waiting for the rest of it */
+#define mHttpServerRxBufferSize_c       HTTP_MAX_RX_BUFFER_SIZE
+
+/* Largest piece of response handed to TCP at once */
+#define mHttpServerTxBufferSize_c       HTTP_MAX_RX_BUFFER_SIZE
+
+/* Status line, headers and empty line of a response, see HTTP_SendResponse() */
+#define mHttpResponseHeadSegments_c     11U
+
+/* Digits of the largest uint32_t */
+#define mHttpMaxDigits_c                10U
 
 /*==================================================================================================
 Private type definitions
@@ -68,11 +85,20 @@ typedef struct httpSockInfo_tag
     int32_t  sockFd;
     char* pAbsPath;
     uint32_t absPathLen;
+    char* pRxBuffer;            /* Start of a request whose header block is not complete yet */
+    uint32_t rxLen;
+    uint32_t bodyToSkip;        /* Bytes of a request body still to be received */
+    char* pTxBuffer;            /* Responses, or their end, TCP had no room for yet */
+    uint32_t txLen;
+    uint32_t txOffset;          /* First byte of pTxBuffer not sent yet */
+    uint32_t lastActivityMs;    /* Last data received or sent */
+    uint32_t nbRequests;
     bool_t bHostIncludedInUri;
     bool_t bCloseConnection;
     uint16_t remotePort;
     uint8_t nbQuery;
     uint8_t versionIndex;
+    uint8_t methodIndex;
 }httpSockInfo_t;
 
 typedef struct httpServerCfg_tag
@@ -86,6 +112,10 @@ typedef struct httpServerCfg_tag
     uint32_t uriTblLen;
     uint16_t hostPort;
     bool_t   bUseSecurity;
+    tmrTimerID_t idleTimer;
+    /* "Server:", "Content-Type:" and "Content-Length:" headers, rendered once for each media
+       type. The one of gHttpUriType_notPresent_c has no Content-Type. */
+    httpString_t aHeaderTemplate[NumberOfElements(aHttpContentTypeValue)];
 }httpServerCfg_t;
 
 typedef enum
@@ -93,7 +123,8 @@ typedef enum
     mHttpHost_c = 0U,
     mHttpUserAgent_c,
     mHttpAccept_c,
-    mHttpConnection_c
+    mHttpConnection_c,
+    mHttpContentLength_c
 }httpRequestIndex_t; /* Request index in mapHttpRequestHeaderList */
 
 /*==================================================================================================
@@ -102,14 +133,32 @@ Private prototypes
 #if BSDS_STREAM_SUPPORT && TCP_ENABLED
 static uint32_t HTTP_GetFreeEntryClientSocketTbl(void);
 static uint32_t HTTP_GetEntryClientSocketTbl(int32_t sockFd);
+static void HTTP_CloseClient(uint32_t sockIndex, bool_t bShutdown);
 static void HTTP_ServerDataIndHandler(void *sockFd);
+static void HTTP_ServerReceive(uint32_t sockIndex, char* pData, uint32_t dataLen);
+static uint32_t HTTP_GetRequestLength(const char* pData, uint32_t dataLen);
 static void HTTP_ServerProcessDataInd(uint32_t sockIndex, char* pHttpDataInd);
 static httpStatus_t HTTP_ParseRequestLine(uint32_t sockIndex, char* pHttpDataInd,
                                                      uint32_t requestLineLength);
-static void HTTP_SendResponse(uint32_t sockIndex, httpStatus_t status,
-                              char* pResult, const uriTableEntry_t* pUriTableEntry);
+static void HTTP_SendResponse(uint32_t sockIndex, httpStatus_t status, httpMediaType_t mediaType,
+                              const httpBodySegment_t* pBody, uint32_t nbBodySegments);
+static bool_t HTTP_SendSegments(uint32_t sockIndex, const httpBodySegment_t* pSegments,
+                                uint32_t nbSegments);
+static bool_t HTTP_KeepPending(uint32_t sockIndex, const char* pData, uint32_t dataLen,
+                               const httpBodySegment_t* pSegments, uint32_t nbSegments,
+                               uint32_t segmentOffset, uint32_t segmentsLen);
+static uint32_t HTTP_GatherSegments(char* pDst, uint32_t maxLen, const httpBodySegment_t** ppSegments,
+                                    uint32_t* pNbSegments, uint32_t* pSegmentOffset);
+static void HTTP_SendPending(uint32_t sockIndex);
+static void HTTP_AddSegment(httpBodySegment_t** ppSegment, const void* pData, uint32_t length);
+static void HTTP_RenderHeaderTemplates(void);
 static void HTTP_ProcessConnectionHeader(uint32_t sockIndex, char* pConnectionValue);
+static bool_t HTTP_TokenMatch(const char* pValue, const char* pToken);
 static httpStatus_t HTTP_CheckHostname(httpString_t hostname);
+static void HTTP_StartIdleTimer(void);
+static void HTTP_IdleTimerCb(void *param);
+static void HTTP_CheckClients(void *param);
+static uint32_t HTTP_GetTimeMs(void);
 #endif /* BSDS_STREAM_SUPPORT && TCP_ENABLED */
 
 /*==================================================================================================
@@ -123,22 +172,23 @@ static httpServerCfg_t* mpHttpServerCfg = NULL;
 /* Supported Schemes */
 static const char* aHttpScheme[]=
 {
-    {"/",},
-    {"http://"},
-    {"https://"}
+    "/",
+    "http://",
+    "https://"
 };
 
-const char* mpHttpServer = {"Server:"};
+const char* mpHttpServer = "Server:";
 
 // TBD: to be configured by the user
-const char* mpHttpServerToken = {"Freescale IP server"};
+const char* mpHttpServerToken = "Freescale IP server";
 
 const char* mapHttpRequestHeaderList[] =
 {
-    {"Host:"},      /* mHttpHost_c */
-    {"User-Agent:"},
-    {"Accept:"},
-    {"Connection:"}
+    "Host:",      /* mHttpHost_c */
+    "User-Agent:",
+    "Accept:",
+    "Connection:",
+    "Content-Length:"
 };
 #endif /* BSDS_STREAM_SUPPORT && TCP_ENABLED */
 OSA_TASK_PROTO(HTTP_AcceptTask);
@@ -191,6 +241,9 @@ bool_t HTTP_StartServer
     uint32_t hostNameLen = strlen((char*)pHostName);
     sockaddrStorage_t* pLocalAddr = NULL;
 
+    /* The server has no TLS support */
+    (void)bUseSecurity;
+
     /* Initialize session task */
     Session_Init();
 
@@ -204,8 +257,9 @@ bool_t HTTP_StartServer
 
         mpHttpServerCfg->hostPort = serverPort;
 
-        mpHttpServerCfg->pHostName = NWKU_MEM_BufferAllocForever(hostNameLen);
-        FLib_MemCpy(mpHttpServerCfg->pHostName, pHostName, hostNameLen);
+        /* Keep the '\0', the name is compared with strlen() */
+        mpHttpServerCfg->pHostName = NWKU_MEM_BufferAllocForever(hostNameLen + 1U);
+        FLib_MemCpy(mpHttpServerCfg->pHostName, pHostName, hostNameLen + 1U);
 
         for(resourceIndex = 0U; resourceIndex < httpUriTableSize; resourceIndex ++)
         {
@@ -236,7 +290,7 @@ bool_t HTTP_StartServer
         /* Create socket */
         mpHttpServerCfg->sockFd = socket(pLocalAddr->ss_family, SOCK_STREAM, IPPROTO_TCP);
 
-        if(mpHttpServerCfg->sockFd > 0U)
+        if(mpHttpServerCfg->sockFd > 0)
         {
             if(gHttpServerTypeDualIpv6Ipv4_c == serverType)
             {
@@ -254,6 +308,11 @@ bool_t HTTP_StartServer
 
                 if(0U == status)
                 {
+                    HTTP_RenderHeaderTemplates();
+
+                    /* Timer closing the idle connections and retrying the blocked responses */
+                    mpHttpServerCfg->idleTimer = TMR_AllocateTimer();
+
                     /* Create HTTP Accept task */
                     ListInit(&mpHttpServerCfg->acceptMsgQueue.msgQueue,HTTP_ACCEPT_TASK_MSG_QUEUE_SIZE);
 
@@ -321,13 +380,15 @@ void HTTP_AcceptTask
        We can use sockaddrIn6_t both for IPv6 and IPv4 */
     sockaddrIn6_t* pSockaddrIn6;
 
+    (void)argument;
+
     while (1)
     {
         remoteSock = accept(mpHttpServerCfg->sockFd, &remoteAddr, sizeof(sockaddrStorage_t));
 
         if(remoteSock > 0)
         {
-           if(mpHttpServerCfg->nbClientSock <= HTTP_SERVER_CONNECTION_TABLE_SIZE)
+           if(mpHttpServerCfg->nbClientSock < HTTP_SERVER_CONNECTION_TABLE_SIZE)
            {
                /* Add new client info in socket table */
                 sockIndex = HTTP_GetFreeEntryClientSocketTbl();
@@ -339,6 +400,8 @@ void HTTP_AcceptTask
 
                 if(mpHttpServerCfg->apClientSockTbl[sockIndex])
                 {
+                    FLib_MemSet(mpHttpServerCfg->apClientSockTbl[sockIndex], 0U, sizeof(httpSockInfo_t));
+
                     /* Update client socket descriptor table */
                     mpHttpServerCfg->apClientSockTbl[sockIndex]->sockFd = remoteSock;
 
@@ -348,9 +411,14 @@ void HTTP_AcceptTask
                     pSockaddrIn6 = (sockaddrIn6_t*)&remoteAddr;
                     mpHttpServerCfg->apClientSockTbl[sockIndex]->remotePort = pSockaddrIn6->sin6_port;
 
+                    mpHttpServerCfg->apClientSockTbl[sockIndex]->lastActivityMs = HTTP_GetTimeMs();
+
                     mpHttpServerCfg->nbClientSock ++;
 
                     Session_RegisterCb(remoteSock, HTTP_ServerDataIndHandler, &mThreadStackMsgQueue);
+
+                    /* A client that never sends a request is closed as well */
+                    HTTP_StartIdleTimer();
                 }
                 //break; /* TBD HTTP: do not break if we can accept more clients */
                 //while(1);
@@ -433,6 +501,49 @@ static uint32_t HTTP_GetEntryClientSocketTbl
     return iCount;
 }
 
+/*!*************************************************************************************************
+\private
+\fn     static void HTTP_CloseClient(uint32_t sockIndex, bool_t bShutdown)
+
+\brief  This function frees a client connection
+
+\param [in]   sockIndex  index of the socket in mpHttpServerCfg->apClientSockTbl
+\param [in]   bShutdown  TRUE if the socket is still open and must be closed
+
+\param [out]  none
+
+\retval       none
+***************************************************************************************************/
+static void HTTP_CloseClient
+(
+    uint32_t sockIndex,
+    bool_t bShutdown
+)
+{
+    httpSockInfo_t* pSockInfo = mpHttpServerCfg->apClientSockTbl[sockIndex];
+
+    if(bShutdown)
+    {
+        // TBD: set sockHow
+        shutdown(pSockInfo->sockFd, 0U);
+    }
+
+    if(pSockInfo->pRxBuffer)
+    {
+        MEM_BufferFree(pSockInfo->pRxBuffer);
+    }
+
+    if(pSockInfo->pTxBuffer)
+    {
+        MEM_BufferFree(pSockInfo->pTxBuffer);
+    }
+
+    MEM_BufferFree(pSockInfo);
+    mpHttpServerCfg->apClientSockTbl[sockIndex] = NULL;
+
+    mpHttpServerCfg->nbClientSock --;
+}
+
 /*!*************************************************************************************************
 \private
 \fn     static void HTTP_ServerDataIndHandler(void *sockFd)
@@ -462,15 +573,12 @@ static void HTTP_ServerDataIndHandler
         if(pSessionPacket->dataLen == 0)
         {
             /* Connection closed */
-            mpHttpServerCfg->nbClientSock --;
-            MEM_BufferFree(mpHttpServerCfg->apClientSockTbl[clientSockIndex]);
-            mpHttpServerCfg->apClientSockTbl[clientSockIndex] = NULL;
+            HTTP_CloseClient(clientSockIndex, FALSE);
         }
         else
         {
-            /* Save '\0' inside the array in order to use string functions */
-            pSessionPacket->pData[pSessionPacket->dataLen] = '\0';
-            HTTP_ServerProcessDataInd(clientSockIndex, (char*)pSessionPacket->pData);
+            mpHttpServerCfg->apClientSockTbl[clientSockIndex]->lastActivityMs = HTTP_GetTimeMs();
+            HTTP_ServerReceive(clientSockIndex, (char*)pSessionPacket->pData, pSessionPacket->dataLen);
         }
     }
 
@@ -478,6 +586,180 @@ static void HTTP_ServerDataIndHandler
     MEM_BufferFree(pSessionPacket);
 }
 
+/*!*************************************************************************************************
+\private
+\fn     static void HTTP_ServerReceive(uint32_t sockIndex, char* pData, uint32_t dataLen)
+
+\brief  This function serves, in order, the requests completed by the received data. A request
+        split between indications is kept until its header block is complete, the requests
+        received while a response waits for room in TCP are kept until it is sent. The request
+        bodies are dropped.
+
+\param [in]   sockIndex  index of the socket on which data is received
+\param [in]   pData      received data, with room for a '\0' after it
+\param [in]   dataLen    length of the received data, 0 serves the requests kept
+
+\param [out]  none
+
+\retval       none
+***************************************************************************************************/
+static void HTTP_ServerReceive
+(
+    uint32_t sockIndex,
+    char* pData,
+    uint32_t dataLen
+)
+{
+    httpSockInfo_t* pSockInfo = mpHttpServerCfg->apClientSockTbl[sockIndex];
+    char* pCrtPos = pData;
+    uint32_t remaining = dataLen;
+    uint32_t length;
+    char savedChar;
+    bool_t bTooLarge = FALSE;
+
+    /* Drop the rest of the body of the previous request */
+    length = (pSockInfo->bodyToSkip < remaining) ? pSockInfo->bodyToSkip : remaining;
+    pCrtPos += length;
+    remaining -= length;
+    pSockInfo->bodyToSkip -= length;
+
+    if(pSockInfo->rxLen)
+    {
+        /* Complete the requests received before */
+        if(pSockInfo->rxLen + remaining > mHttpServerRxBufferSize_c)
+        {
+            bTooLarge = TRUE;
+        }
+        else
+        {
+            FLib_MemCpy(pSockInfo->pRxBuffer + pSockInfo->rxLen, pCrtPos, remaining);
+            pCrtPos = pSockInfo->pRxBuffer;
+            remaining += pSockInfo->rxLen;
+        }
+
+        pSockInfo->rxLen = 0U;
+    }
+
+    /* Serve the pipelined requests, each response is sent before the next request is parsed */
+    while(remaining && (FALSE == bTooLarge) && (NULL == pSockInfo->pTxBuffer))
+    {
+        /* Ignore the empty lines before a request */
+        if(('\r' == *pCrtPos) || ('\n' == *pCrtPos))
+        {
+            pCrtPos ++;
+            remaining --;
+            continue;
+        }
+
+        length = HTTP_GetRequestLength(pCrtPos, remaining);
+
+        if(0U == length)
+        {
+            break;
+        }
+
+        /* Save '\0' after the request in order to use string functions */
+        savedChar = pCrtPos[length];
+        pCrtPos[length] = '\0';
+
+        HTTP_ServerProcessDataInd(sockIndex, pCrtPos);
+
+        if(NULL == mpHttpServerCfg->apClientSockTbl[sockIndex])
+        {
+            /* Connection closed, the requests left are dropped */
+            return;
+        }
+
+        pCrtPos[length] = savedChar;
+        pCrtPos += length;
+        remaining -= length;
+
+        length = (pSockInfo->bodyToSkip < remaining) ? pSockInfo->bodyToSkip : remaining;
+        pCrtPos += length;
+        remaining -= length;
+        pSockInfo->bodyToSkip -= length;
+    }
+
+    if(bTooLarge || (remaining > mHttpServerRxBufferSize_c))
+    {
+        pSockInfo->bCloseConnection = TRUE;
+        HTTP_SendResponse(sockIndex, gHttp_ServerRes413_RequestEntityTooLarge_c,
+                          gHttpUriType_notPresent_c, NULL, 0U);
+    }
+    else if(remaining)
+    {
+        /* Keep the start of the request until the rest of its header block is received, or the
+           requests until the response before them is sent */
+        if(NULL == pSockInfo->pRxBuffer)
+        {
+            pSockInfo->pRxBuffer = NWKU_MEM_BufferAlloc(mHttpServerRxBufferSize_c + 1U);
+        }
+
+        if(pSockInfo->pRxBuffer)
+        {
+            memmove(pSockInfo->pRxBuffer, pCrtPos, remaining);
+            pSockInfo->rxLen = remaining;
+        }
+        else
+        {
+            pSockInfo->bCloseConnection = TRUE;
+        }
+    }
+    else if(pSockInfo->pRxBuffer)
+    {
+        MEM_BufferFree(pSockInfo->pRxBuffer);
+        pSockInfo->pRxBuffer = NULL;
+    }
+
+    if(mpHttpServerCfg->apClientSockTbl[sockIndex] && pSockInfo->bCloseConnection &&
+       (NULL == pSockInfo->pTxBuffer))
+    {
+        HTTP_CloseClient(sockIndex, TRUE);
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static uint32_t HTTP_GetRequestLength(const char* pData, uint32_t dataLen)
+
+\brief  This function searches the empty line ending the header block of a request
+
+\param [in]   pData    pointer to the request line
+\param [in]   dataLen  length of the received data
+
+\param [out]  none
+
+\retval       length of the request line and headers, including the empty line
+\retval       0 if the header block is not complete
+***************************************************************************************************/
+static uint32_t HTTP_GetRequestLength
+(
+    const char* pData,
+    uint32_t dataLen
+)
+{
+    uint32_t index;
+    uint32_t requestLen = 0U;
+
+    for(index = 0U; (index < dataLen) && (0U == requestLen); index ++)
+    {
+        if('\n' == pData[index])
+        {
+            if((index + 1U < dataLen) && ('\n' == pData[index + 1U]))
+            {
+                requestLen = index + 2U;
+            }
+            else if((index + 2U < dataLen) && ('\r' == pData[index + 1U]) &&
+                    ('\n' == pData[index + 2U]))
+            {
+                requestLen = index + 3U;
+            }
+        }
+    }
+
+    return requestLen;
+}
+
 /*!*************************************************************************************************
 \private
 \fn     static void HTTP_ServerProcessDataInd(uint32_t sockIndex, char* pHttpDataInd)
@@ -497,17 +779,20 @@ static void HTTP_ServerProcessDataInd
     char* pHttpDataInd
 )
 {
+    httpSockInfo_t* pSockInfo = mpHttpServerCfg->apClientSockTbl[sockIndex];
     httpStatus_t status = gHttp_ServerRes200_Ok_c;
     char* pSearchedChar;
     uint32_t requestLineLength;
     char* pResult = NULL;
-    uriTableEntry_t* pUriTableEntry = NULL;
+    const uriTableEntry_t* pUriTableEntry = NULL;
+    httpMediaType_t mediaType = gHttpUriType_notPresent_c;
+    httpBodySegment_t aBody[HTTP_SERVER_BODY_SEGMENTS];
+    uint32_t nbBodySegments = 0U;
     char* pCrtPos = pHttpDataInd;
     uint32_t headerIndex;
     //uint32_t headerValueIndex;
     uint32_t resourceIndex;
     char* pAbsPath;
-    int sockHow = 0U;
     httpString_t hostname;
 
     /* Check if CRLF is received (Mandatory HTTP/1.1 : Method SP Request-URI SP HTTP-Version CRLF) */
@@ -526,8 +811,9 @@ static void HTTP_ServerProcessDataInd
 
         if(gHttp_ServerRes200_Ok_c ==  status)
         {
-            /* Continue with header processing */
-            mpHttpServerCfg->apClientSockTbl[sockIndex]->bCloseConnection = FALSE;
+            /* Continue with header processing. HTTP/1.1 connections are persistent unless the
+               client asks otherwise, HTTP/1.0 ones only if it asks for it. */
+            pSockInfo->bCloseConnection = (mHttpVersion10Index_c == pSockInfo->versionIndex);
 
             pCrtPos = pSearchedChar + 1;
 
@@ -591,6 +877,12 @@ static void HTTP_ServerProcessDataInd
                                 // TBD: process accept
                                 break;
 
+                            case mHttpContentLength_c:
+
+                                /* The body is not used, it is skipped to reach the next request */
+                                pSockInfo->bodyToSkip = strtoul(pCrtPos, NULL, 10);
+                                break;
+
                             default:
                                 break;
                         }
@@ -612,46 +904,61 @@ static void HTTP_ServerProcessDataInd
             if(gHttp_ServerRes200_Ok_c ==  status)
             {
                 /* Search resource in URI table */
-                pAbsPath = mpHttpServerCfg->apClientSockTbl[sockIndex]->pAbsPath;
-                for(resourceIndex = 0; ((resourceIndex < mpHttpServerCfg->uriTblLen) && (gHttp_ServerRes200_Ok_c ==  status)); resourceIndex ++)
+                pAbsPath = pSockInfo->pAbsPath;
+                for(resourceIndex = 0; ((resourceIndex < mpHttpServerCfg->uriTblLen) && (NULL == pUriTableEntry)); resourceIndex ++)
                 {
-                    if(0U == strncmp((const char *)pAbsPath,
-                                     (const char *)mpHttpServerCfg->pUriTbl[resourceIndex]->pRequestUri,
-                                     mpHttpServerCfg->apClientSockTbl[sockIndex]->absPathLen))
+                    if((pSockInfo->absPathLen == strlen((const char *)mpHttpServerCfg->pUriTbl[resourceIndex]->pRequestUri)) &&
+                       (0U == strncmp((const char *)pAbsPath,
+                                      (const char *)mpHttpServerCfg->pUriTbl[resourceIndex]->pRequestUri,
+                                      pSockInfo->absPathLen)))
                     {
                         /* Resource found */
-                        pUriTableEntry = (uriTableEntry_t*)mpHttpServerCfg->pUriTbl[resourceIndex];
+                        pUriTableEntry = mpHttpServerCfg->pUriTbl[resourceIndex];
 
                         /* Check if query was present in the request */
-                        if((mpHttpServerCfg->apClientSockTbl[sockIndex]->nbQuery) &&
-                           (mpHttpServerCfg->pUriTbl[resourceIndex]->pQueryFunction))
+                        if((pSockInfo->nbQuery) &&
+                           (pUriTableEntry->pQueryFunction))
                         {
                             /* Call query callback */
-                            status = mpHttpServerCfg->pUriTbl[resourceIndex]->pQueryFunction(
-                                           mpHttpServerCfg->apClientSockTbl[sockIndex]->nbQuery,
-                                           *mpHttpServerCfg->apClientSockTbl[sockIndex]->pQuery);
+                            status = pUriTableEntry->pQueryFunction(pSockInfo->nbQuery,
+                                                                    *pSockInfo->pQuery);
                             // TBD: resulted URI (pResultUriContent)
                         }
-                        else
+                        else if(pUriTableEntry->pUriContent)
                         {
-                            pResult = mpHttpServerCfg->pUriTbl[resourceIndex]->pUriContent;
+                            aBody[0].pData = pUriTableEntry->pUriContent;
+                            aBody[0].length = strlen((const char*)pUriTableEntry->pUriContent);
+                            nbBodySegments = 1U;
                         }
 
                         /* Check for dynamic data */
-                        if(mpHttpServerCfg->pUriTbl[resourceIndex]->pHttpScriptFunction)
+                        if(pUriTableEntry->pHttpBodyFunction)
                         {
-                            pResult = mpHttpServerCfg->pUriTbl[resourceIndex]->pHttpScriptFunction(
-                                mpHttpServerCfg->pUriTbl[resourceIndex]->pUriContent);
+                            nbBodySegments = pUriTableEntry->pHttpBodyFunction(
+                                pUriTableEntry->pUriContent, aBody, HTTP_SERVER_BODY_SEGMENTS);
                         }
+                        else if(pUriTableEntry->pHttpScriptFunction)
+                        {
+                            pResult = pUriTableEntry->pHttpScriptFunction(pUriTableEntry->pUriContent);
+                            nbBodySegments = 0U;
 
-                        // TBD: do not return any message body when HEAD is received
-                    }
-                    else
-                    {
-                        /* Resource not found */
-                        status = gHttp_ServerRes404_NotFound_c;
+                            if(pResult)
+                            {
+                                aBody[0].pData = (uint8_t*)pResult;
+                                aBody[0].length = strlen(pResult);
+                                nbBodySegments = 1U;
+                            }
+                        }
+
+                        mediaType = pUriTableEntry->mediaType;
                     }
                 }
+
+                if(NULL == pUriTableEntry)
+                {
+                    /* Resource not found */
+                    status = gHttp_ServerRes404_NotFound_c;
+                }
             }
         }
     }
@@ -663,20 +970,37 @@ static void HTTP_ServerProcessDataInd
         status = gHttp_ServerRes413_RequestEntityTooLarge_c;
     }
 
-    HTTP_SendResponse(sockIndex, status, pResult, pUriTableEntry);
+    pSockInfo->nbRequests ++;
 
-    if(mpHttpServerCfg->apClientSockTbl[sockIndex] &&
-       mpHttpServerCfg->apClientSockTbl[sockIndex]->bCloseConnection)
+    if((0U == HTTP_SERVER_KEEP_ALIVE_TIMEOUT) ||
+       (pSockInfo->nbRequests >= HTTP_SERVER_KEEP_ALIVE_MAX_REQUESTS) ||
+       (gHttp_ServerRes400_BadRequest_c == status) ||
+       (gHttp_ServerRes413_RequestEntityTooLarge_c == status) ||
+       (gHttp_ServerRes505_VersionNotSupported_c == status))
     {
-        // TBD: set sockHow
-        /* Close the connection after sending the data */
-        shutdown(mpHttpServerCfg->apClientSockTbl[sockIndex]->sockFd, sockHow);
+        /* The headers may not have been parsed, the next request can't be found */
+        pSockInfo->bCloseConnection = TRUE;
+    }
 
-        /* Free socket related info */
-        MEM_BufferFree(mpHttpServerCfg->apClientSockTbl[sockIndex]);
-        mpHttpServerCfg->apClientSockTbl[sockIndex] = NULL;
+    HTTP_SendResponse(sockIndex, status, mediaType, aBody, nbBodySegments);
 
-        mpHttpServerCfg->nbClientSock --;
+    if(pResult)
+    {
+        MEM_BufferFree(pResult);
+    }
+
+    if(mpHttpServerCfg->apClientSockTbl[sockIndex] &&
+       mpHttpServerCfg->apClientSockTbl[sockIndex]->bCloseConnection)
+    {
+        /* Close the connection after sending the data, when all of it is sent */
+        if(NULL == pSockInfo->pTxBuffer)
+        {
+            HTTP_CloseClient(sockIndex, TRUE);
+        }
+    }
+    else
+    {
+        HTTP_StartIdleTimer();
     }
 }
 
@@ -719,6 +1043,7 @@ static httpStatus_t HTTP_ParseRequestLine
     char* pCrtPos = pHttpDataInd;
     uint32_t absPathLen = 0U;
 
+    (void)requestLineLength;
     mpHttpServerCfg->apClientSockTbl[sockIndex]->bHostIncludedInUri = FALSE;
 
     /* Test which the method is present */
@@ -732,6 +1057,8 @@ static httpStatus_t HTTP_ParseRequestLine
         }
     }
 
+    mpHttpServerCfg->apClientSockTbl[sockIndex]->methodIndex = methodIndex;
+
     if(methodIndex < nbMethods)
     {
         /* Method implemented */
@@ -912,15 +1239,18 @@ static httpStatus_t HTTP_ParseRequestLine
 
 /*!*************************************************************************************************
 \private
-\fn     static void HTTP_SendResponse(uint32_t sockIndex, httpStatus_t status, char* pResult,
-                                      const uriTableEntry_t* pUriTableEntry)
+\fn     static void HTTP_SendResponse(uint32_t sockIndex, httpStatus_t status,
+                                      httpMediaType_t mediaType, const httpBodySegment_t* pBody,
+                                      uint32_t nbBodySegments)
 
-\brief  This function sends an HTTP response
+\brief  This function sends an HTTP response. The headers are taken from the templates rendered
+        when the server was started, only the content length is converted for each response.
 
 \param [in]   sockIndex       index of the socket on which data is received
 \param [in]   status          status to be included in response
-\param [in]   pResult         message body to be included in response (NULL is valid)
-\param [in]   pUriTableEntry  pointer to the URI
+\param [in]   mediaType       media type of the message body
+\param [in]   pBody           pieces of the message body (NULL is valid)
+\param [in]   nbBodySegments  number of pieces of the message body
 
 \param [out]  none
 
@@ -930,23 +1260,29 @@ static void HTTP_SendResponse
 (
     uint32_t sockIndex,
     httpStatus_t status,
-    char* pResult,
-    const uriTableEntry_t* pUriTableEntry
+    httpMediaType_t mediaType,
+    const httpBodySegment_t* pBody,
+    uint32_t nbBodySegments
 )
 {
-    char* pHttpResponse = NWKU_MEM_BufferAlloc(HTTP_MAX_RX_BUFFER_SIZE);
-    uint32_t txFlags = MSG_DONTWAIT;
-    uint32_t versionIndex = mpHttpServerCfg->apClientSockTbl[sockIndex]->versionIndex;
-    uint32_t versionLen;
-    char aItoaContentLen[4];
+    httpSockInfo_t* pSockInfo = mpHttpServerCfg->apClientSockTbl[sockIndex];
+    httpBodySegment_t aSegments[mHttpResponseHeadSegments_c + HTTP_SERVER_BODY_SEGMENTS];
+    httpBodySegment_t* pCrtSegment = aSegments;
+    uint32_t versionIndex = pSockInfo->versionIndex;
+    const char* pConnectionToken = gpHttpConnectionKeepAlive;
+    char aItoaContentLen[mHttpMaxDigits_c];
     uint8_t itoaContentLen;
-    char* pCrtPos = pHttpResponse;
-    uint32_t length;
     uint32_t resultSize = 0U;
+    uint32_t iCount;
 
-    if(pResult)
+    if(nbBodySegments > HTTP_SERVER_BODY_SEGMENTS)
+    {
+        nbBodySegments = HTTP_SERVER_BODY_SEGMENTS;
+    }
+
+    for(iCount = 0U; iCount < nbBodySegments; iCount ++)
     {
-        resultSize = strlen(pResult);
+        resultSize += pBody[iCount].length;
     }
 
     if(versionIndex >= NumberOfElements(gapHttpVersion))
@@ -955,76 +1291,422 @@ static void HTTP_SendResponse
         versionIndex = 0U;
     }
 
-    versionLen = strlen(gapHttpVersion[versionIndex]);
+    if((0U == resultSize) || (mediaType >= NumberOfElements(mpHttpServerCfg->aHeaderTemplate)))
+    {
+        /* No Content-Type header */
+        mediaType = gHttpUriType_notPresent_c;
+    }
+
+    if(pSockInfo->bCloseConnection)
+    {
+        pConnectionToken = gpHttpConnectionClose;
+    }
 
-    /* Add HTTP version */
-    FLib_MemCpy(pCrtPos, (void*)gapHttpVersion[versionIndex], versionLen);
-    pCrtPos += versionLen;
+    /* Add HTTP-Version SP Status-Code SP Reason-Phrase CRLF */
+    HTTP_AddSegment(&pCrtSegment, gapHttpVersion[versionIndex], strlen(gapHttpVersion[versionIndex]));
+    HTTP_AddSegment(&pCrtSegment, " ", 1U);
+    HTTP_AddSegment(&pCrtSegment, aHttpStatusReason[status].pstringValue,
+                    strlen((char*)aHttpStatusReason[status].pstringValue));
+
+    /* Add Server, Content-Type and Content-Length headers. The Content-Length is always sent,
+       it delimits the response on a persistent connection. */
+    HTTP_AddSegment(&pCrtSegment, mpHttpServerCfg->aHeaderTemplate[mediaType].pstringValue,
+                    mpHttpServerCfg->aHeaderTemplate[mediaType].strLength);
+    HTTP_Uint32ToAscii(resultSize, aItoaContentLen, &itoaContentLen);
+    HTTP_AddSegment(&pCrtSegment, aItoaContentLen, itoaContentLen);
+    HTTP_AddSegment(&pCrtSegment, gpHttpNewLine, strlen(gpHttpNewLine));
+
+    /* Add Connection header */
+    HTTP_AddSegment(&pCrtSegment, mapHttpRequestHeaderList[mHttpConnection_c],
+                    strlen(mapHttpRequestHeaderList[mHttpConnection_c]));
+    HTTP_AddSegment(&pCrtSegment, " ", 1U);
+    HTTP_AddSegment(&pCrtSegment, pConnectionToken, strlen(pConnectionToken));
+    HTTP_AddSegment(&pCrtSegment, gpHttpNewLine, strlen(gpHttpNewLine));
+
+    /* Add the last '\r\n' */
+    HTTP_AddSegment(&pCrtSegment, gpHttpNewLine, strlen(gpHttpNewLine));
+
+    /* Add message body, none is returned for HEAD */
+    if(gHttpMethodHead_c != pSockInfo->methodIndex)
+    {
+        for(iCount = 0U; iCount < nbBodySegments; iCount ++)
+        {
+            HTTP_AddSegment(&pCrtSegment, pBody[iCount].pData, pBody[iCount].length);
+        }
+    }
 
-    /* Add SP */
-    *pCrtPos = ' ';
-    pCrtPos ++;
+    /* Send HTTP response to TCP */
+    if(FALSE == HTTP_SendSegments(sockIndex, aSegments, pCrtSegment - aSegments))
+    {
+        /* No memory for the response, close the connection */
+        HTTP_CloseClient(sockIndex, TRUE);
+    }
+}
 
-    /* Add Status-Code SP Reason-Phrase CRLF */
-    length = strlen((char*)aHttpStatusReason[status].pstringValue);
-    FLib_MemCpy(pCrtPos, aHttpStatusReason[status].pstringValue, length);
-    pCrtPos += length;
+/*!*************************************************************************************************
+\private
+\fn     static bool_t HTTP_SendSegments(uint32_t sockIndex, const httpBodySegment_t* pSegments,
+                                        uint32_t nbSegments)
 
-    /* Always add Server header */
-    HTTP_AddHeader(&pCrtPos,
-                   (const char*)mpHttpServer,
-                   (const char*)mpHttpServerToken);
+\brief  This function gathers the pieces of a response and sends them to TCP. There is a single
+        send for a response smaller than mHttpServerTxBufferSize_c. Under MSG_DONTWAIT, send()
+        takes what fits in the TCP send buffer and returns -1 if nothing does: the rest of the
+        response is kept and sent later by HTTP_SendPending(). A socket closed by the peer returns
+        -1 as well, its close is indicated to HTTP_ServerDataIndHandler().
 
-    if(resultSize)
+\param [in]   sockIndex   index of the socket in mpHttpServerCfg->apClientSockTbl
+\param [in]   pSegments   pieces of the response, in order
+\param [in]   nbSegments  number of pieces
+
+\param [out]  none
+
+\retval       TRUE    the response was sent, or kept to be sent
+\retval       FALSE   no memory for the response
+***************************************************************************************************/
+static bool_t HTTP_SendSegments
+(
+    uint32_t sockIndex,
+    const httpBodySegment_t* pSegments,
+    uint32_t nbSegments
+)
+{
+    httpSockInfo_t* pSockInfo = mpHttpServerCfg->apClientSockTbl[sockIndex];
+    uint32_t totalLen = 0U;
+    uint32_t bufferSize = 0U;
+    uint32_t segmentOffset = 0U;
+    uint32_t txLen;
+    uint32_t sentLen;
+    int32_t result;
+    uint32_t iCount;
+    char* pHttpResponse = NULL;
+    bool_t bRetValue = TRUE;
+
+    for(iCount = 0U; iCount < nbSegments; iCount ++)
     {
+        totalLen += pSegments[iCount].length;
+    }
 
-        /* Always add Content Type header */
-        HTTP_AddHeader(&pCrtPos,
-                       (const char*)aHttpContentType.pstringValue,
-                       (const char*)aHttpContentTypeValue[pUriTableEntry->mediaType].pstringValue);
+    if(pSockInfo->pTxBuffer)
+    {
+        /* The responses before are not sent yet, this one goes after them */
+        bRetValue = HTTP_KeepPending(sockIndex, NULL, 0U, pSegments, nbSegments, 0U, totalLen);
+    }
+    else
+    {
+        bufferSize = (totalLen < mHttpServerTxBufferSize_c) ? totalLen : mHttpServerTxBufferSize_c;
+        pHttpResponse = NWKU_MEM_BufferAlloc(bufferSize);
 
-        /* Convert content length to ASCII */
-        HTTP_Uint32ToAscii(resultSize, aItoaContentLen, &itoaContentLen);
+        if(NULL == pHttpResponse)
+        {
+            bRetValue = FALSE;
+        }
+    }
 
-        /* Always add Content Length header */
-        HTTP_AddHeader(&pCrtPos,
-                       (const char*)aHttpContentLength.pstringValue,
-                       (const char*)aItoaContentLen);
+    while(bRetValue && totalLen && (NULL == pSockInfo->pTxBuffer))
+    {
+        /* Gather as much of the response as fits in the buffer */
+        txLen = HTTP_GatherSegments(pHttpResponse, bufferSize, &pSegments, &nbSegments, &segmentOffset);
+        totalLen -= txLen;
 
-        /* Add the last '\r\n' */
-        length = strlen(gpHttpNewLine);
-        FLib_MemCpy(pCrtPos, (void*)gpHttpNewLine, length);
-        pCrtPos += length;
+        result = send(pSockInfo->sockFd, pHttpResponse, txLen, MSG_DONTWAIT);
+        sentLen = (result > 0) ? (uint32_t)result : 0U;
+
+        if(sentLen < txLen)
+        {
+            /* No room in TCP for the rest of the response, keep it */
+            bRetValue = HTTP_KeepPending(sockIndex, pHttpResponse + sentLen, txLen - sentLen,
+                                         pSegments, nbSegments, segmentOffset, totalLen);
+        }
+    }
 
-        /* Add message body */
-        FLib_MemCpy(pCrtPos, pResult, resultSize);
+    if(pHttpResponse)
+    {
+        MEM_BufferFree(pHttpResponse);
+    }
 
-        MEM_BufferFree(pResult);
+    return bRetValue;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static bool_t HTTP_KeepPending(uint32_t sockIndex, const char* pData, uint32_t dataLen,
+                                       const httpBodySegment_t* pSegments, uint32_t nbSegments,
+                                       uint32_t segmentOffset, uint32_t segmentsLen)
+
+\brief  This function keeps the end of a response until TCP has room for it, after the data
+        already kept for the connection. The retries are done by the timer of the idle
+        connections, see HTTP_CheckClients().
+
+\param [in]   sockIndex      index of the socket in mpHttpServerCfg->apClientSockTbl
+\param [in]   pData          gathered part of the response not sent
+\param [in]   dataLen        length of pData
+\param [in]   pSegments      pieces of the response left
+\param [in]   nbSegments     number of pieces left
+\param [in]   segmentOffset  bytes of the first piece already gathered
+\param [in]   segmentsLen    length of the pieces left
+
+\param [out]  none
+
+\retval       TRUE    the data is kept
+\retval       FALSE   no memory for it, or no timer to send it
+***************************************************************************************************/
+static bool_t HTTP_KeepPending
+(
+    uint32_t sockIndex,
+    const char* pData,
+    uint32_t dataLen,
+    const httpBodySegment_t* pSegments,
+    uint32_t nbSegments,
+    uint32_t segmentOffset,
+    uint32_t segmentsLen
+)
+{
+    httpSockInfo_t* pSockInfo = mpHttpServerCfg->apClientSockTbl[sockIndex];
+    uint32_t pendingLen = 0U;
+    char* pTxBuffer = NULL;
+    bool_t bRetValue = FALSE;
 
-        pCrtPos += resultSize;
+    if(pSockInfo->pTxBuffer)
+    {
+        pendingLen = pSockInfo->txLen - pSockInfo->txOffset;
     }
-    else
+
+    if(gTmrInvalidTimerID_c != mpHttpServerCfg->idleTimer)
     {
-        /* Add the last '\r\n' */
-        length = strlen(gpHttpNewLine);
-        FLib_MemCpy(pCrtPos, (void*)gpHttpNewLine, length);
-        pCrtPos += length;
+        pTxBuffer = NWKU_MEM_BufferAlloc(pendingLen + dataLen + segmentsLen);
     }
 
-    /* Send HTTP response to TCP */
-    if(-1 == send(mpHttpServerCfg->apClientSockTbl[sockIndex]->sockFd, pHttpResponse, pCrtPos - pHttpResponse, txFlags))
+    if(pTxBuffer)
     {
-        /* Socket was closed, free the data */
+        if(pSockInfo->pTxBuffer)
+        {
+            FLib_MemCpy(pTxBuffer, pSockInfo->pTxBuffer + pSockInfo->txOffset, pendingLen);
+            MEM_BufferFree(pSockInfo->pTxBuffer);
+        }
+        else
+        {
+            /* First retry, the next ones are scheduled by HTTP_CheckClients() */
+            TMR_StartSingleShotTimer(mpHttpServerCfg->idleTimer, HTTP_SERVER_SEND_RETRY_INTERVAL,
+                                     HTTP_IdleTimerCb, NULL);
+        }
 
-        MEM_BufferFree(mpHttpServerCfg->apClientSockTbl[sockIndex]);
+        if(dataLen)
+        {
+            FLib_MemCpy(pTxBuffer + pendingLen, (void*)pData, dataLen);
+        }
 
-        mpHttpServerCfg->apClientSockTbl[sockIndex] = NULL;
+        (void)HTTP_GatherSegments(pTxBuffer + pendingLen + dataLen, segmentsLen, &pSegments,
+                                  &nbSegments, &segmentOffset);
 
-        mpHttpServerCfg->nbClientSock --;
+        pSockInfo->pTxBuffer = pTxBuffer;
+        pSockInfo->txLen = pendingLen + dataLen + segmentsLen;
+        pSockInfo->txOffset = 0U;
+        bRetValue = TRUE;
     }
 
-    MEM_BufferFree(pHttpResponse);
+    return bRetValue;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static uint32_t HTTP_GatherSegments(char* pDst, uint32_t maxLen,
+                                            const httpBodySegment_t** ppSegments,
+                                            uint32_t* pNbSegments, uint32_t* pSegmentOffset)
+
+\brief  This function copies the next pieces of a response, up to maxLen bytes
+
+\param [in]   pDst            destination
+\param [in]   maxLen          room in pDst
+\param [in]   ppSegments      pieces left, advanced
+\param [in]   pNbSegments     number of pieces left, updated
+\param [in]   pSegmentOffset  bytes of the first piece already copied, updated
+
+\param [out]  none
+
+\retval       bytes copied
+***************************************************************************************************/
+static uint32_t HTTP_GatherSegments
+(
+    char* pDst,
+    uint32_t maxLen,
+    const httpBodySegment_t** ppSegments,
+    uint32_t* pNbSegments,
+    uint32_t* pSegmentOffset
+)
+{
+    uint32_t copiedLen = 0U;
+    uint32_t length;
+
+    while((copiedLen < maxLen) && *pNbSegments)
+    {
+        length = (*ppSegments)->length - *pSegmentOffset;
+
+        if(length > maxLen - copiedLen)
+        {
+            length = maxLen - copiedLen;
+        }
+
+        FLib_MemCpy(pDst + copiedLen, (void*)((*ppSegments)->pData + *pSegmentOffset), length);
+        copiedLen += length;
+        *pSegmentOffset += length;
+
+        if(*pSegmentOffset == (*ppSegments)->length)
+        {
+            (*ppSegments) ++;
+            (*pNbSegments) --;
+            *pSegmentOffset = 0U;
+        }
+    }
 
+    return copiedLen;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void HTTP_SendPending(uint32_t sockIndex)
+
+\brief  This function sends the data kept for a connection, as much as TCP takes. When all of it
+        is sent, the connection is closed if it was to be, otherwise the requests received
+        meanwhile are served.
+
+\param [in]   sockIndex  index of the socket in mpHttpServerCfg->apClientSockTbl
+
+\param [out]  none
+
+\retval       none
+***************************************************************************************************/
+static void HTTP_SendPending
+(
+    uint32_t sockIndex
+)
+{
+    httpSockInfo_t* pSockInfo = mpHttpServerCfg->apClientSockTbl[sockIndex];
+    uint32_t txLen;
+    int32_t result;
+
+    do
+    {
+        txLen = pSockInfo->txLen - pSockInfo->txOffset;
+
+        if(txLen > mHttpServerTxBufferSize_c)
+        {
+            txLen = mHttpServerTxBufferSize_c;
+        }
+
+        result = send(pSockInfo->sockFd, pSockInfo->pTxBuffer + pSockInfo->txOffset, txLen,
+                      MSG_DONTWAIT);
+
+        if(result > 0)
+        {
+            pSockInfo->txOffset += (uint32_t)result;
+            pSockInfo->lastActivityMs = HTTP_GetTimeMs();
+        }
+    } while((result == (int32_t)txLen) && (pSockInfo->txOffset < pSockInfo->txLen));
+
+    if(pSockInfo->txOffset == pSockInfo->txLen)
+    {
+        MEM_BufferFree(pSockInfo->pTxBuffer);
+        pSockInfo->pTxBuffer = NULL;
+
+        if(pSockInfo->bCloseConnection)
+        {
+            HTTP_CloseClient(sockIndex, TRUE);
+        }
+        else if(pSockInfo->rxLen)
+        {
+            HTTP_ServerReceive(sockIndex, pSockInfo->pRxBuffer + pSockInfo->rxLen, 0U);
+        }
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void HTTP_AddSegment(httpBodySegment_t** ppSegment, const void* pData,
+                                    uint32_t length)
+
+\brief  This function adds a piece to a response
+
+\param [in]   ppSegment  pointer to the next free segment, advanced
+\param [in]   pData      pointer to the piece
+\param [in]   length     length of the piece
+
+\param [out]  none
+
+\retval       none
+***************************************************************************************************/
+static void HTTP_AddSegment
+(
+    httpBodySegment_t** ppSegment,
+    const void* pData,
+    uint32_t length
+)
+{
+    (*ppSegment)->pData = (const uint8_t*)pData;
+    (*ppSegment)->length = length;
+    (*ppSegment) ++;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void HTTP_RenderHeaderTemplates(void)
+
+\brief  This function renders the Server, Content-Type and Content-Length headers of each media
+        type. Only the Content-Length value is left for the responses.
+
+\param [in]   none
+
+\param [out]  none
+
+\retval       none
+***************************************************************************************************/
+static void HTTP_RenderHeaderTemplates
+(
+    void
+)
+{
+    uint32_t mediaType;
+    uint32_t length;
+    uint32_t newLineLen = strlen(gpHttpNewLine);
+    char* pTemplate;
+    char* pCrtPos;
+
+    for(mediaType = 0U; mediaType < NumberOfElements(mpHttpServerCfg->aHeaderTemplate); mediaType ++)
+    {
+        /* "Server: <token>\r\n" and "Content-Length: " */
+        length = strlen(mpHttpServer) + 1U + strlen(mpHttpServerToken) + newLineLen +
+                 aHttpContentLength.strLength + 1U;
+
+        if(gHttpUriType_notPresent_c != mediaType)
+        {
+            /* "Content-Type: <media type>\r\n" */
+            length += aHttpContentType.strLength + 1U +
+                      strlen((const char*)aHttpContentTypeValue[mediaType].pstringValue) + newLineLen;
+        }
+
+        pTemplate = NWKU_MEM_BufferAllocForever(length);
+
+        if(pTemplate)
+        {
+            pCrtPos = pTemplate;
+
+            HTTP_AddHeader(&pCrtPos, mpHttpServer, mpHttpServerToken);
+
+            if(gHttpUriType_notPresent_c != mediaType)
+            {
+                HTTP_AddHeader(&pCrtPos,
+                               (const char*)aHttpContentType.pstringValue,
+                               (const char*)aHttpContentTypeValue[mediaType].pstringValue);
+            }
+
+            FLib_MemCpy(pCrtPos, aHttpContentLength.pstringValue, aHttpContentLength.strLength);
+            pCrtPos += aHttpContentLength.strLength;
+            *pCrtPos = ' ';
+            pCrtPos ++;
+
+            mpHttpServerCfg->aHeaderTemplate[mediaType].pstringValue = (uint8_t*)pTemplate;
+            mpHttpServerCfg->aHeaderTemplate[mediaType].strLength = pCrtPos - pTemplate;
+        }
+    }
 }
 
 /*!*************************************************************************************************
@@ -1046,10 +1728,44 @@ static void HTTP_ProcessConnectionHeader
     char* pConnectionValue
 )
 {
-    if(FLib_MemCmp(pConnectionValue, (void*)gpHttpConnectionClose, strlen(gpHttpConnectionClose)))
+    if(HTTP_TokenMatch(pConnectionValue, gpHttpConnectionClose))
     {
          mpHttpServerCfg->apClientSockTbl[sockIndex]->bCloseConnection = TRUE;
     }
+    else if(HTTP_TokenMatch(pConnectionValue, gpHttpConnectionKeepAlive))
+    {
+         mpHttpServerCfg->apClientSockTbl[sockIndex]->bCloseConnection = FALSE;
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static bool_t HTTP_TokenMatch(const char* pValue, const char* pToken)
+
+\brief  This function compares a header token, case insensitive, with a lower case token
+
+\param [in]   pValue  pointer to the received token
+\param [in]   pToken  lower case token
+
+\param [out]  none
+
+\retval       TRUE    the tokens are the same
+\retval       FALSE   otherwise
+***************************************************************************************************/
+static bool_t HTTP_TokenMatch
+(
+    const char* pValue,
+    const char* pToken
+)
+{
+    while(('\0' != *pToken) && (tolower((unsigned char)*pValue) == *pToken))
+    {
+        pValue ++;
+        pToken ++;
+    }
+
+    return (('\0' == *pToken) &&
+            (('\0' == *pValue) || ('\r' == *pValue) || (',' == *pValue) || (' ' == *pValue)));
 }
 
 /*!*************************************************************************************************
@@ -1197,6 +1913,141 @@ static httpStatus_t HTTP_CheckHostname
 
     return httpStatus;
 }
+
+/*!*************************************************************************************************
+\private
+\fn     static void HTTP_StartIdleTimer(void)
+
+\brief  This function starts the timer closing the idle connections, if not running
+
+\param [in]   none
+
+\param [out]  none
+
+\retval       none
+***************************************************************************************************/
+static void HTTP_StartIdleTimer
+(
+    void
+)
+{
+    if((0U != HTTP_SERVER_KEEP_ALIVE_TIMEOUT) &&
+       (gTmrInvalidTimerID_c != mpHttpServerCfg->idleTimer) &&
+       (FALSE == TMR_IsTimerActive(mpHttpServerCfg->idleTimer)))
+    {
+        TMR_StartSingleShotTimer(mpHttpServerCfg->idleTimer, HTTP_SERVER_KEEP_ALIVE_TIMEOUT,
+                                 HTTP_IdleTimerCb, NULL);
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void HTTP_IdleTimerCb(void *param)
+
+\brief  This function is called when the idle connections timer expires
+
+\param [in]   param   not used
+
+\param [out]  none
+
+\retval       none
+***************************************************************************************************/
+static void HTTP_IdleTimerCb
+(
+    void *param
+)
+{
+    (void)param;
+    NWKU_SendMsg(HTTP_CheckClients, NULL, &mThreadStackMsgQueue);
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void HTTP_CheckClients(void *param)
+
+\brief  This function retries the responses waiting for room in TCP and closes the connections
+        without activity for HTTP_SERVER_KEEP_ALIVE_TIMEOUT, or for HTTP_SERVER_SEND_TIMEOUT while
+        a response waits. The timer is restarted for the next retry or expiry.
+
+\param [in]   param   not used
+
+\param [out]  none
+
+\retval       none
+***************************************************************************************************/
+static void HTTP_CheckClients
+(
+    void *param
+)
+{
+    httpSockInfo_t* pSockInfo;
+    uint32_t nextCheckMs = 0U;
+    uint32_t timeoutMs;
+    uint32_t idleMs;
+    uint32_t iCount;
+
+    (void)param;
+
+    for(iCount = 0U; iCount < HTTP_SERVER_CONNECTION_TABLE_SIZE; iCount ++)
+    {
+        if(mpHttpServerCfg->apClientSockTbl[iCount] && mpHttpServerCfg->apClientSockTbl[iCount]->pTxBuffer)
+        {
+            HTTP_SendPending(iCount);
+        }
+
+        /* The connection may have been closed */
+        pSockInfo = mpHttpServerCfg->apClientSockTbl[iCount];
+
+        if(pSockInfo)
+        {
+            timeoutMs = (pSockInfo->pTxBuffer) ? HTTP_SERVER_SEND_TIMEOUT : HTTP_SERVER_KEEP_ALIVE_TIMEOUT;
+            idleMs = HTTP_GetTimeMs() - pSockInfo->lastActivityMs;
+
+            if((0U != timeoutMs) && (idleMs >= timeoutMs))
+            {
+                HTTP_CloseClient(iCount, TRUE);
+            }
+            else
+            {
+                if((0U != timeoutMs) && ((0U == nextCheckMs) || (timeoutMs - idleMs < nextCheckMs)))
+                {
+                    nextCheckMs = timeoutMs - idleMs;
+                }
+
+                if((pSockInfo->pTxBuffer) &&
+                   ((0U == nextCheckMs) || (HTTP_SERVER_SEND_RETRY_INTERVAL < nextCheckMs)))
+                {
+                    nextCheckMs = HTTP_SERVER_SEND_RETRY_INTERVAL;
+                }
+            }
+        }
+    }
+
+    if(nextCheckMs)
+    {
+        TMR_StartSingleShotTimer(mpHttpServerCfg->idleTimer, nextCheckMs, HTTP_IdleTimerCb, NULL);
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static uint32_t HTTP_GetTimeMs(void)
+
+\brief  This function returns the time, in milliseconds
+
+\param [in]   none
+
+\param [out]  none
+
+\retval       time in ms
+***************************************************************************************************/
+static uint32_t HTTP_GetTimeMs
+(
+    void
+)
+{
+    return (uint32_t)(TMR_GetTimestamp() / 1000);
+}
 #endif /* BSDS_STREAM_SUPPORT && TCP_ENABLED */
 /*==================================================================================================
 Private debug functions
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file http_server_link.h
+ * State shared by http_server_test.c and http_server_stubs.c: the clock, the server timer, the
+ * messages posted to the stack task and the buffers in use.
+ */
+
+#ifndef _HTTP_SERVER_LINK_H_
+#define _HTTP_SERVER_LINK_H_
+
+#include <stdint.h>
+
+#define LINK_MAX_MSGS       (256U)
+
+typedef struct
+{
+    /* Clock and the server timer */
+    uint64_t nowUs;
+    int timerOn;
+    uint64_t timerAt;
+    void (*timerCallback)(void *);
+    void *timerParam;
+
+    /* Messages posted to the stack task */
+    struct
+    {
+        void (*handler)(void *);
+        void *param;
+    } msgs[LINK_MAX_MSGS];
+    uint32_t msgHead;
+    uint32_t msgTail;
+
+    /* Buffers allocated and not freed */
+    int32_t buffers;
+} link_t;
+
+extern link_t gLink;
+
+#endif
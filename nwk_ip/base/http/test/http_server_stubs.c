@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file http_server_stubs.c
+ * Host test stubs of the timers, messaging, memory and session services used by the HTTP server.
+ * Built apart from the server, without the stack headers. The client sockets are in
+ * http_server_test.c.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_server_link.h"
+
+link_t gLink;
+
+/*****************************************************************************
+ * Timers (one timer, the server's)
+ ****************************************************************************/
+typedef uint8_t bool_t;
+
+const uint8_t gUseRtos_c = 0;
+
+uint8_t TMR_AllocateTimer(void)
+{
+    return 1;
+}
+
+int TMR_StartSingleShotTimer(uint8_t id, uint32_t ms, void (*callback)(void *), void *param)
+{
+    (void)id;
+    gLink.timerAt = gLink.nowUs + (uint64_t)ms * 1000U;
+    gLink.timerOn = 1;
+    gLink.timerCallback = callback;
+    gLink.timerParam = param;
+    return 0;
+}
+
+bool_t TMR_IsTimerActive(uint8_t id)
+{
+    (void)id;
+    return (bool_t)gLink.timerOn;
+}
+
+uint64_t TMR_GetTimestamp(void)
+{
+    return gLink.nowUs;
+}
+
+/*****************************************************************************
+ * Messaging, memory and helpers
+ ****************************************************************************/
+uint8_t gNwkPoolId;
+uint8_t mThreadStackMsgQueue[64];
+
+bool_t NWKU_SendMsg(void (*handler)(void *), void *param, void *queue)
+{
+    (void)queue;
+    gLink.msgs[gLink.msgTail].handler = handler;
+    gLink.msgs[gLink.msgTail].param = param;
+    gLink.msgTail = (gLink.msgTail + 1U) % LINK_MAX_MSGS;
+    return 1;
+}
+
+void *MEM_BufferAllocWithId(uint32_t size, uint8_t poolId, void *pCaller)
+{
+    (void)poolId;
+    (void)pCaller;
+    gLink.buffers++;
+    return malloc(size);
+}
+
+int MEM_BufferFree(void *buffer)
+{
+    if (buffer != NULL)
+    {
+        gLink.buffers--;
+    }
+    free(buffer);
+    return 0;
+}
+
+void FLib_MemCpy(void *pDst, const void *pSrc, uint32_t size)
+{
+    memmove(pDst, pSrc, size);
+}
+
+void FLib_MemSet(void *pData, uint8_t value, uint32_t size)
+{
+    memset(pData, value, size);
+}
+
+/* As with gUseToolchainMemFunc_d 0 */
+bool_t FLib_MemCmp(const void *pData1, const void *pData2, uint32_t size)
+{
+    const uint8_t *p1 = pData1;
+    const uint8_t *p2 = pData2;
+
+    while (size--)
+    {
+        if (*p1++ != *p2++)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*****************************************************************************
+ * Stack services used when the server starts
+ ****************************************************************************/
+const uint8_t in6addr_any[16];
+const uint8_t inaddr_any[16];
+
+int32_t socket(int32_t domain, int32_t type, int32_t protocol)
+{
+    (void)domain;
+    (void)type;
+    (void)protocol;
+    return 3;
+}
+
+int32_t bind(int32_t sockfd, void *pAddr, uint32_t addrLen)
+{
+    (void)sockfd;
+    (void)pAddr;
+    (void)addrLen;
+    return 0;
+}
+
+int32_t listen(int32_t sockfd, int32_t backlog)
+{
+    (void)sockfd;
+    (void)backlog;
+    return 0;
+}
+
+void Session_Init(void)
+{
+}
+
+void Session_RegisterCb(int32_t sockfd, void (*callback)(void *), void *queue)
+{
+    (void)sockfd;
+    (void)callback;
+    (void)queue;
+}
+
+void ListInit(void *pList, uint32_t max)
+{
+    (void)pList;
+    (void)max;
+}
+
+void *OSA_TaskCreate(void *pThreadDef, void *param)
+{
+    (void)pThreadDef;
+    (void)param;
+    return (void *)1;
+}
+
+/* Host names only, the addresses in the Host header are not resolved */
+int32_t pton(uint8_t family, char *pStr, void *pAddr)
+{
+    (void)family;
+    (void)pStr;
+    (void)pAddr;
+    return 0;
+}
+
+void *IP_IF_GetIfByAddr(void *pAddr)
+{
+    (void)pAddr;
+    return NULL;
+}
@@ -0,0 +1,697 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file http_server_test.c
+ * Host socket-level test of the HTTP server. The server sources and the sensor snapshot application
+ * are built in and driven as the session task would: connections are accepted, data indications
+ * are delivered in pieces cut anywhere, and the responses are parsed back from what the server
+ * sent. The sends can be cut short or refused, as MSG_DONTWAIT does when the TCP send buffer is
+ * full. The requests per second are then measured on the host, and modelled over the mesh.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include "../http_server.c"
+#include "../http.c"
+#include "../../../src/common/app_http_server.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "http_server_link.h"
+
+osaThreadDef_t os_thread_def_HTTP_AcceptTask;
+
+/*****************************************************************************
+ * Client sockets: what the server sends is kept per socket
+ ****************************************************************************/
+#define MAX_FD          (16)
+
+typedef struct
+{
+    char *pOut;
+    size_t outLen;
+    size_t outCap;
+    size_t readPos;
+    int closed;
+    uint32_t sends;
+    uint32_t sendLimit;         /* Most bytes taken by a send, 0 for all */
+    uint32_t sendRefusals;      /* Next sends returning -1 */
+} client_t;
+
+static client_t sClients[MAX_FD];
+static int32_t sPendingFd = -1;
+static uint64_t sSendCalls;
+
+int32_t accept(int32_t sockfd, sockaddrStorage_t *pAddr, uint32_t addrLen)
+{
+    int32_t fd = sPendingFd;
+
+    (void)sockfd;
+    (void)addrLen;
+    memset(pAddr, 0, sizeof(*pAddr));
+    sPendingFd = -1;
+    return fd;
+}
+
+int32_t send(int32_t sockfd, void *pMsg, uint32_t len, uint32_t flags)
+{
+    client_t *pClient = &sClients[sockfd];
+
+    (void)flags;
+    sSendCalls++;
+    if (pClient->closed)
+    {
+        return -1;
+    }
+    if (pClient->sendRefusals)
+    {
+        pClient->sendRefusals--;
+        return -1;
+    }
+    if (pClient->sendLimit && (len > pClient->sendLimit))
+    {
+        len = pClient->sendLimit;
+    }
+    if (pClient->outLen + len > pClient->outCap)
+    {
+        pClient->outCap = (pClient->outLen + len) * 2;
+        pClient->pOut = realloc(pClient->pOut, pClient->outCap);
+    }
+    memcpy(pClient->pOut + pClient->outLen, pMsg, len);
+    pClient->outLen += len;
+    pClient->sends++;
+    return (int32_t)len;
+}
+
+int32_t shutdown(int32_t sockfd, int32_t how)
+{
+    (void)how;
+    sClients[sockfd].closed = 1;
+    return 0;
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+#define GET(path)   "GET " path " HTTP/1.1\r\nHost: station\r\nUser-Agent: dash\r\n\r\n"
+
+static void RunMsgs(void)
+{
+    while (gLink.msgHead != gLink.msgTail)
+    {
+        uint32_t head = gLink.msgHead;
+
+        gLink.msgHead = (head + 1U) % LINK_MAX_MSGS;
+        gLink.msgs[head].handler(gLink.msgs[head].param);
+    }
+}
+
+static void Advance(uint32_t ms)
+{
+    gLink.nowUs += (uint64_t)ms * 1000U;
+    if (gLink.timerOn && (gLink.timerAt <= gLink.nowUs))
+    {
+        gLink.timerOn = 0;
+        gLink.timerCallback(gLink.timerParam);
+    }
+    RunMsgs();
+}
+
+/* Advances the clock by ms, one server timer expiry at a time */
+static void AdvanceBy(uint32_t ms)
+{
+    uint64_t end = gLink.nowUs + (uint64_t)ms * 1000U;
+
+    while (gLink.timerOn && (gLink.timerAt <= end))
+    {
+        gLink.nowUs = gLink.timerAt;
+        gLink.timerOn = 0;
+        gLink.timerCallback(gLink.timerParam);
+        RunMsgs();
+    }
+    gLink.nowUs = end;
+}
+
+static void Connect(int32_t fd)
+{
+    client_t *pClient = &sClients[fd];
+
+    pClient->closed = 0;
+    pClient->outLen = 0;
+    pClient->readPos = 0;
+    pClient->sends = 0;
+    pClient->sendLimit = 0;
+    pClient->sendRefusals = 0;
+    sPendingFd = fd;
+    HTTP_AcceptTask(0);
+}
+
+static void Deliver(int32_t fd, const char *pData, uint32_t len)
+{
+    sessionPacket_t *pPacket = MEM_BufferAllocWithId(sizeof(*pPacket), 0, NULL);
+
+    pPacket->sockFd = fd;
+    pPacket->dataLen = len;
+    pPacket->pData = MEM_BufferAllocWithId(len + 1U, 0, NULL);
+    memcpy(pPacket->pData, pData, len);
+    HTTP_ServerDataIndHandler(pPacket);
+}
+
+static void DeliverString(int32_t fd, const char *pData)
+{
+    Deliver(fd, pData, (uint32_t)strlen(pData));
+}
+
+static void PeerClose(int32_t fd)
+{
+    sessionPacket_t *pPacket = MEM_BufferAllocWithId(sizeof(*pPacket), 0, NULL);
+
+    pPacket->sockFd = fd;
+    pPacket->dataLen = 0;
+    pPacket->pData = MEM_BufferAllocWithId(1U, 0, NULL);
+    HTTP_ServerDataIndHandler(pPacket);
+}
+
+static int IsOpen(int32_t fd)
+{
+    return HTTP_GetEntryClientSocketTbl(fd) < HTTP_SERVER_CONNECTION_TABLE_SIZE;
+}
+
+static int IsPending(int32_t fd)
+{
+    return IsOpen(fd) && (mpHttpServerCfg->apClientSockTbl[HTTP_GetEntryClientSocketTbl(fd)]->pTxBuffer != NULL);
+}
+
+/* Client side: the next complete response sent on fd, the body is not expected for HEAD */
+typedef struct
+{
+    int code;
+    long contentLength;
+    char connection[16];
+    char contentType[16];
+    char body[4096];
+} response_t;
+
+static int NextResponse(int32_t fd, response_t *pRsp, int head)
+{
+    client_t *pClient = &sClients[fd];
+    char *p = pClient->pOut + pClient->readPos;
+    char *pEnd = pClient->pOut + pClient->outLen;
+    char *pHeaderEnd;
+    char *pLine;
+
+    memset(pRsp, 0, sizeof(*pRsp));
+    pRsp->contentLength = -1;
+    if (p >= pEnd)
+    {
+        return 0;
+    }
+    pHeaderEnd = memmem(p, pEnd - p, "\r\n\r\n", 4);
+    if (pHeaderEnd == NULL)
+    {
+        return 0;
+    }
+    CHECK(sscanf(p, "HTTP/1.%*d %d", &pRsp->code) == 1);
+    for (pLine = strstr(p, "\r\n") + 2; pLine < pHeaderEnd + 2; pLine = strstr(pLine, "\r\n") + 2)
+    {
+        if (strncmp(pLine, "Content-Length: ", 16) == 0)
+        {
+            pRsp->contentLength = atol(pLine + 16);
+        }
+        if (strncmp(pLine, "Connection: ", 12) == 0)
+        {
+            sscanf(pLine + 12, "%15[^\r]", pRsp->connection);
+        }
+        if (strncmp(pLine, "Content-Type: ", 14) == 0)
+        {
+            sscanf(pLine + 14, "%15[^\r]", pRsp->contentType);
+        }
+    }
+    CHECK(pRsp->contentLength >= 0);
+    p = pHeaderEnd + 4;
+    if (!head)
+    {
+        if (pEnd - p < pRsp->contentLength)
+        {
+            return 0;
+        }
+        CHECK(pRsp->contentLength < (long)sizeof(pRsp->body));
+        memcpy(pRsp->body, p, pRsp->contentLength);
+        p += pRsp->contentLength;
+    }
+    pClient->readPos = p - pClient->pOut;
+    return 1;
+}
+
+static int AllRead(int32_t fd)
+{
+    return sClients[fd].readPos == sClients[fd].outLen;
+}
+
+/*****************************************************************************
+ * Resources: the sensor snapshot of the application, a page, a large body and a script
+ ****************************************************************************/
+static const char sPage[] = "<html>station</html>";
+static char sBig[3000];
+
+static uint32_t BigBody(void *pUriContent, httpBodySegment_t *pSegments, uint32_t maxSegments)
+{
+    (void)pUriContent;
+    (void)maxSegments;
+    pSegments[0].pData = (uint8_t *)sBig;
+    pSegments[0].length = 1000;
+    pSegments[1].pData = (uint8_t *)sBig + 1000;
+    pSegments[1].length = 2000;
+    return 2;
+}
+
+static char *Script(char *pData)
+{
+    char *pResult = MEM_BufferAllocWithId(32, 0, NULL);
+
+    (void)pData;
+    strcpy(pResult, "dynamic");
+    return pResult;
+}
+
+static const uriTableEntry_t sUris[] =
+{
+    {(uint8_t *)"/sensors", gHttpUriType_textplain_c, NULL, NULL, NULL, APP_HttpSensorsBody},
+    {(uint8_t *)"/b", gHttpUriType_textplain_c, NULL, NULL, NULL, BigBody},
+    {(uint8_t *)"/d", gHttpUriType_texthtml_c, NULL, NULL, Script, NULL},
+    {(uint8_t *)"/", gHttpUriType_texthtml_c, (void *)sPage, NULL, NULL, NULL},
+};
+
+static void SetSnapshot(uint8_t flags, int32_t temperature, int32_t humidity, int32_t pressure, int32_t light)
+{
+    appHttpSnapshot_t snapshot;
+
+    snapshot.flags = flags;
+    snapshot.temperature = temperature;
+    snapshot.humidity = humidity;
+    snapshot.pressure = pressure;
+    snapshot.ambientLight = light;
+    APP_HttpServerSetSnapshot(&snapshot);
+}
+
+#define ALL_VALID   (gAppHttpTemperatureValid_c | gAppHttpHumidityValid_c | gAppHttpPressureValid_c | \
+                     gAppHttpAmbientLightValid_c)
+#define SNAPSHOT    "{\"temperature\":21.50,\"humidity\":40.20,\"pressure\":1013,\"light\":312.07}"
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* The snapshot is rendered once and gathered into each response */
+static void TestSensors(void)
+{
+    response_t rsp;
+
+    Connect(4);
+    SetSnapshot(ALL_VALID, 2150, 4020, 1013, 31207);
+    DeliverString(4, GET("/sensors"));
+    CHECK(NextResponse(4, &rsp, 0));
+    CHECK((rsp.code == 200) && (strcmp(rsp.body, SNAPSHOT) == 0) && (strcmp(rsp.contentType, "text/plain") == 0));
+
+    SetSnapshot(gAppHttpTemperatureValid_c | gAppHttpAmbientLightValid_c, -105, 0, 0, 5);
+    DeliverString(4, GET("/sensors"));
+    CHECK(NextResponse(4, &rsp, 0));
+    CHECK(strcmp(rsp.body, "{\"temperature\":-1.05,\"humidity\":null,\"pressure\":null,\"light\":0.05}") == 0);
+
+    SetSnapshot(ALL_VALID, INT32_MIN, 0, INT32_MAX, -1);
+    DeliverString(4, GET("/sensors"));
+    CHECK(NextResponse(4, &rsp, 0));
+    CHECK(strcmp(rsp.body, "{\"temperature\":-21474836.48,\"humidity\":0.00,\"pressure\":2147483647,\"light\":-0.01}") == 0);
+
+    SetSnapshot(ALL_VALID, 2150, 4020, 1013, 31207);
+    PeerClose(4);
+    printf("  /sensors: the snapshot texts gathered in 8 pieces, null for the missing readings\n");
+}
+
+/* Sequential requests on one connection, up to HTTP_SERVER_KEEP_ALIVE_MAX_REQUESTS */
+static void TestKeepAlive(void)
+{
+    response_t rsp;
+    uint32_t i;
+
+    Connect(5);
+    for (i = 0; i < HTTP_SERVER_KEEP_ALIVE_MAX_REQUESTS - 1U; i++)
+    {
+        DeliverString(5, GET("/sensors"));
+        CHECK(NextResponse(5, &rsp, 0));
+        CHECK((rsp.code == 200) && (strcmp(rsp.body, SNAPSHOT) == 0) && (strcmp(rsp.connection, "keep-alive") == 0));
+        CHECK(IsOpen(5));
+        Advance(1000);
+    }
+    CHECK(sClients[5].sends == HTTP_SERVER_KEEP_ALIVE_MAX_REQUESTS - 1U);
+    DeliverString(5, GET("/sensors"));
+    CHECK(NextResponse(5, &rsp, 0));
+    CHECK((strcmp(rsp.connection, "close") == 0) && !IsOpen(5) && sClients[5].closed);
+    printf("  %u sequential requests on one connection: one send each, closed after the last one\n",
+           HTTP_SERVER_KEEP_ALIVE_MAX_REQUESTS);
+}
+
+/* Pipelined GET, POST and HEAD requests, delivered in pieces cut anywhere */
+static void TestPipelining(void)
+{
+    static const char *const requests[] =
+    {
+        GET("/sensors"),
+        GET("/"),
+        "POST /d HTTP/1.1\r\nHost: station\r\nContent-Length: 11\r\n\r\nhello world",
+        "HEAD /sensors HTTP/1.1\r\nHost: station\r\n\r\n"
+    };
+    char stream[8192];
+    int kinds[16];
+    response_t rsp;
+    size_t length;
+    size_t pos;
+    size_t piece;
+    int batch;
+    int count;
+    int i;
+
+    for (batch = 0; batch < 2000; batch++)
+    {
+        Connect(6);
+        length = 0;
+        count = 1 + rand() % 12;
+        for (i = 0; i < count; i++)
+        {
+            kinds[i] = rand() % 4;
+            if (rand() % 3 == 0)
+            {
+                /* Empty line before a request */
+                memcpy(stream + length, "\r\n", 2);
+                length += 2;
+            }
+            memcpy(stream + length, requests[kinds[i]], strlen(requests[kinds[i]]));
+            length += strlen(requests[kinds[i]]);
+        }
+        for (pos = 0; pos < length; pos += piece)
+        {
+            piece = 1 + rand() % 200;
+            piece = (piece > length - pos) ? (length - pos) : piece;
+            Deliver(6, stream + pos, (uint32_t)piece);
+        }
+        for (i = 0; i < count; i++)
+        {
+            CHECK(NextResponse(6, &rsp, kinds[i] == 3));
+            CHECK(rsp.code == 200);
+            if (kinds[i] == 0)
+            {
+                CHECK(strcmp(rsp.body, SNAPSHOT) == 0);
+            }
+            else if (kinds[i] == 1)
+            {
+                CHECK((strcmp(rsp.body, sPage) == 0) && (strcmp(rsp.contentType, "text/html") == 0));
+            }
+            else if (kinds[i] == 2)
+            {
+                CHECK(strcmp(rsp.body, "dynamic") == 0);
+            }
+            else
+            {
+                CHECK(rsp.contentLength == (long)strlen(SNAPSHOT));
+            }
+        }
+        CHECK(AllRead(6) && IsOpen(6));
+        PeerClose(6);
+        CHECK(!IsOpen(6));
+    }
+    printf("  2000 batches of 1-12 pipelined GET/POST/HEAD requests, cut at random: answered in order\n");
+}
+
+/* Persistent connections by version and Connection header, other statuses */
+static void TestConnectionRules(void)
+{
+    response_t rsp;
+    size_t outLen;
+
+    Connect(7);
+    DeliverString(7, "GET / HTTP/1.0\r\n\r\n");
+    CHECK(NextResponse(7, &rsp, 0));
+    CHECK((strcmp(rsp.connection, "close") == 0) && !IsOpen(7));
+
+    Connect(7);
+    DeliverString(7, "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n");
+    CHECK(NextResponse(7, &rsp, 0));
+    CHECK((strcmp(rsp.connection, "keep-alive") == 0) && IsOpen(7));
+    DeliverString(7, "GET / HTTP/1.1\r\nConnection: close\r\n\r\n");
+    CHECK(NextResponse(7, &rsp, 0));
+    CHECK((strcmp(rsp.connection, "close") == 0) && !IsOpen(7));
+
+    Connect(7);
+    DeliverString(7, GET("/nothere"));
+    CHECK(NextResponse(7, &rsp, 0));
+    CHECK((rsp.code == 404) && (rsp.contentLength == 0) && IsOpen(7));
+    outLen = sClients[7].outLen;
+    DeliverString(7, GET("/b"));
+    CHECK(NextResponse(7, &rsp, 0));
+    CHECK((rsp.contentLength == 3000) && (rsp.body[999] == 'A') && (rsp.body[2999] == 'B'));
+    outLen = sClients[7].outLen - outLen;
+    CHECK(sClients[7].sends == 1 + (outLen + mHttpServerTxBufferSize_c - 1) / mHttpServerTxBufferSize_c);
+    printf("  HTTP/1.0 closed unless keep-alive, \"close\" honoured, 404 keeps the connection, 3000 B body in %u B sends\n",
+           mHttpServerTxBufferSize_c);
+}
+
+/* Header block too large, connection table full, idle connections */
+static void TestLimits(void)
+{
+    char block[1000];
+    response_t rsp;
+
+    memset(block, 'a', sizeof(block));
+    block[0] = 'G';
+    Deliver(7, block, sizeof(block));
+    CHECK(IsOpen(7));
+    Deliver(7, block, sizeof(block));
+    CHECK(NextResponse(7, &rsp, 0));
+    CHECK((rsp.code == 413) && !IsOpen(7));
+
+    Connect(8);
+    Connect(9);
+    Connect(10);
+    CHECK(sClients[10].closed && !IsOpen(10));
+
+    DeliverString(8, GET("/"));
+    AdvanceBy(10000);
+    Deliver(9, "GET / HT", 8);
+    AdvanceBy(5000);
+    CHECK(!IsOpen(8) && sClients[8].closed && IsOpen(9));
+    AdvanceBy(9000);
+    CHECK(IsOpen(9));
+    AdvanceBy(1000);
+    CHECK(!IsOpen(9) && !gLink.timerOn);
+    printf("  413 and close on a 2000 B header block, 3rd client refused, idle connections closed after %u ms\n",
+           HTTP_SERVER_KEEP_ALIVE_TIMEOUT);
+}
+
+/* Sends cut short or refused: the rest is kept, retried and followed by the next responses */
+static void TestBlockedSends(void)
+{
+    response_t rsp;
+    uint32_t ticks;
+
+    /* A 3 kB response through a TCP buffer taking 100 B at a time */
+    Connect(11);
+    sClients[11].sendLimit = 100;
+    DeliverString(11, GET("/b"));
+    CHECK(IsPending(11) && (sClients[11].outLen == 100) && !NextResponse(11, &rsp, 0));
+    for (ticks = 0; IsPending(11) && (ticks < 100); ticks++)
+    {
+        AdvanceBy(HTTP_SERVER_SEND_RETRY_INTERVAL);
+    }
+    CHECK(!IsPending(11) && NextResponse(11, &rsp, 0));
+    CHECK((rsp.contentLength == 3000) && (rsp.body[999] == 'A') && (rsp.body[2999] == 'B') && AllRead(11));
+    printf("  3000 B body through 100 B sends: completed in %u retries\n", ticks);
+
+    /* Pipelined requests behind a refused response, and a request received meanwhile */
+    sClients[11].sendLimit = 0;
+    sClients[11].sendRefusals = 3;
+    Deliver(11, GET("/sensors") GET("/") GET("/d"), (uint32_t)strlen(GET("/sensors") GET("/") GET("/d")));
+    CHECK(IsPending(11) && (sClients[11].outLen == sClients[11].readPos));
+    AdvanceBy(HTTP_SERVER_SEND_RETRY_INTERVAL);
+    CHECK(IsPending(11));
+    DeliverString(11, "HEAD / HTTP/1.1\r\nHost: station\r\n\r\n");
+    AdvanceBy(HTTP_SERVER_SEND_RETRY_INTERVAL);
+    CHECK(IsPending(11));
+    AdvanceBy(HTTP_SERVER_SEND_RETRY_INTERVAL);
+    CHECK(!IsPending(11));
+    CHECK(NextResponse(11, &rsp, 0) && (strcmp(rsp.body, SNAPSHOT) == 0));
+    CHECK(NextResponse(11, &rsp, 0) && (strcmp(rsp.body, sPage) == 0));
+    CHECK(NextResponse(11, &rsp, 0) && (strcmp(rsp.body, "dynamic") == 0));
+    CHECK(NextResponse(11, &rsp, 1) && (rsp.contentLength == (long)strlen(sPage)) && AllRead(11) && IsOpen(11));
+
+    /* "Connection: close" waits for the response to be sent */
+    sClients[11].sendRefusals = 2;
+    DeliverString(11, "GET / HTTP/1.1\r\nHost: station\r\nConnection: close\r\n\r\n");
+    CHECK(IsOpen(11) && !sClients[11].closed);
+    AdvanceBy(2 * HTTP_SERVER_SEND_RETRY_INTERVAL);
+    CHECK(!IsOpen(11) && sClients[11].closed);
+    CHECK(NextResponse(11, &rsp, 0) && (strcmp(rsp.connection, "close") == 0) && AllRead(11));
+    printf("  refused sends: the pipelined responses follow in order, \"close\" after the last byte\n");
+
+    /* A peer that never takes anything is dropped */
+    Connect(12);
+    sClients[12].sendRefusals = 0xFFFFFFFFU;
+    DeliverString(12, GET("/sensors"));
+    AdvanceBy(HTTP_SERVER_SEND_TIMEOUT - HTTP_SERVER_SEND_RETRY_INTERVAL);
+    CHECK(IsPending(12));
+    AdvanceBy(HTTP_SERVER_SEND_RETRY_INTERVAL);
+    CHECK(!IsOpen(12) && sClients[12].closed && !gLink.timerOn);
+
+    /* The peer closes with a response kept */
+    Connect(12);
+    sClients[12].sendRefusals = 0xFFFFFFFFU;
+    DeliverString(12, GET("/b"));
+    CHECK(IsPending(12));
+    PeerClose(12);
+    CHECK(!IsOpen(12));
+    AdvanceBy(HTTP_SERVER_SEND_TIMEOUT);
+    printf("  response not taken for %u ms, or peer closed: connection freed\n", HTTP_SERVER_SEND_TIMEOUT);
+}
+
+/* Requests per second: server CPU on the host, then a model of the mesh */
+static void Benchmark(void)
+{
+    const char *pRequest = GET("/sensors");
+    static const char closeRequest[] = "GET /sensors HTTP/1.1\r\nHost: station\r\nUser-Agent: dash\r\nConnection: close\r\n\r\n";
+    uint32_t requestLen = (uint32_t)strlen(pRequest);
+    const uint32_t n = 200000;
+    char pipelined[1024];
+    double keepAlive;
+    double reconnect;
+    double pipelining;
+    uint64_t sends;
+    clock_t start;
+    uint32_t i;
+
+    for (i = 0; i < 8; i++)
+    {
+        memcpy(pipelined + i * requestLen, pRequest, requestLen);
+    }
+
+    sends = sSendCalls;
+    start = clock();
+    for (i = 0; i < n; i++)
+    {
+        if (i % (HTTP_SERVER_KEEP_ALIVE_MAX_REQUESTS - 1U) == 0)
+        {
+            if (IsOpen(13))
+            {
+                PeerClose(13);
+            }
+            Connect(13);
+        }
+        sClients[13].outLen = 0;
+        sClients[13].readPos = 0;
+        Deliver(13, pRequest, requestLen);
+    }
+    keepAlive = n / ((double)(clock() - start) / CLOCKS_PER_SEC);
+    CHECK(sSendCalls - sends == n);
+    PeerClose(13);
+
+    sends = sSendCalls;
+    start = clock();
+    for (i = 0; i < n; i++)
+    {
+        Connect(13);
+        Deliver(13, closeRequest, sizeof(closeRequest) - 1);
+    }
+    reconnect = n / ((double)(clock() - start) / CLOCKS_PER_SEC);
+    CHECK((sSendCalls - sends == n) && !IsOpen(13));
+
+    sends = sSendCalls;
+    start = clock();
+    for (i = 0; i < n / 8; i++)
+    {
+        if (i % 12 == 0)
+        {
+            if (IsOpen(13))
+            {
+                PeerClose(13);
+            }
+            Connect(13);
+        }
+        sClients[13].outLen = 0;
+        sClients[13].readPos = 0;
+        Deliver(13, pipelined, 8 * requestLen);
+    }
+    pipelining = n / ((double)(clock() - start) / CLOCKS_PER_SEC);
+    CHECK(sSendCalls - sends == n);
+    PeerClose(13);
+    printf("  host CPU: keep-alive %.0f req/s, connection per request %.0f req/s, pipelined x8 %.0f req/s\n",
+           keepAlive, reconnect, pipelining);
+
+    /* Store and forward over HOPS hops, one frame on the air at a time, FRAME_MS per frame and
+       hop, FRAME_PAYLOAD bytes of TCP payload per 802.15.4 frame, a control segment takes one
+       frame. The dashboard is WAN_MS away from the border router, per round trip. */
+    {
+#define HOPS            3
+#define FRAME_MS        5.0
+#define FRAME_PAYLOAD   60
+        static const double wanMs[] = {0.0, 80.0};
+        uint32_t responseLen;
+        double requestFrames;
+        double responseFrames;
+        double tKeepAlive;
+        double tReconnect;
+        double tPipelined;
+
+        Connect(13);
+        Deliver(13, pRequest, requestLen);
+        responseLen = (uint32_t)sClients[13].outLen;
+        PeerClose(13);
+
+        requestFrames = (requestLen + FRAME_PAYLOAD - 1) / FRAME_PAYLOAD;
+        responseFrames = (responseLen + FRAME_PAYLOAD - 1) / FRAME_PAYLOAD;
+        for (i = 0; i < 2; i++)
+        {
+            tKeepAlive = (requestFrames + responseFrames) * HOPS * FRAME_MS + wanMs[i];
+            /* SYN, SYN-ACK, and FIN, ACK each way */
+            tReconnect = (requestFrames + responseFrames + 6) * HOPS * FRAME_MS + 2 * wanMs[i];
+            tPipelined = (((8 * requestLen + FRAME_PAYLOAD - 1) / FRAME_PAYLOAD + 8 * responseFrames) * HOPS * FRAME_MS +
+                          wanMs[i]) / 8;
+            printf("  mesh model, %u B request, %u B response, %d hops, WAN RTT %3.0f ms: connection per request "
+                   "%.1f req/s, keep-alive %.1f req/s, pipelined x8 %.1f req/s\n",
+                   requestLen, responseLen, HOPS, wanMs[i], 1000 / tReconnect, 1000 / tKeepAlive, 1000 / tPipelined);
+        }
+    }
+}
+
+int main(void)
+{
+    int32_t buffers;
+
+    srand(1);
+    memset(sBig, 'x', sizeof(sBig));
+    sBig[999] = 'A';
+    sBig[2999] = 'B';
+
+    APP_HttpServerSetSnapshot(&(appHttpSnapshot_t){0});
+    CHECK(HTTP_StartServer(sUris, NumberOfElements(sUris), 80, FALSE, gHttpServerTypeIpv6Only_c, "station"));
+    buffers = gLink.buffers;
+
+    TestSensors();
+    TestKeepAlive();
+    TestPipelining();
+    TestConnectionRules();
+    TestLimits();
+    TestBlockedSends();
+    CHECK(gLink.buffers == buffers);
+    printf("  no buffer left allocated\n");
+
+    Benchmark();
+
+    printf("HTTP server: all tests passed\n");
+    return 0;
+}
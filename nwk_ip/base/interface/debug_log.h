@@ -40,6 +40,9 @@ Include Files
 #include "EmbeddedTypes.h"
 #include <stddef.h>
 #include <stdarg.h>
+#if DEBUG_LOG
+#include "DeferredLog.h"
+#endif
 /*==================================================================================================
 Public macros
 ==================================================================================================*/
@@ -101,7 +104,13 @@ void DBG_PrintLog( bool_t printTimeStamp, uint8_t* pString,
                    uint8_t* pBuf, size_t buflen);
 void DBG_PrintTimeStamp(void);
 void DBG_HexDump(uint8_t *pBuf, uint16_t buflen);
+#if gDLogEnabled_d
+/* Stored as a deferred record: the format string must be a literal and at most
+   gDLogMaxArgs_c integer or pointer arguments are allowed */
+#define DBG_Printf(...) DLOG_PRINTF(__VA_ARGS__)
+#else
 void DBG_Printf(char * format,...);
+#endif
 void DBG_WriteString(uint8_t* pBuf);
 void DBG_PrintNBytes(uint8_t* pBuff, uint16_t n);
 void DBG_MEMBufferCheck(uint8_t *p, uint32_t size);
@@ -125,6 +125,18 @@ typedef httpStatus_t (*pHttpQueryFunction_t)(uint32_t nbQuery, httpQuery_t* pQue
 
 typedef char* (*pHttpScriptFunction_t)(char *pData);
 
+/* Piece of a response body, sent in place */
+typedef struct httpBodySegment_tag
+{
+    const uint8_t* pData;
+    uint32_t       length;
+}httpBodySegment_t;
+
+/* Describes the body as up to maxSegments pieces (e.g. fixed text and the values of a sensor
+   snapshot) and returns their number. The pieces must stay valid until the next call. */
+typedef uint32_t (*pHttpBodyFunction_t)(void *pUriContent, httpBodySegment_t* pSegments,
+                                        uint32_t maxSegments);
+
 typedef struct uriTableEntry_tag
 {
     uint8_t*              pRequestUri;
@@ -134,6 +146,7 @@ typedef struct uriTableEntry_tag
     //uint32_t              uriContentLen;
     pHttpQueryFunction_t  pQueryFunction; //Query function with query string
     pHttpScriptFunction_t pHttpScriptFunction; // Used for updating dinamic data
+    pHttpBodyFunction_t   pHttpBodyFunction; // Dynamic data sent without being copied
 }uriTableEntry_t;
 
 
@@ -176,6 +189,7 @@ extern const char* gapHttpAcceptMediaRange[1];
 extern const char* gpHttpConnection;
 extern const httpString_t aHttpContentTypeRange[1];
 extern const char* gpHttpConnectionClose;
+extern const char* gpHttpConnectionKeepAlive;
 
 /*==================================================================================================
 Public function prototypes
@@ -46,6 +46,18 @@ Include Files
 Public macros
 ==================================================================================================*/
 
+/*! Saves of the same dataset element requested within this window, in milliseconds, are
+    written to flash once. The security datasets are not delayed. */
+#ifndef NVNG_SAVE_WINDOW_MS
+    #define NVNG_SAVE_WINDOW_MS         2000
+#endif
+
+/*! Size of the dirty element bitmaps, in 32 bit words, shared by all the datasets. A dataset
+    that does not fit is saved whole. */
+#ifndef NVNG_DIRTY_BITMAP_WORDS
+    #define NVNG_DIRTY_BITMAP_WORDS     64
+#endif
+
 /*==================================================================================================
 Public type definitions
 ==================================================================================================*/
@@ -55,10 +67,20 @@ typedef enum nvngErrCode_tag{
     gNVNGFail_c
 }nvngErrCode_t;
 
+/*! Save counters of a dataset */
+typedef struct nvngSaveCount_tag
+{
+    uint32_t requested;     /*!< Element saves requested by the stack */
+    uint32_t written;       /*!< Element or dataset saves passed to the NVM module */
+}nvngSaveCount_t;
+
 /*==================================================================================================
 Public global variables declarations
 ==================================================================================================*/
 
+/*! Save counters, indexed like NVM_DataTable */
+extern nvngSaveCount_t gaNvngSaveCount[];
+
 /*==================================================================================================
 Public function prototypes
 ==================================================================================================*/
@@ -123,6 +145,24 @@ void NVNG_Erase(void ** ppRam);
 ***************************************************************************************************/
 void NVNG_MoveToRam(void ** ppRam);
 
+/*!*************************************************************************************************
+\fn      void NVNG_Flush(void)
+\brief   Passes the pending dataset saves to the NVM module without waiting for the end of the
+         coalescing window, the security datasets first.
+***************************************************************************************************/
+void NVNG_Flush(void);
+
+/*!*************************************************************************************************
+\fn      bool_t NVNG_GetSaveCount(uint16_t nvmId, nvngSaveCount_t *pCount)
+\brief   Reads the save counters of a dataset.
+
+\param [in]  nvmId     dataset id, nvmId_*
+\param [out] pCount    counters
+
+\return  bool_t        FALSE if the dataset is not in NVM_DataTable
+***************************************************************************************************/
+bool_t NVNG_GetSaveCount(uint16_t nvmId, nvngSaveCount_t *pCount);
+
 
 #ifdef __cplusplus
 }
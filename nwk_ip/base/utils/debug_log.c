@@ -136,6 +136,7 @@ extern pools_t memPools[];
 /*==================================================================================================
 Public functions
 ==================================================================================================*/
+#if !gDLogEnabled_d
 void DBG_Printf(char * format,...)
 {
 #if DEBUG_LOG
@@ -146,6 +147,7 @@ void DBG_Printf(char * format,...)
 
 #endif
 }
+#endif
 
 
 void DBG_WriteString(uint8_t* pBuf)
@@ -45,6 +45,7 @@ Include Files
 #include "nvm_adapter.h"
 #include "nv_data.h"
 #include "thread_app_callbacks.h"
+#include "TimersManager.h"
 
 #include "thread_types.h"
 
@@ -98,6 +99,15 @@ Private macros
         #error "*** ERROR: gUnmirroredFeatureSet_d from NVM module is not enabled"
     #endif
 #endif
+
+/*! The dataset has no dirty bitmap and is saved whole */
+#define NVNG_NO_BITMAP                  0xFFFFU
+
+/*! Save priorities, the lowest value is passed to the NVM module first */
+#define NVNG_PRIO_SECURITY              0U      /*!< Frame counters and keys, not delayed */
+#define NVNG_PRIO_NETWORK               1U
+#define NVNG_PRIO_TABLES                2U      /*!< Rebuilt from the network after a reset */
+#define NVNG_PRIO_COUNT                 3U
 /*==================================================================================================
 Private type definitions
 ==================================================================================================*/
@@ -105,7 +115,13 @@ Private type definitions
 /*==================================================================================================
 Private prototypes
 ==================================================================================================*/
-
+#if NVM_NG_ENABLED
+static bool_t NVNG_Locate(void **ppRam, uint32_t *pEntry, uint32_t *pElement);
+static uint8_t NVNG_GetPriority(uint16_t nvmId);
+static void NVNG_MarkDirty(uint32_t entry, uint32_t element);
+static bool_t NVNG_ClearDirty(uint32_t entry, uint32_t element);
+static void NVNG_SaveTimerCb(void *param);
+#endif
 /*==================================================================================================
 Private global variables declarations
 ==================================================================================================*/
@@ -113,10 +129,30 @@ Private global variables declarations
 /*! mutex used to ensure NVNG functions thread switch safety */
 osaMutexId_t mNVNGMutex;
 
+#if NVM_NG_ENABLED
+/*! Dirty element bitmaps of the datasets */
+static uint32_t maNvngDirtyBitmap[NVNG_DIRTY_BITMAP_WORDS];
+
+/*! First bitmap word of each dataset, or NVNG_NO_BITMAP */
+static uint16_t maNvngBitmapOffset[gNvTableEntriesCountMax_c];
+
+/*! Datasets to be saved whole */
+static bool_t maNvngDirtyAll[gNvTableEntriesCountMax_c];
+
+/*! Save priority of each dataset */
+static uint8_t maNvngPriority[gNvTableEntriesCountMax_c];
+
+/*! Coalescing window timer */
+static tmrTimerID_t mNvngSaveTimerId = gTmrInvalidTimerID_c;
+#endif
+
 /*==================================================================================================
 Public global variables declarations
 ==================================================================================================*/
-
+#if NVM_NG_ENABLED
+/*! Save counters, indexed like NVM_DataTable */
+nvngSaveCount_t gaNvngSaveCount[gNvTableEntriesCountMax_c];
+#endif
 /*==================================================================================================
 Public functions
 ==================================================================================================*/
@@ -140,9 +176,33 @@ nvngErrCode_t NVNG_Init
 
     if (FALSE == bNvngInitialized)
     {
+        uint32_t i = 0;
+        uint32_t words = 0;
+        uint32_t size;
+
+        /* Give each dataset a dirty bitmap while there is room */
+        while ((i < gNvTableEntriesCountMax_c) && (gNvEndOfTableId_c != NVM_DataTable[i].DataEntryID))
+        {
+            size = (NVM_DataTable[i].ElementsCount + 31) / 32;
+
+            if (words + size <= NVNG_DIRTY_BITMAP_WORDS)
+            {
+                maNvngBitmapOffset[i] = (uint16_t)words;
+                words += size;
+            }
+            else
+            {
+                maNvngBitmapOffset[i] = NVNG_NO_BITMAP;
+            }
+
+            maNvngPriority[i] = NVNG_GetPriority(NVM_DataTable[i].DataEntryID);
+            i++;
+        }
+
         mNVNGMutex  = OSA_MutexCreate();
+        mNvngSaveTimerId = TMR_AllocateTimer();
 
-        if (NULL != mNVNGMutex)
+        if ((NULL != mNVNGMutex) && (gTmrInvalidTimerID_c != mNvngSaveTimerId))
         {
             bNvngInitialized = TRUE;
         }
@@ -290,7 +350,30 @@ void NVNG_Save
 )
 {
 #if NVM_NG_ENABLED
-    NVM_Status_t nvmStatus = NvSaveOnIdle(ppRam, FALSE);
+    NVM_Status_t nvmStatus = gNVM_OK_c;
+    uint32_t entry;
+    uint32_t element;
+
+    if (NVNG_Locate(ppRam, &entry, &element))
+    {
+        gaNvngSaveCount[entry].requested++;
+
+        if (NVNG_PRIO_SECURITY == maNvngPriority[entry])
+        {
+            (void)NVNG_ClearDirty(entry, element);
+            gaNvngSaveCount[entry].written++;
+            nvmStatus = NvSaveOnIdle(ppRam, FALSE);
+        }
+        else
+        {
+            /* Written when the coalescing window ends */
+            NVNG_MarkDirty(entry, element);
+        }
+    }
+    else
+    {
+        nvmStatus = NvSaveOnIdle(ppRam, FALSE);
+    }
 
     if (gNVM_OK_c != nvmStatus)
     {
@@ -314,7 +397,19 @@ void NVNG_SyncSave
 )
 {
 #if NVM_NG_ENABLED
-    NVM_Status_t nvmStatus = NvSyncSave(ppRam, FALSE);
+    NVM_Status_t nvmStatus;
+    uint32_t entry;
+    uint32_t element;
+
+    if (NVNG_Locate(ppRam, &entry, &element))
+    {
+        /* A pending save of the element is done now */
+        (void)NVNG_ClearDirty(entry, element);
+        gaNvngSaveCount[entry].requested++;
+        gaNvngSaveCount[entry].written++;
+    }
+
+    nvmStatus = NvSyncSave(ppRam, FALSE);
 
     if ((gNVM_OK_c != nvmStatus) && (gNVM_CriticalSectionActive_c != nvmStatus))
     {
@@ -337,7 +432,18 @@ void NVNG_SaveOnInterval
 )
 {
 #if NVM_NG_ENABLED
-    NVM_Status_t nvmStatus = NvSaveOnInterval(ppRam);
+    NVM_Status_t nvmStatus;
+    uint32_t entry;
+    uint32_t element;
+
+    if (NVNG_Locate(ppRam, &entry, &element))
+    {
+        (void)NVNG_ClearDirty(entry, element);
+        gaNvngSaveCount[entry].requested++;
+        gaNvngSaveCount[entry].written++;
+    }
+
+    nvmStatus = NvSaveOnInterval(ppRam);
 
     if (gNVM_OK_c != nvmStatus)
     {
@@ -370,7 +476,17 @@ void NVNG_Erase
         MEM_BufferFree(tempPram);
     }
 #else
-    NVM_Status_t nvmStatus = NvErase(ppRam);
+    NVM_Status_t nvmStatus;
+    uint32_t entry;
+    uint32_t element;
+
+    /* Nothing left to save for the element */
+    if (NVNG_Locate(ppRam, &entry, &element))
+    {
+        (void)NVNG_ClearDirty(entry, element);
+    }
+
+    nvmStatus = NvErase(ppRam);
 
     if ((gNVM_OK_c != nvmStatus) && (gNVM_CriticalSectionActive_c != nvmStatus))
     {
@@ -381,9 +497,307 @@ void NVNG_Erase
 #endif
 }
 
+/*!*************************************************************************************************
+\fn      void NVNG_Flush(void)
+\brief   Passes the pending dataset saves to the NVM module without waiting for the end of the
+         coalescing window, the security datasets first.
+***************************************************************************************************/
+void NVNG_Flush
+(
+    void
+)
+{
+#if NVM_NG_ENABLED
+    NVM_Status_t nvmStatus = gNVM_OK_c;
+    uint32_t prio;
+    uint32_t entry;
+    uint32_t element;
+    uint32_t word;
+    uint32_t bits;
+    bool_t saveAll;
+
+    (void)TMR_StopTimer(mNvngSaveTimerId);
+
+    for (prio = 0; prio < NVNG_PRIO_COUNT; prio++)
+    {
+        for (entry = 0; (entry < gNvTableEntriesCountMax_c) && (gNvEndOfTableId_c != NVM_DataTable[entry].DataEntryID); entry++)
+        {
+            if (prio != maNvngPriority[entry])
+            {
+                continue;
+            }
+
+            OSA_InterruptDisable();
+            saveAll = maNvngDirtyAll[entry];
+            maNvngDirtyAll[entry] = FALSE;
+            OSA_InterruptEnable();
+
+            if (saveAll)
+            {
+                gaNvngSaveCount[entry].written++;
+                nvmStatus = NvSaveOnIdle(NVM_DataTable[entry].pData, TRUE);
+                continue;
+            }
+
+            if (NVNG_NO_BITMAP == maNvngBitmapOffset[entry])
+            {
+                continue;
+            }
+
+            for (word = 0; word < (NVM_DataTable[entry].ElementsCount + 31U) / 32U; word++)
+            {
+                /* Take the bits of a word at once, a save requested meanwhile sets them again */
+                OSA_InterruptDisable();
+                bits = maNvngDirtyBitmap[maNvngBitmapOffset[entry] + word];
+                maNvngDirtyBitmap[maNvngBitmapOffset[entry] + word] = 0;
+                OSA_InterruptEnable();
+
+                for (element = word * 32U; 0 != bits; element++, bits >>= 1)
+                {
+                    if (0 == (bits & 1U))
+                    {
+                        continue;
+                    }
+
+                    gaNvngSaveCount[entry].written++;
+
+                    if (gNVM_MirroredInRam_c == NVM_DataTable[entry].DataEntryType)
+                    {
+                        nvmStatus = NvSaveOnIdle((uint8_t *)NVM_DataTable[entry].pData +
+                                                 element * NVM_DataTable[entry].ElementSize, FALSE);
+                    }
+                    else
+                    {
+                        nvmStatus = NvSaveOnIdle(&((void **)NVM_DataTable[entry].pData)[element], FALSE);
+                    }
+
+                    if (gNVM_OK_c != nvmStatus)
+                    {
+                        break;
+                    }
+                }
+
+                if (gNVM_OK_c != nvmStatus)
+                {
+                    break;
+                }
+            }
+
+            if (gNVM_OK_c != nvmStatus)
+            {
+                /* Critical issue with nvm - mcu reset / halt in panic*/
+                APP_CriticalExitCb((uint32_t)NVNG_Flush, nvmStatus);
+                return;
+            }
+        }
+    }
+#endif
+}
+
+/*!*************************************************************************************************
+\fn      bool_t NVNG_GetSaveCount(uint16_t nvmId, nvngSaveCount_t *pCount)
+\brief   Reads the save counters of a dataset.
+
+\param [in]  nvmId     dataset id, nvmId_*
+\param [out] pCount    counters
+
+\return  bool_t        FALSE if the dataset is not in NVM_DataTable
+***************************************************************************************************/
+bool_t NVNG_GetSaveCount
+(
+    uint16_t nvmId,
+    nvngSaveCount_t *pCount
+)
+{
+#if NVM_NG_ENABLED
+    uint32_t i;
+
+    for (i = 0; (i < gNvTableEntriesCountMax_c) && (gNvEndOfTableId_c != NVM_DataTable[i].DataEntryID); i++)
+    {
+        if (nvmId == NVM_DataTable[i].DataEntryID)
+        {
+            FLib_MemCpy(pCount, &gaNvngSaveCount[i], sizeof(nvngSaveCount_t));
+            return TRUE;
+        }
+    }
+#else
+    (void)nvmId;
+    (void)pCount;
+#endif
+    return FALSE;
+}
+
 /*==================================================================================================
 Private functions
 ==================================================================================================*/
+#if NVM_NG_ENABLED
+/*!*************************************************************************************************
+\private
+\fn      bool_t NVNG_Locate(void **ppRam, uint32_t *pEntry, uint32_t *pElement)
+\brief   Finds the dataset and the element a save request points to. The element is addressed
+         directly in a mirrored dataset, and by its pointer slot in an unmirrored one.
+
+\param [in]  ppRam     pointer passed to the NVNG function
+\param [out] pEntry    index in NVM_DataTable
+\param [out] pElement  element index
+
+\return  bool_t        FALSE if the pointer is not in a dataset
+***************************************************************************************************/
+static bool_t NVNG_Locate
+(
+    void **ppRam,
+    uint32_t *pEntry,
+    uint32_t *pElement
+)
+{
+    uint8_t *p = (uint8_t *)ppRam;
+    uint8_t *pBase;
+    uint32_t elementSize;
+    uint32_t i;
+
+    for (i = 0; (i < gNvTableEntriesCountMax_c) && (gNvEndOfTableId_c != NVM_DataTable[i].DataEntryID); i++)
+    {
+        pBase = (uint8_t *)NVM_DataTable[i].pData;
+        elementSize = (gNVM_MirroredInRam_c == NVM_DataTable[i].DataEntryType) ?
+                      NVM_DataTable[i].ElementSize : sizeof(void *);
+
+        if ((NULL != pBase) && (p >= pBase) && (p < pBase + NVM_DataTable[i].ElementsCount * elementSize))
+        {
+            *pEntry = i;
+            *pElement = (uint32_t)(p - pBase) / elementSize;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*!*************************************************************************************************
+\private
+\fn      uint8_t NVNG_GetPriority(uint16_t nvmId)
+\brief   Save priority of a dataset.
+
+\param [in]  nvmId     dataset id, nvmId_*
+
+\return  uint8_t       NVNG_PRIO_*
+***************************************************************************************************/
+static uint8_t NVNG_GetPriority
+(
+    uint16_t nvmId
+)
+{
+    uint8_t prio;
+
+    switch (nvmId)
+    {
+        /* A frame counter or a key lost at reset breaks the network security */
+        case nvmId_MleOutgoingSecFrameCounter_c:
+        case nvmId_MacOutgoingSecFrameCounter_c:
+        case nvmId_ThreadActiveAttr_c:
+        case nvmId_ThreadPendingAttr_c:
+            prio = NVNG_PRIO_SECURITY;
+            break;
+
+        /* Churning tables, relearnt from the neighbors */
+        case nvmId_ThrNeighborsTbl_c:
+        case nvmId_ThrChildAddrRegTbl_c:
+        case nvmId_ThrChildVersionTbl_c:
+        case nvmId_ThreadMcastAddrRegTbl_c:
+        case nvmId_ThrSlaacTempAddrTbl_c:
+        case nvmId_ip6RoutingTblEntry_c:
+            prio = NVNG_PRIO_TABLES;
+            break;
+
+        default:
+            prio = NVNG_PRIO_NETWORK;
+            break;
+    }
+
+    return prio;
+}
+
+/*!*************************************************************************************************
+\private
+\fn      void NVNG_MarkDirty(uint32_t entry, uint32_t element)
+\brief   Records a save request and opens the coalescing window if it is not open.
+
+\param [in]  entry     index in NVM_DataTable
+\param [in]  element   element index
+***************************************************************************************************/
+static void NVNG_MarkDirty
+(
+    uint32_t entry,
+    uint32_t element
+)
+{
+    OSA_InterruptDisable();
+
+    if (NVNG_NO_BITMAP == maNvngBitmapOffset[entry])
+    {
+        maNvngDirtyAll[entry] = TRUE;
+    }
+    else
+    {
+        maNvngDirtyBitmap[maNvngBitmapOffset[entry] + element / 32U] |= 1UL << (element % 32U);
+    }
+
+    OSA_InterruptEnable();
+
+    if (!TMR_IsTimerActive(mNvngSaveTimerId))
+    {
+        (void)TMR_StartSingleShotTimer(mNvngSaveTimerId, NVNG_SAVE_WINDOW_MS, NVNG_SaveTimerCb, NULL);
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn      bool_t NVNG_ClearDirty(uint32_t entry, uint32_t element)
+\brief   Drops the pending save of an element.
+
+\param [in]  entry     index in NVM_DataTable
+\param [in]  element   element index
+
+\return  bool_t        TRUE if a save was pending
+***************************************************************************************************/
+static bool_t NVNG_ClearDirty
+(
+    uint32_t entry,
+    uint32_t element
+)
+{
+    uint32_t *pWord;
+    uint32_t mask = 1UL << (element % 32U);
+    bool_t dirty = FALSE;
+
+    if (NVNG_NO_BITMAP != maNvngBitmapOffset[entry])
+    {
+        pWord = &maNvngDirtyBitmap[maNvngBitmapOffset[entry] + element / 32U];
+
+        OSA_InterruptDisable();
+        dirty = (*pWord & mask) ? TRUE : FALSE;
+        *pWord &= ~mask;
+        OSA_InterruptEnable();
+    }
+
+    return dirty;
+}
+
+/*!*************************************************************************************************
+\private
+\fn      void NVNG_SaveTimerCb(void *param)
+\brief   End of the coalescing window.
+
+\param [in]  param     not used
+***************************************************************************************************/
+static void NVNG_SaveTimerCb
+(
+    void *param
+)
+{
+    (void)param;
+    NVNG_Flush();
+}
+#endif /* NVM_NG_ENABLED */
 
 /*==================================================================================================
 Private debug functions
@@ -83,6 +83,32 @@ Public macros
     #define HTTP_CLIENT_TIMEOUT_INTERVAL 1000U /* ms */
 #endif
 
+/* A server connection left idle this long is closed. 0 closes it after each response */
+#ifndef HTTP_SERVER_KEEP_ALIVE_TIMEOUT
+    #define HTTP_SERVER_KEEP_ALIVE_TIMEOUT 15000U /* ms */
+#endif
+
+/* Requests served on one connection before it is closed, so that the other clients get a
+   turn at the connection table */
+#ifndef HTTP_SERVER_KEEP_ALIVE_MAX_REQUESTS
+    #define HTTP_SERVER_KEEP_ALIVE_MAX_REQUESTS 100U
+#endif
+
+/* A response TCP has no room for is retried at this interval. The connection is closed when
+   none of it could be sent for HTTP_SERVER_SEND_TIMEOUT */
+#ifndef HTTP_SERVER_SEND_RETRY_INTERVAL
+    #define HTTP_SERVER_SEND_RETRY_INTERVAL 100U /* ms */
+#endif
+
+#ifndef HTTP_SERVER_SEND_TIMEOUT
+    #define HTTP_SERVER_SEND_TIMEOUT 15000U /* ms */
+#endif
+
+/* Segments a pHttpBodyFunction may return for one response body */
+#ifndef HTTP_SERVER_BODY_SEGMENTS
+    #define HTTP_SERVER_BODY_SEGMENTS 8U
+#endif
+
 
 
 
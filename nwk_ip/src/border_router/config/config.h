@@ -86,6 +86,8 @@ CONFIG APPLICATION
     #define gSpiMasterDap_Port_d                    gpioPort_B_c
     #define gSpiMasterDap_Pin_d                     11
     #define gHybridApp_d                            (1)
+    /* Timers, framework, serial manager, deferred log and sensor events tasks */
+    #define osNumberOfEvents                        (6)
 
     #if gHybridApp_d
         #define gTmrTaskStackSize_c                 2048
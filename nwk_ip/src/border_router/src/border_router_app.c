@@ -75,6 +75,9 @@ Include Files
 #if UDP_ECHO_PROTOCOL
 #include "app_echo_udp.h"
 #endif
+#if APP_HTTP_SERVER
+#include "app_http_server.h"
+#endif
 
 /*==================================================================================================
 Private macros
@@ -240,6 +243,11 @@ void APP_Init
         APP_InitADC(ADC_0);
 #endif
 
+#if APP_HTTP_SERVER
+        /* Serve the sensor snapshot to the dashboards */
+        APP_HttpServerInit();
+#endif
+
 #if THREAD_USE_THCI && THR_ENABLE_MGMT_DIAGNOSTICS
         (void)MgmtDiagnostic_RegisterAppCb(THCI_MgmtDiagnosticAppCb);
 #endif
@@ -883,6 +891,15 @@ static void APP_ReportTemp
     uint32_t ackPloadSize;
     ifHandle_t ifHandle = THR_GetIpIfPtrByInstId(mThrInstanceId);
 
+#if APP_HTTP_SERVER && USE_TEMPERATURE_SENSOR
+    appHttpSnapshot_t snapshot = {0};
+
+    /* The reading is served on "/sensors" as well */
+    snapshot.flags = gAppHttpTemperatureValid_c;
+    snapshot.temperature = APP_GetCurrentTempValue();
+    APP_HttpServerSetSnapshot(&snapshot);
+#endif
+
     if(!IP_IF_IsMyAddr(ifHandle->ifUniqueId, &gCoapDestAddress))
     {
         pSession = COAP_OpenSession(mAppCoapInstId);
@@ -90,6 +90,11 @@
   #endif
   #define gKbdVeryLongKeyIterations_c (60)
 #endif
+
+/*! Keys of the application settings kept in the key-value store, see KVStore.h */
+#ifndef gAppKVKeyBacklight_c
+    #define gAppKVKeyBacklight_c        0
+#endif
 /************************************************************************************/
 
 #endif /* _APP_CONFIG_H_  */
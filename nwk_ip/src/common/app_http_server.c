@@ -0,0 +1,272 @@
+/*
+ * Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*!=================================================================================================
+\file       app_http_server.c
+\brief      This is the source file for the HTTP server application. The sensor snapshot is sent
+            with pHttpBodyFunction: the response body is the list of the labels and of the value
+            texts, gathered by the server without building the document first.
+==================================================================================================*/
+
+/*==================================================================================================
+Include Files
+==================================================================================================*/
+#include <string.h>
+
+/* FSL Framework */
+#include "FunctionLib.h"
+
+/* Application */
+#include "http.h"
+#include "app_thread_config.h"
+#include "app_http_server.h"
+
+#if APP_HTTP_SERVER
+/*==================================================================================================
+Private macros
+==================================================================================================*/
+
+/* Readings in the snapshot */
+#define mAppHttpNbValues_c              (4U)
+
+/* Longest value text: sign, 10 digits, '.' and the character after the value */
+#define mAppHttpValueSize_c             (13U)
+
+/*==================================================================================================
+Private prototypes
+==================================================================================================*/
+static uint32_t APP_HttpSensorsBody(void *pUriContent, httpBodySegment_t* pSegments,
+                                    uint32_t maxSegments);
+static uint8_t APP_HttpRenderValue(char* pText, int32_t value, bool_t bValid, uint32_t decimals,
+                                   char nextChar);
+
+/*==================================================================================================
+Private global variables declarations
+==================================================================================================*/
+
+static const char mAppHttpIndexPage[] =
+    "<html><body><a href=\"/sensors\">Sensors</a></body></html>";
+
+/* Label before each value, the value texts end with ',' or '}' */
+static const char* const mapAppHttpLabels[mAppHttpNbValues_c] =
+{
+    "{\"temperature\":",
+    "\"humidity\":",
+    "\"pressure\":",
+    "\"light\":"
+};
+
+/* Decimals of each value, see appHttpSnapshot_t */
+static const uint8_t maAppHttpDecimals[mAppHttpNbValues_c] = {2U, 2U, 0U, 2U};
+
+/* Value texts of the last two snapshots. A new snapshot is written over the older one, the
+   response being gathered from the last one is not changed. */
+static char maAppHttpValues[2][mAppHttpNbValues_c][mAppHttpValueSize_c];
+static uint8_t maAppHttpValueLen[2][mAppHttpNbValues_c];
+static volatile uint8_t mAppHttpSnapshot = 0U;
+
+static const uriTableEntry_t maAppHttpUriTable[] =
+{
+    {(uint8_t*)"/", gHttpUriType_texthtml_c, (void*)mAppHttpIndexPage, NULL, NULL, NULL},
+    {(uint8_t*)"/sensors", gHttpUriType_textplain_c, NULL, NULL, NULL, APP_HttpSensorsBody}
+};
+
+/*==================================================================================================
+Public functions
+==================================================================================================*/
+/*!*************************************************************************************************
+\fn     void APP_HttpServerInit(void)
+\brief  This function starts the HTTP server with a page and the sensor snapshot, "/sensors".
+        The readings are reported as null until APP_HttpServerSetSnapshot() is called.
+
+\return         void
+***************************************************************************************************/
+void APP_HttpServerInit
+(
+    void
+)
+{
+    appHttpSnapshot_t snapshot;
+
+    FLib_MemSet(&snapshot, 0U, sizeof(snapshot));
+    APP_HttpServerSetSnapshot(&snapshot);
+
+    (void)HTTP_StartServer(maAppHttpUriTable, NumberOfElements(maAppHttpUriTable),
+                           APP_HTTP_SERVER_PORT, FALSE, gHttpServerTypeIpv6Only_c,
+                           APP_HTTP_SERVER_NAME);
+}
+
+/*!*************************************************************************************************
+\fn     void APP_HttpServerSetSnapshot(const appHttpSnapshot_t* pSnapshot)
+\brief  This function sets the readings served on "/sensors". The values are converted to text
+        here, once, and the responses are gathered from these texts.
+
+\param  [in]    pSnapshot     sensor readings
+
+\return         void
+***************************************************************************************************/
+void APP_HttpServerSetSnapshot
+(
+    const appHttpSnapshot_t* pSnapshot
+)
+{
+    uint8_t snapshot = mAppHttpSnapshot ^ 1U;
+    int32_t aValues[mAppHttpNbValues_c];
+    uint32_t iCount;
+
+    aValues[0] = pSnapshot->temperature;
+    aValues[1] = pSnapshot->humidity;
+    aValues[2] = pSnapshot->pressure;
+    aValues[3] = pSnapshot->ambientLight;
+
+    for(iCount = 0U; iCount < mAppHttpNbValues_c; iCount ++)
+    {
+        maAppHttpValueLen[snapshot][iCount] =
+            APP_HttpRenderValue(maAppHttpValues[snapshot][iCount], aValues[iCount],
+                                (pSnapshot->flags & (1U << iCount)) != 0U,
+                                maAppHttpDecimals[iCount],
+                                (iCount + 1U < mAppHttpNbValues_c) ? ',' : '}');
+    }
+
+    mAppHttpSnapshot = snapshot;
+}
+
+/*==================================================================================================
+Private functions
+==================================================================================================*/
+/*!*************************************************************************************************
+\private
+\fn     static uint32_t APP_HttpSensorsBody(void *pUriContent, httpBodySegment_t* pSegments,
+                                            uint32_t maxSegments)
+\brief  This function describes the body of "/sensors", e.g.
+        {"temperature":21.50,"humidity":40.20,"pressure":1013,"light":null}
+
+\param  [in]    pUriContent   not used
+\param  [out]   pSegments     pieces of the body: a label and a value text for each reading
+\param  [in]    maxSegments   room in pSegments
+
+\return         uint32_t      number of pieces, 0 if they don't fit
+***************************************************************************************************/
+static uint32_t APP_HttpSensorsBody
+(
+    void *pUriContent,
+    httpBodySegment_t* pSegments,
+    uint32_t maxSegments
+)
+{
+    uint8_t snapshot = mAppHttpSnapshot;
+    uint32_t nbSegments = 0U;
+    uint32_t iCount;
+
+    (void)pUriContent;
+
+    if(maxSegments >= 2U * mAppHttpNbValues_c)
+    {
+        for(iCount = 0U; iCount < mAppHttpNbValues_c; iCount ++)
+        {
+            pSegments[nbSegments].pData = (const uint8_t*)mapAppHttpLabels[iCount];
+            pSegments[nbSegments].length = strlen(mapAppHttpLabels[iCount]);
+            nbSegments ++;
+
+            pSegments[nbSegments].pData = (const uint8_t*)maAppHttpValues[snapshot][iCount];
+            pSegments[nbSegments].length = maAppHttpValueLen[snapshot][iCount];
+            nbSegments ++;
+        }
+    }
+
+    return nbSegments;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static uint8_t APP_HttpRenderValue(char* pText, int32_t value, bool_t bValid,
+                                           uint32_t decimals, char nextChar)
+\brief  This function writes a fixed point value as a JSON number, or null
+
+\param  [out]   pText      text, mAppHttpValueSize_c bytes
+\param  [in]    value      value, in units of 10^-decimals
+\param  [in]    bValid     FALSE writes null
+\param  [in]    decimals   digits after the point
+\param  [in]    nextChar   character written after the value
+
+\return         uint8_t    length of the text
+***************************************************************************************************/
+static uint8_t APP_HttpRenderValue
+(
+    char* pText,
+    int32_t value,
+    bool_t bValid,
+    uint32_t decimals,
+    char nextChar
+)
+{
+    char aDigits[10];
+    uint32_t magnitude;
+    uint32_t nbDigits = 0U;
+    uint8_t length = 0U;
+
+    if(FALSE == bValid)
+    {
+        FLib_MemCpy(pText, (void*)"null", 4U);
+        length = 4U;
+    }
+    else
+    {
+        magnitude = (uint32_t)value;
+
+        if(value < 0)
+        {
+            pText[length++] = '-';
+            magnitude = 0U - magnitude;
+        }
+
+        /* Least significant digit first, at least one digit before the point */
+        do
+        {
+            aDigits[nbDigits++] = (char)('0' + (magnitude % 10U));
+            magnitude /= 10U;
+        } while(magnitude || (nbDigits <= decimals));
+
+        while(nbDigits)
+        {
+            if(nbDigits == decimals)
+            {
+                pText[length++] = '.';
+            }
+
+            pText[length++] = aDigits[--nbDigits];
+        }
+    }
+
+    pText[length++] = nextChar;
+
+    return length;
+}
+
+#endif /* APP_HTTP_SERVER */
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _APP_HTTP_SERVER_H
+#define _APP_HTTP_SERVER_H
+/*!=================================================================================================
+\file       app_http_server.h
+\brief      This is a header file for the HTTP server application. It serves the last sensor
+            snapshot to the dashboards polling the node.
+
+==================================================================================================*/
+
+/*==================================================================================================
+ Include Files
+ ==================================================================================================*/
+
+#include "EmbeddedTypes.h"
+
+/*==================================================================================================
+ Public macros
+ ==================================================================================================*/
+
+#define APP_HTTP_SERVER_PORT            (80U)
+#define APP_HTTP_SERVER_NAME            "rpk"
+
+/* appHttpSnapshot_t flags: which fields hold a reading */
+#define gAppHttpTemperatureValid_c      (1U << 0)
+#define gAppHttpHumidityValid_c         (1U << 1)
+#define gAppHttpPressureValid_c         (1U << 2)
+#define gAppHttpAmbientLightValid_c     (1U << 3)
+
+/*==================================================================================================
+ Public type definitions
+ ==================================================================================================*/
+
+/* Sensor readings served on "/sensors", in the units of the BLE telemetry record */
+typedef struct appHttpSnapshot_tag
+{
+    uint8_t  flags;             /* gAppHttpXxxValid_c */
+    int32_t  temperature;       /* 0.01 C */
+    int32_t  humidity;          /* 0.01 % */
+    int32_t  pressure;          /* hPa */
+    int32_t  ambientLight;      /* 0.01 lux */
+}appHttpSnapshot_t;
+
+/*==================================================================================================
+ Public global variables declarations
+ ==================================================================================================*/
+
+/*==================================================================================================
+ Public function prototypes
+ ==================================================================================================*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if APP_HTTP_SERVER
+/*!*************************************************************************************************
+\fn     void APP_HttpServerInit(void)
+\brief  This function starts the HTTP server with a page and the sensor snapshot, "/sensors".
+        The readings are reported as null until APP_HttpServerSetSnapshot() is called.
+
+\return         void
+***************************************************************************************************/
+void APP_HttpServerInit(void);
+
+/*!*************************************************************************************************
+\fn     void APP_HttpServerSetSnapshot(const appHttpSnapshot_t* pSnapshot)
+\brief  This function sets the readings served on "/sensors". The values are converted to text
+        here, once, and the responses are gathered from these texts.
+
+\param  [in]    pSnapshot     sensor readings
+
+\return         void
+***************************************************************************************************/
+void APP_HttpServerSetSnapshot(const appHttpSnapshot_t* pSnapshot);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+/*================================================================================================*/
+#endif  /* _APP_HTTP_SERVER_H */
@@ -46,6 +46,7 @@ Include Files
 #include "app_stack_config.h"
 #include "app_ota.h"
 #include "OtaSupport.h"
+#include "SecLib.h"
 #include "coap.h"
 #include "thread_utils.h"
 /*==================================================================================================
@@ -97,10 +98,56 @@ Private macros
     #define gOtaClientDeclareErrorMs_c                     3000     /* 3 seconds */
 #endif
 
+/* Max. number of block requests in flight during the image download */
+#ifndef gOtaClientMaxBlockWindow_c
+    #define gOtaClientMaxBlockWindow_c                     8
+#endif
+
+/* Number of block requests in flight at the start of the download */
+#ifndef gOtaClientInitialBlockWindow_c
+    #define gOtaClientInitialBlockWindow_c                 2
+#endif
+
+/* Lower bound of the block request timeout, which follows the measured round trip time.
+   The upper bound is gOtaClientDeclareErrorMs_c */
+#ifndef gOtaClientMinBlockTimeoutMs_c
+    #define gOtaClientMinBlockTimeoutMs_c                  100    /*   100 ms */
+#endif
+
+/* Image signature checked before the image is committed. It covers the file from its header
+   up to the signature sub-element (CRC or integrity code tag):
+   gOtaClientSignatureCrc_c     CRC of OTA_CrcCompute(), as written by the legacy image tools
+   gOtaClientSignatureSha256_c  SHA-256 digest, 32 bytes
+   gOtaClientSignatureCmac_c    AES-128 CMAC keyed with gOtaClientSignatureKey_c, 16 bytes.
+                                Only the holders of the key can produce a valid image */
+#define gOtaClientSignatureCrc_c                           0
+#define gOtaClientSignatureSha256_c                        1
+#define gOtaClientSignatureCmac_c                          2
+
+#ifndef gOtaClientSignature_c
+    #define gOtaClientSignature_c                          gOtaClientSignatureCrc_c
+#endif
+
+#if (gOtaClientSignature_c == gOtaClientSignatureCmac_c) && !defined(gOtaClientSignatureKey_c)
+    #error "gOtaClientSignatureKey_c must list the 16 bytes of the image authentication key"
+#endif
+
 /* Enable or disable ota activity led */
 #ifndef gOtaClientEnableLedActivity_c
     #define gOtaClientEnableLedActivity_c      1
 #endif
+#if (gOtaClientSignature_c == gOtaClientSignatureSha256_c)
+    #define mOtaClientSignatureSize_c                      SHA256_HASH_SIZE
+    #define mOtaClientSignatureMinSize_c                   SHA256_HASH_SIZE
+#elif (gOtaClientSignature_c == gOtaClientSignatureCmac_c)
+    #define mOtaClientSignatureSize_c                      AES_128_CMAC_SIZE
+    #define mOtaClientSignatureMinSize_c                   AES_128_CMAC_SIZE
+#else
+    /* The legacy CRC sub-element may be shorter than the CRC value */
+    #define mOtaClientSignatureSize_c                      sizeof(uint32_t)
+    #define mOtaClientSignatureMinSize_c                   1
+#endif
+
 /*==================================================================================================
 Private type definitions
 ==================================================================================================*/
@@ -129,7 +176,13 @@ typedef enum
 
 typedef struct otaClientSignature_tag
 {
+#if (gOtaClientSignature_c == gOtaClientSignatureSha256_c)
+    sha256Context_t sha256;
+#elif (gOtaClientSignature_c == gOtaClientSignatureCmac_c)
+    aesCmacContext_t cmac;
+#else
     uint32_t crcValue;
+#endif
 } otaClientSignature_t;
 
 /* ota client session format: */
@@ -166,6 +219,25 @@ typedef struct otaserverInfo_tag
     uint8_t  pData[1];
 } otaServerInfo_t;
 
+/* block request of the download window */
+typedef struct otaClientBlockSlot_tag
+{
+    otaServerInfo_t *pBlockRsp;     /* Response received ahead of the file offset */
+    uint32_t sentTimeMs;
+    uint8_t txCount;                /* 0 if not requested yet */
+} otaClientBlockSlot_t;
+
+/* ota client download window: slot i requests fileOffset + i * gOtaMaxBlockDataSize_c */
+typedef struct otaClientBlockWindow_tag
+{
+    otaClientBlockSlot_t slot[gOtaClientMaxBlockWindow_c];
+    uint32_t srttMs8;               /* Smoothed round trip time, x8 */
+    uint32_t rttVarMs4;             /* Round trip time variation, x4 */
+    uint32_t timeoutMs;
+    uint8_t size;                   /* Slots that may be requested */
+    uint8_t ackCount;               /* Blocks received since the last size increase */
+} otaClientBlockWindow_t;
+
 typedef enum
 {
     gOtaLedSet_c,
@@ -197,10 +269,20 @@ static void OtaClient_SendBlockReq(void *pParam);
 static void OtaClient_CoapSendUpgradeEndReq(void *pParam);
 static nwkStatus_t OtaClient_CoapSendReq(coapSession_t *pSession, uint8_t *pData, uint32_t dataLen);
 
+/* OTA Client download window */
+static void OtaClient_SendBlockReqAt(uint32_t fileOffset);
+static void OtaClient_FillBlockWindow(void);
+static void OtaClient_BlockReceived(uint32_t slotIdx, otaServerInfo_t *pOtaServerInfo);
+static void OtaClient_ProcessBlockWindow(void);
+static void OtaClient_ResetBlockWindow(bool_t restart);
+static uint32_t OtaClient_GetBlockTimeout(uint8_t txCount);
+static uint32_t OtaClient_GetTimeMs(void);
+
 /* OTA Client utility functions */
-static void OtaClient_ProcessBlock(void *pParam);
+static otaResult_t OtaClient_ProcessBlock(otaServerInfo_t *pOtaServerInfo);
 static void OtaClient_InitSignature(void);
 static void OtaClient_ComputeSignature(uint8_t *pData, uint32_t dataLen);
+static void OtaClient_FinishSignature(uint8_t *pSignature);
 static otaResult_t OtaClient_StartDownload(uint8_t *pData, uint32_t bytesToProcess, uint32_t *pBytesProcessed);
 static otaResult_t OtaClient_ProcessHeader(uint8_t *pData, uint32_t bytesToProcess, uint32_t *pBytesProcessed);
 static otaResult_t OtaClient_UpgradeImage(uint8_t *pData, uint32_t bytesToProcess, uint32_t *pBytesProcessed);
@@ -237,8 +319,15 @@ static otaClientSession_t mOtaClientSession = {.state = gOtaClientState_NotInit_
 
 static otaClientSetup_t mOtaClientSetup = {.mOtaUdpSrvSockFd = -1, .otaClientTmr = gTmrInvalidTimerID_c};
 
+static otaClientBlockWindow_t mOtaClientWindow = {.size = gOtaClientInitialBlockWindow_c,
+                                                  .timeoutMs = gOtaClientDeclareErrorMs_c};
+
 static const bool_t bStart = TRUE;
 
+#if (gOtaClientSignature_c == gOtaClientSignatureCmac_c)
+static const uint8_t maOtaClientSignatureKey[AES_128_KEY_BYTE_LEN] = gOtaClientSignatureKey_c;
+#endif
+
 /*==================================================================================================
 Public global variables declarations
 ==================================================================================================*/
@@ -271,7 +360,7 @@ otaStatus_t OtaClientInit
 
         if (gTmrInvalidTimerID_c == mOtaClientSetup.otaClientTmr)
         {
-            panic(0, (uint32_t)OtaClientInit, 0, 0);
+            panic(0, (uint32_t)(uintptr_t)OtaClientInit, 0, 0);
             return gOtaStatus_NoTimers_c;
         }
     }
@@ -315,6 +404,8 @@ otaStatus_t OtaClient_StartServerDiscovery
     otaStatus_t otaStatus = gOtaStatus_Success_c;
     uint32_t delayMs = NWKU_GetRandomNoFromInterval(0, gOtaClientValueMinForNextDiscoveryReqMs_c);
 
+    (void)param;
+
     if ((gOtaClientState_Idle_c == mOtaClientSession.state) || (gOtaClientState_ServerDiscovery_c == mOtaClientSession.state))
     {
         if (IP_IsAddrEqual(&mOtaClientSession.serverIpAddr, &in6addr_any))
@@ -590,6 +681,7 @@ static otaStatus_t OtaClient_QueryImageRspHandler
             {
                 /* Prepare the first block request */
                 mOtaClientSession.fileOffset = 0;
+                OtaClient_ResetBlockWindow(TRUE);
                 FLib_MemCpy(&mOtaClientSession.downloadFileVersion, pQueryImgRsp->data.success.fileVersion, sizeof(uint32_t));
                 FLib_MemCpy(&mOtaClientSession.fileLength, pQueryImgRsp->data.success.fileSize, sizeof(uint32_t));
                 mOtaClientSession.state = gOtaClientState_BlockReq_c;
@@ -662,6 +754,8 @@ static otaStatus_t OtaClient_BlockRspHandler
                 mOtaClientSession.noOfRetries = 0;
                 FLib_MemCpy(&requestTime, pBlockRsp->data.wait.requestTime, sizeof(uint32_t));
                 FLib_MemCpy(&currentTime, pBlockRsp->data.wait.currentTime, sizeof(uint32_t));
+                /* The requests in flight are not served, ask them again after the delay */
+                OtaClient_ResetBlockWindow(FALSE);
             }
 
             if (mOtaClientSession.noOfRetries <= gOtaClientMaxRetries_c)
@@ -673,12 +767,14 @@ static otaStatus_t OtaClient_BlockRspHandler
         else
         {
             uint32_t fileVersion = 0;
+            uint32_t slotIdx;
 
             status = gOtaStatus_Success_c;
             /* Get received offset */
             FLib_MemCpy(&receivedOffset, pBlockRsp->data.success.fileOffset, sizeof(uint32_t));
             /* Get received fileVersion */
             FLib_MemCpy(&fileVersion, pBlockRsp->data.success.fileVersion, sizeof(uint32_t));
+            slotIdx = (receivedOffset - mOtaClientSession.fileOffset) / gOtaMaxBlockDataSize_c;
 
             if (fileVersion != mOtaClientSession.downloadFileVersion)
             {
@@ -689,9 +785,8 @@ static otaStatus_t OtaClient_BlockRspHandler
             /* Process unicast transfer */
             if (status == gOtaStatus_Success_c)
             {
-                if ((((receivedOffset != mOtaClientSession.fileOffset) ||
-                        (pBlockRsp->data.success.dataSize > gOtaMaxBlockDataSize_c) ||
-                        (pBlockRsp->data.success.dataSize + mOtaClientSession.fileOffset > mOtaClientSession.fileLength))))
+                if ((pBlockRsp->data.success.dataSize > gOtaMaxBlockDataSize_c) ||
+                        (pBlockRsp->data.success.dataSize + receivedOffset > mOtaClientSession.fileLength))
                 {
                     mOtaClientSession.noOfRetries++;
                     status = gOtaStatus_InvalidParam_c;
@@ -700,20 +795,20 @@ static otaStatus_t OtaClient_BlockRspHandler
 
             if (status == gOtaStatus_Success_c)
             {
-                bool_t bstatus = NWKU_SendMsg(OtaClient_ProcessBlock, pOtaServerInfo, mpOtaClientMsgQueue);
-
-                if (bstatus == TRUE)
+                /* Keep the block if it answers a request in flight. The responses to
+                   retransmitted requests may come twice, the late copy is dropped */
+                if ((receivedOffset >= mOtaClientSession.fileOffset) &&
+                        (((receivedOffset - mOtaClientSession.fileOffset) % gOtaMaxBlockDataSize_c) == 0) &&
+                        (slotIdx < gOtaClientMaxBlockWindow_c) &&
+                        (mOtaClientWindow.slot[slotIdx].txCount) &&
+                        (NULL == mOtaClientWindow.slot[slotIdx].pBlockRsp))
                 {
+                    OtaClient_BlockReceived(slotIdx, pOtaServerInfo);
                     pOtaServerInfo = NULL;
-                    status = gOtaStatus_Success_c;
                     OtaClient_ActivityLed(gOtaLedToggle_c);
-                    mOtaClientSession.noOfRetries = 0;
-                }
-                else
-                {
-                    mOtaClientSession.noOfRetries++;
-                    status = gOtaStatus_Failed_c;
                 }
+
+                OtaClient_ProcessBlockWindow();
             }
         }
     }
@@ -882,8 +977,8 @@ static void OtaClient_CoapSendQueryImageReq
 
     if (pSession)
     {
-        otaCmd_QueryImageReq_t queryImageReq = {gOtaCmd_QueryImageReq_c, gOtaManufacturerCode_c, gOtaCurrentImageType_c,
-                                                gOtaCurrentFileVersion_c, gOtaHardwareVersion_c
+        otaCmd_QueryImageReq_t queryImageReq = {gOtaCmd_QueryImageReq_c, {gOtaManufacturerCode_c}, {gOtaCurrentImageType_c},
+                                                {gOtaCurrentFileVersion_c}, {gOtaHardwareVersion_c}
                                                };
 
         OtaClient_CoapSendReq(pSession, (uint8_t *)&queryImageReq, sizeof(otaCmd_QueryImageReq_t));
@@ -911,23 +1006,8 @@ static void OtaClient_SendBlockReq
     /* Used for delaying the command */
     if ((pParam) && (-1 != mOtaClientSetup.mOtaUdpSrvSockFd))
     {
-        sockaddrStorage_t portAddr;
-        otaCmd_BlockReq_t blockReq = {gOtaCmd_BlockReq_c, gOtaManufacturerCode_c, gOtaCurrentImageType_c,
-                                      gOtaCurrentFileVersion_c, {0x00, 0x00, 0x00, 0x00}, gOtaMaxBlockDataSize_c
-                                     };
-
-        FLib_MemCpy(&blockReq.fileVersion, &mOtaClientSession.downloadFileVersion, sizeof(uint32_t));
-        /* Set remote address and local port */
-        FLib_MemSet(&portAddr, 0, sizeof(sockaddrStorage_t));
-        ((sockaddrIn6_t *)&portAddr)->sin6_family = AF_INET6;
-        ((sockaddrIn6_t *)&portAddr)->sin6_port = mOtaClientSession.serverDownloadPort;
-        IP_AddrCopy(&((sockaddrIn6_t *)&portAddr)->sin6_addr, &mOtaClientSession.serverIpAddr);
-        ((sockaddrIn6_t *)&portAddr)->sin6_flowinfo = BSDS_SET_TX_SEC_FLAGS(1, 5);
-        ((sockaddrIn6_t *)&portAddr)->sin6_scope_id = gIpIfSlp0_c;
-
-        FLib_MemCpy(&blockReq.fileOffset, &mOtaClientSession.fileOffset, sizeof(uint32_t));
-        (void)sendto(mOtaClientSetup.mOtaUdpSrvSockFd, (void *)&blockReq, sizeof(otaCmd_BlockReq_t), 0,
-                     &portAddr, sizeof(portAddr));
+        /* Send the new requests of the window and the ones which timed out */
+        OtaClient_FillBlockWindow();
     }
     else
     {
@@ -941,6 +1021,309 @@ static void OtaClient_SendBlockReq
     }
 }
 
+/*!*************************************************************************************************
+\private
+\fn     static void OtaClient_SendBlockReqAt(uint32_t fileOffset)
+\brief  This function is used to send a Block Req command for a file offset to the OTA server node.
+
+\param  [in]   fileOffset    Offset of the block in the image file
+ ***************************************************************************************************/
+static void OtaClient_SendBlockReqAt
+(
+    uint32_t fileOffset
+)
+{
+    sockaddrStorage_t portAddr;
+    otaCmd_BlockReq_t blockReq = {gOtaCmd_BlockReq_c, {gOtaManufacturerCode_c}, {gOtaCurrentImageType_c},
+                                  {gOtaCurrentFileVersion_c}, {0x00, 0x00, 0x00, 0x00}, gOtaMaxBlockDataSize_c
+                                 };
+
+    FLib_MemCpy(&blockReq.fileVersion, &mOtaClientSession.downloadFileVersion, sizeof(uint32_t));
+    /* Set remote address and local port */
+    FLib_MemSet(&portAddr, 0, sizeof(sockaddrStorage_t));
+    ((sockaddrIn6_t *)&portAddr)->sin6_family = AF_INET6;
+    ((sockaddrIn6_t *)&portAddr)->sin6_port = mOtaClientSession.serverDownloadPort;
+    IP_AddrCopy(&((sockaddrIn6_t *)&portAddr)->sin6_addr, &mOtaClientSession.serverIpAddr);
+    ((sockaddrIn6_t *)&portAddr)->sin6_flowinfo = BSDS_SET_TX_SEC_FLAGS(1, 5);
+    ((sockaddrIn6_t *)&portAddr)->sin6_scope_id = gIpIfSlp0_c;
+
+    FLib_MemCpy(&blockReq.fileOffset, &fileOffset, sizeof(uint32_t));
+    (void)sendto(mOtaClientSetup.mOtaUdpSrvSockFd, (void *)&blockReq, sizeof(otaCmd_BlockReq_t), 0,
+                 &portAddr, sizeof(portAddr));
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaClient_FillBlockWindow(void)
+\brief  This function is used to send the block requests of the download window. The slots not
+        requested yet are sent if they fit in the window size, the requests which timed out are
+        sent again. A timeout halves the window size. The OTA client timer is started until the
+        next timeout.
+ ***************************************************************************************************/
+static void OtaClient_FillBlockWindow
+(
+    void
+)
+{
+    uint32_t currentTimeMs = OtaClient_GetTimeMs();
+    uint32_t nextTimeoutMs = gOtaClientDeclareErrorMs_c;
+    uint32_t fileOffset = mOtaClientSession.fileOffset;
+    bool_t lost = FALSE;
+    uint32_t i;
+
+    for (i = 0; (i < gOtaClientMaxBlockWindow_c) && (fileOffset < mOtaClientSession.fileLength);
+            i++, fileOffset += gOtaMaxBlockDataSize_c)
+    {
+        otaClientBlockSlot_t *pSlot = &mOtaClientWindow.slot[i];
+        uint32_t timeoutMs;
+
+        if (pSlot->pBlockRsp)
+        {
+            continue;
+        }
+
+        if (pSlot->txCount)
+        {
+            timeoutMs = OtaClient_GetBlockTimeout(pSlot->txCount);
+
+            if (currentTimeMs - pSlot->sentTimeMs < timeoutMs)
+            {
+                timeoutMs -= currentTimeMs - pSlot->sentTimeMs;
+                nextTimeoutMs = (timeoutMs < nextTimeoutMs) ? timeoutMs : nextTimeoutMs;
+                continue;
+            }
+
+            /* Request or response lost: slow down once per pass */
+            if (!lost)
+            {
+                lost = TRUE;
+                mOtaClientWindow.size = (mOtaClientWindow.size > 1) ? (mOtaClientWindow.size >> 1) : 1;
+                mOtaClientWindow.ackCount = 0;
+            }
+
+            mOtaClientSession.noOfRetries++;
+        }
+        else if (i >= mOtaClientWindow.size)
+        {
+            continue;
+        }
+
+        OtaClient_SendBlockReqAt(fileOffset);
+        pSlot->sentTimeMs = currentTimeMs;
+
+        if (pSlot->txCount < THR_ALL_FFs8)
+        {
+            pSlot->txCount++;
+        }
+
+        timeoutMs = OtaClient_GetBlockTimeout(pSlot->txCount);
+        nextTimeoutMs = (timeoutMs < nextTimeoutMs) ? timeoutMs : nextTimeoutMs;
+    }
+
+    if (mOtaClientSession.noOfRetries > gOtaClientMaxRetries_c)
+    {
+        /* abort current session */
+        OtaClient_PrepareNextReq(gOtaFileStatus_Abort_c, 0);
+    }
+    else
+    {
+        TMR_StartSingleShotTimer(mOtaClientSetup.otaClientTmr, nextTimeoutMs,
+                                 OtaClient_TimerCallback, (void *)&bStart);
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaClient_BlockReceived(uint32_t slotIdx, otaServerInfo_t *pOtaServerInfo)
+\brief  This function is used to keep a received block in its window slot. The round trip time is
+        measured on the blocks requested once, and the window grows by one slot per window of
+        blocks received.
+
+\param  [in]   slotIdx           Window slot of the block
+\param  [in]   pOtaServerInfo    Block response, freed when processed
+ ***************************************************************************************************/
+static void OtaClient_BlockReceived
+(
+    uint32_t slotIdx,
+    otaServerInfo_t *pOtaServerInfo
+)
+{
+    otaClientBlockSlot_t *pSlot = &mOtaClientWindow.slot[slotIdx];
+
+    pSlot->pBlockRsp = pOtaServerInfo;
+
+    if (1 == pSlot->txCount)
+    {
+        uint32_t rttMs = OtaClient_GetTimeMs() - pSlot->sentTimeMs;
+
+        if (0 == mOtaClientWindow.srttMs8)
+        {
+            mOtaClientWindow.srttMs8 = rttMs << 3;
+            mOtaClientWindow.rttVarMs4 = rttMs << 1;
+        }
+        else
+        {
+            uint32_t srttMs = mOtaClientWindow.srttMs8 >> 3;
+            uint32_t deltaMs = (rttMs > srttMs) ? (rttMs - srttMs) : (srttMs - rttMs);
+
+            /* srtt += (rtt - srtt) / 8, rttVar += (|rtt - srtt| - rttVar) / 4 */
+            mOtaClientWindow.srttMs8 = mOtaClientWindow.srttMs8 - srttMs + rttMs;
+            mOtaClientWindow.rttVarMs4 = mOtaClientWindow.rttVarMs4 - (mOtaClientWindow.rttVarMs4 >> 2) + deltaMs;
+        }
+
+        /* timeout = srtt + 4 * rttVar */
+        mOtaClientWindow.timeoutMs = (mOtaClientWindow.srttMs8 >> 3) + mOtaClientWindow.rttVarMs4;
+
+        if (mOtaClientWindow.timeoutMs < gOtaClientMinBlockTimeoutMs_c)
+        {
+            mOtaClientWindow.timeoutMs = gOtaClientMinBlockTimeoutMs_c;
+        }
+        else if (mOtaClientWindow.timeoutMs > gOtaClientDeclareErrorMs_c)
+        {
+            mOtaClientWindow.timeoutMs = gOtaClientDeclareErrorMs_c;
+        }
+    }
+
+    if (++mOtaClientWindow.ackCount >= mOtaClientWindow.size)
+    {
+        mOtaClientWindow.ackCount = 0;
+
+        if (mOtaClientWindow.size < gOtaClientMaxBlockWindow_c)
+        {
+            mOtaClientWindow.size++;
+        }
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaClient_ProcessBlockWindow(void)
+\brief  This function is used to process the blocks received in file order, from the first slot
+        of the window, and to send the next requests.
+ ***************************************************************************************************/
+static void OtaClient_ProcessBlockWindow
+(
+    void
+)
+{
+    otaResult_t status = gOtaSucess_c;
+
+    while ((status == gOtaSucess_c) && (NULL != mOtaClientWindow.slot[0].pBlockRsp))
+    {
+        otaServerInfo_t *pOtaServerInfo = mOtaClientWindow.slot[0].pBlockRsp;
+        uint32_t blockEnd = mOtaClientSession.fileOffset + gOtaMaxBlockDataSize_c;
+        uint32_t i;
+
+        /* Slide the window by one block */
+        for (i = 1; i < gOtaClientMaxBlockWindow_c; i++)
+        {
+            mOtaClientWindow.slot[i - 1] = mOtaClientWindow.slot[i];
+        }
+
+        FLib_MemSet(&mOtaClientWindow.slot[gOtaClientMaxBlockWindow_c - 1], 0, sizeof(otaClientBlockSlot_t));
+
+        status = OtaClient_ProcessBlock(pOtaServerInfo);
+        mOtaClientSession.noOfRetries = 0;
+
+        if ((status == gOtaSucess_c) && (mOtaClientSession.fileOffset != blockEnd) &&
+                (mOtaClientSession.fileOffset < mOtaClientSession.fileLength))
+        {
+            /* Short block: the next slots do not match the file offset any more */
+            OtaClient_ResetBlockWindow(FALSE);
+        }
+    }
+
+    if (status != gOtaSucess_c)
+    {
+        OtaClient_ResetBlockWindow(FALSE);
+        (void)NWKU_SendMsg(OtaClient_CoapSendUpgradeEndReq, NULL, mpOtaClientMsgQueue);
+    }
+    else if ((mOtaClientSession.state == gOtaClientState_BlockReq_c) &&
+             (mOtaClientSession.blockReqState != gOtaClientBlockReqState_ValidateSignature_c))
+    {
+        OtaClient_FillBlockWindow();
+    }
+    else
+    {
+        OtaClient_ResetBlockWindow(FALSE);
+        OtaClient_SendNextReq(NULL);
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaClient_ResetBlockWindow(bool_t restart)
+\brief  This function is used to drop the blocks and the requests of the download window.
+
+\param  [in]   restart    If TRUE, the window size and the round trip time are set back to their
+                          initial values
+ ***************************************************************************************************/
+static void OtaClient_ResetBlockWindow
+(
+    bool_t restart
+)
+{
+    uint32_t i;
+
+    for (i = 0; i < gOtaClientMaxBlockWindow_c; i++)
+    {
+        if (mOtaClientWindow.slot[i].pBlockRsp)
+        {
+            MEM_BufferFree(mOtaClientWindow.slot[i].pBlockRsp);
+        }
+    }
+
+    FLib_MemSet(mOtaClientWindow.slot, 0, sizeof(mOtaClientWindow.slot));
+
+    if (restart)
+    {
+        mOtaClientWindow.srttMs8 = 0;
+        mOtaClientWindow.rttVarMs4 = 0;
+        mOtaClientWindow.timeoutMs = gOtaClientDeclareErrorMs_c;
+        mOtaClientWindow.size = gOtaClientInitialBlockWindow_c;
+        mOtaClientWindow.ackCount = 0;
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static uint32_t OtaClient_GetBlockTimeout(uint8_t txCount)
+\brief  Return the timeout of a block request, doubled on each retransmission.
+
+\param  [in]   txCount    Number of times the block was requested
+
+\return        uint32_t   Timeout [miliseconds]
+ ***************************************************************************************************/
+static uint32_t OtaClient_GetBlockTimeout
+(
+    uint8_t txCount
+)
+{
+    uint32_t timeoutMs = mOtaClientWindow.timeoutMs;
+
+    while ((--txCount) && (timeoutMs < gOtaClientDeclareErrorMs_c))
+    {
+        timeoutMs <<= 1;
+    }
+
+    return (timeoutMs < gOtaClientDeclareErrorMs_c) ? timeoutMs : gOtaClientDeclareErrorMs_c;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static uint32_t OtaClient_GetTimeMs(void)
+\brief  Return the current time, used for the round trip time.
+
+\return        uint32_t   Time stamp [miliseconds]
+ ***************************************************************************************************/
+static uint32_t OtaClient_GetTimeMs
+(
+    void
+)
+{
+    return (uint32_t)(TMR_GetTimestamp() / 1000);
+}
+
 /*!*************************************************************************************************
 \private
 \fn     static void OtaClient_CoapSendUpgradeEndReq(void *pParam)
@@ -964,7 +1347,7 @@ static void OtaClient_CoapSendUpgradeEndReq
     if (pSession)
     {
         otaCmd_UpgradeEndReq_t upgradeEndReq = {gOtaCmd_UpgradeEndReq_c, gOtaFileStatus_Abort_c,
-                                                gOtaManufacturerCode_c, gOtaCurrentImageType_c,
+                                                {gOtaManufacturerCode_c}, {gOtaCurrentImageType_c},
                                                 {0x00, 0x00, 0x00, 0x00}
                                                };
 
@@ -1008,7 +1391,7 @@ static void OtaClient_CoapSendServerDiscovery
 
     if (pSession)
     {
-        otaCmd_ServerDiscovery_t serverDiscoveryCmd = {gOtaCmd_ServerDiscovery_c, gOtaManufacturerCode_c, gOtaCurrentImageType_c};
+        otaCmd_ServerDiscovery_t serverDiscoveryCmd = {gOtaCmd_ServerDiscovery_c, {gOtaManufacturerCode_c}, {gOtaCurrentImageType_c}};
 
         pSession->ipIfId = gIpIfSlp0_c;
         pSession->pCallback = NULL;
@@ -1026,18 +1409,20 @@ static void OtaClient_CoapSendServerDiscovery
 
 /*!*************************************************************************************************
 \private
-\fn     static void OtaClient_ProcessBlock(void *pParam)
+\fn     static otaResult_t OtaClient_ProcessBlock(otaServerInfo_t *pOtaServerInfo)
 \brief  This function is used to process block received.
 
-\param  [in]   pParam    Pointer to data
+\param  [in]   pOtaServerInfo    Block response at the file offset, freed
+
+\return        otaResult_t       Result of the operation
  ***************************************************************************************************/
-static void OtaClient_ProcessBlock
+static otaResult_t OtaClient_ProcessBlock
 (
-    void *pParam
+    otaServerInfo_t *pOtaServerInfo
 )
 {
     otaResult_t status = gOtaSucess_c;
-    otaCmd_BlockRsp_t *pBlockRsp = (otaCmd_BlockRsp_t *)((otaServerInfo_t *)pParam)->pData;
+    otaCmd_BlockRsp_t *pBlockRsp = (otaCmd_BlockRsp_t *)pOtaServerInfo->pData;
     uint32_t bytesToProcess = pBlockRsp->data.success.dataSize;
     uint8_t *pData = pBlockRsp->data.success.pData;
     uint32_t bytesProcessed = 0;
@@ -1082,16 +1467,9 @@ static void OtaClient_ProcessBlock
         }
     }
 
-    MEM_BufferFree(pParam);
+    MEM_BufferFree(pOtaServerInfo);
 
-    if (status != gOtaSucess_c)
-    {
-        (void)NWKU_SendMsg(OtaClient_CoapSendUpgradeEndReq, NULL, mpOtaClientMsgQueue);
-    }
-    else
-    {
-        OtaClient_SendNextReq(NULL);
-    }
+    return status;
 }
 
 /*!*************************************************************************************************
@@ -1104,13 +1482,20 @@ static void OtaClient_InitSignature
     void
 )
 {
+#if (gOtaClientSignature_c == gOtaClientSignatureSha256_c)
+    SHA256_Init(&mOtaClientSession.signature.sha256);
+#elif (gOtaClientSignature_c == gOtaClientSignatureCmac_c)
+    AES_128_CMAC_Init(&mOtaClientSession.signature.cmac, maOtaClientSignatureKey);
+#else
     mOtaClientSession.signature.crcValue = 0;
+#endif
 }
 
 /*!*************************************************************************************************
 \private
 \fn     static void OtaClient_ComputeSignature(uint8_t *pData, uint32_t dataLen)
 \brief  This function is used to compute image signature based on current block received.
+        The data is fed to the signature engine as it arrives, in pieces of any length.
 
 \param  [in]   pData      Pointer to data
 \param  [in]   dataLen    Data length
@@ -1121,7 +1506,35 @@ static void OtaClient_ComputeSignature
     uint32_t dataLen
 )
 {
+#if (gOtaClientSignature_c == gOtaClientSignatureSha256_c)
+    SHA256_HashUpdate(&mOtaClientSession.signature.sha256, pData, dataLen);
+#elif (gOtaClientSignature_c == gOtaClientSignatureCmac_c)
+    AES_128_CMAC_Update(&mOtaClientSession.signature.cmac, pData, dataLen);
+#else
     mOtaClientSession.signature.crcValue = OTA_CrcCompute(pData, dataLen, mOtaClientSession.signature.crcValue);
+#endif
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaClient_FinishSignature(uint8_t *pSignature)
+\brief  This function is used to end the image signature computation.
+
+\param  [out]  pSignature    Computed signature, mOtaClientSignatureSize_c bytes
+ ***************************************************************************************************/
+static void OtaClient_FinishSignature
+(
+    uint8_t *pSignature
+)
+{
+#if (gOtaClientSignature_c == gOtaClientSignatureSha256_c)
+    SHA256_HashFinish(&mOtaClientSession.signature.sha256, NULL, 0);
+    FLib_MemCpy(pSignature, mOtaClientSession.signature.sha256.hash, SHA256_HASH_SIZE);
+#elif (gOtaClientSignature_c == gOtaClientSignatureCmac_c)
+    AES_128_CMAC_Finish(&mOtaClientSession.signature.cmac, pSignature);
+#else
+    FLib_MemCpy(pSignature, &mOtaClientSession.signature.crcValue, sizeof(uint32_t));
+#endif
 }
 
 /*!*************************************************************************************************
@@ -1145,6 +1558,7 @@ static otaResult_t OtaClient_StartDownload
 {
     otaResult_t status = gOtaSucess_c;
 
+    (void)bytesToProcess;
     pData = pData + sizeof(uint32_t) + sizeof(uint16_t);
     OtaClient_InitSignature();
 
@@ -1408,6 +1822,13 @@ static otaResult_t OtaClient_ProcessSubElement
             case gZclOtaFileIntegrityCodeTagId:
             {
                 mOtaClientSession.blockReqState = gOtaClientBlockReqState_ValidateSignature_c;
+
+                if ((subElementLength < mOtaClientSignatureMinSize_c) ||
+                    (subElementLength > mOtaClientSignatureSize_c))
+                {
+                    /* Not a signature of the configured engine */
+                    status = gOtaCrcError_c;
+                }
             }
             break;
 
@@ -1545,7 +1966,7 @@ static otaResult_t OtaClient_ValidateSignature
         else
         {
             status =  gOtaError_c;
-            mOtaClientSession.pTempBuffer = MEM_BufferAlloc(sizeof(otaFileSubElement_t));
+            mOtaClientSession.pTempBuffer = MEM_BufferAlloc(mOtaClientSession.bytesPerState);
 
             if (mOtaClientSession.pTempBuffer)
             {
@@ -1579,9 +2000,13 @@ static otaResult_t OtaClient_ValidateSignature
 
     if (processData && pSignature)
     {
+        uint8_t computedSignature[mOtaClientSignatureSize_c];
+
         status =  gOtaCrcError_c;
+        OtaClient_FinishSignature(computedSignature);
 
-        if (FLib_MemCmp(pSignature, &mOtaClientSession.signature, mOtaClientSession.bytesPerState))
+        /* Constant time, a mismatch must not tell where it is */
+        if (SecLib_VerifyEqual(pSignature, computedSignature, mOtaClientSession.bytesPerState))
         {
             status = OTA_CommitImage(mOtaClientSession.pBitmap);
 
@@ -1623,6 +2048,7 @@ static void OtaClient_AbortSession
         mOtaClientSession.pTempBuffer = NULL;
     }
 
+    OtaClient_ResetBlockWindow(TRUE);
     OtaClient_ActivityLed(gOtaLedOff_c);
     FLib_MemSet(&mOtaClientSession, 0, sizeof(otaClientSession_t));
     mOtaClientSession.state = gOtaClientState_Idle_c;
@@ -1727,6 +2153,7 @@ static void OtaClient_ErrorHandler
     void *pParam
 )
 {
+    (void)pParam;
     if ((mOtaClientSession.noOfRetries > gOtaClientMaxRetries_c) ||
             (mOtaClientSession.state == gOtaClientState_Idle_c))
     {
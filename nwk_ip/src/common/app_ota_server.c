@@ -100,6 +100,23 @@ Private macros
 
 #define gOtaServer_ThciBlockRequestRetryNo_c      5
 #define gOtaServer_ThciBlockRequestTimeoutMs_c    1000
+
+/* Image blocks kept in RAM and shared by all client sessions, 0 disables the cache */
+#ifndef gOtaServer_BlockCacheEntries_c
+    #define gOtaServer_BlockCacheEntries_c               16
+#endif
+
+/* MEM buffers left free for the stack: above this reserve a new block takes a new buffer,
+   otherwise the least recently used block is recycled */
+#ifndef gOtaServer_BlockCacheMinFreeBuffers_c
+    #define gOtaServer_BlockCacheMinFreeBuffers_c        8
+#endif
+
+/* Dongle mode: blocks fetched from the host ahead of each client's next offset while the
+   THCI link is idle, 0 disables the read-ahead */
+#ifndef gOtaServer_BlockReadAheadDepth_c
+    #define gOtaServer_BlockReadAheadDepth_c             1
+#endif
 /*==================================================================================================
 Private type definitions
 ==================================================================================================*/
@@ -152,8 +169,37 @@ typedef struct otaClientSessionInfo_tag
 {
     ipAddr_t  remoteAddr;
     uint64_t  timeStamp;
+    uint32_t  fileVersion;
+    uint32_t  nextOffset;      /* offset following the last block request */
+    uint8_t   blockSize;       /* 0 until the client requests a block */
 } otaClientSessionInfo_t;
 
+typedef struct otaServerBlockCacheEntry_tag
+{
+    uint32_t  fileVersion;
+    uint32_t  offset;
+    uint32_t  lastUse;
+    uint32_t  generation;      /* entries of an older generation are stale */
+    uint8_t   *pData;          /* NULL when the entry is free */
+    uint8_t   dataSize;
+    uint8_t   reqSize;         /* a block shorter than requested is the end of the file */
+} otaServerBlockCacheEntry_t;
+
+typedef struct otaServerBlockFetch_tag
+{
+    uint32_t  fileVersion;
+    uint32_t  offset;
+    uint8_t   dataSize;
+    bool_t    isActive;
+} otaServerBlockFetch_t;
+
+typedef struct otaServerDongleImage_tag
+{
+    uint32_t  fileVersion;
+    uint32_t  fileSize;
+    bool_t    isValid;
+} otaServerDongleImage_t;
+
 /*==================================================================================================
 Private function prototypes
 ==================================================================================================*/
@@ -190,12 +236,24 @@ static bool_t OtaServer_AddClientToAbortList(uint16_t clientId);
 static bool_t OtaServer_RemoveClientFromAbortList(uint16_t clientId);
 static otaStatus_t OtaServer_CheckClientSessionTable(otaClientInfo_t *pOtaClientInfo);
 static otaStatus_t OtaServer_HandleBlockSocket(bool_t onOff);
+static void OtaServer_SessionSetNextBlock(otaClientInfo_t *pOtaClientInfo, uint32_t fileVersion,
+                                          uint32_t offset, uint8_t blockSize);
+
+/* Block cache */
+static otaServerBlockCacheEntry_t *OtaServer_BlockCacheFind(uint32_t fileVersion, uint32_t offset,
+                                                            uint8_t dataSize, bool_t touch);
+static void OtaServer_BlockCacheStore(uint32_t fileVersion, uint32_t offset, uint8_t reqSize,
+                                      uint8_t *pData, uint8_t dataSize);
+static void OtaServer_BlockCacheFlush(void);
+static bool_t OtaServer_BlockCacheServe(otaClientInfo_t *pOtaClientInfo);
+static void OtaServer_BlockCacheServeQueued(uint32_t fileVersion, uint32_t offset);
 
 /* OTA Server dongle functions: */
 static otaStatus_t OtaServerDongle_QueryImageReqHandler(otaClientInfo_t *pOtaClientInfo);
 static otaStatus_t OtaServerDongle_BlockReqHandler(otaClientInfo_t *pOtaClientInfo);
 static otaStatus_t OtaServerDongle_ServerDiscoveryHandler(otaClientInfo_t *pOtaClientInfo);
 static void OtaServerDongle_SendBlockRsp(void *pParam);
+static void OtaServerDongle_ReadAhead(void);
 
 #if gOtaServer_EnableStandaloneMode_c
     /* OTA Server standalone functions: */
@@ -260,6 +318,19 @@ static otaServer_AppCB_t mThciOtaServerCb =
 };
 
 static otaClientSessionInfo_t mOtaClientSessionInfoTable[gOtaServer_MaxSimultaneousClients_c];
+
+#if gOtaServer_BlockCacheEntries_c
+/* Image blocks shared by the client sessions */
+static otaServerBlockCacheEntry_t mOtaServerBlockCache[gOtaServer_BlockCacheEntries_c];
+static uint32_t mOtaServerBlockCacheClock = 0;
+#endif
+static volatile uint32_t mOtaServerBlockCacheGeneration = 0;
+
+/* Dongle mode: block requested from the host without a client waiting for it (read-ahead) */
+static otaServerBlockFetch_t mOtaServerBlockFetch;
+
+/* Dongle mode: image announced by the host in the last Query Image response */
+static otaServerDongleImage_t mOtaServerDongleImage;
 #if gOtaServer_EnableStandaloneMode_c
     static uint8_t mOtaServer_ThciBlockRequestRetryNo = gOtaServer_ThciBlockRequestRetryNo_c;
 #endif
@@ -292,7 +363,7 @@ otaStatus_t OtaServerInit
 
         if (gTmrInvalidTimerID_c == mOtaServerSetup.otaServerTmr)
         {
-            panic(0, (uint32_t)OtaServerInit, 0, 0);
+            panic(0, (uint32_t)(uintptr_t)OtaServerInit, 0, 0);
             return gOtaStatus_NoTimers_c;
         }
     }
@@ -367,6 +438,7 @@ otaStatus_t OtaClient_StartServerImageNotify
     void *param
 )
 {
+    (void)param;
 #if gOtaServer_EnableStandaloneMode_c
     otaStatus_t otaStatus = gOtaStatus_Failed_c;
 
@@ -504,7 +576,12 @@ static void OtaServer_ClientProcess
         {
             if (mOtaServerSetup.opMode == gOtaServerOpMode_Dongle_c)
             {
-                if ((NULL == mpOtaServerTempClientInfo) && (0 == mOtaServerThciClientInfoQueue.size))
+                if (OtaServer_BlockCacheServe(pOtaClientInfo))
+                {
+                    /* Served from RAM, the host is not involved */
+                }
+                else if ((NULL == mpOtaServerTempClientInfo) && (FALSE == mOtaServerBlockFetch.isActive) &&
+                         (0 == mOtaServerThciClientInfoQueue.size))
                 {
                     /* Process client */
                     OtaServer_CmdProcess(pOtaClientInfo);
@@ -586,6 +663,7 @@ static otaStatus_t OtaServer_CheckClientSessionTable
     {
         IP_AddrCopy(&mOtaClientSessionInfoTable[firstExpiredEntry].remoteAddr, &pOtaClientInfo->remoteAddr);
         mOtaClientSessionInfoTable[firstExpiredEntry].timeStamp = pOtaClientInfo->timeStamp;
+        mOtaClientSessionInfoTable[firstExpiredEntry].blockSize = 0;
         status = gOtaStatus_Success_c;
     }
 
@@ -783,7 +861,7 @@ static otaStatus_t OtaServer_UpgradeEndReqHandler
 )
 {
     otaStatus_t status = gOtaStatus_Failed_c;
-    otaCmd_UpgradeEndRsp_t upgradeRsp = {gOtaCmd_UpgradeEndRsp_c, 0x00};
+    otaCmd_UpgradeEndRsp_t upgradeRsp = {.commandId = gOtaCmd_UpgradeEndRsp_c, .status = 0x00};
     uint32_t timeInMs = NWKU_GetTimestampMs();
 
     FLib_MemCpy(&upgradeRsp.data.success.currentTime, &timeInMs, sizeof(uint32_t));
@@ -1029,7 +1107,7 @@ static otaStatus_t OtaServer_CoapSendRspWaitAbortData
     if (status != gOtaFileStatus_Success_c)
     {
         /* All busy / abort responses have the same structure as queryRsp*/
-        otaCmd_QueryImageRsp_t queryRsp = {gOtaCmd_QueryImageRsp_c, gOtaFileStatus_ServerBusy_c, {0x00}};
+        otaCmd_QueryImageRsp_t queryRsp = {.commandId = gOtaCmd_QueryImageRsp_c, .status = gOtaFileStatus_ServerBusy_c};
         uint8_t len = 2 + sizeof(otaCmd_QueryImageRspWait_t);
         uint8_t otaCommand = *pOtaClientInfo->pData;
         uint32_t timeInMs = NWKU_GetTimestampMs();
@@ -1086,16 +1164,40 @@ static void OtaServerDongle_SendBlockRsp
 {
     otaCmd_BlockRsp_t *pBlockRsp = (otaCmd_BlockRsp_t *)pParam;
     otaClientInfo_t *pTempClient = mpOtaServerTempClientInfo;
+    otaCmd_BlockReq_t *pBlockReq;
+    uint32_t fileVersion;
+    uint32_t offset;
+    uint8_t reqSize = mOtaServerBlockFetch.dataSize;
 
     mpOtaServerTempClientInfo = NULL;
+    mOtaServerBlockFetch.isActive = FALSE;
+
+    FLib_MemCpy(&fileVersion, pBlockRsp->data.success.fileVersion, sizeof(uint32_t));
+    FLib_MemCpy(&offset, pBlockRsp->data.success.fileOffset, sizeof(uint32_t));
+
+    if (pTempClient)
+    {
+        pBlockReq = (otaCmd_BlockReq_t *)pTempClient->pData;
+        reqSize = pBlockReq->maxDataSize;
+    }
+
+    OtaServer_BlockCacheStore(fileVersion, offset, reqSize, pBlockRsp->data.success.pData,
+                              pBlockRsp->data.success.dataSize);
 
     if (pTempClient)
     {
         (void)OtaServer_SocketSendRsp(pTempClient, (uint8_t *)pBlockRsp,
                                       sizeof(otaCmd_BlockRsp_t) - 1 + pBlockRsp->data.success.dataSize);
     }
+    else
+    {
+        OtaServer_ProcessNextClient();
+    }
 
     MEM_BufferFree(pBlockRsp);
+
+    /* Clients that queued for the same block while it was fetched */
+    OtaServer_BlockCacheServeQueued(fileVersion, offset);
 }
 
 /*!*************************************************************************************************
@@ -1110,6 +1212,7 @@ static void OtaServer_CloseThciSessionTimeoutCb
     void *pParam
 )
 {
+    (void)pParam;
     if (FALSE == NWKU_SendMsg(OtaServer_CloseThciSessionTimeout, NULL, mpOtaServerMsgQueue))
     {
         TMR_StartSingleShotTimer(mOtaServerSetup.otaServerTmr, gOtaServer_CloseThciSessionTimeoutMs_c,
@@ -1129,12 +1232,14 @@ static void OtaServer_CloseThciSessionTimeout
     void *pParam
 )
 {
+    (void)pParam;
     if (mpOtaServerTempClientInfo)
     {
         MEM_BufferFree(mpOtaServerTempClientInfo);
         mpOtaServerTempClientInfo = NULL;
     }
 
+    mOtaServerBlockFetch.isActive = FALSE;
     OtaServer_ProcessNextClient();
 }
 
@@ -1292,6 +1397,11 @@ static otaStatus_t OtaServerDongle_BlockReqHandler
 
     FLib_MemCpy(&offset, pBlockReq->fileOffset, sizeof(offset));
 
+    if (OtaServer_BlockCacheServe(pOtaClientInfo))
+    {
+        return gOtaStatus_Success_c;
+    }
+
     /* Should not end up here. Earlier in the call stack there already should be a check for the value of mpOtaServerTempClientInfo to be NULL. Just a safety check */
     if (mpOtaServerTempClientInfo != NULL)
     {
@@ -1300,6 +1410,11 @@ static otaStatus_t OtaServerDongle_BlockReqHandler
     }
     else
     {
+        uint32_t fileVersion;
+
+        FLib_MemCpy(&fileVersion, pBlockReq->fileVersion, sizeof(fileVersion));
+        OtaServer_SessionSetNextBlock(pOtaClientInfo, fileVersion, offset, pBlockReq->maxDataSize);
+
         mpOtaServerTempClientInfo = pOtaClientInfo; /* Store the data for the current client that is served. */
         TMR_StartSingleShotTimer(mOtaServerSetup.otaServerTmr, gOtaServer_CloseThciSessionTimeoutMs_c,
                                  OtaServer_CloseThciSessionTimeoutCb, NULL);
@@ -1355,6 +1470,430 @@ static otaStatus_t OtaServerDongle_ServerDiscoveryHandler
     return status;
 }
 
+/*************************************************************************************************
+*
+*  OTA Server block cache functions
+*
+**************************************************************************************************/
+/*!*************************************************************************************************
+\private
+\fn     static void OtaServer_SessionSetNextBlock(otaClientInfo_t *pOtaClientInfo, uint32_t fileVersion,
+                                                  uint32_t offset, uint8_t blockSize)
+\brief  This function is used to record the block a client is expected to request next.
+
+\param  [in]    pOtaClientInfo    Pointer to client info
+\param  [in]    fileVersion       File version requested by the client
+\param  [in]    offset            Offset of the block being served
+\param  [in]    blockSize         Block size requested by the client
+***************************************************************************************************/
+static void OtaServer_SessionSetNextBlock
+(
+    otaClientInfo_t *pOtaClientInfo,
+    uint32_t fileVersion,
+    uint32_t offset,
+    uint8_t blockSize
+)
+{
+    uint8_t idxInfoTable;
+
+    for (idxInfoTable = 0; idxInfoTable < gOtaServer_MaxSimultaneousClients_c; idxInfoTable++)
+    {
+        if (IP_IsAddrEqual(&pOtaClientInfo->remoteAddr, &mOtaClientSessionInfoTable[idxInfoTable].remoteAddr))
+        {
+            mOtaClientSessionInfoTable[idxInfoTable].fileVersion = fileVersion;
+            mOtaClientSessionInfoTable[idxInfoTable].nextOffset = offset + blockSize;
+            mOtaClientSessionInfoTable[idxInfoTable].blockSize = blockSize;
+            break;
+        }
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static otaServerBlockCacheEntry_t *OtaServer_BlockCacheFind(uint32_t fileVersion, uint32_t offset,
+                                                                    uint8_t dataSize, bool_t touch)
+\brief  This function is used to look up an image block in the cache.
+
+\param  [in]    fileVersion    File version
+\param  [in]    offset         Block offset
+\param  [in]    dataSize       Requested block size
+\param  [in]    touch          If TRUE, the entry becomes the most recently used
+
+\return         otaServerBlockCacheEntry_t *    Cache entry, NULL if the block is not cached
+***************************************************************************************************/
+static otaServerBlockCacheEntry_t *OtaServer_BlockCacheFind
+(
+    uint32_t fileVersion,
+    uint32_t offset,
+    uint8_t dataSize,
+    bool_t touch
+)
+{
+#if gOtaServer_BlockCacheEntries_c
+    otaServerBlockCacheEntry_t *pEntry = mOtaServerBlockCache;
+    uint8_t i;
+
+    for (i = 0; i < gOtaServer_BlockCacheEntries_c; i++, pEntry++)
+    {
+        if ((NULL != pEntry->pData) && (pEntry->generation == mOtaServerBlockCacheGeneration) &&
+                (pEntry->fileVersion == fileVersion) && (pEntry->offset == offset) &&
+                ((pEntry->dataSize >= dataSize) || (pEntry->dataSize < pEntry->reqSize)))
+        {
+            if (touch)
+            {
+                pEntry->lastUse = ++mOtaServerBlockCacheClock;
+            }
+
+            return pEntry;
+        }
+    }
+
+#else
+    (void)fileVersion;
+    (void)offset;
+    (void)dataSize;
+    (void)touch;
+#endif
+    return NULL;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaServer_BlockCacheStore(uint32_t fileVersion, uint32_t offset, uint8_t reqSize,
+                                              uint8_t *pData, uint8_t dataSize)
+\brief  This function is used to add an image block to the cache. A new buffer is only taken while
+        the memory manager keeps gOtaServer_BlockCacheMinFreeBuffers_c buffers free, otherwise the
+        least recently used block is recycled.
+
+\param  [in]    fileVersion    File version
+\param  [in]    offset         Block offset
+\param  [in]    reqSize        Block size that was requested
+\param  [in]    pData          Block data
+\param  [in]    dataSize       Block size
+***************************************************************************************************/
+static void OtaServer_BlockCacheStore
+(
+    uint32_t fileVersion,
+    uint32_t offset,
+    uint8_t reqSize,
+    uint8_t *pData,
+    uint8_t dataSize
+)
+{
+#if gOtaServer_BlockCacheEntries_c
+    otaServerBlockCacheEntry_t *pEntry = mOtaServerBlockCache;
+    otaServerBlockCacheEntry_t *pFree = NULL;
+    otaServerBlockCacheEntry_t *pLru = NULL;
+    uint8_t i;
+
+    if ((0 == dataSize) || (NULL != OtaServer_BlockCacheFind(fileVersion, offset, dataSize, TRUE)))
+    {
+        return;
+    }
+
+    for (i = 0; i < gOtaServer_BlockCacheEntries_c; i++, pEntry++)
+    {
+        if (NULL == pEntry->pData)
+        {
+            if (NULL == pFree)
+            {
+                pFree = pEntry;
+            }
+        }
+        else if ((NULL == pLru) || (pEntry->generation != mOtaServerBlockCacheGeneration) ||
+                 ((pLru->generation == mOtaServerBlockCacheGeneration) &&
+                  ((int32_t)(pEntry->lastUse - pLru->lastUse) < 0)))
+        {
+            /* Stale blocks go first, then the least recently used one */
+            pLru = pEntry;
+        }
+    }
+
+    if ((NULL != pFree) && (MEM_GetAvailableBlocks(dataSize) > gOtaServer_BlockCacheMinFreeBuffers_c))
+    {
+        pFree->pData = MEM_BufferAlloc(dataSize);
+
+        if (NULL != pFree->pData)
+        {
+            pEntry = pFree;
+        }
+        else
+        {
+            pEntry = pLru;
+        }
+    }
+    else
+    {
+        pEntry = pLru;
+    }
+
+    if (NULL == pEntry)
+    {
+        return;
+    }
+
+    if ((pEntry != pFree) && (MEM_BufferGetSize(pEntry->pData) < dataSize))
+    {
+        /* Recycled buffer too small for this block */
+        MEM_BufferFree(pEntry->pData);
+        pEntry->pData = MEM_BufferAlloc(dataSize);
+
+        if (NULL == pEntry->pData)
+        {
+            return;
+        }
+    }
+
+    FLib_MemCpy(pEntry->pData, pData, dataSize);
+    pEntry->fileVersion = fileVersion;
+    pEntry->offset = offset;
+    pEntry->dataSize = dataSize;
+    pEntry->reqSize = reqSize;
+    pEntry->generation = mOtaServerBlockCacheGeneration;
+    pEntry->lastUse = ++mOtaServerBlockCacheClock;
+#else
+    (void)fileVersion;
+    (void)offset;
+    (void)reqSize;
+    (void)pData;
+    (void)dataSize;
+#endif
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaServer_BlockCacheFlush(void)
+\brief  This function is used to invalidate the cached blocks when the served image changes. It may
+        run outside the OTA server task, so the buffers are only recycled by later stores.
+***************************************************************************************************/
+static void OtaServer_BlockCacheFlush
+(
+    void
+)
+{
+    mOtaServerBlockCacheGeneration++;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static bool_t OtaServer_BlockCacheServe(otaClientInfo_t *pOtaClientInfo)
+\brief  This function is used to answer a BlockRequest command from the cache. On success the
+        client info is consumed.
+
+\param  [in]    pOtaClientInfo    Pointer to client info
+
+\return         bool_t            TRUE if the block was served, FALSE if the request must be handled
+                                  by the current operation mode
+***************************************************************************************************/
+static bool_t OtaServer_BlockCacheServe
+(
+    otaClientInfo_t *pOtaClientInfo
+)
+{
+    otaCmd_BlockReq_t *pBlockReq = (otaCmd_BlockReq_t *)pOtaClientInfo->pData;
+    otaServerBlockCacheEntry_t *pEntry;
+    otaCmd_BlockRsp_t *pBlockRsp;
+    uint16_t clientId = (pOtaClientInfo->remoteAddr.addr8[14] << 8) + pOtaClientInfo->remoteAddr.addr8[15];
+    uint32_t respLength;
+    uint32_t fileVersion;
+    uint32_t offset;
+    uint8_t len;
+
+    if ((gOtaCmd_BlockReq_c != pBlockReq->commandId) || (FALSE == OtaServer_IsClientValid(clientId)))
+    {
+        return FALSE;
+    }
+
+    FLib_MemCpy(&fileVersion, pBlockReq->fileVersion, sizeof(uint32_t));
+    FLib_MemCpy(&offset, pBlockReq->fileOffset, sizeof(uint32_t));
+    pEntry = OtaServer_BlockCacheFind(fileVersion, offset, pBlockReq->maxDataSize, TRUE);
+
+    if (NULL == pEntry)
+    {
+        return FALSE;
+    }
+
+    len = (pEntry->dataSize < pBlockReq->maxDataSize) ? pEntry->dataSize : pBlockReq->maxDataSize;
+    respLength = 2 + sizeof(otaCmd_BlockRspSuccess_t) - 1 + len;
+    pBlockRsp = MEM_BufferAlloc(respLength);
+
+    if (NULL == pBlockRsp)
+    {
+        /* The client retries the request */
+        MEM_BufferFree(pOtaClientInfo);
+        return TRUE;
+    }
+
+    pBlockRsp->commandId = gOtaCmd_BlockRsp_c;
+    pBlockRsp->status = gOtaFileStatus_Success_c;
+    FLib_MemCpy(pBlockRsp->data.success.fileVersion, pBlockReq->fileVersion, sizeof(uint32_t));
+    FLib_MemCpy(pBlockRsp->data.success.fileOffset, pBlockReq->fileOffset, sizeof(uint32_t));
+    pBlockRsp->data.success.dataSize = len;
+    FLib_MemCpy(pBlockRsp->data.success.pData, pEntry->pData, len);
+
+    OtaServer_SessionSetNextBlock(pOtaClientInfo, fileVersion, offset, pBlockReq->maxDataSize);
+
+    /* send info once at 100 packets */
+    if ((offset == 0) || (((offset / pBlockReq->maxDataSize) % 100) == 0))
+    {
+        OTA_ClientInfoCnf((uint8_t *)&pOtaClientInfo->remoteAddr, offset, clientId);
+    }
+
+    (void)OtaServer_SocketSendRsp(pOtaClientInfo, (uint8_t *)pBlockRsp, respLength);
+    MEM_BufferFree(pBlockRsp);
+
+    return TRUE;
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaServer_BlockCacheServeQueued(uint32_t fileVersion, uint32_t offset)
+\brief  This function is used to answer, from the cache, the queued clients that requested the
+        block just received from the host, so that one host fetch serves all of them.
+
+\param  [in]    fileVersion    File version of the received block
+\param  [in]    offset         Offset of the received block
+***************************************************************************************************/
+static void OtaServer_BlockCacheServeQueued
+(
+    uint32_t fileVersion,
+    uint32_t offset
+)
+{
+    otaClientInfo_t *pQueued = (otaClientInfo_t *)ListGetHeadMsg(&mOtaServerThciClientInfoQueue);
+    otaCmd_BlockReq_t *pBlockReq;
+    uint32_t reqFileVersion;
+    uint32_t reqOffset;
+
+    while (pQueued)
+    {
+        pBlockReq = (otaCmd_BlockReq_t *)pQueued->pData;
+        FLib_MemCpy(&reqFileVersion, pBlockReq->fileVersion, sizeof(uint32_t));
+        FLib_MemCpy(&reqOffset, pBlockReq->fileOffset, sizeof(uint32_t));
+
+        if ((gOtaCmd_BlockReq_c == pBlockReq->commandId) &&
+                (reqFileVersion == fileVersion) && (reqOffset == offset))
+        {
+            (void)ListRemoveMsg(pQueued);
+
+            if (FALSE == OtaServer_BlockCacheServe(pQueued))
+            {
+                /* Not cached after all, back to the queue */
+                (void)MSG_Queue(&mOtaServerThciClientInfoQueue, pQueued);
+                break;
+            }
+
+            /* Serving may have dequeued the next request, start over */
+            pQueued = (otaClientInfo_t *)ListGetHeadMsg(&mOtaServerThciClientInfoQueue);
+        }
+        else
+        {
+            pQueued = (otaClientInfo_t *)ListGetNextMsg(pQueued);
+        }
+    }
+}
+
+/*!*************************************************************************************************
+\private
+\fn     static void OtaServerDongle_ReadAhead(void)
+\brief  This function is used, while the host link is idle, to fetch the block most clients are
+        expected to request next and that is not cached yet. The block is only stored in the cache.
+***************************************************************************************************/
+static void OtaServerDongle_ReadAhead
+(
+    void
+)
+{
+#if gOtaServer_BlockCacheEntries_c && gOtaServer_BlockReadAheadDepth_c
+    otaClientSessionInfo_t *pSession = mOtaClientSessionInfoTable;
+    uint64_t now = TMR_GetTimestamp();
+    uint32_t candidates[gOtaServer_MaxSimultaneousClients_c];
+    uint32_t bestOffset = 0;
+    uint32_t offset;
+    uint8_t bestSize = 0;
+    uint8_t bestCount = 0;
+    uint8_t bestIdx = 0;
+    uint8_t count;
+    uint8_t depth;
+    uint8_t i, j;
+
+    if ((FALSE == mOtaServerDongleImage.isValid) || (FALSE == mOtaServerSetup.isActive))
+    {
+        return;
+    }
+
+    /* First block not cached within the read-ahead window of each active session */
+    for (i = 0; i < gOtaServer_MaxSimultaneousClients_c; i++, pSession++)
+    {
+        candidates[i] = THR_ALL_FFs32;
+
+        if ((0 == pSession->blockSize) || (0 == pSession->timeStamp) ||
+                (pSession->timeStamp + (gOtaServer_ClientSessionExpirationMs_c * 1000) < now) ||
+                (pSession->fileVersion != mOtaServerDongleImage.fileVersion))
+        {
+            continue;
+        }
+
+        for (depth = 0; depth < gOtaServer_BlockReadAheadDepth_c; depth++)
+        {
+            offset = pSession->nextOffset + depth * pSession->blockSize;
+
+            if (offset >= mOtaServerDongleImage.fileSize)
+            {
+                break;
+            }
+
+            if (NULL == OtaServer_BlockCacheFind(pSession->fileVersion, offset, pSession->blockSize, FALSE))
+            {
+                candidates[i] = offset;
+                break;
+            }
+        }
+    }
+
+    /* The block wanted by the most clients, the lowest offset on a tie */
+    for (i = 0; i < gOtaServer_MaxSimultaneousClients_c; i++)
+    {
+        if (THR_ALL_FFs32 == candidates[i])
+        {
+            continue;
+        }
+
+        for (count = 0, j = 0; j < gOtaServer_MaxSimultaneousClients_c; j++)
+        {
+            if (candidates[j] == candidates[i])
+            {
+                count++;
+            }
+        }
+
+        if ((count > bestCount) || ((count == bestCount) && (candidates[i] < bestOffset)))
+        {
+            bestCount = count;
+            bestOffset = candidates[i];
+            bestSize = mOtaClientSessionInfoTable[i].blockSize;
+            bestIdx = i;
+        }
+    }
+
+    if (0 != bestCount)
+    {
+        ipAddr_t *pAddr = &mOtaClientSessionInfoTable[bestIdx].remoteAddr;
+
+        mOtaServerBlockFetch.fileVersion = mOtaServerDongleImage.fileVersion;
+        mOtaServerBlockFetch.offset = bestOffset;
+        mOtaServerBlockFetch.dataSize = bestSize;
+        mOtaServerBlockFetch.isActive = TRUE;
+        TMR_StartSingleShotTimer(mOtaServerSetup.otaServerTmr, gOtaServer_CloseThciSessionTimeoutMs_c,
+                                 OtaServer_CloseThciSessionTimeoutCb, NULL);
+
+        /* wait the host application to reply (see ThciOtaServer_BlockReceivedCnf) */
+        OTA_ImageChunkReq(bestOffset, bestSize, (pAddr->addr8[14] << 8) + pAddr->addr8[15]);
+    }
+
+#endif
+}
+
 #if gOtaServer_EnableStandaloneMode_c
 /*************************************************************************************************
 *
@@ -1562,6 +2101,8 @@ static otaStatus_t OtaServerStandalone_BlockReqHandler
         if (pBlockRsp)
         {
             uint32_t addr = imageOffset + mOtaServerImageList[index].imageAddr;
+            otaServerBlockCacheEntry_t *pEntry = OtaServer_BlockCacheFind(mOtaServerImageList[index].fileVersion,
+                                                                          imageOffset, len, TRUE);
 
             status = gOtaStatus_Success_c;
             pBlockRsp->commandId = gOtaCmd_BlockRsp_c;
@@ -1578,12 +2119,22 @@ static otaStatus_t OtaServerStandalone_BlockReqHandler
                 OTA_ClientInfoCnf((uint8_t *)&pOtaClientInfo->remoteAddr, imageOffset, clientId);
             }
 
-            if (OTA_ReadExternalMemory(&pBlockRsp->data.success.pData[0], len, addr) != gOtaSucess_c)
+            OtaServer_SessionSetNextBlock(pOtaClientInfo, mOtaServerImageList[index].fileVersion, imageOffset, len);
+
+            if (pEntry)
+            {
+                /* Served from RAM, no external memory access */
+                FLib_MemCpy(&pBlockRsp->data.success.pData[0], pEntry->pData, len);
+                OtaServer_SocketSendRsp(pOtaClientInfo, (uint8_t *)pBlockRsp, respLength);
+            }
+            else if (OTA_ReadExternalMemory(&pBlockRsp->data.success.pData[0], len, addr) != gOtaSucess_c)
             {
                 (void)OtaServer_CoapSendRspWaitAbortData(pOtaClientInfo, gOtaFileStatus_Abort_c, 0);
             }
             else
             {
+                OtaServer_BlockCacheStore(mOtaServerImageList[index].fileVersion, imageOffset, len,
+                                          &pBlockRsp->data.success.pData[0], len);
                 OtaServer_SocketSendRsp(pOtaClientInfo, (uint8_t *)pBlockRsp, respLength);
             }
 
@@ -1719,6 +2270,7 @@ static uint8_t OtaServerStandalone_KeepImageInfo
             mOtaServerImageList[i].fileSize = fileSize;
             mOtaServerImageList[i].isValidEntry = FALSE; /* True when the download is completed */
             mOtaServerTempImageOffset = 0;
+            OtaServer_BlockCacheFlush();
             result = i;
             break;
         }
@@ -1789,6 +2341,7 @@ static otaResult_t ThciOtaServer_ImageNotifyCnf
     otaResult_t result = gOtaError_c;
     thciOtaServer_ImageNotify_t imageNotify;
 
+    (void)len;
     FLib_MemCpy((void *)&imageNotify, pBuffer, sizeof(imageNotify));
 
     if (mOtaServerSetup.opMode == gOtaServerOpMode_Dongle_c)
@@ -1860,6 +2413,8 @@ static otaResult_t ThciOtaServer_SetOperationMode
                 mOtaServerImageList[i].isValidEntry = FALSE;
             }
 
+            OtaServer_BlockCacheFlush();
+
             /* start downloading the image */
             (void)NWKU_SendMsg(OtaServerStandalone_ThciQueryImageReq, NULL, mpOtaServerMsgQueue);
         }
@@ -1913,6 +2468,15 @@ static otaResult_t ThciOtaServer_QueryImageRspCnf
         otaCmd_QueryImageRsp_t *pQueryImgRsp;
 
         FLib_MemCpy(&queryImgDeviceId, pThciQueryImg->deviceId, sizeof(queryImgDeviceId));
+
+        /* Bounds the read-ahead */
+        if (pThciQueryImg->imageStatus == gOtaSucess_c)
+        {
+            FLib_MemCpy(&mOtaServerDongleImage.fileVersion, pThciQueryImg->fileVersion, sizeof(uint32_t));
+            FLib_MemCpy(&mOtaServerDongleImage.fileSize, pThciQueryImg->totalImgSize, sizeof(uint32_t));
+            mOtaServerDongleImage.isValid = TRUE;
+        }
+
         pQueryImgRsp = MEM_BufferAlloc(sizeof(otaCmd_QueryImageRsp_t));
 
         if (pQueryImgRsp)
@@ -2006,7 +2570,7 @@ static otaResult_t ThciOtaServer_BlockReceivedCnf
     {
         otaCmd_BlockRsp_t *pBlockRsp = NULL;
 
-        if (NULL !=  mpOtaServerTempClientInfo)
+        if ((NULL !=  mpOtaServerTempClientInfo) || (TRUE == mOtaServerBlockFetch.isActive))
         {
             pBlockRsp = MEM_BufferAlloc(2 + sizeof(otaCmd_BlockRspSuccess_t) - 1 + len);
 
@@ -2014,10 +2578,21 @@ static otaResult_t ThciOtaServer_BlockReceivedCnf
             {
                 pBlockRsp->commandId = gOtaCmd_BlockRsp_c;
                 pBlockRsp->status = gOtaFileStatus_Success_c;
-                otaCmd_BlockReq_t *pOtaCmd_BlockReq = (otaCmd_BlockReq_t *)mpOtaServerTempClientInfo->pData;
 
-                FLib_MemCpy(pBlockRsp->data.success.fileVersion, pOtaCmd_BlockReq->fileVersion, sizeof(uint32_t));
-                FLib_MemCpy(pBlockRsp->data.success.fileOffset, pOtaCmd_BlockReq->fileOffset, sizeof(uint32_t));
+                if (NULL != mpOtaServerTempClientInfo)
+                {
+                    otaCmd_BlockReq_t *pOtaCmd_BlockReq = (otaCmd_BlockReq_t *)mpOtaServerTempClientInfo->pData;
+
+                    FLib_MemCpy(pBlockRsp->data.success.fileVersion, pOtaCmd_BlockReq->fileVersion, sizeof(uint32_t));
+                    FLib_MemCpy(pBlockRsp->data.success.fileOffset, pOtaCmd_BlockReq->fileOffset, sizeof(uint32_t));
+                }
+                else
+                {
+                    /* Read-ahead block, only cached */
+                    FLib_MemCpy(pBlockRsp->data.success.fileVersion, &mOtaServerBlockFetch.fileVersion, sizeof(uint32_t));
+                    FLib_MemCpy(pBlockRsp->data.success.fileOffset, &mOtaServerBlockFetch.offset, sizeof(uint32_t));
+                }
+
                 pBlockRsp->data.success.dataSize = len;
                 FLib_MemCpy(pBlockRsp->data.success.pData, pBuffer, len);
 
@@ -2106,6 +2681,7 @@ static otaResult_t ThciOtaServer_CancelImgCnf
     (void)pBuffer;
 
     mOtaServerSetup.isActive = FALSE;
+    OtaServer_BlockCacheFlush();
 
     if (mOtaServerSetup.opMode == gOtaServerOpMode_Dongle_c)
     {
@@ -2115,6 +2691,9 @@ static otaResult_t ThciOtaServer_CancelImgCnf
             mpOtaServerTempClientInfo = NULL;
         }
 
+        mOtaServerBlockFetch.isActive = FALSE;
+        mOtaServerDongleImage.isValid = FALSE;
+
         while (MSG_Pending(&mOtaServerThciClientInfoQueue))
         {
             void *pOtaClientInfo = MSG_DeQueue(&mOtaServerThciClientInfoQueue);
@@ -2272,12 +2851,17 @@ static otaStatus_t OtaServer_ProcessNextClient
     otaClientInfo_t *pOtaClientInfo = NULL;
 
     if ((mOtaServerSetup.opMode == gOtaServerOpMode_Dongle_c) &&
-            (NULL == mpOtaServerTempClientInfo))
+            (NULL == mpOtaServerTempClientInfo) && (FALSE == mOtaServerBlockFetch.isActive))
     {
         TMR_StopTimer(mOtaServerSetup.otaServerTmr);
         pOtaClientInfo = MSG_DeQueue(&mOtaServerThciClientInfoQueue);
 
-        if (pOtaClientInfo)
+        if (NULL == pOtaClientInfo)
+        {
+            /* The host link is idle */
+            OtaServerDongle_ReadAhead();
+        }
+        else
         {
             if (FALSE == NWKU_SendMsg(OtaServer_CmdProcess, pOtaClientInfo, mpOtaServerMsgQueue))
             {
@@ -2334,7 +2918,7 @@ static otaStatus_t OtaServer_HandleBlockSocket
             }
             else
             {
-                panic(0, (uint32_t)OtaServer_HandleBlockSocket, 0, 0);
+                panic(0, (uint32_t)(uintptr_t)OtaServer_HandleBlockSocket, 0, 0);
                 status = gOtaStatus_Failed_c;
             }
         }
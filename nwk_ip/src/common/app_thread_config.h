@@ -112,6 +112,11 @@ Public macros
     #define UDP_ECHO_PROTOCOL                           FALSE
 #endif
 
+/*! Enable/disable the HTTP server of the sensor snapshot */
+#ifndef APP_HTTP_SERVER
+    #define APP_HTTP_SERVER                             FALSE
+#endif
+
 /*! The device is out-of-band commissioned (the node is pre-configured). This means that the device
  * has all network parameters to directly attach to that network (e.g. master key, PSKc, mesh-local ULA,
  * extended PAN ID, Network name) */
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file ota_client_link.h
+ * State of the simulated link shared by ota_client_test.c and ota_client_stubs.c: the clock, the client
+ * timer, the message queue and the block responses in flight.
+ */
+
+#ifndef _OTA_CLIENT_LINK_H_
+#define _OTA_CLIENT_LINK_H_
+
+#include <stdint.h>
+
+#define LINK_MAX_EVENTS     (4096U)
+#define LINK_MAX_MSGS       (256U)
+#define LINK_SESSION_SIZE   (256U)
+
+typedef struct
+{
+    /* Model */
+    double loss;                /* Loss probability, each way */
+    double oneWayMs;
+    double jitterMs;            /* Added to oneWayMs, uniform */
+    double serverMs;
+
+    /* Clock and the client timer */
+    uint64_t nowUs;
+    int timerOn;
+    uint64_t timerAt;
+    void (*timerCallback)(void *);
+    void *timerParam;
+
+    /* Block responses on their way */
+    struct
+    {
+        uint64_t at;
+        uint32_t offset;
+    } events[LINK_MAX_EVENTS];
+    uint32_t eventCount;
+    uint32_t requests;
+
+    /* Messages posted to the client task */
+    struct
+    {
+        void (*handler)(void *);
+        void *param;
+    } msgs[LINK_MAX_MSGS];
+    uint32_t msgHead;
+    uint32_t msgTail;
+
+    /* Last CoAP request to the server: command and status bytes */
+    uint32_t coapRequests;
+    uint8_t coapCommand;
+    uint8_t coapStatus;
+} link_t;
+
+extern link_t gLink;
+
+double Link_Random(void);
+
+#endif
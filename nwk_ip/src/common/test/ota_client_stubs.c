@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file ota_client_stubs.c
+ * Host test stubs of the timers, messaging, memory and socket services used by the OTA client, and the
+ * lossy link that carries its block requests. Built apart from the client, without the stack headers.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ota_client_link.h"
+
+/*****************************************************************************
+ * Link
+ ****************************************************************************/
+link_t gLink;
+
+double Link_Random(void)
+{
+    return rand() / (RAND_MAX + 1.0);
+}
+
+/* One-way latency of a packet, in microseconds */
+static uint64_t Link_Delay(void)
+{
+    return (uint64_t)((gLink.oneWayMs + Link_Random() * gLink.jitterMs) * 1000.0);
+}
+
+/*****************************************************************************
+ * Timers (one timer, the client's)
+ ****************************************************************************/
+typedef uint8_t bool_t;
+
+int TMR_StartSingleShotTimer(uint8_t id, uint32_t ms, void (*callback)(void *), void *param)
+{
+    (void)id;
+    gLink.timerAt = gLink.nowUs + (uint64_t)ms * 1000U;
+    gLink.timerOn = 1;
+    gLink.timerCallback = callback;
+    gLink.timerParam = param;
+    return 0;
+}
+
+int TMR_StartTimer(uint8_t id, uint8_t type, uint32_t ms, void (*callback)(void *), void *param)
+{
+    (void)type;
+    return TMR_StartSingleShotTimer(id, ms, callback, param);
+}
+
+int TMR_StopTimer(uint8_t id)
+{
+    (void)id;
+    gLink.timerOn = 0;
+    return 0;
+}
+
+bool_t TMR_IsTimerActive(uint8_t id)
+{
+    (void)id;
+    return (bool_t)gLink.timerOn;
+}
+
+uint64_t TMR_GetTimestamp(void)
+{
+    return gLink.nowUs;
+}
+
+/*****************************************************************************
+ * Messaging, memory and helpers
+ ****************************************************************************/
+bool_t NWKU_SendMsg(void (*handler)(void *), void *param, void *queue)
+{
+    (void)queue;
+    gLink.msgs[gLink.msgTail].handler = handler;
+    gLink.msgs[gLink.msgTail].param = param;
+    gLink.msgTail = (gLink.msgTail + 1U) % LINK_MAX_MSGS;
+    return 1;
+}
+
+void *MEM_BufferAllocWithId(uint32_t size, uint8_t poolId, void *pCaller)
+{
+    (void)poolId;
+    (void)pCaller;
+    return malloc(size);
+}
+
+void *MEM_BufferAllocForever(uint32_t size, uint8_t poolId)
+{
+    (void)poolId;
+    return malloc(size);
+}
+
+int MEM_BufferFree(void *buffer)
+{
+    free(buffer);
+    return 0;
+}
+
+void FLib_MemCpy(void *pDst, const void *pSrc, uint32_t size)
+{
+    memmove(pDst, pSrc, size);
+}
+
+void FLib_MemSet(void *pData, uint8_t value, uint32_t size)
+{
+    memset(pData, value, size);
+}
+
+bool_t FLib_MemCmp(const void *pData1, const void *pData2, uint32_t size)
+{
+    return (bool_t)(memcmp(pData1, pData2, size) == 0);
+}
+
+uint32_t NWKU_GetRandomNoFromInterval(uint32_t min, uint32_t max)
+{
+    return min + (uint32_t)(Link_Random() * (max - min + 1U));
+}
+
+void NWKU_TransformUint32ToArray(uint8_t *pArray, uint32_t value)
+{
+    memcpy(pArray, &value, sizeof(value));
+}
+
+void panic(uint32_t id, uint32_t location, uint32_t extra1, uint32_t extra2)
+{
+    (void)id;
+    (void)location;
+    (void)extra1;
+    (void)extra2;
+    abort();
+}
+
+/*****************************************************************************
+ * Sockets: the block requests go through the link
+ ****************************************************************************/
+const uint8_t in6addr_any[16];
+const uint8_t in6addr_realmlocal_allthreadnodes[16];
+
+int32_t socket(int32_t domain, int32_t type, int32_t protocol)
+{
+    (void)domain;
+    (void)type;
+    (void)protocol;
+    return 3;
+}
+
+int32_t bind(int32_t sockfd, void *pAddr, uint32_t addrLen)
+{
+    (void)sockfd;
+    (void)pAddr;
+    (void)addrLen;
+    return 0;
+}
+
+int32_t shutdown(int32_t sockfd, int32_t how)
+{
+    (void)sockfd;
+    (void)how;
+    return 0;
+}
+
+int32_t sendto(int32_t sockfd, void *pBuf, uint32_t len, uint32_t flags, void *pTo, uint32_t toLen)
+{
+    uint32_t offset;
+
+    (void)sockfd;
+    (void)flags;
+    (void)pTo;
+    (void)toLen;
+
+    /* File offset of the block request, see otaCmd_BlockReq_t */
+    memcpy(&offset, (uint8_t *)pBuf + 9, sizeof(offset));
+    gLink.requests++;
+    if ((Link_Random() >= gLink.loss) && (gLink.eventCount < LINK_MAX_EVENTS))
+    {
+        gLink.events[gLink.eventCount].at = gLink.nowUs + Link_Delay() + (uint64_t)(gLink.serverMs * 1000.0);
+        gLink.events[gLink.eventCount].offset = offset;
+        gLink.eventCount++;
+    }
+    return (int32_t)len;
+}
+
+void Session_RegisterCb(int32_t sockfd, void (*callback)(void *), void *queue)
+{
+    (void)sockfd;
+    (void)callback;
+    (void)queue;
+}
+
+void Session_UnRegisterCb(int32_t sockfd)
+{
+    (void)sockfd;
+}
+
+/*****************************************************************************
+ * CoAP: the requests to the server are recorded
+ ****************************************************************************/
+void *COAP_OpenSession(uint8_t instanceId)
+{
+    static uint64_t session[LINK_SESSION_SIZE / sizeof(uint64_t)];
+
+    (void)instanceId;
+    memset(session, 0, sizeof(session));
+    return session;
+}
+
+void COAP_SetUriPath(void *pSession, void *pUriPath)
+{
+    (void)pSession;
+    (void)pUriPath;
+}
+
+int32_t COAP_SendMsg(void *pSession, uint8_t *pData, uint32_t dataLen)
+{
+    (void)pSession;
+    gLink.coapRequests++;
+    gLink.coapCommand = (dataLen > 0U) ? pData[0] : 0U;
+    gLink.coapStatus = (dataLen > 1U) ? pData[1] : 0U;
+    return 0;
+}
+
+int32_t THR_GetIP6Addr(uint32_t instanceId, uint32_t type, void *pAddr, void *pCount)
+{
+    (void)instanceId;
+    (void)type;
+    (void)pAddr;
+    (void)pCount;
+    return 0;
+}
+
+/* Not reached by the block download */
+#define UNUSED_STUB(name)   void name(void) { abort(); }
+UNUSED_STUB(COAP_CreateInstance)
+UNUSED_STUB(COAP_Send)
+UNUSED_STUB(NWKU_GetBit)
+UNUSED_STUB(THR_TimeoutResetMcu)
+UNUSED_STUB(TMR_AllocateTimer)
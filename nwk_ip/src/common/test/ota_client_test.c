@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file ota_client_test.c
+ * Host simulation of the OTA client block download. The client source is built in and fed with the
+ * responses of a server over a link with random loss and latency each way (ota_client_stubs.c). Each
+ * download is checked byte for byte, and its duration against the window of block requests. The image
+ * signature is then checked: a file with one bit flipped, or signed with another engine, is rejected.
+ *
+ * Built once per signature engine (gOtaClientSignature_c). Build and run with "make" from this directory,
+ * "./ota_client_test <image size>" for other sizes.
+ */
+
+#define AppPoolId_d     0
+#ifndef gOtaClientSignatureKey_c
+/* RFC 4493 test key */
+#define gOtaClientSignatureKey_c    {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, \
+                                     0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c}
+#endif
+#include "../app_ota_client.c"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ota_client_link.h"
+
+/*****************************************************************************
+ * Stubs
+ ****************************************************************************/
+static uint8_t *sFile;
+static uint32_t sFileLength;
+static uint8_t *sFlash;
+static uint32_t sFlashLength;
+static int sCommitted;
+
+uint16_t OTA_CrcCompute(uint8_t *pData, uint16_t length, uint16_t crcValueOld)
+{
+    while (length--)
+    {
+        crcValueOld = (uint16_t)((crcValueOld << 5) ^ (crcValueOld >> 11) ^ *pData++);
+    }
+    return crcValueOld;
+}
+
+otaResult_t OTA_StartImage(uint32_t length)
+{
+    (void)length;
+    sFlashLength = 0;
+    return gOtaSucess_c;
+}
+
+otaResult_t OTA_PushImageChunk(uint8_t *pData, uint16_t length, uint32_t *pImageLength, uint32_t *pImageOffset)
+{
+    (void)pImageLength;
+    (void)pImageOffset;
+    memcpy(sFlash + sFlashLength, pData, length);
+    sFlashLength += length;
+    return gOtaSucess_c;
+}
+
+otaResult_t OTA_CommitImage(uint8_t *pBitmap)
+{
+    (void)pBitmap;
+    sCommitted = 1;
+    return gOtaSucess_c;
+}
+
+void OTA_CancelImage(void)
+{
+}
+
+void OTA_SetNewImageFlag(void)
+{
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+#define FILE_VERSION    (0x40034006U)
+#define NO_TAMPERING    (0xFFFFFFFFU)
+
+static const char *const sEngineNames[] = {"CRC", "SHA-256", "CMAC"};
+
+/* OTA file: header, upgrade image and signature sub-elements, one bit flipped at tamperAt */
+static void BuildFile(uint32_t imageSize, uint32_t engine, uint32_t tamperAt)
+{
+    static const uint8_t key[AES_128_KEY_BYTE_LEN] = gOtaClientSignatureKey_c;
+    otaFileHeader_t header;
+    otaFileSubElement_t element;
+    uint32_t imageStart = sizeof(header) + sizeof(element);
+    uint32_t signedLength = imageStart + imageSize;
+    uint8_t signature[SHA256_HASH_SIZE];
+    sha256Context_t sha256;
+    uint32_t signatureSize;
+    uint32_t value32;
+    uint16_t value16;
+    uint16_t crc;
+    uint32_t i;
+
+    sFileLength = signedLength + sizeof(element) + sizeof(signature);
+    sFile = malloc(sFileLength);
+    sFlash = malloc(imageSize);
+    CHECK((sFile != NULL) && (sFlash != NULL));
+
+    memset(&header, 0, sizeof(header));
+    value32 = gOtaFileIdentifierNo_c;
+    memcpy(header.fileIdentifier, &value32, sizeof(value32));
+    value16 = sizeof(header);
+    memcpy(header.headerLength, &value16, sizeof(value16));
+    value16 = gOtaManufacturerCodeNo_c;
+    memcpy(header.manufacturerCode, &value16, sizeof(value16));
+    value16 = gOtaCurrentImageTypeNo_c;
+    memcpy(header.imageType, &value16, sizeof(value16));
+    value32 = FILE_VERSION;
+    memcpy(header.fileVersion, &value32, sizeof(value32));
+    memcpy(sFile, &header, sizeof(header));
+
+    value16 = gOtaFileUpgradeImageTagId_c;
+    memcpy(element.id, &value16, sizeof(value16));
+    memcpy(element.length, &imageSize, sizeof(imageSize));
+    memcpy(sFile + sizeof(header), &element, sizeof(element));
+    for (i = 0; i < imageSize; i++)
+    {
+        sFile[imageStart + i] = (uint8_t)rand();
+    }
+
+    /* Up to the signature sub-element */
+    if (engine == gOtaClientSignatureSha256_c)
+    {
+        SHA256_Hash(&sha256, sFile, signedLength);
+        memcpy(signature, sha256.hash, SHA256_HASH_SIZE);
+        signatureSize = SHA256_HASH_SIZE;
+    }
+    else if (engine == gOtaClientSignatureCmac_c)
+    {
+        AES_128_CMAC(sFile, signedLength, (uint8_t *)key, signature);
+        signatureSize = AES_128_CMAC_SIZE;
+    }
+    else
+    {
+        /* Computed in the chunks of the client */
+        crc = OTA_CrcCompute(sFile, (uint16_t)imageStart, 0);
+        for (i = 0; i < imageSize; i += 255U)
+        {
+            crc = OTA_CrcCompute(&sFile[imageStart + i], (uint16_t)(((imageSize - i) > 255U) ? 255U : (imageSize - i)), crc);
+        }
+        value32 = crc;
+        memcpy(signature, &value32, sizeof(value32));
+        signatureSize = sizeof(value32);
+    }
+    value16 = gOtaFileCrcTagId_c;
+    memcpy(element.id, &value16, sizeof(value16));
+    memcpy(element.length, &signatureSize, sizeof(signatureSize));
+    memcpy(&sFile[signedLength], &element, sizeof(element));
+    memcpy(&sFile[signedLength + sizeof(element)], signature, signatureSize);
+    sFileLength = signedLength + sizeof(element) + signatureSize;
+
+    if (tamperAt < sFileLength)
+    {
+        sFile[tamperAt] ^= 0x01U;
+    }
+}
+
+/* Block response of the server, delivered to the client socket */
+static void SendBlockRsp(uint32_t offset)
+{
+    uint32_t size = ((sFileLength - offset) > gOtaMaxBlockDataSize_c) ? gOtaMaxBlockDataSize_c : (sFileLength - offset);
+    uint32_t length = sizeof(otaCmd_BlockRsp_t) - 1U + size;
+    uint32_t version = FILE_VERSION;
+    sessionPacket_t *pPacket = calloc(1, sizeof(sessionPacket_t));
+    otaCmd_BlockRsp_t *pRsp = calloc(1, length + 8U);
+
+    CHECK((pPacket != NULL) && (pRsp != NULL));
+    pRsp->commandId = gOtaCmd_BlockRsp_c;
+    pRsp->status = gOtaFileStatus_Success_c;
+    memcpy(pRsp->data.success.fileVersion, &version, sizeof(version));
+    memcpy(pRsp->data.success.fileOffset, &offset, sizeof(offset));
+    pRsp->data.success.dataSize = (uint8_t)size;
+    memcpy(pRsp->data.success.pData, &sFile[offset], size);
+    pPacket->pData = (uint8_t *)pRsp;
+    pPacket->dataLen = length;
+    OtaClient_UdpServerService(pPacket);
+}
+
+static void RunMessages(void)
+{
+    while (gLink.msgHead != gLink.msgTail)
+    {
+        void (*handler)(void *) = gLink.msgs[gLink.msgHead].handler;
+        void *param = gLink.msgs[gLink.msgHead].param;
+
+        gLink.msgHead = (gLink.msgHead + 1U) % LINK_MAX_MSGS;
+        handler(param);
+    }
+}
+
+/* Downloads an image, returns the time taken in seconds, or a negative value if the client rejected it: it
+   then tells the server with an upgrade end request */
+static double Download(uint32_t imageSize, uint32_t engine, uint32_t tamperAt)
+{
+    otaServerInfo_t *pQuery = calloc(1, sizeof(otaServerInfo_t) + sizeof(otaCmd_QueryImageRsp_t));
+    otaCmd_QueryImageRsp_t *pRsp;
+    uint32_t version = FILE_VERSION;
+    uint16_t value16;
+
+    CHECK(pQuery != NULL);
+    CHECK(sizeof(coapSession_t) <= LINK_SESSION_SIZE);
+    gLink.nowUs = 0;
+    gLink.timerOn = 0;
+    gLink.eventCount = 0;
+    gLink.requests = 0;
+    gLink.msgHead = 0;
+    gLink.msgTail = 0;
+    gLink.coapRequests = 0;
+    sCommitted = 0;
+    BuildFile(imageSize, engine, tamperAt);
+
+    /* The server answered the image query */
+    mpOtaClientMsgQueue = (taskMsgQueue_t *)1;
+    mOtaClientSetup.otaClientTmr = 0;
+    FLib_MemSet(&mOtaClientSession, 0, sizeof(mOtaClientSession));
+    mOtaClientSession.state = gOtaClientState_QueryImage_c;
+    pRsp = (otaCmd_QueryImageRsp_t *)pQuery->pData;
+    pRsp->commandId = gOtaCmd_QueryImageRsp_c;
+    pRsp->status = gOtaFileStatus_Success_c;
+    value16 = gOtaManufacturerCodeNo_c;
+    memcpy(pRsp->data.success.manufacturerCode, &value16, sizeof(value16));
+    memcpy(pRsp->data.success.fileVersion, &version, sizeof(version));
+    memcpy(pRsp->data.success.fileSize, &sFileLength, sizeof(sFileLength));
+    pQuery->dataLen = sizeof(*pRsp);
+    OtaClient_QueryImageRspHandler(pQuery);
+    RunMessages();
+
+    /* Next response or timer expiry, until the image is committed or rejected */
+    while (!sCommitted && (0U == gLink.coapRequests))
+    {
+        uint64_t next = gLink.timerOn ? gLink.timerAt : UINT64_MAX;
+        int32_t event = -1;
+        uint32_t i;
+
+        for (i = 0; i < gLink.eventCount; i++)
+        {
+            if (gLink.events[i].at < next)
+            {
+                next = gLink.events[i].at;
+                event = (int32_t)i;
+            }
+        }
+        CHECK(next != UINT64_MAX);
+        CHECK(next < 4000ULL * 1000000ULL);
+        gLink.nowUs = next;
+
+        if (event >= 0)
+        {
+            uint32_t offset = gLink.events[event].offset;
+
+            gLink.events[event] = gLink.events[--gLink.eventCount];
+            if (Link_Random() >= gLink.loss)
+            {
+                SendBlockRsp(offset);
+            }
+        }
+        else
+        {
+            gLink.timerOn = 0;
+            gLink.timerCallback(gLink.timerParam);
+        }
+        RunMessages();
+    }
+
+    if (sCommitted)
+    {
+        CHECK(sFlashLength == imageSize);
+        CHECK(0 == memcmp(sFlash, &sFile[sizeof(otaFileHeader_t) + sizeof(otaFileSubElement_t)], imageSize));
+    }
+    else
+    {
+        CHECK(gOtaCmd_UpgradeEndReq_c == gLink.coapCommand);
+        CHECK(gOtaFileStatus_InvalidImage_c == gLink.coapStatus);
+    }
+    free(sFile);
+    free(sFlash);
+    return sCommitted ? (gLink.nowUs / 1e6) : -1.0;
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* The window of block requests on lossy links of increasing latency */
+static void TestWindow(uint32_t imageSize)
+{
+    static const double losses[] = {0.0, 0.02, 0.05, 0.1, 0.2};
+    static const double latencies[] = {15.0, 60.0, 150.0};
+    double seconds;
+    uint32_t i;
+    uint32_t j;
+
+    printf("%u byte image, %u byte blocks, %s signature\n", imageSize, gOtaMaxBlockDataSize_c,
+           sEngineNames[gOtaClientSignature_c]);
+    for (j = 0; j < sizeof(latencies) / sizeof(latencies[0]); j++)
+    {
+        for (i = 0; i < sizeof(losses) / sizeof(losses[0]); i++)
+        {
+            gLink.loss = losses[i];
+            gLink.oneWayMs = latencies[j];
+            gLink.jitterMs = latencies[j] / 3.0;
+            gLink.serverMs = 5.0;
+            seconds = Download(imageSize, gOtaClientSignature_c, NO_TAMPERING);
+            CHECK(seconds >= 0.0);
+            printf("  one-way %3.0f ms, loss %3.0f%% each way: %6.1f s, %5u requests\n",
+                   latencies[j], losses[i] * 100.0, seconds, gLink.requests);
+
+            /* Without loss, each block is asked once, and the window takes a fraction of the round trip
+               per block that a request at a time would */
+            if (losses[i] == 0.0)
+            {
+                uint32_t blocks = (sFileLength + gOtaMaxBlockDataSize_c - 1U) / gOtaMaxBlockDataSize_c;
+
+                CHECK(gLink.requests == blocks);
+                CHECK(4.0 * seconds < blocks * 2.0 * latencies[j] / 1000.0);
+            }
+        }
+    }
+}
+
+/* Only an intact file, signed with the configured engine, is committed */
+static void TestSignature(uint32_t imageSize)
+{
+    uint32_t headerAndImage = sizeof(otaFileHeader_t) + sizeof(otaFileSubElement_t) + imageSize;
+    /* Header string, image and signature bytes: only the signature tells */
+    uint32_t tamperAt[] = {offsetof(otaFileHeader_t, headerString), headerAndImage / 2U, headerAndImage - 1U,
+                           headerAndImage + sizeof(otaFileSubElement_t)};
+    uint32_t engine;
+    uint32_t i;
+
+    gLink.loss = 0.05;
+    gLink.oneWayMs = 60.0;
+    gLink.jitterMs = 20.0;
+
+    for (i = 0; i < sizeof(tamperAt) / sizeof(tamperAt[0]); i++)
+    {
+        CHECK(Download(imageSize, gOtaClientSignature_c, tamperAt[i]) < 0.0);
+    }
+
+    for (engine = gOtaClientSignatureCrc_c; engine <= gOtaClientSignatureCmac_c; engine++)
+    {
+        double seconds = Download(imageSize, engine, NO_TAMPERING);
+
+        printf("  file signed with %-7s: %s\n", sEngineNames[engine], (seconds < 0.0) ? "rejected" : "committed");
+        CHECK((seconds >= 0.0) == (engine == gOtaClientSignature_c));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t imageSize = (argc > 1) ? (uint32_t)atoi(argv[1]) : 8192U;
+
+    srand(1);
+    TestWindow(imageSize);
+    TestSignature(imageSize);
+
+    printf("ota_client (%s): all tests passed\n", sEngineNames[gOtaClientSignature_c]);
+    return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file ota_server_link.h
+ * State of the simulation shared by ota_server_test.c and ota_server_stubs.c: the clock, the server timer,
+ * the message queue of the server task and the memory manager accounting.
+ */
+
+#ifndef _OTA_SERVER_LINK_H_
+#define _OTA_SERVER_LINK_H_
+
+#include <stdint.h>
+
+#define LINK_MAX_MSGS       (256U)
+#define LINK_SESSION_SIZE   (256U)
+
+typedef struct
+{
+    /* Clock and the server timer */
+    uint64_t nowUs;
+    int timerOn;
+    uint64_t timerAt;
+    void (*timerCallback)(void *);
+    void *timerParam;
+
+    /* Messages posted to the server task */
+    struct
+    {
+        void (*handler)(void *);
+        void *param;
+    } msgs[LINK_MAX_MSGS];
+    uint32_t msgHead;
+    uint32_t msgTail;
+
+    /* Memory manager: buffers in use, and the free blocks it reports */
+    uint32_t buffersInUse;
+    uint32_t availableBlocks;
+} link_t;
+
+extern link_t gLink;
+
+#endif
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file ota_server_stubs.c
+ * Host test stubs of the timers, messaging, memory, list and socket services used by the OTA server. Built
+ * apart from the server, without the stack headers. The real generic list is linked in, the message queue
+ * of the client requests relies on it.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GenericList.h"
+#include "ota_server_link.h"
+
+/*****************************************************************************
+ * Clock and timers (one timer, the server's)
+ ****************************************************************************/
+link_t gLink;
+
+typedef uint8_t bool_t;
+
+uint8_t TMR_AllocateTimer(void)
+{
+    return 0;
+}
+
+int TMR_StartSingleShotTimer(uint8_t id, uint32_t ms, void (*callback)(void *), void *param)
+{
+    (void)id;
+    gLink.timerAt = gLink.nowUs + (uint64_t)ms * 1000U;
+    gLink.timerOn = 1;
+    gLink.timerCallback = callback;
+    gLink.timerParam = param;
+    return 0;
+}
+
+int TMR_StopTimer(uint8_t id)
+{
+    (void)id;
+    gLink.timerOn = 0;
+    return 0;
+}
+
+uint64_t TMR_GetTimestamp(void)
+{
+    return gLink.nowUs;
+}
+
+uint32_t NWKU_GetTimestampMs(void)
+{
+    return (uint32_t)(gLink.nowUs / 1000U);
+}
+
+uint32_t NWKU_GetRandomNoFromInterval(uint32_t min, uint32_t max)
+{
+    return min + (uint32_t)((rand() / (RAND_MAX + 1.0)) * (max - min + 1U));
+}
+
+/*****************************************************************************
+ * Messaging and memory: the buffers carry a list header, as MemManager blocks
+ ****************************************************************************/
+typedef struct
+{
+    listElement_t link;
+    uint32_t size;
+} memHeader_t;
+
+bool_t NWKU_SendMsg(void (*handler)(void *), void *param, void *queue)
+{
+    (void)queue;
+    gLink.msgs[gLink.msgTail].handler = handler;
+    gLink.msgs[gLink.msgTail].param = param;
+    gLink.msgTail = (gLink.msgTail + 1U) % LINK_MAX_MSGS;
+    return 1;
+}
+
+void *MEM_BufferAllocWithId(uint32_t size, uint8_t poolId, void *pCaller)
+{
+    memHeader_t *pHeader = calloc(1, sizeof(memHeader_t) + size);
+
+    (void)poolId;
+    (void)pCaller;
+    if (NULL == pHeader)
+    {
+        return NULL;
+    }
+    pHeader->size = size;
+    gLink.buffersInUse++;
+    return pHeader + 1;
+}
+
+int MEM_BufferFree(void *buffer)
+{
+    if (NULL != buffer)
+    {
+        gLink.buffersInUse--;
+        free((memHeader_t *)buffer - 1);
+    }
+    return 0;
+}
+
+uint16_t MEM_BufferGetSize(void *buffer)
+{
+    return (uint16_t)((memHeader_t *)buffer - 1)->size;
+}
+
+uint32_t MEM_GetAvailableBlocks(uint32_t size)
+{
+    (void)size;
+    return gLink.availableBlocks;
+}
+
+listStatus_t ListAddTailMsg(listHandle_t list, void *pMsg)
+{
+    return ListAddTail(list, &((memHeader_t *)pMsg - 1)->link);
+}
+
+void *ListRemoveHeadMsg(listHandle_t list)
+{
+    memHeader_t *pHeader = (memHeader_t *)ListRemoveHead(list);
+
+    return (NULL != pHeader) ? (pHeader + 1) : NULL;
+}
+
+void *ListGetHeadMsg(listHandle_t list)
+{
+    memHeader_t *pHeader = (memHeader_t *)ListGetHead(list);
+
+    return (NULL != pHeader) ? (pHeader + 1) : NULL;
+}
+
+void *ListGetNextMsg(void *pMsg)
+{
+    memHeader_t *pHeader = (memHeader_t *)ListGetNext(&((memHeader_t *)pMsg - 1)->link);
+
+    return (NULL != pHeader) ? (pHeader + 1) : NULL;
+}
+
+listStatus_t ListRemoveMsg(void *pMsg)
+{
+    return ListRemoveElement(&((memHeader_t *)pMsg - 1)->link);
+}
+
+void OSA_InterruptDisable(void)
+{
+}
+
+void OSA_InterruptEnable(void)
+{
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+void FLib_MemCpy(void *pDst, const void *pSrc, uint32_t size)
+{
+    memmove(pDst, pSrc, size);
+}
+
+void FLib_MemCpyReverseOrder(void *pDst, const void *pSrc, uint32_t size)
+{
+    uint8_t *pD = pDst;
+    const uint8_t *pS = (const uint8_t *)pSrc + size;
+
+    while (size--)
+    {
+        *pD++ = *--pS;
+    }
+}
+
+void FLib_MemSet(void *pData, uint8_t value, uint32_t size)
+{
+    memset(pData, value, size);
+}
+
+bool_t FLib_MemCmp(const void *pData1, const void *pData2, uint32_t size)
+{
+    return (bool_t)(memcmp(pData1, pData2, size) == 0);
+}
+
+void panic(uint32_t id, uint32_t location, uint32_t extra1, uint32_t extra2)
+{
+    (void)id;
+    (void)location;
+    (void)extra1;
+    (void)extra2;
+    abort();
+}
+
+/*****************************************************************************
+ * Stack services: the block socket opens, the block responses are sent by the test
+ ****************************************************************************/
+const uint8_t in6addr_any[16];
+const uint8_t in6addr_realmlocal_allthreadnodes[16] = {0xFF, 0x03, [15] = 0x01};
+const uint64_t gOTA_CLIENT_URI_PATH[2];
+
+int32_t socket(int32_t domain, int32_t type, int32_t protocol)
+{
+    (void)domain;
+    (void)type;
+    (void)protocol;
+    return 3;
+}
+
+int32_t bind(int32_t sockfd, void *pAddr, uint32_t addrLen)
+{
+    (void)sockfd;
+    (void)pAddr;
+    (void)addrLen;
+    return 0;
+}
+
+int32_t shutdown(int32_t sockfd, int32_t how)
+{
+    (void)sockfd;
+    (void)how;
+    return 0;
+}
+
+void Session_RegisterCb(int32_t sockfd, void (*callback)(void *), void *queue)
+{
+    (void)sockfd;
+    (void)callback;
+    (void)queue;
+}
+
+void Session_UnRegisterCb(int32_t sockfd)
+{
+    (void)sockfd;
+}
+
+uint8_t COAP_CreateInstance(void *pCallback, void *pParams, uint32_t ipIfId, void *pCbParams, uint32_t nbOfCb)
+{
+    (void)pCallback;
+    (void)pParams;
+    (void)ipIfId;
+    (void)pCbParams;
+    (void)nbOfCb;
+    return 0;
+}
+
+void COAP_AddOptionToList(void *pSession, uint32_t optionNumber, uint8_t *pOptionValue, uint32_t optionLength)
+{
+    (void)pSession;
+    (void)optionNumber;
+    (void)pOptionValue;
+    (void)optionLength;
+}
+
+int32_t THR_GetIP6Addr(uint32_t instanceId, uint32_t type, void *pAddr, void *pCount)
+{
+    (void)instanceId;
+    (void)type;
+    (void)pAddr;
+    (void)pCount;
+    return 0;
+}
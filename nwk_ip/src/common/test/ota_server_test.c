@@ -0,0 +1,528 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file ota_server_test.c
+ * Host simulation of the OTA server block cache in dongle mode. The server source is built in and serves
+ * one image to N clients downloading it block by block. The blocks are read from the host over a THCI link
+ * that carries one request at a time, each taking a fixed round trip. Every block received is checked
+ * byte for byte, and the number of host reads against the image size: one read per block and client
+ * without the cache, close to one per block with it.
+ *
+ * The server memory is then run short: the cache must recycle its buffers instead of taking new ones.
+ * Last, the host replaces the image with one of the same file version: no stale block may be served.
+ *
+ * Built once per cache configuration (gOtaServer_BlockCacheEntries_c, gOtaServer_BlockReadAheadDepth_c).
+ * Build and run with "make" from this directory.
+ */
+
+#define AppPoolId_d     0
+#include "../app_ota_server.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ota_server_link.h"
+
+#define CHECK(c) do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+#define IMAGE_SIZE          (102400U)
+#define BLOCK_SIZE          (gOtaMaxBlockDataSize_c)
+#define BLOCKS              (IMAGE_SIZE / BLOCK_SIZE)
+#define FILE_VERSION        (0x40034006U)
+#define MAX_CLIENTS         (8U)
+#define MAX_EVENTS          (4U * MAX_CLIENTS)
+#define NEVER               (UINT64_MAX)
+
+/* Timing, microseconds */
+#define HOST_FETCH_US       (12000U)    /* round trip of a block read over THCI */
+#define LINK_US             (150U)      /* one way, server to client */
+#define CLIENT_TURN_US      (5000U)     /* client turnaround to the next request */
+#define CLIENT_RETRY_US     (1000000U)  /* client timeout on a block request */
+#define CLIENT_START_US     (20000U)    /* clients start within this window */
+
+/*****************************************************************************
+ * Host: the image and the THCI link, one block read at a time
+ ****************************************************************************/
+static uint8_t sImage[IMAGE_SIZE];
+static otaServer_AppCB_t *sHostCb;
+
+static struct
+{
+    int isActive;
+    uint64_t at;
+    uint32_t offset;
+    uint16_t len;
+} sFetch;
+
+static uint32_t sFetches;
+
+otaResult_t OTA_RegisterToFsci(uint32_t thciInterface, otaServer_AppCB_t *pCb)
+{
+    (void)thciInterface;
+    sHostCb = pCb;
+    return gOtaSucess_c;
+}
+
+otaResult_t OTA_QueryImageReq(uint16_t devId, uint16_t manufacturer, uint16_t imgType, uint32_t fileVersion)
+{
+    (void)devId;
+    (void)manufacturer;
+    (void)imgType;
+    (void)fileVersion;
+    return gOtaSucess_c;
+}
+
+otaResult_t OTA_ImageChunkReq(uint32_t offset, uint16_t len, uint16_t devId)
+{
+    (void)devId;
+    /* The host link carries one request at a time */
+    CHECK(!sFetch.isActive);
+    CHECK(offset < IMAGE_SIZE);
+    sFetch.isActive = 1;
+    sFetch.at = gLink.nowUs + HOST_FETCH_US;
+    sFetch.offset = offset;
+    sFetch.len = (uint16_t)((offset + len > IMAGE_SIZE) ? (IMAGE_SIZE - offset) : len);
+    sFetches++;
+    return gOtaSucess_c;
+}
+
+void OTA_ClientInfoCnf(uint8_t *pData, uint32_t offset, uint16_t devId)
+{
+    (void)pData;
+    (void)offset;
+    (void)devId;
+}
+
+/*****************************************************************************
+ * Clients, and the block responses on their way to them
+ ****************************************************************************/
+typedef struct
+{
+    ipAddr_t addr;
+    uint32_t offset;        /* block wanted */
+    uint64_t sendAt;        /* next request, NEVER while one is pending */
+    uint64_t retryAt;
+    uint64_t doneAt;
+} client_t;
+
+typedef struct
+{
+    uint64_t at;            /* NEVER when the slot is free */
+    uint8_t client;
+    uint8_t size;
+    uint32_t offset;
+    uint8_t data[BLOCK_SIZE];
+} event_t;
+
+static client_t sClients[MAX_CLIENTS];
+static uint32_t sNumClients;
+static event_t sEvents[MAX_EVENTS];
+static uint32_t sStatusRsps;
+static coapSession_t sCoapSession;
+
+static event_t *EventAlloc(uint8_t client)
+{
+    uint32_t i;
+
+    for (i = 0; i < MAX_EVENTS; i++)
+    {
+        if (NEVER == sEvents[i].at)
+        {
+            memset(&sEvents[i], 0, sizeof(sEvents[i]));
+            sEvents[i].at = gLink.nowUs + LINK_US;
+            sEvents[i].client = client;
+            return &sEvents[i];
+        }
+    }
+
+    CHECK(0);
+    return NULL;
+}
+
+static int ClientFind(const ipAddr_t *pAddr)
+{
+    uint32_t i;
+
+    for (i = 0; i < sNumClients; i++)
+    {
+        if (0 == memcmp(pAddr, &sClients[i].addr, sizeof(ipAddr_t)))
+        {
+            return (int)i;
+        }
+    }
+
+    CHECK(0);
+    return -1;
+}
+
+int32_t sendmsg(int32_t sockfd, ipAddr_t *pSrc, void *msg, uint32_t msgLen, uint32_t flags,
+                sockaddrStorage_t *pTo, socklen_t toLen)
+{
+    otaCmd_BlockRsp_t *pRsp = msg;
+    event_t *pEvent = EventAlloc((uint8_t)ClientFind(&((sockaddrIn6_t *)pTo)->sin6_addr));
+
+    (void)sockfd;
+    (void)pSrc;
+    (void)flags;
+    (void)toLen;
+    CHECK(gOtaCmd_BlockRsp_c == pRsp->commandId);
+    CHECK(gOtaFileStatus_Success_c == pRsp->status);
+    CHECK(msgLen == 2 + sizeof(otaCmd_BlockRspSuccess_t) - 1 + pRsp->data.success.dataSize);
+    CHECK(pRsp->data.success.dataSize <= BLOCK_SIZE);
+    pEvent->size = pRsp->data.success.dataSize;
+    memcpy(&pEvent->offset, pRsp->data.success.fileOffset, sizeof(uint32_t));
+    memcpy(pEvent->data, pRsp->data.success.pData, pEvent->size);
+    /* The buffer stays with the caller */
+    return (int32_t)msgLen;
+}
+
+coapSession_t *COAP_OpenSession(uint8_t coapInstanceId)
+{
+    (void)coapInstanceId;
+    memset(&sCoapSession, 0, sizeof(sCoapSession));
+    return &sCoapSession;
+}
+
+nwkStatus_t COAP_Send(coapSession_t *pSession, coapMsgTypesAndCodes_t coapMsgType, void *pData, uint32_t payloadLen)
+{
+    (void)coapMsgType;
+    (void)payloadLen;
+
+    if ((0xFF != pSession->remoteAddr.addr8[0]) && (gOtaCmd_BlockRsp_c == *(uint8_t *)pData))
+    {
+        /* Busy or abort on a block request: the client times out and retries */
+        sStatusRsps++;
+    }
+
+    return gNwkStatusSuccess_c;
+}
+
+static void ClientSend(uint8_t client)
+{
+    client_t *pClient = &sClients[client];
+    sessionPacket_t *pPacket = MEM_BufferAlloc(sizeof(sessionPacket_t));
+    otaCmd_BlockReq_t *pReq = MEM_BufferAlloc(sizeof(otaCmd_BlockReq_t));
+    uint32_t fileVersion = FILE_VERSION;
+
+    CHECK((NULL != pPacket) && (NULL != pReq));
+    pReq->commandId = gOtaCmd_BlockReq_c;
+    memcpy(pReq->fileVersion, &fileVersion, sizeof(uint32_t));
+    memcpy(pReq->fileOffset, &pClient->offset, sizeof(uint32_t));
+    pReq->maxDataSize = BLOCK_SIZE;
+
+    pPacket->sockFd = 3;
+    memcpy(&((sockaddrIn6_t *)&pPacket->remAddr)->sin6_addr, &pClient->addr, sizeof(ipAddr_t));
+    ((sockaddrIn6_t *)&pPacket->remAddr)->sin6_port = 61630 + client;
+    pPacket->dataLen = sizeof(otaCmd_BlockReq_t);
+    pPacket->pData = (uint8_t *)pReq;
+
+    /* Posted to the server task by the socket layer */
+    CHECK(NWKU_SendMsg(OtaClient_UdpServerService, pPacket, NULL));
+    pClient->sendAt = NEVER;
+    pClient->retryAt = gLink.nowUs + CLIENT_RETRY_US;
+}
+
+static void ClientReceive(const event_t *pEvent)
+{
+    client_t *pClient = &sClients[pEvent->client];
+
+    if ((NEVER != pClient->doneAt) || (pEvent->offset != pClient->offset))
+    {
+        /* Answer to a request retried meanwhile */
+        return;
+    }
+
+    CHECK(BLOCK_SIZE == pEvent->size);
+    CHECK(0 == memcmp(pEvent->data, &sImage[pEvent->offset], pEvent->size));
+    pClient->offset += pEvent->size;
+    pClient->retryAt = NEVER;
+
+    if (pClient->offset >= IMAGE_SIZE)
+    {
+        pClient->doneAt = gLink.nowUs;
+    }
+    else
+    {
+        pClient->sendAt = gLink.nowUs + CLIENT_TURN_US;
+    }
+}
+
+/*****************************************************************************
+ * Simulation
+ ****************************************************************************/
+static void RunMessages(void)
+{
+    while (gLink.msgHead != gLink.msgTail)
+    {
+        void (*handler)(void *) = gLink.msgs[gLink.msgHead].handler;
+        void *param = gLink.msgs[gLink.msgHead].param;
+
+        gLink.msgHead = (gLink.msgHead + 1U) % LINK_MAX_MSGS;
+        handler(param);
+    }
+}
+
+static uint32_t CacheBuffers(void)
+{
+    uint32_t count = 0;
+#if gOtaServer_BlockCacheEntries_c
+    uint32_t i;
+
+    for (i = 0; i < gOtaServer_BlockCacheEntries_c; i++)
+    {
+        count += (NULL != mOtaServerBlockCache[i].pData) ? 1U : 0U;
+    }
+#endif
+    return count;
+}
+
+/* The host announces the image, then answers the query of a client */
+static void HostStartImage(unsigned seed)
+{
+    thciOtaServer_ImageNotify_t notify;
+    /* The server copies the query up to the download port of its response, two bytes past the THCI
+       command: they are in the FSCI packet on the target */
+    struct
+    {
+        thciOtaServer_QueryImage_t query;
+        uint8_t downloadPort[2];
+    } packet;
+    uint32_t fileVersion = FILE_VERSION;
+    uint32_t size = IMAGE_SIZE;
+    uint32_t i;
+
+    srand(seed);
+
+    for (i = 0; i < IMAGE_SIZE; i++)
+    {
+        sImage[i] = (uint8_t)rand();
+    }
+
+    memset(&notify, 0, sizeof(notify));
+    memcpy(notify.fileVersion, &fileVersion, sizeof(uint32_t));
+    memcpy(notify.fileSize, &size, sizeof(uint32_t));
+    CHECK(gOtaSucess_c == sHostCb->otaServerImgNotifyCnf((uint8_t *)&notify, sizeof(notify)));
+
+    memset(&packet, 0, sizeof(packet));
+    packet.query.imageStatus = gOtaSucess_c;
+    memcpy(packet.query.fileVersion, &fileVersion, sizeof(uint32_t));
+    memcpy(packet.query.totalImgSize, &size, sizeof(uint32_t));
+    CHECK(gOtaSucess_c == sHostCb->otaServerQueryImageCnf((uint8_t *)&packet.query, sizeof(packet.query)));
+    RunMessages();
+}
+
+/* The host cancels the image: nothing but the cache may stay allocated */
+static void HostCancelImage(void)
+{
+    uint32_t i;
+
+    CHECK(gOtaSucess_c == sHostCb->otaServerCancelImgCnf(NULL, 0));
+    RunMessages();
+    CHECK(gLink.buffersInUse == CacheBuffers());
+
+    for (i = 0; i < MAX_EVENTS; i++)
+    {
+        sEvents[i].at = NEVER;
+    }
+
+    memset(&sFetch, 0, sizeof(sFetch));
+    gLink.timerOn = 0;
+    /* The client sessions expire before the next run */
+    gLink.nowUs += (gOtaServer_ClientSessionExpirationMs_c + 1000U) * 1000ULL;
+}
+
+/* Runs N clients from the given offset to completion, returns the time taken by the last one, in microseconds */
+static uint64_t RunDownload(uint32_t numClients, uint32_t offset)
+{
+    uint64_t start = gLink.nowUs;
+    uint64_t end = 0;
+    uint32_t i;
+
+    sNumClients = numClients;
+    sFetches = 0;
+    sStatusRsps = 0;
+
+    for (i = 0; i < MAX_EVENTS; i++)
+    {
+        sEvents[i].at = NEVER;
+    }
+
+    for (i = 0; i < numClients; i++)
+    {
+        memset(&sClients[i], 0, sizeof(sClients[i]));
+        sClients[i].addr.addr8[0] = 0xFD;
+        sClients[i].addr.addr8[14] = 0x10;
+        sClients[i].addr.addr8[15] = (uint8_t)(i + 1U);
+        sClients[i].offset = offset;
+        sClients[i].sendAt = start + NWKU_GetRandomNoFromInterval(0, CLIENT_START_US);
+        sClients[i].retryAt = NEVER;
+        sClients[i].doneAt = NEVER;
+    }
+
+    for (;;)
+    {
+        uint64_t next = NEVER;
+        int done = 1;
+
+        RunMessages();
+
+        /* Earliest of the client, link, host and timer events */
+        for (i = 0; i < numClients; i++)
+        {
+            done = done && (NEVER != sClients[i].doneAt);
+            next = (sClients[i].sendAt < next) ? sClients[i].sendAt : next;
+            next = (sClients[i].retryAt < next) ? sClients[i].retryAt : next;
+        }
+
+        if (done)
+        {
+            break;
+        }
+
+        for (i = 0; i < MAX_EVENTS; i++)
+        {
+            next = (sEvents[i].at < next) ? sEvents[i].at : next;
+        }
+
+        next = (sFetch.isActive && (sFetch.at < next)) ? sFetch.at : next;
+        next = (gLink.timerOn && (gLink.timerAt < next)) ? gLink.timerAt : next;
+        CHECK(NEVER != next);
+        CHECK(next - start < 3600ULL * 1000000ULL);
+        gLink.nowUs = next;
+
+        if (sFetch.isActive && (sFetch.at == next))
+        {
+            sFetch.isActive = 0;
+            (void)sHostCb->otaServerBlockReceived(&sImage[sFetch.offset], sFetch.len);
+            continue;
+        }
+
+        if (gLink.timerOn && (gLink.timerAt == next))
+        {
+            gLink.timerOn = 0;
+            gLink.timerCallback(gLink.timerParam);
+            continue;
+        }
+
+        for (i = 0; i < MAX_EVENTS; i++)
+        {
+            if (sEvents[i].at == next)
+            {
+                sEvents[i].at = NEVER;
+                ClientReceive(&sEvents[i]);
+                break;
+            }
+        }
+
+        if (i < MAX_EVENTS)
+        {
+            continue;
+        }
+
+        for (i = 0; i < numClients; i++)
+        {
+            if ((sClients[i].sendAt == next) || (sClients[i].retryAt == next))
+            {
+                ClientSend((uint8_t)i);
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < numClients; i++)
+    {
+        end = (sClients[i].doneAt > end) ? sClients[i].doneAt : end;
+    }
+
+    return end - start;
+}
+
+int main(void)
+{
+    static const uint32_t clients[] = {1, 4, MAX_CLIENTS};
+    uint64_t single = 0;
+    uint32_t buffers;
+    uint32_t i;
+
+    gLink.availableBlocks = 100;
+    CHECK(gOtaStatus_Success_c == OtaServerInit(NULL));
+    CHECK(NULL != sHostCb);
+
+    printf("cache %u entries, read-ahead depth %u, %u blocks\n", (unsigned)gOtaServer_BlockCacheEntries_c,
+           (unsigned)gOtaServer_BlockReadAheadDepth_c, (unsigned)BLOCKS);
+    printf("clients      time  host reads\n");
+
+    for (i = 0; i < sizeof(clients) / sizeof(clients[0]); i++)
+    {
+        uint64_t duration;
+
+        HostStartImage(i + 1U);
+        duration = RunDownload(clients[i], 0);
+        printf("%7u  %6.1f s  %10u\n", (unsigned)clients[i], duration / 1e6, (unsigned)sFetches);
+        CHECK(0 == sStatusRsps);
+
+        if (0 == gOtaServer_BlockCacheEntries_c)
+        {
+            CHECK(sFetches == clients[i] * BLOCKS);
+        }
+        else if (1 == clients[i])
+        {
+            CHECK(sFetches == BLOCKS);
+        }
+        else
+        {
+            /* Almost every block read once for all the clients */
+            CHECK(sFetches < BLOCKS + BLOCKS / 4U);
+        }
+
+        if (1 == clients[i])
+        {
+            single = duration;
+
+            if (gOtaServer_BlockCacheEntries_c && gOtaServer_BlockReadAheadDepth_c)
+            {
+                /* The next block is read while the client turns around */
+                CHECK(duration < (uint64_t)BLOCKS * (HOST_FETCH_US + CLIENT_TURN_US) * 3U / 4U);
+            }
+        }
+        else if (gOtaServer_BlockCacheEntries_c)
+        {
+            /* More clients, hardly more time */
+            CHECK(duration < single * 3U / 2U);
+        }
+
+        HostCancelImage();
+    }
+
+    /* Short of memory: the blocks go to the cache buffers already taken, no new one is allocated */
+    buffers = CacheBuffers();
+    gLink.availableBlocks = gOtaServer_BlockCacheMinFreeBuffers_c;
+    HostStartImage(10);
+    (void)RunDownload(4, 0);
+    printf("short of memory: %u host reads, %u cache buffers\n", (unsigned)sFetches, (unsigned)CacheBuffers());
+    CHECK(CacheBuffers() == buffers);
+
+    if (gOtaServer_BlockCacheEntries_c)
+    {
+        CHECK(sFetches < BLOCKS + BLOCKS / 4U);
+    }
+
+    HostCancelImage();
+    gLink.availableBlocks = 100;
+
+    /* Same file version, new content: the cached blocks of the old image, the last ones, are not served to
+       the clients resuming near the end */
+    HostStartImage(11);
+    (void)RunDownload(2, 0);
+    HostCancelImage();
+    HostStartImage(12);
+    (void)RunDownload(2, IMAGE_SIZE - 8U * BLOCK_SIZE);
+    HostCancelImage();
+
+    printf("ota_server: all tests passed\n");
+    return 0;
+}
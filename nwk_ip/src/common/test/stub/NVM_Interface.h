@@ -0,0 +1,43 @@
+/* Host test stub of the NVM interface, not part of this tree */
+#ifndef _NVM_INTERFACE_H_
+#define _NVM_INTERFACE_H_
+
+#include "EmbeddedTypes.h"
+
+typedef enum
+{
+    gNVM_OK_c,
+    gNVM_Error_c,
+    gNVM_MetaNotFound_c,
+    gNVM_CriticalSectionActive_c,
+} NVM_Status_t;
+
+typedef enum
+{
+    gNVM_MirroredInRam_c,
+    gNVM_NotMirroredInRam_c,
+    gNVM_NotMirroredInRamAutoRestore_c,
+} NVM_DataEntryType_t;
+
+typedef struct
+{
+    void *pData;
+    uint16_t ElementsCount;
+    uint16_t ElementSize;
+    uint16_t DataEntryID;
+    uint16_t DataEntryType;
+} NVM_DataEntry_t;
+
+#define gNvStorageIncluded_d        1
+#define gUnmirroredFeatureSet_d     1
+#define gNvEndOfTableId_c           0xFFFF
+#define gNvTableEntriesCountMax_c   38
+
+NVM_Status_t NvSaveOnIdle(void *ptrData, bool_t saveAll);
+NVM_Status_t NvSyncSave(void *ptrData, bool_t saveAll);
+NVM_Status_t NvSaveOnInterval(void *ptrData);
+NVM_Status_t NvErase(void **ptrData);
+NVM_Status_t NvMoveToRam(void **ptrData);
+NVM_Status_t NvRestoreDataSet(void *ptrData, bool_t restoreAll);
+
+#endif
@@ -0,0 +1,48 @@
+/* Host test stub of the OTA support: the image is written by ota_client_test.c, the host link of the
+   server is simulated by ota_server_test.c */
+#ifndef _OTA_SUPPORT_H_
+#define _OTA_SUPPORT_H_
+
+#include "EmbeddedTypes.h"
+
+typedef enum
+{
+    gOtaSucess_c = 0,
+    gOtaNoImage_c,
+    gOtaUpdated_c,
+    gOtaError_c,
+    gOtaCrcError_c,
+    gOtaInvalidParam_c,
+    gOtaInvalidOperation_c,
+    gOtaExternalFlashError_c,
+    gOtaInternalFlashError_c,
+} otaResult_t;
+
+#define gBootFlagsSectorBitNo   0
+
+otaResult_t OTA_StartImage(uint32_t length);
+otaResult_t OTA_PushImageChunk(uint8_t *pData, uint16_t length, uint32_t *pImageLength, uint32_t *pImageOffset);
+otaResult_t OTA_CommitImage(uint8_t *pBitmap);
+void OTA_CancelImage(void);
+void OTA_SetNewImageFlag(void);
+uint16_t OTA_CrcCompute(uint8_t *pData, uint16_t length, uint16_t crcValueOld);
+
+/* OTA server, host link over FSCI */
+typedef struct otaServer_AppCB_tag
+{
+    otaResult_t (*otaServerImgNotifyCnf)(uint8_t *pBuffer, uint16_t len);
+    otaResult_t (*otaServerSetModeCnf)(uint8_t *pBuffer, uint16_t len);
+    otaResult_t (*otaServerQueryImageCnf)(uint8_t *pBuffer, uint16_t len);
+    otaResult_t (*otaServerBlockReceived)(uint8_t *pBuffer, uint16_t len);
+    otaResult_t (*otaServerCancelImgCnf)(uint8_t *pBuffer, uint16_t len);
+    otaResult_t (*otaServerAbortOTAUpgradeCnf)(uint8_t *pBuffer, uint16_t len);
+    otaResult_t (*otaServerSetFileVersPoliciesCnf)(uint8_t *pBuffer, uint16_t len);
+    otaResult_t (*otaServerClientInfoCnf)(uint8_t *pBuffer, uint16_t len);
+} otaServer_AppCB_t;
+
+otaResult_t OTA_RegisterToFsci(uint32_t fsciInterface, otaServer_AppCB_t *pCB);
+otaResult_t OTA_QueryImageReq(uint16_t devId, uint16_t manufacturer, uint16_t imgType, uint32_t fileVersion);
+otaResult_t OTA_ImageChunkReq(uint32_t offset, uint16_t len, uint16_t devId);
+void OTA_ClientInfoCnf(uint8_t *pData, uint32_t offset, uint16_t devId);
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file air_baseline.c
+ * This is the source file for the CCS811 baseline log
+ */
+
+#include "air_baseline.h"
+#include "CCS811.h"
+#include "spi_flash_driver.h"
+#include "spi_bus_share.h"
+#include "img_program_ext.h"
+#include "flash_ica_driver.h"
+#include "DeferredLog.h"
+
+/*****************************************************************************
+ * Variables
+ ****************************************************************************/
+#define AIR_BASELINE_SLOTS          (FLASH_SECTOR_SIZE / sizeof(uint32_t))
+
+static bool sLogReady;
+static uint16_t sNextSlot;          /* AIR_BASELINE_SLOTS: sector full */
+static uint16_t sStored;
+static uint32_t sLastCheckpoint;    /* ms */
+
+/* Record queued for AirBaseline_Idle, 0: none. A record is never 0 as it holds the baseline and
+ * its complement. */
+static volatile uint32_t sPendingRecord;
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+bool AirBaseline_Restore(uint16_t *baseline)
+{
+    uint32_t records[32];
+    uint32_t slot;
+    uint32_t i;
+    status_t status;
+    bool found = false;
+
+    if (img_program_ext_init() != IMG_EXT_NO_ERROR)
+    {
+        return false;
+    }
+
+    for (slot = 0; slot < AIR_BASELINE_SLOTS; slot += sizeof(records) / sizeof(records[0]))
+    {
+        SPI_Bus_Share_Acquire(kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, SPI_BUS_SHARE_NO_DEADLINE);
+        status = SPI_Flash_Read(AIR_BASELINE_FLASH_ADDR + slot * sizeof(uint32_t), sizeof(records), records);
+        SPI_Bus_Share_Release();
+
+        if (status != kStatus_Success)
+        {
+            return false;
+        }
+
+        for (i = 0; i < sizeof(records) / sizeof(records[0]); i++)
+        {
+            if (records[i] == 0xFFFFFFFFU)
+            {
+                sNextSlot = slot + i;
+                sLogReady = true;
+                return found;
+            }
+
+            /* Records torn by a reset are skipped */
+            if ((uint16_t)(records[i] >> 16) == (uint16_t)~records[i])
+            {
+                sStored = (uint16_t)records[i];
+                *baseline = sStored;
+                found = true;
+            }
+        }
+    }
+
+    sNextSlot = AIR_BASELINE_SLOTS;
+    sLogReady = true;
+    return found;
+}
+
+void AirBaseline_Checkpoint(uint32_t now)
+{
+    unsigned int baseline;
+
+    /* The first checkpoint is taken at the end of the warm-up */
+    if (!sLogReady || (now < AIR_BASELINE_WARM_UP) ||
+        ((sLastCheckpoint != 0) && ((now - sLastCheckpoint) < AIR_BASELINE_CHECKPOINT)))
+    {
+        return;
+    }
+
+    sLastCheckpoint = now;
+
+    if ((CCS811_getBaseline(&baseline) != CCS811_SUCCESS) ||
+        ((sNextSlot != 0) && ((uint16_t)baseline == sStored)))
+    {
+        return;
+    }
+
+    sPendingRecord = (uint16_t)baseline | ((uint32_t)(uint16_t)~baseline << 16);
+}
+
+void AirBaseline_Idle(void)
+{
+    uint32_t record = sPendingRecord;
+    status_t status;
+
+    if (record == 0)
+    {
+        return;
+    }
+    sPendingRecord = 0;
+
+    if (sNextSlot >= AIR_BASELINE_SLOTS)
+    {
+        SPI_Bus_Share_Acquire(kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, SPI_BUS_SHARE_NO_DEADLINE);
+        status = SPI_Flash_Erase_Block(AIR_BASELINE_FLASH_ADDR, FLASH_SECTOR_SIZE);
+        SPI_Bus_Share_Release();
+
+        if (status != kStatus_Success)
+        {
+            DLOG_PRINTF("\r\n-->  Air baseline: erase failed. ");
+            return;
+        }
+        sNextSlot = 0;
+    }
+
+    SPI_Bus_Share_Acquire(kSpiBusClientStorage, SPI_BUS_SHARE_PRIO_STORAGE, SPI_BUS_SHARE_NO_DEADLINE);
+    status = SPI_Flash_Write(AIR_BASELINE_FLASH_ADDR + sNextSlot * sizeof(uint32_t), sizeof(record), &record);
+    SPI_Bus_Share_Release();
+
+    if (status == kStatus_Success)
+    {
+        sStored = (uint16_t)record;
+    }
+    else
+    {
+        DLOG_PRINTF("\r\n-->  Air baseline: write failed. ");
+    }
+
+    /* A failed write may have left a partial record, never program the slot again */
+    sNextSlot++;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file air_baseline.h
+ * This is the header file for the CCS811 baseline log
+ */
+
+#ifndef _AIR_BASELINE_H_
+#define _AIR_BASELINE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * @addtogroup air_baseline Air Quality Baseline
+ *
+ * The CCS811 needs a long burn-in before its baseline settles. The air_baseline module keeps the
+ * baseline in a log of 32 bit records in one external flash sector, so that it is restored at the
+ * next power-on.
+ *
+ * A record holds the baseline and its complement: a record torn by a reset does not match and is
+ * skipped. Records are appended until the sector is full, the sector is then erased.
+ *
+ * AirBaseline_Checkpoint reads the baseline from the sensor, from the sampling context. The flash
+ * write is left to AirBaseline_Idle, run from the idle loop of the application.
+ *
+ * @{
+ * @brief CCS811 baseline log
+ */
+
+#ifndef AIR_BASELINE_FLASH_ADDR
+#define AIR_BASELINE_FLASH_ADDR     (FICA_AIR_BASELINE_ADDR) /*!< Log sector, reserved in flash_ica_driver.h */
+#endif
+
+#ifndef AIR_BASELINE_WARM_UP
+#define AIR_BASELINE_WARM_UP        (20U * 60U * 1000U) /*!< ms, before the baseline is meaningful */
+#endif
+
+#ifndef AIR_BASELINE_CHECKPOINT
+#define AIR_BASELINE_CHECKPOINT     (60U * 60U * 1000U) /*!< ms, between two checkpoints */
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Reads the log and finds its first free record. Must be called once before
+ *        AirBaseline_Checkpoint, which does nothing otherwise.
+ *
+ * @param[out] baseline  Last stored baseline
+ *
+ * @return true if a baseline was found
+ *
+ */
+bool AirBaseline_Restore(uint16_t *baseline);
+
+/*!
+ * @brief Queues the current CCS811 baseline for the log once per AIR_BASELINE_CHECKPOINT, after
+ *        AIR_BASELINE_WARM_UP, if it changed
+ *
+ * @param[in] now  ms since power-on
+ *
+ * @return None
+ *
+ */
+void AirBaseline_Checkpoint(uint32_t now);
+
+/*!
+ * @brief Writes the queued baseline to the log, erasing the sector first when it is full
+ *
+ * @return None
+ *
+ */
+void AirBaseline_Idle(void);
+
+/*! @}*/
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _AIR_BASELINE_H_
@@ -0,0 +1,534 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file motion_capture.c
+ * This is the source file for the accelerometer and gyroscope FIFO capture
+ */
+
+#include <string.h>
+#include "motion_capture.h"
+#include "sensor_events.h"
+#include "sensors.h"
+#include "board.h"
+#include "TimersManager.h"
+#include "fsl_os_abstraction.h"
+
+/*****************************************************************************
+ * Variables
+ ****************************************************************************/
+#define MOTION_RING_MASK        (MOTION_CAPTURE_RING_SIZE - 1U)
+#define MOTION_STAGE_SIZE       (2U * MOTION_CAPTURE_FIFO_DEPTH)
+#define MOTION_AXIS_DATA_SIZE   (6U)
+
+/* Samples of one sensor waiting for their counterpart of the other sensor */
+typedef struct _motion_stage
+{
+    motion_sample_t samples[MOTION_STAGE_SIZE];
+    uint32_t count;
+    uint32_t lastTimestamp;     /* us, last sample of the previous batch */
+    bool timeline;              /* lastTimestamp is valid */
+} motion_stage_t;
+
+static volatile bool sRunning = false;
+static volatile motion_batch_callback_t sBatchCallback;
+static uint32_t sPeriod;                    /* us */
+static motion_stage_t sAccelStage;
+static motion_stage_t sGyroStage;
+static motion_sample_t sLatest;             /* Last value of each vector */
+static uint8_t sFifoData[MOTION_CAPTURE_FIFO_DEPTH * MOTION_AXIS_DATA_SIZE];
+
+/* Ring written by the sensor events task only, sHead is the sequence number of the next sample */
+static motion_sample_t sRing[MOTION_CAPTURE_RING_SIZE];
+static volatile uint32_t sHead;
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+static uint8_t MotionCapture_ReadRegs(uint8_t address, uint8_t reg, uint8_t *data, uint32_t size)
+{
+    return App_I2C1_Read(address, &reg, 1, data, size);
+}
+
+static uint8_t MotionCapture_WriteReg(uint8_t address, uint8_t reg, uint8_t value)
+{
+    uint8_t buf[2];
+
+    buf[0] = reg;
+    buf[1] = value;
+
+    return App_I2C1_Write(address, buf, sizeof(buf));
+}
+
+static uint8_t MotionCapture_UpdateReg(uint8_t address, uint8_t reg, uint8_t mask, uint8_t value)
+{
+    uint8_t tmp;
+
+    if (MotionCapture_ReadRegs(address, reg, &tmp, 1) != I2C_RESULT_OK)
+    {
+        return I2C_RESULT_FAIL;
+    }
+
+    return MotionCapture_WriteReg(address, reg, (tmp & (uint8_t)~mask) | value);
+}
+
+static void MotionCapture_Publish(const motion_sample_t *sample)
+{
+    uint32_t head = sHead;
+
+    sRing[head & MOTION_RING_MASK] = *sample;
+
+    /* The sample must be complete before readers can see it */
+    __DMB();
+    sHead = head + 1U;
+
+    OSA_InterruptDisable();
+    sLatest.timestamp = sample->timestamp;
+    if (sample->flags & kMotionSampleAccel)
+    {
+        memcpy(sLatest.accel, sample->accel, sizeof(sLatest.accel));
+    }
+    if (sample->flags & kMotionSampleGyro)
+    {
+        memcpy(sLatest.gyro, sample->gyro, sizeof(sLatest.gyro));
+    }
+    if (sample->flags & kMotionSampleMag)
+    {
+        memcpy(sLatest.mag, sample->mag, sizeof(sLatest.mag));
+    }
+    sLatest.flags |= sample->flags;
+    OSA_InterruptEnable();
+}
+
+/* Publishes the first count samples of a stage unpaired and removes them */
+static void MotionCapture_Flush(motion_stage_t *stage, uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        MotionCapture_Publish(&stage->samples[i]);
+    }
+    stage->count -= count;
+    memmove(&stage->samples[0], &stage->samples[count], stage->count * sizeof(motion_sample_t));
+}
+
+/* Appends a drained FIFO batch to a stage, one sample per period ending at the drain time */
+static void MotionCapture_Stage(motion_stage_t *stage, const uint8_t *raw, uint8_t count, uint32_t timestamp, uint8_t flag)
+{
+    motion_sample_t *pSample;
+    uint32_t first = timestamp - (count - 1U) * sPeriod;
+    int32_t drift;
+    uint32_t i;
+
+    /* Keep the time line of the previous batch while it agrees with the drain time */
+    if (stage->timeline)
+    {
+        drift = (int32_t)(first - (stage->lastTimestamp + sPeriod));
+
+        if ((drift <= (int32_t)(sPeriod / 2U)) && (drift >= -(int32_t)(sPeriod / 2U)))
+        {
+            first = stage->lastTimestamp + sPeriod;
+        }
+    }
+
+    /* The other sensor stalled, let its counterparts go unpaired */
+    if ((stage->count + count) > MOTION_STAGE_SIZE)
+    {
+        MotionCapture_Flush(stage, stage->count + count - MOTION_STAGE_SIZE);
+    }
+
+    for (i = 0; i < count; i++, raw += MOTION_AXIS_DATA_SIZE)
+    {
+        pSample = &stage->samples[stage->count++];
+        memset(pSample, 0, sizeof(motion_sample_t));
+        pSample->timestamp = first + i * sPeriod;
+        pSample->flags = flag;
+
+        if (kMotionSampleAccel == flag)
+        {
+            /* 14 bit left justified */
+            pSample->accel[0] = (int16_t)((raw[0] << 8) | raw[1]) >> 2;
+            pSample->accel[1] = (int16_t)((raw[2] << 8) | raw[3]) >> 2;
+            pSample->accel[2] = (int16_t)((raw[4] << 8) | raw[5]) >> 2;
+        }
+        else
+        {
+            pSample->gyro[0] = (int16_t)((raw[0] << 8) | raw[1]);
+            pSample->gyro[1] = (int16_t)((raw[2] << 8) | raw[3]);
+            pSample->gyro[2] = (int16_t)((raw[4] << 8) | raw[5]);
+        }
+    }
+
+    stage->lastTimestamp = first + (count - 1U) * sPeriod;
+    stage->timeline = true;
+}
+
+/* Pairs the staged samples taken within half a period, in time order */
+static void MotionCapture_Align(void)
+{
+    motion_sample_t *pAccel;
+    motion_sample_t *pGyro;
+    uint32_t accelUsed = 0;
+    uint32_t gyroUsed = 0;
+    int32_t dt;
+
+    while ((accelUsed < sAccelStage.count) && (gyroUsed < sGyroStage.count))
+    {
+        pAccel = &sAccelStage.samples[accelUsed];
+        pGyro = &sGyroStage.samples[gyroUsed];
+        dt = (int32_t)(pAccel->timestamp - pGyro->timestamp);
+
+        if ((dt <= (int32_t)(sPeriod / 2U)) && (dt >= -(int32_t)(sPeriod / 2U)))
+        {
+            memcpy(pAccel->gyro, pGyro->gyro, sizeof(pAccel->gyro));
+            pAccel->flags |= kMotionSampleGyro;
+            MotionCapture_Publish(pAccel);
+            accelUsed++;
+            gyroUsed++;
+        }
+        else if (dt < 0)
+        {
+            MotionCapture_Publish(pAccel);
+            accelUsed++;
+        }
+        else
+        {
+            MotionCapture_Publish(pGyro);
+            gyroUsed++;
+        }
+    }
+
+    /* Already published, only remove them */
+    sAccelStage.count -= accelUsed;
+    memmove(&sAccelStage.samples[0], &sAccelStage.samples[accelUsed], sAccelStage.count * sizeof(motion_sample_t));
+    sGyroStage.count -= gyroUsed;
+    memmove(&sGyroStage.samples[0], &sGyroStage.samples[gyroUsed], sGyroStage.count * sizeof(motion_sample_t));
+}
+
+static void MotionCapture_NotifyBatch(void)
+{
+    motion_batch_callback_t callback = sBatchCallback;
+
+    if (NULL != callback)
+    {
+        callback();
+    }
+}
+
+/*!
+ * @brief FXOS8700 FIFO watermark handler, drains the FIFO and reads the magnetometer once
+ */
+static void MotionCapture_AccelHandler(void)
+{
+    uint8_t status;
+    uint8_t count;
+    uint8_t mag[MOTION_AXIS_DATA_SIZE];
+    uint32_t now;
+    bool magValid;
+
+    if (!sRunning ||
+        (MotionCapture_ReadRegs(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_F_STATUS_REG, &status, 1) != I2C_RESULT_OK))
+    {
+        return;
+    }
+
+    count = status & FXOS8700_F_CNT_MASK;
+
+    if ((0U == count) ||
+        (MotionCapture_ReadRegs(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_OUT_X_MSB_REG, sFifoData,
+                                count * MOTION_AXIS_DATA_SIZE) != I2C_RESULT_OK))
+    {
+        return;
+    }
+
+    now = (uint32_t)TMR_GetTimestamp();
+    magValid = (MotionCapture_ReadRegs(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_M_OUT_X_MSB_REG, mag, sizeof(mag)) == I2C_RESULT_OK);
+
+    MotionCapture_PushAccelBatch(sFifoData, count, now, magValid ? mag : NULL);
+    MotionCapture_NotifyBatch();
+}
+
+/*!
+ * @brief FXAS21002 FIFO watermark handler, drains the FIFO
+ */
+static void MotionCapture_GyroHandler(void)
+{
+    uint8_t status;
+    uint8_t count;
+
+    if (!sRunning ||
+        (MotionCapture_ReadRegs(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_F_STATUS, &status, 1) != I2C_RESULT_OK))
+    {
+        return;
+    }
+
+    count = status & FXAS21002_F_STATUS_F_CNT_MASK;
+
+    if ((0U == count) ||
+        (MotionCapture_ReadRegs(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_OUT_X_MSB, sFifoData,
+                                count * MOTION_AXIS_DATA_SIZE) != I2C_RESULT_OK))
+    {
+        return;
+    }
+
+    MotionCapture_PushGyroBatch(sFifoData, count, (uint32_t)TMR_GetTimestamp());
+    MotionCapture_NotifyBatch();
+}
+
+/* Puts both sensors back in the configuration set by Init_accel_mag and Init_rotation_speed */
+static uint8_t MotionCapture_Restore(void)
+{
+    uint8_t ret = 0;
+
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_CTRL_REG1, FXOS8700_ACTIVE_MASK, 0);
+    ret |= MotionCapture_WriteReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_F_SETUP_REG, FXOS8700_F_MODE_DISABLED);
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_CTRL_REG4, FXOS8700_INT_EN_FIFO_MASK, 0);
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_CTRL_REG5, FXOS8700_INT_CFG_FIFO_MASK, 0);
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_M_CTRL_REG2, FXOS8700_M_HYB_AUTOINC_MASK,
+                                   FXOS8700_M_HYB_AUTOINC_MASK);
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_CTRL_REG1, FXOS8700_DR_MASK | FXOS8700_ACTIVE_MASK,
+                                   FXOS8700_HYB_DATA_RATE_200HZ | FXOS8700_ACTIVE_MASK);
+
+    ret |= MotionCapture_UpdateReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_CTRL_REG1, FXAS21002_CTRL_REG1_MODE_MASK,
+                                   FXAS21002_CTRL_REG1_MODE_STANDBY);
+    ret |= MotionCapture_WriteReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_F_SETUP, FXAS21002_F_SETUP_F_MODE_FIFO_OFF);
+    ret |= MotionCapture_UpdateReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_CTRL_REG2,
+                                   FXAS21002_CTRL_REG2_INT_EN_FIFO_MASK | FXAS21002_CTRL_REG2_INT_CFG_FIFO_MASK, 0);
+    ret |= MotionCapture_UpdateReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_CTRL_REG3, FXAS21002_CTRL_REG3_WRAPTOONE_MASK, 0);
+    ret |= MotionCapture_UpdateReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_CTRL_REG1,
+                                   FXAS21002_CTRL_REG1_DR_MASK | FXAS21002_CTRL_REG1_MODE_MASK,
+                                   FXAS21002_CTRL_REG1_DR_12_5HZ | FXAS21002_CTRL_REG1_MODE_ACTIVE);
+
+    return ret;
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+uint8_t MotionCapture_Start(uint16_t rateHz, uint8_t watermark)
+{
+    uint8_t accelRate;
+    uint8_t gyroRate;
+    uint8_t ret = 0;
+
+    switch (rateHz)
+    {
+        case 100:
+            accelRate = FXOS8700_HYB_DATA_RATE_100HZ;
+            gyroRate = FXAS21002_CTRL_REG1_DR_100HZ;
+            break;
+        case 200:
+            accelRate = FXOS8700_HYB_DATA_RATE_200HZ;
+            gyroRate = FXAS21002_CTRL_REG1_DR_200HZ;
+            break;
+        case 400:
+            accelRate = FXOS8700_HYB_DATA_RATE_400HZ;
+            gyroRate = FXAS21002_CTRL_REG1_DR_400HZ;
+            break;
+        default:
+            return 1;
+    }
+
+    if (sRunning || (0U == watermark) || (watermark >= MOTION_CAPTURE_FIFO_DEPTH))
+    {
+        return 1;
+    }
+
+    sPeriod = 1000000U / rateHz;
+    sAccelStage.count = 0;
+    sAccelStage.timeline = false;
+    sGyroStage.count = 0;
+    sGyroStage.timeline = false;
+    sLatest.flags = 0;
+
+    /* Accelerometer: circular FIFO with watermark interrupt on INT1. The magnetometer stays on in
+     * hybrid mode, but burst reads must wrap on OUT_X_MSB to drain the FIFO. */
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_CTRL_REG1, FXOS8700_ACTIVE_MASK, 0);
+    ret |= MotionCapture_WriteReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_F_SETUP_REG, FXOS8700_F_MODE0_MASK | watermark);
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_CTRL_REG4, FXOS8700_INT_EN_FIFO_MASK,
+                                   FXOS8700_INT_EN_FIFO_MASK);
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_CTRL_REG5, FXOS8700_INT_CFG_FIFO_MASK,
+                                   FXOS8700_INT_CFG_FIFO_MASK);
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_M_CTRL_REG2, FXOS8700_M_HYB_AUTOINC_MASK, 0);
+    ret |= MotionCapture_UpdateReg(FXOS8700_I2C_SLAVE_ADDRESS, FXOS8700_CTRL_REG1, FXOS8700_DR_MASK | FXOS8700_ACTIVE_MASK,
+                                   accelRate | FXOS8700_ACTIVE_MASK);
+
+    /* Gyroscope: same, burst reads wrap on OUT_X_MSB through WRAPTOONE */
+    ret |= MotionCapture_UpdateReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_CTRL_REG1, FXAS21002_CTRL_REG1_MODE_MASK,
+                                   FXAS21002_CTRL_REG1_MODE_STANDBY);
+    ret |= MotionCapture_WriteReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_F_SETUP,
+                                  FXAS21002_F_SETUP_F_MODE_CIR_MODE | watermark);
+    ret |= MotionCapture_UpdateReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_CTRL_REG2,
+                                   FXAS21002_CTRL_REG2_INT_EN_FIFO_MASK | FXAS21002_CTRL_REG2_INT_CFG_FIFO_MASK,
+                                   FXAS21002_CTRL_REG2_INT_EN_FIFO_ENABLE | FXAS21002_CTRL_REG2_INT_CFG_FIFO_INT1);
+    ret |= MotionCapture_UpdateReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_CTRL_REG3, FXAS21002_CTRL_REG3_WRAPTOONE_MASK,
+                                   FXAS21002_CTRL_REG3_WRAPTOONE_MASK);
+    ret |= MotionCapture_UpdateReg(FXAS21002_I2C_SLAVE_ADDRESS, FXAS21002_CTRL_REG1,
+                                   FXAS21002_CTRL_REG1_DR_MASK | FXAS21002_CTRL_REG1_MODE_MASK,
+                                   gyroRate | FXAS21002_CTRL_REG1_MODE_ACTIVE);
+
+    if (ret != 0)
+    {
+        (void)MotionCapture_Restore();
+        return 1;
+    }
+
+    sRunning = true;
+    SensorEvents_RegisterHandler(kSensorEvAccel, MotionCapture_AccelHandler);
+    SensorEvents_RegisterHandler(kSensorEvGyro, MotionCapture_GyroHandler);
+
+    return 0;
+}
+
+uint8_t MotionCapture_Stop(void)
+{
+    if (!sRunning)
+    {
+        return 0;
+    }
+
+    SensorEvents_RegisterHandler(kSensorEvAccel, NULL);
+    SensorEvents_RegisterHandler(kSensorEvGyro, NULL);
+    sRunning = false;
+
+    return MotionCapture_Restore();
+}
+
+bool MotionCapture_IsRunning(void)
+{
+    return sRunning;
+}
+
+uint32_t MotionCapture_GetPeriod(void)
+{
+    return sRunning ? sPeriod : 0U;
+}
+
+void MotionCapture_SetBatchCallback(motion_batch_callback_t callback)
+{
+    sBatchCallback = callback;
+}
+
+void MotionCapture_ReaderInit(motion_reader_t *reader)
+{
+    reader->next = sHead;
+    reader->lost = 0;
+}
+
+uint32_t MotionCapture_Read(motion_reader_t *reader, motion_sample_t *samples, uint32_t maxSamples)
+{
+    uint32_t head = sHead;
+    uint32_t count;
+    uint32_t stale;
+    uint32_t i;
+
+    __DMB();
+
+    /* Skip what the writer already overwrote */
+    if ((head - reader->next) > MOTION_CAPTURE_RING_SIZE)
+    {
+        reader->lost += head - reader->next - MOTION_CAPTURE_RING_SIZE;
+        reader->next = head - MOTION_CAPTURE_RING_SIZE;
+    }
+
+    count = head - reader->next;
+    if (count > maxSamples)
+    {
+        count = maxSamples;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        samples[i] = sRing[(reader->next + i) & MOTION_RING_MASK];
+    }
+
+    /* The writer may have run while copying, drop the samples whose slot it reached */
+    __DMB();
+    head = sHead;
+    stale = 0;
+
+    while ((stale < count) && ((head - (reader->next + stale)) >= MOTION_CAPTURE_RING_SIZE))
+    {
+        stale++;
+    }
+
+    if (stale != 0)
+    {
+        memmove(&samples[0], &samples[stale], (count - stale) * sizeof(motion_sample_t));
+        reader->lost += stale;
+    }
+
+    reader->next += count;
+    return count - stale;
+}
+
+bool MotionCapture_GetLatest(motion_sample_t *sample)
+{
+    OSA_InterruptDisable();
+    *sample = sLatest;
+    OSA_InterruptEnable();
+
+    return (0U != sample->flags);
+}
+
+void MotionCapture_PushAccelBatch(const uint8_t *raw, uint8_t count, uint32_t timestamp, const uint8_t *mag)
+{
+    motion_sample_t *pLast;
+
+    if ((0U == count) || (count > MOTION_CAPTURE_FIFO_DEPTH))
+    {
+        return;
+    }
+
+    MotionCapture_Stage(&sAccelStage, raw, count, timestamp, kMotionSampleAccel);
+
+    if (NULL != mag)
+    {
+        pLast = &sAccelStage.samples[sAccelStage.count - 1U];
+        pLast->mag[0] = (int16_t)((mag[0] << 8) | mag[1]);
+        pLast->mag[1] = (int16_t)((mag[2] << 8) | mag[3]);
+        pLast->mag[2] = (int16_t)((mag[4] << 8) | mag[5]);
+        pLast->flags |= kMotionSampleMag;
+    }
+
+    MotionCapture_Align();
+}
+
+void MotionCapture_PushGyroBatch(const uint8_t *raw, uint8_t count, uint32_t timestamp)
+{
+    if ((0U == count) || (count > MOTION_CAPTURE_FIFO_DEPTH))
+    {
+        return;
+    }
+
+    MotionCapture_Stage(&sGyroStage, raw, count, timestamp, kMotionSampleGyro);
+    MotionCapture_Align();
+}
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file motion_capture.h
+ * This is the header file for the accelerometer and gyroscope FIFO capture
+ */
+
+#ifndef _MOTION_CAPTURE_H_
+#define _MOTION_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * @addtogroup motion_capture Motion Capture
+ *
+ * The motion_capture module streams the FXOS8700 accelerometer and the FXAS21002 gyroscope at
+ * 100 to 400 Hz through their hardware FIFOs.
+ *
+ * Both FIFOs raise a watermark interrupt on their INT1 pin. The sensor events task then drains
+ * each FIFO with one burst read, timestamps the samples from the drain time and the output data
+ * rate, pairs the accelerometer and gyroscope samples taken within half a period of each other
+ * and publishes them in a ring. The CPU wakes once per watermark, not once per sample.
+ *
+ * The ring has a single writer and any number of readers. Readers never block the writer: a
+ * reader that falls more than MOTION_CAPTURE_RING_SIZE samples behind loses the oldest ones.
+ *
+ * Usage
+ * -------------------------------------------------------------------------------------------------
+ *
+ * @code
+ *
+ *      motion_reader_t reader;
+ *      motion_sample_t samples[16];
+ *      uint32_t count;
+ *
+ *      SensorEvents_Init();
+ *      MotionCapture_Start(200, 20);
+ *      MotionCapture_ReaderInit(&reader);
+ *
+ *      count = MotionCapture_Read(&reader, samples, 16);
+ *
+ * @endcode
+ *
+ * @{
+ * @brief Accelerometer and gyroscope FIFO capture
+ */
+
+#define MOTION_CAPTURE_RING_SIZE    (128U)  /*!< Samples kept in the ring, power of two */
+#define MOTION_CAPTURE_FIFO_DEPTH   (32U)   /*!< Samples in the FXOS8700 and FXAS21002 FIFOs */
+
+/*!
+ * @brief Motion sample flags, tell which vectors of a sample are valid
+ */
+typedef enum _motion_sample_flags
+{
+    kMotionSampleAccel = (1U << 0U),    /*!< accel holds an accelerometer sample */
+    kMotionSampleGyro  = (1U << 1U),    /*!< gyro holds a gyroscope sample */
+    kMotionSampleMag   = (1U << 2U),    /*!< mag holds a magnetometer sample, once per FIFO drain */
+
+}motion_sample_flags_t;
+
+/*!
+ * @brief Time aligned motion sample
+ */
+typedef struct _motion_sample
+{
+    uint32_t timestamp;     /*!< us, TMR_GetTimestamp() time base */
+    int16_t accel[3];       /*!< 14 bit accelerometer counts, scaled by the FXOS8700 range */
+    int16_t gyro[3];        /*!< Gyroscope counts, scaled by the FXAS21002 range */
+    int16_t mag[3];         /*!< Magnetometer counts, 0.1 uT/LSB */
+    uint8_t flags;          /*!< motion_sample_flags_t */
+} motion_sample_t;
+
+/*!
+ * @brief Read position of one ring consumer
+ */
+typedef struct _motion_reader
+{
+    uint32_t next;          /*!< Sequence number of the next sample to read */
+    uint32_t lost;          /*!< Samples overwritten before this reader got them */
+} motion_reader_t;
+
+/*!
+ * @brief Callback run in the sensor events task after each FIFO drain
+ */
+typedef void (*motion_batch_callback_t)(void);
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Switches both sensors to FIFO capture and starts filling the ring.
+ *        The sensor events dispatcher must be initialized.
+ *
+ * @param[in] rateHz     Output data rate of both sensors: 100, 200 or 400
+ * @param[in] watermark  FIFO level raising the interrupt, 1 to MOTION_CAPTURE_FIFO_DEPTH - 1
+ *
+ * @return 0 on success, 1 on invalid parameter or I2C failure
+ *
+ */
+uint8_t MotionCapture_Start(uint16_t rateHz, uint8_t watermark);
+
+/*!
+ * @brief Stops the capture and restores the single sample configuration of both sensors
+ *
+ * @return 0 on success, 1 on I2C failure
+ *
+ */
+uint8_t MotionCapture_Stop(void);
+
+/*!
+ * @brief Tells if the capture is running
+ *
+ * @return true while the sensors are in FIFO mode
+ *
+ */
+bool MotionCapture_IsRunning(void);
+
+/*!
+ * @brief Gives the sample period of the running capture
+ *
+ * @return us, 0 if the capture is stopped
+ *
+ */
+uint32_t MotionCapture_GetPeriod(void);
+
+/*!
+ * @brief Sets the callback run after each FIFO drain, once the new samples are published.
+ *        Lets a consumer process the capture batch by batch from the sensor events task.
+ *
+ * @param[in] callback  Callback, or NULL to remove it
+ *
+ * @return None
+ *
+ */
+void MotionCapture_SetBatchCallback(motion_batch_callback_t callback);
+
+/*!
+ * @brief Positions a reader on the next sample to be published
+ *
+ * @param[out] reader  Reader to initialize
+ *
+ * @return None
+ *
+ */
+void MotionCapture_ReaderInit(motion_reader_t *reader);
+
+/*!
+ * @brief Copies the samples published since the last call, oldest first. Can be called from
+ *        any task, each reader must be used by one task only.
+ *
+ * @param[in,out] reader      Reader position
+ * @param[out]    samples     Destination
+ * @param[in]     maxSamples  Size of samples
+ *
+ * @return Number of samples copied
+ *
+ */
+uint32_t MotionCapture_Read(motion_reader_t *reader, motion_sample_t *samples, uint32_t maxSamples);
+
+/*!
+ * @brief Copies the last published value of each vector, flags tell which ones were published
+ *        since the capture started
+ *
+ * @param[out] sample  Destination, timestamp of the last published sample
+ *
+ * @return false if no sample was published since the capture started
+ *
+ */
+bool MotionCapture_GetLatest(motion_sample_t *sample);
+
+/*!
+ * @brief Feeds one drained FXOS8700 FIFO batch to the alignment stage. Called by the capture
+ *        itself, exposed to replay recorded register streams.
+ *
+ * @param[in] raw        count * 6 bytes read from OUT_X_MSB, big endian X, Y, Z
+ * @param[in] count      Samples in raw, F_STATUS F_CNT
+ * @param[in] timestamp  us, time of the drain
+ * @param[in] mag        6 bytes read from M_OUT_X_MSB after the drain, or NULL
+ *
+ * @return None
+ *
+ */
+void MotionCapture_PushAccelBatch(const uint8_t *raw, uint8_t count, uint32_t timestamp, const uint8_t *mag);
+
+/*!
+ * @brief Feeds one drained FXAS21002 FIFO batch to the alignment stage. Called by the capture
+ *        itself, exposed to replay recorded register streams.
+ *
+ * @param[in] raw        count * 6 bytes read from OUT_X_MSB, big endian X, Y, Z
+ * @param[in] count      Samples in raw, F_STATUS F_CNT
+ * @param[in] timestamp  us, time of the drain
+ *
+ * @return None
+ *
+ */
+void MotionCapture_PushGyroBatch(const uint8_t *raw, uint8_t count, uint32_t timestamp);
+
+/*! @}*/
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _MOTION_CAPTURE_H_
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file sensor_conditioning.c
+ * This is the source file for the environmental sensor conditioning
+ */
+
+#include <string.h>
+#include "sensor_conditioning.h"
+
+/*****************************************************************************
+ * Variables
+ ****************************************************************************/
+/* Second order Butterworth low-pass, cut-off at 0.1 and 0.2 of the sample rate */
+#define CONDITIONING_LOWPASS_0_1    {0.06745527f, 0.13491055f, 0.06745527f, 1.1429805f, -0.4128016f}
+#define CONDITIONING_LOWPASS_0_2    {0.20657208f, 0.41314417f, 0.20657208f, 0.36952738f, -0.19581571f}
+
+/* Warm-up integration step, fine enough for the implicit Euler step to follow the exponential */
+#define CONDITIONING_HEATING_STEP   (SENSOR_CONDITIONING_HEATING_TIME / 16U)
+
+typedef struct _conditioning_state
+{
+    float window[SENSOR_CONDITIONING_MEDIAN_MAX];  /* Last inputs, circular */
+    uint8_t windowNext;
+    float x1, x2, y1, y2;                          /* IIR history */
+    uint8_t decimationCount;
+    bool primed;
+} conditioning_state_t;
+
+/* Slow environmental quantities are smoothed, light follows quick changes and only drops spikes */
+static sensor_conditioning_config_t maConfig[kConditioningChannels] =
+{
+    {5, true, CONDITIONING_LOWPASS_0_1, 1},   /* Temperature */
+    {5, true, CONDITIONING_LOWPASS_0_1, 1},   /* Humidity */
+    {3, true, CONDITIONING_LOWPASS_0_2, 1},   /* Pressure */
+    {3, false, CONDITIONING_LOWPASS_0_2, 1},  /* Ambient light */
+};
+
+static conditioning_state_t maState[kConditioningChannels];
+
+static float sHeatingOffset;
+static uint32_t sHeatingUptime;
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+static void SensorConditioning_Prime(conditioning_state_t *state, float value)
+{
+    uint32_t i;
+
+    for (i = 0; i < SENSOR_CONDITIONING_MEDIAN_MAX; i++)
+    {
+        state->window[i] = value;
+    }
+    state->windowNext = 0;
+    state->x1 = value;
+    state->x2 = value;
+    state->y1 = value;
+    state->y2 = value;
+    state->primed = true;
+}
+
+static float SensorConditioning_Median(const float *window, uint8_t length)
+{
+    float sorted[SENSOR_CONDITIONING_MEDIAN_MAX];
+    float value;
+    int32_t i;
+    int32_t j;
+
+    /* Insertion sort, the window is at most 7 long */
+    for (i = 0; i < length; i++)
+    {
+        value = window[i];
+        for (j = i - 1; (j >= 0) && (sorted[j] > value); j--)
+        {
+            sorted[j + 1] = sorted[j];
+        }
+        sorted[j + 1] = value;
+    }
+
+    return sorted[length / 2U];
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+uint8_t SensorConditioning_Configure(sensor_conditioning_channel_t channel, const sensor_conditioning_config_t *config)
+{
+    if ((channel >= kConditioningChannels) || (NULL == config) || (0U == config->decimation) ||
+        (0U == (config->medianLength & 1U)) || (config->medianLength > SENSOR_CONDITIONING_MEDIAN_MAX))
+    {
+        return 1;
+    }
+
+    maConfig[channel] = *config;
+    SensorConditioning_Reset(channel);
+
+    return 0;
+}
+
+void SensorConditioning_Reset(sensor_conditioning_channel_t channel)
+{
+    if (channel < kConditioningChannels)
+    {
+        maState[channel].primed = false;
+        maState[channel].decimationCount = 0;
+    }
+}
+
+uint32_t SensorConditioning_Process(sensor_conditioning_channel_t channel, const float *in, float *out, uint32_t count)
+{
+    const sensor_conditioning_config_t *config;
+    conditioning_state_t *state;
+    const float *b;
+    float x1, x2, y1, y2;
+    float y;
+    uint32_t kept;
+    uint32_t i;
+
+    if ((channel >= kConditioningChannels) || (0U == count))
+    {
+        return 0;
+    }
+
+    config = &maConfig[channel];
+    state = &maState[channel];
+
+    if (!state->primed)
+    {
+        SensorConditioning_Prime(state, in[0]);
+    }
+
+    /* Outlier rejection, the window keeps copies so out may be in */
+    for (i = 0; i < count; i++)
+    {
+        if (config->medianLength > 1U)
+        {
+            state->window[state->windowNext] = in[i];
+            state->windowNext = (state->windowNext + 1U) % config->medianLength;
+            out[i] = SensorConditioning_Median(state->window, config->medianLength);
+        }
+        else
+        {
+            out[i] = in[i];
+        }
+    }
+
+    /* Low-pass, direct form I with the history held in registers over the batch */
+    if (config->lowPass)
+    {
+        b = config->coefficients;
+        x1 = state->x1;
+        x2 = state->x2;
+        y1 = state->y1;
+        y2 = state->y2;
+
+        for (i = 0; i < count; i++)
+        {
+            y = b[0] * out[i] + b[1] * x1 + b[2] * x2 + b[3] * y1 + b[4] * y2;
+            x2 = x1;
+            x1 = out[i];
+            y2 = y1;
+            y1 = y;
+            out[i] = y;
+        }
+
+        state->x1 = x1;
+        state->x2 = x2;
+        state->y1 = y1;
+        state->y2 = y2;
+    }
+
+    /* Decimation */
+    kept = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (0U == state->decimationCount)
+        {
+            out[kept++] = out[i];
+        }
+
+        if (++state->decimationCount >= config->decimation)
+        {
+            state->decimationCount = 0;
+        }
+    }
+
+    return kept;
+}
+
+bool SensorConditioning_ProcessSample(sensor_conditioning_channel_t channel, float in, float *out)
+{
+    float value = in;
+
+    if (SensorConditioning_Process(channel, &value, &value, 1) == 0U)
+    {
+        return false;
+    }
+
+    *out = value;
+    return true;
+}
+
+float SensorConditioning_CompensateTemperature(float sensorCelsius, uint32_t uptime)
+{
+    uint32_t elapsed;
+    uint32_t step;
+
+    if (UINT32_MAX == uptime)
+    {
+        return sensorCelsius - SENSOR_CONDITIONING_HEATING_OFFSET;
+    }
+
+    elapsed = uptime - sHeatingUptime;
+    sHeatingUptime = uptime;
+
+    if (elapsed > (8U * SENSOR_CONDITIONING_HEATING_TIME))
+    {
+        /* Settled */
+        sHeatingOffset = SENSOR_CONDITIONING_HEATING_OFFSET;
+    }
+    else
+    {
+        /* d(offset)/dt = (HEATING_OFFSET - offset) / HEATING_TIME */
+        while (elapsed != 0U)
+        {
+            step = (elapsed > CONDITIONING_HEATING_STEP) ? CONDITIONING_HEATING_STEP : elapsed;
+            elapsed -= step;
+            sHeatingOffset += (SENSOR_CONDITIONING_HEATING_OFFSET - sHeatingOffset) * (float)step /
+                              (float)(SENSOR_CONDITIONING_HEATING_TIME + step);
+        }
+    }
+
+    return sensorCelsius - sHeatingOffset;
+}
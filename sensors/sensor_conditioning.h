@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file sensor_conditioning.h
+ * This is the header file for the environmental sensor conditioning
+ */
+
+#ifndef _SENSOR_CONDITIONING_H_
+#define _SENSOR_CONDITIONING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * @addtogroup sensor_conditioning Sensor Conditioning
+ *
+ * The sensor_conditioning module cleans the temperature, humidity, pressure and ambient light
+ * readings before they are displayed, reported or stored.
+ *
+ * Each channel runs, in this order:
+ * - a median-of-N filter rejecting isolated outliers,
+ * - a second order IIR low-pass filter, coefficients in the CMSIS-DSP arm_biquad_cascade_df1_f32
+ *   layout {b0, b1, b2, a1, a2}, feedback coefficients negated,
+ * - a decimation keeping one sample out of N.
+ *
+ * Blocks are processed one stage at a time over the whole batch. The filters are primed with the
+ * first sample, so the output starts at the input level.
+ *
+ * SensorConditioning_CompensateTemperature replaces the constant ENS210 offset by a first order
+ * warm-up model of the board self-heating.
+ *
+ * Usage
+ * -------------------------------------------------------------------------------------------------
+ *
+ * @code
+ *
+ *      float temperature;
+ *
+ *      if (SensorConditioning_ProcessSample(kConditioningTemperature, raw, &temperature))
+ *      {
+ *          // Report temperature
+ *          ...
+ *      }
+ *
+ * @endcode
+ *
+ * @{
+ * @brief Environmental sensor conditioning
+ */
+
+#define SENSOR_CONDITIONING_MEDIAN_MAX      (7U)    /*!< Longest median window */
+
+#ifndef SENSOR_CONDITIONING_HEATING_OFFSET
+#define SENSOR_CONDITIONING_HEATING_OFFSET  (7.0f)      /*!< Celsius, ENS210 excess over ambient once warm */
+#endif
+
+#ifndef SENSOR_CONDITIONING_HEATING_TIME
+#define SENSOR_CONDITIONING_HEATING_TIME    (900000U)   /*!< ms, time constant of the board warm-up */
+#endif
+
+/*!
+ * @brief Conditioned channels
+ */
+typedef enum _sensor_conditioning_channel
+{
+    kConditioningTemperature = 0U,  /*!< Celsius */
+    kConditioningHumidity,          /*!< %RH */
+    kConditioningPressure,          /*!< hPa */
+    kConditioningAmbientLight,      /*!< lux */
+    kConditioningChannels,          /*!< Number of channels */
+
+}sensor_conditioning_channel_t;
+
+/*!
+ * @brief Conditioning of one channel
+ */
+typedef struct _sensor_conditioning_config
+{
+    uint8_t medianLength;       /*!< Odd, up to SENSOR_CONDITIONING_MEDIAN_MAX, 1 disables the stage */
+    bool lowPass;               /*!< Enables the IIR stage */
+    float coefficients[5];      /*!< b0, b1, b2, a1, a2 of the IIR stage, CMSIS-DSP DF1 layout */
+    uint8_t decimation;         /*!< Keeps one sample out of decimation, 1 keeps all */
+} sensor_conditioning_config_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Changes the conditioning of a channel and resets its filters
+ *
+ * @param[in] channel  Channel
+ * @param[in] config   New conditioning
+ *
+ * @return 0 on success, 1 on invalid parameter
+ *
+ */
+uint8_t SensorConditioning_Configure(sensor_conditioning_channel_t channel, const sensor_conditioning_config_t *config);
+
+/*!
+ * @brief Resets the filters of a channel, the next sample primes them
+ *
+ * @param[in] channel  Channel
+ *
+ * @return None
+ *
+ */
+void SensorConditioning_Reset(sensor_conditioning_channel_t channel);
+
+/*!
+ * @brief Conditions a batch of consecutive samples of one channel
+ *
+ * @param[in]  channel  Channel
+ * @param[in]  in       Samples, oldest first
+ * @param[out] out      Conditioned samples, may be in
+ * @param[in]  count    Samples in in
+ *
+ * @return Samples written to out, less than count with decimation
+ *
+ */
+uint32_t SensorConditioning_Process(sensor_conditioning_channel_t channel, const float *in, float *out, uint32_t count);
+
+/*!
+ * @brief Conditions one sample
+ *
+ * @param[in]  channel  Channel
+ * @param[in]  in       Sample
+ * @param[out] out      Conditioned sample
+ *
+ * @return false if the decimation dropped the sample, out is then unchanged
+ *
+ */
+bool SensorConditioning_ProcessSample(sensor_conditioning_channel_t channel, float in, float *out);
+
+/*!
+ * @brief Removes the board self-heating from an ENS210 temperature. The excess temperature
+ *        rises from 0 at power-on towards SENSOR_CONDITIONING_HEATING_OFFSET with the
+ *        SENSOR_CONDITIONING_HEATING_TIME time constant.
+ *
+ * @param[in] sensorCelsius  Temperature measured by the ENS210
+ * @param[in] uptime         ms since power-on, UINT32_MAX if unknown
+ *
+ * @return Ambient temperature estimate
+ *
+ */
+float SensorConditioning_CompensateTemperature(float sensorCelsius, uint32_t uptime);
+
+/*! @}*/
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _SENSOR_CONDITIONING_H_
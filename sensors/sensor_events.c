@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*!
+ * @file sensor_events.c
+ * This is the source file for the sensor event dispatcher
+ */
+
+#include "sensor_events.h"
+#include "fsl_os_abstraction.h"
+#include "Panic.h"
+
+/*****************************************************************************
+ * Variables
+ ****************************************************************************/
+#define SENSOR_EVENTS_COUNT     (5U)
+
+osaTaskId_t  gSensorEventsTaskId;
+static osaEventId_t sSensorEventsTaskEventId;
+static volatile sensor_event_handler_t sHandlers[SENSOR_EVENTS_COUNT];
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+/*!
+ * @brief Sensor events task, runs the handlers of the sensors that raised an interrupt
+ *
+ * @param[in] argument Task parameter for RTOS. Not used, but necessary for RTOS compatibility
+ *
+ */
+static void SensorEventsTask(osaTaskParam_t argument)
+{
+    osaEventFlags_t sensorEventFlags;
+    sensor_event_handler_t handler;
+    uint32_t i;
+
+    while(1)
+    {
+        /* Wait for an event. The task will block here. */
+        (void)OSA_EventWait(sSensorEventsTaskEventId, kSensorEvAllMask, FALSE, osaWaitForever_c, &sensorEventFlags);
+
+        for (i = 0; i < SENSOR_EVENTS_COUNT; i++)
+        {
+            handler = sHandlers[i];
+
+            if ((sensorEventFlags & (1U << i)) && (NULL != handler))
+            {
+                handler();
+            }
+        }
+    }
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+OSA_TASK_DEFINE(SensorEventsTask, SENSOR_EVENTS_TASK_PRIO, 1, SENSOR_EVENTS_TASK_STACK_SIZE, FALSE);
+
+void SensorEvents_SetEvent(uint32_t events)
+{
+    /* Interrupts may fire before the dispatcher exists, the sensors are read out on registration */
+    if (NULL != sSensorEventsTaskEventId)
+    {
+        (void)OSA_EventSet(sSensorEventsTaskEventId, events);
+    }
+}
+
+void SensorEvents_RegisterHandler(sensor_events_t event, sensor_event_handler_t handler)
+{
+    uint32_t i;
+
+    for (i = 0; i < SENSOR_EVENTS_COUNT; i++)
+    {
+        if ((uint32_t)event == (1U << i))
+        {
+            sHandlers[i] = handler;
+
+            /* An interrupt line already asserted gives no new edge until its data is read */
+            if (NULL != handler)
+            {
+                SensorEvents_SetEvent(event);
+            }
+            break;
+        }
+    }
+}
+
+void SensorEvents_Init(void)
+{
+    static uint8_t initialized = FALSE;
+
+    /* Check if the dispatcher is already initialized */
+    if(FALSE == initialized)
+    {
+        initialized = TRUE;
+
+        sSensorEventsTaskEventId = OSA_EventCreate(TRUE);
+
+        if(NULL == sSensorEventsTaskEventId)
+        {
+            panic(0,0,0,0);
+        }
+        else
+        {
+            gSensorEventsTaskId = OSA_TaskCreate(OSA_TASK(SensorEventsTask), NULL);
+
+            if(NULL == gSensorEventsTaskId)
+            {
+                panic(0,0,0,0);
+            }
+        }
+    }
+}
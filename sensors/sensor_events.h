@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*!
+ * @file sensor_events.h
+ * This is the header file for the sensor event dispatcher
+ */
+
+#ifndef _SENSOR_EVENTS_H_
+#define _SENSOR_EVENTS_H_
+
+#include <stdint.h>
+
+/*!
+ * @addtogroup sensor_events Sensor Events
+ *
+ * The sensor_events module turns the sensor interrupt lines into task level events.
+ *
+ * The port_interrupts handlers set one event flag per sensor. The sensor events task wakes on
+ * these flags and runs the handler registered for each sensor that raised one, so that a sensor
+ * is only accessed over I2C when it has new data. Handlers run in task context and may block.
+ *
+ * Usage
+ * -------------------------------------------------------------------------------------------------
+ *
+ * Initialization:
+ * @code
+ *
+ *      void myPressureHandler(void)
+ *      {
+ *          // Read the pressure output registers, which also releases the interrupt line
+ *          ...
+ *      }
+ *
+ *      SensorEvents_Init();
+ *      SensorEvents_RegisterHandler(kSensorEvPressure, myPressureHandler);
+ *
+ *      PORT_IRQ_EnablePortDIrq();
+ *
+ * @endcode
+ *
+ * @{
+ * @brief Sensor interrupt event dispatcher
+ */
+
+#define SENSOR_EVENTS_TASK_STACK_SIZE   (1024U)
+#define SENSOR_EVENTS_TASK_PRIO         (3)
+
+/*!
+ * @brief Sensor Event Flags
+ *
+ * Event flags to be used in IRQ handlers to wake the sensor events task.
+ *
+ */
+typedef enum _sensor_events
+{
+    kSensorEvAmbLight    = (1U << 0U),    /*!< Ambient light (TSL2572) interrupt */
+    kSensorEvAirQuality  = (1U << 1U),    /*!< Air quality (CCS811) interrupt */
+    kSensorEvPressure    = (1U << 2U),    /*!< Pressure (MPL3115) INT1 or INT2 */
+    kSensorEvAccel       = (1U << 3U),    /*!< Accelerometer (FXOS8700) INT1 or INT2 */
+    kSensorEvGyro        = (1U << 4U),    /*!< Gyroscope (FXAS21002) INT1 or INT2 */
+    kSensorEvAllMask     = (0x1FU),       /*!< All sensor events mask */
+
+}sensor_events_t;
+
+/*!
+ * @brief Handler run in the sensor events task when the event of its sensor is set
+ */
+typedef void (*sensor_event_handler_t)(void);
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Function to set events, can be called from ISR or task.
+ *
+ * @param[in] events  Events to trigger in the sensor events task
+ *
+ * @return None
+ *
+ */
+void SensorEvents_SetEvent(uint32_t events);
+
+/*!
+ * @brief Registers the handler of one sensor event, or removes it if handler is NULL.
+ *        The event is set once so that data latched before registration is read out.
+ *
+ * @param[in] event    Single sensor event flag
+ * @param[in] handler  Handler to run in the sensor events task
+ *
+ * @return None
+ *
+ */
+void SensorEvents_RegisterHandler(sensor_events_t event, sensor_event_handler_t handler);
+
+/*!
+ * @brief Initialization function for creating the sensor events task and event group
+ *
+ * @return None
+ *
+ */
+void SensorEvents_Init(void);
+
+/*! @}*/
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _SENSOR_EVENTS_H_
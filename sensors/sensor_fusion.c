@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file sensor_fusion.c
+ * This is the source file for the orientation estimation
+ */
+
+#include <string.h>
+#include "sensor_fusion.h"
+#include "fsl_os_abstraction.h"
+
+/*****************************************************************************
+ * Variables
+ ****************************************************************************/
+#define FUSION_MUL(a, b)        ((int32_t)(((int64_t)(a) * (b)) >> SENSOR_FUSION_Q))
+#define FUSION_HALF             (SENSOR_FUSION_ONE / 2)
+#define FUSION_PI               (3.14159265f)
+#define FUSION_READ_CHUNK       (8U)
+#define FUSION_CORDIC_STEPS     (16U)
+
+/* atan(2^-i) in degrees, Q16 */
+static const int32_t maFusionAtanTable[FUSION_CORDIC_STEPS] =
+{
+    2949120, 1740967, 919879, 466945, 234379, 117304, 58666, 29335,
+    14668, 7334, 3667, 1833, 917, 458, 229, 115
+};
+
+static volatile bool sRunning = false;
+static motion_reader_t sReader;
+static sensor_fusion_callback_t sCallback;
+
+/* Estimate, Q28 */
+static int32_t sQuat[4];
+static int32_t sIntegral[3];    /* Half angle steps */
+static int32_t sMag[3];         /* Last normalized magnetometer reading */
+static bool sMagValid;
+static bool sAttitudeSet;       /* sQuat was set from a measurement */
+
+/* Per sample constants, Q28 */
+static int32_t sGyroStep;       /* Half angle of one gyroscope count over one period */
+static int32_t sKpStep;
+static int32_t sKiStep;
+static uint32_t sSettleEnd;     /* us */
+static bool sSettling;
+
+static uint32_t sOutputInterval;    /* us */
+static uint32_t sNextOutput;        /* us */
+static bool sOutputTimeline;
+static sensor_fusion_output_t sOutput;
+static bool sOutputValid;
+
+/*****************************************************************************
+ * Private functions
+ ****************************************************************************/
+static uint32_t SensorFusion_Sqrt(uint64_t x)
+{
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (x >= result + bit)
+        {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)result;
+}
+
+/* Square root of x in [0, 4], without pulling libm in for the attitude initialization */
+static float SensorFusion_SqrtUnit(float x)
+{
+    return (float)SensorFusion_Sqrt((uint64_t)(x * SENSOR_FUSION_ONE) << SENSOR_FUSION_Q) / SENSOR_FUSION_ONE;
+}
+
+/* Scales a raw sensor vector to unit length, Q28 */
+static bool SensorFusion_Normalize(const int16_t in[3], int32_t out[3])
+{
+    uint64_t squares = (int64_t)in[0] * in[0] + (int64_t)in[1] * in[1] + (int64_t)in[2] * in[2];
+    uint32_t norm = SensorFusion_Sqrt(squares);
+    int64_t inverse;
+
+    if (0U == norm)
+    {
+        return false;
+    }
+
+    /* One division, 2^44 / norm keeps 16 bits of headroom for the products */
+    inverse = (int64_t)(((uint64_t)1 << (SENSOR_FUSION_Q + 16)) / norm);
+    out[0] = (int32_t)((in[0] * inverse) >> 16);
+    out[1] = (int32_t)((in[1] * inverse) >> 16);
+    out[2] = (int32_t)((in[2] * inverse) >> 16);
+
+    return true;
+}
+
+/* Degrees Q16 in [-180, 180), CORDIC vectoring */
+static int32_t SensorFusion_Atan2(int32_t y, int32_t x)
+{
+    int32_t angle = 0;
+    int32_t tmp;
+    uint32_t i;
+
+    /* Bring the vector in the right half plane */
+    if (x < 0)
+    {
+        x = -x;
+        y = -y;
+        angle = 180 << 16;
+    }
+
+    for (i = 0; i < FUSION_CORDIC_STEPS; i++)
+    {
+        if (y > 0)
+        {
+            tmp = x + (y >> i);
+            y -= x >> i;
+            x = tmp;
+            angle += maFusionAtanTable[i];
+        }
+        else
+        {
+            tmp = x - (y >> i);
+            y += x >> i;
+            x = tmp;
+            angle -= maFusionAtanTable[i];
+        }
+    }
+
+    if (angle >= (180 << 16))
+    {
+        angle -= 360 << 16;
+    }
+
+    return angle;
+}
+
+/* Sets the estimate from one accelerometer and magnetometer reading, runs once in float */
+static void SensorFusion_InitAttitude(const int32_t a[3], const int32_t m[3])
+{
+    float up[3];
+    float north[3];
+    float east[3];
+    float mag[3];
+    float r[3][3];
+    float norm;
+    float s;
+    uint32_t i;
+
+    for (i = 0; i < 3; i++)
+    {
+        up[i] = (float)a[i] / SENSOR_FUSION_ONE;
+        mag[i] = (float)m[i] / SENSOR_FUSION_ONE;
+    }
+
+    /* East is horizontal and normal to the field, north completes the frame */
+    east[0] = mag[1] * up[2] - mag[2] * up[1];
+    east[1] = mag[2] * up[0] - mag[0] * up[2];
+    east[2] = mag[0] * up[1] - mag[1] * up[0];
+    norm = SensorFusion_SqrtUnit(east[0] * east[0] + east[1] * east[1] + east[2] * east[2]);
+    if (norm < 0.01f)
+    {
+        return;
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        east[i] /= norm;
+    }
+    north[0] = up[1] * east[2] - up[2] * east[1];
+    north[1] = up[2] * east[0] - up[0] * east[2];
+    north[2] = up[0] * east[1] - up[1] * east[0];
+
+    /* Board to earth rotation, rows are north, west and up in board coordinates */
+    for (i = 0; i < 3; i++)
+    {
+        r[0][i] = north[i];
+        r[1][i] = -east[i];
+        r[2][i] = up[i];
+    }
+
+    if ((r[0][0] + r[1][1] + r[2][2]) > 0.0f)
+    {
+        s = 2.0f * SensorFusion_SqrtUnit(1.0f + r[0][0] + r[1][1] + r[2][2]);
+        sQuat[0] = (int32_t)(0.25f * s * SENSOR_FUSION_ONE);
+        sQuat[1] = (int32_t)((r[2][1] - r[1][2]) / s * SENSOR_FUSION_ONE);
+        sQuat[2] = (int32_t)((r[0][2] - r[2][0]) / s * SENSOR_FUSION_ONE);
+        sQuat[3] = (int32_t)((r[1][0] - r[0][1]) / s * SENSOR_FUSION_ONE);
+    }
+    else if ((r[0][0] > r[1][1]) && (r[0][0] > r[2][2]))
+    {
+        s = 2.0f * SensorFusion_SqrtUnit(1.0f + r[0][0] - r[1][1] - r[2][2]);
+        sQuat[0] = (int32_t)((r[2][1] - r[1][2]) / s * SENSOR_FUSION_ONE);
+        sQuat[1] = (int32_t)(0.25f * s * SENSOR_FUSION_ONE);
+        sQuat[2] = (int32_t)((r[0][1] + r[1][0]) / s * SENSOR_FUSION_ONE);
+        sQuat[3] = (int32_t)((r[0][2] + r[2][0]) / s * SENSOR_FUSION_ONE);
+    }
+    else if (r[1][1] > r[2][2])
+    {
+        s = 2.0f * SensorFusion_SqrtUnit(1.0f + r[1][1] - r[0][0] - r[2][2]);
+        sQuat[0] = (int32_t)((r[0][2] - r[2][0]) / s * SENSOR_FUSION_ONE);
+        sQuat[1] = (int32_t)((r[0][1] + r[1][0]) / s * SENSOR_FUSION_ONE);
+        sQuat[2] = (int32_t)(0.25f * s * SENSOR_FUSION_ONE);
+        sQuat[3] = (int32_t)((r[1][2] + r[2][1]) / s * SENSOR_FUSION_ONE);
+    }
+    else
+    {
+        s = 2.0f * SensorFusion_SqrtUnit(1.0f + r[2][2] - r[0][0] - r[1][1]);
+        sQuat[0] = (int32_t)((r[1][0] - r[0][1]) / s * SENSOR_FUSION_ONE);
+        sQuat[1] = (int32_t)((r[0][2] + r[2][0]) / s * SENSOR_FUSION_ONE);
+        sQuat[2] = (int32_t)((r[1][2] + r[2][1]) / s * SENSOR_FUSION_ONE);
+        sQuat[3] = (int32_t)(0.25f * s * SENSOR_FUSION_ONE);
+    }
+
+    sAttitudeSet = true;
+}
+
+static void SensorFusion_Publish(uint32_t timestamp)
+{
+    sensor_fusion_output_t output;
+    int32_t yaw;
+    int32_t heading;
+
+    output.timestamp = timestamp;
+    memcpy(output.quaternion, sQuat, sizeof(output.quaternion));
+    output.magnetic = sMagValid;
+
+    /* Yaw counterclockwise from north in the north-west-up frame, heading is clockwise */
+    yaw = SensorFusion_Atan2(2 * (FUSION_MUL(sQuat[0], sQuat[3]) + FUSION_MUL(sQuat[1], sQuat[2])),
+                             SENSOR_FUSION_ONE - 2 * (FUSION_MUL(sQuat[2], sQuat[2]) + FUSION_MUL(sQuat[3], sQuat[3])));
+    heading = (int32_t)(((int64_t)-yaw * 100) >> 16);
+    if (heading < 0)
+    {
+        heading += 36000;
+    }
+    output.heading = (uint16_t)(heading % 36000);
+
+    OSA_InterruptDisable();
+    sOutput = output;
+    sOutputValid = true;
+    OSA_InterruptEnable();
+
+    if (NULL != sCallback)
+    {
+        sCallback(&output);
+    }
+}
+
+/*!
+ * @brief Motion capture batch callback, fuses the samples published by the drain
+ */
+static void SensorFusion_BatchHandler(void)
+{
+    motion_sample_t samples[FUSION_READ_CHUNK];
+    uint32_t count;
+    uint32_t i;
+
+    if (!sRunning)
+    {
+        return;
+    }
+
+    do
+    {
+        count = MotionCapture_Read(&sReader, samples, FUSION_READ_CHUNK);
+
+        for (i = 0; i < count; i++)
+        {
+            SensorFusion_Update(&samples[i]);
+        }
+    } while (FUSION_READ_CHUNK == count);
+}
+
+/*****************************************************************************
+ * Public functions
+ ****************************************************************************/
+uint8_t SensorFusion_Start(uint16_t outputRateHz, sensor_fusion_callback_t callback)
+{
+    uint32_t period = MotionCapture_GetPeriod();
+    float halfPeriod;
+
+    if ((0U == period) || (0U == outputRateHz) || (outputRateHz > (1000000U / period)))
+    {
+        return 1;
+    }
+
+    SensorFusion_Stop();
+
+    /* Constants of the per sample update, computed once */
+    halfPeriod = (float)period / 2000000.0f;
+    sGyroStep = (int32_t)(SENSOR_FUSION_GYRO_MDPS_PER_LSB / 1000.0f * FUSION_PI / 180.0f * halfPeriod * SENSOR_FUSION_ONE);
+    sKpStep = (int32_t)(SENSOR_FUSION_KP * halfPeriod * SENSOR_FUSION_ONE);
+    sKiStep = (int32_t)(SENSOR_FUSION_KI * halfPeriod * 2.0f * halfPeriod * SENSOR_FUSION_ONE);
+
+    sQuat[0] = SENSOR_FUSION_ONE;
+    sQuat[1] = 0;
+    sQuat[2] = 0;
+    sQuat[3] = 0;
+    memset(sIntegral, 0, sizeof(sIntegral));
+    sMagValid = false;
+    sAttitudeSet = false;
+    sSettling = true;
+    sOutputInterval = 1000000U / outputRateHz;
+    sOutputTimeline = false;
+    sOutputValid = false;
+    sCallback = callback;
+
+    MotionCapture_ReaderInit(&sReader);
+    sRunning = true;
+    MotionCapture_SetBatchCallback(SensorFusion_BatchHandler);
+
+    return 0;
+}
+
+void SensorFusion_Stop(void)
+{
+    MotionCapture_SetBatchCallback(NULL);
+    sRunning = false;
+}
+
+bool SensorFusion_GetOutput(sensor_fusion_output_t *output)
+{
+    bool valid;
+
+    OSA_InterruptDisable();
+    *output = sOutput;
+    valid = sOutputValid;
+    OSA_InterruptEnable();
+
+    return valid;
+}
+
+void SensorFusion_Update(const motion_sample_t *sample)
+{
+    int32_t q0 = sQuat[0], q1 = sQuat[1], q2 = sQuat[2], q3 = sQuat[3];
+    int32_t a[3];
+    int32_t halfV[3];
+    int32_t halfE[3] = {0, 0, 0};
+    int32_t step[3];
+    int32_t kpStep = sKpStep;
+    int32_t norm;
+    bool accelValid;
+    uint32_t i;
+
+    /* Read once per drain, kept for the following samples */
+    if (sample->flags & kMotionSampleMag)
+    {
+        sMagValid = SensorFusion_Normalize(sample->mag, sMag);
+    }
+
+    if (!(sample->flags & kMotionSampleGyro))
+    {
+        return;
+    }
+
+    if (!sOutputTimeline)
+    {
+        sSettleEnd = sample->timestamp + SENSOR_FUSION_SETTLE_TIME;
+        sNextOutput = sample->timestamp;
+        sOutputTimeline = true;
+    }
+
+    accelValid = (sample->flags & kMotionSampleAccel) && SensorFusion_Normalize(sample->accel, a);
+
+    /* Start from the measured attitude rather than converge from the reset one */
+    if (accelValid && sMagValid && !sAttitudeSet)
+    {
+        SensorFusion_InitAttitude(a, sMag);
+        q0 = sQuat[0];
+        q1 = sQuat[1];
+        q2 = sQuat[2];
+        q3 = sQuat[3];
+    }
+
+    if (accelValid)
+    {
+        int32_t q0q0 = FUSION_MUL(q0, q0), q0q1 = FUSION_MUL(q0, q1), q0q2 = FUSION_MUL(q0, q2);
+        int32_t q0q3 = FUSION_MUL(q0, q3), q1q1 = FUSION_MUL(q1, q1), q1q2 = FUSION_MUL(q1, q2);
+        int32_t q1q3 = FUSION_MUL(q1, q3), q2q2 = FUSION_MUL(q2, q2), q2q3 = FUSION_MUL(q2, q3);
+        int32_t q3q3 = FUSION_MUL(q3, q3);
+
+        /* Estimated gravity direction, halved */
+        halfV[0] = q1q3 - q0q2;
+        halfV[1] = q0q1 + q2q3;
+        halfV[2] = q0q0 - FUSION_HALF + q3q3;
+
+        /* Error is the cross product between the measured and the estimated directions */
+        halfE[0] = FUSION_MUL(a[1], halfV[2]) - FUSION_MUL(a[2], halfV[1]);
+        halfE[1] = FUSION_MUL(a[2], halfV[0]) - FUSION_MUL(a[0], halfV[2]);
+        halfE[2] = FUSION_MUL(a[0], halfV[1]) - FUSION_MUL(a[1], halfV[0]);
+
+        if (sMagValid)
+        {
+            const int32_t *m = sMag;
+            int32_t h[2];
+            int32_t bx;
+            int32_t bz;
+            int32_t halfW[3];
+
+            /* Earth field in the horizontal plane points north */
+            h[0] = 2 * (FUSION_MUL(m[0], FUSION_HALF - q2q2 - q3q3) + FUSION_MUL(m[1], q1q2 - q0q3) +
+                        FUSION_MUL(m[2], q1q3 + q0q2));
+            h[1] = 2 * (FUSION_MUL(m[0], q1q2 + q0q3) + FUSION_MUL(m[1], FUSION_HALF - q1q1 - q3q3) +
+                        FUSION_MUL(m[2], q2q3 - q0q1));
+            bx = (int32_t)SensorFusion_Sqrt((uint64_t)((int64_t)FUSION_MUL(h[0], h[0]) + FUSION_MUL(h[1], h[1]))
+                                            << SENSOR_FUSION_Q);
+            bz = 2 * (FUSION_MUL(m[0], q1q3 - q0q2) + FUSION_MUL(m[1], q2q3 + q0q1) +
+                      FUSION_MUL(m[2], FUSION_HALF - q1q1 - q2q2));
+
+            /* Estimated magnetic field direction, halved */
+            halfW[0] = FUSION_MUL(bx, FUSION_HALF - q2q2 - q3q3) + FUSION_MUL(bz, q1q3 - q0q2);
+            halfW[1] = FUSION_MUL(bx, q1q2 - q0q3) + FUSION_MUL(bz, q0q1 + q2q3);
+            halfW[2] = FUSION_MUL(bx, q0q2 + q1q3) + FUSION_MUL(bz, FUSION_HALF - q1q1 - q2q2);
+
+            halfE[0] += FUSION_MUL(m[1], halfW[2]) - FUSION_MUL(m[2], halfW[1]);
+            halfE[1] += FUSION_MUL(m[2], halfW[0]) - FUSION_MUL(m[0], halfW[2]);
+            halfE[2] += FUSION_MUL(m[0], halfW[1]) - FUSION_MUL(m[1], halfW[0]);
+        }
+    }
+
+    /* Converge quickly from the reset attitude */
+    if (sSettling)
+    {
+        if ((int32_t)(sample->timestamp - sSettleEnd) < 0)
+        {
+            kpStep *= 10;
+        }
+        else
+        {
+            sSettling = false;
+        }
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        if (0 != sKiStep)
+        {
+            sIntegral[i] += FUSION_MUL(halfE[i], sKiStep);
+        }
+        step[i] = sample->gyro[i] * sGyroStep + FUSION_MUL(halfE[i], kpStep) + sIntegral[i];
+    }
+
+    /* Integrate the rate of change of the quaternion */
+    sQuat[0] = q0 + (-FUSION_MUL(q1, step[0]) - FUSION_MUL(q2, step[1]) - FUSION_MUL(q3, step[2]));
+    sQuat[1] = q1 + (FUSION_MUL(q0, step[0]) + FUSION_MUL(q2, step[2]) - FUSION_MUL(q3, step[1]));
+    sQuat[2] = q2 + (FUSION_MUL(q0, step[1]) - FUSION_MUL(q1, step[2]) + FUSION_MUL(q3, step[0]));
+    sQuat[3] = q3 + (FUSION_MUL(q0, step[2]) + FUSION_MUL(q1, step[1]) - FUSION_MUL(q2, step[0]));
+
+    /* The norm drifts by a tiny amount per step, one Newton step of 1/sqrt around 1 is enough */
+    norm = FUSION_MUL(sQuat[0], sQuat[0]) + FUSION_MUL(sQuat[1], sQuat[1]) +
+           FUSION_MUL(sQuat[2], sQuat[2]) + FUSION_MUL(sQuat[3], sQuat[3]);
+    norm = (3 * FUSION_HALF) - (norm / 2);
+
+    for (i = 0; i < 4; i++)
+    {
+        sQuat[i] = FUSION_MUL(sQuat[i], norm);
+    }
+
+    if ((int32_t)(sample->timestamp - sNextOutput) >= 0)
+    {
+        sNextOutput += sOutputInterval;
+
+        /* Do not replay missed publications after a gap */
+        if ((int32_t)(sample->timestamp - sNextOutput) >= 0)
+        {
+            sNextOutput = sample->timestamp + sOutputInterval;
+        }
+
+        SensorFusion_Publish(sample->timestamp);
+    }
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2018 NXP
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*!
+ * @file sensor_fusion.h
+ * This is the header file for the orientation estimation
+ */
+
+#ifndef _SENSOR_FUSION_H_
+#define _SENSOR_FUSION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "motion_capture.h"
+
+/*!
+ * @addtogroup sensor_fusion Sensor Fusion
+ *
+ * The sensor_fusion module estimates the board orientation from the motion capture stream with a
+ * Mahony complementary filter in Q28 fixed-point.
+ *
+ * The gyroscope is integrated at the capture rate. The accelerometer and the last magnetometer
+ * reading pull the estimate towards gravity and magnetic north through a proportional-integral
+ * feedback. The filter runs batch by batch from the sensor events task and publishes the
+ * quaternion and the heading at a fixed output rate, a few bytes instead of the 9-axis stream.
+ *
+ * The FXOS8700 and FXAS21002 axes are assumed to be aligned, as on the NXP reference designs.
+ *
+ * Usage
+ * -------------------------------------------------------------------------------------------------
+ *
+ * @code
+ *
+ *      void myOrientationHandler(const sensor_fusion_output_t *output)
+ *      {
+ *          // Runs in the sensor events task, at the output rate
+ *          ...
+ *      }
+ *
+ *      SensorEvents_Init();
+ *      MotionCapture_Start(200, 20);
+ *      SensorFusion_Start(10, myOrientationHandler);
+ *
+ * @endcode
+ *
+ * @{
+ * @brief Fixed-point AHRS
+ */
+
+#define SENSOR_FUSION_Q                 (28)                            /*!< Fraction bits */
+#define SENSOR_FUSION_ONE               ((int32_t)1 << SENSOR_FUSION_Q) /*!< 1.0 */
+
+#ifndef SENSOR_FUSION_KP
+#define SENSOR_FUSION_KP                (1.0f)      /*!< Proportional gain (2 * Kp in Mahony's paper), 1/s */
+#endif
+
+#ifndef SENSOR_FUSION_KI
+#define SENSOR_FUSION_KI                (0.0f)      /*!< Integral gain (2 * Ki), 1/s^2, tracks the gyroscope bias */
+#endif
+
+#ifndef SENSOR_FUSION_GYRO_MDPS_PER_LSB
+#define SENSOR_FUSION_GYRO_MDPS_PER_LSB (62.5f)     /*!< FXAS21002 sensitivity at the reset range, 2000 dps */
+#endif
+
+#ifndef SENSOR_FUSION_SETTLE_TIME
+#define SENSOR_FUSION_SETTLE_TIME       (1000000U)  /*!< us of high gain after the start */
+#endif
+
+/*!
+ * @brief Orientation estimate
+ */
+typedef struct _sensor_fusion_output
+{
+    uint32_t timestamp;         /*!< us, timestamp of the last fused sample */
+    int32_t quaternion[4];      /*!< w, x, y, z of the board to earth rotation, Q28 */
+    uint16_t heading;           /*!< Centidegrees clockwise from magnetic north, 0 to 35999 */
+    bool magnetic;              /*!< The magnetometer contributed, heading is absolute */
+} sensor_fusion_output_t;
+
+/*!
+ * @brief Callback run in the sensor events task at the output rate
+ */
+typedef void (*sensor_fusion_callback_t)(const sensor_fusion_output_t *output);
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*!
+ * @brief Resets the estimate and starts fusing the running motion capture
+ *
+ * @param[in] outputRateHz  Publication rate, 1 up to the capture rate
+ * @param[in] callback      Run at each publication, or NULL to poll SensorFusion_GetOutput
+ *
+ * @return 0 on success, 1 if the capture is not running or the rate is invalid
+ *
+ */
+uint8_t SensorFusion_Start(uint16_t outputRateHz, sensor_fusion_callback_t callback);
+
+/*!
+ * @brief Stops fusing, the capture keeps running
+ *
+ * @return None
+ *
+ */
+void SensorFusion_Stop(void);
+
+/*!
+ * @brief Copies the last published estimate
+ *
+ * @param[out] output  Destination
+ *
+ * @return false if nothing was published since the start
+ *
+ */
+bool SensorFusion_GetOutput(sensor_fusion_output_t *output);
+
+/*!
+ * @brief Runs one filter step. Called for each captured sample after SensorFusion_Start,
+ *        exposed to replay recorded datasets and to benchmark the update.
+ *
+ * @param[in] sample  Sample with at least a gyroscope vector
+ *
+ * @return None
+ *
+ */
+void SensorFusion_Update(const motion_sample_t *sample);
+
+/*! @}*/
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif // _SENSOR_FUSION_H_
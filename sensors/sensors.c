@@ -5,6 +5,14 @@
 #include "fsl_port.h"
 #include "FunctionLib.h"
 #include "shell.h"
+#include "sensor_conditioning.h"
+#include "air_baseline.h"
+#if defined(FSL_RTOS_FREE_RTOS)
+#include "fsl_os_abstraction.h"
+#include "sensor_events.h"
+#include "motion_capture.h"
+#include "sensor_fusion.h"
+#endif
 
 /* CMSIS Includes */
 #include "Driver_I2C.h"
@@ -17,6 +25,10 @@
 i2c_master_handle_t g_mi2c_handle;
 volatile bool completionFlag = false;
 volatile bool nakFlag = false;
+#if defined(FSL_RTOS_FREE_RTOS)
+/* I2C1 is shared by the sensor events task, the timers task and the UI */
+static osaMutexId_t sI2C1Mutex;
+#endif
 
 /* I2C2 variables */
 i2c_master_handle_t g_mi2c2_handle;
@@ -42,6 +54,14 @@ fxas21002_i2c_sensorhandle_t FXAS21002drv;
 
 float g_dataScale = 0;
 
+/* Last values read by the sensor event handlers */
+static volatile float sAmbLight;
+static volatile bool sAmbLightValid = false;
+static volatile int32_t sPressure;
+static volatile bool sPressureValid = false;
+static air_quality_data_t sAirQuality;
+static volatile bool sAirQualityValid = false;
+
 /*******************************************************************************
  * Constants
  ******************************************************************************/
@@ -80,6 +100,18 @@ extern void i2c1_master_callback(I2C_Type *base, i2c_master_handle_t *handle, st
 uint8_t I2C1_init(void){
     int32_t status;
     ARM_DRIVER_I2C *I2Cdrv = &I2C_S1_DRIVER; // or I2C_S_SIGNAL_EVENT?
+
+#if defined(FSL_RTOS_FREE_RTOS)
+    if (NULL == sI2C1Mutex)
+    {
+        sI2C1Mutex = OSA_MutexCreate();
+        if (NULL == sI2C1Mutex) {
+            shell_printf("Error while creating I2C1 mutex!\r\n");
+            return 1;
+        }
+    }
+#endif
+
     status = I2Cdrv->Initialize(I2C_S1_SIGNAL_EVENT);
 
     /* Initialize the I2C driver */
@@ -107,6 +139,50 @@ uint8_t I2C1_init(void){
     return 0;
 }
 
+/*****************************************************/
+/* I2C1 bus locking                                  */
+/*****************************************************/
+static void I2C1_Lock(void)
+{
+#if defined(FSL_RTOS_FREE_RTOS)
+    if (NULL != sI2C1Mutex) {
+        (void)OSA_MutexLock(sI2C1Mutex, osaWaitForever_c);
+    }
+#endif
+}
+
+static void I2C1_Unlock(void)
+{
+#if defined(FSL_RTOS_FREE_RTOS)
+    if (NULL != sI2C1Mutex) {
+        (void)OSA_MutexUnlock(sI2C1Mutex);
+    }
+#endif
+}
+
+/* Waits for the transfer started under the lock, then releases the bus */
+static uint8_t I2C1_WaitTransfer(void)
+{
+    uint8_t result;
+
+    /*  wait for transfer completed. */
+    while ((!nakFlag) && (!completionFlag)) {
+    }
+
+    nakFlag = false;
+
+    if (completionFlag == true) {
+        completionFlag = false;
+        result = I2C_RESULT_OK;
+    }
+    else {
+        result = I2C_RESULT_FAIL;
+    }
+
+    I2C1_Unlock();
+    return result;
+}
+
 /*****************************************************/
 /* Low level I2C1_Write function                     */
 /*****************************************************/
@@ -123,25 +199,16 @@ uint8_t App_I2C1_Write(uint8_t device_addr, uint8_t *writeBuf, uint32_t writeSiz
     masterXfer.dataSize = writeSize;
     masterXfer.flags = kI2C_TransferDefaultFlag;
 
+    I2C1_Lock();
+
     I2C_MasterTransferCreateHandle(BOARD_SENSORS_I2C_BASEADDR, &g_mi2c_handle, i2c1_master_callback, NULL);
 
     if (kStatus_Success != I2C_MasterTransferNonBlocking(BOARD_SENSORS_I2C_BASEADDR, &g_mi2c_handle, &masterXfer)) {
+        I2C1_Unlock();
         return I2C_RESULT_FAIL;
     }
 
-    /*  wait for transfer completed. */
-    while ((!nakFlag) && (!completionFlag)) {
-    }
-
-    nakFlag = false;
-
-    if (completionFlag == true) {
-        completionFlag = false;
-        return I2C_RESULT_OK;
-    }
-    else {
-        return I2C_RESULT_FAIL;
-    }
+    return I2C1_WaitTransfer();
 }
 
 /*****************************************************/
@@ -159,23 +226,16 @@ uint8_t App_I2C1_Read(uint8_t device_addr, uint8_t *writeBuf, uint32_t writeSize
     masterXfer.dataSize = readSize;
     masterXfer.flags = kI2C_TransferDefaultFlag;
 
-    I2C_MasterTransferCreateHandle(BOARD_SENSORS_I2C_BASEADDR, &g_mi2c_handle, i2c1_master_callback, NULL);
-
-    I2C_MasterTransferNonBlocking(BOARD_SENSORS_I2C_BASEADDR, &g_mi2c_handle, &masterXfer);
+    I2C1_Lock();
 
-    /*  wait for transfer completed. */
-    while ((!nakFlag) && (!completionFlag)) {
-    }
-
-    nakFlag = false;
+    I2C_MasterTransferCreateHandle(BOARD_SENSORS_I2C_BASEADDR, &g_mi2c_handle, i2c1_master_callback, NULL);
 
-    if (completionFlag == true) {
-        completionFlag = false;
-        return I2C_RESULT_OK;
-    }
-    else {
+    if (kStatus_Success != I2C_MasterTransferNonBlocking(BOARD_SENSORS_I2C_BASEADDR, &g_mi2c_handle, &masterXfer)) {
+        I2C1_Unlock();
         return I2C_RESULT_FAIL;
     }
+
+    return I2C1_WaitTransfer();
 }
 
 /*****************************************************/
@@ -293,12 +353,75 @@ uint8_t App_I2C2_Read(uint8_t device_addr, uint8_t *writeBuf, uint32_t writeSize
     }
 }
 
+#if defined(FSL_RTOS_FREE_RTOS)
+/*****************************************************/
+/* Sensor event handlers, run in the events task     */
+/*****************************************************/
+static void ambient_light_event_handler(void)
+{
+    float fAmbLight;
+
+    if (TSL2572_ReadAmbientLight(&fAmbLight) == 0)
+    {
+        sAmbLight = fAmbLight;
+        sAmbLightValid = true;
+    }
+
+    /* Release the interrupt line for the next ALS cycle */
+    (void)TSL2572_ClearALSInterrupt();
+}
+
+static void air_quality_event_handler(void)
+{
+    CCS811_result_t result;
+    uint32_t timestamp = OSA_TimeGetMsec();
+
+    /* One transfer for the results, status and error: this also releases AIR_INTN */
+    if (CCS811_readAlgorithmResultBlock(&result) == CCS811_SUCCESS)
+    {
+        /* DATA_READY is clear if nothing new was measured, e.g. on the read done at registration */
+        if (result.status & (1 << 3))
+        {
+            OSA_InterruptDisable();
+            sAirQuality.eCO2 = result.eCO2;
+            sAirQuality.TVOC = result.TVOC;
+            sAirQuality.status = result.status;
+            sAirQuality.errorId = result.errorId;
+            sAirQuality.timestamp = timestamp;
+            sAirQualityValid = true;
+            OSA_InterruptEnable();
+        }
+    }
+}
+
+static void pressure_event_handler(void)
+{
+    int32_t data;
+    bool ready;
+
+    if ((MPL_ReadReadyData(&data, &ready) == MPL_SUCCESS) && ready)
+    {
+        sPressure = data / 400; // in HPa (LSB = 0.25Pa)
+        sPressureValid = true;
+    }
+}
+#endif
+
 uint8_t get_ambient_light(uint8_t *buf, uint8_t *size)
 {
     float fAmbLight;
 
     if(buf != NULL && size != NULL && *size > 3)
     {
+        if (sAmbLightValid)
+        {
+            /* Kept up to date by the ambient light interrupt */
+            fAmbLight = sAmbLight;
+            FLib_MemCpy(buf, &fAmbLight, 4);
+            *size = 4;
+            return 0;
+        }
+
         if (TSL2572_ReadAmbientLight(&fAmbLight) == 0)
         {
             FLib_MemCpy(buf, &fAmbLight, 4);
@@ -325,6 +448,15 @@ uint8_t get_air_quality(uint8_t *buf, uint8_t *size)
 
     if (buf == NULL || size == NULL || *size <= 1) return 1;
 
+    if (sAirQualityValid)
+    {
+        /* Kept up to date by the air quality interrupt */
+        uCO2 = sAirQuality.eCO2;
+        FLib_MemCpy(buf, &uCO2, 2);
+        *size = 2;
+        return 0;
+    }
+
     if (CCS811_dataAvailable(&avail) != CCS811_SUCCESS) return 1;
     if (avail == 1)
     {
@@ -338,12 +470,34 @@ uint8_t get_air_quality(uint8_t *buf, uint8_t *size)
     return 0;
 }
 
+uint8_t get_air_quality_data(air_quality_data_t *data)
+{
+    if ((data == NULL) || !sAirQualityValid) return 1;
+
+#if defined(FSL_RTOS_FREE_RTOS)
+    OSA_InterruptDisable();
+    *data = sAirQuality;
+    OSA_InterruptEnable();
+#endif
+
+    return 0;
+}
+
 uint8_t get_pressure(uint8_t *buf, uint8_t *size)
 {
     int32_t data;
 
     if(buf != NULL && size != NULL && *size > 3)
     {
+        if (sPressureValid) {
+            /* Kept up to date by the pressure data ready interrupt */
+            data = sPressure;
+            FLib_MemCpy(buf, &data, 4);
+            *size = 4;
+
+            return 0;
+        }
+
         if (MPL_ReadRawData (MPL_MODE_PRESSURE, &data) == 0) {
             data /= 400; // in HPa (LSB = 0.25Pa)
 
@@ -363,14 +517,17 @@ uint8_t get_pressure(uint8_t *buf, uint8_t *size)
 uint8_t get_temperature(uint8_t *buf, uint8_t *size)
 {
     ens210_meas_data_t ens210_data;
-    uint8_t TempOffsetCelcius = 7;
 
     if(buf != NULL && size != NULL && *size > 3)
     {
         if(ENS210_Measure(mode_Tonly, &ens210_data) == 0)
         {
             float temp = ens210_data.T_mCelsius / 1000.0;
-            temp -= TempOffsetCelcius;
+#if defined(FSL_RTOS_FREE_RTOS)
+            temp = SensorConditioning_CompensateTemperature(temp, OSA_TimeGetMsec());
+#else
+            temp = SensorConditioning_CompensateTemperature(temp, UINT32_MAX);
+#endif
             FLib_MemCpy(buf, &temp, 4);
             *size = 4;
 
@@ -408,8 +565,33 @@ uint8_t get_humidity(uint8_t *buf, uint8_t *size)
 
 uint8_t get_acceleration(uint8_t *buf, uint8_t *size)
 {
+#if defined(FSL_RTOS_FREE_RTOS)
+    motion_sample_t sample;
+#endif
+
     if(buf != NULL && size != NULL && *size > 11)
     {
+#if defined(FSL_RTOS_FREE_RTOS)
+        /* Reading the output registers would pop the capture FIFO */
+        if (MotionCapture_IsRunning())
+        {
+            float accel[3];
+
+            if (!MotionCapture_GetLatest(&sample) || !(sample.flags & kMotionSampleAccel))
+            {
+                return kStatus_Fail;
+            }
+
+            accel[0] = sample.accel[0] * g_dataScale;
+            accel[1] = sample.accel[1] * g_dataScale;
+            accel[2] = sample.accel[2] * g_dataScale;
+            FLib_MemCpy(buf, accel, 12);
+
+            *size = 12;
+            return kStatus_Success;
+        }
+#endif
+
         if (FXOS8700_ReadSensorData(&g_fxosHandle, &fxos8700_data) == kStatus_Success)
         {
             float accel[3]= {0};
@@ -441,8 +623,33 @@ uint8_t get_acceleration(uint8_t *buf, uint8_t *size)
 
 uint8_t get_magnetic_field(uint8_t *buf, uint8_t *size)
 {
+#if defined(FSL_RTOS_FREE_RTOS)
+    motion_sample_t sample;
+#endif
+
     if(buf != NULL && size != NULL && *size > 11)
     {
+#if defined(FSL_RTOS_FREE_RTOS)
+        /* The capture reads the magnetometer at every accelerometer FIFO drain */
+        if (MotionCapture_IsRunning())
+        {
+            float mag[3];
+
+            if (!MotionCapture_GetLatest(&sample) || !(sample.flags & kMotionSampleMag))
+            {
+                return kStatus_Fail;
+            }
+
+            mag[0] = sample.mag[0] * 0.1;
+            mag[1] = sample.mag[1] * 0.1;
+            mag[2] = sample.mag[2] * 0.1;
+            FLib_MemCpy(buf, mag, 12);
+
+            *size = 12;
+            return kStatus_Success;
+        }
+#endif
+
         if (FXOS8700_ReadSensorData(&g_fxosHandle, &fxos8700_data) == kStatus_Success)
         {
             float mag[3]={0, 0, 0};
@@ -469,10 +676,29 @@ uint8_t get_rotation_speed(uint8_t *buf, uint8_t *size)
 {
     int32_t status;
     uint8_t data[FXAS21002_GYRO_DATA_SIZE];
+#if defined(FSL_RTOS_FREE_RTOS)
+    motion_sample_t sample;
+#endif
 
     if(buf != NULL && size != NULL && *size > 5)
     {
         int16_t rotspeed[3] = {10, 15, -2000};
+
+#if defined(FSL_RTOS_FREE_RTOS)
+        /* Reading the output registers would pop the capture FIFO */
+        if (MotionCapture_IsRunning())
+        {
+            if (!MotionCapture_GetLatest(&sample) || !(sample.flags & kMotionSampleGyro))
+            {
+                return 1;
+            }
+
+            FLib_MemCpy(buf, sample.gyro, 6);
+            *size = 6;
+
+            return 0;
+        }
+#endif
         /* Read the raw sensor data from the FXAS21002 */
         status = FXAS21002_I2C_ReadData(&FXAS21002drv, fxas21002_Output_Values, data);
         if (ARM_DRIVER_OK != status) return 1;
@@ -491,6 +717,37 @@ uint8_t get_rotation_speed(uint8_t *buf, uint8_t *size)
     return 1;
 }
 
+uint8_t get_orientation(uint8_t *buf, uint8_t *size)
+{
+#if defined(FSL_RTOS_FREE_RTOS)
+    sensor_fusion_output_t output;
+
+    if(buf != NULL && size != NULL && *size > 19)
+    {
+        float orientation[5];
+
+        if (!SensorFusion_GetOutput(&output))
+        {
+            return 1;
+        }
+
+        /* Quaternion w, x, y, z then heading in degrees */
+        orientation[0] = (float)output.quaternion[0] / SENSOR_FUSION_ONE;
+        orientation[1] = (float)output.quaternion[1] / SENSOR_FUSION_ONE;
+        orientation[2] = (float)output.quaternion[2] / SENSOR_FUSION_ONE;
+        orientation[3] = (float)output.quaternion[3] / SENSOR_FUSION_ONE;
+        orientation[4] = output.heading / 100.0;
+
+        FLib_MemCpy(buf, orientation, 20);
+        *size = 20;
+
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+
 bool motion_detected(void)
 {
     /*This motion detected is using the FXOS8700CQ embedded transient detection function which is similar to motion detection function
@@ -747,6 +1004,8 @@ uint8_t DeInit_pressure(void)
 
 uint8_t Init_air_quality(void)
 {
+    uint16_t baseline;
+
     /* Init air quality sensor */
     CCS811_sensor.connect_hw = CCS811_Connect;
     CCS811_sensor.disconnect_hw = CCS811_Disconnect;
@@ -760,6 +1019,12 @@ uint8_t Init_air_quality(void)
     {
         return 1;
     }
+
+    /* Skip the burn-in by restoring the last checkpointed baseline */
+    if (AirBaseline_Restore(&baseline))
+    {
+        (void)CCS811_setBaseline(baseline);
+    }
     return 0;
 }
 
@@ -911,6 +1176,47 @@ uint8_t Init_authentication(void)
     return ret;
 }
 
+uint8_t Init_sensor_events(void)
+{
+    uint8_t ret = 0;
+
+#if defined(FSL_RTOS_FREE_RTOS)
+    SensorEvents_Init();
+
+    /* Ambient light: interrupt at the end of every ALS cycle */
+    if (TSL2572_SetALSPersistence(0) != 0)
+    {
+        ret = 1;
+    }
+    else
+    {
+        SensorEvents_RegisterHandler(kSensorEvAmbLight, ambient_light_event_handler);
+    }
+
+    /* Air quality: nINT asserted when a new result is ready, every second in drive mode 1 */
+    if (CCS811_setInterrupts(1) != CCS811_SUCCESS)
+    {
+        ret = 1;
+    }
+    else
+    {
+        SensorEvents_RegisterHandler(kSensorEvAirQuality, air_quality_event_handler);
+    }
+
+    /* Pressure: data ready interrupt at every auto acquisition step, on INT1 */
+    if (MPL_SetDataReadyInterrupt(FIFO_INT1) != MPL_SUCCESS)
+    {
+        ret = 1;
+    }
+    else
+    {
+        SensorEvents_RegisterHandler(kSensorEvPressure, pressure_event_handler);
+    }
+#endif
+
+    return ret;
+}
+
 uint8_t Init_all_sensors(void)
 {
     uint8_t ret = 0;
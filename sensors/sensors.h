@@ -34,6 +34,16 @@
 #define SECURITY_I2C_BAUDRATE            100000U
 
 
+/* Air quality sample, as read on the CCS811 data ready interrupt */
+typedef struct _air_quality_data_t
+{
+    uint16_t eCO2;          /* ppm */
+    uint16_t TVOC;          /* ppb */
+    uint8_t status;         /* CCS811 STATUS register */
+    uint8_t errorId;        /* CCS811 ERROR_ID register */
+    uint32_t timestamp;     /* ms, OSA_TimeGetMsec() when read */
+} air_quality_data_t;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -47,12 +57,14 @@ uint8_t App_I2C2_Read(uint8_t device_addr, uint8_t *writeBuf, uint32_t writeSize
 
 uint8_t get_ambient_light(uint8_t *buf, uint8_t *size);
 uint8_t get_air_quality(uint8_t *buf, uint8_t *size);
+uint8_t get_air_quality_data(air_quality_data_t *data);
 uint8_t get_pressure(uint8_t *buf, uint8_t *size);
 uint8_t get_temperature(uint8_t *buf, uint8_t *size);
 uint8_t get_humidity(uint8_t *buf, uint8_t *size);
 uint8_t get_acceleration(uint8_t *buf, uint8_t *size);
 uint8_t get_magnetic_field(uint8_t *buf, uint8_t *size);
 uint8_t get_rotation_speed(uint8_t *buf, uint8_t *size);
+uint8_t get_orientation(uint8_t *buf, uint8_t *size);
 
 /* Authentication */
 uint8_t get_auth_uid(uint8_t *buf);
@@ -64,6 +76,7 @@ uint8_t set_auth_softreset(void);
 uint8_t Init_touchpad(void);
 
 uint8_t Init_all_sensors(void);
+uint8_t Init_sensor_events(void);
 uint8_t Init_ambient_light(void);
 uint8_t Init_air_quality(void);
 uint8_t Init_pressure(void);
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file air_baseline_test.c
+ * Host test for the CCS811 baseline log. The module source is built in with a simulated
+ * external flash (program only clears bits) which counts the accesses, so the test can check
+ * that the sampling side never reaches the flash.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../air_baseline.c"
+
+/*****************************************************************************
+ * Stubs
+ ****************************************************************************/
+static uint8_t sFlash[FLASH_SECTOR_SIZE];
+static uint32_t sAccesses;
+static uint32_t sErases;
+static unsigned int sSensorBaseline;
+static int sBusOwned;
+static status_t sWriteStatus;
+
+status_t SPI_Flash_Read(uint32_t offset, uint32_t data_len, void *data)
+{
+    if (!sBusOwned || (offset < AIR_BASELINE_FLASH_ADDR) ||
+        (offset + data_len > AIR_BASELINE_FLASH_ADDR + FLASH_SECTOR_SIZE))
+    {
+        abort();
+    }
+    memcpy(data, &sFlash[offset - AIR_BASELINE_FLASH_ADDR], data_len);
+    sAccesses++;
+    return kStatus_Success;
+}
+
+status_t SPI_Flash_Write(uint32_t offset, uint32_t len, void *buf)
+{
+    uint32_t i;
+
+    if (!sBusOwned || (offset < AIR_BASELINE_FLASH_ADDR) ||
+        (offset + len > AIR_BASELINE_FLASH_ADDR + FLASH_SECTOR_SIZE))
+    {
+        abort();
+    }
+    /* A failed write programs half of the record */
+    if (sWriteStatus != kStatus_Success)
+    {
+        len /= 2;
+    }
+    for (i = 0; i < len; i++)
+    {
+        sFlash[offset - AIR_BASELINE_FLASH_ADDR + i] &= ((uint8_t *)buf)[i];
+    }
+    sAccesses++;
+    return sWriteStatus;
+}
+
+status_t SPI_Flash_Erase_Block(uint32_t offset, uint32_t blkSize)
+{
+    if (!sBusOwned || (offset != AIR_BASELINE_FLASH_ADDR) || (blkSize != FLASH_SECTOR_SIZE))
+    {
+        abort();
+    }
+    memset(sFlash, 0xFF, sizeof(sFlash));
+    sAccesses++;
+    sErases++;
+    return kStatus_Success;
+}
+
+status_t SPI_Bus_Share_Acquire(spi_bus_client_t client, uint8_t priority, uint32_t deadlineMs)
+{
+    (void)client;
+    (void)priority;
+    (void)deadlineMs;
+    sBusOwned = 1;
+    return kStatus_Success;
+}
+
+status_t SPI_Bus_Share_Release(void)
+{
+    sBusOwned = 0;
+    return kStatus_Success;
+}
+
+int32_t img_program_ext_init(void)
+{
+    return IMG_EXT_NO_ERROR;
+}
+
+CCS811_status CCS811_getBaseline(unsigned int *baseline)
+{
+    *baseline = sSensorBaseline;
+    return CCS811_SUCCESS;
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+#define HOUR        (60U * 60U * 1000U)
+
+/* Simulates a power cycle: the module state is lost, the flash is kept */
+static bool Reboot(uint16_t *baseline)
+{
+    sLogReady = false;
+    sNextSlot = 0;
+    sStored = 0;
+    sLastCheckpoint = 0;
+    sPendingRecord = 0;
+    return AirBaseline_Restore(baseline);
+}
+
+static uint32_t Record(uint32_t slot)
+{
+    uint32_t record;
+
+    memcpy(&record, &sFlash[slot * sizeof(record)], sizeof(record));
+    return record;
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* The sampling side only reads the sensor, the idle loop writes */
+static void TestDeferredCheckpoint(void)
+{
+    uint16_t baseline = 0;
+    uint32_t accesses;
+
+    memset(sFlash, 0xFF, sizeof(sFlash));
+    CHECK(!Reboot(&baseline));
+
+    /* Nothing before the warm-up */
+    sSensorBaseline = 0x1234;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP - 1U);
+    AirBaseline_Idle();
+    CHECK(0xFFFFFFFFU == Record(0));
+
+    accesses = sAccesses;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP);
+    CHECK(accesses == sAccesses);
+    AirBaseline_Idle();
+    CHECK(accesses + 1U == sAccesses);
+    CHECK(0xEDCB1234U == Record(0));
+
+    /* Once per checkpoint interval, and only if it changed */
+    sSensorBaseline = 0x2345;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP + HOUR - 1U);
+    AirBaseline_Idle();
+    CHECK(0xFFFFFFFFU == Record(1));
+    sSensorBaseline = 0x1234;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP + HOUR);
+    AirBaseline_Idle();
+    CHECK(0xFFFFFFFFU == Record(1));
+    sSensorBaseline = 0x2345;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP + 2U * HOUR);
+    AirBaseline_Idle();
+    CHECK(0xDCBA2345U == Record(1));
+
+    CHECK(Reboot(&baseline));
+    CHECK(0x2345 == baseline);
+    CHECK(2 == sNextSlot);
+}
+
+/* Without a restore there is no log to append to */
+static void TestNotRestored(void)
+{
+    memset(sFlash, 0xFF, sizeof(sFlash));
+    sLogReady = false;
+    sSensorBaseline = 0x1111;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP + 10U * HOUR);
+    AirBaseline_Idle();
+    CHECK(0xFFFFFFFFU == Record(0));
+}
+
+/* A torn record is skipped and its slot is never programmed again */
+static void TestTornRecord(void)
+{
+    uint16_t baseline = 0;
+
+    memset(sFlash, 0xFF, sizeof(sFlash));
+    CHECK(!Reboot(&baseline));
+
+    sSensorBaseline = 0x0F0F;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP);
+    AirBaseline_Idle();
+
+    sWriteStatus = 1;
+    sSensorBaseline = 0x7777;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP + HOUR);
+    AirBaseline_Idle();
+    sWriteStatus = kStatus_Success;
+    CHECK(0xFFFF7777U == Record(1));
+
+    sSensorBaseline = 0x6666;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP + 2U * HOUR);
+    AirBaseline_Idle();
+    CHECK(0x99996666U == Record(2));
+
+    CHECK(Reboot(&baseline));
+    CHECK(0x6666 == baseline);
+    CHECK(3 == sNextSlot);
+
+    /* The torn record alone gives no baseline */
+    memset(sFlash, 0xFF, sizeof(sFlash));
+    sFlash[0] = 0x77;
+    sFlash[1] = 0x77;
+    CHECK(!Reboot(&baseline));
+    CHECK(1 == sNextSlot);
+}
+
+/* A full sector is erased by the write that follows */
+static void TestFullSector(void)
+{
+    uint16_t baseline = 0;
+    uint32_t slot;
+    uint32_t erases;
+
+    for (slot = 0; slot < AIR_BASELINE_SLOTS; slot++)
+    {
+        uint32_t record = (slot & 0xFFFFU) | ((uint32_t)(uint16_t)~slot << 16);
+
+        memcpy(&sFlash[slot * sizeof(record)], &record, sizeof(record));
+    }
+    CHECK(Reboot(&baseline));
+    CHECK(AIR_BASELINE_SLOTS - 1U == baseline);
+    CHECK(AIR_BASELINE_SLOTS == sNextSlot);
+
+    erases = sErases;
+    sSensorBaseline = 0xABCD;
+    AirBaseline_Checkpoint(AIR_BASELINE_WARM_UP);
+    CHECK(erases == sErases);
+    AirBaseline_Idle();
+    CHECK(erases + 1U == sErases);
+    CHECK(0x5432ABCDU == Record(0));
+    CHECK(0xFFFFFFFFU == Record(1));
+
+    CHECK(Reboot(&baseline));
+    CHECK(0xABCD == baseline);
+}
+
+int main(void)
+{
+    TestDeferredCheckpoint();
+    TestNotRestored();
+    TestTornRecord();
+    TestFullSector();
+
+    printf("air_baseline: all tests passed\n");
+    return 0;
+}
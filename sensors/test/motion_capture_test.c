@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file motion_capture_test.c
+ * Host test for the accelerometer and gyroscope FIFO capture. The module source is built in
+ * with a simulated register map of both sensors behind App_I2C1_Read/Write, so the FIFO
+ * configuration, the drain handlers, the pairing and the ring readers run unchanged.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../motion_capture.c"
+
+/*****************************************************************************
+ * Stubs
+ ****************************************************************************/
+#define ACCEL   0
+#define GYRO    1
+
+static uint8_t sRegs[2][256];
+static uint8_t sFifo[2][MOTION_CAPTURE_FIFO_DEPTH * MOTION_AXIS_DATA_SIZE];
+static uint64_t sNow;
+static sensor_event_handler_t sHandlers[2];
+static uint32_t sBatches;
+
+static int Device(uint8_t address)
+{
+    if (FXOS8700_I2C_SLAVE_ADDRESS == address)
+    {
+        return ACCEL;
+    }
+    if (FXAS21002_I2C_SLAVE_ADDRESS == address)
+    {
+        return GYRO;
+    }
+    abort();
+}
+
+uint8_t App_I2C1_Read(uint8_t device_addr, uint8_t *writeBuf, uint32_t writeSize, uint8_t *readBuf, uint32_t readSize)
+{
+    int dev = Device(device_addr);
+
+    if ((1U != writeSize) || (writeBuf[0] + readSize > 256U))
+    {
+        abort();
+    }
+
+    /* Burst reads on OUT_X_MSB wrap, they drain the FIFO */
+    if ((FXOS8700_OUT_X_MSB_REG == writeBuf[0]) && (readSize >= MOTION_AXIS_DATA_SIZE))
+    {
+        memcpy(readBuf, sFifo[dev], readSize);
+    }
+    else
+    {
+        memcpy(readBuf, &sRegs[dev][writeBuf[0]], readSize);
+    }
+    return I2C_RESULT_OK;
+}
+
+uint8_t App_I2C1_Write(uint8_t device_addr, uint8_t *writeBuf, uint32_t writeSize)
+{
+    if (2U != writeSize)
+    {
+        abort();
+    }
+    sRegs[Device(device_addr)][writeBuf[0]] = writeBuf[1];
+    return I2C_RESULT_OK;
+}
+
+void SensorEvents_RegisterHandler(sensor_events_t event, sensor_event_handler_t handler)
+{
+    sHandlers[(kSensorEvAccel == event) ? ACCEL : GYRO] = handler;
+}
+
+uint64_t TMR_GetTimestamp(void)
+{
+    return sNow;
+}
+
+void OSA_InterruptDisable(void)
+{
+}
+
+void OSA_InterruptEnable(void)
+{
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+static void BatchCallback(void)
+{
+    sBatches++;
+}
+
+/* Builds count FIFO samples, sample i of the batch holds value + i on every axis */
+static void MakeBatch(uint8_t *raw, uint8_t count, int16_t value, bool accel)
+{
+    uint16_t v;
+    uint8_t i;
+    uint8_t axis;
+
+    for (i = 0; i < count; i++)
+    {
+        v = accel ? (uint16_t)((value + i) << 2) : (uint16_t)(value + i);
+        for (axis = 0; axis < 3; axis++)
+        {
+            *raw++ = (uint8_t)(v >> 8);
+            *raw++ = (uint8_t)v;
+        }
+    }
+}
+
+static void PushAccel(uint8_t count, int16_t value, uint32_t timestamp)
+{
+    uint8_t raw[MOTION_CAPTURE_FIFO_DEPTH * MOTION_AXIS_DATA_SIZE];
+
+    MakeBatch(raw, count, value, true);
+    MotionCapture_PushAccelBatch(raw, count, timestamp, NULL);
+}
+
+static void PushGyro(uint8_t count, int16_t value, uint32_t timestamp)
+{
+    uint8_t raw[MOTION_CAPTURE_FIFO_DEPTH * MOTION_AXIS_DATA_SIZE];
+
+    MakeBatch(raw, count, value, false);
+    MotionCapture_PushGyroBatch(raw, count, timestamp);
+}
+
+static void Restart(uint16_t rateHz)
+{
+    CHECK(0 == MotionCapture_Stop());
+    CHECK(0 == MotionCapture_Start(rateHz, 4));
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* Only the supported rates and FIFO levels start the capture, Stop puts the sensors back */
+static void TestStartStop(void)
+{
+    CHECK(1 == MotionCapture_Start(150, 10));
+    CHECK(1 == MotionCapture_Start(200, 0));
+    CHECK(1 == MotionCapture_Start(200, MOTION_CAPTURE_FIFO_DEPTH));
+    CHECK(!MotionCapture_IsRunning());
+    CHECK(0U == MotionCapture_GetPeriod());
+    CHECK(NULL == sHandlers[ACCEL]);
+
+    CHECK(0 == MotionCapture_Start(200, 20));
+    CHECK(MotionCapture_IsRunning());
+    CHECK(5000U == MotionCapture_GetPeriod());
+    CHECK((FXOS8700_F_MODE0_MASK | 20) == sRegs[ACCEL][FXOS8700_F_SETUP_REG]);
+    CHECK((FXAS21002_F_SETUP_F_MODE_CIR_MODE | 20) == sRegs[GYRO][FXAS21002_F_SETUP]);
+    CHECK((FXOS8700_HYB_DATA_RATE_200HZ | FXOS8700_ACTIVE_MASK) ==
+          (sRegs[ACCEL][FXOS8700_CTRL_REG1] & (FXOS8700_DR_MASK | FXOS8700_ACTIVE_MASK)));
+    CHECK(NULL != sHandlers[ACCEL]);
+    CHECK(NULL != sHandlers[GYRO]);
+
+    /* Already running */
+    CHECK(1 == MotionCapture_Start(100, 20));
+
+    CHECK(0 == MotionCapture_Stop());
+    CHECK(!MotionCapture_IsRunning());
+    CHECK(FXOS8700_F_MODE_DISABLED == sRegs[ACCEL][FXOS8700_F_SETUP_REG]);
+    CHECK(NULL == sHandlers[ACCEL]);
+    CHECK(NULL == sHandlers[GYRO]);
+}
+
+/* Samples within half a period are paired, timestamps follow the output data rate */
+static void TestPairing(void)
+{
+    motion_reader_t reader;
+    motion_sample_t samples[16];
+    uint32_t i;
+
+    Restart(100);
+    MotionCapture_ReaderInit(&reader);
+
+    PushAccel(4, 100, 40000);
+    CHECK(0 == MotionCapture_Read(&reader, samples, 16));
+
+    PushGyro(4, -50, 41000);
+    CHECK(4 == MotionCapture_Read(&reader, samples, 16));
+    for (i = 0; i < 4; i++)
+    {
+        CHECK(samples[i].flags == (kMotionSampleAccel | kMotionSampleGyro));
+        CHECK(samples[i].timestamp == 10000U * (i + 1U));
+        CHECK(samples[i].accel[0] == (int16_t)(100 + i));
+        CHECK(samples[i].accel[2] == (int16_t)(100 + i));
+        CHECK(samples[i].gyro[1] == (int16_t)(-50 + (int32_t)i));
+    }
+
+    /* A late drain keeps the time line of the previous batch */
+    PushAccel(2, 0, 62000);
+    PushGyro(2, 0, 63000);
+    CHECK(2 == MotionCapture_Read(&reader, samples, 16));
+    CHECK(50000U == samples[0].timestamp);
+    CHECK(60000U == samples[1].timestamp);
+
+    /* A drain far off the time line restarts it from the drain time */
+    PushAccel(1, 0, 200000);
+    PushGyro(1, 0, 200000);
+    CHECK(1 == MotionCapture_Read(&reader, samples, 16));
+    CHECK(200000U == samples[0].timestamp);
+    CHECK(0U == reader.lost);
+}
+
+/* Samples without a counterpart are published alone, in time order */
+static void TestUnpaired(void)
+{
+    motion_reader_t reader;
+    motion_sample_t samples[MOTION_CAPTURE_RING_SIZE];
+    uint32_t count;
+    uint32_t i;
+
+    Restart(100);
+    MotionCapture_ReaderInit(&reader);
+
+    /* A gyroscope sample before the first accelerometer one, then a gap in the gyroscope */
+    PushAccel(2, 0, 20000);
+    PushGyro(1, 7, 0);
+    PushAccel(1, 0, 30000);
+    PushGyro(1, 8, 30000);
+    CHECK(4 == MotionCapture_Read(&reader, samples, 16));
+    CHECK(kMotionSampleGyro == samples[0].flags);
+    CHECK(0U == samples[0].timestamp);
+    CHECK(7 == samples[0].gyro[0]);
+    CHECK(kMotionSampleAccel == samples[1].flags);
+    CHECK(10000U == samples[1].timestamp);
+    CHECK(kMotionSampleAccel == samples[2].flags);
+    CHECK((kMotionSampleAccel | kMotionSampleGyro) == samples[3].flags);
+    CHECK(30000U == samples[3].timestamp);
+    CHECK(8 == samples[3].gyro[0]);
+
+    /* The gyroscope stalls: the stage keeps the most recent accelerometer samples */
+    Restart(100);
+    MotionCapture_ReaderInit(&reader);
+    for (i = 0; i < 4; i++)
+    {
+        PushAccel(20, (int16_t)(20 * i), 200000U * (i + 1U));
+    }
+    count = MotionCapture_Read(&reader, samples, MOTION_CAPTURE_RING_SIZE);
+    CHECK(80U - MOTION_STAGE_SIZE == count);
+    for (i = 0; i < count; i++)
+    {
+        CHECK(kMotionSampleAccel == samples[i].flags);
+        CHECK(samples[i].accel[0] == (int16_t)i);
+    }
+    CHECK(MOTION_STAGE_SIZE == sAccelStage.count);
+}
+
+/* A slow reader loses the oldest samples, the others are not affected */
+static void TestRingLoss(void)
+{
+    motion_reader_t fast;
+    motion_reader_t slow;
+    motion_sample_t samples[MOTION_CAPTURE_RING_SIZE];
+    uint32_t expected = 0;
+    uint32_t count;
+    uint32_t i;
+
+    Restart(400);
+    MotionCapture_ReaderInit(&fast);
+    MotionCapture_ReaderInit(&slow);
+
+    for (i = 0; i < 10; i++)
+    {
+        PushAccel(20, (int16_t)(20 * i), 50000U * (i + 1U));
+        PushGyro(20, 0, 50000U * (i + 1U));
+
+        count = MotionCapture_Read(&fast, samples, MOTION_CAPTURE_RING_SIZE);
+        CHECK(20 == count);
+        CHECK(samples[0].accel[0] == (int16_t)expected);
+        expected += count;
+    }
+    CHECK(0U == fast.lost);
+
+    count = MotionCapture_Read(&slow, samples, MOTION_CAPTURE_RING_SIZE);
+    /* The oldest slot may be under the writer, it is given up as well */
+    CHECK(MOTION_CAPTURE_RING_SIZE - 1U == count);
+    CHECK(200U == count + slow.lost);
+    CHECK(samples[0].accel[0] == (int16_t)slow.lost);
+    CHECK(samples[count - 1U].accel[0] == 199);
+    CHECK(0 == MotionCapture_Read(&slow, samples, MOTION_CAPTURE_RING_SIZE));
+}
+
+/* The latest value of each vector, reset by every start */
+static void TestLatest(void)
+{
+    motion_sample_t latest;
+
+    Restart(200);
+    CHECK(!MotionCapture_GetLatest(&latest));
+
+    /* The gyroscope sample waits for its counterpart */
+    PushAccel(1, 3, 10000);
+    PushGyro(1, 9, 40000);
+    CHECK(MotionCapture_GetLatest(&latest));
+    CHECK(kMotionSampleAccel == latest.flags);
+    CHECK(10000U == latest.timestamp);
+
+    PushAccel(1, 3, 40000);
+    CHECK(MotionCapture_GetLatest(&latest));
+    CHECK((kMotionSampleAccel | kMotionSampleGyro) == latest.flags);
+    CHECK(3 == latest.accel[1]);
+    CHECK(9 == latest.gyro[1]);
+    CHECK(40000U == latest.timestamp);
+
+    Restart(200);
+    CHECK(!MotionCapture_GetLatest(&latest));
+}
+
+/* The watermark handlers drain the FIFOs, read the magnetometer and run the batch callback */
+static void TestHandlers(void)
+{
+    motion_reader_t reader;
+    motion_sample_t samples[16];
+    static const uint8_t mag[MOTION_AXIS_DATA_SIZE] = {0x01, 0x02, 0xFF, 0xFE, 0x00, 0x10};
+
+    Restart(200);
+    MotionCapture_SetBatchCallback(BatchCallback);
+    MotionCapture_ReaderInit(&reader);
+    sBatches = 0;
+
+    MakeBatch(sFifo[ACCEL], 3, -8, true);
+    sRegs[ACCEL][FXOS8700_F_STATUS_REG] = 3;
+    memcpy(&sRegs[ACCEL][FXOS8700_M_OUT_X_MSB_REG], mag, sizeof(mag));
+    MakeBatch(sFifo[GYRO], 3, 1000, false);
+    sRegs[GYRO][FXAS21002_F_STATUS] = 3;
+
+    sNow = 1000000;
+    sHandlers[ACCEL]();
+    sNow += 100;
+    sHandlers[GYRO]();
+    CHECK(2U == sBatches);
+
+    CHECK(3 == MotionCapture_Read(&reader, samples, 16));
+    CHECK(samples[0].accel[0] == -8);
+    CHECK(samples[2].gyro[2] == 1002);
+    CHECK(samples[2].timestamp == 1000000U);
+    CHECK(0U == (samples[1].flags & kMotionSampleMag));
+    CHECK(0U != (samples[2].flags & kMotionSampleMag));
+    CHECK(0x0102 == samples[2].mag[0]);
+    CHECK(-2 == samples[2].mag[1]);
+    CHECK(0x0010 == samples[2].mag[2]);
+
+    /* An empty FIFO is not a batch */
+    sRegs[ACCEL][FXOS8700_F_STATUS_REG] = 0;
+    sHandlers[ACCEL]();
+    CHECK(2U == sBatches);
+
+    MotionCapture_SetBatchCallback(NULL);
+    CHECK(0 == MotionCapture_Stop());
+}
+
+int main(void)
+{
+    TestStartStop();
+    TestPairing();
+    TestUnpaired();
+    TestRingLoss();
+    TestLatest();
+    TestHandlers();
+
+    printf("motion_capture: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file sensor_conditioning_test.c
+ * Host test for the environmental sensor conditioning. The module source is built in and fed
+ * with synthetic signals: spikes on a constant level, steps, and a slow drift with Gaussian noise
+ * and outliers. The outputs are compared with the clean signals, and the batch path with the
+ * sample by sample one.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../sensor_conditioning.c"
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+#define MAX_SAMPLES (4000U)
+#define PI          (3.14159265358979)
+
+static float sIn[MAX_SAMPLES];
+static float sOut[MAX_SAMPLES];
+static float sClean[MAX_SAMPLES];
+
+static const sensor_conditioning_config_t sTemperature = {5, true, CONDITIONING_LOWPASS_0_1, 1};
+static const sensor_conditioning_config_t sLight = {3, false, CONDITIONING_LOWPASS_0_2, 1};
+
+static double Gaussian(void)
+{
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * PI * u2);
+}
+
+static void Configure(sensor_conditioning_channel_t channel, const sensor_conditioning_config_t *config)
+{
+    CHECK(SensorConditioning_Configure(channel, config) == 0);
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* Isolated spikes never reach the output: up to two in a row with a window of five, one with three */
+static void TestOutliers(void)
+{
+    sensor_conditioning_config_t medianOnly = sTemperature;
+    uint32_t i;
+
+    medianOnly.lowPass = false;
+    Configure(kConditioningTemperature, &medianOnly);
+    for (i = 0; i < 1000; i++)
+    {
+        sIn[i] = 21.5f;
+        if ((i % 10) == 3)
+        {
+            sIn[i] = 85.0f;     /* ENS210 glitch */
+        }
+        if ((i % 10) == 4)
+        {
+            sIn[i] = -40.0f;
+        }
+    }
+    CHECK(SensorConditioning_Process(kConditioningTemperature, sIn, sOut, 1000) == 1000);
+    for (i = 0; i < 1000; i++)
+    {
+        CHECK(sOut[i] == 21.5f);
+    }
+
+    /* With the low-pass, the output stays at the level */
+    Configure(kConditioningTemperature, &sTemperature);
+    CHECK(SensorConditioning_Process(kConditioningTemperature, sIn, sOut, 1000) == 1000);
+    for (i = 0; i < 1000; i++)
+    {
+        CHECK(fabsf(sOut[i] - 21.5f) < 1e-4f);
+    }
+
+    /* A window of three drops single spikes, in place */
+    Configure(kConditioningAmbientLight, &sLight);
+    for (i = 0; i < 1000; i++)
+    {
+        sIn[i] = ((i % 7) == 5) ? 60000.0f : 320.0f;
+    }
+    CHECK(SensorConditioning_Process(kConditioningAmbientLight, sIn, sIn, 1000) == 1000);
+    for (i = 0; i < 1000; i++)
+    {
+        CHECK(sIn[i] == 320.0f);
+    }
+
+    /* Three in a row are a change of level, not an outlier */
+    Configure(kConditioningTemperature, &medianOnly);
+    for (i = 0; i < 20; i++)
+    {
+        sIn[i] = ((i >= 10) && (i < 13)) ? 30.0f : 20.0f;
+    }
+    SensorConditioning_Process(kConditioningTemperature, sIn, sOut, 20);
+    CHECK((sOut[12] == 30.0f) && (sOut[11] == 20.0f) && (sOut[15] == 20.0f));
+    printf("  outliers: spikes of 1 and 2 samples removed by the median of 5, single ones by the median of 3\n");
+}
+
+/* Step responses of the two low-pass filters: unity gain, Butterworth overshoot and rise time */
+static void TestStepResponse(void)
+{
+    static const struct
+    {
+        const char *name;
+        sensor_conditioning_config_t config;
+        uint32_t minRise;
+        uint32_t maxRise;
+        float overshoot;
+    } filters[] =
+    {
+        /* Bilinear transform of a second order Butterworth: the overshoot grows with the cut-off */
+        {"0.1 fs", {1, true, CONDITIONING_LOWPASS_0_1, 1}, 3, 5, 0.050f},
+        {"0.2 fs", {1, true, CONDITIONING_LOWPASS_0_2, 1}, 1, 3, 0.075f},
+    };
+    float peak;
+    uint32_t rise10;
+    uint32_t rise90;
+    uint32_t settle;
+    uint32_t f;
+    uint32_t i;
+
+    for (f = 0; f < 2; f++)
+    {
+        Configure(kConditioningPressure, &filters[f].config);
+        for (i = 0; i < 200; i++)
+        {
+            sIn[i] = (i < 10) ? 1000.0f : 1010.0f;
+        }
+        SensorConditioning_Process(kConditioningPressure, sIn, sOut, 200);
+
+        peak = 0.0f;
+        rise10 = 0;
+        rise90 = 0;
+        settle = 0;
+        for (i = 0; i < 200; i++)
+        {
+            float level = (sOut[i] - 1000.0f) / 10.0f;
+
+            CHECK((i >= 10) || (fabsf(sOut[i] - 1000.0f) < 1e-3f));
+            peak = (level > peak) ? level : peak;
+            if ((rise10 == 0) && (level >= 0.1f))
+            {
+                rise10 = i;
+            }
+            if ((rise90 == 0) && (level >= 0.9f))
+            {
+                rise90 = i;
+            }
+            if (fabsf(level - 1.0f) > 0.01f)
+            {
+                settle = i + 1;
+            }
+        }
+        CHECK(fabsf(peak - 1.0f - filters[f].overshoot) < 0.002f);
+        CHECK(fabsf(sOut[199] - 1010.0f) < 1e-3f);
+        CHECK((rise90 - rise10 >= filters[f].minRise) && (rise90 - rise10 <= filters[f].maxRise));
+        printf("  step, low-pass %s: 10-90 %% rise %u samples, overshoot %.1f %%, within 1 %% after %u samples\n",
+               filters[f].name, rise90 - rise10, (peak - 1.0f) * 100.0f, settle - 10);
+    }
+
+    /* The median delays a step by half its window */
+    Configure(kConditioningTemperature, &sTemperature);
+    for (i = 0; i < 100; i++)
+    {
+        sIn[i] = (i < 10) ? 20.0f : 25.0f;
+    }
+    SensorConditioning_Process(kConditioningTemperature, sIn, sOut, 100);
+    CHECK((sOut[11] == 20.0f) && (sOut[12] > 20.0f));
+}
+
+/* A slow drift with noise and outliers: the error to the clean signal shrinks */
+static void TestNoisySignal(void)
+{
+    double rawError = 0.0;
+    double error = 0.0;
+    double worst = 0.0;
+    uint32_t count = 0;
+    uint32_t i;
+
+    Configure(kConditioningHumidity, &sTemperature);
+    for (i = 0; i < MAX_SAMPLES; i++)
+    {
+        /* 45 %RH, +-10 over 2000 samples, noise 0.4 %RH, one outlier in 50 */
+        sClean[i] = (float)(45.0 + 10.0 * sin(2.0 * PI * i / 2000.0));
+        sIn[i] = sClean[i] + (float)(0.4 * Gaussian());
+        if ((rand() % 50) == 0)
+        {
+            sIn[i] = (rand() & 1) ? 100.0f : 0.0f;
+        }
+    }
+
+    /* Random batch sizes, as the sample buffer is drained */
+    for (i = 0; i < MAX_SAMPLES;)
+    {
+        uint32_t batch = 1 + rand() % 64;
+
+        batch = (i + batch > MAX_SAMPLES) ? (MAX_SAMPLES - i) : batch;
+        CHECK(SensorConditioning_Process(kConditioningHumidity, &sIn[i], &sOut[i], batch) == batch);
+        i += batch;
+    }
+
+    /* After the start, against the clean signal delayed by the median and the filter group delay */
+    for (i = 100; i < MAX_SAMPLES; i++)
+    {
+        double e = sOut[i] - sClean[i - 4];
+
+        rawError += (sIn[i] - sClean[i]) * (sIn[i] - sClean[i]);
+        error += e * e;
+        worst = (fabs(e) > worst) ? fabs(e) : worst;
+        count++;
+    }
+    rawError = sqrt(rawError / count);
+    error = sqrt(error / count);
+    CHECK(error < 0.2);
+    CHECK(worst < 0.8);
+    printf("  humidity drift, 0.4 %%RH noise and 2 %% outliers: rms error %.2f raw, %.3f conditioned, worst %.2f\n",
+           rawError, error, worst);
+}
+
+/* Batches give the same result as sample by sample, and decimation counts across batches */
+static void TestBatchesAndDecimation(void)
+{
+    sensor_conditioning_config_t decimated = sTemperature;
+    float sample;
+    uint32_t kept;
+    uint32_t i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        sIn[i] = (float)(1013.0 + Gaussian());
+    }
+
+    Configure(kConditioningPressure, &sTemperature);
+    SensorConditioning_Process(kConditioningPressure, sIn, sOut, 1000);
+    Configure(kConditioningPressure, &sTemperature);
+    for (i = 0; i < 1000; i++)
+    {
+        CHECK(SensorConditioning_ProcessSample(kConditioningPressure, sIn[i], &sample));
+        CHECK(sample == sOut[i]);
+    }
+
+    decimated.decimation = 4;
+    Configure(kConditioningPressure, &decimated);
+    kept = 0;
+    for (i = 0; i < 1000; i += 7)
+    {
+        uint32_t batch = (i + 7 > 1000) ? (1000 - i) : 7;
+
+        kept += SensorConditioning_Process(kConditioningPressure, &sIn[i], &sClean[kept], batch);
+    }
+    CHECK(kept == 250);
+    for (i = 0; i < 250; i++)
+    {
+        CHECK(sClean[i] == sOut[4 * i]);
+    }
+
+    Configure(kConditioningPressure, &decimated);
+    CHECK(SensorConditioning_ProcessSample(kConditioningPressure, 1013.0f, &sample));
+    sample = -1.0f;
+    CHECK(!SensorConditioning_ProcessSample(kConditioningPressure, 1013.0f, &sample) && (sample == -1.0f));
+
+    /* Invalid configurations are refused */
+    decimated.decimation = 0;
+    CHECK(SensorConditioning_Configure(kConditioningPressure, &decimated) == 1);
+    decimated = sTemperature;
+    decimated.medianLength = 4;
+    CHECK(SensorConditioning_Configure(kConditioningPressure, &decimated) == 1);
+    decimated.medianLength = SENSOR_CONDITIONING_MEDIAN_MAX + 2;
+    CHECK(SensorConditioning_Configure(kConditioningPressure, &decimated) == 1);
+    CHECK(SensorConditioning_Configure(kConditioningChannels, &sTemperature) == 1);
+    CHECK(SensorConditioning_Process(kConditioningChannels, sIn, sOut, 10) == 0);
+    printf("  batches match sample by sample, decimation by 4 keeps 250 of 1000 across batches of 7\n");
+}
+
+/* The self-heating model follows its exponential */
+static void TestSelfHeating(void)
+{
+    float expected;
+    uint32_t t;
+
+    CHECK(SensorConditioning_CompensateTemperature(30.0f, 0) == 30.0f);
+    for (t = 1000; t <= 3 * SENSOR_CONDITIONING_HEATING_TIME; t += 1000)
+    {
+        float ambient = SensorConditioning_CompensateTemperature(30.0f, t);
+
+        expected = 30.0f - SENSOR_CONDITIONING_HEATING_OFFSET * (1.0f - expf(-(float)t / SENSOR_CONDITIONING_HEATING_TIME));
+        CHECK(fabsf(ambient - expected) < 0.05f);
+    }
+
+    /* Long gaps between readings */
+    expected = 30.0f - SENSOR_CONDITIONING_HEATING_OFFSET * (1.0f - expf(-4.0f));
+    CHECK(fabsf(SensorConditioning_CompensateTemperature(30.0f, 4 * SENSOR_CONDITIONING_HEATING_TIME) - expected) < 0.05f);
+    CHECK(SensorConditioning_CompensateTemperature(30.0f, 20 * SENSOR_CONDITIONING_HEATING_TIME) ==
+          30.0f - SENSOR_CONDITIONING_HEATING_OFFSET);
+    CHECK(SensorConditioning_CompensateTemperature(30.0f, UINT32_MAX) == 30.0f - SENSOR_CONDITIONING_HEATING_OFFSET);
+    printf("  self-heating: within 0.05 C of the warm-up exponential, 1 s steps over 3 time constants\n");
+}
+
+int main(void)
+{
+    srand(1);
+    TestOutliers();
+    TestStepResponse();
+    TestNoisySignal();
+    TestBatchesAndDecimation();
+    TestSelfHeating();
+
+    printf("sensor_conditioning: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file sensor_fusion_test.c
+ * Host test for the fixed-point AHRS. The module source is built in with a stubbed motion
+ * capture, and fed with synthetic samples of a board at a known orientation: the published
+ * heading and quaternion are compared with the true ones.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../sensor_fusion.c"
+
+/*****************************************************************************
+ * Stubs
+ ****************************************************************************/
+#define MAX_SAMPLES     (64U)
+
+static uint32_t sCapturePeriod;
+static motion_batch_callback_t sBatchHandler;
+static motion_sample_t sCaptured[MAX_SAMPLES];
+static uint32_t sCapturedCount;
+
+uint32_t MotionCapture_GetPeriod(void)
+{
+    return sCapturePeriod;
+}
+
+void MotionCapture_SetBatchCallback(motion_batch_callback_t callback)
+{
+    sBatchHandler = callback;
+}
+
+void MotionCapture_ReaderInit(motion_reader_t *reader)
+{
+    reader->next = sCapturedCount;
+    reader->lost = 0;
+}
+
+uint32_t MotionCapture_Read(motion_reader_t *reader, motion_sample_t *samples, uint32_t maxSamples)
+{
+    uint32_t count = sCapturedCount - reader->next;
+
+    if (count > maxSamples)
+    {
+        count = maxSamples;
+    }
+    memcpy(samples, &sCaptured[reader->next], count * sizeof(motion_sample_t));
+    reader->next += count;
+    return count;
+}
+
+void OSA_InterruptDisable(void)
+{
+}
+
+void OSA_InterruptEnable(void)
+{
+}
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+#define DEG         (3.14159265358979 / 180.0)
+#define RATE_HZ     (200U)
+#define ACCEL_1G    (4096.0)    /* counts, 2 g range */
+#define FIELD_H     (300.0)     /* counts, 30 uT horizontal */
+#define FIELD_V     (-400.0)    /* counts, 40 uT down */
+#define MAG_EVERY   (20U)       /* One magnetometer reading per FIFO drain */
+
+static uint32_t sPublished;
+
+/* Board at heading h (clockwise from north), roll r about its x axis, turning at w (deg/s,
+ * clockwise seen from above) */
+typedef struct
+{
+    double heading;
+    double roll;
+    double rate;
+} pose_t;
+
+/* Rotates an earth (north, west, up) vector to the board frame of the pose */
+static void ToBoard(const pose_t *pose, const double earth[3], double board[3])
+{
+    double yaw = -pose->heading * DEG;
+    double roll = pose->roll * DEG;
+    double v[3];
+
+    /* Undo the yaw about up, then the roll about x */
+    v[0] = cos(yaw) * earth[0] + sin(yaw) * earth[1];
+    v[1] = -sin(yaw) * earth[0] + cos(yaw) * earth[1];
+    v[2] = earth[2];
+
+    board[0] = v[0];
+    board[1] = cos(roll) * v[1] + sin(roll) * v[2];
+    board[2] = -sin(roll) * v[1] + cos(roll) * v[2];
+}
+
+static void MakeSample(const pose_t *pose, uint32_t index, bool mag, motion_sample_t *sample)
+{
+    static const double up[3] = {0.0, 0.0, ACCEL_1G};
+    static const double field[3] = {FIELD_H, 0.0, FIELD_V};
+    double turn[3] = {0.0, 0.0, -pose->rate / (SENSOR_FUSION_GYRO_MDPS_PER_LSB / 1000.0)};
+    double v[3];
+    uint32_t i;
+
+    memset(sample, 0, sizeof(*sample));
+    sample->timestamp = index * (1000000U / RATE_HZ);
+    sample->flags = kMotionSampleAccel | kMotionSampleGyro;
+
+    ToBoard(pose, up, v);
+    for (i = 0; i < 3; i++)
+    {
+        sample->accel[i] = (int16_t)lround(v[i]);
+    }
+    ToBoard(pose, turn, v);
+    for (i = 0; i < 3; i++)
+    {
+        sample->gyro[i] = (int16_t)lround(v[i]);
+    }
+    if (mag)
+    {
+        ToBoard(pose, field, v);
+        for (i = 0; i < 3; i++)
+        {
+            sample->mag[i] = (int16_t)lround(v[i]);
+        }
+        sample->flags |= kMotionSampleMag;
+    }
+}
+
+/* Centidegrees between two headings */
+static int32_t HeadingError(uint16_t heading, double expected)
+{
+    int32_t error = (int32_t)heading - (int32_t)lround(expected * 100.0);
+
+    error %= 36000;
+    if (error > 18000)
+    {
+        error -= 36000;
+    }
+    if (error < -18000)
+    {
+        error += 36000;
+    }
+    return abs(error);
+}
+
+static double QuaternionNorm(const sensor_fusion_output_t *output)
+{
+    double squares = 0.0;
+    uint32_t i;
+
+    for (i = 0; i < 4; i++)
+    {
+        double q = (double)output->quaternion[i] / SENSOR_FUSION_ONE;
+        squares += q * q;
+    }
+    return sqrt(squares);
+}
+
+static void Published(const sensor_fusion_output_t *output)
+{
+    (void)output;
+    sPublished++;
+}
+
+static void Start(uint16_t outputRateHz)
+{
+    sCapturePeriod = 1000000U / RATE_HZ;
+    sCapturedCount = 0;
+    sPublished = 0;
+    CHECK(0 == SensorFusion_Start(outputRateHz, Published));
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* The fusion needs a running capture and an output rate it can provide */
+static void TestStart(void)
+{
+    sCapturePeriod = 0;
+    CHECK(1 == SensorFusion_Start(10, NULL));
+
+    sCapturePeriod = 1000000U / RATE_HZ;
+    CHECK(1 == SensorFusion_Start(0, NULL));
+    CHECK(1 == SensorFusion_Start(RATE_HZ + 1U, NULL));
+    CHECK(0 == SensorFusion_Start(RATE_HZ, NULL));
+    CHECK(SensorFusion_BatchHandler == sBatchHandler);
+
+    SensorFusion_Stop();
+    CHECK(NULL == sBatchHandler);
+}
+
+/* A still board: the heading is right from the first publication, tilted or not */
+static void TestStill(void)
+{
+    static const double headings[] = {0.0, 45.0, 90.0, 170.0, 190.0, 270.0, 359.0};
+    sensor_fusion_output_t output;
+    motion_sample_t sample;
+    pose_t pose = {0.0, 0.0, 0.0};
+    uint32_t h;
+    uint32_t roll;
+    uint32_t i;
+
+    for (roll = 0; roll < 2; roll++)
+    {
+        for (h = 0; h < sizeof(headings) / sizeof(headings[0]); h++)
+        {
+            pose.heading = headings[h];
+            pose.roll = roll ? 25.0 : 0.0;
+            Start(10);
+
+            for (i = 0; i < 2U * RATE_HZ; i++)
+            {
+                MakeSample(&pose, i, 0U == (i % MAG_EVERY), &sample);
+                SensorFusion_Update(&sample);
+
+                if (SensorFusion_GetOutput(&output))
+                {
+                    CHECK(output.magnetic);
+                    CHECK(HeadingError(output.heading, pose.heading) <= 100);
+                    CHECK(fabs(QuaternionNorm(&output) - 1.0) < 0.001);
+                }
+            }
+
+            /* 10 Hz over 2 s */
+            CHECK(20U == sPublished);
+        }
+    }
+}
+
+/* A tilted board turning at 90 deg/s for 4 s: the heading follows the gyroscope */
+static void TestTurning(void)
+{
+    sensor_fusion_output_t output;
+    motion_sample_t sample;
+    pose_t pose = {30.0, 10.0, 90.0};
+    int32_t worst = 0;
+    int32_t error;
+    uint32_t i;
+
+    Start(50);
+
+    for (i = 0; i < 4U * RATE_HZ; i++)
+    {
+        pose.heading = fmod(30.0 + pose.rate * i / RATE_HZ, 360.0);
+        MakeSample(&pose, i, 0U == (i % MAG_EVERY), &sample);
+        SensorFusion_Update(&sample);
+
+        CHECK(SensorFusion_GetOutput(&output));
+        if (output.timestamp == sample.timestamp)
+        {
+            error = HeadingError(output.heading, pose.heading);
+            worst = (error > worst) ? error : worst;
+            CHECK(fabs(QuaternionNorm(&output) - 1.0) < 0.001);
+        }
+    }
+
+    /* The magnetometer is read once per drain, up to 9 degrees late at this rate */
+    printf("turning: worst heading error %d.%02d deg\n", worst / 100, worst % 100);
+    CHECK(worst <= 300);
+    CHECK(200U == sPublished);
+}
+
+/* The batch handler fuses the captured samples in chunks */
+static void TestBatches(void)
+{
+    sensor_fusion_output_t output;
+    pose_t pose = {135.0, 0.0, 0.0};
+    uint32_t i;
+
+    Start(RATE_HZ);
+
+    for (i = 0; i < MAX_SAMPLES; i++)
+    {
+        MakeSample(&pose, i, 0U == (i % MAG_EVERY), &sCaptured[i]);
+    }
+    sCapturedCount = MAX_SAMPLES;
+    sBatchHandler();
+
+    CHECK(MAX_SAMPLES == sPublished);
+    CHECK(SensorFusion_GetOutput(&output));
+    CHECK(sCaptured[MAX_SAMPLES - 1U].timestamp == output.timestamp);
+    CHECK(HeadingError(output.heading, pose.heading) <= 100);
+
+    /* Stopped, the samples are left in the capture */
+    SensorFusion_Stop();
+    sCapturedCount = 0;
+    sPublished = 0;
+    SensorFusion_BatchHandler();
+    CHECK(0U == sPublished);
+}
+
+int main(void)
+{
+    TestStart();
+    TestStill();
+    TestTurning();
+    TestBatches();
+
+    printf("sensor_fusion: all tests passed\n");
+    return 0;
+}
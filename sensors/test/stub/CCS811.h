@@ -0,0 +1,13 @@
+/* Host test stub of the CCS811 driver */
+#ifndef _CCS811_H_
+#define _CCS811_H_
+
+typedef enum
+{
+    CCS811_SUCCESS = 0,
+    CCS811_I2C_ERROR,
+} CCS811_status;
+
+CCS811_status CCS811_getBaseline(unsigned int *baseline);
+
+#endif
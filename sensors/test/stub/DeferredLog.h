@@ -0,0 +1,7 @@
+/* Host test stub of the deferred logging */
+#ifndef _DEFERRED_LOG_H_
+#define _DEFERRED_LOG_H_
+
+#define DLOG_PRINTF(...)    ((void)0)
+
+#endif
@@ -0,0 +1,9 @@
+/* Host test stub of the timers manager */
+#ifndef _TIMERS_MANAGER_H_
+#define _TIMERS_MANAGER_H_
+
+#include <stdint.h>
+
+uint64_t TMR_GetTimestamp(void);
+
+#endif
@@ -0,0 +1,7 @@
+/* Host test stub, included by sensors.h only */
+#ifndef _A100X_INTERFACE_H_
+#define _A100X_INTERFACE_H_
+
+#include "fsl_common.h"
+
+#endif
@@ -0,0 +1,7 @@
+/* Host test stub, included by sensors.h only */
+#ifndef _BATTERY_H_
+#define _BATTERY_H_
+
+#include "fsl_common.h"
+
+#endif
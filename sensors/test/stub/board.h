@@ -0,0 +1,8 @@
+/* Host test stub of the board definitions */
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#define FXOS8700_I2C_SLAVE_ADDRESS      (uint8_t)0x1E
+#define FXAS21002_I2C_SLAVE_ADDRESS     (uint8_t)0x20
+
+#endif
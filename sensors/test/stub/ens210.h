@@ -0,0 +1,7 @@
+/* Host test stub, included by sensors.h only */
+#ifndef _ENS210_H_
+#define _ENS210_H_
+
+#include "fsl_common.h"
+
+#endif
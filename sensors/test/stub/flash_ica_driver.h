@@ -0,0 +1,10 @@
+/* Host test stub of the flash image configuration area driver */
+#ifndef _FLASH_ICA_DRIVER_H_
+#define _FLASH_ICA_DRIVER_H_
+
+#define IMG_EXT_NO_ERROR    0
+#define IMG_EXT_ERROR       1
+
+#define FICA_AIR_BASELINE_ADDR  0x00900000
+
+#endif
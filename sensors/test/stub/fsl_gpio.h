@@ -0,0 +1,7 @@
+/* Host test stub, included by sensors.h only */
+#ifndef _FSL_GPIO_H_
+#define _FSL_GPIO_H_
+
+#include "fsl_common.h"
+
+#endif
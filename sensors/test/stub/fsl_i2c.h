@@ -0,0 +1,14 @@
+/* Host test stub of the I2C driver, only the types used by the sensor headers */
+#ifndef _FSL_I2C_H_
+#define _FSL_I2C_H_
+
+#include "fsl_common.h"
+
+typedef struct _I2C_Type I2C_Type;
+typedef struct _i2c_master_handle i2c_master_handle_t;
+typedef struct _i2c_master_transfer
+{
+    uint8_t slaveAddress;
+} i2c_master_transfer_t;
+
+#endif
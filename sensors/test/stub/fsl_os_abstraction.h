@@ -0,0 +1,8 @@
+/* Host test stub of the OS abstraction */
+#ifndef _FSL_OS_ABSTRACTION_H_
+#define _FSL_OS_ABSTRACTION_H_
+
+void OSA_InterruptDisable(void);
+void OSA_InterruptEnable(void);
+
+#endif
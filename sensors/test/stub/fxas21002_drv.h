@@ -0,0 +1,8 @@
+/* Host test stub of the FXAS21002 driver, only the register map */
+#ifndef _FXAS21002_DRV_H_
+#define _FXAS21002_DRV_H_
+
+#include "fsl_common.h"
+#include "fxas21002.h"
+
+#endif
@@ -0,0 +1,9 @@
+/* Host test stub of the external flash image programming */
+#ifndef _IMG_PROGRAM_EXT_H_
+#define _IMG_PROGRAM_EXT_H_
+
+#include <stdint.h>
+
+int32_t img_program_ext_init(void);
+
+#endif
@@ -0,0 +1,7 @@
+/* Host test stub, included by sensors.h only */
+#ifndef _MPL3115_H_
+#define _MPL3115_H_
+
+#include "fsl_common.h"
+
+#endif
@@ -0,0 +1,7 @@
+/* Host test stub, included by sensors.h only */
+#ifndef _PCF2123_H_
+#define _PCF2123_H_
+
+#include "fsl_common.h"
+
+#endif
@@ -0,0 +1,16 @@
+/* Host test stub of the SPI bus arbitration */
+#ifndef _SPI_BUS_SHARE_H_
+#define _SPI_BUS_SHARE_H_
+
+#define SPI_BUS_SHARE_PRIO_STORAGE  2
+#define SPI_BUS_SHARE_NO_DEADLINE   0
+
+typedef enum
+{
+    kSpiBusClientStorage,
+} spi_bus_client_t;
+
+status_t SPI_Bus_Share_Acquire(spi_bus_client_t client, uint8_t priority, uint32_t deadlineMs);
+status_t SPI_Bus_Share_Release(void);
+
+#endif
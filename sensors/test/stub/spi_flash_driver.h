@@ -0,0 +1,13 @@
+/* Host test stub of the SPI flash driver */
+#ifndef _SPI_FLASH_DRIVER_H_
+#define _SPI_FLASH_DRIVER_H_
+
+#include "fsl_common.h"
+
+#define FLASH_SECTOR_SIZE   (256U * 16U)
+
+status_t SPI_Flash_Write(uint32_t offset, uint32_t len, void *buf);
+status_t SPI_Flash_Read(uint32_t offset, uint32_t data_len, void *data);
+status_t SPI_Flash_Erase_Block(uint32_t offset, uint32_t blkSize);
+
+#endif
@@ -0,0 +1,7 @@
+/* Host test stub, included by sensors.h only */
+#ifndef _SX9500_H_
+#define _SX9500_H_
+
+#include "fsl_common.h"
+
+#endif
@@ -0,0 +1,7 @@
+/* Host test stub, included by sensors.h only */
+#ifndef _TSL2572_H_
+#define _TSL2572_H_
+
+#include "fsl_common.h"
+
+#endif
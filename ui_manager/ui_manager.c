@@ -38,6 +38,7 @@
 #include "ui_manager.h"
 #include "fsl_os_abstraction.h"
 #include "FreeRTOS.h"
+#include "timers.h"
 #include "fsl_port.h"
 #include "Panic.h"
 #include "sx9500.h"
@@ -65,191 +66,313 @@
 /*****************************************************************************
  * Variables
  ****************************************************************************/
+/* Scan timer period and state machine thresholds, in scan ticks */
+#define UI_SWITCH_SCAN_TICKS    ((UI_SWITCH_SCAN_PERIOD_MS * configTICK_RATE_HZ) / 1000U)
+#define UI_SWITCH_DEBOUNCE      ((UI_SWITCH_DEBOUNCE_MS + UI_SWITCH_SCAN_PERIOD_MS - 1U) / UI_SWITCH_SCAN_PERIOD_MS)
+#define UI_SWITCH_LONG_PRESS    (UI_SWITCH_LONG_PRESS_MS / UI_SWITCH_SCAN_PERIOD_MS)
+#define UI_SWITCH_REPEAT        (UI_SWITCH_REPEAT_MS / UI_SWITCH_SCAN_PERIOD_MS)
+
+/* Internal event flag, set by the scan timer when the switch event queue is not empty */
+#define UI_SWITCH_QUEUE_EVENT   (1U << 5U)
+
+typedef struct _ui_switch_state
+{
+    uint8_t integrator;         /* Debounce integrator, 0 is released and UI_SWITCH_DEBOUNCE is pressed */
+    bool_t pressed;             /* Debounced state */
+    uint16_t heldTicks;         /* Scan ticks since the debounced press */
+    uint16_t nextEventTicks;    /* Tick of the next long press or repeat event */
+} ui_switch_state_t;
+
+typedef struct _ui_switch_pin
+{
+    GPIO_Type *gpio;
+    uint32_t pin;
+} ui_switch_pin_t;
+
+typedef struct _ui_switch_region
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+    int textX;
+} ui_switch_region_t;
+
 osaTaskId_t  gUiManTaskId;
 static osaEventId_t sUiManTaskEventId;
 static bool_t sIsProcessingEvent = FALSE;
 
 extern osaSemaphoreId_t gOtaSem;
 
-static uint8_t sSwitchOneCount;
-static uint8_t sSwitchTwoCount;
-static uint8_t sSwitchThreeCount;
-static uint8_t sSwitchFourCount;
-static const uint32_t kDebounceCount = 10U;
+static TimerHandle_t sSwitchScanTimer;
+static volatile bool_t sSwitchScanActive = FALSE;
+static ui_switch_state_t sSwitchState[UI_SWITCH_COUNT];
+
+static ui_switch_event_t sSwitchQueue[UI_SWITCH_QUEUE_SIZE];
+static volatile uint8_t sSwitchQueueHead;
+static volatile uint8_t sSwitchQueueTail;
+static volatile uint32_t sSwitchQueueLost;
+
+static uint8_t sSwitchCount[UI_SWITCH_COUNT];
+
+static const ui_switch_pin_t kSwitchPins[UI_SWITCH_COUNT] =
+{
+    {BOARD_INITPINS_USER_SW1_GPIO, BOARD_INITPINS_USER_SW1_GPIO_PIN},
+    {BOARD_INITPINS_USER_SW2_GPIO, BOARD_INITPINS_USER_SW2_GPIO_PIN},
+    {BOARD_INITPINS_USER_SW3_GPIO, BOARD_INITPINS_USER_SW3_GPIO_PIN},
+    {BOARD_INITPINS_USER_SW4_GPIO, BOARD_INITPINS_USER_SW4_GPIO_PIN},
+};
+
+static const ui_switch_region_t kSwitchRegions[UI_SWITCH_COUNT] =
+{
+    {140, 20, 176, 34, 145},
+    {140, 150, 176, 164, 145},
+    {0, 20, 36, 34, 15},
+    {0, 150, 36, 164, 15},
+};
 /*****************************************************************************
  * Private functions
  ****************************************************************************/
 /*!
- * @brief Capture input from switch events
+ * @brief Adds one switch event to the queue read by the UI manager task
  *
- * @param[in, out] events Pointer to event flags from interrupt, outputs input after debounce
+ * @param[in] sw    Switch index
+ * @param[in] type  Event type
+ *
+ * @return TRUE if the event was queued, FALSE if the queue is full
  *
  */
-static void UiManagerCaptureInput(uint32_t *events)
+static bool_t UiManagerPushSwitchEvent(uint8_t sw, ui_switch_event_type_t type)
 {
-    *events = 0U;
-
-    /* Wait for 5 ms to help debounce */
-    OSA_TimeDelay(5);
-
-    volatile uint32_t count = kDebounceCount;
-
-    /*
-     * Verify we have captured all intended inputs by reading the value of each gpio.
-     *
-     * If the GPIO is asserted, we OR the event back into the event flags and clear any pending interrupt.
-     *
-     * If the GPIO is not longer asserted, at any time in the loop it is cleared from the event flags.
-     *
-     */
-    while(count--)
+    uint8_t head = sSwitchQueueHead;
+    uint8_t next = (uint8_t)((head + 1U) % UI_SWITCH_QUEUE_SIZE);
+
+    if (next == sSwitchQueueTail)
     {
-        if (0U == GPIO_PinRead(BOARD_INITPINS_USER_SW1_GPIO, BOARD_INITPINS_USER_SW1_GPIO_PIN))
-        {
-            *events |= kUiSwOne;
-            GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_USER_SW1_GPIO, 1U << BOARD_INITPINS_USER_SW1_GPIO_PIN);
-        }
-        else
-        {
-            *events &= ~kUiSwOne;
-        }
+        sSwitchQueueLost++;
+        return FALSE;
+    }
 
-        if (0U == GPIO_PinRead(BOARD_INITPINS_USER_SW2_GPIO, BOARD_INITPINS_USER_SW2_GPIO_PIN))
-        {
-            *events |= kUiSwTwo;
-            GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_USER_SW2_GPIO, 1U << BOARD_INITPINS_USER_SW2_GPIO_PIN);
-        }
-        else
-        {
-            *events &= ~kUiSwTwo;
-        }
+    sSwitchQueue[head].sw = sw;
+    sSwitchQueue[head].type = (uint8_t)type;
+
+    /* Publish the entry before the index */
+    __DMB();
+    sSwitchQueueHead = next;
+
+    return TRUE;
+}
+
+/*!
+ * @brief Takes the oldest switch event from the queue
+ *
+ * @param[out] event  Event read
+ *
+ * @return TRUE if an event was read, FALSE if the queue is empty
+ *
+ */
+static bool_t UiManagerPopSwitchEvent(ui_switch_event_t *event)
+{
+    uint8_t tail = sSwitchQueueTail;
+
+    if (tail == sSwitchQueueHead)
+    {
+        return FALSE;
+    }
+
+    __DMB();
+    *event = sSwitchQueue[tail];
+    sSwitchQueueTail = (uint8_t)((tail + 1U) % UI_SWITCH_QUEUE_SIZE);
+
+    return TRUE;
+}
 
-        if (0U == GPIO_PinRead(BOARD_INITPINS_USER_SW3_GPIO, BOARD_INITPINS_USER_SW3_GPIO_PIN))
+/*!
+ * @brief Runs one step of the debounce state machine of a switch
+ *
+ * The integrator counts up while the input reads pressed and down while it reads released. The
+ * debounced state only changes when it reaches either end, so bounces shorter than the debounce
+ * time are filtered out without any delay in the UI manager task.
+ *
+ * @param[in] sw      Switch index
+ * @param[in] active  TRUE if the input reads pressed in this scan
+ *
+ * @return TRUE if an event was queued
+ *
+ */
+static bool_t UiManagerStepSwitch(uint8_t sw, bool_t active)
+{
+    ui_switch_state_t *state = &sSwitchState[sw];
+    bool_t queued = FALSE;
+
+    if (active)
+    {
+        if (state->integrator < UI_SWITCH_DEBOUNCE)
         {
-            *events |= kUiSwThree;
-            GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_USER_SW3_GPIO, 1U << BOARD_INITPINS_USER_SW3_GPIO_PIN);
+            state->integrator++;
         }
-        else
+    }
+    else if (state->integrator > 0U)
+    {
+        state->integrator--;
+    }
+
+    if (!state->pressed)
+    {
+        if (UI_SWITCH_DEBOUNCE == state->integrator)
         {
-            *events &= ~kUiSwThree;
+            state->pressed = TRUE;
+            state->heldTicks = 0U;
+            state->nextEventTicks = UI_SWITCH_LONG_PRESS;
+            queued = UiManagerPushSwitchEvent(sw, kUiSwPress);
         }
+    }
+    else if (0U == state->integrator)
+    {
+        state->pressed = FALSE;
+        queued = UiManagerPushSwitchEvent(sw, kUiSwRelease);
+    }
+    else if (++state->heldTicks == state->nextEventTicks)
+    {
+        /* The first event while held is the long press, the following ones are repeats */
+        queued = UiManagerPushSwitchEvent(sw, (UI_SWITCH_LONG_PRESS == state->heldTicks) ? kUiSwLongPress : kUiSwRepeat);
+        state->nextEventTicks += UI_SWITCH_REPEAT;
+    }
+
+    return queued;
+}
+
+/*!
+ * @brief Starts the switch scan timer if it is not already running, can be called from ISR or task
+ */
+static void UiManagerStartSwitchScan(void)
+{
+    BaseType_t taskWoken = pdFALSE;
+
+    if (!sSwitchScanActive)
+    {
+        sSwitchScanActive = TRUE;
 
-        if (0U == GPIO_PinRead(BOARD_INITPINS_USER_SW4_GPIO, BOARD_INITPINS_USER_SW4_GPIO_PIN))
+        if (__get_IPSR())
         {
-            *events |= kUiSwFour;
-            GPIO_ClearPinsInterruptFlags(BOARD_INITPINS_USER_SW4_GPIO, 1U << BOARD_INITPINS_USER_SW4_GPIO_PIN);
+            (void)xTimerStartFromISR(sSwitchScanTimer, &taskWoken);
+            portYIELD_FROM_ISR(taskWoken);
         }
         else
         {
-            *events &= ~kUiSwFour;
+            (void)xTimerStart(sSwitchScanTimer, 0U);
         }
     }
 }
 
 /*!
- * @brief Handler for UI switch input events, displays event counts through GUI
+ * @brief Switch scan timer callback, runs in the RTOS timer task
  *
- * @param[in] events Event flags set from input capture
+ * The timer is one-shot and re-armed here for as long as a switch is pressed or bouncing. Once all
+ * switches are idle it stays stopped until the next switch interrupt.
+ *
+ * @param[in] timer  Timer handle, not used
  *
  */
-static void UiManagerSwitchHandler(uint32_t events)
+static void UiManagerScanSwitches(TimerHandle_t timer)
 {
-    /* Process the captured switch events */
-
-    /* Set background and clear display */
-    GUI_SetBkColor(GUI_BLACK);
-    GUI_Clear();
+    bool_t queued = FALSE;
+    bool_t idle = TRUE;
+    uint8_t sw;
 
-    /* Check for SW1 event */
-    if (events & kUiSwOne)
+    for (sw = 0U; sw < UI_SWITCH_COUNT; sw++)
     {
-        /* Increment the counter */
-        ++sSwitchOneCount;
+        /* Switches are active low */
+        bool_t active = (0U == GPIO_PinRead(kSwitchPins[sw].gpio, kSwitchPins[sw].pin));
 
-        /* Draw a white rectangle to highlight the event */
-        GUI_SetColor(GUI_WHITE);
-        GUI_FillRect(140, 20, 176, 34);
+        if (UiManagerStepSwitch(sw, active))
+        {
+            queued = TRUE;
+        }
 
-        /* Display the count on top of the highlighted area */
-        GUI_SetTextMode(GUI_TM_TRANS);
-        GUI_SetColor(GUI_BLACK);
-        GUI_DispDecAt(sSwitchOneCount, 145, 20, 3);
+        if (sSwitchState[sw].pressed || (0U != sSwitchState[sw].integrator))
+        {
+            idle = FALSE;
+        }
     }
-    else
+
+    if (queued)
     {
-        /* Display the count without the highlighted area */
-        GUI_SetColor(GUI_WHITE);
-        GUI_DispDecAt(sSwitchOneCount, 145, 20, 3);
+        (void)OSA_EventSet(sUiManTaskEventId, UI_SWITCH_QUEUE_EVENT);
     }
 
-    /* Check for SW2 event */
-    if (events & kUiSwTwo)
+    if (idle)
     {
-        /* Increment the counter */
-        ++sSwitchTwoCount;
+        /* A switch interrupt after this point restarts the timer */
+        sSwitchScanActive = FALSE;
 
-        /* Draw a white rectangle to highlight the event */
-        GUI_SetColor(GUI_WHITE);
-        GUI_FillRect(140, 150, 176, 164);
-
-        /* Display the count on top of the highlighted area */
-        GUI_SetTextMode(GUI_TM_TRANS);
-        GUI_SetColor(GUI_BLACK);
-        GUI_DispDecAt(sSwitchTwoCount, 145, 150, 3);
+        /* An edge between the scan above and the flag clear was dropped by the ISR, look again */
+        for (sw = 0U; sw < UI_SWITCH_COUNT; sw++)
+        {
+            if (0U == GPIO_PinRead(kSwitchPins[sw].gpio, kSwitchPins[sw].pin))
+            {
+                UiManagerStartSwitchScan();
+                break;
+            }
+        }
     }
     else
     {
-        /* Display the count without the highlighted area */
-        GUI_SetColor(GUI_WHITE);
-        GUI_DispDecAt(sSwitchTwoCount, 145, 150, 3);
+        (void)xTimerStart(sSwitchScanTimer, 0U);
     }
+}
 
-    /* Check for SW3 event */
-    if (events & kUiSwThree)
-    {
-        /* Increment the counter */
-        ++sSwitchThreeCount;
-
-        /* Draw a white rectangle to highlight the event */
-        GUI_SetColor(GUI_WHITE);
-        GUI_FillRect(0, 20, 36, 34);
+/*!
+ * @brief Draws the counter of one switch, only the region of the counter is updated
+ *
+ * @param[in] sw           Switch index
+ * @param[in] highlighted  TRUE to draw the counter highlighted, while the switch is held
+ *
+ */
+static void UiManagerDrawSwitchCount(uint8_t sw, bool_t highlighted)
+{
+    const ui_switch_region_t *region = &kSwitchRegions[sw];
 
-        /* Display the count on top of the highlighted area */
-        GUI_SetTextMode(GUI_TM_TRANS);
-        GUI_SetColor(GUI_BLACK);
-        GUI_DispDecAt(sSwitchThreeCount, 15, 20, 3);
-    }
-    else
-    {
-        /* Display the count without the highlighted area */
-        GUI_SetColor(GUI_WHITE);
-        GUI_DispDecAt(sSwitchThreeCount, 15, 20, 3);
-    }
+    /* Draw a white rectangle to highlight the event, or erase the previous highlight */
+    GUI_SetColor(highlighted ? GUI_WHITE : GUI_BLACK);
+    GUI_FillRect(region->x0, region->y0, region->x1, region->y1);
 
-    /* Check for SW4 event */
-    if (events & kUiSwFour)
-    {
-        /* Increment the counter */
-        ++sSwitchFourCount;
+    /* Display the count on top of the region */
+    GUI_SetTextMode(GUI_TM_TRANS);
+    GUI_SetColor(highlighted ? GUI_BLACK : GUI_WHITE);
+    GUI_DispDecAt(sSwitchCount[sw], region->textX, region->y0, 3);
+}
 
-        /* Draw a white rectangle to highlight the event */
-        GUI_SetColor(GUI_WHITE);
-        GUI_FillRect(0, 150, 36, 164);
+/*!
+ * @brief Handler for UI switch input events, displays event counts through GUI
+ *
+ * A press increments the counter of the switch and highlights it until release. Holding the switch
+ * past the long press time increments the counter again, then once per repeat interval.
+ *
+ */
+static void UiManagerSwitchHandler(void)
+{
+    ui_switch_event_t event;
 
-        /* Display the count on top of the highlighted area */
-        GUI_SetTextMode(GUI_TM_TRANS);
-        GUI_SetColor(GUI_BLACK);
-        GUI_DispDecAt(sSwitchFourCount, 15, 150, 3);
-    }
-    else
+    while (UiManagerPopSwitchEvent(&event))
     {
-        /* Display the count without the highlighted area */
-        GUI_SetColor(GUI_WHITE);
-        GUI_DispDecAt(sSwitchFourCount, 15, 150, 3);
+        switch (event.type)
+        {
+            case kUiSwPress:
+            case kUiSwLongPress:
+            case kUiSwRepeat:
+                ++sSwitchCount[event.sw];
+                UiManagerDrawSwitchCount(event.sw, TRUE);
+                break;
+
+            case kUiSwRelease:
+                UiManagerDrawSwitchCount(event.sw, FALSE);
+                break;
+
+            default:
+                break;
+        }
     }
-
-    /* Sleep for a while to debounce inputs */
-    OSA_TimeDelay(60);
 }
 
 /*!
@@ -262,12 +385,6 @@ static void UiManagerTask(osaTaskParam_t argument)
 {
     osaEventFlags_t  uiManTaskEventFlags;
 
-    /* Init counters to zero */
-    sSwitchOneCount   = 0;
-    sSwitchTwoCount   = 0;
-    sSwitchThreeCount = 0;
-    sSwitchFourCount  = 0;
-
 #if LOAD_EXT_IMG
     /* Load images to flash, if needed... */
     uint32_t imgBaseAddr = 0x00C00000;
@@ -280,11 +397,13 @@ static void UiManagerTask(osaTaskParam_t argument)
     uint32_t rightAddr = downAddr + sizeof(kImgBmp_downarrow) + 32;
     uint32_t leftAddr = rightAddr + sizeof(kImgBmp_rightarrow) + 32;
 
-    /* Save images into external flash */
+    /* Save images into external flash, under a single bus grant */
+    SPI_Bus_Share_Acquire(kSpiBusClientUpdate, SPI_BUS_SHARE_PRIO_UPDATE, SPI_BUS_SHARE_NO_DEADLINE);
     img_program_ext(upAddr, (uint8_t*)kImgBmp_uparrow, sizeof(kImgBmp_uparrow));
     img_program_ext(downAddr, (uint8_t*)kImgBmp_downarrow, sizeof(kImgBmp_downarrow));
     img_program_ext(rightAddr, (uint8_t*)kImgBmp_rightarrow, sizeof(kImgBmp_rightarrow));
     img_program_ext(leftAddr, (uint8_t*)kImgBmp_leftarrow, sizeof(kImgBmp_leftarrow));
+    SPI_Bus_Share_Release();
 #endif
 
     /* Let user know that UI is ready */
@@ -359,8 +478,9 @@ static void UiManagerTask(osaTaskParam_t argument)
 #endif
 #if LOAD_EXT_IMG
                             /* Draw down arrow image from External memory */
+                            SPI_Bus_Share_Acquire(kSpiBusClientDisplay, SPI_BUS_SHARE_PRIO_DISPLAY, UI_IMAGE_BUS_DEADLINE_MS);
                             GUI_BMP_DrawEx(RPK_GUI_get_data, &downAddr, 0, 0);
-                            SPI_Bus_Share_Release_Access();
+                            SPI_Bus_Share_Release();
 #else
                             GUI_SetColor(GUI_YELLOW);
                             GUI_FillCircle(80, 150, 10);
@@ -377,8 +497,9 @@ static void UiManagerTask(osaTaskParam_t argument)
 #endif
 #if LOAD_EXT_IMG
                             /* Draw right arrow image from External memory */
+                            SPI_Bus_Share_Acquire(kSpiBusClientDisplay, SPI_BUS_SHARE_PRIO_DISPLAY, UI_IMAGE_BUS_DEADLINE_MS);
                             GUI_BMP_DrawEx(RPK_GUI_get_data, &rightAddr, 0, 0);
-                            SPI_Bus_Share_Release_Access();
+                            SPI_Bus_Share_Release();
 #else
                             GUI_SetColor(GUI_GREEN);
                             GUI_FillCircle(150, 80, 10);
@@ -395,8 +516,9 @@ static void UiManagerTask(osaTaskParam_t argument)
 #endif
 #if LOAD_EXT_IMG
                             /* Draw up arrow image from External memory */
+                            SPI_Bus_Share_Acquire(kSpiBusClientDisplay, SPI_BUS_SHARE_PRIO_DISPLAY, UI_IMAGE_BUS_DEADLINE_MS);
                             GUI_BMP_DrawEx(RPK_GUI_get_data, &upAddr, 0, 0);
-                            SPI_Bus_Share_Release_Access();
+                            SPI_Bus_Share_Release();
 #else
                             GUI_SetColor(GUI_BLUE);
                             GUI_FillCircle(80, 20, 10);
@@ -413,8 +535,9 @@ static void UiManagerTask(osaTaskParam_t argument)
 #endif
 #if LOAD_EXT_IMG
                             /* Draw left arrow image from External memory */
+                            SPI_Bus_Share_Acquire(kSpiBusClientDisplay, SPI_BUS_SHARE_PRIO_DISPLAY, UI_IMAGE_BUS_DEADLINE_MS);
                             GUI_BMP_DrawEx(RPK_GUI_get_data, &leftAddr, 0, 0);
-                            SPI_Bus_Share_Release_Access();
+                            SPI_Bus_Share_Release();
 #else
                             GUI_SetColor(GUI_RED);
                             GUI_FillCircle(20, 80, 10);
@@ -429,15 +552,11 @@ static void UiManagerTask(osaTaskParam_t argument)
                 }
             }
         }
-        else if (uiManTaskEventFlags & kUiSwMask)
-        {
-            /* IRQ event from switches */
 
-            /* Check for additional input */
-            UiManagerCaptureInput(&uiManTaskEventFlags);
-
-            /* Process event */
-            UiManagerSwitchHandler(uiManTaskEventFlags);
+        if (uiManTaskEventFlags & UI_SWITCH_QUEUE_EVENT)
+        {
+            /* Debounced events from switches */
+            UiManagerSwitchHandler();
         }
     }
 }
@@ -448,8 +567,15 @@ static void UiManagerTask(osaTaskParam_t argument)
 OSA_TASK_DEFINE(UiManagerTask, UI_TASK_PRIO, 1, UI_TASK_STACK_SIZE, FALSE);
 void UiManager_SetEvent(uint32_t event)
 {
+    /* Switch edges only start the scan timer, the debounced events are queued by the timer */
+    if (event & kUiSwMask)
+    {
+        UiManagerStartSwitchScan();
+        event &= ~(uint32_t)kUiSwMask;
+    }
+
     /* If we are currently processing an event, ignore this interrupt (part of debounce solution) */
-    if (!sIsProcessingEvent)
+    if ((0U != event) && !sIsProcessingEvent)
     {
         /* Set event and set flag to block additional interrupts */
         sIsProcessingEvent = TRUE;
@@ -471,6 +597,13 @@ void UiManager_Init(void)
         {
             panic(0,0,0,0);
         }
+
+        sSwitchScanTimer = xTimerCreate("UiSwScan", (UI_SWITCH_SCAN_TICKS > 0U) ? UI_SWITCH_SCAN_TICKS : 1U,
+                                        pdFALSE, NULL, UiManagerScanSwitches);
+        if(NULL == sSwitchScanTimer)
+        {
+            panic(0,0,0,0);
+        }
         else
         {
             gUiManTaskId = OSA_TaskCreate(OSA_TASK(UiManagerTask), NULL);
@@ -35,6 +35,8 @@
 #ifndef _UI_MANAGER_H_
 #define _UI_MANAGER_H_
 
+#include <stdint.h>
+
 /*!
  * @addtogroup ui_manager UI Manager
  *
@@ -64,6 +66,11 @@
  * -------------------------------------------------------------------------------------------------
  * See local README.md
  *
+ * The push buttons are debounced by a state machine per switch, run from an RTOS timer every
+ * UI_SWITCH_SCAN_PERIOD_MS. A switch interrupt starts the timer, which stops again once all
+ * switches are released and stable. Press, release, long press and repeat events are queued for
+ * the UI Manager task, so no input is lost while the task is drawing.
+ *
  * Usage
  * -------------------------------------------------------------------------------------------------
  *
@@ -128,6 +135,32 @@
 #define UI_TASK_STACK_SIZE      (3072U)
 #define UI_TASK_PRIO            (3)
 
+#define UI_SWITCH_COUNT         (4U)
+
+#ifndef UI_SWITCH_SCAN_PERIOD_MS
+#define UI_SWITCH_SCAN_PERIOD_MS    (5U)      /*!< Period of the switch scan timer while a switch is active */
+#endif
+
+#ifndef UI_SWITCH_DEBOUNCE_MS
+#define UI_SWITCH_DEBOUNCE_MS       (20U)     /*!< Time an input must be stable for a press or release */
+#endif
+
+#ifndef UI_SWITCH_LONG_PRESS_MS
+#define UI_SWITCH_LONG_PRESS_MS     (800U)    /*!< Hold time of a long press */
+#endif
+
+#ifndef UI_SWITCH_REPEAT_MS
+#define UI_SWITCH_REPEAT_MS         (200U)    /*!< Repeat interval while held after a long press */
+#endif
+
+#ifndef UI_SWITCH_QUEUE_SIZE
+#define UI_SWITCH_QUEUE_SIZE        (16U)     /*!< Switch event queue entries, one is kept free */
+#endif
+
+#ifndef UI_IMAGE_BUS_DEADLINE_MS
+#define UI_IMAGE_BUS_DEADLINE_MS    (20U)     /*!< Time within which an image fetch from the SPI flash wants the bus */
+#endif
+
 /*!
  * @brief UI Event Flags and Masks
  *
@@ -168,12 +201,38 @@ typedef enum _ui_touch
 
 }ui_touch_t;
 
+/*!
+ * @brief UI Switch event types
+ *
+ * Events produced by the debounce state machine of each switch.
+ *
+ */
+typedef enum _ui_switch_event_type
+{
+    kUiSwPress      = 0U,    /*!< Debounced press */
+    kUiSwRelease    = 1U,    /*!< Debounced release */
+    kUiSwLongPress  = 2U,    /*!< Switch held for UI_SWITCH_LONG_PRESS_MS */
+    kUiSwRepeat     = 3U,    /*!< Switch still held, every UI_SWITCH_REPEAT_MS after the long press */
+
+}ui_switch_event_type_t;
+
+/*!
+ * @brief UI Switch event, as queued for the UI Manager task
+ */
+typedef struct _ui_switch_event
+{
+    uint8_t sw;      /*!< Switch index, 0 for SW1 to 3 for SW4 */
+    uint8_t type;    /*!< Event type, see ui_switch_event_type_t */
+
+}ui_switch_event_t;
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 /*!
- * @brief Function to set event, can be called from ISR or task. Will ignore new events until manager processes previous event.
+ * @brief Function to set event, can be called from ISR or task. Will ignore new touch and lock events until manager
+ *        processes previous event. Switch events only start the switch scan timer and are never ignored.
  *
  * @param[in] event  Event to trigger in UI manager
  *
@@ -41,6 +41,9 @@
 #include <math.h>
 #include "fsl_debug_console.h"
 #include "fsl_usart.h"
+#if PRINTF_FLOAT_ENABLE
+#include "fsl_ftoa.h"
+#endif /* PRINTF_FLOAT_ENABLE */
 
 /*! @brief Keil: suppress ellipsis warning in va_arg usage below. */
 #if defined(__CC_ARM)
@@ -453,98 +456,28 @@ static int32_t DbgConsole_ConvertFloatRadixNumToString(char *numstr,
                                                        int32_t radix,
                                                        uint32_t precision_width)
 {
-    int32_t a;
-    int32_t b;
-    int32_t c;
-    int32_t i;
-    uint32_t uc;
-    double fa;
-    double dc;
-    double fb;
+    char fstr[FTOA_MAX_DOUBLE_STR_LEN];
     double r;
-    double fractpart;
-    double intpart;
+    int32_t flen;
+    int32_t nlen = 0;
 
-    int32_t nlen;
-    char *nstrp;
-    nlen = 0;
-    nstrp = numstr;
-    *nstrp++ = '\0';
+    /* Decimal only, formatted with integer arithmetic instead of modf() and
+     * pow(). The caller adds the sign. */
+    (void)radix;
     r = *(double *)nump;
-    if (!r)
-    {
-        *nstrp = '0';
-        ++nlen;
-        return nlen;
-    }
-    fractpart = modf((double)r, (double *)&intpart);
-    /* Process fractional part. */
-    for (i = 0; i < precision_width; i++)
-    {
-        fractpart *= radix;
-    }
-    if (r >= 0)
-    {
-        fa = fractpart + (double)0.5;
-        if (fa >= pow(10, precision_width))
-        {
-            intpart++;
-        }
-    }
-    else
-    {
-        fa = fractpart - (double)0.5;
-        if (fa <= -pow(10, precision_width))
-        {
-            intpart--;
-        }
-    }
-    for (i = 0; i < precision_width; i++)
-    {
-        fb = fa / (int32_t)radix;
-        dc = (fa - (int64_t)fb * (int32_t)radix);
-        c = (int32_t)dc;
-        if (c < 0)
-        {
-            uc = (uint32_t)c;
-            c = (int32_t)(~uc) + 1 + '0';
-        }
-        else
-        {
-            c = c + '0';
-        }
-        fa = fb;
-        *nstrp++ = (char)c;
-        ++nlen;
-    }
-    *nstrp++ = (char)'.';
-    ++nlen;
-    a = (int32_t)intpart;
-    if (a == 0)
+    if (r < 0)
     {
-        *nstrp++ = '0';
-        ++nlen;
+        r = -r;
     }
-    else
+    flen = Ftoa_FormatDouble(fstr, r, precision_width);
+
+    /* The caller prints the string backwards, starting after a null character */
+    numstr[0] = '\0';
+    while (flen > 0)
     {
-        while (a != 0)
-        {
-            b = (int32_t)a / (int32_t)radix;
-            c = (int32_t)a - ((int32_t)b * (int32_t)radix);
-            if (c < 0)
-            {
-                uc = (uint32_t)c;
-                c = (int32_t)(~uc) + 1 + '0';
-            }
-            else
-            {
-                c = c + '0';
-            }
-            a = b;
-            *nstrp++ = (char)c;
-            ++nlen;
-        }
+        numstr[++nlen] = fstr[--flen];
     }
+
     return nlen;
 }
 #endif /* PRINTF_FLOAT_ENABLE */
@@ -567,7 +500,11 @@ static int DbgConsole_PrintfFormattedData(PUTCHAR_FUNC func_ptr, const char *fmt
     char *p;
     int32_t c;
 
+#if PRINTF_FLOAT_ENABLE
+    char vstr[FTOA_MAX_DOUBLE_STR_LEN + 1];
+#else
     char vstr[33];
+#endif /* PRINTF_FLOAT_ENABLE */
     char *vstrp = NULL;
     int32_t vlen = 0;
 
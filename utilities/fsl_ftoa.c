@@ -0,0 +1,518 @@
+/*
+ * The Clear BSD License
+ * Copyright 2018 NXP
+ * All rights reserved.
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted (subject to the limitations in the disclaimer below) provided
+ *  that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of Freescale Semiconductor, Inc. nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY THIS LICENSE.
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <string.h>
+#include "fsl_ftoa.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Fixed point position used to round the fractional part. 2^44 * 10^6 fits in 64 bits. */
+#define FTOA_FRAC_BITS (44U)
+
+/*! @brief Base 10^9 limbs needed for the integer part of FLT_MAX (39 digits). */
+#define FTOA_BIG_LIMBS (5U)
+
+/*! @brief Largest binary exponent for which the integer part still fits in 64 bits. */
+#define FTOA_MAX_U64_EXP (40)
+
+/*! @brief Largest power of 2 multiplier which keeps a base 10^9 limb product in 64 bits. */
+#define FTOA_BIG_SHIFT (29)
+
+/*! @brief Single precision layout. */
+#define FTOA_MANT_BITS (23U)
+#define FTOA_MANT_MASK (0x7FFFFFU)
+#define FTOA_EXP_MASK (0xFFU)
+#define FTOA_EXP_BIAS (150)
+
+/*! @brief Double precision layout. */
+#define FTOA_DBL_MANT_BITS (52U)
+#define FTOA_DBL_MANT_MASK (0xFFFFFFFFFFFFFULL)
+#define FTOA_DBL_EXP_MASK (0x7FFU)
+#define FTOA_DBL_EXP_BIAS (1075)
+
+/*! @brief Difference between the double and single precision exponent biases. */
+#define FTOA_DBL_FLT_BIAS (896)
+
+/*! @brief Mantissa bits of a double which single precision does not have. */
+#define FTOA_DBL_FLT_EXTRA_MASK (0x1FFFFFFFU)
+
+/*! @brief Largest binary exponent for which mant * 2^exp stays below 2^128. */
+#define FTOA_DBL_MAX_EXP (75)
+
+/*! @brief Largest binary exponent for which mant * 2^exp still fits in 64 bits. */
+#define FTOA_DBL_MAX_U64_EXP (11)
+
+/*! @brief 32 bit words holding the exact fraction of any double, down to 2^-1074. */
+#define FTOA_DBL_FRAC_WORDS (34U)
+
+typedef union _ftoa_float_bits
+{
+    float f;
+    uint32_t u;
+} ftoa_float_bits_t;
+
+typedef union _ftoa_double_bits
+{
+    double d;
+    uint64_t u;
+} ftoa_double_bits_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const uint32_t s_ftoaPow10[] = {1U,      10U,      100U,      1000U,      10000U,
+                                       100000U, 1000000U, 10000000U, 100000000U, 1000000000U};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/*!
+ * @brief Writes a number backwards, ending just before end.
+ *
+ * @param[in] end        Position after the last digit.
+ * @param[in] value      Number to convert.
+ * @param[in] minDigits  Zero pad to this many digits.
+ *
+ * @return Position of the first digit.
+ */
+static char *Ftoa_U32ToStr(char *end, uint32_t value, uint32_t minDigits)
+{
+    uint32_t count = 0U;
+
+    do
+    {
+        *--end = (char)('0' + (value % 10U));
+        value /= 10U;
+        count++;
+    } while ((value != 0U) || (count < minDigits));
+
+    return end;
+}
+
+/*!
+ * @brief Writes mant * 2^exp backwards, for integers too large for 64 bits.
+ */
+static char *Ftoa_BigToStr(char *end, uint64_t mant, int32_t exp)
+{
+    uint32_t limbs[FTOA_BIG_LIMBS] = {0U};
+    uint32_t used = 1U;
+    uint32_t i;
+    uint64_t carry;
+    int32_t shift;
+
+    /* mant < 2^53 fits in the first three limbs */
+    limbs[0] = (uint32_t)(mant % 1000000000U);
+    mant /= 1000000000U;
+
+    while (mant != 0U)
+    {
+        limbs[used++] = (uint32_t)(mant % 1000000000U);
+        mant /= 1000000000U;
+    }
+
+    while (exp > 0)
+    {
+        shift = (exp > FTOA_BIG_SHIFT) ? FTOA_BIG_SHIFT : exp;
+        exp -= shift;
+        carry = 0U;
+
+        for (i = 0U; i < used; i++)
+        {
+            carry += (uint64_t)limbs[i] << shift;
+            limbs[i] = (uint32_t)(carry % 1000000000U);
+            carry /= 1000000000U;
+        }
+
+        while ((carry != 0U) && (used < FTOA_BIG_LIMBS))
+        {
+            limbs[used++] = (uint32_t)(carry % 1000000000U);
+            carry /= 1000000000U;
+        }
+    }
+
+    for (i = 0U; i < (used - 1U); i++)
+    {
+        end = Ftoa_U32ToStr(end, limbs[i], 9U);
+    }
+
+    return Ftoa_U32ToStr(end, limbs[used - 1U], 1U);
+}
+
+/*!
+ * @brief Writes a 64 bit number backwards.
+ */
+static char *Ftoa_U64ToStr(char *end, uint64_t value)
+{
+    while (value > 0xFFFFFFFFU)
+    {
+        end = Ftoa_U32ToStr(end, (uint32_t)(value % 1000000000U), 9U);
+        value /= 1000000000U;
+    }
+
+    return Ftoa_U32ToStr(end, (uint32_t)value, 1U);
+}
+
+/*!
+ * @brief Copies the string built backwards into the caller's buffer.
+ */
+static int32_t Ftoa_Output(char *buf, const char *start, const char *end)
+{
+    int32_t len = (int32_t)(end - start);
+
+    memcpy(buf, start, (size_t)len);
+    buf[len] = '\0';
+
+    return len;
+}
+
+int32_t Ftoa_FormatFloat(char *buf, float value, uint32_t precision)
+{
+    char tmp[FTOA_MAX_STR_LEN];
+    char *end = &tmp[FTOA_MAX_STR_LEN];
+    char *p = end;
+    ftoa_float_bits_t bits;
+    uint32_t mant;
+    int32_t exp;
+    uint32_t shift;
+    uint32_t fracBits;
+    uint32_t fracDigits;
+    uint32_t lsb;
+    uint64_t intPart = 0U;
+    uint64_t fracQ = 0U;
+    uint64_t scaled;
+    uint64_t rem;
+
+    if (precision > FTOA_MAX_PRECISION)
+    {
+        precision = FTOA_MAX_PRECISION;
+    }
+
+    bits.f = value;
+    exp = (int32_t)((bits.u >> FTOA_MANT_BITS) & FTOA_EXP_MASK);
+    mant = bits.u & FTOA_MANT_MASK;
+
+    if (exp == (int32_t)FTOA_EXP_MASK)
+    {
+        p -= 3;
+        memcpy(p, (mant != 0U) ? "nan" : "inf", 3U);
+    }
+    else
+    {
+        /* value = mant * 2^exp */
+        if (exp == 0)
+        {
+            exp = 1 - FTOA_EXP_BIAS;
+        }
+        else
+        {
+            mant |= (FTOA_MANT_MASK + 1U);
+            exp -= FTOA_EXP_BIAS;
+        }
+
+        if (exp >= 0)
+        {
+            if (exp <= FTOA_MAX_U64_EXP)
+            {
+                intPart = (uint64_t)mant << exp;
+            }
+        }
+        else
+        {
+            shift = (uint32_t)(-exp);
+
+            if (shift < 32U)
+            {
+                intPart = mant >> shift;
+                fracBits = mant & ((1U << shift) - 1U);
+            }
+            else
+            {
+                fracBits = mant;
+            }
+
+            /* Below 2^-21 the value is less than half a unit of the last printable
+             * decimal and rounds to zero, so fracQ can stay zero. */
+            if (shift <= FTOA_FRAC_BITS)
+            {
+                fracQ = (uint64_t)fracBits << (FTOA_FRAC_BITS - shift);
+            }
+        }
+
+        /* Round the exact binary fraction to precision digits, ties to even */
+        scaled = fracQ * s_ftoaPow10[precision];
+        fracDigits = (uint32_t)(scaled >> FTOA_FRAC_BITS);
+        rem = scaled & ((1ULL << FTOA_FRAC_BITS) - 1U);
+        lsb = (precision != 0U) ? fracDigits : (uint32_t)intPart;
+
+        if ((rem > (1ULL << (FTOA_FRAC_BITS - 1U))) || ((rem == (1ULL << (FTOA_FRAC_BITS - 1U))) && (lsb & 1U)))
+        {
+            fracDigits++;
+
+            if (fracDigits == s_ftoaPow10[precision])
+            {
+                fracDigits = 0U;
+                intPart++;
+            }
+        }
+
+        if (precision != 0U)
+        {
+            p = Ftoa_U32ToStr(p, fracDigits, precision);
+            *--p = '.';
+        }
+
+        if (exp > FTOA_MAX_U64_EXP)
+        {
+            p = Ftoa_BigToStr(p, mant, exp);
+        }
+        else
+        {
+            p = Ftoa_U64ToStr(p, intPart);
+        }
+    }
+
+    if (bits.u >> 31U)
+    {
+        *--p = '-';
+    }
+
+    return Ftoa_Output(buf, p, end);
+}
+
+/*!
+ * @brief Writes the fraction digits of mant * 2^-shift forwards, rounded to
+ * precision digits, ties to even.
+ *
+ * @return 1 when the rounding carries into the integer part.
+ */
+static uint32_t Ftoa_FracToStr(char *digits, uint64_t mant, uint32_t shift, uint32_t precision, uint32_t intLsb)
+{
+    uint32_t frac[FTOA_DBL_FRAC_WORDS] = {0U};
+    uint32_t words = (shift + 31U) / 32U;
+    uint32_t first;
+    uint32_t bit;
+    uint32_t rest = 0U;
+    uint32_t lsb;
+    uint32_t i;
+    uint32_t d;
+    uint64_t carry;
+
+    /* frac holds mant * 2^-shift scaled by 2^(32 * words), mant < 2^shift */
+    bit = (32U * words) - shift;
+    first = bit / 32U;
+    bit %= 32U;
+    frac[first] = (uint32_t)(mant << bit);
+    if ((first + 1U) < words)
+    {
+        frac[first + 1U] = (uint32_t)((mant << bit) >> 32U);
+    }
+    if (((first + 2U) < words) && (bit != 0U))
+    {
+        frac[first + 2U] = (uint32_t)(mant >> (64U - bit));
+    }
+
+    /* Each digit is what a multiplication by ten carries out of the top word. The
+     * words below the lowest set bit stay zero. */
+    for (d = 0U; d < precision; d++)
+    {
+        carry = 0U;
+        for (i = first; i < words; i++)
+        {
+            carry += (uint64_t)frac[i] * 10U;
+            frac[i] = (uint32_t)carry;
+            carry >>= 32U;
+        }
+        digits[d] = (char)('0' + carry);
+    }
+
+    for (i = first; i < (words - 1U); i++)
+    {
+        rest |= frac[i];
+    }
+    rest |= frac[words - 1U] & 0x7FFFFFFFU;
+    lsb = (precision != 0U) ? (uint32_t)(digits[precision - 1U] - '0') : intLsb;
+
+    if (((frac[words - 1U] & 0x80000000U) == 0U) || ((rest == 0U) && ((lsb & 1U) == 0U)))
+    {
+        return 0U;
+    }
+
+    for (d = precision; d > 0U; d--)
+    {
+        if (digits[d - 1U] != '9')
+        {
+            digits[d - 1U]++;
+            return 0U;
+        }
+        digits[d - 1U] = '0';
+    }
+
+    return 1U;
+}
+
+int32_t Ftoa_FormatDouble(char *buf, double value, uint32_t precision)
+{
+    char tmp[FTOA_MAX_DOUBLE_STR_LEN];
+    char *end = &tmp[FTOA_MAX_DOUBLE_STR_LEN];
+    char *p;
+    ftoa_double_bits_t bits;
+    ftoa_float_bits_t single;
+    uint64_t mant;
+    uint64_t intPart = 0U;
+    int32_t exp;
+    uint32_t shift;
+
+    bits.d = value;
+    exp = (int32_t)((bits.u >> FTOA_DBL_MANT_BITS) & FTOA_DBL_EXP_MASK);
+    mant = bits.u & FTOA_DBL_MANT_MASK;
+    single.u = (uint32_t)(bits.u >> 32U) & 0x80000000U;
+
+    /* Infinities, NaN, and the values the single precision formatter prints exactly */
+    if (exp == (int32_t)FTOA_DBL_EXP_MASK)
+    {
+        single.u |= (FTOA_EXP_MASK << FTOA_MANT_BITS) | ((mant != 0U) ? 1U : 0U);
+        return Ftoa_FormatFloat(buf, single.f, precision);
+    }
+
+    if ((precision <= FTOA_MAX_PRECISION) && ((mant & FTOA_DBL_FLT_EXTRA_MASK) == 0U) &&
+        (((exp == 0) && (mant == 0U)) || ((exp > FTOA_DBL_FLT_BIAS) && (exp < (FTOA_DBL_FLT_BIAS + 255)))))
+    {
+        if (exp != 0)
+        {
+            single.u |= ((uint32_t)(exp - FTOA_DBL_FLT_BIAS) << FTOA_MANT_BITS) |
+                        (uint32_t)(mant >> (FTOA_DBL_MANT_BITS - FTOA_MANT_BITS));
+        }
+        return Ftoa_FormatFloat(buf, single.f, precision);
+    }
+
+    if (precision > FTOA_MAX_DOUBLE_PRECISION)
+    {
+        precision = FTOA_MAX_DOUBLE_PRECISION;
+    }
+
+    /* value = mant * 2^exp */
+    if (exp == 0)
+    {
+        exp = 1 - FTOA_DBL_EXP_BIAS;
+    }
+    else
+    {
+        mant |= (FTOA_DBL_MANT_MASK + 1U);
+        exp -= FTOA_DBL_EXP_BIAS;
+    }
+
+    if (exp > FTOA_DBL_MAX_EXP)
+    {
+        p = end - 3;
+        memcpy(p, "inf", 3U);
+    }
+    else
+    {
+        p = end - precision;
+
+        if (exp >= 0)
+        {
+            memset(p, '0', precision);
+            if (exp <= FTOA_DBL_MAX_U64_EXP)
+            {
+                intPart = mant << exp;
+            }
+        }
+        else
+        {
+            shift = (uint32_t)(-exp);
+            if (shift < 64U)
+            {
+                intPart = mant >> shift;
+                mant &= (1ULL << shift) - 1U;
+            }
+            intPart += Ftoa_FracToStr(p, mant, shift, precision, (uint32_t)intPart);
+        }
+
+        if (precision != 0U)
+        {
+            *--p = '.';
+        }
+
+        if (exp > FTOA_DBL_MAX_U64_EXP)
+        {
+            p = Ftoa_BigToStr(p, mant, exp);
+        }
+        else
+        {
+            p = Ftoa_U64ToStr(p, intPart);
+        }
+    }
+
+    if (bits.u >> 63U)
+    {
+        *--p = '-';
+    }
+
+    return Ftoa_Output(buf, p, end);
+}
+
+int32_t Ftoa_FormatFixed(char *buf, int32_t value, uint32_t decimals)
+{
+    char tmp[FTOA_MAX_STR_LEN];
+    char *end = &tmp[FTOA_MAX_STR_LEN];
+    char *p = end;
+    uint32_t mag = (value < 0) ? (0U - (uint32_t)value) : (uint32_t)value;
+
+    if (decimals > 9U)
+    {
+        decimals = 9U;
+    }
+
+    if (decimals != 0U)
+    {
+        p = Ftoa_U32ToStr(p, mag % s_ftoaPow10[decimals], decimals);
+        *--p = '.';
+        mag /= s_ftoaPow10[decimals];
+    }
+
+    p = Ftoa_U32ToStr(p, mag, 1U);
+
+    if (value < 0)
+    {
+        *--p = '-';
+    }
+
+    return Ftoa_Output(buf, p, end);
+}
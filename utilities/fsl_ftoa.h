@@ -0,0 +1,128 @@
+/*
+ * The Clear BSD License
+ * Copyright 2018 NXP
+ * All rights reserved.
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted (subject to the limitations in the disclaimer below) provided
+ *  that the following conditions are met:
+ *
+ * o Redistributions of source code must retain the above copyright notice, this list
+ *   of conditions and the following disclaimer.
+ *
+ * o Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ * o Neither the name of Freescale Semiconductor, Inc. nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY THIS LICENSE.
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _FSL_FTOA_H
+#define _FSL_FTOA_H
+
+#include "fsl_common.h"
+
+/*!
+ * @addtogroup debugconsole
+ * @{
+ */
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/*! @brief Maximum number of digits after the decimal point. */
+#define FTOA_MAX_PRECISION (6U)
+
+/*!
+ * @brief Buffer size which fits any string produced by this module, including
+ * the terminating null: sign, 39 integer digits (FLT_MAX), point, fraction.
+ */
+#define FTOA_MAX_STR_LEN (48U)
+
+/*! @brief Maximum number of digits after the decimal point for double precision values. */
+#define FTOA_MAX_DOUBLE_PRECISION (17U)
+
+/*!
+ * @brief Buffer size which fits any string produced by Ftoa_FormatDouble(),
+ * including the terminating null: sign, 39 integer digits, point, fraction.
+ */
+#define FTOA_MAX_DOUBLE_STR_LEN (64U)
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern "C" {
+#endif /* __cplusplus */
+
+/*!
+ * @brief Formats a single precision value like printf("%.*f").
+ *
+ * The conversion works on the binary representation of the value with integer
+ * arithmetic only (no double precision or libm calls). The result is exactly
+ * what newlib prints for the same value promoted to double: correctly rounded,
+ * ties to even.
+ *
+ * @param[out] buf        Destination, at least FTOA_MAX_STR_LEN bytes.
+ * @param[in]  value      Value to format.
+ * @param[in]  precision  Digits after the decimal point, clamped to FTOA_MAX_PRECISION.
+ *
+ * @return Length of the null terminated string written to buf.
+ */
+int32_t Ftoa_FormatFloat(char *buf, float value, uint32_t precision);
+
+/*!
+ * @brief Formats a double precision value like printf("%.*f").
+ *
+ * Integer arithmetic only, like Ftoa_FormatFloat(), which it uses for the values
+ * exactly representable in single precision when at most FTOA_MAX_PRECISION
+ * digits are requested. Other values are rounded from their exact binary
+ * fraction, ties to even, as newlib does. Magnitudes of 2^128 and above, beyond
+ * the single precision range, are printed as "inf".
+ *
+ * @param[out] buf        Destination, at least FTOA_MAX_DOUBLE_STR_LEN bytes.
+ * @param[in]  value      Value to format.
+ * @param[in]  precision  Digits after the decimal point, clamped to FTOA_MAX_DOUBLE_PRECISION.
+ *
+ * @return Length of the null terminated string written to buf.
+ */
+int32_t Ftoa_FormatDouble(char *buf, double value, uint32_t precision);
+
+/*!
+ * @brief Formats a fixed point value: prints value / 10^decimals.
+ *
+ * Fast path for readings which are already scaled integers, e.g. 2345 with 2
+ * decimals is printed as "23.45". Only 32 bit integer arithmetic is used.
+ *
+ * @param[out] buf       Destination, at least FTOA_MAX_STR_LEN bytes.
+ * @param[in]  value     Scaled value.
+ * @param[in]  decimals  Number of decimal digits in value, up to 9.
+ *
+ * @return Length of the null terminated string written to buf.
+ */
+int32_t Ftoa_FormatFixed(char *buf, int32_t value, uint32_t decimals);
+
+#if defined(__cplusplus)
+}
+#endif /* __cplusplus */
+
+/*! @} */
+
+#endif /* _FSL_FTOA_H */
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2018 NXP
+ * All rights reserved.
+ */
+
+/*!
+ * @file ftoa_test.c
+ * Host test for the integer-only float formatter. Every reading the sensors can produce, over
+ * their full range and at their resolution, is formatted at each precision and compared with
+ * the C library printf; random single and double precision bit patterns follow. The printf
+ * engine of fsl_str.c is built in as well, with float and advanced formats enabled. The
+ * formatter is then timed against snprintf on sensor readings.
+ *
+ * Build and run with "make" from this directory.
+ */
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../fsl_ftoa.c"
+#include "../fsl_str.c"
+
+/*****************************************************************************
+ * Helpers
+ ****************************************************************************/
+#define CHECK(c)    do { if (!(c)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+static uint64_t sChecked;
+
+static void CheckFloat(float value, uint32_t precision)
+{
+    char expected[FTOA_MAX_STR_LEN];
+    char out[FTOA_MAX_STR_LEN];
+    int32_t len;
+
+    snprintf(expected, sizeof(expected), "%.*f", (int)precision, (double)value);
+    len = Ftoa_FormatFloat(out, value, precision);
+    if ((strcmp(out, expected) != 0) || (len != (int32_t)strlen(expected)))
+    {
+        printf("FAIL float %a at %u digits: \"%s\", expected \"%s\"\n", (double)value, precision, out, expected);
+        exit(1);
+    }
+    sChecked++;
+}
+
+static void CheckDouble(double value, uint32_t precision)
+{
+    char expected[FTOA_MAX_DOUBLE_STR_LEN];
+    char out[FTOA_MAX_DOUBLE_STR_LEN];
+    int32_t len;
+
+    snprintf(expected, sizeof(expected), "%.*f", (int)precision, value);
+    len = Ftoa_FormatDouble(out, value, precision);
+    if ((strcmp(out, expected) != 0) || (len != (int32_t)strlen(expected)))
+    {
+        printf("FAIL double %a at %u digits: \"%s\", expected \"%s\"\n", value, precision, out, expected);
+        exit(1);
+    }
+    sChecked++;
+}
+
+static uint64_t Random64(void)
+{
+    return ((uint64_t)(rand() & 0xFFFF) << 48) | ((uint64_t)(rand() & 0xFFFF) << 32) |
+           ((uint64_t)(rand() & 0xFFFF) << 16) | (uint64_t)(rand() & 0xFFFF);
+}
+
+static double Now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/* StrFormatPrintf output callback, as used by the SDK sprintf */
+static void PrintToBuffer(char *buf, int32_t *indicator, char val, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+    {
+        buf[(*indicator)++] = val;
+    }
+    buf[*indicator] = '\0';
+}
+
+static int TestSprintf(char *buf, const char *fmt, ...)
+{
+    va_list ap;
+    int count;
+
+    va_start(ap, fmt);
+    count = StrFormatPrintf(fmt, ap, buf, PrintToBuffer);
+    va_end(ap);
+    return count;
+}
+
+/*****************************************************************************
+ * Tests
+ ****************************************************************************/
+
+/* Sensor ranges and resolutions, as the drivers report them */
+static const struct
+{
+    const char *name;
+    double min;
+    double max;
+    double resolution;
+} sRanges[] =
+{
+    {"ENS210 temperature (C)", -40.0, 125.0, 1.0 / 64},
+    {"ENS210 humidity (%)", 0.0, 100.0, 1.0 / 512},
+    {"MPL3115 pressure (hPa)", 500.0, 1150.0, 0.0025},
+    {"TSL2572 ambient light (lux)", 0.0, 10000.0, 0.01},
+    {"FXOS8700 acceleration (g)", -8.0, 8.0, 1.0 / 4096},
+    {"FXOS8700 magnetic field (uT)", -1200.0, 1200.0, 0.1},
+    {"FXAS21002 angular rate (dps)", -2000.0, 2000.0, 1.0 / 16},
+};
+
+/* Every reading of every sensor, at every precision */
+static void TestSensorRanges(void)
+{
+    static const uint32_t doublePrecisions[] = {2, 6, 8, 12, FTOA_MAX_DOUBLE_PRECISION};
+    uint32_t range;
+    uint32_t precision;
+    uint32_t i;
+    uint64_t steps;
+    uint64_t k;
+    double value;
+
+    for (range = 0; range < sizeof(sRanges) / sizeof(sRanges[0]); range++)
+    {
+        steps = (uint64_t)((sRanges[range].max - sRanges[range].min) / sRanges[range].resolution + 0.5);
+        for (k = 0; k <= steps; k++)
+        {
+            value = sRanges[range].min + k * sRanges[range].resolution;
+            for (precision = 0; precision <= FTOA_MAX_PRECISION; precision++)
+            {
+                CheckFloat((float)value, precision);
+            }
+            for (i = 0; i < sizeof(doublePrecisions) / sizeof(doublePrecisions[0]); i++)
+            {
+                CheckDouble(value, doublePrecisions[i]);
+            }
+        }
+        printf("  %-30s %8llu readings\n", sRanges[range].name, (unsigned long long)steps + 1);
+    }
+}
+
+/* Random bit patterns over the whole single precision range, and over the double
+   precision range the formatter covers */
+static void TestRandom(void)
+{
+    ftoa_float_bits_t f;
+    ftoa_double_bits_t d;
+    uint32_t i;
+
+    for (i = 0; i < 2000000; i++)
+    {
+        f.u = (uint32_t)Random64();
+        CheckFloat(f.f, i % (FTOA_MAX_PRECISION + 1));
+    }
+
+    for (i = 0; i < 2000000; i++)
+    {
+        d.u = Random64();
+        if (((d.u >> 52) & 0x7FF) > 1023 + 127)
+        {
+            /* Beyond 2^128: moved into range, the exponent itself is checked below */
+            d.u &= ~(0x7FFULL << 52);
+            d.u |= (uint64_t)(1023 + (i % 128)) << 52;
+        }
+        CheckDouble(d.d, i % (FTOA_MAX_DOUBLE_PRECISION + 1));
+    }
+    printf("  2000000 random floats, 2000000 random doubles below 2^128\n");
+}
+
+static void TestEdges(void)
+{
+    static const double values[] = {0.0, -0.0, 0.5, 1.5, 2.5, -2.5, 0.125, 0.375, 1e-7, 5e-7, 0.9999995, 9.5,
+                                    99.995, 1234567.891, 2.718281828459045, 3.141592653589793, 1e15 + 0.3,
+                                    18446744073709551615.0, 18446744073709551616.0, 1e20, 1e38, (double)FLT_MAX,
+                                    (double)FLT_MIN, 1.4e-45, DBL_MIN, 4.9e-324, 340282366920938425684442744474606501888.0};
+    char out[FTOA_MAX_DOUBLE_STR_LEN];
+    char buf[128];
+    uint32_t precision;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        for (precision = 0; precision <= FTOA_MAX_DOUBLE_PRECISION; precision++)
+        {
+            CheckDouble(values[i], precision);
+            CheckDouble(-values[i], precision);
+        }
+        for (precision = 0; precision <= FTOA_MAX_PRECISION; precision++)
+        {
+            CheckFloat((float)values[i], precision);
+        }
+    }
+
+    /* Out of range, clamped */
+    CHECK((Ftoa_FormatDouble(out, 340282366920938463463374607431768211456.0, 2) == 3) && (strcmp(out, "inf") == 0));
+    CHECK((Ftoa_FormatDouble(out, -DBL_MAX, 2) == 4) && (strcmp(out, "-inf") == 0));
+    CHECK((Ftoa_FormatDouble(out, (double)INFINITY, 8) == 3) && (strcmp(out, "inf") == 0));
+    CHECK((Ftoa_FormatDouble(out, (double)NAN, 8) == 3) && (strcmp(out, "nan") == 0));
+    Ftoa_FormatDouble(out, 0.1, 30);
+    CHECK(strcmp(out, "0.10000000000000001") == 0);
+    Ftoa_FormatFloat(out, 0.1f, 9);
+    CHECK(strcmp(out, "0.100000") == 0);
+
+    /* Fixed point fast path */
+    Ftoa_FormatFixed(out, 2345, 2);
+    CHECK(strcmp(out, "23.45") == 0);
+    Ftoa_FormatFixed(out, -5, 2);
+    CHECK(strcmp(out, "-0.05") == 0);
+    Ftoa_FormatFixed(out, INT32_MIN, 9);
+    CHECK(strcmp(out, "-2.147483648") == 0);
+    Ftoa_FormatFixed(out, 42, 0);
+    CHECK(strcmp(out, "42") == 0);
+
+    /* The printf engine: widths, flags, and precisions above FTOA_MAX_PRECISION */
+    TestSprintf(buf, "Temp : %.2f C", 23.456);
+    CHECK(strcmp(buf, "Temp : 23.46 C") == 0);
+    TestSprintf(buf, "[%8.3f][%-8.1f][%+.0f][%08.2f]", -1.0625, 2.25, 2.5, -3.14159);
+    CHECK(strcmp(buf, "[  -1.062][2.2     ][+2][-0003.14]") == 0);
+    TestSprintf(buf, "%.8f %.12f %f", 3.141592653589793, 0.1, 1234567.891);
+    CHECK(strcmp(buf, "3.14159265 0.100000000000 1234567.891000") == 0);
+    TestSprintf(buf, "%.17f", 1e-17);
+    CHECK(strcmp(buf, "0.00000000000000001") == 0);
+    printf("  edge values, ties, subnormals, clamping and the printf flags\n");
+}
+
+/* Time per call against the C library, on the readings the display formats */
+static void Benchmark(void)
+{
+    const uint32_t n = 2000000;
+    char out[FTOA_MAX_DOUBLE_STR_LEN];
+    volatile uint32_t sink = 0;
+    double t;
+    double tLib;
+    uint32_t i;
+
+    t = Now();
+    for (i = 0; i < n; i++)
+    {
+        sink += (uint32_t)snprintf(out, sizeof(out), "%.2f", (double)(float)((int32_t)(i % 16500) - 4000) / 100.0f);
+    }
+    tLib = Now() - t;
+    t = Now();
+    for (i = 0; i < n; i++)
+    {
+        sink += (uint32_t)Ftoa_FormatFloat(out, (float)((int32_t)(i % 16500) - 4000) / 100.0f, 2);
+    }
+    t = Now() - t;
+    printf("  %%.2f float:      snprintf %6.1f ns, Ftoa_FormatFloat  %6.1f ns\n", tLib * 1e9 / n, t * 1e9 / n);
+
+    t = Now();
+    for (i = 0; i < n; i++)
+    {
+        int32_t v = (int32_t)(i % 16500) - 4000;
+
+        sink += (uint32_t)snprintf(out, sizeof(out), "%s%ld.%02ld", (v < 0) ? "-" : "", labs(v) / 100L, labs(v) % 100L);
+    }
+    tLib = Now() - t;
+    t = Now();
+    for (i = 0; i < n; i++)
+    {
+        sink += (uint32_t)Ftoa_FormatFixed(out, (int32_t)(i % 16500) - 4000, 2);
+    }
+    t = Now() - t;
+    printf("  fixed point:     snprintf %6.1f ns, Ftoa_FormatFixed  %6.1f ns\n", tLib * 1e9 / n, t * 1e9 / n);
+
+    t = Now();
+    for (i = 0; i < n; i++)
+    {
+        sink += (uint32_t)snprintf(out, sizeof(out), "%.8f", 1013.25 + i * 1e-5);
+    }
+    tLib = Now() - t;
+    t = Now();
+    for (i = 0; i < n; i++)
+    {
+        sink += (uint32_t)Ftoa_FormatDouble(out, 1013.25 + i * 1e-5, 8);
+    }
+    t = Now() - t;
+    printf("  %%.8f double:     snprintf %6.1f ns, Ftoa_FormatDouble %6.1f ns\n", tLib * 1e9 / n, t * 1e9 / n);
+    (void)sink;
+}
+
+int main(void)
+{
+    srand(1);
+    TestEdges();
+    TestSensorRanges();
+    TestRandom();
+    printf("  %llu results identical to the C library\n", (unsigned long long)sChecked);
+    Benchmark();
+
+    printf("ftoa: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,15 @@
+/* Host test stub of the SDK common definitions */
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int32_t status_t;
+#define kStatus_Success     0
+#define kStatus_Fail        1
+
+#define __DMB()             __sync_synchronize()
+
+#endif